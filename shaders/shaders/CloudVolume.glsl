@@ -37,6 +37,10 @@
  * Notes:
  * - No lighting is applied; this shader is for visualizing cloud structure only.
  * - Designed as a reusable cloud volume core for lighting modules to be added externally
+ * - Most samples of the march land in empty air. To skip them, move map() and the constants into Common,
+ *   add rendering/volume_occupancy.glsl there, bake it in Buffer A (fragColor = bakeOccupancy(ivec2(fragCoord)),
+ *   512 × 256) and define VOL_OCCUPANCY as the channel Buffer A is bound to, e.g. iChannel2.
+ * - Far samples can use fewer octaves of map(): add rendering/volume_lod.glsl to Common with VOL_LOD_DISTANCE, e.g. 16.0.
  */
 
 
@@ -44,6 +48,7 @@
 #define CAM_POS vec3(0.0, -1.0, -6.0)
 #define CLOUD_BASE -3.0
 #define CLOUD_TOP  0.6
+#define VOL_MIN_TRANSMITTANCE 0.01  // the march stops once less light than this gets through
 const float PI = 3.14159265;
 
 
@@ -170,11 +175,23 @@ vec4 integrateDensity(vec3 ro, vec3 rd, ivec2 px) {
 
     float t = tmin + 0.1 * texelFetch(iChannel1, px & 1023, 0).x;
     vec4 sum = vec4(0.0);
-    const int oct = 5;
 
     for (int i = 0; i < 190; i++) {
         float dt = max(0.05, 0.02 * t);
+#ifdef VOL_OCCUPANCY
+        // empty cell of the occupancy grid: cross it in one step, skip map()
+        float skipTo = occupancySkipUntil(VOL_OCCUPANCY, ro, rd, t, 0.01);
+        if (skipTo > t) {
+            t = max(t + dt, skipTo);
+            if (t > tmax) break;
+            continue;
+        }
+#endif
         vec3 pos = ro + t * rd;
+        int oct = 5;
+#ifdef VOLUME_LOD_GLSL
+        oct = volumeOctaves(t);
+#endif
         float den = map(pos, oct);
 
         if (den > 0.01) {
@@ -186,7 +203,7 @@ vec4 integrateDensity(vec3 ro, vec3 rd, ivec2 px) {
         }
 
         t += dt;
-        if (t > tmax || sum.a > 0.99) break;
+        if (t > tmax || sum.a > 1.0 - VOL_MIN_TRANSMITTANCE) break;
     }
 
     return clamp(sum, 0.0, 1.0);
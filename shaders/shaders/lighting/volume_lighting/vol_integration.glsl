@@ -10,6 +10,21 @@
 uniform sampler2D NoiseTex;
 uniform vec2 Resolution; 
 
+// ------------------------------------------------------------
+// Optional, define before this module:
+//   VOL_OCCUPANCY         : sampler of a cloud occupancy buffer baked by
+//                           rendering/volume_occupancy.glsl, empty cells are
+//                           crossed in one step without evaluating map()
+//   VOL_MIN_TRANSMITTANCE : the march stops once less light than this gets through
+// rendering/volume_lod.glsl, added before this module, lowers the
+// octaves of map() with distance in integrateCloud.
+// integrateFog has no occupancy grid: its density depends on the
+// camera position, which a grid baked in world space can not bound.
+// ------------------------------------------------------------
+#ifndef VOL_MIN_TRANSMITTANCE
+#define VOL_MIN_TRANSMITTANCE 0.01
+#endif
+
 // ------------------------------------------------------------
 // Volume Sample
 // Description:
@@ -78,9 +93,22 @@ vec4 integrateCloud(vec3 rayOrigin, vec3 rayDir, float rayLength,
 
     for (int i = 0; i < int(stepCount); ++i) {
         float dt = max(0.05, 0.02 * t);
+#ifdef VOL_OCCUPANCY
+        // empty cell: crossed in one step, no density evaluation
+        float skipTo = occupancySkipUntil(VOL_OCCUPANCY, rayOrigin, rayDir, t, 0.01);
+        if (skipTo > t) {
+            t = max(t + dt, skipTo);
+            if (t > tmax) break;
+            continue;
+        }
+#endif
         vec3 p = rayOrigin + t * rayDir;
 
-        float density = map(p, 5);
+        int octaves = 5;
+#ifdef VOLUME_LOD_GLSL
+        octaves = volumeOctaves(t);
+#endif
+        float density = map(p, octaves);
         if (density > 0.01) {
             VolumeSample s;
             s.density = density * mat.densityScale;
@@ -97,7 +125,7 @@ vec4 integrateCloud(vec3 rayOrigin, vec3 rayDir, float rayLength,
         }
 
         t += dt;
-        if (t > tmax || accum.a > 0.99) break;
+        if (t > tmax || accum.a > 1.0 - VOL_MIN_TRANSMITTANCE) break;
     }
 
     return clamp(accum, 0.0, 1.0);
@@ -154,7 +182,7 @@ vec4 integrateFog(vec3 rayOrigin, vec3 rayDir, float rayLength,
         }
 
         t += dt;
-        if (t > rayLength || accum.a > 0.99) break;
+        if (t > rayLength || accum.a > 1.0 - VOL_MIN_TRANSMITTANCE) break;
     }
 
     return clamp(accum, 0.0, 1.0);
@@ -0,0 +1,25 @@
+/*
+ Octave LOD for the density of the volumetric integrators.
+
+  Far samples cover more of the volume than the finest octaves of map() can show. With VOL_LOD_DISTANCE above 0,
+  VolumeticRayMarch, integrateDensity and integrateCloud call map() with one octave less every doubling of the
+  distance past it. Add this module before them; without it they always use 5 octaves.
+
+  Configuration (define before including to override):
+    VOL_LOD_DISTANCE – distance at which map() drops to 4 octaves, 0 keeps 5 octaves everywhere
+ */
+
+#ifndef VOLUME_LOD_GLSL
+#define VOLUME_LOD_GLSL
+
+#ifndef VOL_LOD_DISTANCE
+#define VOL_LOD_DISTANCE 0.0
+#endif
+
+// FBM octaves at distance t, 5 up close, never fewer than 2
+int volumeOctaves(float t) {
+    if (VOL_LOD_DISTANCE <= 0.0) return 5;
+    return clamp(5 - int(floor(log2(max(t, 1e-4) / VOL_LOD_DISTANCE))), 2, 5);
+}
+
+#endif
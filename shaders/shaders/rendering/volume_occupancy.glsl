@@ -0,0 +1,126 @@
+/*
+ Occupancy grid for empty-space skipping in the volumetric integrators.
+
+  A prepass (e.g. Buffer A) bakes, for every cell of a coarse grid over the volume, an upper bound of the density
+  inside the cell: the maximum of a low-octave map() over 3x3x3 points of the cell plus OCC_MARGIN for the octaves
+  and the detail the samples miss. The integrators (VolumeticRayMarch, integrateDensity, integrateCloud) cross
+  a cell whose bound is below the density they treat as empty in one step, without evaluating map().
+  The density animates with iTime, so the prepass runs every frame; it costs a small fraction of one full-octave
+  sample per pixel.
+
+  Layout:
+    cell (x, y, z) → index x + res.x * (y + res.y * z), four cells per RGBA texel,
+    texel index / OCC_TEX_WIDTH rows of OCC_TEX_WIDTH texels. The defaults need a 512 × 256 buffer.
+
+  Configuration (define before including to override):
+    OCC_GRID_MIN / OCC_GRID_MAX – world-space box covered by the grid, outside of it nothing is skipped
+    OCC_GRID_RES                 – cells per axis
+    OCC_TEX_WIDTH                – width of the occupancy buffer in texels
+    OCC_OCTAVES                  – octaves of map() used by the bake
+    OCC_MARGIN                   – added to the baked maximum, larger is safer, smaller skips more
+    OCC_DENSITY(p)               – density that is baked, map(p, OCC_OCTAVES) by default
+
+  External dependencies:
+    float map(vec3 p, int oct)   – user-supplied density function (or OCC_DENSITY)
+ */
+
+#ifndef OCC_GRID_MIN
+#define OCC_GRID_MIN vec3(-60.0, CLOUD_BASE, -66.0)
+#endif
+#ifndef OCC_GRID_MAX
+#define OCC_GRID_MAX vec3(60.0, CLOUD_TOP, 54.0)
+#endif
+#ifndef OCC_GRID_RES
+#define OCC_GRID_RES ivec3(128, 32, 128)
+#endif
+#ifndef OCC_TEX_WIDTH
+#define OCC_TEX_WIDTH 512
+#endif
+#ifndef OCC_OCTAVES
+#define OCC_OCTAVES 2
+#endif
+#ifndef OCC_MARGIN
+#define OCC_MARGIN 0.2
+#endif
+#ifndef OCC_DENSITY
+#define OCC_DENSITY(p) map(p, OCC_OCTAVES)
+#endif
+
+vec3 occupancyCellSize() {
+    return (OCC_GRID_MAX - OCC_GRID_MIN) / vec3(OCC_GRID_RES);
+}
+
+// Upper bound of the density inside one cell
+float bakeOccupancyCell(int cell) {
+    ivec3 res = OCC_GRID_RES;
+    ivec3 c = ivec3(cell % res.x, (cell / res.x) % res.y, cell / (res.x * res.y));
+    vec3 size = occupancyCellSize();
+    vec3 cellMin = OCC_GRID_MIN + vec3(c) * size;
+
+    // corners, edge and face midpoints and the center
+    float maxDensity = -1e4;
+    for (int z = 0; z < 3; ++z)
+    for (int y = 0; y < 3; ++y)
+    for (int x = 0; x < 3; ++x) {
+        vec3 p = cellMin + 0.5 * vec3(x, y, z) * size;
+        maxDensity = max(maxDensity, OCC_DENSITY(p));
+    }
+    return maxDensity + OCC_MARGIN;
+}
+
+// Prepass entry: the four cells stored in one texel of the occupancy buffer
+vec4 bakeOccupancy(ivec2 texel) {
+    ivec3 res = OCC_GRID_RES;
+    int cellCount = res.x * res.y * res.z;
+    int first = (texel.y * OCC_TEX_WIDTH + texel.x) * 4;
+    if (texel.x >= OCC_TEX_WIDTH || first >= cellCount) return vec4(1e4);
+
+    vec4 bounds;
+    for (int i = 0; i < 4; ++i) {
+        bounds[i] = first + i < cellCount ? bakeOccupancyCell(first + i) : 1e4;
+    }
+    return bounds;
+}
+
+// Baked density bound of the cell containing p, a large value outside the grid
+float occupancyMaxDensity(sampler2D occupancy, vec3 p) {
+    ivec3 res = OCC_GRID_RES;
+    ivec3 c = ivec3(floor((p - OCC_GRID_MIN) / occupancyCellSize()));
+    if (any(lessThan(c, ivec3(0))) || any(greaterThanEqual(c, res))) return 1e4;
+
+    int cell = c.x + res.x * (c.y + res.y * c.z);
+    int texelIndex = cell / 4;
+    vec4 bounds = texelFetch(occupancy, ivec2(texelIndex % OCC_TEX_WIDTH, texelIndex / OCC_TEX_WIDTH), 0);
+    return bounds[cell % 4];
+}
+
+/*
+ Distance along the ray the integrator can jump to without evaluating the density: the exit of the cell
+ containing ro + t * rd if its bound is at most emptyDensity (the threshold of the integrator), t otherwise.
+ */
+float occupancySkipUntil(sampler2D occupancy, vec3 ro, vec3 rd, float t, float emptyDensity) {
+    vec3 p = ro + t * rd;
+    if (occupancyMaxDensity(occupancy, p) > emptyDensity) return t;
+
+    vec3 size = occupancyCellSize();
+    vec3 cellMin = OCC_GRID_MIN + floor((p - OCC_GRID_MIN) / size) * size;
+    vec3 forward = step(0.0, rd);
+    vec3 safeRd = (forward * 2.0 - 1.0) * max(abs(rd), vec3(1e-6));
+    vec3 tExit = (cellMin + forward * size - ro) / safeRd;
+    return max(t, min(min(tExit.x, tExit.y), tExit.z));
+}
+
+/*
+usage example:
+    // Common: map(), CLOUD_BASE / CLOUD_TOP and the OCC_* overrides, shared by both passes
+
+    // Buffer A (at least 512 × 256), bakes the grid every frame
+    void mainImage(out vec4 fragColor, in vec2 fragCoord) {
+        fragColor = bakeOccupancy(ivec2(fragCoord));
+    }
+
+    // Image, Buffer A bound to iChannel2
+    #define VOL_OCCUPANCY iChannel2
+    ...
+    vec4 vol = VolumeticRayMarch(ro, rd, ivec2(fragCoord));
+*/
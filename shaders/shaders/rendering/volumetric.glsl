@@ -14,7 +14,16 @@ External dependencies:
         float map(vec3 p, int oct)   – user-supplied density function
             map() must return  > 0.0  inside the cloud,
                                 ≤ 0.0 outside (air)
+Optional (define before this function):
+        VOL_OCCUPANCY          – sampler of the occupancy buffer baked by rendering/volume_occupancy.glsl,
+                                 empty cells are crossed in one step without calling map()
+        VOL_MIN_TRANSMITTANCE  – the march stops once less light than this gets through
+        rendering/volume_lod.glsl, added before this function, lowers the octaves of map() with distance
 */
+#ifndef VOL_MIN_TRANSMITTANCE
+#define VOL_MIN_TRANSMITTANCE 0.01
+#endif
+
 vec4 VolumeticRayMarch(vec3 ro, vec3 rd, ivec2 px) {
     float tb = (CLOUD_BASE - ro.y) / rd.y; 
     float tt = (CLOUD_TOP  - ro.y) / rd.y;
@@ -40,12 +49,24 @@ vec4 VolumeticRayMarch(vec3 ro, vec3 rd, ivec2 px) {
     // Add blue-noise dither to the first sample position, helps break up banding artifacts
     float t = tmin + 0.1 * texelFetch(iChannel1, px & 1023, 0).x;
     vec4 sum = vec4(0.0);  // accumulated RGBA (premultiplied)
-    const int oct = 5;       // FBM octave count (passed to map)
 
     for (int i = 0; i < 190; i++) {
         // adaptive step size: finer when close, coarser when fa
         float dt = max(0.05, 0.02 * t);
+#ifdef VOL_OCCUPANCY
+        // an empty cell is crossed in one iteration, never in less than a regular step
+        float skipTo = occupancySkipUntil(VOL_OCCUPANCY, ro, rd, t, 0.01);
+        if (skipTo > t) {
+            t = max(t + dt, skipTo);
+            if (t > tmax) break;
+            continue;
+        }
+#endif
         vec3 pos = ro + t * rd;
+        int oct = 5;
+#ifdef VOLUME_LOD_GLSL
+        oct = volumeOctaves(t);
+#endif
         float den = map(pos, oct); /*!!! Density Function needed, Positive den → cloud/medium density  Negative or zero → empty air!!!*/
 
         if (den > 0.01) {
@@ -58,7 +79,7 @@ vec4 VolumeticRayMarch(vec3 ro, vec3 rd, ivec2 px) {
 
         t += dt;
         // exit when outside the cloud or nearly opaque
-        if (t > tmax || sum.a > 0.99) break;
+        if (t > tmax || sum.a > 1.0 - VOL_MIN_TRANSMITTANCE) break;
     }
     // Clamp numeric drift and return premultiplied colour + alpha
     return clamp(sum, 0.0, 1.0);
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFAmalgamateCommandlet.h"
+#include "PSFShaderGraph.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UPSFAmalgamateCommandlet::UPSFAmalgamateCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFAmalgamateCommandlet::Main(const FString &Params)
+{
+	FString EntryString;
+	if(!FParse::Value(*Params, TEXT("Entry="), EntryString, false))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFAmalgamate -Entry=<function,...> [-Root=procedural_shader.ush] [-Dir=<Shaders>] [-Out=<PSFAmalgamated.ush>] [-Graph=<graph.json>]"));
+		return 1;
+	}
+
+	TArray<FString> EntryPoints;
+	EntryString.ParseIntoArray(EntryPoints, TEXT(","));
+
+	// the project copy, it also has MyCustomSDFs.ush
+	FString ShaderDir = FPaths::ProjectDir() / TEXT("Shaders");
+	FString Root = TEXT("procedural_shader.ush");
+	FString OutPath = FPaths::ProjectDir() / TEXT("Shaders") / TEXT("PSFAmalgamated.ush");
+	FParse::Value(*Params, TEXT("Dir="), ShaderDir);
+	FParse::Value(*Params, TEXT("Root="), Root);
+	FParse::Value(*Params, TEXT("Out="), OutPath);
+
+	FPSFShaderGraph Graph;
+	if(!Graph.LoadFromDirectory(ShaderDir, Root))
+	{
+		return 1;
+	}
+
+	FString GraphPath;
+	if(FParse::Value(*Params, TEXT("Graph="), GraphPath) && !FFileHelper::SaveStringToFile(Graph.ToJsonString(), *GraphPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write shader graph to: %s"), *GraphPath);
+		return 1;
+	}
+
+	FPSFAmalgamationStats Stats;
+	const FString Code = Graph.Amalgamate(Root, EntryPoints, Stats);
+	for(const FString &EntryPoint : EntryPoints)
+	{
+		if(!Graph.HasFunction(EntryPoint))
+		{
+			return 1;
+		}
+	}
+
+	if(!FFileHelper::SaveStringToFile(Code, *OutPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write amalgamated shader to: %s"), *OutPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Amalgamated shader written to: %s"), *OutPath);
+	FPSFShaderGraph::LogStats(Stats);
+	return 0;
+}
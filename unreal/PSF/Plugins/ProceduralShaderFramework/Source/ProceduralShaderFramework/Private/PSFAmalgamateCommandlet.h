@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFAmalgamateCommandlet.generated.h"
+
+/**
+ * Writes a single header with only the shader functions that the given entry points need and logs how much was removed.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFAmalgamate -Entry=raymarchAll,applyPhongLighting [-Root=procedural_shader.ush]
+ *     [-Dir=<Shaders>] [-Out=<Shaders/PSFAmalgamated.ush>] [-Graph=<graph.json>]
+ */
+UCLASS()
+class UPSFAmalgamateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFAmalgamateCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFAnimation.h"
+#include "PSFNoise.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+FVector3f PSFAnimation::OrbitObjectAroundPoint(const FVector3f &SeedPosition, const FVector3f &Center, const FVector3f &InAxis, float Radius, float Speed,
+	float AngleOffset, float Time, float &OutAngle)
+{
+	const FVector3f Axis = Normalize(InAxis);
+	const float Angle = Time * Speed + AngleOffset * UE_PI / 180.0f;
+
+	const FVector3f RadiusAxis = (FVector3f(1.0f, 1.0f, 1.0f) - Axis) * Radius;
+
+	const FVector3f P = SeedPosition + RadiusAxis - Center;
+	const float CosAngle = FMath::Cos(Angle);
+	const float SinAngle = FMath::Sin(Angle);
+	OutAngle = Angle * 180.0f / UE_PI;
+	return Center + P * CosAngle + (Axis ^ P) * SinAngle + Axis * ((1.0f - CosAngle) * (Axis | P));
+}
+
+FVector3f PSFAnimation::ShakeObject(const FVector3f &SeedPosition, float Intensity, float Speed, float Time)
+{
+	const float T = Time * Speed;
+
+	const float X = PSFNoise::Hash11(T + 1.1f) - 0.5f;
+	const float Y = PSFNoise::Hash11(T + 2.3f) - 0.5f;
+	const float Z = PSFNoise::Hash11(T + 3.7f) - 0.5f;
+
+	return SeedPosition + FVector3f(X, Y, Z) * Intensity;
+}
+
+FVector3f PSFAnimation::CycleColor(const FVector3f &SeedColor, float Speed, float Time)
+{
+	const float Hue = Frac(Time * Speed);
+	const FVector3f Offsets(0.0f, 2.0f / 3.0f, 1.0f / 3.0f);
+	FVector3f Rgb;
+	for(int32 Channel = 0; Channel < 3; ++Channel)
+	{
+		Rgb[Channel] = Saturate(FMath::Abs(Frac(Hue + Offsets[Channel]) * 6.0f - 3.0f) - 1.0f);
+	}
+	return Rgb * SeedColor;
+}
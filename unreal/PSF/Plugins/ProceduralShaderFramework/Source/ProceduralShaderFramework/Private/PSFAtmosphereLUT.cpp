@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFAtmosphereLUT.h"
+#include "PSFShaderMath.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	const FVector3f BR(58e-7f, 135e-7f, 331e-7f); // Rayleigh scattering coefficient
+	const FVector3f BMs(2e-5f, 2e-5f, 2e-5f); // Mie scattering coefficients
+	const FVector3f BMe = BMs * 1.1f;
+
+	/** sunriseZenithToCoord, square root spacing puts half of the texels within 15 degrees of the horizon */
+	float ZenithToCoord(float Mu)
+	{
+		return 0.5f + 0.5f * FMath::Sign(Mu) * FMath::Sqrt(FMath::Abs(Mu));
+	}
+
+	float CoordToZenith(float Coord)
+	{
+		const float S = 2.0f * Coord - 1.0f;
+		return FMath::Sign(S) * S * S;
+	}
+
+	/** Texel I of Size maps to coordinate I / (Size - 1), so both ends of the range sit on texel centers */
+	float TexelToCoord(int32 Texel, int32 Size)
+	{
+		return Size > 1 ? float(Texel) / float(Size - 1) : 0.0f;
+	}
+
+	/** Continuous texel position of a coordinate, texel centers at I + 0.5 like a sampler */
+	float CoordToTexel(float Coord, int32 Size)
+	{
+		return FMath::Clamp(Coord, 0.0f, 1.0f) * float(Size - 1) + 0.5f;
+	}
+
+	/** Bilinear fetch with clamped addressing from the SizeX x SizeY slice starting at Offset, X and Y in texels */
+	FVector4f SampleBilinear(const TArray<FVector4f> &Data, int32 Offset, int32 SizeX, int32 SizeY, float X, float Y)
+	{
+		X -= 0.5f;
+		Y -= 0.5f;
+		const int32 X0 = FMath::Clamp(FMath::FloorToInt(X), 0, SizeX - 1);
+		const int32 Y0 = FMath::Clamp(FMath::FloorToInt(Y), 0, SizeY - 1);
+		const int32 X1 = FMath::Min(X0 + 1, SizeX - 1);
+		const int32 Y1 = FMath::Min(Y0 + 1, SizeY - 1);
+		const float FX = FMath::Clamp(X - float(X0), 0.0f, 1.0f);
+		const float FY = FMath::Clamp(Y - float(Y0), 0.0f, 1.0f);
+		const FVector4f Bottom = FMath::Lerp(Data[Offset + Y0 * SizeX + X0], Data[Offset + Y0 * SizeX + X1], FX);
+		const FVector4f Top = FMath::Lerp(Data[Offset + Y1 * SizeX + X0], Data[Offset + Y1 * SizeX + X1], FX);
+		return FMath::Lerp(Bottom, Top, FY);
+	}
+
+	/** Trilinear fetch with clamped addressing, positions in texels */
+	FVector4f SampleTrilinear(const TArray<FVector4f> &Data, const FIntVector &Size, float X, float Y, float Z)
+	{
+		Z -= 0.5f;
+		const int32 Z0 = FMath::Clamp(FMath::FloorToInt(Z), 0, Size.Z - 1);
+		const int32 Z1 = FMath::Min(Z0 + 1, Size.Z - 1);
+		const float FZ = FMath::Clamp(Z - float(Z0), 0.0f, 1.0f);
+		const int32 SliceTexels = Size.X * Size.Y;
+		const FVector4f Near = SampleBilinear(Data, Z0 * SliceTexels, Size.X, Size.Y, X, Y);
+		const FVector4f Far = SampleBilinear(Data, Z1 * SliceTexels, Size.X, Size.Y, X, Y);
+		return FMath::Lerp(Near, Far, FZ);
+	}
+
+	/** The optical depth part of the applySunriseLighting loop */
+	FVector2f ViewDepth(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, const FPSFSunriseLight &Light)
+	{
+		FVector2f DepthRM(0.0f, 0.0f);
+		AtmosphericDistance /= 16.0f;
+		Direction *= AtmosphericDistance;
+		for(float I = 0.0f; I < 16.0f; ++I)
+		{
+			DepthRM += PSFLighting::DensitiesRM(Position + Direction * I, Light) * AtmosphericDistance;
+		}
+		return DepthRM;
+	}
+
+	struct FLookup
+	{
+		float Altitude;
+		float ViewCoord;
+		float SunCoord;
+		float Mu;
+	};
+
+	FLookup MakeLookup(const FPSFAtmosphereLUT &LUT, const FVector3f &Position, const FVector3f &Direction, const FPSFSunriseLight &Light)
+	{
+		FVector3f Up = Position - Light.EarthCenter;
+		const float R = Up.Size();
+		Up /= R;
+
+		FLookup Lookup;
+		Lookup.Altitude = FMath::Clamp(FMath::Max(R - Light.EarthRadius, 0.0f) / LUT.Settings.MaxAltitude, 0.0f, 1.0f);
+		Lookup.ViewCoord = ZenithToCoord(Direction | Up);
+		Lookup.SunCoord = ZenithToCoord(Light.SunDir | Up);
+		Lookup.Mu = Direction | Light.SunDir;
+		return Lookup;
+	}
+
+	/** sunriseInScatteringLUT without the sun intensity and the phase functions: Rayleigh in xyz of the first, Mie of the second */
+	void SampleScatter(const FPSFAtmosphereLUT &LUT, const FLookup &Lookup, FVector3f &OutRayleigh, FVector3f &OutMie)
+	{
+		const FPSFAtmosphereLUTSettings &Settings = LUT.Settings;
+		const FIntVector Size = LUT.GetScatterSize();
+		const float Slice = Lookup.Altitude * float(Settings.AltitudeSlices - 1);
+		const float Slice0 = FMath::FloorToFloat(Slice);
+		const float Slice1 = FMath::Min(Slice0 + 1.0f, float(Settings.AltitudeSlices - 1));
+
+		// the sun zenith is clamped inside every altitude block, the altitude is blended by hand
+		const float U = CoordToTexel(0.5f + 0.5f * Lookup.Mu, Settings.AngleSize);
+		const float V = CoordToTexel(Lookup.ViewCoord, Settings.ViewSize);
+		const float W = CoordToTexel(Lookup.SunCoord, Settings.SunSize);
+		const float Z0 = Slice0 * Settings.SunSize + W;
+		const float Z1 = Slice1 * Settings.SunSize + W;
+		const float Blend = Slice - Slice0;
+
+		const FVector4f Rayleigh = FMath::Lerp(SampleTrilinear(LUT.Scatter, Size, U, V, Z0), SampleTrilinear(LUT.Scatter, Size, U, V, Z1), Blend);
+		const FVector4f Mie = FMath::Lerp(SampleTrilinear(LUT.Scatter, Size, U + Settings.AngleSize, V, Z0), SampleTrilinear(LUT.Scatter, Size, U + Settings.AngleSize, V, Z1), Blend);
+		OutRayleigh = FVector3f(Rayleigh.X, Rayleigh.Y, Rayleigh.Z);
+		OutMie = FVector3f(Mie.X, Mie.Y, Mie.Z);
+	}
+}
+
+bool FPSFAtmosphereLUTBaker::Bake(const FPSFAtmosphereLUTSettings &Settings, const FPSFSunriseLight &Light, FPSFAtmosphereLUT &OutLUT, FPSFAtmosphereLUTStats &OutStats)
+{
+	if(Settings.DepthViewSize < 2 || Settings.DepthAltitudeSize < 2 || Settings.AngleSize < 2 || Settings.ViewSize < 2 || Settings.SunSize < 2
+		|| Settings.AltitudeSlices < 2 || Settings.MaxAltitude <= 0.0f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid atmosphere LUT settings: every table side needs at least 2 texels and the max altitude must be positive."));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	OutLUT.Settings = Settings;
+	OutLUT.Light = Light;
+
+	// the tables are baked at the north pole, every other point of the sphere is a rotation of it
+	const auto MakePosition = [&Light](float Altitude)
+	{
+		return Light.EarthCenter + FVector3f(0.0f, Light.EarthRadius + Altitude, 0.0f);
+	};
+	const auto MakeDirection = [](float Mu)
+	{
+		return FVector3f(FMath::Sqrt(FMath::Max(1.0f - Mu * Mu, 0.0f)), Mu, 0.0f);
+	};
+
+	OutLUT.Depth.SetNumUninitialized(Settings.DepthViewSize * Settings.DepthAltitudeSize);
+	ParallelFor(Settings.DepthAltitudeSize, [&](int32 Row)
+	{
+		const FVector3f Position = MakePosition(TexelToCoord(Row, Settings.DepthAltitudeSize) * Settings.MaxAltitude);
+		for(int32 Column = 0; Column < Settings.DepthViewSize; ++Column)
+		{
+			const FVector3f Direction = MakeDirection(CoordToZenith(TexelToCoord(Column, Settings.DepthViewSize)));
+			const FVector2f DepthRM = ViewDepth(Position, Direction, PSFLighting::Escape(Position, Direction, Light.AtmosphereRadius, Light.EarthCenter), Light);
+			OutLUT.Depth[Row * Settings.DepthViewSize + Column] = FVector4f(DepthRM.X, DepthRM.Y, 0.0f, 0.0f);
+		}
+	});
+
+	const FIntVector Size = OutLUT.GetScatterSize();
+	OutLUT.Scatter.SetNumUninitialized(Size.X * Size.Y * Size.Z);
+	ParallelFor(Size.Z, [&](int32 Slice)
+	{
+		FPSFSunriseLight SliceLight = Light;
+		const int32 AltitudeSlice = Slice / Settings.SunSize;
+		const FVector3f Position = MakePosition(TexelToCoord(AltitudeSlice, Settings.AltitudeSlices) * Settings.MaxAltitude);
+		const float SunMu = CoordToZenith(TexelToCoord(Slice % Settings.SunSize, Settings.SunSize));
+		const float SunSin = FMath::Sqrt(FMath::Max(1.0f - SunMu * SunMu, 0.0f));
+
+		for(int32 Row = 0; Row < Size.Y; ++Row)
+		{
+			const float ViewMu = CoordToZenith(TexelToCoord(Row, Settings.ViewSize));
+			const FVector3f Direction = MakeDirection(ViewMu);
+			const float AtmosphereDist = PSFLighting::Escape(Position, Direction, Light.AtmosphereRadius, Light.EarthCenter);
+			const float SinProduct = Direction.X * SunSin;
+
+			for(int32 Column = 0; Column < Settings.AngleSize; ++Column)
+			{
+				// the sun azimuth that gives the view / sun angle of the column, clamped where the angle can not occur
+				const float Mu = TexelToCoord(Column, Settings.AngleSize) * 2.0f - 1.0f;
+				const float CosAzimuth = SinProduct > 1e-5f ? FMath::Clamp((Mu - ViewMu * SunMu) / SinProduct, -1.0f, 1.0f) : 0.0f;
+				SliceLight.SunDir = FVector3f(SunSin * CosAzimuth, SunMu, SunSin * FMath::Sqrt(FMath::Max(1.0f - CosAzimuth * CosAzimuth, 0.0f)));
+
+				FVector2f DepthRM;
+				FVector3f IR, IM;
+				PSFLighting::SunriseInScattering(Position, Direction, AtmosphereDist, SliceLight, DepthRM, IR, IM);
+
+				const int32 RowStart = (Slice * Size.Y + Row) * Size.X;
+				OutLUT.Scatter[RowStart + Column] = FVector4f(IR * BR * 0.0597f, 0.0f);
+				OutLUT.Scatter[RowStart + Settings.AngleSize + Column] = FVector4f(IM * BMs * 0.0196f, 0.0f);
+			}
+		}
+	});
+
+	OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+	OutStats.Integrals = int64(OutLUT.Depth.Num()) + OutLUT.Scatter.Num() / 2;
+	OutStats.Bytes = OutLUT.GetNumBytes();
+	return true;
+}
+
+FVector3f FPSFAtmosphereLUTBaker::InScattering(const FPSFAtmosphereLUT &LUT, const FVector3f &Position, const FVector3f &Direction, const FPSFSunriseLight &Light)
+{
+	const FLookup Lookup = MakeLookup(LUT, Position, Direction, Light);
+	FVector3f Rayleigh, Mie;
+	SampleScatter(LUT, Lookup, Rayleigh, Mie);
+	return Light.SunIntensity * (1.0f + Lookup.Mu * Lookup.Mu) * (Rayleigh + Mie / FMath::Pow(1.58f - 1.52f * Lookup.Mu, 1.5f));
+}
+
+FVector3f FPSFAtmosphereLUTBaker::ApplySunriseLighting(const FPSFAtmosphereLUT &LUT, const FVector3f &Position, const FVector3f &Direction, const FVector3f &Lo, const FPSFSunriseLight &Light)
+{
+	const FLookup Lookup = MakeLookup(LUT, Position, Direction, Light);
+	const FPSFAtmosphereLUTSettings &Settings = LUT.Settings;
+	const FVector4f DepthRM = SampleBilinear(LUT.Depth, 0, Settings.DepthViewSize, Settings.DepthAltitudeSize,
+		CoordToTexel(Lookup.ViewCoord, Settings.DepthViewSize), CoordToTexel(Lookup.Altitude, Settings.DepthAltitudeSize));
+
+	FVector3f Rayleigh, Mie;
+	SampleScatter(LUT, Lookup, Rayleigh, Mie);
+	return Lo + Lo * Exp(-BR * DepthRM.X - BMe * DepthRM.Y)
+		+ Light.SunIntensity * (1.0f + Lookup.Mu * Lookup.Mu) * (Rayleigh + Mie / FMath::Pow(1.58f - 1.52f * Lookup.Mu, 1.5f));
+}
+
+void FPSFAtmosphereLUTBaker::MeasureError(const FPSFAtmosphereLUT &LUT, FPSFAtmosphereLUTStats &InOutStats)
+{
+	struct FSample
+	{
+		FVector3f Position;
+		FVector3f Direction;
+		FVector3f Lo;
+		FPSFSunriseLight Light;
+	};
+
+	// rays from anywhere below the max altitude, under the suns addSunriseLight animates through
+	FRandomStream Random(0x5c47);
+	const int32 NumSamples = FMath::Max(LUT.Settings.ErrorSamples, 1);
+	TArray<FSample> Samples;
+	Samples.SetNum(NumSamples);
+	for(FSample &Sample : Samples)
+	{
+		Sample.Light = FPSFSunriseLight::Make(Random.FRand() * 4.0f * PI);
+		Sample.Light.EarthCenter = LUT.Light.EarthCenter;
+		Sample.Light.EarthRadius = LUT.Light.EarthRadius;
+		Sample.Light.AtmosphereRadius = LUT.Light.AtmosphereRadius;
+		Sample.Position = FVector3f((Random.FRand() * 2.0f - 1.0f) * 1000.0f, Random.FRand() * LUT.Settings.MaxAltitude, (Random.FRand() * 2.0f - 1.0f) * 1000.0f);
+		Sample.Direction = FVector3f(Random.GetUnitVector());
+		Sample.Lo = FVector3f(Random.FRand(), Random.FRand(), Random.FRand());
+	}
+
+	TArray<FVector3f> Analytic;
+	Analytic.SetNumUninitialized(NumSamples);
+	double Start = FPlatformTime::Seconds();
+	for(int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const FSample &Sample = Samples[Index];
+		const float AtmosphereDist = PSFLighting::Escape(Sample.Position, Sample.Direction, Sample.Light.AtmosphereRadius, Sample.Light.EarthCenter);
+		Analytic[Index] = PSFLighting::ApplySunriseLighting(Sample.Position, Sample.Direction, AtmosphereDist, Sample.Lo, Sample.Light);
+	}
+	InOutStats.AnalyticNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / NumSamples;
+
+	TArray<FVector3f> Baked;
+	Baked.SetNumUninitialized(NumSamples);
+	Start = FPlatformTime::Seconds();
+	for(int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const FSample &Sample = Samples[Index];
+		Baked[Index] = ApplySunriseLighting(LUT, Sample.Position, Sample.Direction, Sample.Lo, Sample.Light);
+	}
+	InOutStats.LUTNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / NumSamples;
+
+	double SquaredSum = 0.0;
+	InOutStats.MaxError = 0.0f;
+	InOutStats.MaxValue = 0.0f;
+	for(int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const FVector3f Difference = Baked[Index] - Analytic[Index];
+		const float Error = Difference.GetAbsMax();
+		InOutStats.MaxError = FMath::Max(InOutStats.MaxError, Error);
+		InOutStats.MaxValue = FMath::Max(InOutStats.MaxValue, Analytic[Index].GetAbsMax());
+		SquaredSum += double(Error) * Error;
+	}
+	InOutStats.RmsError = float(FMath::Sqrt(SquaredSum / NumSamples));
+}
+
+void FPSFAtmosphereLUTBaker::LogStats(const FPSFAtmosphereLUTStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("Baked the atmosphere LUTs in %.2f s, %.0f view integrals/s, %.2f MB"), Stats.Seconds,
+		Stats.Seconds > 0.0 ? Stats.Integrals / Stats.Seconds : 0.0, Stats.Bytes / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Display, TEXT("Sky color error against applySunriseLighting: max %.5f, rms %.5f (brightest sample %.3f)"),
+		Stats.MaxError, Stats.RmsError, Stats.MaxValue);
+	UE_LOG(LogTemp, Display, TEXT("CPU cost of applySunriseLighting: %.1f ns analytic, %.1f ns LUT (%.1fx)"), Stats.AnalyticNsPerEval, Stats.LUTNsPerEval,
+		Stats.LUTNsPerEval > 0.0 ? Stats.AnalyticNsPerEval / Stats.LUTNsPerEval : 0.0);
+}
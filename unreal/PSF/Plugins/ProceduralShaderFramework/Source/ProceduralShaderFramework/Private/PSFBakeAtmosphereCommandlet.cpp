@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFBakeAtmosphereCommandlet.h"
+#include "PSFAtmosphereLUT.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	bool SaveTexture(UPackage *Package, UTexture *Texture)
+	{
+		Texture->SRGB = false;
+		Texture->CompressionNone = true;
+		Texture->CompressionSettings = TC_HDR_F32;
+		Texture->MipGenSettings = TMGS_NoMipmaps;
+		Texture->Filter = TF_Bilinear;
+		Texture->PostEditChange();
+		Package->MarkPackageDirty();
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if(!UPackage::SavePackage(Package, Texture, *FileName, SaveArgs))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to save atmosphere LUT: %s"), *FileName);
+			return false;
+		}
+		return true;
+	}
+}
+
+UPSFBakeAtmosphereCommandlet::UPSFBakeAtmosphereCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFBakeAtmosphereCommandlet::Main(const FString &Params)
+{
+	FPSFAtmosphereLUTSettings Settings;
+	FParse::Value(*Params, TEXT("AngleSize="), Settings.AngleSize);
+	FParse::Value(*Params, TEXT("ViewSize="), Settings.ViewSize);
+	FParse::Value(*Params, TEXT("SunSize="), Settings.SunSize);
+	FParse::Value(*Params, TEXT("AltitudeSlices="), Settings.AltitudeSlices);
+	FParse::Value(*Params, TEXT("MaxAltitude="), Settings.MaxAltitude);
+	FParse::Value(*Params, TEXT("DepthSize="), Settings.DepthViewSize);
+
+	FString PackagePath = TEXT("/Game/PSF/Baked");
+	FParse::Value(*Params, TEXT("Package="), PackagePath);
+	FString AssetName = TEXT("Sunrise");
+	FParse::Value(*Params, TEXT("Name="), AssetName);
+
+	// the planet of addSunriseLight, the sun direction does not matter for the bake
+	FPSFAtmosphereLUT LUT;
+	FPSFAtmosphereLUTStats Stats;
+	if(!FPSFAtmosphereLUTBaker::Bake(Settings, FPSFSunriseLight::Make(0.0f), LUT, Stats))
+	{
+		return 1;
+	}
+	FPSFAtmosphereLUTBaker::MeasureError(LUT, Stats);
+	FPSFAtmosphereLUTBaker::LogStats(Stats);
+
+	const FString DepthName = AssetName + TEXT("_Depth");
+	UPackage *DepthPackage = CreatePackage(*(PackagePath / DepthName));
+	UTexture2D *DepthTexture = NewObject<UTexture2D>(DepthPackage, *DepthName, RF_Public | RF_Standalone);
+	DepthTexture->Source.Init(Settings.DepthViewSize, Settings.DepthAltitudeSize, 1, 1, TSF_RGBA32F, reinterpret_cast<const uint8 *>(LUT.Depth.GetData()));
+	DepthTexture->AddressX = TA_Clamp;
+	DepthTexture->AddressY = TA_Clamp;
+
+	const FString ScatterName = AssetName + TEXT("_Scatter");
+	const FIntVector ScatterSize = LUT.GetScatterSize();
+	UPackage *ScatterPackage = CreatePackage(*(PackagePath / ScatterName));
+	UVolumeTexture *ScatterTexture = NewObject<UVolumeTexture>(ScatterPackage, *ScatterName, RF_Public | RF_Standalone);
+	ScatterTexture->Source.Init(ScatterSize.X, ScatterSize.Y, ScatterSize.Z, 1, TSF_RGBA32F, reinterpret_cast<const uint8 *>(LUT.Scatter.GetData()));
+	ScatterTexture->AddressMode = TA_Clamp;
+
+	if(!SaveTexture(DepthPackage, DepthTexture) || !SaveTexture(ScatterPackage, ScatterTexture))
+	{
+		return 1;
+	}
+
+	const FVector4f ShaderParameters = LUT.GetShaderParameters();
+	UE_LOG(LogTemp, Display, TEXT("applySunriseLightingLUT(p, dir, Lo, light, %s, %sSampler, %s, %sSampler, float4(%g, %g, 0, 0))"),
+		*DepthName, *DepthName, *ScatterName, *ScatterName, ShaderParameters.X, ShaderParameters.Y);
+
+	FString ReportPath;
+	if(FParse::Value(*Params, TEXT("Report="), ReportPath))
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("depth"), PackagePath / DepthName);
+		Root->SetStringField(TEXT("scatter"), PackagePath / ScatterName);
+		Root->SetNumberField(TEXT("angleSize"), Settings.AngleSize);
+		Root->SetNumberField(TEXT("viewSize"), Settings.ViewSize);
+		Root->SetNumberField(TEXT("sunSize"), Settings.SunSize);
+		Root->SetNumberField(TEXT("altitudeSlices"), Settings.AltitudeSlices);
+		Root->SetNumberField(TEXT("maxAltitude"), Settings.MaxAltitude);
+		Root->SetNumberField(TEXT("seconds"), Stats.Seconds);
+		Root->SetNumberField(TEXT("integralsPerSecond"), Stats.Seconds > 0.0 ? Stats.Integrals / Stats.Seconds : 0.0);
+		Root->SetNumberField(TEXT("bytes"), double(Stats.Bytes));
+		Root->SetNumberField(TEXT("maxError"), Stats.MaxError);
+		Root->SetNumberField(TEXT("rmsError"), Stats.RmsError);
+		Root->SetNumberField(TEXT("maxValue"), Stats.MaxValue);
+		Root->SetNumberField(TEXT("analyticNsPerEval"), Stats.AnalyticNsPerEval);
+		Root->SetNumberField(TEXT("lutNsPerEval"), Stats.LUTNsPerEval);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+		if(!FFileHelper::SaveStringToFile(JsonString, *ReportPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write bake report: %s"), *ReportPath);
+			return 1;
+		}
+	}
+	return 0;
+}
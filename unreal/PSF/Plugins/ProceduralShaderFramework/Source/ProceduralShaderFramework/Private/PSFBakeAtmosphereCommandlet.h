@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFBakeAtmosphereCommandlet.generated.h"
+
+/**
+ * Bakes the sunrise atmosphere of lighting_functions.ush into the lookup tables of applySunriseLightingLUT and
+ * addSunriseLightLUT, and reports their error and cost against applySunriseLighting.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFBakeAtmosphere [-AngleSize=32] [-ViewSize=64] [-SunSize=32] [-AltitudeSlices=4]
+ *     [-MaxAltitude=1000] [-DepthSize=128] [-Package=/Game/PSF/Baked] [-Name=Sunrise] [-Report=<report.json>]
+ */
+UCLASS()
+class UPSFBakeAtmosphereCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFBakeAtmosphereCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFBakeSdfCommandlet.h"
+#include "PSFScene.h"
+#include "PSFSdfBaker.h"
+#include "Engine/VolumeTexture.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	UVolumeTexture *SaveVolumeTexture(const FString &PackagePath, const FString &AssetName, const FIntVector &Size, ETextureSourceFormat Format, const void *Data, bool bFiltered)
+	{
+		UPackage *Package = CreatePackage(*(PackagePath / AssetName));
+		UVolumeTexture *Texture = NewObject<UVolumeTexture>(Package, *AssetName, RF_Public | RF_Standalone);
+		Texture->Source.Init(Size.X, Size.Y, Size.Z, 1, Format, static_cast<const uint8 *>(Data));
+		Texture->SRGB = false;
+		Texture->CompressionNone = true;
+		Texture->CompressionSettings = Format == TSF_R16F ? TC_HalfFloat : TC_HDR_F32;
+		Texture->MipGenSettings = TMGS_NoMipmaps;
+
+		// the brick index is read with Load, the atlas is filtered inside a brick
+		Texture->Filter = bFiltered ? TF_Bilinear : TF_Nearest;
+		Texture->PostEditChange();
+		Package->MarkPackageDirty();
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if(!UPackage::SavePackage(Package, Texture, *FileName, SaveArgs))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to save baked SDF texture: %s"), *FileName);
+			return nullptr;
+		}
+		return Texture;
+	}
+
+	bool ParseBounds(const FString &BoundsString, FBox3f &OutBounds)
+	{
+		TArray<FString> Values;
+		BoundsString.ParseIntoArray(Values, TEXT(","));
+		if(Values.Num() != 6)
+		{
+			return false;
+		}
+		OutBounds = FBox3f(FVector3f(FCString::Atof(*Values[0]), FCString::Atof(*Values[1]), FCString::Atof(*Values[2])),
+			FVector3f(FCString::Atof(*Values[3]), FCString::Atof(*Values[4]), FCString::Atof(*Values[5])));
+		return true;
+	}
+
+	TSharedRef<FJsonObject> BakeToJson(int32 Index, const FPSFSdf &Sdf, const FString &PackagePath, const FString &AssetPrefix, const FPSFBakedSdf &Baked, const FPSFSdfBakeStats &Stats)
+	{
+		const FVector4f BakeOrigin = Baked.GetBakeOrigin();
+		TArray<TSharedPtr<FJsonValue>> OriginValues;
+		for(int32 Component = 0; Component < 4; ++Component)
+		{
+			OriginValues.Add(MakeShared<FJsonValueNumber>(BakeOrigin[Component]));
+		}
+
+		TSharedRef<FJsonObject> BakeObject = MakeShared<FJsonObject>();
+		BakeObject->SetNumberField(TEXT("index"), Index);
+		BakeObject->SetStringField(TEXT("type"), PSFScene::SdfTypeToString(Sdf.Type));
+		BakeObject->SetStringField(TEXT("bricks"), PackagePath / AssetPrefix + TEXT("_Bricks"));
+		BakeObject->SetStringField(TEXT("atlas"), PackagePath / AssetPrefix + TEXT("_Atlas"));
+		BakeObject->SetArrayField(TEXT("bakeOrigin"), OriginValues);
+		BakeObject->SetNumberField(TEXT("seconds"), Stats.Seconds);
+		BakeObject->SetNumberField(TEXT("sdfEvaluationsPerSecond"), Stats.Seconds > 0.0 ? Stats.SdfEvaluations / Stats.Seconds : 0.0);
+		BakeObject->SetNumberField(TEXT("totalBricks"), Stats.TotalBricks);
+		BakeObject->SetNumberField(TEXT("allocatedBricks"), Stats.AllocatedBricks);
+		BakeObject->SetNumberField(TEXT("bakedBytes"), double(Stats.BakedBytes));
+		BakeObject->SetNumberField(TEXT("denseBytes"), double(Stats.DenseBytes));
+		BakeObject->SetNumberField(TEXT("maxError"), Stats.MaxError);
+		BakeObject->SetNumberField(TEXT("rmsError"), Stats.RmsError);
+		BakeObject->SetNumberField(TEXT("maxOvershoot"), Stats.MaxOvershoot);
+		BakeObject->SetNumberField(TEXT("analyticNsPerEval"), Stats.AnalyticNsPerEval);
+		BakeObject->SetNumberField(TEXT("bakedNsPerEval"), Stats.BakedNsPerEval);
+		return BakeObject;
+	}
+}
+
+UPSFBakeSdfCommandlet::UPSFBakeSdfCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFBakeSdfCommandlet::Main(const FString &Params)
+{
+	FString ScenePath;
+	if(!FParse::Value(*Params, TEXT("Scene="), ScenePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFBakeSdf -Scene=<scene.json> [-Index=<n>] [-Resolution=128] [-Band=4] [-Bounds=minX,minY,minZ,maxX,maxY,maxZ] [-Package=/Game/PSF/Baked] [-Report=<report.json>]"));
+		return 1;
+	}
+
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
+	{
+		return 1;
+	}
+
+	FPSFSdfBakeSettings Settings;
+	FParse::Value(*Params, TEXT("Resolution="), Settings.Resolution);
+	FParse::Value(*Params, TEXT("Band="), Settings.NarrowBandVoxels);
+
+	FBox3f Bounds(ForceInit);
+	FString BoundsString;
+	if(FParse::Value(*Params, TEXT("Bounds="), BoundsString, false) && !ParseBounds(BoundsString, Bounds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("-Bounds needs six comma separated values: %s"), *BoundsString);
+		return 1;
+	}
+
+	FString PackagePath = TEXT("/Game/PSF/Baked");
+	FParse::Value(*Params, TEXT("Package="), PackagePath);
+
+	TArray<int32> Indices;
+	int32 SelectedIndex = INDEX_NONE;
+	if(FParse::Value(*Params, TEXT("Index="), SelectedIndex))
+	{
+		if(!Scene.SDFs.IsValidIndex(SelectedIndex))
+		{
+			UE_LOG(LogTemp, Error, TEXT("The scene has no SDF %d."), SelectedIndex);
+			return 1;
+		}
+		Indices.Add(SelectedIndex);
+	}
+	else
+	{
+		// the expensive static primitives
+		for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+		{
+			if(Scene.SDFs[Index].Type == EPSFSdfType::Rock || Scene.SDFs[Index].Type == EPSFSdfType::Desert)
+			{
+				Indices.Add(Index);
+			}
+		}
+	}
+
+	if(Indices.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Nothing to bake in %s."), *ScenePath);
+		return 0;
+	}
+
+	const FString SceneName = FPaths::GetBaseFilename(ScenePath);
+	TArray<TSharedPtr<FJsonValue>> BakeValues;
+	int32 Failures = 0;
+	for(const int32 Index : Indices)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Index];
+		UE_LOG(LogTemp, Display, TEXT("Baking SDF %d (%s) at resolution %d"), Index, PSFScene::SdfTypeToString(Sdf.Type), Settings.Resolution);
+
+		FPSFBakedSdf Baked;
+		FPSFSdfBakeStats Stats;
+		if(!FPSFSdfBaker::Bake(Sdf, Bounds, Settings, Baked, Stats))
+		{
+			++Failures;
+			continue;
+		}
+		FPSFSdfBaker::MeasureError(Sdf, Baked, Settings, Stats);
+		FPSFSdfBaker::LogStats(Stats);
+
+		const FString AssetPrefix = FString::Printf(TEXT("%s_%d"), *SceneName, Index);
+		if(!SaveVolumeTexture(PackagePath, AssetPrefix + TEXT("_Bricks"), Baked.BrickCount, TSF_RGBA32F, Baked.BrickIndex.GetData(), false)
+			|| !SaveVolumeTexture(PackagePath, AssetPrefix + TEXT("_Atlas"), Baked.GetAtlasSize(), TSF_R16F, Baked.Atlas.GetData(), true))
+		{
+			++Failures;
+			continue;
+		}
+
+		const FVector4f BakeOrigin = Baked.GetBakeOrigin();
+		UE_LOG(LogTemp, Display, TEXT("evalBakedSDF(p, %s_Bricks, %s_Atlas, %s_AtlasSampler, float4(%f, %f, %f, %f))"),
+			*AssetPrefix, *AssetPrefix, *AssetPrefix, BakeOrigin.X, BakeOrigin.Y, BakeOrigin.Z, BakeOrigin.W);
+		BakeValues.Add(MakeShared<FJsonValueObject>(BakeToJson(Index, Sdf, PackagePath, AssetPrefix, Baked, Stats)));
+	}
+
+	FString ReportPath;
+	if(FParse::Value(*Params, TEXT("Report="), ReportPath))
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("scene"), ScenePath);
+		Root->SetNumberField(TEXT("resolution"), Settings.Resolution);
+		Root->SetNumberField(TEXT("bandVoxels"), Settings.NarrowBandVoxels);
+		Root->SetArrayField(TEXT("bakes"), BakeValues);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+		if(!FFileHelper::SaveStringToFile(JsonString, *ReportPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write bake report: %s"), *ReportPath);
+			return 1;
+		}
+	}
+	return Failures > 0 ? 1 : 0;
+}
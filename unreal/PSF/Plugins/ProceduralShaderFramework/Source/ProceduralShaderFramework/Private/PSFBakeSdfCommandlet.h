@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFBakeSdfCommandlet.generated.h"
+
+/**
+ * Bakes static SDFs of a json scene into sparse brick map volume textures for evalBakedSDF.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFBakeSdf -Scene=<scene.json> [-Index=<n>] [-Resolution=128] [-Band=4]
+ *     [-Bounds=minX,minY,minZ,maxX,maxY,maxZ] [-Package=/Game/PSF/Baked] [-Report=<report.json>]
+ *
+ * Without -Index every rock and desert of the scene is baked. The desert is unbounded and needs -Bounds.
+ * Every bake writes <Scene>_<Index>_Bricks and <Scene>_<Index>_Atlas and logs the bakeOrigin argument, the bake time,
+ * the error against evalSDF and the CPU cost of both versions.
+ */
+UCLASS()
+class UPSFBakeSdfCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFBakeSdfCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
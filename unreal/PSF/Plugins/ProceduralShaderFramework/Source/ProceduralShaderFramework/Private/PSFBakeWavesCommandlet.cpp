@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFBakeWavesCommandlet.h"
+#include "PSFWaveBaker.h"
+#include "Engine/Texture2D.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+UPSFBakeWavesCommandlet::UPSFBakeWavesCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFBakeWavesCommandlet::Main(const FString &Params)
+{
+	FPSFWaveBakeSettings Settings;
+	FParse::Value(*Params, TEXT("Resolution="), Settings.Resolution);
+	FParse::Value(*Params, TEXT("TileSize="), Settings.TileSize);
+	FParse::Value(*Params, TEXT("CoarseOctaves="), Settings.CoarseOctaves);
+
+	FString PackagePath = TEXT("/Game/PSF/Baked");
+	FParse::Value(*Params, TEXT("Package="), PackagePath);
+	FString AssetName = TEXT("WaveField");
+	FParse::Value(*Params, TEXT("Name="), AssetName);
+
+	FPSFBakedWaves Baked;
+	FPSFWaveBakeStats Stats;
+	if(!FPSFWaveBaker::Bake(Settings, Baked, Stats))
+	{
+		return 1;
+	}
+	FPSFWaveBaker::MeasureStatistics(Baked, Settings, Stats);
+	FPSFWaveBaker::LogStats(Stats);
+
+	UPackage *Package = CreatePackage(*(PackagePath / AssetName));
+	UTexture2D *Texture = NewObject<UTexture2D>(Package, *AssetName, RF_Public | RF_Standalone);
+	Texture->Source.Init(Baked.Resolution, Baked.Resolution, 1, 1, TSF_RGBA16F, reinterpret_cast<const uint8 *>(Baked.Texels.GetData()));
+	Texture->SRGB = false;
+	Texture->CompressionNone = true;
+	Texture->CompressionSettings = TC_HDR;
+	Texture->MipGenSettings = TMGS_NoMipmaps;
+	Texture->Filter = TF_Bilinear;
+
+	// the tile repeats across the whole ocean
+	Texture->AddressX = TA_Wrap;
+	Texture->AddressY = TA_Wrap;
+	Texture->PostEditChange();
+	Package->MarkPackageDirty();
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+	if(!UPackage::SavePackage(Package, Texture, *FileName, SaveArgs))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to save the wave field: %s"), *FileName);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Wave field saved to %s, pass float4(%g, <fade start>, <fade end>, 0) as waveBake."), *(PackagePath / AssetName), Baked.TileSize);
+
+	FString ReportPath;
+	if(FParse::Value(*Params, TEXT("Report="), ReportPath))
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("texture"), PackagePath / AssetName);
+		Root->SetNumberField(TEXT("resolution"), Baked.Resolution);
+		Root->SetNumberField(TEXT("tileSize"), Baked.TileSize);
+		Root->SetNumberField(TEXT("coarseOctaves"), Baked.CoarseOctaves);
+		Root->SetNumberField(TEXT("seconds"), Stats.Seconds);
+		Root->SetNumberField(TEXT("waveEvaluationsPerSecond"), Stats.Seconds > 0.0 ? Stats.WaveEvaluations / Stats.Seconds : 0.0);
+		Root->SetNumberField(TEXT("bytes"), double(Stats.Bytes));
+		Root->SetNumberField(TEXT("analyticMean"), Stats.AnalyticMean);
+		Root->SetNumberField(TEXT("analyticStdDev"), Stats.AnalyticStdDev);
+		Root->SetNumberField(TEXT("bakedMean"), Stats.BakedMean);
+		Root->SetNumberField(TEXT("bakedStdDev"), Stats.BakedStdDev);
+		Root->SetNumberField(TEXT("analyticNsPerEval"), Stats.AnalyticNsPerEval);
+		Root->SetNumberField(TEXT("bakedNsPerEval"), Stats.BakedNsPerEval);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+		if(!FFileHelper::SaveStringToFile(JsonString, *ReportPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write bake report: %s"), *ReportPath);
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFBakeWavesCommandlet.generated.h"
+
+/**
+ * Bakes the computeWave octaves of water_functions.ush into a tileable texture for computeWaterBaked.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFBakeWaves [-Resolution=1024] [-TileSize=64] [-CoarseOctaves=3]
+ *     [-Package=/Game/PSF/Baked] [-Name=WaveField] [-Report=<report.json>]
+ */
+UCLASS()
+class UPSFBakeWavesCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFBakeWavesCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,601 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFBenchmarkCommandlet.h"
+#include "PSFSdfFunctions.h"
+#include "PSFNoise.h"
+#include "PSFLighting.h"
+#include "PSFWater.h"
+#include "PSFTween.h"
+#include "PSFAnimation.h"
+#include "Interfaces/IPluginManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	const int32 NumSamples = 4096;
+
+	/** A timed pass has to last at least this long, shorter ones are dominated by the timer */
+	const double MinPassSeconds = 0.02;
+
+	/** The noise batches are compared to their scalar ports over this many cells, where the hashes see large arguments */
+	const float CompareScale = 64.0f;
+
+	/** Random inputs shared by all kernels, generated once so that every run sees the same data */
+	struct FBenchmarkInputs
+	{
+		TArray<FVector3f> Points;
+		TArray<FVector3f> Directions;
+
+		/** x and z of Points, for the 2D noise */
+		TArray<FVector2f> Points2D;
+
+		/** Points and Scalars * 100, in the range n31 hashes */
+		TArray<FVector4f> Points4D;
+
+		/** In [0, 1], used as time, tween progress and similar scalar inputs */
+		TArray<float> Scalars;
+
+		/** escape() of every point and direction against the sunrise atmosphere */
+		TArray<float> AtmosphereDistances;
+
+		FPSFSunriseLight Sunrise;
+	};
+
+	struct FKernel
+	{
+		const TCHAR *Name;
+
+		/** The .ush the port mirrors */
+		const TCHAR *ShaderFile;
+
+		/** One evaluation per sample, returns the sum so the work can not be optimized away */
+		float (*Run)(const FBenchmarkInputs &Inputs);
+
+		/** Batch kernels: the values of the batch and of the scalar port it mirrors, on the same samples */
+		void (*Compare)(const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar) = nullptr;
+
+		/** Largest difference to the scalar port before the benchmark fails, negative if the batch does not have to match it */
+		float Tolerance = -1.0f;
+	};
+
+	struct FKernelResult
+	{
+		FString Name;
+		FString ShaderFile;
+		FString ShaderHash;
+		double NsPerEval = 0.0;
+		double NsPerEvalMin = 0.0;
+
+		/** Batch kernels: largest difference to the scalar port and the share of samples beyond PSFNoise::BatchTolerance */
+		double MaxError = -1.0;
+		double MismatchShare = 0.0;
+	};
+
+	template<typename FunctionType>
+	FORCEINLINE float SumOverSamples(const FBenchmarkInputs &Inputs, FunctionType Function)
+	{
+		float Sum = 0.0f;
+		for(int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			Sum += Function(Inputs, Index);
+		}
+		return Sum;
+	}
+
+	/** Runs a batch kernel on all samples at once, returns the sum so the work can not be optimized away */
+	template<typename FunctionType>
+	FORCEINLINE float SumOverBatch(const FBenchmarkInputs &Inputs, FunctionType Function)
+	{
+		float Values[NumSamples];
+		Function(Inputs, TArrayView<float>(Values, NumSamples));
+
+		float Sum = 0.0f;
+		for(const float Value : Values)
+		{
+			Sum += Value;
+		}
+		return Sum;
+	}
+
+	template<typename PointType, typename BatchType, typename ScalarType>
+	void CompareBatch(const TArray<PointType> &InPoints, BatchType Batch, ScalarType Scalar, TArray<float> &OutBatch, TArray<float> &OutScalar)
+	{
+		TArray<PointType> Points;
+		for(const PointType &Point : InPoints)
+		{
+			Points.Add(Point * CompareScale);
+		}
+
+		OutBatch.SetNumUninitialized(Points.Num());
+		Batch(Points, TArrayView<float>(OutBatch));
+		for(const PointType &Point : Points)
+		{
+			OutScalar.Add(Scalar(Point));
+		}
+	}
+
+	const FKernel Kernels[] = {
+		{TEXT("sdSphere"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdSphere(In.Points[I], 1.0f); });
+		}},
+		{TEXT("sdRoundBox"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdRoundBox(In.Points[I], FVector3f(0.8f, 0.5f, 0.3f), 0.1f); });
+		}},
+		{TEXT("sdTorus"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdTorus(In.Points[I], FVector2f(1.0f, 0.25f)); });
+		}},
+		{TEXT("sdHexPrism"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdHexPrism(In.Points[I], FVector2f(0.5f, 0.5f)); });
+		}},
+		{TEXT("sdOctahedron"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdOctahedron(In.Points[I], 1.0f); });
+		}},
+		{TEXT("sdEllipsoid"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::SdEllipsoid(In.Points[I], FVector3f(1.0f, 0.6f, 0.4f)); });
+		}},
+		{TEXT("dolphinDistance"), TEXT("helper_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFSdf::DolphinDistance(In.Points[I], FVector3f::ZeroVector, 0.0f, 1.0f, 10.0 * In.Scalars[I]).X; });
+		}},
+		{TEXT("snoise"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::SNoise(In.Points[I]); });
+		}},
+		{TEXT("fbm_n31"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::FbmN31(In.Points[I], 5); });
+		}},
+		{TEXT("n31"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::N31(In.Points[I]); });
+		}},
+		{TEXT("hash44"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::Hash44(In.Points4D[I]).X; });
+		}},
+		{TEXT("n2D"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::N2D(In.Points2D[I]); });
+		}},
+		{TEXT("gradN2D"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFNoise::GradN2D(In.Points2D[I]); });
+		}},
+		{TEXT("hashNoise"), TEXT("water_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFWater::HashNoise(In.Points[I]); });
+		}},
+		{TEXT("snoise_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::SNoiseBatch(In.Points, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points, [](TConstArrayView<FVector3f> P, TArrayView<float> V) { PSFNoise::SNoiseBatch(P, V); }, PSFNoise::SNoise, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("n31_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::N31Batch(In.Points, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points, [](TConstArrayView<FVector3f> P, TArrayView<float> V) { PSFNoise::N31Batch(P, V); }, PSFNoise::N31, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("fbm_n31_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::FbmN31Batch(In.Points, 5, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points, [](TConstArrayView<FVector3f> P, TArrayView<float> V) { PSFNoise::FbmN31Batch(P, 5, V); },
+				[](const FVector3f &P) { return PSFNoise::FbmN31(P, 5); }, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("hash44_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			TArray<FVector4f> Values;
+			Values.SetNumUninitialized(NumSamples);
+			PSFNoise::Hash44Batch(Inputs.Points4D, Values);
+			float Sum = 0.0f;
+			for(const FVector4f &Value : Values)
+			{
+				Sum += Value.X;
+			}
+			return Sum;
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			// every component is a value of its own
+			TArray<FVector4f> Values;
+			Values.SetNumUninitialized(Inputs.Points4D.Num());
+			PSFNoise::Hash44Batch(Inputs.Points4D, Values);
+			for(int32 Index = 0; Index < Values.Num(); ++Index)
+			{
+				const FVector4f Scalar = PSFNoise::Hash44(Inputs.Points4D[Index]);
+				OutBatch.Append({Values[Index].X, Values[Index].Y, Values[Index].Z, Values[Index].W});
+				OutScalar.Append({Scalar.X, Scalar.Y, Scalar.Z, Scalar.W});
+			}
+		}, PSFNoise::BatchTolerance},
+		{TEXT("n2D_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::N2DBatch(In.Points2D, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points2D, [](TConstArrayView<FVector2f> P, TArrayView<float> V) { PSFNoise::N2DBatch(P, V); }, PSFNoise::N2D, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("n2D_batch_fast"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::N2DBatch(In.Points2D, Values, EPSFSinHash::Fast); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points2D, [](TConstArrayView<FVector2f> P, TArrayView<float> V) { PSFNoise::N2DBatch(P, V, EPSFSinHash::Fast); }, PSFNoise::N2D, OutBatch, OutScalar);
+		}},
+		{TEXT("gradN2D_batch"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::GradN2DBatch(In.Points2D, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points2D, [](TConstArrayView<FVector2f> P, TArrayView<float> V) { PSFNoise::GradN2DBatch(P, V); }, PSFNoise::GradN2D, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("gradN2D_batch_fast"), TEXT("noise_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::GradN2DBatch(In.Points2D, Values, EPSFSinHash::Fast); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points2D, [](TConstArrayView<FVector2f> P, TArrayView<float> V) { PSFNoise::GradN2DBatch(P, V, EPSFSinHash::Fast); }, PSFNoise::GradN2D, OutBatch, OutScalar);
+		}},
+		{TEXT("hashNoise_batch"), TEXT("water_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::HashNoiseBatch(In.Points, Values); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points, [](TConstArrayView<FVector3f> P, TArrayView<float> V) { PSFNoise::HashNoiseBatch(P, V); }, PSFWater::HashNoise, OutBatch, OutScalar);
+		}, PSFNoise::BatchTolerance},
+		{TEXT("hashNoise_batch_fast"), TEXT("water_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverBatch(Inputs, [](const FBenchmarkInputs &In, TArrayView<float> Values) { PSFNoise::HashNoiseBatch(In.Points, Values, EPSFSinHash::Fast); });
+		}, [](const FBenchmarkInputs &Inputs, TArray<float> &OutBatch, TArray<float> &OutScalar)
+		{
+			CompareBatch(Inputs.Points, [](TConstArrayView<FVector3f> P, TArrayView<float> V) { PSFNoise::HashNoiseBatch(P, V, EPSFSinHash::Fast); }, PSFWater::HashNoise, OutBatch, OutScalar);
+		}},
+		{TEXT("computeWave"), TEXT("water_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFWater::ComputeWave(In.Points[I] * 10.0f, 10.0f * In.Scalars[I]); });
+		}},
+		{TEXT("scatterDepthInt"), TEXT("lighting_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			// the inner call of applySunriseLighting: towards the sun with 4 steps
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFLighting::ScatterDepthInt(In.Points[I], In.Directions[I], In.AtmosphereDistances[I], 4.0f, In.Sunrise).X; });
+		}},
+		{TEXT("applyTweenFunction"), TEXT("tween_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			// all tween types in turn, like a scene with many different tweens
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFTween::ApplyTweenFunction(In.Scalars[I], I % (PSFTween::MaxTweenType + 1)); });
+		}},
+		{TEXT("tween3D"), TEXT("tween_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			// what a material pays per pixel for a tween that UPSFTimelineComponent evaluates once per frame
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFTween::Tween3D(In.Points[I], In.Directions[I], 2.0f, I % (PSFTween::MaxTweenType + 1), 0.0f, true, 10.0f * In.Scalars[I]).X; });
+		}},
+		{TEXT("orbitObjectAroundPoint"), TEXT("animation_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I)
+			{
+				float Angle = 0.0f;
+				return PSFAnimation::OrbitObjectAroundPoint(In.Points[I], FVector3f::ZeroVector, In.Directions[I], 1.0f, 1.0f, 30.0f, 10.0f * In.Scalars[I], Angle).X + Angle;
+			});
+		}},
+		{TEXT("shakeObject"), TEXT("animation_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFAnimation::ShakeObject(In.Points[I], 0.1f, 5.0f, 10.0f * In.Scalars[I]).X; });
+		}},
+		{TEXT("cycleColor"), TEXT("animation_functions.ush"), [](const FBenchmarkInputs &Inputs)
+		{
+			return SumOverSamples(Inputs, [](const FBenchmarkInputs &In, int32 I) { return PSFAnimation::CycleColor(In.Points[I], 0.5f, 10.0f * In.Scalars[I]).X; });
+		}},
+	};
+
+	FBenchmarkInputs MakeInputs()
+	{
+		FRandomStream Random(1);
+		FBenchmarkInputs Inputs;
+		Inputs.Sunrise = FPSFSunriseLight::Make(0.0f);
+		for(int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			const FVector3f Point(Random.FRandRange(-2.0f, 2.0f), Random.FRandRange(-2.0f, 2.0f), Random.FRandRange(-2.0f, 2.0f));
+			FVector3f Direction = FVector3f(Random.GetUnitVector());
+			Direction.Y = FMath::Abs(Direction.Y);
+
+			Inputs.Points.Add(Point);
+			Inputs.Directions.Add(Direction);
+			Inputs.Scalars.Add(Random.FRand());
+			Inputs.Points2D.Add(FVector2f(Point.X, Point.Z));
+			Inputs.Points4D.Add(FVector4f(Point, Inputs.Scalars.Last()) * 100.0f);
+			Inputs.AtmosphereDistances.Add(PSFLighting::Escape(Point, Direction, Inputs.Sunrise.AtmosphereRadius, Inputs.Sunrise.EarthCenter));
+		}
+		return Inputs;
+	}
+
+	/** Median and minimum ns per evaluation over Repetitions timed passes */
+	void MeasureKernel(const FKernel &Kernel, const FBenchmarkInputs &Inputs, int32 Repetitions, FKernelResult &OutResult)
+	{
+		volatile float Sink = 0.0f;
+
+		// warm up caches and find how many runs make a pass long enough to time
+		int32 RunsPerPass = 1;
+		while(true)
+		{
+			const double Start = FPlatformTime::Seconds();
+			for(int32 Run = 0; Run < RunsPerPass; ++Run)
+			{
+				Sink = Sink + Kernel.Run(Inputs);
+			}
+			if(FPlatformTime::Seconds() - Start >= MinPassSeconds || RunsPerPass >= (1 << 20))
+			{
+				break;
+			}
+			RunsPerPass *= 2;
+		}
+
+		TArray<double> Passes;
+		for(int32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+		{
+			const double Start = FPlatformTime::Seconds();
+			for(int32 Run = 0; Run < RunsPerPass; ++Run)
+			{
+				Sink = Sink + Kernel.Run(Inputs);
+			}
+			Passes.Add((FPlatformTime::Seconds() - Start) * 1e9 / (double(RunsPerPass) * NumSamples));
+		}
+		Passes.Sort();
+
+		OutResult.NsPerEval = Passes[Passes.Num() / 2];
+		OutResult.NsPerEvalMin = Passes[0];
+	}
+
+	FString HashShaderFile(const FString &ShaderDir, const FString &ShaderFile)
+	{
+		TArray<uint8> Bytes;
+		if(!FFileHelper::LoadFileToArray(Bytes, *(ShaderDir / ShaderFile)))
+		{
+			return FString();
+		}
+		return FMD5::HashBytes(Bytes.GetData(), Bytes.Num());
+	}
+
+	FString ResultsToJson(const TArray<FKernelResult> &Results, int32 Repetitions)
+	{
+		TArray<TSharedPtr<FJsonValue>> KernelValues;
+		for(const FKernelResult &Result : Results)
+		{
+			TSharedRef<FJsonObject> KernelObject = MakeShared<FJsonObject>();
+			KernelObject->SetStringField(TEXT("name"), Result.Name);
+			KernelObject->SetStringField(TEXT("shader"), Result.ShaderFile);
+			KernelObject->SetStringField(TEXT("shaderHash"), Result.ShaderHash);
+			KernelObject->SetNumberField(TEXT("nsPerEval"), Result.NsPerEval);
+			KernelObject->SetNumberField(TEXT("nsPerEvalMin"), Result.NsPerEvalMin);
+			KernelObject->SetNumberField(TEXT("pointsPerSecond"), 1e9 / Result.NsPerEval);
+			if(Result.MaxError >= 0.0)
+			{
+				KernelObject->SetNumberField(TEXT("maxError"), Result.MaxError);
+				KernelObject->SetNumberField(TEXT("mismatchShare"), Result.MismatchShare);
+			}
+			KernelValues.Add(MakeShared<FJsonValueObject>(KernelObject));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetNumberField(TEXT("samples"), NumSamples);
+		Root->SetNumberField(TEXT("repetitions"), Repetitions);
+		Root->SetStringField(TEXT("platform"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+		Root->SetArrayField(TEXT("kernels"), KernelValues);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+		return JsonString;
+	}
+
+	bool LoadBaseline(const FString &BaselinePath, TMap<FString, FKernelResult> &OutBaseline)
+	{
+		FString JsonString;
+		if(!FFileHelper::LoadFileToString(JsonString, *BaselinePath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to read benchmark baseline: %s"), *BaselinePath);
+			return false;
+		}
+
+		TSharedPtr<FJsonObject> Root;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+		const TArray<TSharedPtr<FJsonValue>> *KernelValues = nullptr;
+		if(!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetArrayField(TEXT("kernels"), KernelValues))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Benchmark baseline is not valid json: %s"), *BaselinePath);
+			return false;
+		}
+
+		for(const TSharedPtr<FJsonValue> &KernelValue : *KernelValues)
+		{
+			const TSharedPtr<FJsonObject> *KernelObject = nullptr;
+			FKernelResult Result;
+			if(KernelValue.IsValid() && KernelValue->TryGetObject(KernelObject) && (*KernelObject)->TryGetStringField(TEXT("name"), Result.Name)
+				&& (*KernelObject)->TryGetNumberField(TEXT("nsPerEval"), Result.NsPerEval))
+			{
+				(*KernelObject)->TryGetStringField(TEXT("shader"), Result.ShaderFile);
+				(*KernelObject)->TryGetStringField(TEXT("shaderHash"), Result.ShaderHash);
+				OutBaseline.Add(Result.Name, Result);
+			}
+		}
+		return true;
+	}
+
+	/** Compares a batch kernel to its scalar port, false if it is further off than the kernel allows */
+	bool CheckBatch(const FKernel &Kernel, const FBenchmarkInputs &Inputs, FKernelResult &OutResult)
+	{
+		TArray<float> BatchValues;
+		TArray<float> ScalarValues;
+		Kernel.Compare(Inputs, BatchValues, ScalarValues);
+
+		int32 Mismatches = 0;
+		OutResult.MaxError = 0.0;
+		for(int32 Index = 0; Index < BatchValues.Num(); ++Index)
+		{
+			const double Error = FMath::Abs(BatchValues[Index] - ScalarValues[Index]);
+			OutResult.MaxError = FMath::Max(OutResult.MaxError, Error);
+			Mismatches += Error > PSFNoise::BatchTolerance ? 1 : 0;
+		}
+		OutResult.MismatchShare = double(Mismatches) / FMath::Max(BatchValues.Num(), 1);
+
+		if(Kernel.Tolerance >= 0.0f && OutResult.MaxError > Kernel.Tolerance)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s differs from its scalar port by up to %g on %.2f%% of the samples, more than %g."), Kernel.Name, OutResult.MaxError,
+				OutResult.MismatchShare * 100.0, Kernel.Tolerance);
+			return false;
+		}
+		return true;
+	}
+
+	/** Number of kernels that got slower than Threshold allows */
+	int32 CompareToBaseline(const TArray<FKernelResult> &Results, const TMap<FString, FKernelResult> &Baseline, double Threshold)
+	{
+		int32 Regressions = 0;
+		for(const FKernelResult &Result : Results)
+		{
+			const FKernelResult *Previous = Baseline.Find(Result.Name);
+			if(!Previous || Previous->NsPerEval <= 0.0)
+			{
+				UE_LOG(LogTemp, Display, TEXT("%s is not in the baseline."), *Result.Name);
+				continue;
+			}
+
+			const double Ratio = Result.NsPerEval / Previous->NsPerEval;
+			const bool bShaderChanged = !Previous->ShaderHash.IsEmpty() && Previous->ShaderHash != Result.ShaderHash;
+			if(Ratio > 1.0 + Threshold)
+			{
+				++Regressions;
+				UE_LOG(LogTemp, Error, TEXT("%s got %.0f%% slower (%.2f -> %.2f ns/eval)%s."), *Result.Name, (Ratio - 1.0) * 100.0, Previous->NsPerEval, Result.NsPerEval,
+					bShaderChanged ? *FString::Printf(TEXT(" after a change to %s"), *Result.ShaderFile) : TEXT(", its shader did not change"));
+			}
+			else if(bShaderChanged)
+			{
+				// the shader changed but the timing did not, the port may not mirror the new version yet
+				UE_LOG(LogTemp, Warning, TEXT("%s changed since the baseline, check that the CPU port of %s still mirrors it."), *Result.ShaderFile, *Result.Name);
+			}
+		}
+		return Regressions;
+	}
+}
+
+UPSFBenchmarkCommandlet::UPSFBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFBenchmarkCommandlet::Main(const FString &Params)
+{
+	int32 Repetitions = 9;
+	FParse::Value(*Params, TEXT("Repetitions="), Repetitions);
+	Repetitions = FMath::Max(Repetitions, 1);
+
+	TArray<FString> Selected;
+	FString KernelsString;
+	if(FParse::Value(*Params, TEXT("Kernels="), KernelsString, false))
+	{
+		KernelsString.ParseIntoArray(Selected, TEXT(","));
+	}
+
+	const FString ShaderDir = IPluginManager::Get().FindPlugin(TEXT("ProceduralShaderFramework"))->GetBaseDir() / TEXT("Shaders");
+	const FBenchmarkInputs Inputs = MakeInputs();
+
+	TArray<FKernelResult> Results;
+	int32 BatchMismatches = 0;
+	for(const FKernel &Kernel : Kernels)
+	{
+		if(Selected.Num() > 0 && !Selected.Contains(Kernel.Name))
+		{
+			continue;
+		}
+
+		FKernelResult &Result = Results.AddDefaulted_GetRef();
+		Result.Name = Kernel.Name;
+		Result.ShaderFile = Kernel.ShaderFile;
+		Result.ShaderHash = HashShaderFile(ShaderDir, Kernel.ShaderFile);
+		MeasureKernel(Kernel, Inputs, Repetitions, Result);
+		if(Kernel.Compare && !CheckBatch(Kernel, Inputs, Result))
+		{
+			++BatchMismatches;
+		}
+	}
+
+	// the most expensive functions first
+	TArray<FKernelResult> Sorted = Results;
+	Sorted.Sort([](const FKernelResult &A, const FKernelResult &B) { return A.NsPerEval > B.NsPerEval; });
+	UE_LOG(LogTemp, Display, TEXT("%-24s %12s %12s %12s  %s"), TEXT("function"), TEXT("ns/eval"), TEXT("min"), TEXT("Mpoints/s"), TEXT("shader"));
+	for(const FKernelResult &Result : Sorted)
+	{
+		UE_LOG(LogTemp, Display, TEXT("%-24s %12.2f %12.2f %12.2f  %s"), *Result.Name, Result.NsPerEval, Result.NsPerEvalMin, 1e3 / Result.NsPerEval, *Result.ShaderFile);
+	}
+
+	// <name>_batch against <name>
+	for(const FKernelResult &Result : Results)
+	{
+		FString ScalarName;
+		if(Result.MaxError < 0.0 || !Result.Name.Split(TEXT("_batch"), &ScalarName, nullptr))
+		{
+			continue;
+		}
+		const FKernelResult *Scalar = Results.FindByPredicate([&ScalarName](const FKernelResult &Other) { return Other.Name == ScalarName; });
+		UE_LOG(LogTemp, Display, TEXT("%-24s %s, max difference to %s %g, %.2f%% of the samples beyond %g"), *Result.Name,
+			Scalar ? *FString::Printf(TEXT("%.1fx as fast as %s"), Scalar->NsPerEval / Result.NsPerEval, *ScalarName) : TEXT("no scalar timing"),
+			*ScalarName, Result.MaxError, Result.MismatchShare * 100.0, PSFNoise::BatchTolerance);
+	}
+
+	FString OutPath;
+	if(FParse::Value(*Params, TEXT("Out="), OutPath))
+	{
+		if(!FFileHelper::SaveStringToFile(ResultsToJson(Results, Repetitions), *OutPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write benchmark results to: %s"), *OutPath);
+			return 1;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Benchmark results written to: %s"), *OutPath);
+	}
+
+	FString BaselinePath;
+	if(FParse::Value(*Params, TEXT("Baseline="), BaselinePath))
+	{
+		float Threshold = 0.15f;
+		FParse::Value(*Params, TEXT("Threshold="), Threshold);
+
+		TMap<FString, FKernelResult> Baseline;
+		if(!LoadBaseline(BaselinePath, Baseline))
+		{
+			return 1;
+		}
+
+		const int32 Regressions = CompareToBaseline(Results, Baseline, Threshold);
+		if(Regressions > 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%d functions are slower than the baseline allows (threshold %.0f%%)."), Regressions, Threshold * 100.0f);
+			return 1;
+		}
+		UE_LOG(LogTemp, Display, TEXT("No function is more than %.0f%% slower than the baseline."), Threshold * 100.0f);
+	}
+
+	if(BatchMismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%d noise batches do not match their scalar ports."), BatchMismatches);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the CPU ports of the hot shader functions in ns per evaluation and writes the result as json.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFBenchmark [-Out=<benchmark.json>] [-Kernels=sdSphere,snoise] [-Repetitions=9]
+ *     [-Baseline=<benchmark.json>] [-Threshold=0.15]
+ *
+ * Every kernel entry has the MD5 of the .ush it mirrors. With -Baseline the commandlet fails if a kernel got slower
+ * than the threshold allows and says whether its .ush changed since the baseline was taken. The noise batches
+ * (<name>_batch) are also compared to their scalar ports and fail the run if they are further off than they may be.
+ */
+UCLASS()
+class UPSFBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFBenchmarkCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFBvh.h"
+#include "PSFSdfFunctions.h"
+#include "Algo/Sort.h"
+#include "Engine/Texture2D.h"
+
+namespace
+{
+	// distance from the dolphin's start point that contains the 11 body segments (0.655 + 10 * 0.48),
+	// the tail fin and the smooth union radius
+	const float DolphinBoundingRadius = 7.5f;
+
+	// |snoise| stays below 1, the rock displaces the box by at most 0.1 * 0.3
+	const float RockDisplacement = 0.05f;
+
+	// circumradius of the hexagon relative to sdHexPrism's h.x
+	const float HexCircumradiusScale = 1.1547f;
+
+	/**
+	 * World space box around a local space box (center, half extents).
+	 * The probe point is mul(p - position, rotation), for a rotation the way back is mul(rotation, local).
+	 */
+	FBox3f TransformLocalBox(const FPSFSdf &Sdf, const FVector3f &LocalCenter, const FVector3f &LocalExtents)
+	{
+		const FVector3f Center = Sdf.Position + Sdf.Rotation.MulColumn(LocalCenter);
+		FVector3f Extents;
+		for(int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const FVector3f &Row = Sdf.Rotation.Rows[Axis];
+			Extents[Axis] = FMath::Abs(Row.X) * LocalExtents.X + FMath::Abs(Row.Y) * LocalExtents.Y + FMath::Abs(Row.Z) * LocalExtents.Z;
+		}
+		return FBox3f(Center - Extents, Center + Extents);
+	}
+}
+
+bool PSFSdfBounds::ComputeBounds(const FPSFSdf &Sdf, float Time, FBox3f &OutBounds)
+{
+	switch(Sdf.Type)
+	{
+	case EPSFSdfType::Sphere:
+		OutBounds = FBox3f(Sdf.Position - FVector3f(Sdf.Radius), Sdf.Position + FVector3f(Sdf.Radius));
+		return true;
+	case EPSFSdfType::RoundBox:
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, Sdf.Size);
+		return true;
+	case EPSFSdfType::Torus:
+	{
+		const float Outer = Sdf.Size.Y + Sdf.Size.Z;
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, FVector3f(Outer, Outer, Sdf.Size.Z));
+		return true;
+	}
+	case EPSFSdfType::HexPrism:
+	{
+		const float Circumradius = Sdf.Radius * HexCircumradiusScale;
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, FVector3f(Circumradius, Circumradius, Sdf.Radius));
+		return true;
+	}
+	case EPSFSdfType::Octahedron:
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, FVector3f(Sdf.Radius));
+		return true;
+	case EPSFSdfType::Ellipsoid:
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, Sdf.Size);
+		return true;
+	case EPSFSdfType::Dolphin:
+	{
+		// dolphinDistance is evaluated around dolphinMovement(position) in probe space
+		const FVector3f Start = PSFSdf::DolphinMovement(Sdf.TimeOffset, Sdf.Position, Sdf.Speed, Time);
+		OutBounds = TransformLocalBox(Sdf, Start, FVector3f(DolphinBoundingRadius));
+		return true;
+	}
+	case EPSFSdfType::Rock:
+		OutBounds = TransformLocalBox(Sdf, FVector3f::ZeroVector, Sdf.Size + FVector3f(RockDisplacement));
+		return true;
+	default:
+		// the desert is an infinite height field and custom SDFs are opaque HLSL
+		OutBounds = FBox3f(FVector3f(-Unbounded), FVector3f(Unbounded));
+		return false;
+	}
+}
+
+float PSFSdfBounds::GetLipschitzBound(const FPSFSdf &Sdf)
+{
+	switch(Sdf.Type)
+	{
+	case EPSFSdfType::Sphere:
+	case EPSFSdfType::RoundBox:
+	case EPSFSdfType::Torus:
+	case EPSFSdfType::HexPrism:
+	case EPSFSdfType::Octahedron:
+		return 1.0f;
+	case EPSFSdfType::Rock:
+		// the box minus 0.03 snoise(5 p), snoise changes by less than 10 per unit (8.5 measured)
+		return 1.0f + 0.03f * 5.0f * 10.0f;
+	default:
+		// the ellipsoid approximation is steeper than 1 once its radii differ, the desert far more
+		return 0.0f;
+	}
+}
+
+void FPSFBvh::Build(const FPSFScene &Scene, float Time)
+{
+	const int32 NumSDFs = Scene.SDFs.Num();
+
+	Nodes.Reset();
+	Depth = 0;
+	PrimitiveIndices.Reset(NumSDFs);
+	PrimitiveBounds.SetNum(NumSDFs);
+	PrimitiveCentroids.SetNum(NumSDFs);
+
+	for(int32 SdfIndex = 0; SdfIndex < NumSDFs; ++SdfIndex)
+	{
+		// unbounded primitives get a box that every query point is inside of, so they are always evaluated
+		PSFSdfBounds::ComputeBounds(Scene.SDFs[SdfIndex], Time, PrimitiveBounds[SdfIndex]);
+		PrimitiveCentroids[SdfIndex] = PrimitiveBounds[SdfIndex].GetCenter();
+		PrimitiveIndices.Add(SdfIndex);
+	}
+
+	if(NumSDFs > 0)
+	{
+		Nodes.Reserve(2 * NumSDFs);
+		BuildRecursive(0, NumSDFs, 0);
+	}
+
+	// traversal pushes both children of a node, a path of Depth inner nodes needs Depth + 1 stack entries
+	check(Depth < MaxTraversalDepth);
+	if(Depth + 1 > ShaderStackSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("BVH over %d SDFs is %d levels deep, more than the shader stack of %d. evalSceneBVH falls back to a linear scan."), NumSDFs, Depth, ShaderStackSize);
+	}
+}
+
+int32 FPSFBvh::BuildRecursive(int32 First, int32 Count, int32 NodeDepth)
+{
+	const int32 NodeIndex = Nodes.AddDefaulted();
+
+	FBox3f Bounds(ForceInit);
+	FBox3f CentroidBounds(ForceInit);
+	for(int32 Index = First; Index < First + Count; ++Index)
+	{
+		Bounds += PrimitiveBounds[PrimitiveIndices[Index]];
+		CentroidBounds += PrimitiveCentroids[PrimitiveIndices[Index]];
+	}
+	Nodes[NodeIndex].Bounds = Bounds;
+
+	if(Count <= MaxLeafSize)
+	{
+		Depth = FMath::Max(Depth, NodeDepth);
+		Nodes[NodeIndex].RightChildOrFirstPrimitive = First;
+		Nodes[NodeIndex].PrimitiveCount = Count;
+		return NodeIndex;
+	}
+
+	// median split along the longest axis of the centroids, scenes are rebuilt every frame so build speed wins over SAH quality
+	const FVector3f CentroidExtent = CentroidBounds.GetSize();
+	const int32 Axis = CentroidExtent.X >= CentroidExtent.Y && CentroidExtent.X >= CentroidExtent.Z ? 0 : (CentroidExtent.Y >= CentroidExtent.Z ? 1 : 2);
+
+	TArrayView<int32> Range(PrimitiveIndices.GetData() + First, Count);
+	Algo::Sort(Range, [this, Axis](int32 A, int32 B)
+	{
+		return PrimitiveCentroids[A][Axis] < PrimitiveCentroids[B][Axis];
+	});
+
+	const int32 LeftCount = Count / 2;
+	BuildRecursive(First, LeftCount, NodeDepth + 1);
+	const int32 RightChild = BuildRecursive(First + LeftCount, Count - LeftCount, NodeDepth + 1);
+
+	// Nodes may have been reallocated by the recursion
+	Nodes[NodeIndex].RightChildOrFirstPrimitive = RightChild;
+	Nodes[NodeIndex].PrimitiveCount = 0;
+	return NodeIndex;
+}
+
+float FPSFBvh::EvalScene(const FPSFScene &Scene, const FVector3f &P, float Time, int32 &OutIndex, int64 &InOutSdfEvaluations, int64 *InOutPerSdfEvaluations) const
+{
+	float D = 1e5f;
+	OutIndex = INDEX_NONE;
+	if(Nodes.Num() == 0)
+	{
+		return D;
+	}
+
+	int32 Stack[MaxTraversalDepth];
+	int32 StackSize = 0;
+	Stack[StackSize++] = 0;
+
+	while(StackSize > 0)
+	{
+		const FPSFBvhNode &Node = Nodes[Stack[--StackSize]];
+
+		// a primitive can only lower the distance if its bounds are closer than the current best
+		if(PSFSdfBounds::DistanceToBox(Node.Bounds, P) >= D)
+		{
+			continue;
+		}
+
+		if(Node.PrimitiveCount > 0)
+		{
+			for(int32 Index = 0; Index < Node.PrimitiveCount; ++Index)
+			{
+				const int32 SdfIndex = PrimitiveIndices[Node.RightChildOrFirstPrimitive + Index];
+				const float DJ = PSFSdf::EvalSDF(Scene.SDFs[SdfIndex], P, Time);
+				++InOutSdfEvaluations;
+				if(InOutPerSdfEvaluations)
+				{
+					++InOutPerSdfEvaluations[SdfIndex];
+				}
+				if(DJ < D)
+				{
+					D = DJ;
+					OutIndex = SdfIndex;
+				}
+			}
+			continue;
+		}
+
+		// visit the closer child first, it tightens D before the other one is tested
+		const int32 Left = int32(&Node - Nodes.GetData()) + 1;
+		const int32 Right = Node.RightChildOrFirstPrimitive;
+		const bool bLeftFirst = PSFSdfBounds::DistanceToBox(Nodes[Left].Bounds, P) <= PSFSdfBounds::DistanceToBox(Nodes[Right].Bounds, P);
+		Stack[StackSize++] = bLeftFirst ? Right : Left;
+		Stack[StackSize++] = bLeftFirst ? Left : Right;
+	}
+	return D;
+}
+
+void FPSFBvh::Pack(TArray<FVector4f> &OutTexels) const
+{
+	OutTexels.Reset(1 + 2 * Nodes.Num() + FMath::DivideAndRoundUp(PrimitiveIndices.Num(), 4));
+
+	// indices are stored as plain floats, exact up to 2^24 and safe from denormal flushing unlike asfloat
+	OutTexels.Add(FVector4f(float(Nodes.Num()), float(PrimitiveIndices.Num()), 0.0f, 0.0f));
+	for(const FPSFBvhNode &Node : Nodes)
+	{
+		OutTexels.Add(FVector4f(Node.Bounds.Min, float(Node.RightChildOrFirstPrimitive)));
+		OutTexels.Add(FVector4f(Node.Bounds.Max, float(Node.PrimitiveCount)));
+	}
+	for(int32 Index = 0; Index < PrimitiveIndices.Num(); Index += 4)
+	{
+		FVector4f Texel(-1.0f, -1.0f, -1.0f, -1.0f);
+		for(int32 Component = 0; Component < 4 && Index + Component < PrimitiveIndices.Num(); ++Component)
+		{
+			Texel[Component] = float(PrimitiveIndices[Index + Component]);
+		}
+		OutTexels.Add(Texel);
+	}
+}
+
+UTexture2D *FPSFBvh::UpdateTexture(UTexture2D *Texture) const
+{
+	TArray<FVector4f> *Texels = new TArray<FVector4f>();
+	Pack(*Texels);
+	const int32 NumTexels = Texels->Num();
+
+	if(!Texture || Texture->GetSizeX() < NumTexels)
+	{
+		Texture = UTexture2D::CreateTransient(FMath::RoundUpToPowerOfTwo(NumTexels), 1, PF_A32B32G32R32F);
+		Texture->Filter = TF_Nearest;
+		Texture->SRGB = false;
+		Texture->CompressionSettings = TC_HDR;
+		Texture->NeverStream = true;
+		Texture->UpdateResource();
+	}
+
+	// the render thread reads the data later, it owns the copy and the region until the upload is done
+	FUpdateTextureRegion2D *Region = new FUpdateTextureRegion2D(0, 0, 0, 0, NumTexels, 1);
+	Texture->UpdateTextureRegions(0, 1, Region, NumTexels * sizeof(FVector4f), sizeof(FVector4f), reinterpret_cast<uint8 *>(Texels->GetData()),
+		[Texels](uint8 *, const FUpdateTextureRegion2D *Regions)
+		{
+			delete Texels;
+			delete Regions;
+		});
+	return Texture;
+}
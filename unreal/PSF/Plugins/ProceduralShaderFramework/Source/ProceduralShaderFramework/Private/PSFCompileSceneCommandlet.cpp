@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFCompileSceneCommandlet.h"
+#include "PSFScene.h"
+#include "PSFSceneCompiler.h"
+#include "PSFCustomSDFRegistry.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UPSFCompileSceneCommandlet::UPSFCompileSceneCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFCompileSceneCommandlet::Main(const FString &Params)
+{
+	FString ScenePath;
+	if(!FParse::Value(*Params, TEXT("Scene="), ScenePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFCompileScene -Scene=<scene.json> [-Out=<CompiledScene.ush>] [-ShaderDir=<Shaders>]"));
+		return 1;
+	}
+
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
+	{
+		return 1;
+	}
+
+	FString ShaderDir = FPaths::ProjectDir() / TEXT("Shaders");
+	FParse::Value(*Params, TEXT("ShaderDir="), ShaderDir);
+	FString OutPath = ShaderDir / FPSFSceneCompiler::OutputFileName;
+	FParse::Value(*Params, TEXT("Out="), OutPath);
+
+	// the custom SDFs of the scene call the functions MyCustomSDFs.ush defines for them
+	FPSFCustomSDFRegistry Registry;
+	if(!Registry.LoadFromJsonFile(ShaderDir / FPSFCustomSDFRegistry::FileName))
+	{
+		return 1;
+	}
+
+	FPSFSceneCompilerStats Stats;
+	FString Code;
+	if(!FPSFSceneCompiler::Compile(Scene, Registry.GetEntries(), FPaths::GetCleanFilename(ScenePath), Code, Stats))
+	{
+		return 1;
+	}
+	if(!FFileHelper::SaveStringToFile(Code, *OutPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write compiled scene to: %s"), *OutPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Compiled scene written to: %s"), *OutPath);
+	FPSFSceneCompiler::LogStats(Stats);
+	return 0;
+}
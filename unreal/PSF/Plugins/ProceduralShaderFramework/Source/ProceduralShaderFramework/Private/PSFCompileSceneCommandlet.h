@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFCompileSceneCommandlet.generated.h"
+
+/**
+ * Compiles a json scene description into CompiledScene.ush and logs the static cost of the generic path next to the compiled one.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFCompileScene -Scene=<scene.json> [-Out=<Shaders/CompiledScene.ush>]
+ */
+UCLASS()
+class UPSFCompileSceneCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFCompileSceneCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
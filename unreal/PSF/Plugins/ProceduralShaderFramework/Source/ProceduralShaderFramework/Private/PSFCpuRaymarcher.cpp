@@ -0,0 +1,825 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFCpuRaymarcher.h"
+#include "PSFBvh.h"
+#include "PSFLightGrid.h"
+#include "PSFMarchProfile.h"
+#include "PSFSdfFunctions.h"
+#include "PSFLighting.h"
+#include "PSFShaderMath.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/VectorRegister.h"
+#include <atomic>
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	const int32 MaxMarchSteps = 100;
+	const float HitEpsilon = 0.001f;
+	const float MissDistance = 1e5f;
+
+	// below this the traversal costs more than evaluating every primitive
+	const int32 MinSDFsForBvh = 8;
+
+	/** Four rays in structure-of-arrays layout */
+	struct FRayPacket
+	{
+		VectorRegister4Float X;
+		VectorRegister4Float Y;
+		VectorRegister4Float Z;
+	};
+
+	FORCEINLINE VectorRegister4Float Length3(const VectorRegister4Float &X, const VectorRegister4Float &Y, const VectorRegister4Float &Z)
+	{
+		return VectorSqrt(VectorMultiplyAdd(X, X, VectorMultiplyAdd(Y, Y, VectorMultiply(Z, Z))));
+	}
+
+	/**
+	 * Evaluates one primitive for four probe points at once.
+	 * Returns false for the primitives without a SIMD path, the caller then evaluates lane by lane.
+	 */
+	bool EvalSdfPacket(const FPSFSdf &Sdf, const FRayPacket &P, VectorRegister4Float &OutDistance)
+	{
+		// probePoint = mul(p - position, rotation)
+		const VectorRegister4Float DX = VectorSubtract(P.X, VectorSetFloat1(Sdf.Position.X));
+		const VectorRegister4Float DY = VectorSubtract(P.Y, VectorSetFloat1(Sdf.Position.Y));
+		const VectorRegister4Float DZ = VectorSubtract(P.Z, VectorSetFloat1(Sdf.Position.Z));
+
+		const FVector3f *Rows = Sdf.Rotation.Rows;
+		const VectorRegister4Float LX = VectorMultiplyAdd(DX, VectorSetFloat1(Rows[0].X), VectorMultiplyAdd(DY, VectorSetFloat1(Rows[1].X), VectorMultiply(DZ, VectorSetFloat1(Rows[2].X))));
+		const VectorRegister4Float LY = VectorMultiplyAdd(DX, VectorSetFloat1(Rows[0].Y), VectorMultiplyAdd(DY, VectorSetFloat1(Rows[1].Y), VectorMultiply(DZ, VectorSetFloat1(Rows[2].Y))));
+		const VectorRegister4Float LZ = VectorMultiplyAdd(DX, VectorSetFloat1(Rows[0].Z), VectorMultiplyAdd(DY, VectorSetFloat1(Rows[1].Z), VectorMultiply(DZ, VectorSetFloat1(Rows[2].Z))));
+
+		const VectorRegister4Float Zero = VectorZeroFloat();
+
+		switch(Sdf.Type)
+		{
+		case EPSFSdfType::Sphere:
+		{
+			OutDistance = VectorSubtract(Length3(LX, LY, LZ), VectorSetFloat1(Sdf.Radius));
+			return true;
+		}
+		case EPSFSdfType::RoundBox:
+		{
+			const VectorRegister4Float R = VectorSetFloat1(Sdf.Radius);
+			const VectorRegister4Float QX = VectorAdd(VectorSubtract(VectorAbs(LX), VectorSetFloat1(Sdf.Size.X)), R);
+			const VectorRegister4Float QY = VectorAdd(VectorSubtract(VectorAbs(LY), VectorSetFloat1(Sdf.Size.Y)), R);
+			const VectorRegister4Float QZ = VectorAdd(VectorSubtract(VectorAbs(LZ), VectorSetFloat1(Sdf.Size.Z)), R);
+			const VectorRegister4Float Outside = Length3(VectorMax(QX, Zero), VectorMax(QY, Zero), VectorMax(QZ, Zero));
+			const VectorRegister4Float Inside = VectorMin(VectorMax(QX, VectorMax(QY, QZ)), Zero);
+			OutDistance = VectorSubtract(VectorAdd(Outside, Inside), R);
+			return true;
+		}
+		case EPSFSdfType::Torus:
+		{
+			const VectorRegister4Float QX = VectorSubtract(VectorSqrt(VectorMultiplyAdd(LX, LX, VectorMultiply(LY, LY))), VectorSetFloat1(Sdf.Size.Y));
+			OutDistance = VectorSubtract(VectorSqrt(VectorMultiplyAdd(QX, QX, VectorMultiply(LZ, LZ))), VectorSetFloat1(Sdf.Size.Z));
+			return true;
+		}
+		case EPSFSdfType::Octahedron:
+		{
+			const VectorRegister4Float Sum = VectorAdd(VectorAbs(LX), VectorAdd(VectorAbs(LY), VectorAbs(LZ)));
+			OutDistance = VectorMultiply(VectorSubtract(Sum, VectorSetFloat1(Sdf.Radius)), VectorSetFloat1(0.57735027f));
+			return true;
+		}
+		case EPSFSdfType::Ellipsoid:
+		{
+			const VectorRegister4Float RX = VectorSetFloat1(Sdf.Size.X);
+			const VectorRegister4Float RY = VectorSetFloat1(Sdf.Size.Y);
+			const VectorRegister4Float RZ = VectorSetFloat1(Sdf.Size.Z);
+			const VectorRegister4Float K0 = Length3(VectorDivide(LX, RX), VectorDivide(LY, RY), VectorDivide(LZ, RZ));
+			const VectorRegister4Float K1 = Length3(VectorDivide(LX, VectorMultiply(RX, RX)), VectorDivide(LY, VectorMultiply(RY, RY)), VectorDivide(LZ, VectorMultiply(RZ, RZ)));
+			OutDistance = VectorDivide(VectorMultiply(K0, VectorSubtract(K0, VectorSetFloat1(1.0f))), K1);
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	/** Distances of the four probe points to one primitive, inactive lanes evaluate to MissDistance on the scalar path */
+	void EvalPrimitivePacket(const FPSFSdf &Sdf, const FRayPacket &Position, float Time, const bool (&bActive)[4], float (&OutDistance)[4])
+	{
+		VectorRegister4Float DistanceV;
+		if(EvalSdfPacket(Sdf, Position, DistanceV))
+		{
+			VectorStoreAligned(DistanceV, OutDistance);
+			return;
+		}
+
+		alignas(16) float PX[4], PY[4], PZ[4];
+		VectorStoreAligned(Position.X, PX);
+		VectorStoreAligned(Position.Y, PY);
+		VectorStoreAligned(Position.Z, PZ);
+		for(int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			OutDistance[Lane] = bActive[Lane] ? PSFSdf::EvalSDF(Sdf, FVector3f(PX[Lane], PY[Lane], PZ[Lane]), Time) : MissDistance;
+		}
+	}
+
+	FORCEINLINE void KeepClosest(const float (&Distance)[4], int32 SdfIndex, float (&Best)[4], int32 (&BestIndex)[4])
+	{
+		for(int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			if(Distance[Lane] < Best[Lane])
+			{
+				Best[Lane] = Distance[Lane];
+				BestIndex[Lane] = SdfIndex;
+			}
+		}
+	}
+
+	/** Distance of the four probe points to a box, 0 inside */
+	FORCEINLINE VectorRegister4Float DistanceToBoxPacket(const FBox3f &Box, const FRayPacket &P)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float DX = VectorMax(VectorMax(VectorSubtract(VectorSetFloat1(Box.Min.X), P.X), VectorSubtract(P.X, VectorSetFloat1(Box.Max.X))), Zero);
+		const VectorRegister4Float DY = VectorMax(VectorMax(VectorSubtract(VectorSetFloat1(Box.Min.Y), P.Y), VectorSubtract(P.Y, VectorSetFloat1(Box.Max.Y))), Zero);
+		const VectorRegister4Float DZ = VectorMax(VectorMax(VectorSubtract(VectorSetFloat1(Box.Min.Z), P.Z), VectorSubtract(P.Z, VectorSetFloat1(Box.Max.Z))), Zero);
+		return Length3(DX, DY, DZ);
+	}
+
+	/**
+	 * Packet version of FPSFBvh::EvalScene: a node is visited while its bounds are closer than the best distance of at least one lane.
+	 * Inactive lanes start at a negative best distance so they never keep a node alive.
+	 */
+	void EvalSceneBvhPacket(const FPSFScene &Scene, const FPSFBvh &Bvh, const FRayPacket &Position, float Time, const bool (&bActive)[4], int32 NumActive,
+		float (&Best)[4], int32 (&BestIndex)[4], int64 &InOutSdfEvaluations)
+	{
+		const TArray<FPSFBvhNode> &Nodes = Bvh.GetNodes();
+		const TArray<int32> &PrimitiveIndices = Bvh.GetPrimitiveIndices();
+		if(Nodes.Num() == 0)
+		{
+			return;
+		}
+
+		for(int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			Best[Lane] = bActive[Lane] ? MissDistance : -1.0f;
+		}
+
+		int32 Stack[FPSFBvh::MaxTraversalDepth];
+		int32 StackSize = 0;
+		Stack[StackSize++] = 0;
+
+		while(StackSize > 0)
+		{
+			const int32 NodeIndex = Stack[--StackSize];
+			const FPSFBvhNode &Node = Nodes[NodeIndex];
+
+			if(VectorMaskBits(VectorCompareLT(DistanceToBoxPacket(Node.Bounds, Position), VectorLoadAligned(Best))) == 0)
+			{
+				continue;
+			}
+
+			if(Node.PrimitiveCount > 0)
+			{
+				for(int32 Index = 0; Index < Node.PrimitiveCount; ++Index)
+				{
+					const int32 SdfIndex = PrimitiveIndices[Node.RightChildOrFirstPrimitive + Index];
+					alignas(16) float Distance[4];
+					EvalPrimitivePacket(Scene.SDFs[SdfIndex], Position, Time, bActive, Distance);
+					KeepClosest(Distance, SdfIndex, Best, BestIndex);
+				}
+				InOutSdfEvaluations += int64(NumActive) * Node.PrimitiveCount;
+				continue;
+			}
+
+			// visit the child that is closer on average first
+			const int32 Left = NodeIndex + 1;
+			const int32 Right = Node.RightChildOrFirstPrimitive;
+			alignas(16) float LeftDistance[4], RightDistance[4];
+			VectorStoreAligned(DistanceToBoxPacket(Nodes[Left].Bounds, Position), LeftDistance);
+			VectorStoreAligned(DistanceToBoxPacket(Nodes[Right].Bounds, Position), RightDistance);
+			const bool bLeftFirst = LeftDistance[0] + LeftDistance[1] + LeftDistance[2] + LeftDistance[3] <= RightDistance[0] + RightDistance[1] + RightDistance[2] + RightDistance[3];
+			Stack[StackSize++] = bLeftFirst ? Right : Left;
+			Stack[StackSize++] = bLeftFirst ? Left : Right;
+		}
+	}
+
+	/** Marches a 2x2 quad of rays from their start states until every lane hit, escaped or ran out of steps */
+	void RaymarchPacket(const FPSFScene &Scene, const FPSFBvh *Bvh, const FVector3f (&Directions)[4], float Time, const FPSFMarchState (&Starts)[4], FPSFRayHit (&OutHits)[4],
+		int64 &InOutSdfEvaluations)
+	{
+		const FVector3f &Origin = Scene.RayOrigin;
+		const int32 NumSDFs = Scene.SDFs.Num();
+
+		alignas(16) float DirX[4], DirY[4], DirZ[4];
+		alignas(16) float T[4];
+		FPSFMarchState Marches[4];
+		bool bActive[4] = {true, true, true, true};
+		int32 NumActive = 4;
+
+		for(int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			DirX[Lane] = Directions[Lane].X;
+			DirY[Lane] = Directions[Lane].Y;
+			DirZ[Lane] = Directions[Lane].Z;
+			Marches[Lane] = Starts[Lane];
+			OutHits[Lane] = FPSFRayHit();
+		}
+
+		const FRayPacket Direction = {VectorLoadAligned(DirX), VectorLoadAligned(DirY), VectorLoadAligned(DirZ)};
+
+		for(int32 Step = 0; Step < MaxMarchSteps && NumActive > 0; ++Step)
+		{
+			for(int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				T[Lane] = Marches[Lane].T;
+			}
+			const VectorRegister4Float TV = VectorLoadAligned(T);
+			FRayPacket Position;
+			Position.X = VectorMultiplyAdd(Direction.X, TV, VectorSetFloat1(Origin.X));
+			Position.Y = VectorMultiplyAdd(Direction.Y, TV, VectorSetFloat1(Origin.Y));
+			Position.Z = VectorMultiplyAdd(Direction.Z, TV, VectorSetFloat1(Origin.Z));
+
+			alignas(16) float Best[4] = {MissDistance, MissDistance, MissDistance, MissDistance};
+			int32 BestIndex[4] = {INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE};
+
+			if(Bvh)
+			{
+				EvalSceneBvhPacket(Scene, *Bvh, Position, Time, bActive, NumActive, Best, BestIndex, InOutSdfEvaluations);
+			}
+			else
+			{
+				for(int32 SdfIndex = 0; SdfIndex < NumSDFs; ++SdfIndex)
+				{
+					alignas(16) float Distance[4];
+					EvalPrimitivePacket(Scene.SDFs[SdfIndex], Position, Time, bActive, Distance);
+					KeepClosest(Distance, SdfIndex, Best, BestIndex);
+				}
+				InOutSdfEvaluations += int64(NumActive) * NumSDFs;
+			}
+
+			for(int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				if(!bActive[Lane])
+				{
+					continue;
+				}
+
+				FPSFRayHit &Hit = OutHits[Lane];
+				Hit.Steps = Step + 1;
+				const FVector3f CurrentPosition = Origin + Directions[Lane] * T[Lane];
+
+				if(!Marches[Lane].Advance(Best[Lane]))
+				{
+					continue;
+				}
+				if(Best[Lane] < HitEpsilon)
+				{
+					Hit.HitPosition = FVector4f(CurrentPosition, T[Lane]);
+					Hit.HitIndex = BestIndex[Lane];
+					bActive[Lane] = false;
+					--NumActive;
+				}
+				else if(T[Lane] > Scene.RaymarchStoppingCriterium)
+				{
+					Hit.HitPosition = FVector4f(CurrentPosition, Scene.RaymarchStoppingCriterium + 1.0f);
+					bActive[Lane] = false;
+					--NumActive;
+				}
+			}
+		}
+	}
+
+	/** Minimum over all primitives at P, through the BVH if there is one. InOutPerSdfEvaluations has one counter per primitive */
+	FORCEINLINE float EvalScene(const FPSFScene &Scene, const FPSFBvh *Bvh, const FVector3f &P, float Time, int32 &OutBestIndex, int64 &InOutSdfEvaluations,
+		int64 *InOutPerSdfEvaluations = nullptr)
+	{
+		if(Bvh)
+		{
+			return Bvh->EvalScene(Scene, P, Time, OutBestIndex, InOutSdfEvaluations, InOutPerSdfEvaluations);
+		}
+
+		float D = MissDistance;
+		OutBestIndex = INDEX_NONE;
+		for(int32 SdfIndex = 0; SdfIndex < Scene.SDFs.Num(); ++SdfIndex)
+		{
+			const float DJ = PSFSdf::EvalSDF(Scene.SDFs[SdfIndex], P, Time);
+			if(DJ < D)
+			{
+				D = DJ;
+				OutBestIndex = SdfIndex;
+			}
+		}
+		InOutSdfEvaluations += Scene.SDFs.Num();
+		if(InOutPerSdfEvaluations)
+		{
+			for(int32 SdfIndex = 0; SdfIndex < Scene.SDFs.Num(); ++SdfIndex)
+			{
+				++InOutPerSdfEvaluations[SdfIndex];
+			}
+		}
+		return D;
+	}
+
+	int64 SumDolphinEvaluations(const FPSFScene &Scene, const int64 *PerSdfEvaluations)
+	{
+		int64 Sum = 0;
+		for(int32 SdfIndex = 0; SdfIndex < Scene.SDFs.Num(); ++SdfIndex)
+		{
+			Sum += Scene.SDFs[SdfIndex].Type == EPSFSdfType::Dolphin ? PerSdfEvaluations[SdfIndex] : 0;
+		}
+		return Sum;
+	}
+
+	/** Mirrors coneRadiusForTile for a prepass of Width x Height texels */
+	float ConeRadiusForTile(int32 Width, int32 Height)
+	{
+		return 0.5f * FVector2f(2.0f / Width, 2.0f / Height).Size();
+	}
+
+	/** Mirrors loadConeStart */
+	float LoadConeStart(const TArray<float> &ConeStarts, int32 Width, int32 Height, const FVector2f &ScreenUV)
+	{
+		const int32 TexelX = FMath::FloorToInt(ScreenUV.X * Width - 0.5f);
+		const int32 TexelY = FMath::FloorToInt(ScreenUV.Y * Height - 0.5f);
+		float T = MissDistance;
+		for(int32 Y = 0; Y <= 1; ++Y)
+		{
+			for(int32 X = 0; X <= 1; ++X)
+			{
+				T = FMath::Min(T, ConeStarts[FMath::Clamp(TexelY + Y, 0, Height - 1) * Width + FMath::Clamp(TexelX + X, 0, Width - 1)]);
+			}
+		}
+		return T;
+	}
+}
+
+FVector2f FPSFCpuRaymarcher::PixelToUV(int32 X, int32 Y, int32 Width, int32 Height)
+{
+	// computeUV: fragCoord is the normalized screen position with y pointing down
+	const FVector2f FragCoord((X + 0.5f) / Width, (Y + 0.5f) / Height);
+	const FVector2f FlippedUV(FragCoord.X, -FragCoord.Y + 1.0f);
+	return FlippedUV * 2.0f - FVector2f(1.0f, 1.0f);
+}
+
+FVector2f FPSFCpuRaymarcher::UVToScreenUV(const FVector2f &UV)
+{
+	return FVector2f(UV.X + 1.0f, 1.0f - UV.Y) * 0.5f;
+}
+
+bool FPSFCpuRaymarcher::ProjectToScreen(const FVector3f &P, const FVector3f &Eye, const FPSFMatrix3 &CameraMatrix, FVector2f &OutScreenUV)
+{
+	const FVector3f ViewPosition = CameraMatrix.MulColumn(P - Eye);
+	OutScreenUV = FVector2f::ZeroVector;
+	if(ViewPosition.Z >= 0.0f)
+	{
+		return false;
+	}
+
+	OutScreenUV = UVToScreenUV(FVector2f(ViewPosition.X, ViewPosition.Y) / -ViewPosition.Z);
+	return OutScreenUV.X >= 0.0f && OutScreenUV.X <= 1.0f && OutScreenUV.Y >= 0.0f && OutScreenUV.Y <= 1.0f;
+}
+
+float FPSFCpuRaymarcher::TemporalDepth(const FVector4f &HitPosition, float StoppingCriterium)
+{
+	return HitPosition.W > 0.0f && HitPosition.W <= StoppingCriterium ? HitPosition.W : -1.0f;
+}
+
+float FPSFCpuRaymarcher::ReprojectStart(const FPSFTemporalHistory &History, const FVector3f &RayOrigin, const FVector3f &RayDirection, const FVector2f &ScreenUV,
+	const FPSFRenderSettings &Settings)
+{
+	const int32 Width = History.Width;
+	const int32 Height = History.Height;
+	auto LoadDepth = [&](int32 X, int32 Y)
+	{
+		return History.Depth[FMath::Clamp(Y, 0, Height - 1) * Width + FMath::Clamp(X, 0, Width - 1)];
+	};
+
+	const int32 PixelX = FMath::Clamp(FMath::FloorToInt(ScreenUV.X * Width), 0, Width - 1);
+	const int32 PixelY = FMath::Clamp(FMath::FloorToInt(ScreenUV.Y * Height), 0, Height - 1);
+	if(Settings.TemporalRefresh > 0 && (PixelX + 5 * PixelY + Settings.Frame) % Settings.TemporalRefresh == 0)
+	{
+		return 0.0f;
+	}
+
+	float T = LoadDepth(PixelX, PixelY);
+	FVector3f Q = RayOrigin;
+	for(int32 Iteration = 0; Iteration < 2; ++Iteration)
+	{
+		FVector2f HistoryUV;
+		if(T <= 0.0f || !ProjectToScreen(RayOrigin + RayDirection * T, History.Eye, History.CameraMatrix, HistoryUV))
+		{
+			return 0.0f;
+		}
+
+		const int32 TexelX = FMath::FloorToInt(HistoryUV.X * Width - 0.5f);
+		const int32 TexelY = FMath::FloorToInt(HistoryUV.Y * Height - 0.5f);
+		float TMin = MissDistance;
+		float TMax = -MissDistance;
+		for(int32 Y = 0; Y <= 1; ++Y)
+		{
+			for(int32 X = 0; X <= 1; ++X)
+			{
+				const float H = LoadDepth(TexelX + X, TexelY + Y);
+				TMin = FMath::Min(TMin, H);
+				TMax = FMath::Max(TMax, H);
+			}
+		}
+		if(TMin <= 0.0f || TMax - TMin > Settings.TemporalTolerance * TMin)
+		{
+			return 0.0f;
+		}
+
+		Q = History.Eye + Normalize(RayOrigin + RayDirection * T - History.Eye) * TMin;
+		T = (Q - RayOrigin) | RayDirection;
+	}
+
+	if(T <= 0.0f || (Q - (RayOrigin + RayDirection * T)).Size() > Settings.TemporalTolerance * T)
+	{
+		return 0.0f;
+	}
+	return T * (1.0f - Settings.TemporalBackoff);
+}
+
+float FPSFCpuRaymarcher::LimitTemporalStart(const FPSFScene &Scene, const FVector3f &RayOrigin, const FVector3f &RayDirection, float Time, float TStart)
+{
+	for(const FPSFSdf &Sdf : Scene.SDFs)
+	{
+		// the CPU scene only animates with the time, the SDFs addSDF marks in sdfAnimated
+		if(!(Sdf.Type == EPSFSdfType::Dolphin && Sdf.Speed != 0.0f) && Sdf.Type != EPSFSdfType::Custom)
+		{
+			continue;
+		}
+
+		FBox3f Bounds;
+		if(!PSFSdfBounds::ComputeBounds(Sdf, Time, Bounds))
+		{
+			return 0.0f;
+		}
+		const FVector3f ToRay = RayOrigin - Bounds.GetCenter();
+		const float Radius = Bounds.GetExtent().Size();
+		const float B = ToRay | RayDirection;
+		const float H = B * B - (ToRay | ToRay) + Radius * Radius;
+		if(H >= 0.0f && -B + FMath::Sqrt(H) > 0.0f)
+		{
+			TStart = FMath::Min(TStart, FMath::Max(-B - FMath::Sqrt(H), 0.0f));
+		}
+	}
+	return TStart;
+}
+
+FVector3f FPSFCpuRaymarcher::ComputeRayDirection(const FPSFMatrix3 &CameraMatrix, const FVector2f &UV)
+{
+	return Normalize(CameraMatrix.MulRow(FVector3f(UV.X, UV.Y, -1.0f)));
+}
+
+FPSFRayHit FPSFCpuRaymarcher::Raymarch(const FPSFScene &Scene, const FVector3f &RayDirection, float Time, int64 &InOutSdfEvaluations, const FPSFBvh *Bvh,
+	const FPSFMarchState &Start, FPSFMarchCounters *OutCounters, int64 *InOutPerSdfEvaluations)
+{
+	FPSFRayHit Hit;
+	FPSFMarchState March = Start;
+	const int64 StartEvaluations = InOutSdfEvaluations;
+	const int64 StartDolphinEvaluations = OutCounters && InOutPerSdfEvaluations ? SumDolphinEvaluations(Scene, InOutPerSdfEvaluations) : 0;
+	EPSFMarchExit Exit = EPSFMarchExit::StepCap;
+
+	// countMarchStep: the nearest SDF of the longest run of consecutive steps
+	int32 NearestSdf = INDEX_NONE;
+	int32 NearestRun = 0;
+	int32 CostliestSdf = INDEX_NONE;
+	int32 CostliestRun = 0;
+
+	for(int32 Step = 0; Step < MaxMarchSteps; ++Step)
+	{
+		const float T = March.T;
+		const FVector3f CurrentPosition = Scene.RayOrigin + RayDirection * T;
+		int32 BestIndex = INDEX_NONE;
+		const float D = EvalScene(Scene, Bvh, CurrentPosition, Time, BestIndex, InOutSdfEvaluations, InOutPerSdfEvaluations);
+		Hit.Steps = Step + 1;
+
+		NearestRun = BestIndex == NearestSdf ? NearestRun + 1 : 1;
+		NearestSdf = BestIndex;
+		if(NearestRun > CostliestRun)
+		{
+			CostliestRun = NearestRun;
+			CostliestSdf = BestIndex;
+		}
+
+		if(!March.Advance(D))
+		{
+			continue;
+		}
+		if(D < HitEpsilon)
+		{
+			Hit.HitPosition = FVector4f(CurrentPosition, T);
+			Hit.HitIndex = BestIndex;
+			Exit = EPSFMarchExit::Hit;
+			break;
+		}
+		if(T > Scene.RaymarchStoppingCriterium)
+		{
+			Hit.HitPosition = FVector4f(CurrentPosition, Scene.RaymarchStoppingCriterium + 1.0f);
+			Exit = EPSFMarchExit::Escaped;
+			break;
+		}
+	}
+
+	if(OutCounters)
+	{
+		OutCounters->Steps = Hit.Steps;
+		OutCounters->SdfEvaluations = int32(InOutSdfEvaluations - StartEvaluations);
+		OutCounters->DolphinEvaluations = InOutPerSdfEvaluations ? int32(SumDolphinEvaluations(Scene, InOutPerSdfEvaluations) - StartDolphinEvaluations) : 0;
+		OutCounters->Exit = Exit;
+		OutCounters->CostliestSdf = CostliestSdf;
+	}
+	return Hit;
+}
+
+float FPSFCpuRaymarcher::ConeMarch(const FPSFScene &Scene, const FVector3f &RayDirection, float ConeRadius, float Time, int64 &InOutSdfEvaluations, int32 &OutSteps, const FPSFBvh *Bvh)
+{
+	float T = 0.0f;
+	OutSteps = 0;
+	for(int32 Step = 0; Step < MaxMarchSteps; ++Step)
+	{
+		++OutSteps;
+		int32 BestIndex = INDEX_NONE;
+		const float D = EvalScene(Scene, Bvh, Scene.RayOrigin + RayDirection * T, Time, BestIndex, InOutSdfEvaluations);
+		const float Free = D - T * ConeRadius;
+		if(Free < HitEpsilon || T > Scene.RaymarchStoppingCriterium)
+		{
+			break;
+		}
+		// the cone section at T + step stays inside the sphere of radius D
+		T += Free / (1.0f + ConeRadius);
+	}
+	return T;
+}
+
+FLinearColor FPSFCpuRaymarcher::ShadeHit(const FPSFScene &Scene, const FPSFRayHit &Hit, const FVector3f &RayDirection, const FVector2f &UV, float Time,
+	const FPSFLightGrid *LightGrid)
+{
+	FVector3f Normal = FVector3f::ZeroVector;
+	FPSFMaterialParams Material;
+
+	if(Hit.HitIndex != INDEX_NONE)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Hit.HitIndex];
+		const FVector3f HitPoint(Hit.HitPosition.X, Hit.HitPosition.Y, Hit.HitPosition.Z);
+		Normal = PSFSdf::GetNormal(Sdf, HitPoint);
+		Material = Sdf.Material;
+		if(Sdf.Type == EPSFSdfType::Desert)
+		{
+			Normal = PSFSdf::DoBumpMap(HitPoint, Normal, 0.07f);
+			Material.BaseColor = PSFSdf::GetDesertColor(HitPoint);
+		}
+	}
+
+	// rays that run out of steps keep hitPosition = 0 in the shader, which the lighting treats as a hit at the origin
+	FVector3f Color;
+	if(!LightGrid || !PSFLighting::ShadeTiled(Scene, Hit.HitPosition, Normal, Material, LightGrid->GetTileLights(UVToScreenUV(UV)), Color))
+	{
+		Color = PSFLighting::Shade(Scene, Time, Hit.HitPosition, Normal, Material, RayDirection, UV);
+	}
+	return FLinearColor(Color.X, Color.Y, Color.Z, 1.0f);
+}
+
+void FPSFCpuRaymarcher::Render(const FPSFScene &Scene, const FPSFRenderSettings &Settings, TArray<FLinearColor> &OutPixels, FPSFRenderStats &OutStats,
+	FPSFTemporalHistory *History, FPSFMarchProfile *OutProfile)
+{
+	const int32 Width = Settings.Width;
+	const int32 Height = Settings.Height;
+	const int32 TileSize = FMath::Max(2, Settings.TileSize & ~1);
+	const int32 TilesX = FMath::DivideAndRoundUp(Width, TileSize);
+	const int32 TilesY = FMath::DivideAndRoundUp(Height, TileSize);
+
+	OutPixels.SetNumZeroed(Width * Height);
+	const FPSFMatrix3 CameraMatrix = Scene.ComputeCameraMatrix();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// bounds depend on the time (moving dolphins), the hierarchy is rebuilt for every frame
+	const bool bUseBvh = Settings.bUseBvh && Scene.SDFs.Num() >= MinSDFsForBvh;
+	FPSFBvh Bvh;
+	if(bUseBvh)
+	{
+		Bvh.Build(Scene, Settings.Time);
+	}
+	const FPSFBvh *BvhPtr = bUseBvh ? &Bvh : nullptr;
+
+	// the lights are binned for this view once per frame, like the grid the scene component uploads
+	FPSFLightGrid LightGrid;
+	const FPSFLightGrid *LightGridPtr = Scene.PointLights.Num() > 0 ? &LightGrid : nullptr;
+	if(LightGridPtr)
+	{
+		const double BinningStartTime = FPlatformTime::Seconds();
+		if(Settings.bUseLightGrid)
+		{
+			LightGrid.Build(Scene.PointLights, Scene.RayOrigin, CameraMatrix, Width, Height, Settings.LightTileSize);
+		}
+		else
+		{
+			LightGrid.BuildUnculled(Scene.PointLights);
+		}
+		OutStats.LightBinningSeconds = FPlatformTime::Seconds() - BinningStartTime;
+	}
+
+	std::atomic<int64> TotalSteps(0);
+	std::atomic<int64> TotalEvaluations(0);
+	std::atomic<int64> TotalLightEvaluations(0);
+
+	// the prepass renders at its own resolution, like the prepass material into its render target
+	const int32 PrepassTexel = FMath::Max(0, Settings.ConePrepassTexel);
+	const int32 PrepassWidth = PrepassTexel > 0 ? FMath::DivideAndRoundUp(Width, PrepassTexel) : 0;
+	const int32 PrepassHeight = PrepassTexel > 0 ? FMath::DivideAndRoundUp(Height, PrepassTexel) : 0;
+	TArray<float> ConeStarts;
+	std::atomic<int64> TotalPrepassSteps(0);
+	if(PrepassTexel > 0)
+	{
+		ConeStarts.SetNumZeroed(PrepassWidth * PrepassHeight);
+		const float ConeRadius = ConeRadiusForTile(PrepassWidth, PrepassHeight);
+		ParallelFor(PrepassHeight, [&](int32 Y)
+		{
+			int64 RowSteps = 0;
+			int64 RowEvaluations = 0;
+			for(int32 X = 0; X < PrepassWidth; ++X)
+			{
+				int32 Steps = 0;
+				const FVector3f Direction = ComputeRayDirection(CameraMatrix, PixelToUV(X, Y, PrepassWidth, PrepassHeight));
+				ConeStarts[Y * PrepassWidth + X] = ConeMarch(Scene, Direction, ConeRadius, Settings.Time, RowEvaluations, Steps, BvhPtr);
+				RowSteps += Steps;
+			}
+			TotalPrepassSteps += RowSteps;
+			TotalEvaluations += RowEvaluations;
+		});
+	}
+
+	// the history of another resolution is dropped, like a resized history target
+	const bool bUseHistory = History && History->IsValid() && History->Width == Width && History->Height == Height;
+	TArray<float> Depth;
+	if(History)
+	{
+		Depth.SetNumUninitialized(Width * Height);
+	}
+	std::atomic<int64> TotalTemporalStarts(0);
+
+	// the counters of a profile are written per pixel and per SDF, each tile counts the SDFs on its own
+	TArray<TArray<int64>> TileSdfEvaluations;
+	if(OutProfile)
+	{
+		OutProfile->Width = Width;
+		OutProfile->Height = Height;
+		OutProfile->Pixels.SetNum(Width * Height);
+		OutProfile->Sdfs.Reset();
+		OutProfile->Sdfs.SetNum(Scene.SDFs.Num());
+		TileSdfEvaluations.SetNum(TilesX * TilesY);
+	}
+
+	// the reprojected start is checked like raymarchAllTemporal does, one evaluation that counts as a march step
+	auto MakeStart = [&](int32 X, int32 Y, const FVector3f &Direction, int64 &InOutSteps, int64 &InOutEvaluations, int64 &InOutTemporalStarts,
+		int64 *InOutPerSdfEvaluations = nullptr)
+	{
+		const FVector2f ScreenUV((X + 0.5f) / Width, (Y + 0.5f) / Height);
+		float StartT = PrepassTexel > 0 ? LoadConeStart(ConeStarts, PrepassWidth, PrepassHeight, ScreenUV) : 0.0f;
+		if(bUseHistory)
+		{
+			const float TemporalT = LimitTemporalStart(Scene, Scene.RayOrigin, Direction, Settings.Time, ReprojectStart(*History, Scene.RayOrigin, Direction, ScreenUV, Settings));
+			if(TemporalT > StartT)
+			{
+				int32 BestIndex = INDEX_NONE;
+				++InOutSteps;
+				if(EvalScene(Scene, BvhPtr, Scene.RayOrigin + Direction * TemporalT, Settings.Time, BestIndex, InOutEvaluations, InOutPerSdfEvaluations) >= 0.0f)
+				{
+					StartT = TemporalT;
+					++InOutTemporalStarts;
+				}
+			}
+		}
+		return FPSFMarchState(StartT, Settings.MarchMode, Settings.Relaxation);
+	};
+
+	// unbalanced: tile cost varies a lot between sky and geometry, let idle workers pick up the remaining tiles
+	ParallelFor(TilesX * TilesY, [&](int32 TileIndex)
+	{
+		const int32 MinX = (TileIndex % TilesX) * TileSize;
+		const int32 MinY = (TileIndex / TilesX) * TileSize;
+		const int32 MaxX = FMath::Min(MinX + TileSize, Width);
+		const int32 MaxY = FMath::Min(MinY + TileSize, Height);
+
+		int64 TileSteps = 0;
+		int64 TileEvaluations = 0;
+		int64 TileLightEvaluations = 0;
+		int64 TileTemporalStarts = 0;
+
+		int64 *PerSdfEvaluations = nullptr;
+		if(OutProfile)
+		{
+			TileSdfEvaluations[TileIndex].SetNumZeroed(Scene.SDFs.Num());
+			PerSdfEvaluations = TileSdfEvaluations[TileIndex].GetData();
+		}
+
+		auto WritePixel = [&](int32 X, int32 Y, const FPSFRayHit &Hit, const FVector3f &Direction, const FVector2f &UV)
+		{
+			OutPixels[Y * Width + X] = ShadeHit(Scene, Hit, Direction, UV, Settings.Time, LightGridPtr);
+			if(History)
+			{
+				Depth[Y * Width + X] = TemporalDepth(Hit.HitPosition, Scene.RaymarchStoppingCriterium);
+			}
+			TileSteps += Hit.Steps;
+			if(LightGridPtr && Hit.HitPosition.W <= Scene.RaymarchStoppingCriterium)
+			{
+				TileLightEvaluations += LightGrid.GetTileLights(UVToScreenUV(UV)).Num();
+			}
+		};
+
+		for(int32 Y = MinY; Y < MaxY; Y += 2)
+		{
+			for(int32 X = MinX; X < MaxX; X += 2)
+			{
+				const int32 QuadX[4] = {X, X + 1, X, X + 1};
+				const int32 QuadY[4] = {Y, Y, Y + 1, Y + 1};
+				FVector2f UVs[4];
+				FVector3f Directions[4];
+				for(int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					UVs[Lane] = PixelToUV(QuadX[Lane], QuadY[Lane], Width, Height);
+					Directions[Lane] = ComputeRayDirection(CameraMatrix, UVs[Lane]);
+				}
+
+				// the packets march four rays per evaluation, the profile counts each ray on the scalar path
+				const bool bFullQuad = X + 1 < MaxX && Y + 1 < MaxY;
+				if(Settings.bUsePackets && bFullQuad && !OutProfile)
+				{
+					FPSFMarchState Starts[4];
+					for(int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						Starts[Lane] = MakeStart(QuadX[Lane], QuadY[Lane], Directions[Lane], TileSteps, TileEvaluations, TileTemporalStarts);
+					}
+					FPSFRayHit Hits[4];
+					RaymarchPacket(Scene, BvhPtr, Directions, Settings.Time, Starts, Hits, TileEvaluations);
+					for(int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						WritePixel(QuadX[Lane], QuadY[Lane], Hits[Lane], Directions[Lane], UVs[Lane]);
+					}
+					continue;
+				}
+
+				for(int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					if(QuadX[Lane] < MaxX && QuadY[Lane] < MaxY)
+					{
+						// the check of a reprojected start is part of the pixel's counters
+						int64 StartSteps = 0;
+						int64 StartEvaluations = 0;
+						const FPSFMarchState Start = MakeStart(QuadX[Lane], QuadY[Lane], Directions[Lane], StartSteps, StartEvaluations, TileTemporalStarts, PerSdfEvaluations);
+						FPSFMarchCounters *Counters = OutProfile ? &OutProfile->Pixels[QuadY[Lane] * Width + QuadX[Lane]] : nullptr;
+						const FPSFRayHit Hit = Raymarch(Scene, Directions[Lane], Settings.Time, TileEvaluations, BvhPtr, Start, Counters, PerSdfEvaluations);
+						if(Counters)
+						{
+							Counters->Steps += StartSteps;
+							Counters->SdfEvaluations += StartEvaluations;
+						}
+						TileSteps += StartSteps;
+						TileEvaluations += StartEvaluations;
+						WritePixel(QuadX[Lane], QuadY[Lane], Hit, Directions[Lane], UVs[Lane]);
+					}
+				}
+			}
+		}
+
+		TotalSteps += TileSteps;
+		TotalEvaluations += TileEvaluations;
+		TotalLightEvaluations += TileLightEvaluations;
+		TotalTemporalStarts += TileTemporalStarts;
+	}, EParallelForFlags::Unbalanced);
+
+	if(History)
+	{
+		History->Eye = Scene.RayOrigin;
+		History->CameraMatrix = CameraMatrix;
+		History->Width = Width;
+		History->Height = Height;
+		History->Depth = MoveTemp(Depth);
+	}
+
+	OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+
+	if(OutProfile)
+	{
+		for(const TArray<int64> &Evaluations : TileSdfEvaluations)
+		{
+			for(int32 SdfIndex = 0; SdfIndex < Evaluations.Num(); ++SdfIndex)
+			{
+				OutProfile->Sdfs[SdfIndex].Evaluations += Evaluations[SdfIndex];
+			}
+		}
+		for(const FPSFMarchCounters &Counters : OutProfile->Pixels)
+		{
+			if(Counters.CostliestSdf != INDEX_NONE)
+			{
+				++OutProfile->Sdfs[Counters.CostliestSdf].CostliestPixels;
+			}
+		}
+		OutProfile->MeasureEvaluationCost(Scene, Settings.Time);
+	}
+	OutStats.Rays = int64(Width) * Height;
+	OutStats.MarchSteps = TotalSteps.load();
+	OutStats.SdfEvaluations = TotalEvaluations.load();
+	OutStats.PrepassCones = int64(PrepassWidth) * PrepassHeight;
+	OutStats.PrepassSteps = TotalPrepassSteps.load();
+	OutStats.LightEvaluations = TotalLightEvaluations.load();
+	OutStats.TemporalStarts = TotalTemporalStarts.load();
+}
@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFCustomSDFGenerator.h"
+#include "PSFCustomSDFRegistry.h"
+#include "PSFShaderPatcher.h"
+#include "MaterialEditingLibrary.h"
+#include "Misc/Crc.h"
+#include "HAL/FileManager.h"
+#include "AssetToolsModule.h"
+#include "Factories/MaterialFunctionFactoryNew.h"
+#include "Materials/MaterialFunction.h"
+#include "IAssetTools.h"
+#include "Materials/MaterialExpressionFunctionInput.h"
+#include "Materials/MaterialExpressionFunctionOutput.h"
+#include "Materials/MaterialExpressionCustom.h"
+#include "MaterialShared.h"
+#include "Materials/MaterialExpressionBreakMaterialAttributes.h"
+#include "ObjectTools.h"
+
+const TCHAR *FPSFCustomSDFGenerator::DefaultPackagePath = TEXT("/Game/SDF");
+
+namespace
+{
+	/**
+	 * Code of the Custom node in Add<Name>. The checksum of the SDF code changes the node with every edit of the
+	 * SDF, so exactly the materials that use this function get a new shader map.
+	 */
+	FString MakeAddCustomSDFNodeCode(const FPSFCustomSDF &Sdf)
+	{
+		return FString::Printf(TEXT("// sd%s %08x\n"), *Sdf.Name, FCrc::StrCrc32(*Sdf.Code)) +
+			TEXT("float index = Index;\n"
+			"MaterialParams mat;\n"
+			"mat.baseColor = baseColor;\n"
+			"mat.specularColor = specularColor;\n"
+			"mat.specularStrength = specularStrength;\n"
+			"mat.shininess = shininess;\n"
+			"mat.roughness = roughness;\n"
+			"mat.metallic = metallic;\n"
+			"mat.rimPower = rimPower;\n"
+			"mat.fakeSpecularColor = fakeSpecularColor;\n"
+			"mat.fakeSpecularPower = fakeSpecularPower;\n"
+			"mat.ior = ior;\n"
+			"mat.refractionStrength = refractionStrength;\n"
+			"mat.refractionTint = refractionTint;\n") +
+			FString::Printf(TEXT("add%s(index, mat);\n"), *Sdf.Name) +
+			TEXT("return index;\n");
+	}
+}
+
+bool FPSFCustomSDFGenerator::WriteShaderFiles(const FString &ShaderDir, const FPSFCustomSDFRegistry &Registry, bool &bOutChanged)
+{
+	bOutChanged = false;
+
+	// Ensure directory exists
+	IFileManager::Get().MakeDirectory(*ShaderDir, true);
+
+	// Write to file, unchanged code keeps the file and the compiled shaders untouched
+	FString FilePath = ShaderDir / TEXT("/MyCustomSDFs.ush");
+	bool bWritten = false;
+	if(!FPSFShaderPatcher::SaveStringIfChanged(Registry.GenerateIncludeFile(), FilePath, bWritten))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write shader code to: %s"), *FilePath);
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("Shader code %s: %s"), bWritten ? TEXT("written to") : TEXT("is unchanged in"), *FilePath);
+	bOutChanged = bWritten;
+
+	// sdf_functions.ush is parsed once and written once with all three regions
+	FPSFShaderPatcher Patcher;
+	if(!Patcher.Load(ShaderDir / TEXT("/sdf_functions.ush")))
+	{
+		return false;
+	}
+
+	// include customSDF.ush
+	Patcher.SetRegion(TEXT("INCLUDECUSTOMSDF"), TEXT("#include \"MyCustomSDFs.ush\"\n"));
+
+	// Modify evalSDF, one branch per type id
+	Patcher.SetRegion(TEXT("EVALCUSTOMSDF"), Registry.GenerateEvalCode());
+
+	// add<Name>(inout int index, MaterialParams material) for every custom SDF
+	Patcher.SetRegion(TEXT("ADDCUSTOMSDF"), Registry.GenerateAddCode());
+
+	if(!Patcher.Save(bWritten))
+	{
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s between markers."), bWritten ? TEXT("Successfully updated file") : TEXT("File is unchanged"));
+	bOutChanged |= bWritten;
+	return true;
+}
+
+UMaterialFunction *FPSFCustomSDFGenerator::UpdateMaterialFunction(const FPSFCustomSDF &Sdf, bool bShaderChanged, const FString &PackagePath, bool &bOutModified)
+{
+	bOutModified = false;
+	FString AssetName = FPSFCustomSDFRegistry::GetMaterialFunctionName(Sdf);
+	FAssetToolsModule &AssetToolsModule = FAssetToolsModule::GetModule();
+	const FString CustomCode = MakeAddCustomSDFNodeCode(Sdf);
+
+
+	// Update an existing asset in place, materials using it keep their reference and only they recompile
+	UMaterialFunction *ExistingFunction = LoadObject<UMaterialFunction>(nullptr, *(PackagePath / AssetName + TEXT(".") + AssetName), nullptr, LOAD_NoWarn | LOAD_Quiet);
+	if(ExistingFunction)
+	{
+		UMaterialExpressionCustom *ExistingNode = nullptr;
+		for(UMaterialExpression *Expression : ExistingFunction->GetExpressions())
+		{
+			ExistingNode = Cast<UMaterialExpressionCustom>(Expression);
+			if(ExistingNode)
+			{
+				break;
+			}
+		}
+
+		if(ExistingNode)
+		{
+			const bool bNodeChanged = !ExistingNode->Code.Equals(CustomCode, ESearchCase::CaseSensitive);
+			if(bNodeChanged)
+			{
+				ExistingFunction->Modify();
+				ExistingNode->Modify();
+				ExistingNode->Code = CustomCode;
+				ExistingFunction->PostEditChange();
+				ExistingFunction->MarkPackageDirty();
+			}
+
+			if(bNodeChanged || bShaderChanged)
+			{
+				UMaterialEditingLibrary::UpdateMaterialFunction(ExistingFunction, nullptr);
+				UE_LOG(LogTemp, Log, TEXT("Material Function '%s' updated in place."), *(PackagePath / AssetName));
+			}
+			bOutModified = bNodeChanged;
+			return ExistingFunction;
+		}
+
+		// not one of ours anymore, start over
+		TArray<UObject *> AssetsToDelete = {ExistingFunction};
+		ObjectTools::DeleteObjectsUnchecked(AssetsToDelete);
+		UE_LOG(LogTemp, Warning, TEXT("Existing asset '%s' has no Custom node and was deleted."), *(PackagePath / AssetName));
+	}
+
+	// Create the asset
+	UMaterialFunctionFactoryNew *Factory = NewObject<UMaterialFunctionFactoryNew>();
+
+
+	UObject* CreatedAsset = AssetToolsModule.Get().CreateAsset(
+		AssetName, PackagePath, UMaterialFunction::StaticClass(), Factory);
+
+
+	UMaterialFunction *MaterialFunction = Cast<UMaterialFunction>(CreatedAsset);
+
+	if(!MaterialFunction)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to create Material Function."));
+		return nullptr;
+	}
+
+	// Mark as transactional so we can undo/redo
+	MaterialFunction->SetFlags(RF_Transactional);
+
+	// Create nodes
+	UMaterialExpressionFunctionInput *IndexInputNode = NewObject<UMaterialExpressionFunctionInput>(MaterialFunction, UMaterialExpressionFunctionInput::StaticClass(), NAME_None, RF_Transactional);
+	UMaterialExpressionFunctionInput *MaterialInputNode = NewObject<UMaterialExpressionFunctionInput>(MaterialFunction, UMaterialExpressionFunctionInput::StaticClass(), NAME_None, RF_Transactional);
+
+
+	UMaterialExpressionCustom *CustomNode = NewObject<UMaterialExpressionCustom>(MaterialFunction, UMaterialExpressionCustom::StaticClass(), NAME_None, RF_Transactional);
+	UMaterialExpressionFunctionOutput *OutputNode = NewObject<UMaterialExpressionFunctionOutput>(MaterialFunction, UMaterialExpressionFunctionOutput::StaticClass(), NAME_None, RF_Transactional);
+
+	UMaterialExpressionBreakMaterialAttributes *BreakMaterialNode = NewObject<UMaterialExpressionBreakMaterialAttributes>(MaterialFunction, UMaterialExpressionBreakMaterialAttributes::StaticClass(), NAME_None, RF_Transactional);
+
+	// Configure Inputs
+	IndexInputNode->InputName = TEXT("index");
+	IndexInputNode->InputType = FunctionInput_Scalar;
+	IndexInputNode->MaterialExpressionEditorX = -400;
+	IndexInputNode->MaterialExpressionEditorY = 0;
+
+	MaterialInputNode->InputName = TEXT("material");
+	MaterialInputNode->InputType = FunctionInput_MaterialAttributes;
+	MaterialInputNode->MaterialExpressionEditorX = -400;
+	MaterialInputNode->MaterialExpressionEditorY = -200;
+
+
+	FCustomInput baseColor, specularColor, specularStrength, shininess, roughness, metallic, rimPower, fakeSpecularColor, fakeSpecularPower, ior, refractionStrength, refractionTint;
+	baseColor.InputName = TEXT("baseColor");
+	specularColor.InputName = TEXT("specularColor");
+	specularStrength.InputName = TEXT("specularStrength");
+	shininess.InputName = TEXT("shininess");
+	roughness.InputName = TEXT("roughness");
+	metallic.InputName = TEXT("metallic");
+	rimPower.InputName = TEXT("rimPower");
+	fakeSpecularColor.InputName = TEXT("fakeSpecularColor");
+	fakeSpecularPower.InputName = TEXT("fakeSpecularPower");
+	ior.InputName = TEXT("ior");
+	refractionStrength.InputName = TEXT("refractionStrength");
+	refractionTint.InputName = TEXT("refractionTint");
+
+	CustomNode->Inputs.Add(baseColor);
+	CustomNode->Inputs.Add(specularColor);
+	CustomNode->Inputs.Add(specularStrength);
+	CustomNode->Inputs.Add(shininess);
+	CustomNode->Inputs.Add(roughness);
+	CustomNode->Inputs.Add(metallic);
+	CustomNode->Inputs.Add(rimPower);
+	CustomNode->Inputs.Add(fakeSpecularColor);
+	CustomNode->Inputs.Add(fakeSpecularPower);
+	CustomNode->Inputs.Add(ior);
+	CustomNode->Inputs.Add(refractionStrength);
+	CustomNode->Inputs.Add(refractionTint);
+
+	// Configure Custom node
+	CustomNode->Code = CustomCode;
+	CustomNode->OutputType = CMOT_Float1;
+
+	CustomNode->IncludeFilePaths.Add("/ProceduralShaderFramework/procedural_shader.ush");
+	CustomNode->IncludeFilePaths.Add("/ProceduralShaderFramework/MyCustomSDFs.ush");
+	CustomNode->ShowCode = true;
+	CustomNode->Inputs[0].InputName = "Index";
+
+	CustomNode->MaterialExpressionEditorX = 400;
+	CustomNode->MaterialExpressionEditorY = 0;
+
+	// Connect input to custom input
+	CustomNode->Inputs[0].Input.Connect(0, IndexInputNode); // index
+
+	CustomNode->Inputs[1].Input.Connect(0, BreakMaterialNode); // basecolor -> basecolor
+	CustomNode->Inputs[6].Input.Connect(1, BreakMaterialNode); // metallic -> metallic
+	CustomNode->Inputs[3].Input.Connect(2, BreakMaterialNode); // Specular -> specularStrength
+	CustomNode->Inputs[5].Input.Connect(3, BreakMaterialNode); // Roughness -> roughness
+	CustomNode->Inputs[9].Input.Connect(4, BreakMaterialNode); // Anisotropy -> fakeSpecularPower
+	CustomNode->Inputs[2].Input.Connect(5, BreakMaterialNode); // EmissiveColor -> SpecularColor
+	CustomNode->Inputs[4].Input.Connect(6, BreakMaterialNode); // Opacity -> shininess
+	CustomNode->Inputs[7].Input.Connect(7, BreakMaterialNode); // OpacityMask -> rimPower
+	CustomNode->Inputs[8].Input.Connect(8, BreakMaterialNode); // Normal -> fakeSpecularColor
+	CustomNode->Inputs[12].Input.Connect(9, BreakMaterialNode); // Tangent -> refractionTint
+	CustomNode->Inputs[11].Input.Connect(13, BreakMaterialNode); // ClearCoatRoughness -> refractionStrength
+	CustomNode->Inputs[10].Input.Connect(14, BreakMaterialNode); // AmbientOcclusion -> ior
+
+
+	// Configure breakMaterialNode
+	BreakMaterialNode->MaterialAttributes.Connect(0, MaterialInputNode);
+	BreakMaterialNode->MaterialExpressionEditorX = 0;
+	BreakMaterialNode->MaterialExpressionEditorY = 0;
+
+
+	
+
+	// Configure Output
+	OutputNode->OutputName = TEXT("nextIndex");
+	OutputNode->MaterialExpressionEditorX = 800;
+	OutputNode->MaterialExpressionEditorY = 0;
+	OutputNode->A.Connect(0, CustomNode);
+
+	TArray<FFunctionExpressionInput> Inputs;
+	TArray<FFunctionExpressionOutput> Outputs;
+	MaterialFunction->GetInputsAndOutputs(Inputs, Outputs);
+
+
+	FMaterialExpressionCollection Collection;
+	Collection.Expressions = {
+		IndexInputNode,
+		CustomNode,
+		OutputNode,
+		MaterialInputNode,
+		BreakMaterialNode
+	};
+
+	MaterialFunction->AssignExpressionCollection(Collection);
+	
+	// Compile and save
+	MaterialFunction->PostEditChange();
+	MaterialFunction->MarkPackageDirty();
+	MaterialFunction->UpdateFromFunctionResource();
+	UE_LOG(LogTemp, Log, TEXT("Material Function created and configured successfully."));
+	bOutModified = true;
+	return MaterialFunction;
+}
+
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FPSFCustomSDFRegistry;
+class UMaterialFunction;
+struct FPSFCustomSDF;
+
+/**
+ * Writes the shader code and the Add<Name> material functions of the custom SDFs, for the Generate button of the
+ * plugin tab and for the batch generation of -run=PSFGenerateCustomSDFs.
+ */
+class FPSFCustomSDFGenerator
+{
+public:
+	/** Package the material functions are created in */
+	static const TCHAR *DefaultPackagePath;
+
+	/**
+	 * Writes MyCustomSDFs.ush and the generated regions of sdf_functions.ush in ShaderDir for every SDF of the registry.
+	 * Each file is written at most once and only if its content changed, bOutChanged tells whether one was.
+	 */
+	static bool WriteShaderFiles(const FString &ShaderDir, const FPSFCustomSDFRegistry &Registry, bool &bOutChanged);
+
+	/**
+	 * Creates Add<Name> in PackagePath or updates its Custom node in place, materials using it are recompiled if the node
+	 * or the shader files (bShaderChanged) changed. bOutModified tells whether the asset was created or edited and needs
+	 * saving. nullptr if the asset could not be created.
+	 */
+	static UMaterialFunction *UpdateMaterialFunction(const FPSFCustomSDF &Sdf, bool bShaderChanged, const FString &PackagePath, bool &bOutModified);
+};
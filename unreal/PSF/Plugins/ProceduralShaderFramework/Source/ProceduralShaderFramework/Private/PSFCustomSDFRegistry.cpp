@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFCustomSDFRegistry.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+const TCHAR *FPSFCustomSDFRegistry::LegacyName = TEXT("CustomSDF");
+const TCHAR *FPSFCustomSDFRegistry::LegacyFunctionName = TEXT("sdMyCustomSDF");
+const TCHAR *FPSFCustomSDFRegistry::FileName = TEXT("CustomSDFs.json");
+
+namespace
+{
+	// names whose sd<Name> or add<Name> already exist in the framework shaders
+	const TCHAR *ReservedNames[] = {
+		TEXT("SDF"), TEXT("Sphere"), TEXT("RoundBox"), TEXT("Box"), TEXT("Torus"), TEXT("HexPrism"), TEXT("Octahedron"),
+		TEXT("Ellipsoid"), TEXT("Dolphin"), TEXT("Rock"), TEXT("Desert"), TEXT("SunriseLight"),
+		TEXT("MyCustomSDF")
+	};
+}
+
+bool FPSFCustomSDFRegistry::LoadFromJsonFile(const FString &FilePath)
+{
+	Entries.Reset();
+	NextTypeId = LegacyTypeId;
+
+	if(!FPaths::FileExists(FilePath))
+	{
+		return true;
+	}
+
+	FString JsonString;
+	if(!FFileHelper::LoadFileToString(JsonString, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read custom SDF registry: %s"), *FilePath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if(!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Custom SDF registry is not valid json: %s"), *FilePath);
+		return false;
+	}
+
+	Root->TryGetNumberField(TEXT("nextTypeId"), NextTypeId);
+
+	const TArray<TSharedPtr<FJsonValue>> *SdfValues = nullptr;
+	if(Root->TryGetArrayField(TEXT("sdfs"), SdfValues))
+	{
+		for(const TSharedPtr<FJsonValue> &SdfValue : *SdfValues)
+		{
+			const TSharedPtr<FJsonObject> *SdfObject = nullptr;
+			if(!SdfValue.IsValid() || !SdfValue->TryGetObject(SdfObject))
+			{
+				continue;
+			}
+
+			FPSFCustomSDF Sdf;
+			if(!(*SdfObject)->TryGetStringField(TEXT("name"), Sdf.Name) || !(*SdfObject)->TryGetNumberField(TEXT("typeId"), Sdf.TypeId) || !ValidateName(Sdf.Name).IsEmpty() || Find(Sdf.Name))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Skipping invalid custom SDF entry in %s."), *FilePath);
+				continue;
+			}
+			(*SdfObject)->TryGetStringField(TEXT("code"), Sdf.Code);
+
+			NextTypeId = FMath::Max(NextTypeId, Sdf.TypeId + 1);
+			Entries.Add(Sdf);
+		}
+	}
+	return true;
+}
+
+bool FPSFCustomSDFRegistry::SaveToJsonFile(const FString &FilePath) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("nextTypeId"), NextTypeId);
+
+	TArray<TSharedPtr<FJsonValue>> SdfValues;
+	for(const FPSFCustomSDF &Sdf : Entries)
+	{
+		TSharedRef<FJsonObject> SdfObject = MakeShared<FJsonObject>();
+		SdfObject->SetStringField(TEXT("name"), Sdf.Name);
+		SdfObject->SetNumberField(TEXT("typeId"), Sdf.TypeId);
+		SdfObject->SetStringField(TEXT("code"), Sdf.Code);
+		SdfValues.Add(MakeShared<FJsonValueObject>(SdfObject));
+	}
+	Root->SetArrayField(TEXT("sdfs"), SdfValues);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	if(!FFileHelper::SaveStringToFile(JsonString, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write custom SDF registry: %s"), *FilePath);
+		return false;
+	}
+	return true;
+}
+
+FString FPSFCustomSDFRegistry::ValidateName(const FString &Name)
+{
+	if(Name.IsEmpty())
+	{
+		return TEXT("The name is empty.");
+	}
+	if(!FChar::IsAlpha(Name[0]))
+	{
+		return TEXT("The name has to start with a letter.");
+	}
+	for(const TCHAR Character : Name)
+	{
+		if(!FChar::IsAlnum(Character) && Character != TEXT('_'))
+		{
+			return TEXT("The name may only contain letters, digits and underscores.");
+		}
+	}
+	for(const TCHAR *Reserved : ReservedNames)
+	{
+		if(Name.Equals(Reserved, ESearchCase::IgnoreCase))
+		{
+			return FString::Printf(TEXT("sd%s or add%s already exists in the framework."), Reserved, Reserved);
+		}
+	}
+	return FString();
+}
+
+const FPSFCustomSDF &FPSFCustomSDFRegistry::AddOrUpdate(const FString &Name, const FString &Code)
+{
+	FPSFCustomSDF *Existing = Entries.FindByPredicate([&Name](const FPSFCustomSDF &Sdf)
+	{
+		return Sdf.Name.Equals(Name, ESearchCase::CaseSensitive);
+	});
+	if(Existing)
+	{
+		Existing->Code = Code;
+		return *Existing;
+	}
+
+	FPSFCustomSDF &Sdf = Entries.AddDefaulted_GetRef();
+	Sdf.Name = Name;
+	Sdf.Code = Code;
+
+	// the legacy name keeps its id even if other SDFs were created first
+	if(Name.Equals(LegacyName, ESearchCase::CaseSensitive) && !Entries.ContainsByPredicate([](const FPSFCustomSDF &Other) { return Other.TypeId == LegacyTypeId; }))
+	{
+		Sdf.TypeId = LegacyTypeId;
+	}
+	else
+	{
+		NextTypeId = FMath::Max(NextTypeId, LegacyTypeId + 1);
+		Sdf.TypeId = NextTypeId++;
+	}
+	return Sdf;
+}
+
+bool FPSFCustomSDFRegistry::Remove(const FString &Name)
+{
+	// NextTypeId is saved with the registry, so the id stays retired
+	return Entries.RemoveAll([&Name](const FPSFCustomSDF &Sdf)
+	{
+		return Sdf.Name.Equals(Name, ESearchCase::CaseSensitive);
+	}) > 0;
+}
+
+const FPSFCustomSDF *FPSFCustomSDFRegistry::Find(const FString &Name) const
+{
+	return Entries.FindByPredicate([&Name](const FPSFCustomSDF &Sdf)
+	{
+		return Sdf.Name.Equals(Name, ESearchCase::CaseSensitive);
+	});
+}
+
+FString FPSFCustomSDFRegistry::GenerateIncludeFile() const
+{
+	FString Code;
+	Code += TEXT("#ifndef PROCEDURAL_SHADER_FRAMEWORK_CUSTOM_SDFs_H\n");
+	Code += TEXT("#define PROCEDURAL_SHADER_FRAMEWORK_CUSTOM_SDFs_H\n");
+
+	for(const FPSFCustomSDF &Sdf : Entries)
+	{
+		Code += FString::Printf(TEXT("\n// type %d\n"), Sdf.TypeId);
+		Code += FString::Printf(TEXT("float sd%s(float3 probePoint, float time)\n"), *Sdf.Name);
+		Code += TEXT("{\n    ");
+		Code += Sdf.Code.Replace(TEXT("\n"), TEXT("\n    ")); // indent nicely
+		Code += TEXT("\n}\n");
+
+		// HLSL written against the single custom SDF calls it by its old name
+		if(Sdf.Name.Equals(LegacyName, ESearchCase::CaseSensitive))
+		{
+			Code += FString::Printf(TEXT("\nfloat %s(float3 probePoint, float time)\n"), LegacyFunctionName);
+			Code += FString::Printf(TEXT("{\n    return sd%s(probePoint, time);\n}\n"), LegacyName);
+		}
+	}
+
+	Code += TEXT("#endif\n");
+	return Code;
+}
+
+FString FPSFCustomSDFRegistry::GenerateEvalCode() const
+{
+	FString Code;
+	for(const FPSFCustomSDF &Sdf : Entries)
+	{
+		Code += FString::Printf(TEXT("    else if (s.type == %d)\n"), Sdf.TypeId);
+		Code += TEXT("    {\n");
+		Code += FString::Printf(TEXT("        return sd%s(probePoint, time);\n"), *Sdf.Name);
+		Code += TEXT("    }\n");
+	}
+	return Code;
+}
+
+FString FPSFCustomSDFRegistry::GenerateAddCode() const
+{
+	FString Code;
+	for(const FPSFCustomSDF &Sdf : Entries)
+	{
+		Code += FString::Printf(TEXT("void add%s(inout int index, MaterialParams material)\n"), *Sdf.Name);
+		Code += TEXT("{\n");
+		Code += TEXT("    SDF newSDF;\n");
+		Code += FString::Printf(TEXT("    newSDF.type = %d;\n"), Sdf.TypeId);
+		Code += TEXT("    newSDF.position = float3(0.0, 0.0, 0.0);\n");
+		Code += TEXT("    newSDF.material = material;\n");
+		Code += TEXT("    newSDF.rotation = computeRotationMatrix(normalize(float3(0.0, 1.0, 0.0)), 0 * PI / 180);\n");
+		Code += TEXT("    addSDF(index, newSDF);\n");
+		Code += TEXT("}\n");
+	}
+	return Code;
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPSFCustomSDF
+{
+	/** HLSL identifier, the SDF is sd<Name>, added with add<Name> and has the material function Add<Name> */
+	FString Name;
+
+	/** SDF::type in the shaders, assigned once and never reused */
+	int32 TypeId = 0;
+
+	/** Body of sd<Name>(float3 probePoint, float time) */
+	FString Code;
+};
+
+/**
+ * The custom SDFs of a project, persisted as json next to the generated shaders.
+ *
+ * The first custom SDF is CustomSDF with the type 99 that the single custom SDF always had, so addCustomSDF,
+ * the AddCustomSDF material function and scenes with type 99 keep working. Every further name gets the next free id.
+ */
+class FPSFCustomSDFRegistry
+{
+public:
+	static const int32 LegacyTypeId = 99;
+	static const TCHAR *LegacyName;
+
+	/** What the single custom SDF was called in HLSL before the registry, MyCustomSDFs.ush still defines it for CustomSDF */
+	static const TCHAR *LegacyFunctionName;
+	static const TCHAR *FileName;
+
+	/** A missing file is an empty registry */
+	bool LoadFromJsonFile(const FString &FilePath);
+	bool SaveToJsonFile(const FString &FilePath) const;
+
+	/** Empty if Name can be used, otherwise the reason why not */
+	static FString ValidateName(const FString &Name);
+
+	/** Adds Name or replaces its code, the type id of an existing name does not change */
+	const FPSFCustomSDF &AddOrUpdate(const FString &Name, const FString &Code);
+
+	/** Removes Name, its type id is not handed out again. False if Name is not registered. */
+	bool Remove(const FString &Name);
+
+	const FPSFCustomSDF *Find(const FString &Name) const;
+
+	const TArray<FPSFCustomSDF> &GetEntries() const
+	{
+		return Entries;
+	}
+
+	/** MyCustomSDFs.ush with one sd<Name> per entry and LegacyFunctionName for CustomSDF */
+	FString GenerateIncludeFile() const;
+
+	/** Branches of evalSDF, between the EVALCUSTOMSDF markers of sdf_functions.ush */
+	FString GenerateEvalCode() const;
+
+	/** add<Name> functions, between the ADDCUSTOMSDF markers of sdf_functions.ush */
+	FString GenerateAddCode() const;
+
+	static FString GetMaterialFunctionName(const FPSFCustomSDF &Sdf)
+	{
+		return TEXT("Add") + Sdf.Name;
+	}
+
+private:
+	TArray<FPSFCustomSDF> Entries;
+	int32 NextTypeId = LegacyTypeId;
+};
@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFExtractMeshCommandlet.h"
+#include "PSFBvh.h"
+#include "PSFMeshExtractor.h"
+#include "PSFScene.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	bool ParseBounds(const FString &BoundsString, FBox3f &OutBounds)
+	{
+		TArray<FString> Values;
+		BoundsString.ParseIntoArray(Values, TEXT(","));
+		if(Values.Num() != 6)
+		{
+			return false;
+		}
+		OutBounds = FBox3f(FVector3f(FCString::Atof(*Values[0]), FCString::Atof(*Values[1]), FCString::Atof(*Values[2])),
+			FVector3f(FCString::Atof(*Values[3]), FCString::Atof(*Values[4]), FCString::Atof(*Values[5])));
+		return true;
+	}
+
+	/** Wavefront obj with positions, normals and 1 based triangle indices */
+	bool SaveObj(const FPSFExtractedMesh &Mesh, const FString &FileName)
+	{
+		FString Obj;
+		Obj.Reserve((Mesh.Positions.Num() * 2 + Mesh.GetNumTriangles()) * 40);
+		for(const FVector3f &Position : Mesh.Positions)
+		{
+			Obj += FString::Printf(TEXT("v %f %f %f\n"), Position.X, Position.Y, Position.Z);
+		}
+		for(const FVector3f &Normal : Mesh.Normals)
+		{
+			Obj += FString::Printf(TEXT("vn %f %f %f\n"), Normal.X, Normal.Y, Normal.Z);
+		}
+		for(int32 Triangle = 0; Triangle < Mesh.GetNumTriangles(); ++Triangle)
+		{
+			const uint32 A = Mesh.Indices[Triangle * 3] + 1, B = Mesh.Indices[Triangle * 3 + 1] + 1, C = Mesh.Indices[Triangle * 3 + 2] + 1;
+			Obj += FString::Printf(TEXT("f %u//%u %u//%u %u//%u\n"), A, A, B, B, C, C);
+		}
+
+		if(!FFileHelper::SaveStringToFile(Obj, *FileName))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write mesh: %s"), *FileName);
+			return false;
+		}
+		return true;
+	}
+
+	TSharedRef<FJsonObject> LodToJson(int32 Lod, const FString &FileName, const FPSFExtractedMesh &Mesh, const FPSFMeshExtractStats &Stats)
+	{
+		TSharedRef<FJsonObject> LodObject = MakeShared<FJsonObject>();
+		LodObject->SetNumberField(TEXT("lod"), Lod);
+		LodObject->SetStringField(TEXT("file"), FileName);
+		LodObject->SetNumberField(TEXT("cellSize"), Mesh.CellSize);
+		LodObject->SetNumberField(TEXT("vertices"), Stats.Vertices);
+		LodObject->SetNumberField(TEXT("triangles"), Stats.Triangles);
+		LodObject->SetNumberField(TEXT("seconds"), Stats.Seconds);
+		LodObject->SetNumberField(TEXT("trianglesPerSecond"), Stats.GetTrianglesPerSecond());
+		LodObject->SetNumberField(TEXT("sdfEvaluationsPerSecond"), Stats.Seconds > 0.0 ? Stats.SdfEvaluations / Stats.Seconds : 0.0);
+		LodObject->SetNumberField(TEXT("totalChunks"), Stats.TotalChunks);
+		LodObject->SetNumberField(TEXT("surfaceChunks"), Stats.SurfaceChunks);
+		LodObject->SetNumberField(TEXT("peakBytes"), double(Stats.PeakBytes));
+		LodObject->SetNumberField(TEXT("denseBytes"), double(Stats.DenseBytes));
+		LodObject->SetNumberField(TEXT("meshBytes"), double(Mesh.GetNumBytes()));
+		LodObject->SetNumberField(TEXT("maxVertexError"), Stats.MaxVertexError);
+		return LodObject;
+	}
+}
+
+UPSFExtractMeshCommandlet::UPSFExtractMeshCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFExtractMeshCommandlet::Main(const FString &Params)
+{
+	FString ScenePath;
+	FString OutDir;
+	if(!FParse::Value(*Params, TEXT("Scene="), ScenePath) || !FParse::Value(*Params, TEXT("Out="), OutDir))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFExtractMesh -Scene=<scene.json> -Out=<dir> [-Index=<n>] [-Resolution=128] [-Lods=3] [-Chunk=32] [-Bounds=minX,minY,minZ,maxX,maxY,maxZ] [-NoProject] [-Report=<report.json>]"));
+		return 1;
+	}
+
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
+	{
+		return 1;
+	}
+
+	FPSFMeshExtractSettings Settings;
+	FParse::Value(*Params, TEXT("Resolution="), Settings.Resolution);
+	FParse::Value(*Params, TEXT("Lods="), Settings.NumLods);
+	FParse::Value(*Params, TEXT("Chunk="), Settings.ChunkCells);
+	Settings.bProjectVertices = !FParse::Param(*Params, TEXT("NoProject"));
+
+	FBox3f Bounds(ForceInit);
+	FString BoundsString;
+	if(FParse::Value(*Params, TEXT("Bounds="), BoundsString, false) && !ParseBounds(BoundsString, Bounds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("-Bounds needs six comma separated values: %s"), *BoundsString);
+		return 1;
+	}
+
+	TArray<int32> Indices;
+	int32 SelectedIndex = INDEX_NONE;
+	if(FParse::Value(*Params, TEXT("Index="), SelectedIndex))
+	{
+		if(!Scene.SDFs.IsValidIndex(SelectedIndex))
+		{
+			UE_LOG(LogTemp, Error, TEXT("The scene has no SDF %d."), SelectedIndex);
+			return 1;
+		}
+		Indices.Add(SelectedIndex);
+	}
+	else
+	{
+		for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+		{
+			FBox3f SdfBounds(ForceInit);
+			if(FPSFMeshExtractor::CanExtract(Scene.SDFs[Index]) && (Bounds.IsValid || PSFSdfBounds::ComputeBounds(Scene.SDFs[Index], 0.0f, SdfBounds)))
+			{
+				Indices.Add(Index);
+			}
+		}
+	}
+
+	if(Indices.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Nothing to extract in %s."), *ScenePath);
+		return 0;
+	}
+
+	const FString SceneName = FPaths::GetBaseFilename(ScenePath);
+	TArray<TSharedPtr<FJsonValue>> MeshValues;
+	int32 Failures = 0;
+	for(const int32 Index : Indices)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Index];
+		UE_LOG(LogTemp, Display, TEXT("Extracting SDF %d (%s) at resolution %d with %d LODs"), Index, PSFScene::SdfTypeToString(Sdf.Type), Settings.Resolution, Settings.NumLods);
+
+		TArray<FPSFExtractedMesh> Lods;
+		TArray<FPSFMeshExtractStats> Stats;
+		if(!FPSFMeshExtractor::ExtractLods(Sdf, Bounds, Settings, Lods, Stats))
+		{
+			++Failures;
+			continue;
+		}
+
+		TArray<TSharedPtr<FJsonValue>> LodValues;
+		for(int32 Lod = 0; Lod < Lods.Num(); ++Lod)
+		{
+			FPSFMeshExtractor::LogStats(Lod, Stats[Lod]);
+			const FString FileName = OutDir / FString::Printf(TEXT("%s_%d_LOD%d.obj"), *SceneName, Index, Lod);
+			if(!SaveObj(Lods[Lod], FileName))
+			{
+				++Failures;
+				continue;
+			}
+			LodValues.Add(MakeShared<FJsonValueObject>(LodToJson(Lod, FileName, Lods[Lod], Stats[Lod])));
+		}
+
+		TSharedRef<FJsonObject> MeshObject = MakeShared<FJsonObject>();
+		MeshObject->SetNumberField(TEXT("index"), Index);
+		MeshObject->SetStringField(TEXT("type"), PSFScene::SdfTypeToString(Sdf.Type));
+		MeshObject->SetArrayField(TEXT("lods"), LodValues);
+		MeshValues.Add(MakeShared<FJsonValueObject>(MeshObject));
+	}
+
+	FString ReportPath;
+	if(FParse::Value(*Params, TEXT("Report="), ReportPath))
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("scene"), ScenePath);
+		Root->SetNumberField(TEXT("resolution"), Settings.Resolution);
+		Root->SetNumberField(TEXT("chunkCells"), Settings.ChunkCells);
+		Root->SetArrayField(TEXT("meshes"), MeshValues);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+		if(!FFileHelper::SaveStringToFile(JsonString, *ReportPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write mesh report: %s"), *ReportPath);
+			return 1;
+		}
+	}
+	return Failures > 0 ? 1 : 0;
+}
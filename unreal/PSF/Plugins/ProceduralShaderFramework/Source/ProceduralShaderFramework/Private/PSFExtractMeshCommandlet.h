@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFExtractMeshCommandlet.generated.h"
+
+/**
+ * Extracts indexed meshes with LODs from static SDFs of a json scene, for rasterization at distance and for collision.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFExtractMesh -Scene=<scene.json> -Out=<dir> [-Index=<n>] [-Resolution=128] [-Lods=3]
+ *     [-Chunk=32] [-Bounds=minX,minY,minZ,maxX,maxY,maxZ] [-NoProject] [-Report=<report.json>]
+ *
+ * Without -Index every bounded SDF that evalSDF can evaluate on the CPU is extracted, the desert is unbounded and needs
+ * -Bounds. Every LOD is written to <Out>/<Scene>_<Index>_LOD<n>.obj, which the static mesh importer reads, the
+ * coarsest LOD is the one meant for collision. Logs triangles per second and the peak memory of every extraction.
+ */
+UCLASS()
+class UPSFExtractMeshCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFExtractMeshCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
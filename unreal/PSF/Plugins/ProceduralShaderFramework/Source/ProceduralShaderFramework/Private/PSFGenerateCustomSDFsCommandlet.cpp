@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFGenerateCustomSDFsCommandlet.h"
+#include "PSFCustomSDFGenerator.h"
+#include "PSFCustomSDFRegistry.h"
+#include "FileHelpers.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Materials/MaterialFunction.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "ShaderCompiler.h"
+
+namespace
+{
+	struct FSdfDefinition
+	{
+		FString Name;
+		FString Code;
+		bool bChanged = false;
+	};
+
+	/** Reads every <Name>.hlsl of Dir in name order, false if one can not be read or has an invalid name */
+	bool LoadDefinitions(const FString &Dir, TArray<FSdfDefinition> &OutDefinitions)
+	{
+		TArray<FString> FileNames;
+		IFileManager::Get().FindFiles(FileNames, *(Dir / TEXT("*.hlsl")), true, false);
+		FileNames.Sort();
+
+		bool bValid = true;
+		for(const FString &FileName : FileNames)
+		{
+			FSdfDefinition &Definition = OutDefinitions.AddDefaulted_GetRef();
+			Definition.Name = FPaths::GetBaseFilename(FileName);
+
+			const FString NameError = FPSFCustomSDFRegistry::ValidateName(Definition.Name);
+			if(!NameError.IsEmpty())
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: %s"), *FileName, *NameError);
+				bValid = false;
+				continue;
+			}
+			if(!FFileHelper::LoadFileToString(Definition.Code, *(Dir / FileName)))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Failed to read custom SDF: %s"), *(Dir / FileName));
+				bValid = false;
+				continue;
+			}
+
+			// a checkout with other line endings is no edit
+			Definition.Code.ReplaceInline(TEXT("\r\n"), TEXT("\n"));
+			Definition.Code.TrimEndInline();
+		}
+		return bValid;
+	}
+}
+
+UPSFGenerateCustomSDFsCommandlet::UPSFGenerateCustomSDFsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFGenerateCustomSDFsCommandlet::Main(const FString &Params)
+{
+	FString Dir;
+	FString RemoveList;
+	const bool bHasDir = FParse::Value(*Params, TEXT("Dir="), Dir);
+	FParse::Value(*Params, TEXT("Remove="), RemoveList);
+	if(!bHasDir && RemoveList.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFGenerateCustomSDFs -Dir=<definitions> [-ShaderDir=<Shaders>] [-PackagePath=/Game/SDF] [-Force] [-NoSave] [-Prune] [-Remove=<Name>[,<Name>...]]"));
+		return 1;
+	}
+	TArray<FString> RemoveNames;
+	RemoveList.ParseIntoArray(RemoveNames, TEXT(","));
+
+	FString ShaderDir = FPaths::ProjectDir() / TEXT("Shaders");
+	FString PackagePath = FPSFCustomSDFGenerator::DefaultPackagePath;
+	FParse::Value(*Params, TEXT("ShaderDir="), ShaderDir);
+	FParse::Value(*Params, TEXT("PackagePath="), PackagePath);
+	const bool bForce = FParse::Param(*Params, TEXT("Force"));
+	const bool bSave = !FParse::Param(*Params, TEXT("NoSave"));
+	const bool bPrune = FParse::Param(*Params, TEXT("Prune"));
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// nothing is written unless every definition is valid
+	TArray<FSdfDefinition> Definitions;
+	if(bHasDir && !LoadDefinitions(Dir, Definitions))
+	{
+		return 1;
+	}
+	if(bHasDir && Definitions.Num() == 0 && RemoveNames.Num() == 0)
+	{
+		// also keeps -Prune from emptying the registry because of a wrong path
+		UE_LOG(LogTemp, Warning, TEXT("No custom SDFs (*.hlsl) in %s."), *Dir);
+		return 0;
+	}
+	const auto HasDefinition = [&Definitions](const FString &Name)
+	{
+		return Definitions.ContainsByPredicate([&Name](const FSdfDefinition &Definition) { return Definition.Name.Equals(Name, ESearchCase::CaseSensitive); });
+	};
+	for(const FString &Name : RemoveNames)
+	{
+		if(HasDefinition(Name))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s is to be removed but has a file in %s."), *Name, *Dir);
+			return 1;
+		}
+	}
+
+	FPSFCustomSDFRegistry Registry;
+	const FString RegistryPath = ShaderDir / FPSFCustomSDFRegistry::FileName;
+	if(!Registry.LoadFromJsonFile(RegistryPath))
+	{
+		return 1;
+	}
+
+	TArray<FString> RemovedNames;
+	for(const FString &Name : RemoveNames)
+	{
+		if(!Registry.Remove(Name))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s is not a registered custom SDF."), *Name);
+			continue;
+		}
+		RemovedNames.Add(Name);
+	}
+
+	int32 NumChanged = 0;
+	for(FSdfDefinition &Definition : Definitions)
+	{
+		const FPSFCustomSDF *Existing = Registry.Find(Definition.Name);
+		Definition.bChanged = !Existing || !Existing->Code.Equals(Definition.Code, ESearchCase::CaseSensitive);
+		NumChanged += Definition.bChanged ? 1 : 0;
+		Registry.AddOrUpdate(Definition.Name, Definition.Code);
+	}
+	if(bHasDir)
+	{
+		TArray<FString> UnlistedNames;
+		for(const FPSFCustomSDF &Sdf : Registry.GetEntries())
+		{
+			if(!HasDefinition(Sdf.Name))
+			{
+				UnlistedNames.Add(Sdf.Name);
+				if(!bPrune)
+				{
+					UE_LOG(LogTemp, Display, TEXT("%s (type %d) has no file in %s and is kept as registered."), *Sdf.Name, Sdf.TypeId, *Dir);
+				}
+			}
+		}
+		for(const FString &Name : UnlistedNames)
+		{
+			if(bPrune && Registry.Remove(Name))
+			{
+				RemovedNames.Add(Name);
+			}
+		}
+	}
+	for(const FString &Name : RemovedNames)
+	{
+		// deleting it would break the materials that still use it without a compile error to point there
+		UE_LOG(LogTemp, Warning, TEXT("Removed %s. %s is left in %s, materials that still use it no longer compile."), *Name, *(TEXT("Add") + Name), *PackagePath);
+	}
+
+	if(NumChanged + RemovedNames.Num() > 0 && !Registry.SaveToJsonFile(RegistryPath))
+	{
+		return 1;
+	}
+
+	// one write per shader file for the whole batch
+	bool bShaderChanged = false;
+	if(!FPSFCustomSDFGenerator::WriteShaderFiles(ShaderDir, Registry, bShaderChanged))
+	{
+		return 1;
+	}
+	if(bShaderChanged)
+	{
+		// the shader file cache still holds the old includes
+		FlushShaderFileCache();
+	}
+
+	TArray<UPackage *> PackagesToSave;
+	int32 NumFailed = 0;
+	for(const FSdfDefinition &Definition : Definitions)
+	{
+		const FPSFCustomSDF &Sdf = *Registry.Find(Definition.Name);
+		const FString AssetName = FPSFCustomSDFRegistry::GetMaterialFunctionName(Sdf);
+		if(!Definition.bChanged && !bForce && FPackageName::DoesPackageExist(PackagePath / AssetName))
+		{
+			continue;
+		}
+
+		bool bModified = false;
+		UMaterialFunction *MaterialFunction = FPSFCustomSDFGenerator::UpdateMaterialFunction(Sdf, Definition.bChanged, PackagePath, bModified);
+		if(!MaterialFunction)
+		{
+			++NumFailed;
+			continue;
+		}
+		if(bModified)
+		{
+			PackagesToSave.Add(MaterialFunction->GetPackage());
+		}
+	}
+
+	if(bSave && PackagesToSave.Num() > 0 && !UEditorLoadingAndSavingUtils::SavePackages(PackagesToSave, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to save the material functions."));
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("%d custom SDFs, %d changed, %d removed: shader files %s, %d material functions %s in %.2f s."), Definitions.Num(), NumChanged, RemovedNames.Num(),
+		bShaderChanged ? TEXT("written") : TEXT("unchanged"), PackagesToSave.Num(), bSave ? TEXT("saved") : TEXT("modified"), FPlatformTime::Seconds() - StartTime);
+	if(NumFailed > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%d material functions could not be created."), NumFailed);
+		return 1;
+	}
+	return 0;
+}
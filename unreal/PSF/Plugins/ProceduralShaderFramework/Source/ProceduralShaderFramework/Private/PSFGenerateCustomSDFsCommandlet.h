@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFGenerateCustomSDFsCommandlet.generated.h"
+
+/**
+ * Generates the shader code and the Add<Name> material functions of a directory of custom SDFs in one batch, what the
+ * Generate button of the plugin tab does for a single SDF.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFGenerateCustomSDFs -Dir=<definitions> [-ShaderDir=<Shaders>] [-PackagePath=/Game/SDF] [-Force] [-NoSave] [-Prune]
+ * UnrealEditor-Cmd PSF.uproject -run=PSFGenerateCustomSDFs -Remove=<Name>[,<Name>...] [-ShaderDir=<Shaders>]
+ *
+ * Every <Name>.hlsl in the directory is the body of sd<Name>(float3 probePoint, float time). All SDFs are registered first,
+ * MyCustomSDFs.ush and sdf_functions.ush are then written once, and only if their content changed. Material functions
+ * are only touched for SDFs whose code changed or whose asset is missing (-Force: all of them) and saved afterwards.
+ * SDFs of the registry without a file keep their type id and their code, unless -Prune removes them. -Remove removes
+ * the named SDFs, their type ids are not reused. The Add<Name> assets of removed SDFs are left to the user.
+ */
+UCLASS()
+class UPSFGenerateCustomSDFsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFGenerateCustomSDFsCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFGenerateShadersCommandlet.h"
+#include "PSFShaderGenerator.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UPSFGenerateShadersCommandlet::UPSFGenerateShadersCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFGenerateShadersCommandlet::Main(const FString &Params)
+{
+	// the plugin copy is the canonical source, the project copy also has the user's custom SDFs
+	FString ShaderDir = IPluginManager::Get().FindPlugin(TEXT("ProceduralShaderFramework"))->GetBaseDir() / TEXT("Shaders");
+	FString Root = TEXT("procedural_shader.ush");
+	FString OutDir = FPaths::ProjectSavedDir() / TEXT("ProceduralShaderFramework") / TEXT("Generated");
+	FParse::Value(*Params, TEXT("Dir="), ShaderDir);
+	FParse::Value(*Params, TEXT("Root="), Root);
+	FParse::Value(*Params, TEXT("OutDir="), OutDir);
+
+	FString BackendString = TEXT("unreal,unity,godot,glsl");
+	FString EntryString;
+	FString DefineString;
+	FParse::Value(*Params, TEXT("Backends="), BackendString, false);
+	FParse::Value(*Params, TEXT("Entry="), EntryString, false);
+	FParse::Value(*Params, TEXT("Define="), DefineString, false);
+
+	TArray<FString> BackendNames;
+	TArray<FString> EntryPoints;
+	TArray<FString> Defines;
+	BackendString.ParseIntoArray(BackendNames, TEXT(","));
+	EntryString.ParseIntoArray(EntryPoints, TEXT(","));
+	DefineString.ParseIntoArray(Defines, TEXT(","));
+
+	// an entry point that does not reach a backend is as bad as a missing fast path
+	TArray<FString> FastPaths = FPSFShaderGenerator::GetDefaultFastPaths();
+	FString FastPathString;
+	if(FParse::Value(*Params, TEXT("FastPath="), FastPathString, false))
+	{
+		FastPathString.ParseIntoArray(FastPaths, TEXT(","));
+	}
+	for(const FString &EntryPoint : EntryPoints)
+	{
+		FastPaths.AddUnique(EntryPoint);
+	}
+
+	FPSFShaderGenerator Generator;
+	if(!Generator.LoadFromDirectory(ShaderDir, Root))
+	{
+		return 1;
+	}
+
+	const FString BaseName = FPaths::GetBaseFilename(Root);
+	TArray<FPSFShaderGeneratorResult> Results;
+	int32 Problems = 0;
+	for(const FString &BackendName : BackendNames)
+	{
+		EPSFShaderBackend Backend;
+		if(!FPSFShaderBackendConfig::ParseBackend(BackendName, Backend))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Unknown backend %s, expected unreal, unity, godot or glsl."), *BackendName);
+			return 1;
+		}
+
+		FPSFShaderBackendConfig Config = FPSFShaderBackendConfig::Create(Backend);
+		Config.Defines = Defines;
+		const FPSFShaderGeneratorResult Result = Generator.Generate(Config, EntryPoints, FastPaths);
+		FPSFShaderGenerator::LogResult(Result);
+		Problems += Result.HasProblems(Config) ? 1 : 0;
+
+		const FString OutPath = OutDir / BaseName + TEXT(".") + FPSFShaderBackendConfig::GetExtension(Backend);
+		if(!FFileHelper::SaveStringToFile(Result.Code, *OutPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write generated shader to: %s"), *OutPath);
+			return 1;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Generated shader written to: %s"), *OutPath);
+		Results.Add(Result);
+	}
+
+	FString ReportPath;
+	if(FParse::Value(*Params, TEXT("Report="), ReportPath) && !FFileHelper::SaveStringToFile(FPSFShaderGenerator::ToJsonString(Results), *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write generator report: %s"), *ReportPath);
+		return 1;
+	}
+
+	if(FParse::Param(*Params, TEXT("Check")) && Problems > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%d backends miss a fast path or left a conditional unresolved."), Problems);
+		return 1;
+	}
+	return 0;
+}
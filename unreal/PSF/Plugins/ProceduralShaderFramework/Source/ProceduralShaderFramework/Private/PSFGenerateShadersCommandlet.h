@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFGenerateShadersCommandlet.generated.h"
+
+/**
+ * Generates the Unreal, Unity, Godot and GLSL shader libraries from the plugin's .ush files and reports per backend
+ * what specialization removed and whether the fast paths (the entry points and -FastPath=) made it into the output.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFGenerateShaders [-Backends=unreal,unity,godot,glsl] [-Entry=<function,...>]
+ *     [-Define=NAME=VALUE,...] [-Dir=<Shaders>] [-Root=procedural_shader.ush] [-OutDir=<Saved/ProceduralShaderFramework/Generated>]
+ *     [-FastPath=<function,...>] [-Report=<report.json>] [-Check]
+ */
+UCLASS()
+class UPSFGenerateShadersCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFGenerateShadersCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
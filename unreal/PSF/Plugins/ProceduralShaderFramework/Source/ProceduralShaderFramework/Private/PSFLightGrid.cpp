@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFLightGrid.h"
+#include "Engine/Texture2D.h"
+
+namespace
+{
+	/** Tiles a light was binned into, inclusive */
+	struct FLightRect
+	{
+		int32 Light;
+		int32 MinX;
+		int32 MaxX;
+		int32 MinY;
+		int32 MaxY;
+	};
+
+	/**
+	 * Whether a sphere touches the wedge of view directions between Lo and Hi along one screen axis.
+	 * A is the camera space coordinate of the center along that axis and Z along the view axis (the camera looks down -Z),
+	 * the wedge is bounded by the planes through the eye with the normals (1, Lo) and (-1, -Hi).
+	 */
+	FORCEINLINE bool TouchesWedge(float A, float Z, float Radius, float Lo, float Hi)
+	{
+		return A + Lo * Z >= -Radius * FMath::Sqrt(1.0f + Lo * Lo) && -A - Hi * Z >= -Radius * FMath::Sqrt(1.0f + Hi * Hi);
+	}
+
+	/** First and last wedge between consecutive edges that the sphere touches, false if none */
+	bool FindWedgeRange(float A, float Z, float Radius, const TArray<float> &Edges, bool bDescending, int32 &OutMin, int32 &OutMax)
+	{
+		OutMin = INDEX_NONE;
+		OutMax = INDEX_NONE;
+		for(int32 Index = 0; Index + 1 < Edges.Num(); ++Index)
+		{
+			const float Lo = bDescending ? Edges[Index + 1] : Edges[Index];
+			const float Hi = bDescending ? Edges[Index] : Edges[Index + 1];
+			if(TouchesWedge(A, Z, Radius, Lo, Hi))
+			{
+				OutMin = OutMin == INDEX_NONE ? Index : OutMin;
+				OutMax = Index;
+			}
+		}
+		return OutMin != INDEX_NONE;
+	}
+}
+
+void FPSFLightGrid::Build(const TArray<FPSFPointLight> &InLights, const FVector3f &RayOrigin, const FPSFMatrix3 &CameraMatrix, int32 Width, int32 Height, int32 TileSize)
+{
+	Lights = InLights;
+	Tiles.Reset();
+	LightIndices.Reset();
+	VisibleLights = 0;
+
+	TileSize = FMath::Max(1, TileSize);
+	TilesX = Width > 0 ? FMath::DivideAndRoundUp(Width, TileSize) : 0;
+	TilesY = Height > 0 ? FMath::DivideAndRoundUp(Height, TileSize) : 0;
+	TilesPerUV = FVector2f(float(Width) / TileSize, float(Height) / TileSize);
+	Tiles.SetNum(TilesX * TilesY);
+	if(Tiles.Num() == 0)
+	{
+		return;
+	}
+
+	// tile edges in the uv of computeUV: x runs from -1 to 1, y from 1 (top row) to -1
+	TArray<float> ColumnEdges;
+	TArray<float> RowEdges;
+	for(int32 X = 0; X <= TilesX; ++X)
+	{
+		ColumnEdges.Add(FMath::Min(-1.0f + 2.0f * X * TileSize / Width, 1.0f));
+	}
+	for(int32 Y = 0; Y <= TilesY; ++Y)
+	{
+		RowEdges.Add(FMath::Max(1.0f - 2.0f * Y * TileSize / Height, -1.0f));
+	}
+
+	// a pixel's ray is mul(float3(uv, -1), cameraMatrix), the rows of the camera matrix are the camera space axes
+	TArray<FLightRect> Rects;
+	for(int32 LightIndex = 0; LightIndex < Lights.Num(); ++LightIndex)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		const FVector3f Offset = Light.Position - RayOrigin;
+		const FVector3f Center(Offset | CameraMatrix.Rows[0], Offset | CameraMatrix.Rows[1], Offset | CameraMatrix.Rows[2]);
+		if(Light.Radius <= 0.0f || Center.Z > Light.Radius)
+		{
+			continue;
+		}
+
+		FLightRect Rect;
+		Rect.Light = LightIndex;
+		if(FindWedgeRange(Center.X, Center.Z, Light.Radius, ColumnEdges, false, Rect.MinX, Rect.MaxX)
+			&& FindWedgeRange(Center.Y, Center.Z, Light.Radius, RowEdges, true, Rect.MinY, Rect.MaxY))
+		{
+			Rects.Add(Rect);
+			for(int32 Y = Rect.MinY; Y <= Rect.MaxY; ++Y)
+			{
+				for(int32 X = Rect.MinX; X <= Rect.MaxX; ++X)
+				{
+					++Tiles[Y * TilesX + X].LightCount;
+				}
+			}
+		}
+	}
+	VisibleLights = Rects.Num();
+
+	// counts to offsets, then fill every tile in light order so the lists match the unculled loop
+	int32 Total = 0;
+	for(FPSFLightTile &Tile : Tiles)
+	{
+		Tile.FirstIndex = Total;
+		Total += Tile.LightCount;
+		Tile.LightCount = 0;
+	}
+	LightIndices.SetNumUninitialized(Total);
+	for(const FLightRect &Rect : Rects)
+	{
+		for(int32 Y = Rect.MinY; Y <= Rect.MaxY; ++Y)
+		{
+			for(int32 X = Rect.MinX; X <= Rect.MaxX; ++X)
+			{
+				FPSFLightTile &Tile = Tiles[Y * TilesX + X];
+				LightIndices[Tile.FirstIndex + Tile.LightCount++] = Rect.Light;
+			}
+		}
+	}
+}
+
+void FPSFLightGrid::BuildUnculled(const TArray<FPSFPointLight> &InLights)
+{
+	Lights = InLights;
+	TilesX = 1;
+	TilesY = 1;
+	TilesPerUV = FVector2f(1.0f, 1.0f);
+	VisibleLights = Lights.Num();
+
+	LightIndices.SetNumUninitialized(Lights.Num());
+	for(int32 LightIndex = 0; LightIndex < Lights.Num(); ++LightIndex)
+	{
+		LightIndices[LightIndex] = LightIndex;
+	}
+
+	Tiles.SetNum(1);
+	Tiles[0].FirstIndex = 0;
+	Tiles[0].LightCount = Lights.Num();
+}
+
+TConstArrayView<int32> FPSFLightGrid::GetTileLights(const FVector2f &ScreenUV) const
+{
+	if(Tiles.Num() == 0)
+	{
+		return TConstArrayView<int32>();
+	}
+
+	const int32 X = FMath::Clamp(FMath::FloorToInt(ScreenUV.X * TilesPerUV.X), 0, TilesX - 1);
+	const int32 Y = FMath::Clamp(FMath::FloorToInt(ScreenUV.Y * TilesPerUV.Y), 0, TilesY - 1);
+	const FPSFLightTile &Tile = Tiles[Y * TilesX + X];
+	return TConstArrayView<int32>(LightIndices.GetData() + Tile.FirstIndex, Tile.LightCount);
+}
+
+int32 FPSFLightGrid::GetMaxLightsPerTile() const
+{
+	int32 MaxLights = 0;
+	for(const FPSFLightTile &Tile : Tiles)
+	{
+		MaxLights = FMath::Max(MaxLights, Tile.LightCount);
+	}
+	return MaxLights;
+}
+
+void FPSFLightGrid::Pack(TArray<FVector4f> &OutTexels) const
+{
+	const int32 TileOffset = 2 + 2 * Lights.Num();
+	const int32 IndexOffset = TileOffset + (Tiles.Num() + 1) / 2;
+	const int32 NumTexels = IndexOffset + (LightIndices.Num() + 3) / 4;
+	const int32 NumRows = FMath::Max(1, FMath::DivideAndRoundUp(NumTexels, TextureWidth));
+
+	OutTexels.Reset(NumRows * TextureWidth);
+	OutTexels.SetNumZeroed(NumRows * TextureWidth);
+	OutTexels[0] = FVector4f(TilesX, TilesY, Lights.Num(), 0.0f);
+	OutTexels[1] = FVector4f(TilesPerUV.X, TilesPerUV.Y, 0.0f, 0.0f);
+
+	for(int32 LightIndex = 0; LightIndex < Lights.Num(); ++LightIndex)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		OutTexels[2 + 2 * LightIndex] = FVector4f(Light.Position, Light.Radius);
+		OutTexels[3 + 2 * LightIndex] = FVector4f(Light.Color * Light.Intensity, 0.0f);
+	}
+
+	for(int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex)
+	{
+		FVector4f &Texel = OutTexels[TileOffset + TileIndex / 2];
+		const int32 Component = (TileIndex % 2) * 2;
+		Texel[Component] = Tiles[TileIndex].FirstIndex;
+		Texel[Component + 1] = Tiles[TileIndex].LightCount;
+	}
+
+	for(int32 Index = 0; Index < LightIndices.Num(); ++Index)
+	{
+		OutTexels[IndexOffset + Index / 4][Index % 4] = LightIndices[Index];
+	}
+}
+
+UTexture2D *FPSFLightGrid::UpdateTexture(UTexture2D *Texture) const
+{
+	TArray<FVector4f> *Texels = new TArray<FVector4f>();
+	Pack(*Texels);
+	const int32 NumRows = Texels->Num() / TextureWidth;
+
+	if(!Texture || Texture->GetSizeX() != TextureWidth || Texture->GetSizeY() < NumRows)
+	{
+		Texture = UTexture2D::CreateTransient(TextureWidth, FMath::RoundUpToPowerOfTwo(NumRows), PF_A32B32G32R32F);
+		Texture->Filter = TF_Nearest;
+		Texture->SRGB = false;
+		Texture->CompressionSettings = TC_HDR;
+		Texture->NeverStream = true;
+		Texture->UpdateResource();
+	}
+
+	// the render thread reads the data later, it owns the copy and the region until the upload is done
+	FUpdateTextureRegion2D *Region = new FUpdateTextureRegion2D(0, 0, 0, 0, TextureWidth, NumRows);
+	Texture->UpdateTextureRegions(0, 1, Region, TextureWidth * sizeof(FVector4f), sizeof(FVector4f), reinterpret_cast<uint8 *>(Texels->GetData()),
+		[Texels](uint8 *, const FUpdateTextureRegion2D *Regions)
+		{
+			delete Texels;
+			delete Regions;
+		});
+	return Texture;
+}
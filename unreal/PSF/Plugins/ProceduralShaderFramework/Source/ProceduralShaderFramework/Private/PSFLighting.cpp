@@ -0,0 +1,524 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFLighting.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	const FVector3f WhiteLight(1.0f, 1.0f, 1.0f);
+	const FVector3f DefaultAmbient(0.05f, 0.05f, 0.05f);
+
+	FORCEINLINE bool IsMiss(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition)
+	{
+		return HitPosition.W > Globals.RaymarchStoppingCriterium;
+	}
+
+	FORCEINLINE FVector3f HitPoint(const FVector4f &HitPosition)
+	{
+		return FVector3f(HitPosition.X, HitPosition.Y, HitPosition.Z);
+	}
+}
+
+FPSFSunriseLight FPSFSunriseLight::Make(float Time)
+{
+	FPSFSunriseLight Sunrise;
+	Sunrise.SunDir = Normalize(FVector3f(0.5f, 0.4f * (1.0f + FMath::Sin(0.5f * Time)), -1.0f));
+	Sunrise.EarthCenter = FVector3f(0.0f, -6360e3f, 0.0f);
+	Sunrise.EarthRadius = 6360e3f;
+	Sunrise.AtmosphereRadius = 6380e3f;
+	Sunrise.SunIntensity = 10.0f;
+	return Sunrise;
+}
+
+FVector3f PSFLighting::ApplyPhongLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f LightDir = Normalize(LightPosition - HitPoint(HitPosition));
+
+	const float Diff = FMath::Max(Normal | LightDir, 0.0f);
+	const FVector3f R = Reflect(-LightDir, Normal);
+	const float Spec = FMath::Pow(FMath::Max(R | ViewDir, 0.0f), Material.Shininess);
+
+	const FVector3f Diffuse = Diff * Material.BaseColor * WhiteLight;
+	const FVector3f Specular = Spec * Material.SpecularColor * Material.SpecularStrength;
+	return DefaultAmbient + Diffuse + Specular;
+}
+
+FVector3f PSFLighting::ApplyLambertLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f LightDirection = Normalize(LightPosition - HitPoint(HitPosition));
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+	return DefaultAmbient + DiffuseValue * WhiteLight;
+}
+
+FVector3f PSFLighting::ApplyBlinnPhongLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f LightDir = Normalize(LightPosition - HitPoint(HitPosition));
+
+	const float Diff = FMath::Max(Normal | LightDir, 0.0f);
+	const FVector3f H = Normalize(LightDir + ViewDir);
+	const float Spec = FMath::Pow(FMath::Max(Normal | H, 0.0f), Material.Shininess);
+
+	const FVector3f Diffuse = Diff * Material.BaseColor * WhiteLight;
+	const FVector3f Specular = Spec * Material.SpecularColor * Material.SpecularStrength;
+	return DefaultAmbient + Diffuse + Specular;
+}
+
+FVector3f PSFLighting::ApplyFakeSpecular(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f LightDir = Normalize(LightPosition - HitPoint(HitPosition));
+
+	const FVector3f H = Normalize(LightDir + ViewDir);
+	const float Highlight = FMath::Pow(FMath::Max(Normal | H, 0.0f), Material.FakeSpecularPower);
+	return Highlight * Material.FakeSpecularColor * WhiteLight;
+}
+
+FVector3f PSFLighting::LambertDiffuse(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f LightDir = Normalize(LightPosition - HitPoint(HitPosition));
+	const float Diff = FMath::Max(Normal | LightDir, 0.0f);
+	return Material.BaseColor * WhiteLight * Diff;
+}
+
+FVector3f PSFLighting::ApplyToonLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f LightDirection = Normalize(LightPosition - HitPoint(HitPosition));
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+
+	const float Step1 = 0.3f;
+	const float Step2 = 0.6f;
+	const float Step3 = 0.9f;
+
+	const float ToonDiff =
+		DiffuseValue > Step3 ? 1.0f :
+		DiffuseValue > Step2 ? 0.7f :
+		DiffuseValue > Step1 ? 0.4f : 0.1f;
+
+	return DefaultAmbient + ToonDiff * Material.BaseColor * WhiteLight;
+}
+
+FVector3f PSFLighting::CookTorranceLighting(const FVector3f &N, const FVector3f &V, const FVector3f &L, const FPSFMaterialParams &Material)
+{
+	const FVector3f H = Normalize(L + V);
+	const FVector3f F0 = Lerp(FVector3f(0.04f), Material.BaseColor, Material.Metallic);
+
+	const float NDF = FMath::Pow(Material.Roughness + 1.0f, 2.0f);
+	const float A = NDF * NDF;
+	const float A2 = A * A;
+
+	// GGX Normal Distribution Function (D)
+	const float NdotH = FMath::Max(N | H, 0.0f);
+	const float D = A2 / (PI * FMath::Pow((NdotH * NdotH) * (A2 - 1.0f) + 1.0f, 2.0f));
+
+	// Fresnel Schlick approximation (F)
+	const float HdotV = FMath::Max(H | V, 0.0f);
+	const FVector3f F = F0 + (FVector3f(1.0f) - F0) * FMath::Pow(1.0f - HdotV, 5.0f);
+
+	// Smith's Geometry Function (G)
+	const float NdotV = FMath::Max(N | V, 0.0f);
+	const float NdotL = FMath::Max(N | L, 0.0f);
+	const float K = FMath::Pow(Material.Roughness + 1.0f, 2.0f) / 8.0f;
+	const float GV = NdotV / (NdotV * (1.0f - K) + K);
+	const float GL = NdotL / (NdotL * (1.0f - K) + K);
+	const float G = GV * GL;
+
+	// Cook-Torrance BRDF
+	const FVector3f Specular = (D * F * G) / (4.0f * NdotL * NdotV + 0.001f);
+
+	// Diffuse (non-metallic only)
+	const FVector3f Kd = (FVector3f(1.0f) - F) * (1.0f - Material.Metallic);
+	const FVector3f Diffuse = Kd * Material.BaseColor / PI;
+
+	return (Diffuse + Specular) * NdotL;
+}
+
+FVector3f PSFLighting::ApplyPBRLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	const FVector3f N = Normalize(Normal);
+	const FVector3f V = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f L = Normalize(LightPosition - HitPoint(HitPosition));
+	return CookTorranceLighting(N, V, L, Material) * WhiteLight;
+}
+
+FVector3f PSFLighting::ApplyRimLighting(const FPSFShaderGlobals &Globals, const FVector3f &RimColor, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const float Rim = FMath::Pow(1.0f - FMath::Max(Normal | ViewDir, 0.0f), Material.RimPower);
+	return Rim * RimColor;
+}
+
+FVector3f PSFLighting::ApplySoftSSLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	const FVector3f LightDirection = Normalize(LightPosition - HitPoint(HitPosition));
+
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+	const float BackLight = FMath::Max(-Normal | LightDirection, 0.0f);
+
+	const FVector3f SssColor(1.0f, 0.5f, 0.5f);
+	const FVector3f DiffuseColor = DiffuseValue * Material.BaseColor * WhiteLight;
+	const FVector3f Sss = BackLight * SssColor * 0.25f;
+
+	return DefaultAmbient + DiffuseColor + Sss;
+}
+
+FVector3f PSFLighting::ApplyFresnelLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDirection = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const float Fresnel = FMath::Pow(1.0f - Saturate(ViewDirection | Normal), 3.0f);
+	const float RimStrength = 1.2f;
+
+	return DefaultAmbient + Material.BaseColor * WhiteLight + RimStrength * Fresnel * Material.SpecularColor;
+}
+
+FVector3f PSFLighting::ApplyUVGradientLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const FVector2f &UV)
+{
+	const FVector3f LightDirection = Normalize(LightPosition - HitPoint(HitPosition));
+	const FVector3f AmbientColor(0.1f, 0.1f, 0.1f);
+
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+	const FVector3f GradientColor = Lerp(FVector3f(0.2f, 0.4f, 0.9f), FVector3f(1.0f, 0.6f, 0.0f), UV.Y);
+
+	return AmbientColor + DiffuseValue * GradientColor * WhiteLight;
+}
+
+FVector3f PSFLighting::ApplyUVAnisotropicLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const FVector2f &UV)
+{
+	const FVector3f ViewDirection = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f LightDirection = Normalize(LightPosition - HitPoint(HitPosition));
+	const FVector3f HalfVec = Normalize(ViewDirection + LightDirection);
+
+	const float Angle = UV.X * 6.2831853f;
+	const FVector3f LocalTangent(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f);
+	const FVector3f Tangent = Normalize(LocalTangent - Normal * (LocalTangent | Normal));
+	const FVector3f Bitangent = Normal ^ Tangent;
+
+	const float TdotH = Tangent | HalfVec;
+	const float BdotH = Bitangent | HalfVec;
+	const float SpectralAnisotropic = FMath::Pow(TdotH * TdotH + BdotH * BdotH, 8.0f);
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+
+	const FVector3f AmbientColor(0.1f, 0.1f, 0.1f);
+	return AmbientColor + DiffuseValue * Material.BaseColor + SpectralAnisotropic * Material.SpecularColor;
+}
+
+FVector2f PSFLighting::DensitiesRM(const FVector3f &Position, const FPSFSunriseLight &Light)
+{
+	const float H = FMath::Max(0.0f, (Position - Light.EarthCenter).Size() - Light.EarthRadius);
+	return FVector2f(FMath::Exp(-H / 8e3f), FMath::Exp(-H / 12e2f));
+}
+
+float PSFLighting::Escape(const FVector3f &Position, const FVector3f &Direction, float AtmosphereRadius, const FVector3f &EarthCenter)
+{
+	const FVector3f V = Position - EarthCenter;
+	const float B = V | Direction;
+	float Det = B * B - (V | V) + AtmosphereRadius * AtmosphereRadius;
+	if(Det < 0.0f)
+	{
+		return -1.0f;
+	}
+	Det = FMath::Sqrt(Det);
+	const float T1 = -B - Det;
+	const float T2 = -B + Det;
+	return T1 >= 0.0f ? T1 : T2;
+}
+
+FVector2f PSFLighting::ScatterDepthInt(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, float Steps, const FPSFSunriseLight &Light)
+{
+	FVector2f DepthRMs(0.0f, 0.0f);
+	AtmosphericDistance /= Steps;
+	Direction *= AtmosphericDistance;
+
+	for(float I = 0.0f; I < Steps; ++I)
+	{
+		DepthRMs += DensitiesRM(Position + Direction * I, Light);
+	}
+
+	return DepthRMs * AtmosphericDistance;
+}
+
+void PSFLighting::SunriseInScattering(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, const FPSFSunriseLight &Light, FVector2f &OutDepthRM, FVector3f &OutRayleigh, FVector3f &OutMie)
+{
+	const FVector3f BR(58e-7f, 135e-7f, 331e-7f); // Rayleigh scattering coefficient
+	const FVector3f BMe = FVector3f(2e-5f, 2e-5f, 2e-5f) * 1.1f;
+	OutDepthRM = FVector2f(0.0f, 0.0f);
+	OutRayleigh = FVector3f::ZeroVector;
+	OutMie = FVector3f::ZeroVector;
+	AtmosphericDistance /= 16.0f;
+	Direction *= AtmosphericDistance;
+
+	for(float I = 0.0f; I < 16.0f; ++I)
+	{
+		const FVector3f CurrentPosition = Position + Direction * I;
+		const FVector2f DRM = DensitiesRM(CurrentPosition, Light) * AtmosphericDistance;
+		OutDepthRM += DRM;
+		const FVector2f DepthRMSum = OutDepthRM + ScatterDepthInt(CurrentPosition, Light.SunDir, Escape(CurrentPosition, Light.SunDir, Light.AtmosphereRadius, Light.EarthCenter), 4.0f, Light);
+		const FVector3f A = Exp(-BR * DepthRMSum.X - BMe * DepthRMSum.Y);
+		OutRayleigh += A * DRM.X;
+		OutMie += A * DRM.Y;
+	}
+}
+
+FVector3f PSFLighting::ApplySunriseLighting(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, const FVector3f &Lo, const FPSFSunriseLight &Light)
+{
+	const FVector3f BR(58e-7f, 135e-7f, 331e-7f); // Rayleigh scattering coefficient
+	const FVector3f BMs(2e-5f, 2e-5f, 2e-5f); // Mie scattering coefficients
+	const FVector3f BMe = BMs * 1.1f;
+
+	FVector2f TotalDepthRM;
+	FVector3f IR, IM;
+	SunriseInScattering(Position, Direction, AtmosphericDistance, Light, TotalDepthRM, IR, IM);
+
+	const float Mu = Direction | Light.SunDir;
+	return Lo + Lo * Exp(-BR * TotalDepthRM.X - BMe * TotalDepthRM.Y)
+		+ Light.SunIntensity * (1.0f + Mu * Mu) * (
+			IR * BR * 0.0597f +
+			IM * BMs * 0.0196f / FMath::Pow(1.58f - 1.52f * Mu, 1.5f));
+}
+
+FVector3f PSFLighting::AddSunriseLight(const FPSFShaderGlobals &Globals, float Time, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, const FVector3f &RayDirection)
+{
+	const FPSFSunriseLight Sunrise = FPSFSunriseLight::Make(Time);
+
+	const float AtmosphereDist = Escape(HitPoint(HitPosition), RayDirection, Sunrise.AtmosphereRadius, Sunrise.EarthCenter);
+	const FVector3f LightColor = ApplySunriseLighting(HitPoint(HitPosition), RayDirection, AtmosphereDist, FVector3f::ZeroVector, Sunrise);
+
+	if(IsMiss(Globals, HitPosition))
+	{
+		return LightColor;
+	}
+
+	const FVector3f LightDirection = Sunrise.SunDir;
+	const FVector3f ViewDirection = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	const FVector3f ReflectedDirection = Reflect(-LightDirection, Normal);
+
+	const float DiffuseValue = FMath::Max(Normal | LightDirection, 0.0f);
+	const float SpecularValue = FMath::Pow(FMath::Max(ReflectedDirection | ViewDirection, 0.0f), Material.Shininess);
+
+	const FVector3f DiffuseColor = DiffuseValue * (0.5f * Material.BaseColor + 0.5f * LightColor);
+	const FVector3f SpecularColor = SpecularValue * Material.SpecularColor * Material.SpecularStrength;
+	return DiffuseColor + SpecularColor;
+}
+
+float PSFLighting::PointLightAttenuation(float Distance, float Radius)
+{
+	const float X = Distance / FMath::Max(Radius, 1e-4f);
+	const float Window = FMath::Clamp(1.0f - X * X, 0.0f, 1.0f);
+	return Window * Window / (1.0f + Distance * Distance);
+}
+
+FVector3f PSFLighting::ApplyPhongLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal,
+	const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	FVector3f LightingColor = DefaultAmbient;
+	for(const int32 LightIndex : LightIndices)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		const FVector3f ToLight = Light.Position - HitPoint(HitPosition);
+		const float Attenuation = PointLightAttenuation(ToLight.Size(), Light.Radius);
+		if(Attenuation <= 0.0f)
+		{
+			continue;
+		}
+
+		const FVector3f LightDir = Normalize(ToLight);
+		const float Diff = FMath::Max(Normal | LightDir, 0.0f);
+		const FVector3f R = Reflect(-LightDir, Normal);
+		const float Spec = FMath::Pow(FMath::Max(R | ViewDir, 0.0f), Material.Shininess);
+		LightingColor += (Diff * Material.BaseColor + Spec * Material.SpecularColor * Material.SpecularStrength) * Light.Color * Light.Intensity * Attenuation;
+	}
+	return LightingColor;
+}
+
+FVector3f PSFLighting::ApplyLambertLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &Normal,
+	const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	FVector3f LightingColor = DefaultAmbient;
+	for(const int32 LightIndex : LightIndices)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		const FVector3f ToLight = Light.Position - HitPoint(HitPosition);
+		const float Attenuation = PointLightAttenuation(ToLight.Size(), Light.Radius);
+		if(Attenuation <= 0.0f)
+		{
+			continue;
+		}
+
+		const float DiffuseValue = FMath::Max(Normal | Normalize(ToLight), 0.0f);
+		LightingColor += DiffuseValue * Light.Color * Light.Intensity * Attenuation;
+	}
+	return LightingColor;
+}
+
+FVector3f PSFLighting::ApplyBlinnPhongLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal,
+	const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f ViewDir = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	FVector3f LightingColor = DefaultAmbient;
+	for(const int32 LightIndex : LightIndices)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		const FVector3f ToLight = Light.Position - HitPoint(HitPosition);
+		const float Attenuation = PointLightAttenuation(ToLight.Size(), Light.Radius);
+		if(Attenuation <= 0.0f)
+		{
+			continue;
+		}
+
+		const FVector3f LightDir = Normalize(ToLight);
+		const float Diff = FMath::Max(Normal | LightDir, 0.0f);
+		const FVector3f H = Normalize(LightDir + ViewDir);
+		const float Spec = FMath::Pow(FMath::Max(Normal | H, 0.0f), Material.Shininess);
+		LightingColor += (Diff * Material.BaseColor + Spec * Material.SpecularColor * Material.SpecularStrength) * Light.Color * Light.Intensity * Attenuation;
+	}
+	return LightingColor;
+}
+
+FVector3f PSFLighting::ApplyPBRLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal,
+	const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices)
+{
+	if(IsMiss(Globals, HitPosition))
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const FVector3f N = Normalize(Normal);
+	const FVector3f V = Normalize(Globals.RayOrigin - HitPoint(HitPosition));
+	FVector3f LightingColor = FVector3f::ZeroVector;
+	for(const int32 LightIndex : LightIndices)
+	{
+		const FPSFPointLight &Light = Lights[LightIndex];
+		const FVector3f ToLight = Light.Position - HitPoint(HitPosition);
+		const float Attenuation = PointLightAttenuation(ToLight.Size(), Light.Radius);
+		if(Attenuation <= 0.0f)
+		{
+			continue;
+		}
+
+		LightingColor += CookTorranceLighting(N, V, Normalize(ToLight), Material) * Light.Color * Light.Intensity * Attenuation;
+	}
+	return LightingColor;
+}
+
+bool PSFLighting::ShadeTiled(const FPSFScene &Scene, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, TConstArrayView<int32> LightIndices,
+	FVector3f &OutColor)
+{
+	FPSFShaderGlobals Globals;
+	Globals.RayOrigin = Scene.RayOrigin;
+	Globals.RaymarchStoppingCriterium = Scene.RaymarchStoppingCriterium;
+
+	switch(Scene.LightingModel)
+	{
+	case EPSFLightingModel::Phong:
+		OutColor = ApplyPhongLightingTiled(Globals, HitPosition, Material, Normal, Scene.PointLights, LightIndices);
+		return true;
+	case EPSFLightingModel::Lambert:
+		OutColor = ApplyLambertLightingTiled(Globals, HitPosition, Normal, Scene.PointLights, LightIndices);
+		return true;
+	case EPSFLightingModel::BlinnPhong:
+		OutColor = ApplyBlinnPhongLightingTiled(Globals, HitPosition, Material, Normal, Scene.PointLights, LightIndices);
+		return true;
+	case EPSFLightingModel::PBR:
+		OutColor = ApplyPBRLightingTiled(Globals, HitPosition, Material, Normal, Scene.PointLights, LightIndices);
+		return true;
+	default:
+		return false;
+	}
+}
+
+FVector3f PSFLighting::Shade(const FPSFScene &Scene, float Time, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, const FVector3f &RayDirection, const FVector2f &UV)
+{
+	FPSFShaderGlobals Globals;
+	Globals.RayOrigin = Scene.RayOrigin;
+	Globals.RaymarchStoppingCriterium = Scene.RaymarchStoppingCriterium;
+
+	// the functions without a miss check would shade garbage on background pixels, renderScene masks those in the engine
+	const bool bMiss = IsMiss(Globals, HitPosition);
+	const FVector3f &Light = Scene.LightPosition;
+
+	switch(Scene.LightingModel)
+	{
+	case EPSFLightingModel::Phong:
+		return ApplyPhongLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::Lambert:
+		return ApplyLambertLighting(Globals, HitPosition, Light, Normal);
+	case EPSFLightingModel::BlinnPhong:
+		return ApplyBlinnPhongLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::FakeSpecular:
+		return ApplyFakeSpecular(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::LambertDiffuse:
+		return LambertDiffuse(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::Toon:
+		return ApplyToonLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::PBR:
+		return bMiss ? FVector3f::ZeroVector : ApplyPBRLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::Rim:
+		return bMiss ? FVector3f::ZeroVector : ApplyRimLighting(Globals, Scene.RimColor, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::SoftSS:
+		return bMiss ? FVector3f::ZeroVector : ApplySoftSSLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::Fresnel:
+		return ApplyFresnelLighting(Globals, HitPosition, Light, Material, Normal);
+	case EPSFLightingModel::UVGradient:
+		return bMiss ? FVector3f::ZeroVector : ApplyUVGradientLighting(Globals, HitPosition, Light, Material, Normal, UV);
+	case EPSFLightingModel::UVAnisotropic:
+		return bMiss ? FVector3f::ZeroVector : ApplyUVAnisotropicLighting(Globals, HitPosition, Light, Material, Normal, UV);
+	case EPSFLightingModel::Sunrise:
+		return AddSunriseLight(Globals, Time, HitPosition, Normal, Material, RayDirection);
+	default:
+		return bMiss ? FVector3f::ZeroVector : Material.BaseColor;
+	}
+}
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFMarchProfile.h"
+#include "PSFSdfFunctions.h"
+#include "HAL/PlatformTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	// evaluations per SDF of MeasureEvaluationCost, on a lattice of SamplesPerAxis^3 points around its position
+	const int32 SamplesPerAxis = 16;
+	const float SampleExtent = 2.0f;
+
+	/** Mirrors debugHeatmap */
+	FLinearColor Heatmap(float Value)
+	{
+		const float V = FMath::Clamp(Value, 0.0f, 1.0f);
+		return FLinearColor(FMath::Clamp(1.5f - FMath::Abs(4.0f * V - 3.0f), 0.0f, 1.0f), FMath::Clamp(1.5f - FMath::Abs(4.0f * V - 2.0f), 0.0f, 1.0f),
+			FMath::Clamp(1.5f - FMath::Abs(4.0f * V - 1.0f), 0.0f, 1.0f), 1.0f);
+	}
+
+	int32 GetCounter(const FPSFMarchCounters &Counters, EPSFDebugView View)
+	{
+		switch(View)
+		{
+		case EPSFDebugView::Evaluations:
+			return Counters.SdfEvaluations;
+		case EPSFDebugView::Dolphins:
+			return Counters.DolphinEvaluations;
+		default:
+			return Counters.Steps;
+		}
+	}
+}
+
+void FPSFMarchProfile::MeasureEvaluationCost(const FPSFScene &Scene, float Time)
+{
+	Sdfs.SetNum(Scene.SDFs.Num());
+	for(int32 SdfIndex = 0; SdfIndex < Scene.SDFs.Num(); ++SdfIndex)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[SdfIndex];
+
+		// the sum keeps the compiler from dropping the evaluations
+		volatile float Sink = 0.0f;
+		float Sum = 0.0f;
+		const double StartTime = FPlatformTime::Seconds();
+		for(int32 Z = 0; Z < SamplesPerAxis; ++Z)
+		{
+			for(int32 Y = 0; Y < SamplesPerAxis; ++Y)
+			{
+				for(int32 X = 0; X < SamplesPerAxis; ++X)
+				{
+					const FVector3f Offset = (FVector3f(X, Y, Z) / (SamplesPerAxis - 1) * 2.0f - FVector3f(1.0f, 1.0f, 1.0f)) * SampleExtent;
+					Sum += PSFSdf::EvalSDF(Sdf, Sdf.Position + Offset, Time);
+				}
+			}
+		}
+		const double Seconds = FPlatformTime::Seconds() - StartTime;
+		Sink = Sum;
+		Sdfs[SdfIndex].NanosecondsPerEvaluation = Seconds * 1e9 / (SamplesPerAxis * SamplesPerAxis * SamplesPerAxis);
+	}
+}
+
+int64 FPSFMarchProfile::CountExits(EPSFMarchExit Exit) const
+{
+	int64 Count = 0;
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		Count += Counters.Exit == Exit ? 1 : 0;
+	}
+	return Count;
+}
+
+int64 FPSFMarchProfile::GetTotalSteps() const
+{
+	int64 Total = 0;
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		Total += Counters.Steps;
+	}
+	return Total;
+}
+
+int64 FPSFMarchProfile::GetTotalEvaluations() const
+{
+	int64 Total = 0;
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		Total += Counters.SdfEvaluations;
+	}
+	return Total;
+}
+
+int64 FPSFMarchProfile::GetTotalDolphinEvaluations() const
+{
+	int64 Total = 0;
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		Total += Counters.DolphinEvaluations;
+	}
+	return Total;
+}
+
+int32 FPSFMarchProfile::GetMaxValue(EPSFDebugView View) const
+{
+	int32 MaxValue = 0;
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		MaxValue = FMath::Max(MaxValue, GetCounter(Counters, View));
+	}
+	return MaxValue;
+}
+
+TArray<int32> FPSFMarchProfile::GetHistogram(EPSFDebugView View, int32 NumBuckets, int32 MaxValue) const
+{
+	TArray<int32> Buckets;
+	Buckets.SetNumZeroed(FMath::Max(1, NumBuckets));
+	const double BucketsPerValue = double(Buckets.Num()) / FMath::Max(1, MaxValue);
+	for(const FPSFMarchCounters &Counters : Pixels)
+	{
+		++Buckets[FMath::Clamp(int32(GetCounter(Counters, View) * BucketsPerValue), 0, Buckets.Num() - 1)];
+	}
+	return Buckets;
+}
+
+int32 FPSFMarchProfile::GetCostliestSdf() const
+{
+	int32 Costliest = INDEX_NONE;
+	for(int32 SdfIndex = 0; SdfIndex < Sdfs.Num(); ++SdfIndex)
+	{
+		if(Costliest == INDEX_NONE || Sdfs[SdfIndex].GetEstimatedSeconds() > Sdfs[Costliest].GetEstimatedSeconds())
+		{
+			Costliest = SdfIndex;
+		}
+	}
+	return Costliest;
+}
+
+FLinearColor FPSFMarchProfile::GetDebugColor(int32 PixelIndex, EPSFDebugView View, float MaxEvaluations) const
+{
+	const FPSFMarchCounters &Counters = Pixels[PixelIndex];
+	switch(View)
+	{
+	case EPSFDebugView::Steps:
+		return Heatmap(Counters.Steps / 100.0f);
+	case EPSFDebugView::Evaluations:
+		return Heatmap(Counters.SdfEvaluations / MaxEvaluations);
+	case EPSFDebugView::Dolphins:
+		return Heatmap(Counters.DolphinEvaluations / MaxEvaluations);
+	case EPSFDebugView::Exit:
+		return Counters.Exit == EPSFMarchExit::Hit ? FLinearColor(0.2f, 0.8f, 0.2f) : Counters.Exit == EPSFMarchExit::Escaped ? FLinearColor(0.1f, 0.1f, 0.4f) : FLinearColor(1.0f, 0.0f, 0.0f);
+	default:
+		break;
+	}
+
+	if(Counters.CostliestSdf == INDEX_NONE)
+	{
+		return FLinearColor::Black;
+	}
+	const float Hue = FMath::Frac(Counters.CostliestSdf * 0.618034f);
+	return FLinearColor(FMath::Clamp(FMath::Abs(FMath::Frac(Hue) * 6.0f - 3.0f) - 1.0f, 0.0f, 1.0f), FMath::Clamp(FMath::Abs(FMath::Frac(Hue + 2.0f / 3.0f) * 6.0f - 3.0f) - 1.0f, 0.0f, 1.0f),
+		FMath::Clamp(FMath::Abs(FMath::Frac(Hue + 1.0f / 3.0f) * 6.0f - 3.0f) - 1.0f, 0.0f, 1.0f), 1.0f);
+}
+
+FString FPSFMarchProfile::ToJsonString(const FPSFScene &Scene) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("width"), Width);
+	Root->SetNumberField(TEXT("height"), Height);
+	Root->SetNumberField(TEXT("steps"), GetTotalSteps());
+	Root->SetNumberField(TEXT("sdfEvaluations"), GetTotalEvaluations());
+	Root->SetNumberField(TEXT("dolphinEvaluations"), GetTotalDolphinEvaluations());
+	Root->SetNumberField(TEXT("hits"), CountExits(EPSFMarchExit::Hit));
+	Root->SetNumberField(TEXT("escaped"), CountExits(EPSFMarchExit::Escaped));
+	Root->SetNumberField(TEXT("stepCapped"), CountExits(EPSFMarchExit::StepCap));
+	Root->SetNumberField(TEXT("costliestSdf"), GetCostliestSdf());
+
+	// one bucket per step, the cap is 100
+	TArray<TSharedPtr<FJsonValue>> HistogramValues;
+	for(const int32 Count : GetHistogram(EPSFDebugView::Steps, 101, 101))
+	{
+		HistogramValues.Add(MakeShared<FJsonValueNumber>(Count));
+	}
+	Root->SetArrayField(TEXT("stepHistogram"), HistogramValues);
+
+	TArray<TSharedPtr<FJsonValue>> SdfValues;
+	for(int32 SdfIndex = 0; SdfIndex < Sdfs.Num(); ++SdfIndex)
+	{
+		const FPSFSdfCost &Cost = Sdfs[SdfIndex];
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField(TEXT("index"), SdfIndex);
+		Object->SetStringField(TEXT("type"), Scene.SDFs.IsValidIndex(SdfIndex) ? PSFScene::SdfTypeToString(Scene.SDFs[SdfIndex].Type) : TEXT(""));
+		Object->SetNumberField(TEXT("evaluations"), Cost.Evaluations);
+		Object->SetNumberField(TEXT("costliestPixels"), Cost.CostliestPixels);
+		Object->SetNumberField(TEXT("nanosecondsPerEvaluation"), Cost.NanosecondsPerEvaluation);
+		Object->SetNumberField(TEXT("estimatedSeconds"), Cost.GetEstimatedSeconds());
+		SdfValues.Add(MakeShared<FJsonValueObject>(Object));
+	}
+	Root->SetArrayField(TEXT("sdfs"), SdfValues);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+void FPSFMarchProfile::LogSummary(const FPSFScene &Scene) const
+{
+	const double Rays = FMath::Max(Pixels.Num(), 1);
+	UE_LOG(LogTemp, Display, TEXT("March counters at %dx%d: %.2f steps, %.1f SDF evaluations and %.1f dolphin evaluations per pixel."), Width, Height,
+		GetTotalSteps() / Rays, GetTotalEvaluations() / Rays, GetTotalDolphinEvaluations() / Rays);
+	UE_LOG(LogTemp, Display, TEXT("%.2f%% hit, %.2f%% passed the stopping criterium, %.2f%% ran out of steps."), CountExits(EPSFMarchExit::Hit) * 100.0 / Rays,
+		CountExits(EPSFMarchExit::Escaped) * 100.0 / Rays, CountExits(EPSFMarchExit::StepCap) * 100.0 / Rays);
+
+	UE_LOG(LogTemp, Display, TEXT("%6s %-12s %14s %10s %12s %10s"), TEXT("sdf"), TEXT("type"), TEXT("evaluations"), TEXT("ns/eval"), TEXT("est. ms"), TEXT("costliest"));
+	for(int32 SdfIndex = 0; SdfIndex < Sdfs.Num(); ++SdfIndex)
+	{
+		const FPSFSdfCost &Cost = Sdfs[SdfIndex];
+		UE_LOG(LogTemp, Display, TEXT("%6d %-12s %14lld %10.1f %12.3f %9.2f%%"), SdfIndex, Scene.SDFs.IsValidIndex(SdfIndex) ? PSFScene::SdfTypeToString(Scene.SDFs[SdfIndex].Type) : TEXT(""),
+			Cost.Evaluations, Cost.NanosecondsPerEvaluation, Cost.GetEstimatedSeconds() * 1000.0, Cost.CostliestPixels * 100.0 / Rays);
+	}
+
+	const int32 Costliest = GetCostliestSdf();
+	if(Costliest != INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Display, TEXT("The most expensive SDF is %d (%s)."), Costliest, PSFScene::SdfTypeToString(Scene.SDFs[Costliest].Type));
+	}
+}
+
+const TCHAR *FPSFMarchProfile::GetViewName(EPSFDebugView View)
+{
+	switch(View)
+	{
+	case EPSFDebugView::Steps:
+		return TEXT("steps");
+	case EPSFDebugView::Evaluations:
+		return TEXT("evaluations");
+	case EPSFDebugView::Dolphins:
+		return TEXT("dolphins");
+	case EPSFDebugView::Exit:
+		return TEXT("exit");
+	case EPSFDebugView::CostliestSdf:
+		return TEXT("sdf");
+	}
+	return TEXT("");
+}
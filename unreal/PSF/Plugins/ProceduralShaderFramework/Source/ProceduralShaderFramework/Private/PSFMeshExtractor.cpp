@@ -0,0 +1,384 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFMeshExtractor.h"
+#include "PSFSdfFunctions.h"
+#include "PSFBvh.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+namespace
+{
+	/** Current and largest number of bytes held by an extraction */
+	struct FMemoryCounter
+	{
+		std::atomic<int64> Current {0};
+		std::atomic<int64> Peak {0};
+
+		void Add(int64 Bytes)
+		{
+			const int64 Value = Current += Bytes;
+			int64 PreviousPeak = Peak.load();
+			while(Value > PreviousPeak && !Peak.compare_exchange_weak(PreviousPeak, Value))
+			{
+			}
+		}
+	};
+
+	/**
+	 * Mesh of one chunk with chunk local indices. Vertices of the cells on the faces of the chunk are shared with the
+	 * neighbouring chunks and carry the index of their cell in the whole grid, all others have no key.
+	 */
+	struct FChunkMesh
+	{
+		TArray<FVector3f> Positions;
+		TArray<FVector3f> Normals;
+		TArray<int64> Keys;
+		TArray<uint32> Indices;
+		float MaxVertexError = 0.0f;
+
+		int64 GetNumBytes() const
+		{
+			return int64(Positions.Num() + Normals.Num()) * sizeof(FVector3f) + int64(Keys.Num()) * sizeof(int64) + int64(Indices.Num()) * sizeof(uint32);
+		}
+	};
+
+	/** Corner a and b of the 12 edges of a cell, bit 0, 1, 2 of a corner is its x, y, z offset */
+	struct FCellEdges
+	{
+		int32 Corners[12][2];
+
+		FCellEdges()
+		{
+			int32 Edge = 0;
+			for(int32 Corner = 0; Corner < 8; ++Corner)
+			{
+				for(int32 Bit = 1; Bit < 8; Bit <<= 1)
+				{
+					if(!(Corner & Bit))
+					{
+						Corners[Edge][0] = Corner;
+						Corners[Edge][1] = Corner | Bit;
+						++Edge;
+					}
+				}
+			}
+		}
+	};
+
+	const FCellEdges CellEdges;
+
+	FVector3f CornerOffset(int32 Corner)
+	{
+		return FVector3f(float(Corner & 1), float((Corner >> 1) & 1), float((Corner >> 2) & 1));
+	}
+}
+
+bool FPSFMeshExtractor::CanExtract(const FPSFSdf &Sdf)
+{
+	// the CPU evalSDF returns the miss value for custom SDFs
+	return Sdf.Type != EPSFSdfType::Dolphin && Sdf.Type != EPSFSdfType::Custom;
+}
+
+bool FPSFMeshExtractor::Extract(const FPSFSdf &Sdf, const FBox3f &Bounds, int32 Resolution, const FPSFMeshExtractSettings &Settings, FPSFExtractedMesh &OutMesh, FPSFMeshExtractStats &OutStats)
+{
+	if(!CanExtract(Sdf))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s SDFs can not be extracted."), PSFScene::SdfTypeToString(Sdf.Type));
+		return false;
+	}
+
+	FBox3f Box = Bounds;
+	if(!Box.IsValid && !PSFSdfBounds::ComputeBounds(Sdf, 0.0f, Box))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s SDFs are unbounded, the extraction needs explicit bounds."), PSFScene::SdfTypeToString(Sdf.Type));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const float CellSize = Box.GetSize().GetMax() / FMath::Max(Resolution, 1);
+	if(CellSize <= 0.0f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("The extraction bounds are empty."));
+		return false;
+	}
+
+	const FVector3f Padding(Settings.PaddingCells * CellSize);
+	const FVector3f Size = Box.GetSize() + 2.0f * Padding;
+	const FVector3f Origin = Box.Min - Padding;
+	const FIntVector Cells(
+		FMath::Max(FMath::CeilToInt(Size.X / CellSize), 1),
+		FMath::Max(FMath::CeilToInt(Size.Y / CellSize), 1),
+		FMath::Max(FMath::CeilToInt(Size.Z / CellSize), 1));
+
+	const int32 ChunkCells = FMath::Max(Settings.ChunkCells, 2);
+	const FIntVector ChunkCount(FMath::DivideAndRoundUp(Cells.X, ChunkCells), FMath::DivideAndRoundUp(Cells.Y, ChunkCells), FMath::DivideAndRoundUp(Cells.Z, ChunkCells));
+	const int32 TotalChunks = ChunkCount.X * ChunkCount.Y * ChunkCount.Z;
+	const float LipschitzBound = PSFSdfBounds::GetLipschitzBound(Sdf);
+
+	// cells from -1 to Cells, the layer below the grid is the one the first chunks read
+	auto CellKey = [&Cells](const FIntVector &Cell)
+	{
+		return int64(Cell.X + 1) + int64(Cells.X + 2) * (int64(Cell.Y + 1) + int64(Cells.Y + 2) * int64(Cell.Z + 1));
+	};
+
+	FMemoryCounter Memory;
+	std::atomic<int64> TotalEvaluations(0);
+	std::atomic<int32> SurfaceChunks(0);
+
+	OutMesh = FPSFExtractedMesh();
+	OutMesh.CellSize = CellSize;
+	float MaxVertexError = 0.0f;
+
+	// chunks are merged in index order once all before them are done, the seam table resolves the shared vertices
+	FCriticalSection MergeLock;
+	TArray<FChunkMesh> PendingChunks;
+	TArray<bool> ChunkDone;
+	PendingChunks.SetNum(TotalChunks);
+	ChunkDone.SetNumZeroed(TotalChunks);
+	int32 NextChunkToMerge = 0;
+	TMap<int64, uint32> SeamVertices;
+	TArray<uint32> Remap;
+
+	auto MergeChunk = [&](FChunkMesh &Chunk)
+	{
+		const int64 BytesBefore = OutMesh.GetNumBytes() + int64(SeamVertices.Num()) * (sizeof(int64) + sizeof(uint32));
+		Remap.SetNumUninitialized(Chunk.Positions.Num());
+		for(int32 Vertex = 0; Vertex < Chunk.Positions.Num(); ++Vertex)
+		{
+			if(Chunk.Keys[Vertex] != INDEX_NONE)
+			{
+				if(const uint32 *Existing = SeamVertices.Find(Chunk.Keys[Vertex]))
+				{
+					Remap[Vertex] = *Existing;
+					continue;
+				}
+				SeamVertices.Add(Chunk.Keys[Vertex], uint32(OutMesh.Positions.Num()));
+			}
+			Remap[Vertex] = uint32(OutMesh.Positions.Num());
+			OutMesh.Positions.Add(Chunk.Positions[Vertex]);
+			OutMesh.Normals.Add(Chunk.Normals[Vertex]);
+		}
+		OutMesh.Indices.Reserve(OutMesh.Indices.Num() + Chunk.Indices.Num());
+		for(const uint32 Index : Chunk.Indices)
+		{
+			OutMesh.Indices.Add(Remap[Index]);
+		}
+		MaxVertexError = FMath::Max(MaxVertexError, Chunk.MaxVertexError);
+		Memory.Add(OutMesh.GetNumBytes() + int64(SeamVertices.Num()) * (sizeof(int64) + sizeof(uint32)) - BytesBefore);
+	};
+
+	auto FinishChunk = [&](int32 ChunkIndex, FChunkMesh &&Chunk)
+	{
+		FScopeLock Lock(&MergeLock);
+		const int64 ChunkBytes = Chunk.GetNumBytes();
+		Memory.Add(ChunkBytes);
+		PendingChunks[ChunkIndex] = MoveTemp(Chunk);
+		ChunkDone[ChunkIndex] = true;
+		while(NextChunkToMerge < TotalChunks && ChunkDone[NextChunkToMerge])
+		{
+			FChunkMesh &Pending = PendingChunks[NextChunkToMerge];
+			const int64 PendingBytes = Pending.GetNumBytes();
+			MergeChunk(Pending);
+			Pending = FChunkMesh();
+			Memory.Add(-PendingBytes);
+			++NextChunkToMerge;
+		}
+	};
+
+	ParallelFor(TotalChunks, [&](int32 ChunkIndex)
+	{
+		const FIntVector Chunk(ChunkIndex % ChunkCount.X, (ChunkIndex / ChunkCount.X) % ChunkCount.Y, ChunkIndex / (ChunkCount.X * ChunkCount.Y));
+		const FIntVector First = Chunk * ChunkCells;
+		const FIntVector Count(FMath::Min(ChunkCells, Cells.X - First.X), FMath::Min(ChunkCells, Cells.Y - First.Y), FMath::Min(ChunkCells, Cells.Z - First.Z));
+
+		// the chunk reads one layer of cells below it, the surface can not reach into both if evalSDF at their center
+		// is larger than the slope bound times their half diagonal
+		const FVector3f Center = Origin + (FVector3f(First) + 0.5f * FVector3f(Count) - FVector3f(0.5f)) * CellSize;
+		const float HalfDiagonal = 0.5f * FVector3f(Count + FIntVector(1)).Size() * CellSize;
+		int64 Evaluations = 0;
+		if(LipschitzBound > 0.0f)
+		{
+			++Evaluations;
+			if(FMath::Abs(PSFSdf::EvalSDF(Sdf, Center)) > LipschitzBound * HalfDiagonal)
+			{
+				TotalEvaluations += Evaluations;
+				FinishChunk(ChunkIndex, FChunkMesh());
+				return;
+			}
+		}
+		++SurfaceChunks;
+
+		// corners from First - 1 to First + Count, cells from First - 1 to First + Count - 1
+		const FIntVector Corners = Count + FIntVector(2);
+		const FIntVector LocalCells = Count + FIntVector(1);
+		TArray<float> Samples;
+		TArray<int32> CellVertices;
+		Samples.SetNumUninitialized(Corners.X * Corners.Y * Corners.Z);
+		CellVertices.Init(INDEX_NONE, LocalCells.X * LocalCells.Y * LocalCells.Z);
+		const int64 ScratchBytes = int64(Samples.Num()) * sizeof(float) + int64(CellVertices.Num()) * sizeof(int32);
+		Memory.Add(ScratchBytes);
+
+		auto CornerPosition = [&](int32 X, int32 Y, int32 Z)
+		{
+			return Origin + FVector3f(float(First.X - 1 + X), float(First.Y - 1 + Y), float(First.Z - 1 + Z)) * CellSize;
+		};
+		auto Sample = [&](int32 X, int32 Y, int32 Z)
+		{
+			return Samples[X + Corners.X * (Y + Corners.Y * Z)];
+		};
+
+		for(int32 Z = 0; Z < Corners.Z; ++Z)
+		{
+			for(int32 Y = 0; Y < Corners.Y; ++Y)
+			{
+				for(int32 X = 0; X < Corners.X; ++X)
+				{
+					Samples[X + Corners.X * (Y + Corners.Y * Z)] = PSFSdf::EvalSDF(Sdf, CornerPosition(X, Y, Z));
+				}
+			}
+		}
+		Evaluations += Samples.Num();
+
+		FChunkMesh Mesh;
+
+		// the vertex of a cell is placed the first time a quad uses it
+		auto GetVertex = [&](const FIntVector &Cell) -> uint32
+		{
+			int32 &Vertex = CellVertices[Cell.X + LocalCells.X * (Cell.Y + LocalCells.Y * Cell.Z)];
+			if(Vertex != INDEX_NONE)
+			{
+				return uint32(Vertex);
+			}
+
+			float Distances[8];
+			for(int32 Corner = 0; Corner < 8; ++Corner)
+			{
+				Distances[Corner] = Sample(Cell.X + (Corner & 1), Cell.Y + ((Corner >> 1) & 1), Cell.Z + ((Corner >> 2) & 1));
+			}
+
+			// mean of the points where the surface crosses the edges of the cell
+			FVector3f Sum = FVector3f::ZeroVector;
+			int32 Crossings = 0;
+			for(int32 Edge = 0; Edge < 12; ++Edge)
+			{
+				const int32 A = CellEdges.Corners[Edge][0];
+				const int32 B = CellEdges.Corners[Edge][1];
+				if((Distances[A] < 0.0f) != (Distances[B] < 0.0f))
+				{
+					const float T = Distances[A] / (Distances[A] - Distances[B]);
+					Sum += FMath::Lerp(CornerOffset(A), CornerOffset(B), T);
+					++Crossings;
+				}
+			}
+
+			const FVector3f CellMin = CornerPosition(Cell.X, Cell.Y, Cell.Z);
+			FVector3f Position = CellMin + Sum / float(FMath::Max(Crossings, 1)) * CellSize;
+			if(Settings.bProjectVertices)
+			{
+				// one step along the gradient, kept inside the cell so that the mesh can not fold over
+				Position -= PSFSdf::EvalSDF(Sdf, Position) * PSFSdf::GetNormal(Sdf, Position);
+				Position = FVector3f::Min(FVector3f::Max(Position, CellMin), CellMin + FVector3f(CellSize));
+				Evaluations += 5;
+			}
+			const float Error = FMath::Abs(PSFSdf::EvalSDF(Sdf, Position));
+			Evaluations += 5;
+
+			// cells on a face of the chunk are shared with the neighbouring chunk
+			const bool bShared = Cell.X == 0 || Cell.Y == 0 || Cell.Z == 0 || Cell.X == Count.X || Cell.Y == Count.Y || Cell.Z == Count.Z;
+			Vertex = Mesh.Positions.Add(Position);
+			Mesh.Normals.Add(PSFSdf::GetNormal(Sdf, Position));
+			Mesh.Keys.Add(bShared ? CellKey(First - FIntVector(1) + Cell) : int64(INDEX_NONE));
+			Mesh.MaxVertexError = FMath::Max(Mesh.MaxVertexError, Error);
+			return uint32(Vertex);
+		};
+
+		// every edge belongs to the cell at its lower corner, the four cells around an edge the surface crosses form
+		// a quad, wound counter-clockwise around the axis of the edge if the surface is left towards the upper corner
+		for(int32 Z = 1; Z <= Count.Z; ++Z)
+		{
+			for(int32 Y = 1; Y <= Count.Y; ++Y)
+			{
+				for(int32 X = 1; X <= Count.X; ++X)
+				{
+					const FIntVector Cell(X, Y, Z);
+					const float Distance = Sample(X, Y, Z);
+					for(int32 Axis = 0; Axis < 3; ++Axis)
+					{
+						FIntVector Next = Cell;
+						Next[Axis] += 1;
+						const bool bInside = Distance < 0.0f;
+						if(bInside == (Sample(Next.X, Next.Y, Next.Z) < 0.0f))
+						{
+							continue;
+						}
+
+						FIntVector U = FIntVector::ZeroValue, V = FIntVector::ZeroValue;
+						U[(Axis + 1) % 3] = 1;
+						V[(Axis + 2) % 3] = 1;
+						uint32 Quad[4] = {GetVertex(Cell - U - V), GetVertex(Cell - V), GetVertex(Cell), GetVertex(Cell - U)};
+						if(!bInside)
+						{
+							Swap(Quad[1], Quad[3]);
+						}
+
+						// the shorter diagonal splits the quad
+						const bool bSplit02 = FVector3f::DistSquared(Mesh.Positions[Quad[0]], Mesh.Positions[Quad[2]])
+							<= FVector3f::DistSquared(Mesh.Positions[Quad[1]], Mesh.Positions[Quad[3]]);
+						if(bSplit02)
+						{
+							Mesh.Indices.Append({Quad[0], Quad[1], Quad[2], Quad[0], Quad[2], Quad[3]});
+						}
+						else
+						{
+							Mesh.Indices.Append({Quad[0], Quad[1], Quad[3], Quad[1], Quad[2], Quad[3]});
+						}
+					}
+				}
+			}
+		}
+
+		Samples.Empty();
+		CellVertices.Empty();
+		Memory.Add(-ScratchBytes);
+		TotalEvaluations += Evaluations;
+		FinishChunk(ChunkIndex, MoveTemp(Mesh));
+	}, EParallelForFlags::Unbalanced);
+
+	OutStats = FPSFMeshExtractStats();
+	OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+	OutStats.SdfEvaluations = TotalEvaluations;
+	OutStats.TotalChunks = TotalChunks;
+	OutStats.SurfaceChunks = SurfaceChunks;
+	OutStats.Vertices = OutMesh.Positions.Num();
+	OutStats.Triangles = OutMesh.GetNumTriangles();
+	OutStats.PeakBytes = Memory.Peak;
+	OutStats.DenseBytes = int64(Cells.X + 1) * (Cells.Y + 1) * (Cells.Z + 1) * sizeof(float);
+	OutStats.MaxVertexError = MaxVertexError;
+	return true;
+}
+
+bool FPSFMeshExtractor::ExtractLods(const FPSFSdf &Sdf, const FBox3f &Bounds, const FPSFMeshExtractSettings &Settings, TArray<FPSFExtractedMesh> &OutLods, TArray<FPSFMeshExtractStats> &OutStats)
+{
+	const int32 NumLods = FMath::Max(Settings.NumLods, 1);
+	OutLods.SetNum(NumLods);
+	OutStats.SetNum(NumLods);
+	for(int32 Lod = 0; Lod < NumLods; ++Lod)
+	{
+		if(!Extract(Sdf, Bounds, FMath::Max(Settings.Resolution >> Lod, 2), Settings, OutLods[Lod], OutStats[Lod]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FPSFMeshExtractor::LogStats(int32 Lod, const FPSFMeshExtractStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("LOD %d: %d triangles, %d vertices in %.2f s, %.2f M triangles/s, %.2f M evalSDF/s"), Lod, Stats.Triangles, Stats.Vertices, Stats.Seconds,
+		Stats.GetTrianglesPerSecond() * 1e-6, Stats.Seconds > 0.0 ? Stats.SdfEvaluations / Stats.Seconds * 1e-6 : 0.0);
+	UE_LOG(LogTemp, Display, TEXT("LOD %d: %d of %d chunks meshed, peak memory %.2f MB, dense grid %.2f MB, max vertex error %.5f"), Lod, Stats.SurfaceChunks, Stats.TotalChunks,
+		Stats.PeakBytes / (1024.0 * 1024.0), Stats.DenseBytes / (1024.0 * 1024.0), Stats.MaxVertexError);
+}
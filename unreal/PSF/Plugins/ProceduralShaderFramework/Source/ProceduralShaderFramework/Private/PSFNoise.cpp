@@ -0,0 +1,677 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFNoise.h"
+#include "PSFShaderMath.h"
+#include "Math/VectorRegister.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	FORCEINLINE float Mod289(float X)
+	{
+		return X - FMath::FloorToFloat(X * (1.0f / 289.0f)) * 289.0f;
+	}
+
+	FORCEINLINE float Permute(float X)
+	{
+		return Mod289(((X * 34.0f) + 1.0f) * X);
+	}
+}
+
+float PSFNoise::SNoise(const FVector3f &V)
+{
+	const float Cx = 1.0f / 6.0f;
+	const float Cy = 1.0f / 3.0f;
+
+	FVector3f I = Floor(V + FVector3f((V.X + V.Y + V.Z) * Cy));
+	const FVector3f X0 = V - I + FVector3f((I.X + I.Y + I.Z) * Cx);
+
+	// g = step(x0.yzx, x0.xyz), l = 1 - g
+	const FVector3f G(X0.X >= X0.Y ? 1.0f : 0.0f, X0.Y >= X0.Z ? 1.0f : 0.0f, X0.Z >= X0.X ? 1.0f : 0.0f);
+	const FVector3f L = FVector3f(1.0f) - G;
+	const FVector3f I1(FMath::Min(G.X, L.Z), FMath::Min(G.Y, L.X), FMath::Min(G.Z, L.Y));
+	const FVector3f I2(FMath::Max(G.X, L.Z), FMath::Max(G.Y, L.X), FMath::Max(G.Z, L.Y));
+
+	const FVector3f X1 = X0 - I1 + FVector3f(Cx);
+	const FVector3f X2 = X0 - I2 + FVector3f(Cy);
+	const FVector3f X3 = X0 - FVector3f(0.5f);
+
+	I = FVector3f(Mod289(I.X), Mod289(I.Y), Mod289(I.Z));
+
+	const float OffsetsX[4] = {0.0f, I1.X, I2.X, 1.0f};
+	const float OffsetsY[4] = {0.0f, I1.Y, I2.Y, 1.0f};
+	const float OffsetsZ[4] = {0.0f, I1.Z, I2.Z, 1.0f};
+
+	// ns = n_ * D.wyz - D.xzx with n_ = 1/7
+	const float NsX = 2.0f / 7.0f;
+	const float NsY = 0.5f / 7.0f - 1.0f;
+	const float NsZ = 1.0f / 7.0f;
+
+	float H[4];
+	float A[4][2];
+	for(int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		const float P = Permute(Permute(Permute(I.Z + OffsetsZ[Corner]) + I.Y + OffsetsY[Corner]) + I.X + OffsetsX[Corner]);
+
+		const float J = P - 49.0f * FMath::FloorToFloat(P * NsZ * NsZ);
+		const float XU = FMath::FloorToFloat(J * NsZ);
+		const float YU = FMath::FloorToFloat(J - 7.0f * XU);
+
+		const float X = XU * NsX + NsY;
+		const float Y = YU * NsX + NsY;
+		H[Corner] = 1.0f - FMath::Abs(X) - FMath::Abs(Y);
+
+		// a0 = b0.xzyw + s0.xzyw * sh.xxyy, which per corner reduces to (b + s * sh)
+		const float Sh = H[Corner] <= 0.0f ? -1.0f : 0.0f;
+		A[Corner][0] = X + (FMath::FloorToFloat(X) * 2.0f + 1.0f) * Sh;
+		A[Corner][1] = Y + (FMath::FloorToFloat(Y) * 2.0f + 1.0f) * Sh;
+	}
+
+	const FVector3f Offsets[4] = {X0, X1, X2, X3};
+	float Result = 0.0f;
+	for(int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		FVector3f Gradient(A[Corner][0], A[Corner][1], H[Corner]);
+		Gradient *= 1.79284291400159f - 0.85373472095314f * (Gradient | Gradient);
+
+		float M = FMath::Max(0.6f - (Offsets[Corner] | Offsets[Corner]), 0.0f);
+		M = M * M;
+		Result += M * M * (Gradient | Offsets[Corner]);
+	}
+	return 42.0f * Result;
+}
+
+float PSFNoise::N31(const FVector3f &InP)
+{
+	const FVector3f S(7.0f, 157.0f, 113.0f);
+	const FVector3f IP = Floor(InP);
+	FVector3f P = Frac(InP);
+	P = P * P * (FVector3f(3.0f) - P * 2.0f);
+
+	const float Base = IP | S;
+	const FVector4f H0(Base, S.Y + Base, S.Z + Base, S.Y + S.Z + Base);
+	const FVector4f H1 = H0 + FVector4f(S.X, S.X, S.X, S.X);
+	const FVector4f A = Hash44(H0);
+	const FVector4f B = Hash44(H1);
+	const FVector4f H = A + (B - A) * P.X;
+
+	// h.xy = lerp(h.xz, h.yw, p.y)
+	const float X = FMath::Lerp(H.X, H.Y, P.Y);
+	const float Y = FMath::Lerp(H.Z, H.W, P.Y);
+	return FMath::Lerp(X, Y, P.Z);
+}
+
+float PSFNoise::FbmN31(const FVector3f &InP, int32 Octaves)
+{
+	FVector3f P = InP;
+	float Value = 0.0f;
+	float Amplitude = 0.5f;
+	for(int32 Octave = 0; Octave < Octaves; ++Octave)
+	{
+		Value += Amplitude * N31(P);
+		P *= 2.0f;
+		Amplitude *= 0.5f;
+	}
+	return Value;
+}
+
+float PSFNoise::Hash11(float X)
+{
+	return Frac(FMath::Sin(X * 17.23f) * 43758.5453f);
+}
+
+FVector2f PSFNoise::Hash22(const FVector2f &P)
+{
+	const float N = FMath::Sin(P.X * 113.0f + P.Y);
+	return FVector2f(Frac(2097152.0f * N), Frac(262144.0f * N)) * 2.0f - FVector2f(1.0f, 1.0f);
+}
+
+float PSFNoise::N2D(const FVector2f &InP)
+{
+	const FVector2f I(FMath::FloorToFloat(InP.X), FMath::FloorToFloat(InP.Y));
+	FVector2f P = InP - I;
+	P = P * P * (FVector2f(3.0f, 3.0f) - P * 2.0f);
+
+	const float Base = I.X + I.Y * 113.0f;
+	const float Offsets[4] = {0.0f, 1.0f, 113.0f, 114.0f};
+	float H[4];
+	for(int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		H[Corner] = Frac(FMath::Sin(FMod(Offsets[Corner] + Base, 6.2831853f)) * 43758.5453f);
+	}
+
+	// dot(mul(float2x2(h), float2(1 - p.y, p.y)), float2(1 - p.x, p.x))
+	const float Row0 = H[0] * (1.0f - P.Y) + H[1] * P.Y;
+	const float Row1 = H[2] * (1.0f - P.Y) + H[3] * P.Y;
+	return Row0 * (1.0f - P.X) + Row1 * P.X;
+}
+
+float PSFNoise::GradN2D(const FVector2f &InF)
+{
+	const FVector2f P(FMath::FloorToFloat(InF.X), FMath::FloorToFloat(InF.Y));
+	const FVector2f F = InF - P;
+	const FVector2f W = F * F * (FVector2f(3.0f, 3.0f) - F * 2.0f);
+
+	const FVector2f E00(0, 0), E10(1, 0), E01(0, 1), E11(1, 1);
+	const float C = FMath::Lerp(
+		FMath::Lerp(Hash22(P + E00) | (F - E00), Hash22(P + E10) | (F - E10), W.X),
+		FMath::Lerp(Hash22(P + E01) | (F - E01), Hash22(P + E11) | (F - E11), W.X),
+		W.Y);
+	return C * 0.5f + 0.5f;
+}
+
+FVector4f PSFNoise::Hash44(const FVector4f &InP)
+{
+	FVector4f P(Frac(InP.X * 0.1031f), Frac(InP.Y * 0.1030f), Frac(InP.Z * 0.0973f), Frac(InP.W * 0.1099f));
+
+	// p += dot(p, p.wzxy + 33.33)
+	const float D = P.X * (P.W + 33.33f) + P.Y * (P.Z + 33.33f) + P.Z * (P.X + 33.33f) + P.W * (P.Y + 33.33f);
+	P += FVector4f(D, D, D, D);
+
+	// frac((p.xxyz + p.yzzw) * p.zywx)
+	return FVector4f(Frac((P.X + P.Y) * P.Z), Frac((P.X + P.Z) * P.Y), Frac((P.Y + P.Z) * P.W), Frac((P.Z + P.W) * P.X));
+}
+
+namespace
+{
+	// The packet versions repeat the scalar ports operation by operation, without fused multiply-adds, so that both
+	// round the same way.
+
+	FORCEINLINE VectorRegister4Float FracV(const VectorRegister4Float &X)
+	{
+		return VectorSubtract(X, VectorFloor(X));
+	}
+
+	FORCEINLINE VectorRegister4Float LerpV(const VectorRegister4Float &A, const VectorRegister4Float &B, const VectorRegister4Float &T)
+	{
+		return VectorAdd(A, VectorMultiply(T, VectorSubtract(B, A)));
+	}
+
+	/** p * p * (3 - 2p) */
+	FORCEINLINE VectorRegister4Float SmoothV(const VectorRegister4Float &P)
+	{
+		return VectorMultiply(VectorMultiply(P, P), VectorSubtract(VectorSetFloat1(3.0f), VectorMultiply(P, VectorSetFloat1(2.0f))));
+	}
+
+	FORCEINLINE VectorRegister4Float Mod289V(const VectorRegister4Float &X)
+	{
+		return VectorSubtract(X, VectorMultiply(VectorFloor(VectorMultiply(X, VectorSetFloat1(1.0f / 289.0f))), VectorSetFloat1(289.0f)));
+	}
+
+	FORCEINLINE VectorRegister4Float PermuteV(const VectorRegister4Float &X)
+	{
+		return Mod289V(VectorMultiply(VectorAdd(VectorMultiply(X, VectorSetFloat1(34.0f)), VectorOneFloat()), X));
+	}
+
+	FORCEINLINE VectorRegister4Float Dot3V(const VectorRegister4Float &AX, const VectorRegister4Float &AY, const VectorRegister4Float &AZ,
+		const VectorRegister4Float &BX, const VectorRegister4Float &BY, const VectorRegister4Float &BZ)
+	{
+		return VectorAdd(VectorAdd(VectorMultiply(AX, BX), VectorMultiply(AY, BY)), VectorMultiply(AZ, BZ));
+	}
+
+	/** 1 where A >= B, otherwise 0, the HLSL step(B, A) */
+	FORCEINLINE VectorRegister4Float StepV(const VectorRegister4Float &B, const VectorRegister4Float &A)
+	{
+		return VectorSelect(VectorCompareGE(A, B), VectorOneFloat(), VectorZeroFloat());
+	}
+
+	/**
+	 * fmod(X, Y) as exact as fmodf. X - trunc(X / Y) * Y rounds the product, which is enough to change a sin hash once
+	 * X is in the hundreds, so the product is split into two exact parts (Dekker) first.
+	 */
+	FORCEINLINE VectorRegister4Float FModV(const VectorRegister4Float &X, float Y)
+	{
+		const VectorRegister4Float YV = VectorSetFloat1(Y);
+		const VectorRegister4Float Q = VectorTruncate(VectorDivide(X, YV));
+
+		const VectorRegister4Float Splitter = VectorSetFloat1(4097.0f);
+		const VectorRegister4Float QC = VectorMultiply(Q, Splitter);
+		const VectorRegister4Float QHi = VectorSubtract(QC, VectorSubtract(QC, Q));
+		const VectorRegister4Float QLo = VectorSubtract(Q, QHi);
+		const float YC = Y * 4097.0f;
+		const VectorRegister4Float YHi = VectorSetFloat1(YC - (YC - Y));
+		const VectorRegister4Float YLo = VectorSetFloat1(Y - (YC - (YC - Y)));
+
+		// q * y = Product + Error without rounding
+		const VectorRegister4Float Product = VectorMultiply(Q, YV);
+		const VectorRegister4Float Error = VectorAdd(VectorAdd(VectorAdd(VectorSubtract(VectorMultiply(QHi, YHi), Product), VectorMultiply(QHi, YLo)), VectorMultiply(QLo, YHi)),
+			VectorMultiply(QLo, YLo));
+		const VectorRegister4Float R = VectorSubtract(VectorSubtract(X, Product), Error);
+
+		// a quotient rounded up to the next integer leaves R with the wrong sign
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float WrongSign = VectorCompareLT(VectorMultiply(R, X), Zero);
+		const VectorRegister4Float Correction = VectorSelect(VectorCompareLT(X, Zero), VectorNegate(YV), YV);
+		return VectorSelect(WrongSign, VectorAdd(R, Correction), R);
+	}
+
+	template<EPSFSinHash SinHash>
+	FORCEINLINE VectorRegister4Float SinV(const VectorRegister4Float &X)
+	{
+		if constexpr(SinHash == EPSFSinHash::Fast)
+		{
+			return VectorSin(X);
+		}
+		else
+		{
+			alignas(16) float Lanes[4];
+			VectorStoreAligned(X, Lanes);
+			for(float &Lane : Lanes)
+			{
+				Lane = FMath::Sin(Lane);
+			}
+			return VectorLoadAligned(Lanes);
+		}
+	}
+
+	/** sin of several registers in place, lane by lane in one pass for EPSFSinHash::Exact */
+	template<EPSFSinHash SinHash, int32 Num>
+	FORCEINLINE void SinV(VectorRegister4Float (&X)[Num])
+	{
+		if constexpr(SinHash == EPSFSinHash::Fast)
+		{
+			for(VectorRegister4Float &Register : X)
+			{
+				Register = VectorSin(Register);
+			}
+		}
+		else
+		{
+			alignas(16) float Lanes[Num * 4];
+			for(int32 Index = 0; Index < Num; ++Index)
+			{
+				VectorStoreAligned(X[Index], Lanes + Index * 4);
+			}
+			for(float &Lane : Lanes)
+			{
+				Lane = FMath::Sin(Lane);
+			}
+			for(int32 Index = 0; Index < Num; ++Index)
+			{
+				X[Index] = VectorLoadAligned(Lanes + Index * 4);
+			}
+		}
+	}
+
+	/** frac(sin(X) * Scale) */
+	template<EPSFSinHash SinHash>
+	FORCEINLINE VectorRegister4Float SinHashV(const VectorRegister4Float &X, float Scale)
+	{
+		return FracV(VectorMultiply(SinV<SinHash>(X), VectorSetFloat1(Scale)));
+	}
+
+	/** hash44 of four points given as their x, y, z and w components, in place */
+	FORCEINLINE void Hash44V(VectorRegister4Float (&P)[4])
+	{
+		const VectorRegister4Float X = FracV(VectorMultiply(P[0], VectorSetFloat1(0.1031f)));
+		const VectorRegister4Float Y = FracV(VectorMultiply(P[1], VectorSetFloat1(0.1030f)));
+		const VectorRegister4Float Z = FracV(VectorMultiply(P[2], VectorSetFloat1(0.0973f)));
+		const VectorRegister4Float W = FracV(VectorMultiply(P[3], VectorSetFloat1(0.1099f)));
+
+		// p += dot(p, p.wzxy + 33.33)
+		const VectorRegister4Float Offset = VectorSetFloat1(33.33f);
+		const VectorRegister4Float D = VectorAdd(VectorAdd(VectorAdd(VectorMultiply(X, VectorAdd(W, Offset)), VectorMultiply(Y, VectorAdd(Z, Offset))),
+			VectorMultiply(Z, VectorAdd(X, Offset))), VectorMultiply(W, VectorAdd(Y, Offset)));
+		const VectorRegister4Float DX = VectorAdd(X, D);
+		const VectorRegister4Float DY = VectorAdd(Y, D);
+		const VectorRegister4Float DZ = VectorAdd(Z, D);
+		const VectorRegister4Float DW = VectorAdd(W, D);
+
+		// frac((p.xxyz + p.yzzw) * p.zywx)
+		P[0] = FracV(VectorMultiply(VectorAdd(DX, DY), DZ));
+		P[1] = FracV(VectorMultiply(VectorAdd(DX, DZ), DY));
+		P[2] = FracV(VectorMultiply(VectorAdd(DY, DZ), DW));
+		P[3] = FracV(VectorMultiply(VectorAdd(DZ, DW), DX));
+	}
+
+	VectorRegister4Float SNoiseV(const VectorRegister4Float &VX, const VectorRegister4Float &VY, const VectorRegister4Float &VZ)
+	{
+		const VectorRegister4Float Cx = VectorSetFloat1(1.0f / 6.0f);
+		const VectorRegister4Float Cy = VectorSetFloat1(1.0f / 3.0f);
+		const VectorRegister4Float One = VectorOneFloat();
+
+		const VectorRegister4Float Skew = VectorMultiply(VectorAdd(VectorAdd(VX, VY), VZ), Cy);
+		VectorRegister4Float IX = VectorFloor(VectorAdd(VX, Skew));
+		VectorRegister4Float IY = VectorFloor(VectorAdd(VY, Skew));
+		VectorRegister4Float IZ = VectorFloor(VectorAdd(VZ, Skew));
+		const VectorRegister4Float Unskew = VectorMultiply(VectorAdd(VectorAdd(IX, IY), IZ), Cx);
+		const VectorRegister4Float X0[3] = {VectorAdd(VectorSubtract(VX, IX), Unskew), VectorAdd(VectorSubtract(VY, IY), Unskew), VectorAdd(VectorSubtract(VZ, IZ), Unskew)};
+
+		// g = step(x0.yzx, x0.xyz), l = 1 - g
+		const VectorRegister4Float GX = StepV(X0[1], X0[0]);
+		const VectorRegister4Float GY = StepV(X0[2], X0[1]);
+		const VectorRegister4Float GZ = StepV(X0[0], X0[2]);
+		const VectorRegister4Float LX = VectorSubtract(One, GX);
+		const VectorRegister4Float LY = VectorSubtract(One, GY);
+		const VectorRegister4Float LZ = VectorSubtract(One, GZ);
+		const VectorRegister4Float I1[3] = {VectorMin(GX, LZ), VectorMin(GY, LX), VectorMin(GZ, LY)};
+		const VectorRegister4Float I2[3] = {VectorMax(GX, LZ), VectorMax(GY, LX), VectorMax(GZ, LY)};
+
+		const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+		VectorRegister4Float Offsets[4][3];
+		for(int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Offsets[0][Axis] = X0[Axis];
+			Offsets[1][Axis] = VectorAdd(VectorSubtract(X0[Axis], I1[Axis]), Cx);
+			Offsets[2][Axis] = VectorAdd(VectorSubtract(X0[Axis], I2[Axis]), Cy);
+			Offsets[3][Axis] = VectorSubtract(X0[Axis], Half);
+		}
+
+		IX = Mod289V(IX);
+		IY = Mod289V(IY);
+		IZ = Mod289V(IZ);
+
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float CornerX[4] = {Zero, I1[0], I2[0], One};
+		const VectorRegister4Float CornerY[4] = {Zero, I1[1], I2[1], One};
+		const VectorRegister4Float CornerZ[4] = {Zero, I1[2], I2[2], One};
+
+		// ns = n_ * D.wyz - D.xzx with n_ = 1/7
+		const VectorRegister4Float NsX = VectorSetFloat1(2.0f / 7.0f);
+		const VectorRegister4Float NsY = VectorSetFloat1(0.5f / 7.0f - 1.0f);
+		const VectorRegister4Float NsZ = VectorSetFloat1(1.0f / 7.0f);
+		const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+
+		VectorRegister4Float Result = Zero;
+		for(int32 Corner = 0; Corner < 4; ++Corner)
+		{
+			const VectorRegister4Float P = PermuteV(VectorAdd(VectorAdd(PermuteV(VectorAdd(VectorAdd(PermuteV(VectorAdd(IZ, CornerZ[Corner])), IY), CornerY[Corner])), IX), CornerX[Corner]));
+
+			const VectorRegister4Float J = VectorSubtract(P, VectorMultiply(VectorSetFloat1(49.0f), VectorFloor(VectorMultiply(VectorMultiply(P, NsZ), NsZ))));
+			const VectorRegister4Float XU = VectorFloor(VectorMultiply(J, NsZ));
+			const VectorRegister4Float YU = VectorFloor(VectorSubtract(J, VectorMultiply(VectorSetFloat1(7.0f), XU)));
+
+			const VectorRegister4Float X = VectorAdd(VectorMultiply(XU, NsX), NsY);
+			const VectorRegister4Float Y = VectorAdd(VectorMultiply(YU, NsX), NsY);
+			const VectorRegister4Float H = VectorSubtract(VectorSubtract(One, VectorAbs(X)), VectorAbs(Y));
+
+			// a0 = b0.xzyw + s0.xzyw * sh.xxyy, which per corner reduces to (b + s * sh)
+			const VectorRegister4Float Sh = VectorSelect(VectorCompareLE(H, Zero), VectorNegate(One), Zero);
+			VectorRegister4Float GradientX = VectorAdd(X, VectorMultiply(VectorAdd(VectorMultiply(VectorFloor(X), Two), One), Sh));
+			VectorRegister4Float GradientY = VectorAdd(Y, VectorMultiply(VectorAdd(VectorMultiply(VectorFloor(Y), Two), One), Sh));
+			VectorRegister4Float GradientZ = H;
+
+			const VectorRegister4Float Norm = VectorSubtract(VectorSetFloat1(1.79284291400159f),
+				VectorMultiply(VectorSetFloat1(0.85373472095314f), Dot3V(GradientX, GradientY, GradientZ, GradientX, GradientY, GradientZ)));
+			GradientX = VectorMultiply(GradientX, Norm);
+			GradientY = VectorMultiply(GradientY, Norm);
+			GradientZ = VectorMultiply(GradientZ, Norm);
+
+			const VectorRegister4Float(&Offset)[3] = Offsets[Corner];
+			VectorRegister4Float M = VectorMax(VectorSubtract(VectorSetFloat1(0.6f), Dot3V(Offset[0], Offset[1], Offset[2], Offset[0], Offset[1], Offset[2])), Zero);
+			M = VectorMultiply(M, M);
+			Result = VectorAdd(Result, VectorMultiply(VectorMultiply(M, M), Dot3V(GradientX, GradientY, GradientZ, Offset[0], Offset[1], Offset[2])));
+		}
+		return VectorMultiply(VectorSetFloat1(42.0f), Result);
+	}
+
+	VectorRegister4Float N31V(const VectorRegister4Float &InX, const VectorRegister4Float &InY, const VectorRegister4Float &InZ)
+	{
+		const VectorRegister4Float IX = VectorFloor(InX);
+		const VectorRegister4Float IY = VectorFloor(InY);
+		const VectorRegister4Float IZ = VectorFloor(InZ);
+		const VectorRegister4Float PX = SmoothV(VectorSubtract(InX, IX));
+		const VectorRegister4Float PY = SmoothV(VectorSubtract(InY, IY));
+		const VectorRegister4Float PZ = SmoothV(VectorSubtract(InZ, IZ));
+
+		// S = (7, 157, 113)
+		const VectorRegister4Float Base = Dot3V(IX, IY, IZ, VectorSetFloat1(7.0f), VectorSetFloat1(157.0f), VectorSetFloat1(113.0f));
+		const VectorRegister4Float H0[4] = {Base, VectorAdd(VectorSetFloat1(157.0f), Base), VectorAdd(VectorSetFloat1(113.0f), Base), VectorAdd(VectorSetFloat1(157.0f + 113.0f), Base)};
+
+		VectorRegister4Float A[4] = {H0[0], H0[1], H0[2], H0[3]};
+		VectorRegister4Float B[4];
+		for(int32 Component = 0; Component < 4; ++Component)
+		{
+			B[Component] = VectorAdd(H0[Component], VectorSetFloat1(7.0f));
+		}
+		Hash44V(A);
+		Hash44V(B);
+
+		VectorRegister4Float H[4];
+		for(int32 Component = 0; Component < 4; ++Component)
+		{
+			H[Component] = VectorAdd(A[Component], VectorMultiply(VectorSubtract(B[Component], A[Component]), PX));
+		}
+
+		// h.xy = lerp(h.xz, h.yw, p.y)
+		const VectorRegister4Float X = LerpV(H[0], H[1], PY);
+		const VectorRegister4Float Y = LerpV(H[2], H[3], PY);
+		return LerpV(X, Y, PZ);
+	}
+
+	template<EPSFSinHash SinHash>
+	VectorRegister4Float N2DV(const VectorRegister4Float &InX, const VectorRegister4Float &InY)
+	{
+		const VectorRegister4Float IX = VectorFloor(InX);
+		const VectorRegister4Float IY = VectorFloor(InY);
+		const VectorRegister4Float PX = SmoothV(VectorSubtract(InX, IX));
+		const VectorRegister4Float PY = SmoothV(VectorSubtract(InY, IY));
+
+		const VectorRegister4Float Base = VectorAdd(IX, VectorMultiply(IY, VectorSetFloat1(113.0f)));
+		const float Offsets[4] = {0.0f, 1.0f, 113.0f, 114.0f};
+		VectorRegister4Float H[4];
+		for(int32 Corner = 0; Corner < 4; ++Corner)
+		{
+			H[Corner] = SinHashV<SinHash>(FModV(VectorAdd(VectorSetFloat1(Offsets[Corner]), Base), 6.2831853f), 43758.5453f);
+		}
+
+		// dot(mul(float2x2(h), float2(1 - p.y, p.y)), float2(1 - p.x, p.x))
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float OneMinusY = VectorSubtract(One, PY);
+		const VectorRegister4Float Row0 = VectorAdd(VectorMultiply(H[0], OneMinusY), VectorMultiply(H[1], PY));
+		const VectorRegister4Float Row1 = VectorAdd(VectorMultiply(H[2], OneMinusY), VectorMultiply(H[3], PY));
+		return VectorAdd(VectorMultiply(Row0, VectorSubtract(One, PX)), VectorMultiply(Row1, PX));
+	}
+
+	/** dot(hash22(p + e), f - e) for the cell corner e */
+	template<EPSFSinHash SinHash>
+	FORCEINLINE VectorRegister4Float GradientDotV(const VectorRegister4Float &PX, const VectorRegister4Float &PY, const VectorRegister4Float &FX, const VectorRegister4Float &FY,
+		float EX, float EY)
+	{
+		const VectorRegister4Float CornerX = VectorAdd(PX, VectorSetFloat1(EX));
+		const VectorRegister4Float CornerY = VectorAdd(PY, VectorSetFloat1(EY));
+		const VectorRegister4Float N = SinV<SinHash>(VectorAdd(VectorMultiply(CornerX, VectorSetFloat1(113.0f)), CornerY));
+
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+		const VectorRegister4Float HashX = VectorSubtract(VectorMultiply(FracV(VectorMultiply(VectorSetFloat1(2097152.0f), N)), Two), One);
+		const VectorRegister4Float HashY = VectorSubtract(VectorMultiply(FracV(VectorMultiply(VectorSetFloat1(262144.0f), N)), Two), One);
+		return VectorAdd(VectorMultiply(HashX, VectorSubtract(FX, VectorSetFloat1(EX))), VectorMultiply(HashY, VectorSubtract(FY, VectorSetFloat1(EY))));
+	}
+
+	template<EPSFSinHash SinHash>
+	VectorRegister4Float GradN2DV(const VectorRegister4Float &InX, const VectorRegister4Float &InY)
+	{
+		const VectorRegister4Float PX = VectorFloor(InX);
+		const VectorRegister4Float PY = VectorFloor(InY);
+		const VectorRegister4Float FX = VectorSubtract(InX, PX);
+		const VectorRegister4Float FY = VectorSubtract(InY, PY);
+		const VectorRegister4Float WX = SmoothV(FX);
+		const VectorRegister4Float WY = SmoothV(FY);
+
+		const VectorRegister4Float C = LerpV(
+			LerpV(GradientDotV<SinHash>(PX, PY, FX, FY, 0.0f, 0.0f), GradientDotV<SinHash>(PX, PY, FX, FY, 1.0f, 0.0f), WX),
+			LerpV(GradientDotV<SinHash>(PX, PY, FX, FY, 0.0f, 1.0f), GradientDotV<SinHash>(PX, PY, FX, FY, 1.0f, 1.0f), WX),
+			WY);
+		const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+		return VectorAdd(VectorMultiply(C, Half), Half);
+	}
+
+	template<EPSFSinHash SinHash>
+	VectorRegister4Float HashNoiseV(const VectorRegister4Float &InX, const VectorRegister4Float &InY, const VectorRegister4Float &InZ)
+	{
+		const VectorRegister4Float FX = VectorFloor(InX);
+		const VectorRegister4Float FY = VectorFloor(InY);
+		const VectorRegister4Float FZ = VectorFloor(InZ);
+		const VectorRegister4Float PX = SmoothV(VectorSubtract(InX, FX));
+		const VectorRegister4Float PY = SmoothV(VectorSubtract(InY, FY));
+		const VectorRegister4Float PZ = SmoothV(VectorSubtract(InZ, FZ));
+
+		// magic = (7, 157, 113)
+		const VectorRegister4Float Base = Dot3V(FX, FY, FZ, VectorSetFloat1(7.0f), VectorSetFloat1(157.0f), VectorSetFloat1(113.0f));
+		const VectorRegister4Float H0[4] = {Base, VectorAdd(VectorSetFloat1(157.0f), Base), VectorAdd(VectorSetFloat1(113.0f), Base), VectorAdd(VectorSetFloat1(157.0f + 113.0f), Base)};
+
+		VectorRegister4Float Sin[8];
+		for(int32 Corner = 0; Corner < 4; ++Corner)
+		{
+			Sin[Corner * 2] = H0[Corner];
+			Sin[Corner * 2 + 1] = VectorAdd(H0[Corner], VectorSetFloat1(7.0f));
+		}
+		SinV<SinHash>(Sin);
+
+		VectorRegister4Float H[4];
+		for(int32 Corner = 0; Corner < 4; ++Corner)
+		{
+			const VectorRegister4Float Scale = VectorSetFloat1(43785.5f);
+			H[Corner] = LerpV(FracV(VectorMultiply(Sin[Corner * 2], Scale)), FracV(VectorMultiply(Sin[Corner * 2 + 1], Scale)), PX);
+		}
+
+		// h.xy = lerp(h.xz, h.yw, p.y)
+		const VectorRegister4Float X = LerpV(H[0], H[1], PY);
+		const VectorRegister4Float Y = LerpV(H[2], H[3], PY);
+		return LerpV(X, Y, PZ);
+	}
+
+	/**
+	 * Calls Kernel with four points at a time in structure-of-arrays layout and writes its four results. The lanes past
+	 * the end repeat the last point and are not written.
+	 */
+	template<typename KernelType>
+	void ForEachPacket(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues, KernelType Kernel)
+	{
+		check(Points.Num() == OutValues.Num());
+		for(int32 Start = 0; Start < Points.Num(); Start += 4)
+		{
+			const int32 Count = FMath::Min(4, Points.Num() - Start);
+			alignas(16) float X[4], Y[4], Z[4], Result[4];
+			for(int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const FVector3f &Point = Points[Start + FMath::Min(Lane, Count - 1)];
+				X[Lane] = Point.X;
+				Y[Lane] = Point.Y;
+				Z[Lane] = Point.Z;
+			}
+			VectorStoreAligned(Kernel(VectorLoadAligned(X), VectorLoadAligned(Y), VectorLoadAligned(Z)), Result);
+			FMemory::Memcpy(&OutValues[Start], Result, Count * sizeof(float));
+		}
+	}
+
+	template<typename KernelType>
+	void ForEachPacket(TConstArrayView<FVector2f> Points, TArrayView<float> OutValues, KernelType Kernel)
+	{
+		check(Points.Num() == OutValues.Num());
+		for(int32 Start = 0; Start < Points.Num(); Start += 4)
+		{
+			const int32 Count = FMath::Min(4, Points.Num() - Start);
+			alignas(16) float X[4], Y[4], Result[4];
+			for(int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const FVector2f &Point = Points[Start + FMath::Min(Lane, Count - 1)];
+				X[Lane] = Point.X;
+				Y[Lane] = Point.Y;
+			}
+			VectorStoreAligned(Kernel(VectorLoadAligned(X), VectorLoadAligned(Y)), Result);
+			FMemory::Memcpy(&OutValues[Start], Result, Count * sizeof(float));
+		}
+	}
+}
+
+void PSFNoise::SNoiseBatch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues)
+{
+	ForEachPacket(Points, OutValues, SNoiseV);
+}
+
+void PSFNoise::N31Batch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues)
+{
+	ForEachPacket(Points, OutValues, N31V);
+}
+
+void PSFNoise::FbmN31Batch(TConstArrayView<FVector3f> Points, int32 Octaves, TArrayView<float> OutValues)
+{
+	ForEachPacket(Points, OutValues, [Octaves](VectorRegister4Float X, VectorRegister4Float Y, VectorRegister4Float Z)
+	{
+		const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+		VectorRegister4Float Value = VectorZeroFloat();
+		float Amplitude = 0.5f;
+		for(int32 Octave = 0; Octave < Octaves; ++Octave)
+		{
+			Value = VectorAdd(Value, VectorMultiply(VectorSetFloat1(Amplitude), N31V(X, Y, Z)));
+			X = VectorMultiply(X, Two);
+			Y = VectorMultiply(Y, Two);
+			Z = VectorMultiply(Z, Two);
+			Amplitude *= 0.5f;
+		}
+		return Value;
+	});
+}
+
+void PSFNoise::Hash44Batch(TConstArrayView<FVector4f> Points, TArrayView<FVector4f> OutValues)
+{
+	check(Points.Num() == OutValues.Num());
+	for(int32 Start = 0; Start < Points.Num(); Start += 4)
+	{
+		const int32 Count = FMath::Min(4, Points.Num() - Start);
+		alignas(16) float Components[4][4];
+		for(int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			const FVector4f &Point = Points[Start + FMath::Min(Lane, Count - 1)];
+			Components[0][Lane] = Point.X;
+			Components[1][Lane] = Point.Y;
+			Components[2][Lane] = Point.Z;
+			Components[3][Lane] = Point.W;
+		}
+
+		VectorRegister4Float P[4];
+		for(int32 Component = 0; Component < 4; ++Component)
+		{
+			P[Component] = VectorLoadAligned(Components[Component]);
+		}
+		Hash44V(P);
+		for(int32 Component = 0; Component < 4; ++Component)
+		{
+			VectorStoreAligned(P[Component], Components[Component]);
+		}
+
+		for(int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			OutValues[Start + Lane] = FVector4f(Components[0][Lane], Components[1][Lane], Components[2][Lane], Components[3][Lane]);
+		}
+	}
+}
+
+void PSFNoise::N2DBatch(TConstArrayView<FVector2f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash)
+{
+	if(SinHash == EPSFSinHash::Fast)
+	{
+		ForEachPacket(Points, OutValues, N2DV<EPSFSinHash::Fast>);
+	}
+	else
+	{
+		ForEachPacket(Points, OutValues, N2DV<EPSFSinHash::Exact>);
+	}
+}
+
+void PSFNoise::GradN2DBatch(TConstArrayView<FVector2f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash)
+{
+	if(SinHash == EPSFSinHash::Fast)
+	{
+		ForEachPacket(Points, OutValues, GradN2DV<EPSFSinHash::Fast>);
+	}
+	else
+	{
+		ForEachPacket(Points, OutValues, GradN2DV<EPSFSinHash::Exact>);
+	}
+}
+
+void PSFNoise::HashNoiseBatch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash)
+{
+	if(SinHash == EPSFSinHash::Fast)
+	{
+		ForEachPacket(Points, OutValues, HashNoiseV<EPSFSinHash::Fast>);
+	}
+	else
+	{
+		ForEachPacket(Points, OutValues, HashNoiseV<EPSFSinHash::Exact>);
+	}
+}
@@ -0,0 +1,706 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFRenderCommandlet.h"
+#include "PSFScene.h"
+#include "PSFCpuRaymarcher.h"
+#include "PSFLightGrid.h"
+#include "PSFMarchProfile.h"
+#include "PSFWater.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "ImageCore.h"
+#include "ImageUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	struct FImageDifference
+	{
+		double MaxError = 0.0;
+		double RootMeanSquareError = 0.0;
+	};
+
+	bool CompareToGolden(const FImage &Rendered, const FString &GoldenPath, FImageDifference &OutDifference)
+	{
+		FImage Golden;
+		if(!FImageUtils::LoadImage(*GoldenPath, Golden))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to load golden image: %s"), *GoldenPath);
+			return false;
+		}
+
+		if(Golden.SizeX != Rendered.SizeX || Golden.SizeY != Rendered.SizeY)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Golden image is %dx%d, the render is %dx%d."), Golden.SizeX, Golden.SizeY, Rendered.SizeX, Rendered.SizeY);
+			return false;
+		}
+
+		Golden.ChangeFormat(ERawImageFormat::BGRA8, Rendered.GammaSpace);
+		const TArrayView64<const FColor> GoldenPixels = Golden.AsBGRA8();
+		const TArrayView64<const FColor> RenderedPixels = Rendered.AsBGRA8();
+
+		double SumSquared = 0.0;
+		for(int64 Index = 0; Index < RenderedPixels.Num(); ++Index)
+		{
+			const FColor &A = RenderedPixels[Index];
+			const FColor &B = GoldenPixels[Index];
+			const double Channels[3] = {
+				FMath::Abs(A.R - B.R) / 255.0,
+				FMath::Abs(A.G - B.G) / 255.0,
+				FMath::Abs(A.B - B.B) / 255.0
+			};
+			for(double Channel : Channels)
+			{
+				OutDifference.MaxError = FMath::Max(OutDifference.MaxError, Channel);
+				SumSquared += Channel * Channel;
+			}
+		}
+		OutDifference.RootMeanSquareError = FMath::Sqrt(SumSquared / (RenderedPixels.Num() * 3.0));
+		return true;
+	}
+
+	/** Random analytic primitives in a cube in front of the default camera, sized so the cube stays about equally filled */
+	FPSFScene MakeRandomScene(int32 NumSDFs, int32 Seed)
+	{
+		const EPSFSdfType Types[] = {EPSFSdfType::Sphere, EPSFSdfType::RoundBox, EPSFSdfType::Torus, EPSFSdfType::Octahedron, EPSFSdfType::Ellipsoid};
+		const float Extent = 3.0f;
+		const float Scale = 1.5f * Extent / FMath::Max(1.0f, FMath::Pow(float(NumSDFs), 1.0f / 3.0f));
+
+		FRandomStream Random(Seed);
+		FPSFScene Scene;
+		for(int32 Index = 0; Index < NumSDFs; ++Index)
+		{
+			FPSFSdf Sdf;
+			Sdf.Type = Types[Random.RandHelper(UE_ARRAY_COUNT(Types))];
+			Sdf.Position = FVector3f(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent));
+			Sdf.Radius = Scale * Random.FRandRange(0.2f, 0.4f);
+			Sdf.Size = Scale * FVector3f(Random.FRandRange(0.15f, 0.4f), Random.FRandRange(0.15f, 0.4f), Random.FRandRange(0.1f, 0.3f));
+			if(Sdf.Type == EPSFSdfType::RoundBox)
+			{
+				Sdf.Radius = 0.05f * Scale;
+			}
+			Sdf.Rotation = FPSFMatrix3::FromAxisAngle(FVector3f(Random.GetUnitVector()), Random.FRandRange(0.0f, UE_TWO_PI));
+			Sdf.Material.BaseColor = FVector3f(Random.FRand(), Random.FRand(), Random.FRand());
+			Scene.SDFs.Add(Sdf);
+		}
+		return Scene;
+	}
+
+	/** Renders random scenes of growing size with and without the BVH, reports time and SDF evaluations per ray */
+	int32 RunScalingBenchmark(const FString &Params)
+	{
+		FString CountsString = TEXT("8,32,128,512,1024");
+		FParse::Value(*Params, TEXT("Counts="), CountsString, false);
+		TArray<FString> CountStrings;
+		CountsString.ParseIntoArray(CountStrings, TEXT(","));
+
+		FPSFRenderSettings Settings;
+		Settings.Width = 256;
+		Settings.Height = 256;
+		FParse::Value(*Params, TEXT("Width="), Settings.Width);
+		FParse::Value(*Params, TEXT("Height="), Settings.Height);
+		Settings.bUsePackets = !FParse::Param(*Params, TEXT("NoPackets"));
+
+		int32 Seed = 1;
+		FParse::Value(*Params, TEXT("Seed="), Seed);
+
+		UE_LOG(LogTemp, Display, TEXT("%8s %14s %14s %12s %12s %8s"), TEXT("SDFs"), TEXT("brute ms"), TEXT("bvh ms"), TEXT("brute ev/ray"), TEXT("bvh ev/ray"), TEXT("speedup"));
+
+		FString Json = TEXT("[\n");
+		for(int32 CountIndex = 0; CountIndex < CountStrings.Num(); ++CountIndex)
+		{
+			const int32 NumSDFs = FCString::Atoi(*CountStrings[CountIndex]);
+			const FPSFScene Scene = MakeRandomScene(NumSDFs, Seed);
+
+			TArray<FLinearColor> Pixels;
+			FPSFRenderStats BruteForce;
+			FPSFRenderStats Hierarchy;
+			Settings.bUseBvh = false;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, BruteForce);
+			Settings.bUseBvh = true;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, Hierarchy);
+
+			const double Rays = FMath::Max<int64>(BruteForce.Rays, 1);
+			const double Speedup = Hierarchy.Seconds > 0.0 ? BruteForce.Seconds / Hierarchy.Seconds : 0.0;
+			UE_LOG(LogTemp, Display, TEXT("%8d %14.2f %14.2f %12.1f %12.1f %7.2fx"), NumSDFs, BruteForce.Seconds * 1000.0, Hierarchy.Seconds * 1000.0,
+				BruteForce.SdfEvaluations / Rays, Hierarchy.SdfEvaluations / Rays, Speedup);
+
+			Json += FString::Printf(TEXT("\t{\"sdfs\": %d, \"bruteForceSeconds\": %f, \"bvhSeconds\": %f, \"bruteForceEvaluations\": %lld, \"bvhEvaluations\": %lld}%s\n"),
+				NumSDFs, BruteForce.Seconds, Hierarchy.Seconds, BruteForce.SdfEvaluations, Hierarchy.SdfEvaluations, CountIndex + 1 < CountStrings.Num() ? TEXT(",") : TEXT(""));
+		}
+		Json += TEXT("]\n");
+
+		FString StatsPath;
+		if(FParse::Value(*Params, TEXT("Stats="), StatsPath))
+		{
+			FFileHelper::SaveStringToFile(Json, *StatsPath);
+		}
+		return 0;
+	}
+
+	void ParseMarchSettings(const FString &Params, FPSFRenderSettings &InOutSettings)
+	{
+		FString MarchMode;
+		if(FParse::Value(*Params, TEXT("March="), MarchMode))
+		{
+			InOutSettings.MarchMode = MarchMode.Equals(TEXT("relaxed"), ESearchCase::IgnoreCase) ? EPSFMarchMode::Relaxed : EPSFMarchMode::Plain;
+		}
+		FParse::Value(*Params, TEXT("Relaxation="), InOutSettings.Relaxation);
+		FParse::Value(*Params, TEXT("ConePrepass="), InOutSettings.ConePrepassTexel);
+	}
+
+	/** Largest per-channel difference and the share of pixels that differ by more than one 8 bit step */
+	void ComparePixels(const TArray<FLinearColor> &Reference, const TArray<FLinearColor> &Pixels, double &OutMaxError, double &OutChangedPixels)
+	{
+		OutMaxError = 0.0;
+		int64 Changed = 0;
+		for(int32 Index = 0; Index < Pixels.Num(); ++Index)
+		{
+			const FLinearColor Difference = (Reference[Index] - Pixels[Index]).GetAbs();
+			const double Error = FMath::Max3(Difference.R, Difference.G, Difference.B);
+			OutMaxError = FMath::Max(OutMaxError, Error);
+			Changed += Error > 1.0 / 255.0 ? 1 : 0;
+		}
+		OutChangedPixels = Pixels.Num() > 0 ? double(Changed) / Pixels.Num() : 0.0;
+	}
+
+	/** Random point lights in and around the cube of MakeRandomScene, their reach shrinks as they get denser */
+	void AddRandomLights(FPSFScene &Scene, int32 NumLights, int32 Seed)
+	{
+		const float Extent = 4.0f;
+		const float Scale = FMath::Clamp(4.0f / FMath::Pow(float(FMath::Max(NumLights, 1)), 1.0f / 3.0f), 0.5f, 2.0f);
+
+		FRandomStream Random(Seed);
+		for(int32 Index = 0; Index < NumLights; ++Index)
+		{
+			FPSFPointLight Light;
+			Light.Position = FVector3f(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent));
+			Light.Color = FVector3f(Random.FRandRange(0.2f, 1.0f), Random.FRandRange(0.2f, 1.0f), Random.FRandRange(0.2f, 1.0f));
+			Light.Intensity = 4.0f;
+			Light.Radius = Scale * Random.FRandRange(1.0f, 2.0f);
+			Scene.PointLights.Add(Light);
+		}
+	}
+
+	/**
+	 * Renders a random scene with a growing number of point lights, shaded with every light and with the lights of each
+	 * screen tile, reports the binning time, lights per pixel and the largest difference between both images
+	 */
+	int32 RunLightScalingBenchmark(const FString &Params)
+	{
+		FString CountsString = TEXT("16,64,256,1024");
+		FParse::Value(*Params, TEXT("LightCounts="), CountsString, false);
+		TArray<FString> CountStrings;
+		CountsString.ParseIntoArray(CountStrings, TEXT(","));
+
+		FPSFRenderSettings Settings;
+		Settings.Width = 256;
+		Settings.Height = 256;
+		FParse::Value(*Params, TEXT("Width="), Settings.Width);
+		FParse::Value(*Params, TEXT("Height="), Settings.Height);
+		FParse::Value(*Params, TEXT("LightTileSize="), Settings.LightTileSize);
+
+		int32 NumSDFs = 64;
+		int32 Seed = 1;
+		FParse::Value(*Params, TEXT("SDFs="), NumSDFs);
+		FParse::Value(*Params, TEXT("Seed="), Seed);
+
+		// the binning alone is too fast to time once
+		const int32 BinningRepeats = 20;
+
+		UE_LOG(LogTemp, Display, TEXT("Point lights on %d SDFs at %dx%d, %d px tiles:"), NumSDFs, Settings.Width, Settings.Height, Settings.LightTileSize);
+		UE_LOG(LogTemp, Display, TEXT("%8s %10s %10s %10s %10s %10s %12s %12s %10s"), TEXT("lights"), TEXT("bin ms"), TEXT("avg/tile"), TEXT("max/tile"),
+			TEXT("all ms"), TEXT("tiled ms"), TEXT("all l/px"), TEXT("tiled l/px"), TEXT("max diff"));
+
+		FString Json = TEXT("[\n");
+		for(int32 CountIndex = 0; CountIndex < CountStrings.Num(); ++CountIndex)
+		{
+			const int32 NumLights = FCString::Atoi(*CountStrings[CountIndex]);
+			FPSFScene Scene = MakeRandomScene(NumSDFs, Seed);
+			Scene.LightingModel = EPSFLightingModel::BlinnPhong;
+			AddRandomLights(Scene, NumLights, Seed + 1);
+
+			FPSFLightGrid Grid;
+			const FPSFMatrix3 CameraMatrix = Scene.ComputeCameraMatrix();
+			const double BinningStartTime = FPlatformTime::Seconds();
+			for(int32 Repeat = 0; Repeat < BinningRepeats; ++Repeat)
+			{
+				Grid.Build(Scene.PointLights, Scene.RayOrigin, CameraMatrix, Settings.Width, Settings.Height, Settings.LightTileSize);
+			}
+			const double BinningSeconds = (FPlatformTime::Seconds() - BinningStartTime) / BinningRepeats;
+
+			TArray<FLinearColor> Reference;
+			TArray<FLinearColor> Pixels;
+			FPSFRenderStats AllLights;
+			FPSFRenderStats Tiled;
+			Settings.bUseLightGrid = false;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Reference, AllLights);
+			Settings.bUseLightGrid = true;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, Tiled);
+
+			double MaxError = 0.0;
+			double ChangedPixels = 0.0;
+			ComparePixels(Reference, Pixels, MaxError, ChangedPixels);
+
+			UE_LOG(LogTemp, Display, TEXT("%8d %10.3f %10.1f %10d %10.2f %10.2f %12.1f %12.1f %10.5f"), NumLights, BinningSeconds * 1000.0, Grid.GetAverageLightsPerTile(),
+				Grid.GetMaxLightsPerTile(), AllLights.Seconds * 1000.0, Tiled.Seconds * 1000.0, AllLights.LightsPerPixel(), Tiled.LightsPerPixel(), MaxError);
+
+			Json += FString::Printf(TEXT("\t{\"lights\": %d, \"visibleLights\": %d, \"binningSeconds\": %f, \"averageLightsPerTile\": %f, \"maxLightsPerTile\": %d, ")
+				TEXT("\"allLightsSeconds\": %f, \"tiledSeconds\": %f, \"allLightsPerPixel\": %f, \"tiledLightsPerPixel\": %f, \"maxError\": %f}%s\n"),
+				NumLights, Grid.GetVisibleLights(), BinningSeconds, Grid.GetAverageLightsPerTile(), Grid.GetMaxLightsPerTile(), AllLights.Seconds, Tiled.Seconds,
+				AllLights.LightsPerPixel(), Tiled.LightsPerPixel(), MaxError, CountIndex + 1 < CountStrings.Num() ? TEXT(",") : TEXT(""));
+		}
+		Json += TEXT("]\n");
+
+		FString StatsPath;
+		if(FParse::Value(*Params, TEXT("Stats="), StatsPath))
+		{
+			FFileHelper::SaveStringToFile(Json, *StatsPath);
+		}
+		return 0;
+	}
+
+	/** Steps per pixel of traceWater with the default camera of the scene, OutMaxDeviation is the largest t difference of a hit against the plain march */
+	double MeasureWaterSteps(const FPSFScene &Scene, const FPSFRenderSettings &Settings, EPSFMarchMode MarchMode, TArray<float> &InOutPlainT, float &OutMaxDeviation)
+	{
+		const FPSFMatrix3 CameraMatrix = Scene.ComputeCameraMatrix();
+		const int32 NumPixels = Settings.Width * Settings.Height;
+		const bool bPlain = MarchMode == EPSFMarchMode::Plain;
+		if(bPlain)
+		{
+			InOutPlainT.SetNumZeroed(NumPixels);
+		}
+
+		TArray<int32> Steps;
+		TArray<float> Deviations;
+		Steps.SetNumZeroed(Settings.Height);
+		Deviations.SetNumZeroed(Settings.Height);
+		ParallelFor(Settings.Height, [&](int32 Y)
+		{
+			for(int32 X = 0; X < Settings.Width; ++X)
+			{
+				const FVector3f Direction = FPSFCpuRaymarcher::ComputeRayDirection(CameraMatrix, FPSFCpuRaymarcher::PixelToUV(X, Y, Settings.Width, Settings.Height));
+				int32 PixelSteps = 0;
+				const FVector4f Hit = PSFWater::TraceWater(Scene.RayOrigin, Direction, Settings.Time, Scene.RaymarchStoppingCriterium,
+					FPSFMarchState(0.0f, MarchMode, Settings.Relaxation), PixelSteps);
+				Steps[Y] += PixelSteps;
+
+				// rays that run out of steps stop anywhere, only converged hits are compared
+				const bool bConverged = PixelSteps < 100 && Hit.W < Scene.RaymarchStoppingCriterium;
+				float &PlainT = InOutPlainT[Y * Settings.Width + X];
+				if(bPlain)
+				{
+					PlainT = bConverged ? Hit.W : -1.0f;
+				}
+				else if(bConverged && PlainT >= 0.0f)
+				{
+					Deviations[Y] = FMath::Max(Deviations[Y], FMath::Abs(Hit.W - PlainT));
+				}
+			}
+		});
+
+		int64 TotalSteps = 0;
+		OutMaxDeviation = 0.0f;
+		for(int32 Y = 0; Y < Settings.Height; ++Y)
+		{
+			TotalSteps += Steps[Y];
+			OutMaxDeviation = FMath::Max(OutMaxDeviation, Deviations[Y]);
+		}
+		return NumPixels > 0 ? double(TotalSteps) / NumPixels : 0.0;
+	}
+
+	/** Renders the scene with every march strategy, reports steps per pixel, time and the difference to plain sphere tracing */
+	int32 RunMarchComparison(const FPSFScene &Scene, const FString &ScenePath, const FString &Params, FPSFRenderSettings Settings)
+	{
+		int32 PrepassTexel = 8;
+		FParse::Value(*Params, TEXT("ConePrepass="), PrepassTexel);
+
+		struct FStrategy
+		{
+			const TCHAR *Name;
+			EPSFMarchMode MarchMode;
+			int32 ConePrepassTexel;
+		};
+		const FStrategy Strategies[] = {
+			{TEXT("plain"), EPSFMarchMode::Plain, 0},
+			{TEXT("relaxed"), EPSFMarchMode::Relaxed, 0},
+			{TEXT("plain+cone"), EPSFMarchMode::Plain, PrepassTexel},
+			{TEXT("relaxed+cone"), EPSFMarchMode::Relaxed, PrepassTexel},
+		};
+
+		UE_LOG(LogTemp, Display, TEXT("March strategies for %s at %dx%d, relaxation %.2f, cone prepass texel %d px:"), *ScenePath, Settings.Width, Settings.Height,
+			Settings.Relaxation, PrepassTexel);
+		UE_LOG(LogTemp, Display, TEXT("%-14s %12s %12s %10s %10s %10s"), TEXT("strategy"), TEXT("steps/px"), TEXT("prepass/px"), TEXT("ms"), TEXT("max diff"), TEXT("changed"));
+
+		TArray<FLinearColor> Reference;
+		FString Json = TEXT("{\n\t\"strategies\": [\n");
+		for(int32 StrategyIndex = 0; StrategyIndex < UE_ARRAY_COUNT(Strategies); ++StrategyIndex)
+		{
+			const FStrategy &Strategy = Strategies[StrategyIndex];
+			Settings.MarchMode = Strategy.MarchMode;
+			Settings.ConePrepassTexel = Strategy.ConePrepassTexel;
+
+			TArray<FLinearColor> Pixels;
+			FPSFRenderStats Stats;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, Stats);
+
+			double MaxError = 0.0;
+			double ChangedPixels = 0.0;
+			if(StrategyIndex == 0)
+			{
+				Reference = MoveTemp(Pixels);
+			}
+			else
+			{
+				ComparePixels(Reference, Pixels, MaxError, ChangedPixels);
+			}
+
+			const double Rays = FMath::Max<int64>(Stats.Rays, 1);
+			UE_LOG(LogTemp, Display, TEXT("%-14s %12.2f %12.2f %10.2f %10.4f %9.3f%%"), Strategy.Name, Stats.StepsPerPixel(), Stats.PrepassSteps / Rays, Stats.Seconds * 1000.0,
+				MaxError, ChangedPixels * 100.0);
+			Json += FString::Printf(TEXT("\t\t{\"strategy\": \"%s\", \"stepsPerPixel\": %f, \"prepassStepsPerPixel\": %f, \"seconds\": %f, \"maxError\": %f, \"changedPixels\": %f}%s\n"),
+				Strategy.Name, Stats.StepsPerPixel(), Stats.PrepassSteps / Rays, Stats.Seconds, MaxError, ChangedPixels, StrategyIndex + 1 < UE_ARRAY_COUNT(Strategies) ? TEXT(",") : TEXT(""));
+		}
+
+		// traceWater has no prepass, its surface is not a scene SDF
+		TArray<float> PlainT;
+		float Deviation = 0.0f;
+		const double PlainWaterSteps = MeasureWaterSteps(Scene, Settings, EPSFMarchMode::Plain, PlainT, Deviation);
+		const double RelaxedWaterSteps = MeasureWaterSteps(Scene, Settings, EPSFMarchMode::Relaxed, PlainT, Deviation);
+		UE_LOG(LogTemp, Display, TEXT("traceWater: %.2f steps/px plain, %.2f relaxed, largest hit distance difference %.4f."), PlainWaterSteps, RelaxedWaterSteps, Deviation);
+		Json += FString::Printf(TEXT("\t],\n\t\"waterPlainStepsPerPixel\": %f,\n\t\"waterRelaxedStepsPerPixel\": %f,\n\t\"waterMaxDeviation\": %f\n}\n"),
+			PlainWaterSteps, RelaxedWaterSteps, Deviation);
+
+		FString StatsPath;
+		if(FParse::Value(*Params, TEXT("Stats="), StatsPath))
+		{
+			FFileHelper::SaveStringToFile(Json, *StatsPath);
+		}
+		return 0;
+	}
+
+	/**
+	 * One frame of traceWater from the eye and from the reprojection of InOutHistory (traceWaterTemporal), the history is
+	 * replaced with the temporal hits. OutMaxDeviation is the largest t difference of a converged hit between both.
+	 */
+	void MeasureWaterTemporal(const FPSFScene &Scene, const FPSFRenderSettings &Settings, FPSFTemporalHistory &InOutHistory, double &OutFullSteps,
+		double &OutTemporalSteps, double &OutReprojected, float &OutMaxDeviation)
+	{
+		const FPSFMatrix3 CameraMatrix = Scene.ComputeCameraMatrix();
+		const int32 NumPixels = Settings.Width * Settings.Height;
+		const bool bUseHistory = InOutHistory.IsValid() && InOutHistory.Width == Settings.Width && InOutHistory.Height == Settings.Height;
+
+		TArray<float> Depth;
+		Depth.SetNumUninitialized(NumPixels);
+		TArray<int64> FullSteps;
+		TArray<int64> TemporalSteps;
+		TArray<int64> Reprojected;
+		TArray<float> Deviations;
+		FullSteps.SetNumZeroed(Settings.Height);
+		TemporalSteps.SetNumZeroed(Settings.Height);
+		Reprojected.SetNumZeroed(Settings.Height);
+		Deviations.SetNumZeroed(Settings.Height);
+		ParallelFor(Settings.Height, [&](int32 Y)
+		{
+			for(int32 X = 0; X < Settings.Width; ++X)
+			{
+				const FVector2f UV = FPSFCpuRaymarcher::PixelToUV(X, Y, Settings.Width, Settings.Height);
+				const FVector3f Direction = FPSFCpuRaymarcher::ComputeRayDirection(CameraMatrix, UV);
+				int32 PixelSteps = 0;
+				const FVector4f FullHit = PSFWater::TraceWater(Scene.RayOrigin, Direction, Settings.Time, Scene.RaymarchStoppingCriterium,
+					FPSFMarchState(0.0f, Settings.MarchMode, Settings.Relaxation), PixelSteps);
+				FullSteps[Y] += PixelSteps;
+
+				// a start below the waves of this frame marches from the eye, the check is one more step
+				float StartT = bUseHistory ? FPSFCpuRaymarcher::ReprojectStart(InOutHistory, Scene.RayOrigin, Direction, FPSFCpuRaymarcher::UVToScreenUV(UV), Settings) : 0.0f;
+				if(StartT > 0.0f)
+				{
+					++TemporalSteps[Y];
+					if(PSFWater::ComputeWave(Scene.RayOrigin + Direction * StartT, Settings.Time) < 0.0f)
+					{
+						StartT = 0.0f;
+					}
+					else
+					{
+						++Reprojected[Y];
+					}
+				}
+				int32 TemporalPixelSteps = 0;
+				const FVector4f TemporalHit = PSFWater::TraceWater(Scene.RayOrigin, Direction, Settings.Time, Scene.RaymarchStoppingCriterium,
+					FPSFMarchState(StartT, Settings.MarchMode, Settings.Relaxation), TemporalPixelSteps);
+				TemporalSteps[Y] += TemporalPixelSteps;
+
+				// rays that run out of steps stop anywhere, they neither seed the history nor count as a deviation
+				const bool bFullConverged = PixelSteps < 100 && FullHit.W <= Scene.RaymarchStoppingCriterium;
+				const bool bTemporalConverged = TemporalPixelSteps < 100 && TemporalHit.W <= Scene.RaymarchStoppingCriterium;
+				Depth[Y * Settings.Width + X] = bTemporalConverged ? FPSFCpuRaymarcher::TemporalDepth(TemporalHit, Scene.RaymarchStoppingCriterium) : -1.0f;
+				if(bFullConverged && bTemporalConverged)
+				{
+					Deviations[Y] = FMath::Max(Deviations[Y], FMath::Abs(TemporalHit.W - FullHit.W));
+				}
+			}
+		});
+
+		int64 TotalFullSteps = 0;
+		int64 TotalTemporalSteps = 0;
+		int64 TotalReprojected = 0;
+		OutMaxDeviation = 0.0f;
+		for(int32 Y = 0; Y < Settings.Height; ++Y)
+		{
+			TotalFullSteps += FullSteps[Y];
+			TotalTemporalSteps += TemporalSteps[Y];
+			TotalReprojected += Reprojected[Y];
+			OutMaxDeviation = FMath::Max(OutMaxDeviation, Deviations[Y]);
+		}
+		const double Pixels = FMath::Max(NumPixels, 1);
+		OutFullSteps = TotalFullSteps / Pixels;
+		OutTemporalSteps = TotalTemporalSteps / Pixels;
+		OutReprojected = TotalReprojected / Pixels;
+
+		InOutHistory.Eye = Scene.RayOrigin;
+		InOutHistory.CameraMatrix = CameraMatrix;
+		InOutHistory.Width = Settings.Width;
+		InOutHistory.Height = Settings.Height;
+		InOutHistory.Depth = MoveTemp(Depth);
+	}
+
+	/**
+	 * Renders a short animation of the scene, the time advances by FrameTime and the camera orbits the look at point by
+	 * Orbit degrees per frame. Every frame is marched from the eye and from the reprojected history of the frame before,
+	 * for the scene and for traceWater, and the steps per pixel, the share of reprojected rays and the difference are logged.
+	 */
+	int32 RunTemporalComparison(FPSFScene Scene, const FString &ScenePath, const FString &Params, FPSFRenderSettings Settings)
+	{
+		int32 NumFrames = 16;
+		float FrameTime = 0.033f;
+		float Orbit = 0.5f;
+		FParse::Value(*Params, TEXT("Frames="), NumFrames);
+		FParse::Value(*Params, TEXT("FrameTime="), FrameTime);
+		FParse::Value(*Params, TEXT("Orbit="), Orbit);
+
+		UE_LOG(LogTemp, Display, TEXT("Temporal reprojection for %s at %dx%d, %d frames of %.3f s, orbit %.2f degrees per frame:"), *ScenePath, Settings.Width, Settings.Height,
+			NumFrames, FrameTime, Orbit);
+		UE_LOG(LogTemp, Display, TEXT("%6s %10s %10s %10s %10s %10s %10s %10s %10s"), TEXT("frame"), TEXT("full/px"), TEXT("temp/px"), TEXT("reproj"), TEXT("max diff"), TEXT("changed"),
+			TEXT("water/px"), TEXT("temp/px"), TEXT("water dt"));
+
+		const FVector3f Offset = Scene.RayOrigin - Scene.LookAt;
+		const float StartTime = Settings.Time;
+		FPSFTemporalHistory History;
+		FPSFTemporalHistory WaterHistory;
+		double SumFull = 0.0;
+		double SumTemporal = 0.0;
+		double SumWaterFull = 0.0;
+		double SumWaterTemporal = 0.0;
+		FString Json = TEXT("{\n\t\"frames\": [\n");
+		for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Settings.Frame = Frame;
+			Settings.Time = StartTime + Frame * FrameTime;
+			Scene.RayOrigin = Scene.LookAt + FPSFMatrix3::FromAxisAngle(FVector3f(0.0f, 1.0f, 0.0f), FMath::DegreesToRadians(Orbit * Frame)).MulColumn(Offset);
+
+			TArray<FLinearColor> Reference;
+			TArray<FLinearColor> Pixels;
+			FPSFRenderStats FullStats;
+			FPSFRenderStats TemporalStats;
+			FPSFCpuRaymarcher::Render(Scene, Settings, Reference, FullStats);
+			FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, TemporalStats, &History);
+
+			double MaxError = 0.0;
+			double ChangedPixels = 0.0;
+			ComparePixels(Reference, Pixels, MaxError, ChangedPixels);
+
+			double WaterFull = 0.0;
+			double WaterTemporal = 0.0;
+			double WaterReprojected = 0.0;
+			float WaterDeviation = 0.0f;
+			MeasureWaterTemporal(Scene, Settings, WaterHistory, WaterFull, WaterTemporal, WaterReprojected, WaterDeviation);
+
+			const double Reprojected = double(TemporalStats.TemporalStarts) / FMath::Max<int64>(TemporalStats.Rays, 1);
+			UE_LOG(LogTemp, Display, TEXT("%6d %10.2f %10.2f %9.1f%% %10.4f %9.3f%% %10.2f %10.2f %10.4f"), Frame, FullStats.StepsPerPixel(), TemporalStats.StepsPerPixel(),
+				Reprojected * 100.0, MaxError, ChangedPixels * 100.0, WaterFull, WaterTemporal, WaterDeviation);
+			Json += FString::Printf(TEXT("\t\t{\"frame\": %d, \"stepsPerPixel\": %f, \"temporalStepsPerPixel\": %f, \"reprojected\": %f, \"maxError\": %f, \"changedPixels\": %f, ")
+				TEXT("\"waterStepsPerPixel\": %f, \"waterTemporalStepsPerPixel\": %f, \"waterReprojected\": %f, \"waterMaxDeviation\": %f}%s\n"),
+				Frame, FullStats.StepsPerPixel(), TemporalStats.StepsPerPixel(), Reprojected, MaxError, ChangedPixels, WaterFull, WaterTemporal, WaterReprojected, WaterDeviation,
+				Frame + 1 < NumFrames ? TEXT(",") : TEXT(""));
+
+			// the first frame has no history, it is left out of the averages
+			if(Frame > 0)
+			{
+				SumFull += FullStats.StepsPerPixel();
+				SumTemporal += TemporalStats.StepsPerPixel();
+				SumWaterFull += WaterFull;
+				SumWaterTemporal += WaterTemporal;
+			}
+		}
+
+		const int32 Measured = FMath::Max(NumFrames - 1, 1);
+		UE_LOG(LogTemp, Display, TEXT("Average over the reprojected frames: scene %.2f -> %.2f steps/px, traceWater %.2f -> %.2f steps/px."), SumFull / Measured,
+			SumTemporal / Measured, SumWaterFull / Measured, SumWaterTemporal / Measured);
+		Json += FString::Printf(TEXT("\t],\n\t\"stepsPerPixel\": %f,\n\t\"temporalStepsPerPixel\": %f,\n\t\"waterStepsPerPixel\": %f,\n\t\"waterTemporalStepsPerPixel\": %f\n}\n"),
+			SumFull / Measured, SumTemporal / Measured, SumWaterFull / Measured, SumWaterTemporal / Measured);
+
+		FString StatsPath;
+		if(FParse::Value(*Params, TEXT("Stats="), StatsPath))
+		{
+			FFileHelper::SaveStringToFile(Json, *StatsPath);
+		}
+		return 0;
+	}
+
+	/** Writes <Prefix>_<view>.png for every debug view and the totals to <Prefix>.json */
+	bool WriteMarchCounters(const FPSFScene &Scene, const FPSFMarchProfile &Profile, const FString &Prefix)
+	{
+		// the evaluation views are scaled to the most expensive pixel
+		const float MaxEvaluations = FMath::Max(1, Profile.GetMaxValue(EPSFDebugView::Evaluations));
+		for(const EPSFDebugView View : {EPSFDebugView::Steps, EPSFDebugView::Evaluations, EPSFDebugView::Dolphins, EPSFDebugView::Exit, EPSFDebugView::CostliestSdf})
+		{
+			FImage Image(Profile.Width, Profile.Height, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+			TArrayView64<FColor> ImagePixels = Image.AsBGRA8();
+			for(int32 Index = 0; Index < Profile.Pixels.Num(); ++Index)
+			{
+				ImagePixels[Index] = Profile.GetDebugColor(Index, View, MaxEvaluations).ToFColor(false);
+			}
+
+			const FString Path = FString::Printf(TEXT("%s_%s.png"), *Prefix, FPSFMarchProfile::GetViewName(View));
+			if(!FImageUtils::SaveImageByExtension(*Path, Image))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Failed to write image: %s"), *Path);
+				return false;
+			}
+		}
+
+		const FString JsonPath = Prefix + TEXT(".json");
+		FFileHelper::SaveStringToFile(Profile.ToJsonString(Scene), *JsonPath);
+		UE_LOG(LogTemp, Display, TEXT("March counters written to %s_*.png and %s, evaluation views scaled to %d evaluations."), *Prefix, *JsonPath, int32(MaxEvaluations));
+		return true;
+	}
+}
+
+UPSFRenderCommandlet::UPSFRenderCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPSFRenderCommandlet::Main(const FString &Params)
+{
+	if(FParse::Param(*Params, TEXT("ScalingBenchmark")))
+	{
+		return RunScalingBenchmark(Params);
+	}
+	if(FParse::Param(*Params, TEXT("LightScalingBenchmark")))
+	{
+		return RunLightScalingBenchmark(Params);
+	}
+
+	FString ScenePath;
+	if(!FParse::Value(*Params, TEXT("Scene="), ScenePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PSFRender -Scene=<scene.json> -Out=<image.png> [-Width=] [-Height=] [-Time=] [-TileSize=] [-NoPackets] [-NoBvh] [-LightTileSize=] [-NoLightGrid] [-March=plain|relaxed] [-ConePrepass=] [-CompareMarch] [-CompareTemporal] [-Counters=] [-sRGB] [-Golden=] [-Tolerance=] [-Stats=]"));
+		return 1;
+	}
+
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
+	{
+		return 1;
+	}
+
+	FPSFRenderSettings Settings;
+	FParse::Value(*Params, TEXT("Width="), Settings.Width);
+	FParse::Value(*Params, TEXT("Height="), Settings.Height);
+	FParse::Value(*Params, TEXT("Time="), Settings.Time);
+	FParse::Value(*Params, TEXT("TileSize="), Settings.TileSize);
+	FParse::Value(*Params, TEXT("LightTileSize="), Settings.LightTileSize);
+	Settings.bUseLightGrid = !FParse::Param(*Params, TEXT("NoLightGrid"));
+	Settings.bUsePackets = !FParse::Param(*Params, TEXT("NoPackets"));
+	Settings.bUseBvh = !FParse::Param(*Params, TEXT("NoBvh"));
+	ParseMarchSettings(Params, Settings);
+
+	if(FParse::Param(*Params, TEXT("CompareMarch")))
+	{
+		return RunMarchComparison(Scene, ScenePath, Params, Settings);
+	}
+	if(FParse::Param(*Params, TEXT("CompareTemporal")))
+	{
+		return RunTemporalComparison(Scene, ScenePath, Params, Settings);
+	}
+
+	FString OutPath = FPaths::ChangeExtension(ScenePath, TEXT("png"));
+	FParse::Value(*Params, TEXT("Out="), OutPath);
+
+	UE_LOG(LogTemp, Display, TEXT("Rendering %s (%d SDFs) at %dx%d, %s."), *ScenePath, Scene.SDFs.Num(), Settings.Width, Settings.Height,
+		Settings.bUsePackets ? TEXT("4-wide packets") : TEXT("single rays"));
+
+	// the counters need the scalar path, which makes the render slower
+	FString CountersPrefix;
+	const bool bCounters = FParse::Value(*Params, TEXT("Counters="), CountersPrefix);
+	FPSFMarchProfile Profile;
+
+	TArray<FLinearColor> Pixels;
+	FPSFRenderStats Stats;
+	FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, Stats, nullptr, bCounters ? &Profile : nullptr);
+
+	UE_LOG(LogTemp, Display, TEXT("Rendered in %.3f s: %.2f Mrays/s, %.2f M SDF evaluations/s, %.1f steps/pixel (%lld of them in the cone prepass)."),
+		Stats.Seconds, Stats.RaysPerSecond() / 1e6, Stats.SdfEvaluationsPerSecond() / 1e6, Stats.StepsPerPixel(), Stats.PrepassSteps);
+
+	// engine captures of the post process material are the raw shader output, -sRGB encodes like a tonemapped capture
+	const bool bSRGB = FParse::Param(*Params, TEXT("sRGB"));
+	FImage Image(Settings.Width, Settings.Height, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+	TArrayView64<FColor> ImagePixels = Image.AsBGRA8();
+	for(int32 Index = 0; Index < Pixels.Num(); ++Index)
+	{
+		ImagePixels[Index] = Pixels[Index].ToFColor(bSRGB);
+	}
+
+	if(!FImageUtils::SaveImageByExtension(*OutPath, Image))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write image: %s"), *OutPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Image written to: %s"), *OutPath);
+
+	if(bCounters)
+	{
+		Profile.LogSummary(Scene);
+		if(!WriteMarchCounters(Scene, Profile, CountersPrefix))
+		{
+			return 1;
+		}
+	}
+
+	FString StatsPath;
+	if(FParse::Value(*Params, TEXT("Stats="), StatsPath))
+	{
+		const FString StatsJson = FString::Printf(
+			TEXT("{\n\t\"width\": %d,\n\t\"height\": %d,\n\t\"sdfs\": %d,\n\t\"seconds\": %f,\n\t\"raysPerSecond\": %f,\n\t\"sdfEvaluationsPerSecond\": %f,\n\t\"marchSteps\": %lld,\n\t\"prepassSteps\": %lld,\n\t\"stepsPerPixel\": %f\n}\n"),
+			Settings.Width, Settings.Height, Scene.SDFs.Num(), Stats.Seconds, Stats.RaysPerSecond(), Stats.SdfEvaluationsPerSecond(), Stats.MarchSteps, Stats.PrepassSteps, Stats.StepsPerPixel());
+		FFileHelper::SaveStringToFile(StatsJson, *StatsPath);
+	}
+
+	FString GoldenPath;
+	if(FParse::Value(*Params, TEXT("Golden="), GoldenPath))
+	{
+		float Tolerance = 0.02f;
+		FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+		FImageDifference Difference;
+		if(!CompareToGolden(Image, GoldenPath, Difference))
+		{
+			return 1;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Golden comparison: max error %.4f, rmse %.4f (tolerance %.4f)."), Difference.MaxError, Difference.RootMeanSquareError, Tolerance);
+		if(Difference.MaxError > Tolerance)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Render differs from %s."), *GoldenPath);
+			return 1;
+		}
+	}
+
+	return 0;
+}
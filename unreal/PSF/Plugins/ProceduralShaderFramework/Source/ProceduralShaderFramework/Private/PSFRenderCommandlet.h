@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PSFRenderCommandlet.generated.h"
+
+/**
+ * Renders a json scene description with the CPU reference raymarcher, without a GPU and without opening the editor UI.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFRender -Scene=<scene.json> -Out=<image.png>
+ *     [-Width=512] [-Height=512] [-Time=0] [-TileSize=16] [-NoPackets] [-NoBvh] [-LightTileSize=16] [-NoLightGrid] [-sRGB]
+ *     [-March=plain|relaxed] [-Relaxation=1.2] [-ConePrepass=<pixels per prepass texel>]
+ *     [-Golden=<capture.png>] [-Tolerance=0.02] [-Stats=<stats.json>] [-Counters=<prefix>]
+ *
+ * With -Golden the render is compared against an engine capture and the commandlet fails if the
+ * largest per-channel difference exceeds the tolerance. -Counters renders on the scalar path and writes the march
+ * counters of every pixel as heatmaps <prefix>_<view>.png and the totals and per SDF costs to <prefix>.json.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFRender -ScalingBenchmark [-Counts=8,32,128,512,1024] [-Seed=1] [-Stats=<scaling.json>]
+ *
+ * renders random scenes of increasing primitive count with and without the BVH and logs time and SDF evaluations per ray.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFRender -LightScalingBenchmark [-LightCounts=16,64,256,1024] [-LightTileSize=16] [-SDFs=64] [-Seed=1] [-Stats=<lights.json>]
+ *
+ * renders a random scene with a growing number of point lights, shaded with every light and with the lights binned into
+ * screen tiles, and logs the binning time, lights per pixel, time and the largest difference between both images.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFRender -Scene=<scene.json> -CompareMarch [-ConePrepass=8] [-Relaxation=1.2] [-Stats=<march.json>]
+ *
+ * renders the scene with every march strategy and logs steps per pixel, time and the difference to plain sphere tracing,
+ * and the steps of traceWater with and without relaxation.
+ *
+ * UnrealEditor-Cmd PSF.uproject -run=PSFRender -Scene=<scene.json> -CompareTemporal [-Frames=16] [-FrameTime=0.033] [-Orbit=0.5] [-Stats=<temporal.json>]
+ *
+ * animates the scene with an orbiting camera and logs per frame the steps per pixel of marching from the eye and from the
+ * reprojected hits of the frame before, for the scene and for traceWater, and the difference between both images.
+ */
+UCLASS()
+class UPSFRenderCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPSFRenderCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,380 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFScene.h"
+#include "Misc/FileHelper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	struct FSdfTypeName
+	{
+		EPSFSdfType Type;
+		const TCHAR *Name;
+	};
+
+	const FSdfTypeName SdfTypeNames[] = {
+		{EPSFSdfType::Sphere, TEXT("sphere")},
+		{EPSFSdfType::RoundBox, TEXT("roundBox")},
+		{EPSFSdfType::Torus, TEXT("torus")},
+		{EPSFSdfType::HexPrism, TEXT("hexPrism")},
+		{EPSFSdfType::Octahedron, TEXT("octahedron")},
+		{EPSFSdfType::Ellipsoid, TEXT("ellipsoid")},
+		{EPSFSdfType::Dolphin, TEXT("dolphin")},
+		{EPSFSdfType::Rock, TEXT("rock")},
+		{EPSFSdfType::Desert, TEXT("desert")},
+		{EPSFSdfType::Custom, TEXT("custom")}
+	};
+
+	struct FLightingModelName
+	{
+		EPSFLightingModel Model;
+		const TCHAR *Name;
+	};
+
+	const FLightingModelName LightingModelNames[] = {
+		{EPSFLightingModel::None, TEXT("none")},
+		{EPSFLightingModel::Phong, TEXT("phong")},
+		{EPSFLightingModel::Lambert, TEXT("lambert")},
+		{EPSFLightingModel::BlinnPhong, TEXT("blinnPhong")},
+		{EPSFLightingModel::FakeSpecular, TEXT("fakeSpecular")},
+		{EPSFLightingModel::LambertDiffuse, TEXT("lambertDiffuse")},
+		{EPSFLightingModel::Toon, TEXT("toon")},
+		{EPSFLightingModel::PBR, TEXT("pbr")},
+		{EPSFLightingModel::Rim, TEXT("rim")},
+		{EPSFLightingModel::SoftSS, TEXT("softSS")},
+		{EPSFLightingModel::Fresnel, TEXT("fresnel")},
+		{EPSFLightingModel::UVGradient, TEXT("uvGradient")},
+		{EPSFLightingModel::UVAnisotropic, TEXT("uvAnisotropic")},
+		{EPSFLightingModel::Sunrise, TEXT("sunrise")}
+	};
+
+	bool ReadVector(const TSharedPtr<FJsonObject> &Object, const TCHAR *Field, FVector3f &OutVector)
+	{
+		const TArray<TSharedPtr<FJsonValue>> *Values = nullptr;
+		if(!Object->TryGetArrayField(Field, Values) || Values->Num() != 3)
+		{
+			return false;
+		}
+
+		OutVector = FVector3f((*Values)[0]->AsNumber(), (*Values)[1]->AsNumber(), (*Values)[2]->AsNumber());
+		return true;
+	}
+
+	void ReadFloat(const TSharedPtr<FJsonObject> &Object, const TCHAR *Field, float &OutValue)
+	{
+		double Value;
+		if(Object->TryGetNumberField(Field, Value))
+		{
+			OutValue = static_cast<float>(Value);
+		}
+	}
+
+	TArray<TSharedPtr<FJsonValue>> MakeVector(const FVector3f &Vector)
+	{
+		return {
+			MakeShared<FJsonValueNumber>(Vector.X),
+			MakeShared<FJsonValueNumber>(Vector.Y),
+			MakeShared<FJsonValueNumber>(Vector.Z)
+		};
+	}
+
+	void ReadMaterial(const TSharedPtr<FJsonObject> &Object, FPSFMaterialParams &OutMaterial)
+	{
+		ReadVector(Object, TEXT("baseColor"), OutMaterial.BaseColor);
+		ReadVector(Object, TEXT("specularColor"), OutMaterial.SpecularColor);
+		ReadFloat(Object, TEXT("specularStrength"), OutMaterial.SpecularStrength);
+		ReadFloat(Object, TEXT("shininess"), OutMaterial.Shininess);
+		ReadFloat(Object, TEXT("roughness"), OutMaterial.Roughness);
+		ReadFloat(Object, TEXT("metallic"), OutMaterial.Metallic);
+		ReadFloat(Object, TEXT("rimPower"), OutMaterial.RimPower);
+		ReadFloat(Object, TEXT("fakeSpecularPower"), OutMaterial.FakeSpecularPower);
+		ReadVector(Object, TEXT("fakeSpecularColor"), OutMaterial.FakeSpecularColor);
+		ReadFloat(Object, TEXT("ior"), OutMaterial.Ior);
+		ReadFloat(Object, TEXT("refractionStrength"), OutMaterial.RefractionStrength);
+		ReadVector(Object, TEXT("refractionTint"), OutMaterial.RefractionTint);
+	}
+
+	TSharedRef<FJsonObject> WriteMaterial(const FPSFMaterialParams &Material)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetArrayField(TEXT("baseColor"), MakeVector(Material.BaseColor));
+		Object->SetArrayField(TEXT("specularColor"), MakeVector(Material.SpecularColor));
+		Object->SetNumberField(TEXT("specularStrength"), Material.SpecularStrength);
+		Object->SetNumberField(TEXT("shininess"), Material.Shininess);
+		Object->SetNumberField(TEXT("roughness"), Material.Roughness);
+		Object->SetNumberField(TEXT("metallic"), Material.Metallic);
+		Object->SetNumberField(TEXT("rimPower"), Material.RimPower);
+		Object->SetNumberField(TEXT("fakeSpecularPower"), Material.FakeSpecularPower);
+		Object->SetArrayField(TEXT("fakeSpecularColor"), MakeVector(Material.FakeSpecularColor));
+		Object->SetNumberField(TEXT("ior"), Material.Ior);
+		Object->SetNumberField(TEXT("refractionStrength"), Material.RefractionStrength);
+		Object->SetArrayField(TEXT("refractionTint"), MakeVector(Material.RefractionTint));
+		return Object;
+	}
+}
+
+FPSFMatrix3 FPSFMatrix3::FromAxisAngle(const FVector3f &Axis, float Angle)
+{
+	const float C = FMath::Cos(Angle);
+	const float S = FMath::Sin(Angle);
+	const float MinusC = 1.0f - C;
+
+	return FPSFMatrix3(
+		FVector3f(C + Axis.X * Axis.X * MinusC, Axis.X * Axis.Y * MinusC - Axis.Z * S, Axis.X * Axis.Z * MinusC + Axis.Y * S),
+		FVector3f(Axis.Y * Axis.X * MinusC + Axis.Z * S, C + Axis.Y * Axis.Y * MinusC, Axis.Y * Axis.Z * MinusC - Axis.X * S),
+		FVector3f(Axis.Z * Axis.X * MinusC - Axis.Y * S, Axis.Z * Axis.Y * MinusC + Axis.X * S, C + Axis.Z * Axis.Z * MinusC));
+}
+
+FPSFMatrix3 FPSFScene::ComputeCameraMatrix() const
+{
+	const FVector3f Forward = (LookAt - RayOrigin).GetSafeNormal();
+	const FVector3f Right = (Forward ^ FVector3f(0, 1, 0)).GetSafeNormal();
+	const FVector3f Up = Right ^ Forward;
+	return FPSFMatrix3(Right, Up, -Forward);
+}
+
+bool FPSFScene::LoadFromJsonFile(const FString &FilePath)
+{
+	FString JsonString;
+	if(!FFileHelper::LoadFileToString(JsonString, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read scene file: %s"), *FilePath);
+		return false;
+	}
+
+	return LoadFromJsonString(JsonString);
+}
+
+bool FPSFScene::LoadFromJsonString(const FString &JsonString)
+{
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if(!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Scene description is not valid json."));
+		return false;
+	}
+
+	*this = FPSFScene();
+
+	const TSharedPtr<FJsonObject> *Camera = nullptr;
+	if(Root->TryGetObjectField(TEXT("camera"), Camera))
+	{
+		ReadVector(*Camera, TEXT("rayOrigin"), RayOrigin);
+		ReadVector(*Camera, TEXT("lookAt"), LookAt);
+	}
+	ReadFloat(Root, TEXT("raymarchStoppingCriterium"), RaymarchStoppingCriterium);
+
+	const TSharedPtr<FJsonObject> *Lighting = nullptr;
+	if(Root->TryGetObjectField(TEXT("lighting"), Lighting))
+	{
+		FString ModelName;
+		if((*Lighting)->TryGetStringField(TEXT("model"), ModelName) && !PSFScene::LightingModelFromString(ModelName, LightingModel))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Unknown lighting model '%s'."), *ModelName);
+			return false;
+		}
+		ReadVector(*Lighting, TEXT("lightPosition"), LightPosition);
+		ReadVector(*Lighting, TEXT("rimColor"), RimColor);
+
+		const TArray<TSharedPtr<FJsonValue>> *LightValues = nullptr;
+		if((*Lighting)->TryGetArrayField(TEXT("pointLights"), LightValues))
+		{
+			for(const TSharedPtr<FJsonValue> &LightValue : *LightValues)
+			{
+				const TSharedPtr<FJsonObject> LightObject = LightValue->AsObject();
+				if(!LightObject.IsValid())
+				{
+					continue;
+				}
+
+				FPSFPointLight Light;
+				ReadVector(LightObject, TEXT("position"), Light.Position);
+				ReadVector(LightObject, TEXT("color"), Light.Color);
+				ReadFloat(LightObject, TEXT("intensity"), Light.Intensity);
+				ReadFloat(LightObject, TEXT("radius"), Light.Radius);
+				PointLights.Add(Light);
+			}
+		}
+	}
+
+	const TArray<TSharedPtr<FJsonValue>> *SdfValues = nullptr;
+	if(!Root->TryGetArrayField(TEXT("sdfs"), SdfValues))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Scene description has no 'sdfs' array."));
+		return false;
+	}
+
+	for(const TSharedPtr<FJsonValue> &SdfValue : *SdfValues)
+	{
+		const TSharedPtr<FJsonObject> SdfObject = SdfValue->AsObject();
+		if(!SdfObject.IsValid())
+		{
+			continue;
+		}
+
+		FPSFSdf Sdf;
+		FString TypeName;
+		if(!SdfObject->TryGetStringField(TEXT("type"), TypeName) || !PSFScene::SdfTypeFromString(TypeName, Sdf.Type))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Unknown SDF type '%s'."), *TypeName);
+			return false;
+		}
+
+		ReadVector(SdfObject, TEXT("position"), Sdf.Position);
+		ReadVector(SdfObject, TEXT("size"), Sdf.Size);
+		ReadFloat(SdfObject, TEXT("radius"), Sdf.Radius);
+		ReadFloat(SdfObject, TEXT("timeOffset"), Sdf.TimeOffset);
+		ReadFloat(SdfObject, TEXT("speed"), Sdf.Speed);
+		SdfObject->TryGetStringField(TEXT("name"), Sdf.CustomName);
+
+		// Rotations are either given like the add* functions take them (axis + angle in degrees) or as explicit rows
+		FVector3f Axis(0, 1, 0);
+		float Angle = 0.0f;
+		ReadVector(SdfObject, TEXT("axis"), Axis);
+		ReadFloat(SdfObject, TEXT("angle"), Angle);
+		Sdf.Rotation = FPSFMatrix3::FromAxisAngle(Axis.GetSafeNormal(), Angle * PI / 180.0f);
+
+		const TArray<TSharedPtr<FJsonValue>> *RotationRows = nullptr;
+		if(SdfObject->TryGetArrayField(TEXT("rotation"), RotationRows) && RotationRows->Num() == 3)
+		{
+			for(int32 Row = 0; Row < 3; ++Row)
+			{
+				const TArray<TSharedPtr<FJsonValue>> &Values = (*RotationRows)[Row]->AsArray();
+				if(Values.Num() == 3)
+				{
+					Sdf.Rotation.Rows[Row] = FVector3f(Values[0]->AsNumber(), Values[1]->AsNumber(), Values[2]->AsNumber());
+				}
+			}
+		}
+
+		const TSharedPtr<FJsonObject> *Material = nullptr;
+		if(SdfObject->TryGetObjectField(TEXT("material"), Material))
+		{
+			ReadMaterial(*Material, Sdf.Material);
+		}
+
+		SDFs.Add(Sdf);
+	}
+
+	return true;
+}
+
+FString FPSFScene::SaveToJsonString() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+
+	TSharedRef<FJsonObject> Camera = MakeShared<FJsonObject>();
+	Camera->SetArrayField(TEXT("rayOrigin"), MakeVector(RayOrigin));
+	Camera->SetArrayField(TEXT("lookAt"), MakeVector(LookAt));
+	Root->SetObjectField(TEXT("camera"), Camera);
+	Root->SetNumberField(TEXT("raymarchStoppingCriterium"), RaymarchStoppingCriterium);
+
+	TSharedRef<FJsonObject> Lighting = MakeShared<FJsonObject>();
+	Lighting->SetStringField(TEXT("model"), PSFScene::LightingModelToString(LightingModel));
+	Lighting->SetArrayField(TEXT("lightPosition"), MakeVector(LightPosition));
+	Lighting->SetArrayField(TEXT("rimColor"), MakeVector(RimColor));
+	if(PointLights.Num() > 0)
+	{
+		TArray<TSharedPtr<FJsonValue>> LightValues;
+		for(const FPSFPointLight &Light : PointLights)
+		{
+			TSharedRef<FJsonObject> LightObject = MakeShared<FJsonObject>();
+			LightObject->SetArrayField(TEXT("position"), MakeVector(Light.Position));
+			LightObject->SetArrayField(TEXT("color"), MakeVector(Light.Color));
+			LightObject->SetNumberField(TEXT("intensity"), Light.Intensity);
+			LightObject->SetNumberField(TEXT("radius"), Light.Radius);
+			LightValues.Add(MakeShared<FJsonValueObject>(LightObject));
+		}
+		Lighting->SetArrayField(TEXT("pointLights"), LightValues);
+	}
+	Root->SetObjectField(TEXT("lighting"), Lighting);
+
+	TArray<TSharedPtr<FJsonValue>> SdfValues;
+	for(const FPSFSdf &Sdf : SDFs)
+	{
+		TSharedRef<FJsonObject> SdfObject = MakeShared<FJsonObject>();
+		SdfObject->SetStringField(TEXT("type"), PSFScene::SdfTypeToString(Sdf.Type));
+		SdfObject->SetArrayField(TEXT("position"), MakeVector(Sdf.Position));
+		SdfObject->SetArrayField(TEXT("size"), MakeVector(Sdf.Size));
+		SdfObject->SetNumberField(TEXT("radius"), Sdf.Radius);
+		if(Sdf.Type == EPSFSdfType::Dolphin)
+		{
+			SdfObject->SetNumberField(TEXT("timeOffset"), Sdf.TimeOffset);
+			SdfObject->SetNumberField(TEXT("speed"), Sdf.Speed);
+		}
+		if(Sdf.Type == EPSFSdfType::Custom && !Sdf.CustomName.IsEmpty())
+		{
+			SdfObject->SetStringField(TEXT("name"), Sdf.CustomName);
+		}
+
+		TArray<TSharedPtr<FJsonValue>> RotationRows;
+		for(const FVector3f &Row : Sdf.Rotation.Rows)
+		{
+			RotationRows.Add(MakeShared<FJsonValueArray>(MakeVector(Row)));
+		}
+		SdfObject->SetArrayField(TEXT("rotation"), RotationRows);
+		SdfObject->SetObjectField(TEXT("material"), WriteMaterial(Sdf.Material));
+
+		SdfValues.Add(MakeShared<FJsonValueObject>(SdfObject));
+	}
+	Root->SetArrayField(TEXT("sdfs"), SdfValues);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(Root, Writer);
+	return JsonString;
+}
+
+const TCHAR *PSFScene::SdfTypeToString(EPSFSdfType Type)
+{
+	for(const FSdfTypeName &Entry : SdfTypeNames)
+	{
+		if(Entry.Type == Type)
+		{
+			return Entry.Name;
+		}
+	}
+	return TEXT("custom");
+}
+
+bool PSFScene::SdfTypeFromString(const FString &Name, EPSFSdfType &OutType)
+{
+	for(const FSdfTypeName &Entry : SdfTypeNames)
+	{
+		if(Name.Equals(Entry.Name, ESearchCase::IgnoreCase))
+		{
+			OutType = Entry.Type;
+			return true;
+		}
+	}
+	return false;
+}
+
+const TCHAR *PSFScene::LightingModelToString(EPSFLightingModel Model)
+{
+	for(const FLightingModelName &Entry : LightingModelNames)
+	{
+		if(Entry.Model == Model)
+		{
+			return Entry.Name;
+		}
+	}
+	return TEXT("none");
+}
+
+bool PSFScene::LightingModelFromString(const FString &Name, EPSFLightingModel &OutModel)
+{
+	for(const FLightingModelName &Entry : LightingModelNames)
+	{
+		if(Name.Equals(Entry.Name, ESearchCase::IgnoreCase))
+		{
+			OutModel = Entry.Model;
+			return true;
+		}
+	}
+	return false;
+}
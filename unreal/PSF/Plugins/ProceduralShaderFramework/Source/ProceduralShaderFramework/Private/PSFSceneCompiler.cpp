@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFSceneCompiler.h"
+#include "PSFCustomSDFRegistry.h"
+
+const TCHAR *FPSFSceneCompiler::OutputFileName = TEXT("CompiledScene.ush");
+
+namespace
+{
+	// p - s.position (3) + mul(float3, float3x3) (9)
+	const int32 TranslationOps = 3;
+	const int32 RotationOps = 9;
+
+	// normalize(axis) (7) + angle * PI / 180 (2) + computeRotationMatrix (26)
+	const int32 RotationSetupOps = 35;
+
+	/** Number of `s.type == N` compares evalSDF evaluates until it reaches the branch of the type */
+	int32 DispatchCompares(EPSFSdfType Type)
+	{
+		return Type == EPSFSdfType::Custom ? 10 : int32(Type) + 1;
+	}
+
+	FString HlslFloat(float Value)
+	{
+		FString Result = FString::Printf(TEXT("%.9g"), Value);
+		if(!Result.Contains(TEXT(".")) && !Result.Contains(TEXT("e")) && !Result.Contains(TEXT("n")))
+		{
+			Result += TEXT(".0");
+		}
+		return Result;
+	}
+
+	FString HlslFloat2(float X, float Y)
+	{
+		return FString::Printf(TEXT("float2(%s, %s)"), *HlslFloat(X), *HlslFloat(Y));
+	}
+
+	FString HlslFloat3(const FVector3f &V)
+	{
+		return FString::Printf(TEXT("float3(%s, %s, %s)"), *HlslFloat(V.X), *HlslFloat(V.Y), *HlslFloat(V.Z));
+	}
+
+	FString HlslFloat3x3(const FPSFMatrix3 &M)
+	{
+		return FString::Printf(TEXT("float3x3(%s, %s, %s, %s, %s, %s, %s, %s, %s)"),
+			*HlslFloat(M.Rows[0].X), *HlslFloat(M.Rows[0].Y), *HlslFloat(M.Rows[0].Z),
+			*HlslFloat(M.Rows[1].X), *HlslFloat(M.Rows[1].Y), *HlslFloat(M.Rows[1].Z),
+			*HlslFloat(M.Rows[2].X), *HlslFloat(M.Rows[2].Y), *HlslFloat(M.Rows[2].Z));
+	}
+
+	bool IsIdentity(const FPSFMatrix3 &M)
+	{
+		const float Tolerance = 1e-6f;
+		return M.Rows[0].Equals(FVector3f(1, 0, 0), Tolerance) && M.Rows[1].Equals(FVector3f(0, 1, 0), Tolerance) && M.Rows[2].Equals(FVector3f(0, 0, 1), Tolerance);
+	}
+
+	/** Emits the body of evalCompiledSDF<N>, mirrors the branch of evalSDF for the type. CustomSDF is the registry entry of a custom SDF. */
+	FString CompileSdf(int32 Index, const FPSFSdf &Sdf, const FPSFCustomSDF *CustomSDF, FPSFSceneCompilerStats &Stats)
+	{
+		const bool bTranslate = !Sdf.Position.Equals(FVector3f::ZeroVector, 0.0f);
+		// spheres are rotation invariant and the desert is evaluated without the probe point
+		const bool bRotate = !IsIdentity(Sdf.Rotation) && Sdf.Type != EPSFSdfType::Sphere && Sdf.Type != EPSFSdfType::Desert;
+
+		Stats.GenericDispatchComparesPerStep += DispatchCompares(Sdf.Type);
+		Stats.GenericTransformOpsPerStep += TranslationOps + RotationOps;
+		Stats.CompiledTransformOpsPerStep += (bTranslate ? TranslationOps : 0) + (bRotate ? RotationOps : 0);
+		Stats.GenericSetupOpsPerPixel += RotationSetupOps;
+		Stats.FoldedRotations += bRotate ? 0 : 1;
+		Stats.FoldedTranslations += bTranslate ? 0 : 1;
+
+		FString Code;
+		const FString Offset = bTranslate ? FString::Printf(TEXT("(p - %s)"), *HlslFloat3(Sdf.Position)) : FString(TEXT("p"));
+		if(Sdf.Type != EPSFSdfType::Desert)
+		{
+			Code += bRotate
+				? FString::Printf(TEXT("    float3 probePoint = mul(%s, %s);\n"), *Offset, *HlslFloat3x3(Sdf.Rotation))
+				: FString::Printf(TEXT("    float3 probePoint = %s;\n"), *Offset);
+		}
+
+		switch(Sdf.Type)
+		{
+		case EPSFSdfType::Sphere:
+			Code += FString::Printf(TEXT("    return length(probePoint) - %s;\n"), *HlslFloat(Sdf.Radius));
+			break;
+		case EPSFSdfType::RoundBox:
+			Code += FString::Printf(TEXT("    return sdRoundBox(probePoint, %s, %s);\n"), *HlslFloat3(Sdf.Size), *HlslFloat(Sdf.Radius));
+			break;
+		case EPSFSdfType::Torus:
+			Code += FString::Printf(TEXT("    return sdTorus(probePoint, %s);\n"), *HlslFloat2(Sdf.Size.Y, Sdf.Size.Z));
+			break;
+		case EPSFSdfType::HexPrism:
+			Code += FString::Printf(TEXT("    return sdHexPrism(probePoint, %s);\n"), *HlslFloat2(Sdf.Radius, Sdf.Radius));
+			break;
+		case EPSFSdfType::Octahedron:
+			Code += FString::Printf(TEXT("    return sdOctahedron(probePoint, %s);\n"), *HlslFloat(Sdf.Radius));
+			break;
+		case EPSFSdfType::Ellipsoid:
+			Code += FString::Printf(TEXT("    return sdEllipsoid(probePoint, %s);\n"), *HlslFloat3(Sdf.Size));
+			break;
+		case EPSFSdfType::Dolphin:
+			// the skeleton is computed once per pixel by updateCompiledDolphins
+			Code += FString::Printf(TEXT("    return dolphinSkeletonDistance(probePoint, compiledDolphin%d).x;\n"), Index);
+			break;
+		case EPSFSdfType::Rock:
+			Code += FString::Printf(TEXT("    return sdBox(probePoint, %s) - snoise(probePoint * 5.0) * 0.03;\n"), *HlslFloat3(Sdf.Size));
+			break;
+		case EPSFSdfType::Desert:
+			Code += FString::Printf(TEXT("    return mapDesert(%s);\n"), *Offset);
+			break;
+		case EPSFSdfType::Custom:
+			Code += FString::Printf(TEXT("    return sd%s(probePoint, time);\n"), *CustomSDF->Name);
+			break;
+		default:
+			Code += TEXT("    return 1e5;\n");
+			break;
+		}
+		return Code;
+	}
+
+	/** Assignments for the fields that differ from createDefaultMaterialParams */
+	FString CompileMaterial(const FPSFMaterialParams &Material)
+	{
+		const FPSFMaterialParams Default;
+		FString Code;
+		auto AddVector = [&Code](const TCHAR *Name, const FVector3f &Value, const FVector3f &DefaultValue)
+		{
+			if(!Value.Equals(DefaultValue, 0.0f))
+			{
+				Code += FString::Printf(TEXT("        mat.%s = %s;\n"), Name, *HlslFloat3(Value));
+			}
+		};
+		auto AddScalar = [&Code](const TCHAR *Name, float Value, float DefaultValue)
+		{
+			if(Value != DefaultValue)
+			{
+				Code += FString::Printf(TEXT("        mat.%s = %s;\n"), Name, *HlslFloat(Value));
+			}
+		};
+
+		AddVector(TEXT("baseColor"), Material.BaseColor, Default.BaseColor);
+		AddVector(TEXT("specularColor"), Material.SpecularColor, Default.SpecularColor);
+		AddScalar(TEXT("specularStrength"), Material.SpecularStrength, Default.SpecularStrength);
+		AddScalar(TEXT("shininess"), Material.Shininess, Default.Shininess);
+		AddScalar(TEXT("roughness"), Material.Roughness, Default.Roughness);
+		AddScalar(TEXT("metallic"), Material.Metallic, Default.Metallic);
+		AddScalar(TEXT("rimPower"), Material.RimPower, Default.RimPower);
+		AddScalar(TEXT("fakeSpecularPower"), Material.FakeSpecularPower, Default.FakeSpecularPower);
+		AddVector(TEXT("fakeSpecularColor"), Material.FakeSpecularColor, Default.FakeSpecularColor);
+		AddScalar(TEXT("ior"), Material.Ior, Default.Ior);
+		AddScalar(TEXT("refractionStrength"), Material.RefractionStrength, Default.RefractionStrength);
+		AddVector(TEXT("refractionTint"), Material.RefractionTint, Default.RefractionTint);
+		return Code;
+	}
+}
+
+bool FPSFSceneCompiler::Compile(const FPSFScene &Scene, const TArray<FPSFCustomSDF> &CustomSDFs, const FString &SourceName, FString &OutCode, FPSFSceneCompilerStats &OutStats)
+{
+	OutStats = FPSFSceneCompilerStats();
+	OutStats.NumSDFs = Scene.SDFs.Num();
+
+	// MyCustomSDFs.ush only defines the sd<Name> of registered SDFs
+	TArray<const FPSFCustomSDF *> SdfCustomSDFs;
+	SdfCustomSDFs.Init(nullptr, Scene.SDFs.Num());
+	bool bHasCustom = false;
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Index];
+		if(Sdf.Type != EPSFSdfType::Custom)
+		{
+			continue;
+		}
+
+		const FString Name = Sdf.CustomName.IsEmpty() ? FString(FPSFCustomSDFRegistry::LegacyName) : Sdf.CustomName;
+		SdfCustomSDFs[Index] = CustomSDFs.FindByPredicate([&Name](const FPSFCustomSDF &CustomSDF) { return CustomSDF.Name.Equals(Name, ESearchCase::CaseSensitive); });
+		if(!SdfCustomSDFs[Index])
+		{
+			UE_LOG(LogTemp, Error, TEXT("SDF %d is the custom SDF %s, which is not registered in %s."), Index, *Name, FPSFCustomSDFRegistry::FileName);
+			return false;
+		}
+		bHasCustom = true;
+	}
+
+	FString Code;
+	Code += FString::Printf(TEXT("// Generated by the ProceduralShaderFramework scene compiler from %s, changes are overwritten on the next compile.\n"), *SourceName);
+	Code += TEXT("#ifndef PROCEDURAL_SHADER_FRAMEWORK_COMPILED_SCENE_H\n");
+	Code += TEXT("#define PROCEDURAL_SHADER_FRAMEWORK_COMPILED_SCENE_H\n\n");
+	Code += TEXT("#include \"sdf_functions.ush\"\n");
+	if(bHasCustom)
+	{
+		Code += TEXT("#include \"MyCustomSDFs.ush\"\n");
+	}
+	Code += FString::Printf(TEXT("\n#define PSF_COMPILED_SCENE_SDFS %d\n\n"), Scene.SDFs.Num());
+
+	// the packer gives the dolphins their skeleton slots in the same order
+	FString DolphinUpdates;
+	FString DolphinLoads;
+	int32 DolphinSlot = 0;
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Index];
+		if(Sdf.Type == EPSFSdfType::Dolphin)
+		{
+			Code += FString::Printf(TEXT("static DolphinSkeleton compiledDolphin%d;\n"), Index);
+			DolphinUpdates += FString::Printf(TEXT("    compiledDolphin%d = computeDolphinSkeleton(%s, %s, %s, time);\n"), Index, *HlslFloat3(Sdf.Position), *HlslFloat(Sdf.TimeOffset), *HlslFloat(Sdf.Speed));
+			DolphinLoads += FString::Printf(TEXT("    compiledDolphin%d = loadDolphinSkeleton(sceneData, %d);\n"), Index, DolphinSlot++);
+		}
+	}
+	if(!DolphinUpdates.IsEmpty())
+	{
+		Code += TEXT("static bool gCompiledDolphinsLoaded = false;\n\n");
+	}
+
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		const FPSFSdf &Sdf = Scene.SDFs[Index];
+		Code += FString::Printf(TEXT("// %d: %s\n"), Index, PSFScene::SdfTypeToString(Sdf.Type));
+		Code += FString::Printf(TEXT("float evalCompiledSDF%d(float3 p, float time)\n{\n"), Index);
+		Code += CompileSdf(Index, Sdf, SdfCustomSDFs[Index], OutStats);
+		Code += TEXT("}\n\n");
+	}
+
+	// minimum over all SDFs, same comparison order as the loop in raymarchAll
+	Code += TEXT("float evalCompiledScene(float3 p, float time, out int hitIndex)\n{\n");
+	Code += TEXT("    float d = 1e5;\n    float dj;\n    hitIndex = -1;\n");
+	const int32 NumDolphins = Scene.SDFs.FilterByPredicate([](const FPSFSdf &Sdf) { return Sdf.Type == EPSFSdfType::Dolphin; }).Num();
+	Code += FString::Printf(TEXT("#if PSF_DEBUG_COUNTERS\n    gSdfEvaluations += %d;\n    gDolphinEvaluations += %d;\n#endif\n"), Scene.SDFs.Num(), NumDolphins);
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		Code += FString::Printf(TEXT("    dj = evalCompiledSDF%d(p, time);\n    if (dj < d) { d = dj; hitIndex = %d; }\n"), Index, Index);
+	}
+	Code += TEXT("    return d;\n}\n\n");
+
+	// only used for the normal of the hit, four calls per pixel
+	Code += TEXT("float evalCompiledSDF(int index, float3 p, float time = 0.0)\n{\n    switch (index)\n    {\n");
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		Code += FString::Printf(TEXT("    case %d: return evalCompiledSDF%d(p, time);\n"), Index, Index);
+	}
+	Code += TEXT("    default: return 1e5;\n    }\n}\n\n");
+
+	Code += TEXT("float3 getCompiledNormal(int index, float3 p)\n{\n");
+	Code += TEXT("    float h = 0.0001;\n    float2 k = float2(1, -1);\n");
+	Code += TEXT("    return normalize(k.xyy * evalCompiledSDF(index, p + k.xyy * h) + k.yyx * evalCompiledSDF(index, p + k.yyx * h)\n");
+	Code += TEXT("        + k.yxy * evalCompiledSDF(index, p + k.yxy * h) + k.xxx * evalCompiledSDF(index, p + k.xxx * h));\n}\n\n");
+
+	Code += TEXT("MaterialParams getCompiledMaterial(int index)\n{\n    MaterialParams mat = createDefaultMaterialParams();\n    switch (index)\n    {\n");
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		Code += FString::Printf(TEXT("    case %d:\n"), Index);
+		Code += CompileMaterial(Scene.SDFs[Index].Material);
+		Code += TEXT("        break;\n");
+	}
+	Code += TEXT("    }\n    return mat;\n}\n\n");
+
+	FString DesertCondition;
+	for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+	{
+		if(Scene.SDFs[Index].Type == EPSFSdfType::Desert)
+		{
+			DesertCondition += FString::Printf(TEXT("%shitIndex == %d"), DesertCondition.IsEmpty() ? TEXT("") : TEXT(" || "), Index);
+		}
+	}
+
+	// the time dependent part of every dolphin, once per pixel instead of once per distance evaluation
+	Code += TEXT("// raymarchCompiledScene calls it, code that calls evalCompiledScene on its own has to call it first\n");
+	Code += TEXT("void updateCompiledDolphins(float time)\n{\n");
+	if(!DolphinUpdates.IsEmpty())
+	{
+		Code += TEXT("    if (gCompiledDolphinsLoaded)\n        return;\n");
+	}
+	Code += DolphinUpdates;
+	Code += TEXT("}\n\n");
+
+	Code += TEXT("// loads the skeletons from the texture a UPSFSceneComponent packs for the same scene, updateCompiledDolphins then does nothing\n");
+	Code += TEXT("void loadCompiledDolphins(Texture2D sceneData)\n{\n");
+	Code += DolphinLoads;
+	if(!DolphinLoads.IsEmpty())
+	{
+		Code += TEXT("    gCompiledDolphinsLoaded = true;\n");
+	}
+	Code += TEXT("}\n\n");
+
+	Code += TEXT("// replaces the add* calls and raymarchAll for this scene, marches with the PSF_MARCH_MODE strategy\n");
+	Code += TEXT("void raymarchCompiledScene(float condition, float3x3 cameraMatrix, float2 uv, out float4 hitPosition, out float3 normal, out MaterialParams material, out float3 rayDirection, float time = 0.0)\n{\n");
+	Code += TEXT("    if (condition == 0)\n    {\n        cameraMatrix = computeCameraMatrix(float3(0, 0, 0), _rayOrigin, float3x3(1, 0, 0, 0, 1, 0, 0, 0, 1));\n    }\n\n");
+	Code += TEXT("    updateCompiledDolphins(time);\n");
+	Code += TEXT("    rayDirection = normalize(mul(float3(uv, -1), cameraMatrix));\n");
+	Code += TEXT("    MarchState march = beginMarch(0.0);\n    hitPosition = float4(0, 0, 0, 0);\n    int hitIndex;\n    gMarchSteps = 0;\n    beginMarchCounters();\n");
+	Code += TEXT("    for (int i = 0; i < 100; i++)\n    {\n");
+	Code += TEXT("        gMarchSteps++;\n        float t = march.t;\n");
+	Code += TEXT("        float3 currentPosition = _rayOrigin + rayDirection * t;\n");
+	Code += TEXT("        float d = evalCompiledScene(currentPosition, time, hitIndex);\n");
+	Code += TEXT("        countMarchStep(hitIndex);\n");
+	Code += TEXT("        if (!advanceMarch(march, d))\n            continue;\n");
+	Code += TEXT("        if (d < 0.001)\n        {\n");
+	Code += TEXT("            endMarchCounters(PSF_EXIT_HIT);\n");
+	Code += TEXT("            hitPosition = float4(currentPosition, t);\n");
+	Code += TEXT("            normal = getCompiledNormal(hitIndex, currentPosition);\n");
+	Code += TEXT("            material = getCompiledMaterial(hitIndex);\n");
+	if(!DesertCondition.IsEmpty())
+	{
+		Code += FString::Printf(TEXT("            if (%s)\n            {\n"), *DesertCondition);
+		Code += TEXT("                normal = doBumpMap(hitPosition.xyz, normal, 0.07);\n");
+		Code += TEXT("                getDesertColor(hitPosition.xyz, material.baseColor);\n            }\n");
+	}
+	Code += TEXT("            break;\n        }\n");
+	Code += TEXT("        if (t > _raymarchStoppingCriterium)\n        {\n");
+	Code += TEXT("            endMarchCounters(PSF_EXIT_ESCAPED);\n");
+	Code += TEXT("            hitPosition = float4(currentPosition, _raymarchStoppingCriterium + 1);\n            break;\n        }\n");
+	Code += TEXT("    }\n}\n\n");
+	Code += TEXT("#endif\n");
+
+	OutCode = MoveTemp(Code);
+	return true;
+}
+
+void FPSFSceneCompiler::LogStats(const FPSFSceneCompilerStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("Compiled %d SDFs, %d rotations and %d translations folded away."), Stats.NumSDFs, Stats.FoldedRotations, Stats.FoldedTranslations);
+	UE_LOG(LogTemp, Display, TEXT("Per march step: generic %d ops (%d type compares, %d transform), compiled %d ops."),
+		Stats.GenericOpsPerStep(), Stats.GenericDispatchComparesPerStep, Stats.GenericTransformOpsPerStep, Stats.CompiledTransformOpsPerStep);
+	UE_LOG(LogTemp, Display, TEXT("Per pixel setup: generic %d ops in the add* calls, compiled 0."), Stats.GenericSetupOpsPerPixel);
+}
@@ -0,0 +1,288 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFSceneComponent.h"
+#include "PSFLightGrid.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Misc/Paths.h"
+
+UPSFSceneComponent::UPSFSceneComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	bTickInEditor = true;
+}
+
+void UPSFSceneComponent::BindMaterial(UMaterialInstanceDynamic *Material)
+{
+	if(!Material)
+	{
+		return;
+	}
+
+	BoundMaterials.AddUnique(Material);
+	if(SceneTexture)
+	{
+		Material->SetTextureParameterValue(SceneTextureParameter, SceneTexture);
+	}
+	if(ConeStartTarget)
+	{
+		Material->SetTextureParameterValue(ConeStartParameter, ConeStartTarget);
+	}
+	if(LightGridTexture)
+	{
+		Material->SetTextureParameterValue(LightGridParameter, LightGridTexture);
+	}
+	if(TemporalDepthTargets[CurrentTemporalTarget])
+	{
+		Material->SetTextureParameterValue(TemporalDepthParameter, TemporalDepthTargets[CurrentTemporalTarget]);
+	}
+}
+
+bool UPSFSceneComponent::LoadSceneFromJsonFile(const FString &FilePath)
+{
+	FPSFScene Loaded;
+	if(!Loaded.LoadFromJsonFile(FilePath))
+	{
+		return false;
+	}
+	SetScene(Loaded);
+	return true;
+}
+
+int32 UPSFSceneComponent::AddSdf(const FPSFSdf &Sdf)
+{
+	bSceneDirty = true;
+	return Scene.SDFs.Add(Sdf);
+}
+
+void UPSFSceneComponent::SetSdf(int32 Index, const FPSFSdf &Sdf)
+{
+	if(!Scene.SDFs.IsValidIndex(Index))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SetSdf: index %d is out of range (%d SDFs)."), Index, Scene.SDFs.Num());
+		return;
+	}
+	Scene.SDFs[Index] = Sdf;
+	bSceneDirty = true;
+}
+
+void UPSFSceneComponent::RemoveSdf(int32 Index)
+{
+	if(!Scene.SDFs.IsValidIndex(Index))
+	{
+		UE_LOG(LogTemp, Error, TEXT("RemoveSdf: index %d is out of range (%d SDFs)."), Index, Scene.SDFs.Num());
+		return;
+	}
+	Scene.SDFs.RemoveAt(Index);
+	bSceneDirty = true;
+}
+
+void UPSFSceneComponent::SetScene(const FPSFScene &InScene)
+{
+	Scene = InScene;
+	bSceneDirty = true;
+}
+
+void UPSFSceneComponent::SetPointLights(const TArray<FPSFPointLight> &PointLights)
+{
+	Scene.PointLights = PointLights;
+	bSceneDirty = true;
+}
+
+void UPSFSceneComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if(!SceneFile.FilePath.IsEmpty())
+	{
+		const FString FilePath = FPaths::IsRelative(SceneFile.FilePath) ? FPaths::ProjectDir() / SceneFile.FilePath : SceneFile.FilePath;
+		LoadSceneFromJsonFile(FilePath);
+	}
+}
+
+void UPSFSceneComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	LastUploadedTexels = 0;
+
+	// swimming dolphins get a new skeleton every frame, the packer only uploads their skeleton texels. SDFs that moved
+	// stay flagged for the temporal march until the next pack, one more pack after the last edit clears them
+	const bool bAnimated = Packer.HasMovedSdfs() || Scene.SDFs.ContainsByPredicate([](const FPSFSdf &Sdf) { return Sdf.Type == EPSFSdfType::Dolphin && Sdf.Speed != 0.0f; });
+	if(bSceneDirty || (bAnimated && !bSceneRejected))
+	{
+		UploadDirtyRanges();
+	}
+
+	// the grid depends on the lights and the scene's camera, both only change through edits. A scene without lights
+	// still gets an empty grid, or the tiles of removed lights would keep shading
+	if(bSceneDirty)
+	{
+		UpdateLightGrid();
+	}
+	bSceneDirty = false;
+
+	// the camera may move every frame, the prepass is redrawn even if the scene did not change
+	if(ConePrepassMaterial && SceneTexture)
+	{
+		DrawConePrepass();
+	}
+	if(TemporalDepthMaterial && SceneTexture)
+	{
+		DrawTemporalDepth();
+	}
+}
+
+void UPSFSceneComponent::DrawConePrepass()
+{
+	const FIntPoint Resolution(FMath::Max(1, ConePrepassResolution.X), FMath::Max(1, ConePrepassResolution.Y));
+	if(!ConeStartTarget || ConeStartTarget->SizeX != Resolution.X || ConeStartTarget->SizeY != Resolution.Y)
+	{
+		// loadConeStart reads single texels, the target must not be filtered
+		ConeStartTarget = UKismetRenderingLibrary::CreateRenderTarget2D(this, Resolution.X, Resolution.Y, RTF_R32f, FLinearColor::Black, false);
+		ConeStartTarget->Filter = TF_Nearest;
+		for(UMaterialInstanceDynamic *Material : BoundMaterials)
+		{
+			if(Material)
+			{
+				Material->SetTextureParameterValue(ConeStartParameter, ConeStartTarget);
+			}
+		}
+	}
+
+	if(!ConePrepassInstance || ConePrepassInstance->Parent != ConePrepassMaterial)
+	{
+		ConePrepassInstance = UMaterialInstanceDynamic::Create(ConePrepassMaterial, this);
+	}
+	ConePrepassInstance->SetTextureParameterValue(SceneTextureParameter, SceneTexture);
+	ConePrepassInstance->SetVectorParameterValue(ConeTileUVSizeParameter, FLinearColor(2.0f / Resolution.X, 2.0f / Resolution.Y, 0.0f, 0.0f));
+	UKismetRenderingLibrary::DrawMaterialToRenderTarget(this, ConeStartTarget, ConePrepassInstance);
+}
+
+void UPSFSceneComponent::DrawTemporalDepth()
+{
+	const FIntPoint Resolution(FMath::Max(1, TemporalResolution.X), FMath::Max(1, TemporalResolution.Y));
+	if(!TemporalDepthTargets[0] || TemporalDepthTargets[0]->SizeX != Resolution.X || TemporalDepthTargets[0]->SizeY != Resolution.Y)
+	{
+		// cleared to 0, which reprojectStart reads as no history, reprojectStart and loadTemporalStart read single texels
+		for(TObjectPtr<UTextureRenderTarget2D> &Target : TemporalDepthTargets)
+		{
+			Target = UKismetRenderingLibrary::CreateRenderTarget2D(this, Resolution.X, Resolution.Y, RTF_R32f, FLinearColor::Black, false);
+			Target->Filter = TF_Nearest;
+		}
+		TemporalFrame = 0;
+	}
+
+	if(!TemporalDepthInstance || TemporalDepthInstance->Parent != TemporalDepthMaterial)
+	{
+		TemporalDepthInstance = UMaterialInstanceDynamic::Create(TemporalDepthMaterial, this);
+	}
+
+	// the target of the last tick is the history, the other one is overwritten
+	UTextureRenderTarget2D *History = TemporalDepthTargets[CurrentTemporalTarget];
+	CurrentTemporalTarget = 1 - CurrentTemporalTarget;
+	UTextureRenderTarget2D *Target = TemporalDepthTargets[CurrentTemporalTarget];
+
+	TemporalDepthInstance->SetTextureParameterValue(SceneTextureParameter, SceneTexture);
+	TemporalDepthInstance->SetTextureParameterValue(TemporalHistoryParameter, History);
+	TemporalDepthInstance->SetVectorParameterValue(HistoryEyeParameter, FLinearColor(HistoryEye.X, HistoryEye.Y, HistoryEye.Z, 0.0f));
+	for(int32 Row = 0; Row < 3; ++Row)
+	{
+		const FVector3f &Axis = HistoryCamera.Rows[Row];
+		TemporalDepthInstance->SetVectorParameterValue(FName(*FString::Printf(TEXT("%s%d"), *HistoryCameraParameter.ToString(), Row)), FLinearColor(Axis.X, Axis.Y, Axis.Z, 0.0f));
+	}
+	TemporalDepthInstance->SetScalarParameterValue(TemporalFrameParameter, TemporalFrame);
+	UKismetRenderingLibrary::DrawMaterialToRenderTarget(this, Target, TemporalDepthInstance);
+
+	for(UMaterialInstanceDynamic *Material : BoundMaterials)
+	{
+		if(Material)
+		{
+			Material->SetTextureParameterValue(TemporalDepthParameter, Target);
+		}
+	}
+
+	// the next tick reprojects from this camera, the frame wraps before a float loses the refresh pattern
+	HistoryEye = Scene.RayOrigin;
+	HistoryCamera = Scene.ComputeCameraMatrix();
+	TemporalFrame = (TemporalFrame + 1) % (1 << 20);
+}
+
+void UPSFSceneComponent::UpdateLightGrid()
+{
+	FPSFLightGrid Grid;
+	Grid.Build(Scene.PointLights, Scene.RayOrigin, Scene.ComputeCameraMatrix(), FMath::Max(1, LightGridResolution.X), FMath::Max(1, LightGridResolution.Y), LightTileSize);
+
+	UTexture2D *Texture = Grid.UpdateTexture(LightGridTexture);
+	if(Texture != LightGridTexture)
+	{
+		LightGridTexture = Texture;
+		for(UMaterialInstanceDynamic *Material : BoundMaterials)
+		{
+			if(Material)
+			{
+				Material->SetTextureParameterValue(LightGridParameter, LightGridTexture);
+			}
+		}
+	}
+}
+
+void UPSFSceneComponent::UploadDirtyRanges()
+{
+	// the time of the Time material expression, so that the skeletons match the frame the material renders
+	const UWorld *World = GetWorld();
+	TArray<FPSFTexelRange> Ranges;
+	Packer.SetShaderLimits({MaxSdfs, MaxMaterials, MaxDolphins});
+	bSceneRejected = !Packer.Pack(Scene.SDFs, Ranges, World ? World->GetTimeSeconds() : 0.0);
+	if(bSceneRejected)
+	{
+		return;
+	}
+	const int32 NumTexels = Packer.GetTexels().Num();
+
+	if(!SceneTexture || SceneTexture->GetSizeX() < NumTexels)
+	{
+		SceneTexture = UTexture2D::CreateTransient(FMath::RoundUpToPowerOfTwo(NumTexels), 1, PF_A32B32G32R32F);
+		SceneTexture->Filter = TF_Nearest;
+		SceneTexture->SRGB = false;
+		SceneTexture->CompressionSettings = TC_HDR;
+		SceneTexture->NeverStream = true;
+		SceneTexture->UpdateResource();
+
+		// a new texture has no content yet
+		Ranges = {{0, NumTexels}};
+		for(UMaterialInstanceDynamic *Material : BoundMaterials)
+		{
+			if(Material)
+			{
+				Material->SetTextureParameterValue(SceneTextureParameter, SceneTexture);
+			}
+		}
+	}
+
+	if(Ranges.Num() == 0)
+	{
+		return;
+	}
+
+	FUpdateTextureRegion2D *Regions = new FUpdateTextureRegion2D[Ranges.Num()];
+	for(int32 RangeIndex = 0; RangeIndex < Ranges.Num(); ++RangeIndex)
+	{
+		const FPSFTexelRange &Range = Ranges[RangeIndex];
+		Regions[RangeIndex] = FUpdateTextureRegion2D(Range.First, 0, Range.First, 0, Range.Count, 1);
+		LastUploadedTexels += Range.Count;
+	}
+
+	// the render thread reads the data later, it owns the copy and the regions until the upload is done
+	TArray<FVector4f> *Texels = new TArray<FVector4f>(Packer.GetTexels());
+	SceneTexture->UpdateTextureRegions(0, Ranges.Num(), Regions, NumTexels * sizeof(FVector4f), sizeof(FVector4f), reinterpret_cast<uint8 *>(Texels->GetData()),
+		[Texels](uint8 *, const FUpdateTextureRegion2D *UploadedRegions)
+		{
+			delete Texels;
+			delete[] UploadedRegions;
+		});
+}
@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFScenePacker.h"
+#include "PSFBvh.h"
+#include "PSFSdfFunctions.h"
+
+namespace
+{
+	int32 GrowCapacity(int32 Capacity, int32 Required)
+	{
+		return Required <= Capacity ? Capacity : FMath::Max<int32>(FPSFScenePacker::MinCapacity, FMath::RoundUpToPowerOfTwo(Required));
+	}
+
+	/** Bitwise, so that a NaN that did not change is not uploaded every frame */
+	bool TexelEquals(const FVector4f &A, const FVector4f &B)
+	{
+		return FMemory::Memcmp(&A, &B, sizeof(FVector4f)) == 0;
+	}
+}
+
+bool FPSFScenePacker::Pack(const TArray<FPSFSdf> &SDFs, TArray<FPSFTexelRange> &OutRanges, double Time)
+{
+	OutRanges.Reset();
+
+	// materials are shared by value, most scenes only use a handful
+	TArray<FPSFMaterialParams> Materials;
+	TArray<int32> MaterialIndices;
+	MaterialIndices.Reserve(SDFs.Num());
+	for(const FPSFSdf &Sdf : SDFs)
+	{
+		int32 MaterialIndex = Materials.IndexOfByKey(Sdf.Material);
+		if(MaterialIndex == INDEX_NONE)
+		{
+			MaterialIndex = Materials.Add(Sdf.Material);
+		}
+		MaterialIndices.Add(MaterialIndex);
+	}
+	if(SDFs.Num() > ShaderLimits.MaxSdfs || Materials.Num() > ShaderLimits.MaxMaterials)
+	{
+		UE_LOG(LogTemp, Error, TEXT("The scene has %d SDFs and %d materials, the shaders hold %d (MAX_SDFS) and %d (MAX_MATERIALS)."),
+			SDFs.Num(), Materials.Num(), ShaderLimits.MaxSdfs, ShaderLimits.MaxMaterials);
+		return false;
+	}
+
+	int32 NewNumDolphins = 0;
+	for(const FPSFSdf &Sdf : SDFs)
+	{
+		NewNumDolphins += Sdf.Type == EPSFSdfType::Dolphin ? 1 : 0;
+	}
+	// animated scenes are packed every frame, only warn when the count changes
+	if(NewNumDolphins > ShaderLimits.MaxDolphins && NewNumDolphins != NumDolphins)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The scene has %d dolphins, the shaders hold the skeletons of %d (MAX_DOLPHINS). The others rebuild their skeleton at every step."),
+			NewNumDolphins, ShaderLimits.MaxDolphins);
+	}
+	NumDolphins = NewNumDolphins;
+	const int32 NumSkeletons = FMath::Min(NumDolphins, ShaderLimits.MaxDolphins);
+
+	const int32 NewSdfCapacity = GrowCapacity(SdfCapacity, SDFs.Num());
+	const int32 NewMaterialCapacity = GrowCapacity(MaterialCapacity, Materials.Num());
+	const int32 NewDolphinCapacity = GrowCapacity(DolphinCapacity, NumSkeletons);
+	const bool bLayoutChanged = Texels.Num() == 0 || NewSdfCapacity != SdfCapacity || NewMaterialCapacity != MaterialCapacity || NewDolphinCapacity != DolphinCapacity;
+	SdfCapacity = NewSdfCapacity;
+	MaterialCapacity = NewMaterialCapacity;
+	DolphinCapacity = NewDolphinCapacity;
+	NumMaterials = Materials.Num();
+
+	const int32 DolphinOffset = 1 + SdfCapacity * TexelsPerSdf;
+	const int32 MaterialOffset = DolphinOffset + DolphinCapacity * TexelsPerDolphin;
+	TArray<FVector4f> NewTexels;
+	NewTexels.SetNumZeroed(MaterialOffset + MaterialCapacity * TexelsPerMaterial);
+
+	NewTexels[0] = FVector4f(float(SDFs.Num()), float(Materials.Num()), float(MaterialOffset), float(SdfCapacity));
+	int32 DolphinSlot = 0;
+	for(int32 SdfIndex = 0; SdfIndex < SDFs.Num(); ++SdfIndex)
+	{
+		const FPSFSdf &Sdf = SDFs[SdfIndex];
+		if(Sdf.Type != EPSFSdfType::Dolphin || DolphinSlot >= NumSkeletons)
+		{
+			PackSdf(Sdf, MaterialIndices[SdfIndex], INDEX_NONE, &NewTexels[1 + SdfIndex * TexelsPerSdf]);
+			continue;
+		}
+
+		// a resting dolphin packs the same skeleton every frame, only swimming ones become dirty
+		PackSdf(Sdf, MaterialIndices[SdfIndex], DolphinSlot, &NewTexels[1 + SdfIndex * TexelsPerSdf]);
+		PackDolphinSkeleton(PSFSdf::ComputeDolphinSkeleton(Sdf.Position, Sdf.TimeOffset, Sdf.Speed, Time), &NewTexels[DolphinOffset + DolphinSlot * TexelsPerDolphin]);
+		++DolphinSlot;
+	}
+
+	// record.z flags the SDFs that are new or changed their shape since the last pack, and the ones that change with
+	// the time in the shader. limitTemporalStart does not trust the history in front of them
+	const int32 PreviousCount = Texels.Num() > 0 ? int32(Texels[0].X) : 0;
+	bHasMovedSdfs = false;
+	for(int32 SdfIndex = 0; SdfIndex < SDFs.Num(); ++SdfIndex)
+	{
+		const FPSFSdf &Sdf = SDFs[SdfIndex];
+		const int32 Texel = 1 + SdfIndex * TexelsPerSdf;
+		bool bMoved = SdfIndex >= PreviousCount || NewTexels[Texel].X != Texels[Texel].X;
+		for(int32 Offset = 1; Offset < 4 && !bMoved; ++Offset)
+		{
+			bMoved = !TexelEquals(NewTexels[Texel + Offset], Texels[Texel + Offset]);
+		}
+		bHasMovedSdfs |= bMoved;
+		const bool bAnimated = (Sdf.Type == EPSFSdfType::Dolphin && Sdf.Speed != 0.0f) || Sdf.Type == EPSFSdfType::Custom;
+		NewTexels[Texel].Z = bMoved || bAnimated ? 1.0f : 0.0f;
+	}
+
+	for(int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+	{
+		PackMaterial(Materials[MaterialIndex], &NewTexels[MaterialOffset + MaterialIndex * TexelsPerMaterial]);
+	}
+
+	if(bLayoutChanged)
+	{
+		OutRanges.Add({0, NewTexels.Num()});
+	}
+	else
+	{
+		for(int32 Texel = 0; Texel < NewTexels.Num(); ++Texel)
+		{
+			if(TexelEquals(NewTexels[Texel], Texels[Texel]))
+			{
+				continue;
+			}
+
+			if(OutRanges.Num() > 0 && Texel - (OutRanges.Last().First + OutRanges.Last().Count) <= MergeGap)
+			{
+				OutRanges.Last().Count = Texel + 1 - OutRanges.Last().First;
+			}
+			else
+			{
+				OutRanges.Add({Texel, 1});
+			}
+		}
+	}
+
+	Texels = MoveTemp(NewTexels);
+	return true;
+}
+
+void FPSFScenePacker::PackSdf(const FPSFSdf &Sdf, int32 MaterialIndex, int32 DolphinSlot, FVector4f *OutTexels)
+{
+	// dolphins keep timeOffset, speed and the skeleton slot in size.xyz like addDolphin
+	const FVector3f Size = Sdf.Type == EPSFSdfType::Dolphin ? FVector3f(Sdf.TimeOffset, Sdf.Speed, float(DolphinSlot)) : Sdf.Size;
+
+	OutTexels[0] = FVector4f(float(int32(Sdf.Type)), float(MaterialIndex), 0.0f, 0.0f);
+	OutTexels[1] = FVector4f(Sdf.Position, Sdf.Radius);
+	OutTexels[2] = FVector4f(Size, 0.0f);
+	OutTexels[3] = QuaternionFromRotation(Sdf.Rotation);
+	OutTexels[4] = ComputeBoundingSphere(Sdf);
+}
+
+void FPSFScenePacker::PackDolphinSkeleton(const FPSFDolphinSkeleton &Skeleton, FVector4f *OutTexels)
+{
+	// the order loadSceneTexture unpacks in
+	for(int32 Joint = 0; Joint <= FPSFDolphinSkeleton::NumSegments; ++Joint)
+	{
+		*OutTexels++ = FVector4f(Skeleton.Joints[Joint], 0.0f);
+	}
+	for(int32 Row = 0; Row < 3; ++Row)
+	{
+		OutTexels[Row] = FVector4f(Skeleton.FinFrame.Rows[Row], 0.0f);
+		OutTexels[3 + Row] = FVector4f(Skeleton.FlipperFrame.Rows[Row], 0.0f);
+	}
+	OutTexels[6] = FVector4f(Skeleton.TailDirection, 0.0f);
+}
+
+void FPSFScenePacker::PackMaterial(const FPSFMaterialParams &Material, FVector4f *OutTexels)
+{
+	// the order loadSceneTexture unpacks in
+	OutTexels[0] = FVector4f(Material.BaseColor, Material.SpecularStrength);
+	OutTexels[1] = FVector4f(Material.SpecularColor, Material.Shininess);
+	OutTexels[2] = FVector4f(Material.FakeSpecularColor, Material.Roughness);
+	OutTexels[3] = FVector4f(Material.RefractionTint, Material.Metallic);
+	OutTexels[4] = FVector4f(Material.RimPower, Material.FakeSpecularPower, Material.Ior, Material.RefractionStrength);
+}
+
+FVector4f FPSFScenePacker::QuaternionFromRotation(const FPSFMatrix3 &Rotation)
+{
+	const FVector3f *M = Rotation.Rows;
+	const float Trace = M[0][0] + M[1][1] + M[2][2];
+	if(Trace > 0.0f)
+	{
+		const float S = FMath::Sqrt(Trace + 1.0f) * 2.0f;
+		return FVector4f(M[1][2] - M[2][1], M[2][0] - M[0][2], M[0][1] - M[1][0], 0.25f * S * S) / S;
+	}
+	if(M[0][0] > M[1][1] && M[0][0] > M[2][2])
+	{
+		const float S = FMath::Sqrt(1.0f + M[0][0] - M[1][1] - M[2][2]) * 2.0f;
+		return FVector4f(0.25f * S * S, M[1][0] + M[0][1], M[2][0] + M[0][2], M[1][2] - M[2][1]) / S;
+	}
+	if(M[1][1] > M[2][2])
+	{
+		const float S = FMath::Sqrt(1.0f + M[1][1] - M[0][0] - M[2][2]) * 2.0f;
+		return FVector4f(M[1][0] + M[0][1], 0.25f * S * S, M[2][1] + M[1][2], M[2][0] - M[0][2]) / S;
+	}
+	const float S = FMath::Sqrt(1.0f + M[2][2] - M[0][0] - M[1][1]) * 2.0f;
+	return FVector4f(M[2][0] + M[0][2], M[2][1] + M[1][2], 0.25f * S * S, M[0][1] - M[1][0]) / S;
+}
+
+FVector4f FPSFScenePacker::ComputeBoundingSphere(const FPSFSdf &Sdf)
+{
+	// a swimming dolphin moves every frame, its bounds would make every frame dirty
+	FBox3f Bounds;
+	if((Sdf.Type == EPSFSdfType::Dolphin && Sdf.Speed != 0.0f) || !PSFSdfBounds::ComputeBounds(Sdf, 0.0f, Bounds))
+	{
+		return FVector4f(Sdf.Position, PSFSdfBounds::Unbounded);
+	}
+	return FVector4f(Bounds.GetCenter(), Bounds.GetExtent().Size());
+}
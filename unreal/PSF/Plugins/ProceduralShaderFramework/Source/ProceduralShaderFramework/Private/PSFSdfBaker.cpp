@@ -0,0 +1,272 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFSdfBaker.h"
+#include "PSFSdfFunctions.h"
+#include "PSFBvh.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	constexpr int32 BrickVoxels = FPSFSdfBaker::BrickSamples - 1;
+
+	int32 BrickToIndex(const FIntVector &Brick, const FIntVector &Count)
+	{
+		return Brick.X + Count.X * (Brick.Y + Count.Y * Brick.Z);
+	}
+
+	bool FitsTexture(const FIntVector &Size, int32 MaxTextureSize)
+	{
+		return Size.X <= MaxTextureSize && Size.Y <= MaxTextureSize && Size.Z <= MaxTextureSize
+			&& int64(Size.X) * Size.Y * Size.Z <= MAX_int32;
+	}
+
+	FIntVector IndexToBrick(int32 Index, const FIntVector &Count)
+	{
+		return FIntVector(Index % Count.X, (Index / Count.X) % Count.Y, Index / (Count.X * Count.Y));
+	}
+
+	/** World position of the sample Voxel voxels into Brick */
+	FVector3f SamplePosition(const FPSFBakedSdf &Baked, const FIntVector &Brick, const FVector3f &Voxel)
+	{
+		return Baked.BoundsMin + (FVector3f(Brick * BrickVoxels) + Voxel) * Baked.VoxelSize;
+	}
+
+	float LoadAtlas(const FPSFBakedSdf &Baked, const FIntVector &AtlasSize, int32 X, int32 Y, int32 Z)
+	{
+		return Baked.Atlas[X + AtlasSize.X * (Y + AtlasSize.Y * Z)].GetFloat();
+	}
+}
+
+FIntVector FPSFBakedSdf::GetAtlasSize() const
+{
+	return AtlasBricks * FPSFSdfBaker::BrickSamples;
+}
+
+bool FPSFSdfBaker::CanBake(const FPSFSdf &Sdf)
+{
+	// the CPU evalSDF returns the miss value for custom SDFs
+	return Sdf.Type != EPSFSdfType::Dolphin && Sdf.Type != EPSFSdfType::Custom;
+}
+
+bool FPSFSdfBaker::Bake(const FPSFSdf &Sdf, const FBox3f &Bounds, const FPSFSdfBakeSettings &Settings, FPSFBakedSdf &OutBaked, FPSFSdfBakeStats &OutStats)
+{
+	if(!CanBake(Sdf))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s SDFs can not be baked."), PSFScene::SdfTypeToString(Sdf.Type));
+		return false;
+	}
+
+	FBox3f Box = Bounds;
+	if(!Box.IsValid && !PSFSdfBounds::ComputeBounds(Sdf, 0.0f, Box))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s SDFs are unbounded, the bake needs explicit bounds."), PSFScene::SdfTypeToString(Sdf.Type));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const float VoxelSize = Box.GetSize().GetMax() / FMath::Max(Settings.Resolution, 1);
+	if(VoxelSize <= 0.0f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("The bake bounds are empty."));
+		return false;
+	}
+
+	const FVector3f Padding(Settings.PaddingVoxels * VoxelSize);
+	const FVector3f Size = Box.GetSize() + 2.0f * Padding;
+
+	OutBaked = FPSFBakedSdf();
+	OutBaked.BoundsMin = Box.Min - Padding;
+	OutBaked.VoxelSize = VoxelSize;
+	OutBaked.BrickCount = FIntVector(
+		FMath::Max(FMath::CeilToInt(Size.X / (VoxelSize * BrickVoxels)), 1),
+		FMath::Max(FMath::CeilToInt(Size.Y / (VoxelSize * BrickVoxels)), 1),
+		FMath::Max(FMath::CeilToInt(Size.Z / (VoxelSize * BrickVoxels)), 1));
+
+	if(!FitsTexture(OutBaked.BrickCount, Settings.MaxTextureSize))
+	{
+		UE_LOG(LogTemp, Error, TEXT("The brick index of the bake would be %d x %d x %d, more than %d per side. Lower the resolution."),
+			OutBaked.BrickCount.X, OutBaked.BrickCount.Y, OutBaked.BrickCount.Z, Settings.MaxTextureSize);
+		return false;
+	}
+
+	const int32 TotalBricks = OutBaked.BrickCount.X * OutBaked.BrickCount.Y * OutBaked.BrickCount.Z;
+	const float Band = Settings.NarrowBandVoxels * VoxelSize;
+	const float HalfDiagonal = 0.5f * BrickVoxels * VoxelSize * UE_SQRT_3;
+	const float LipschitzBound = PSFSdfBounds::GetLipschitzBound(Sdf);
+
+	// the surface is at least |evalSDF| / LipschitzBound away from the brick center, a brick that is farther than its
+	// half diagonal plus the band holds no surface and that distance minus the half diagonal bounds every point in it.
+	// Without a bound every brick is stored
+	OutBaked.BrickIndex.SetNumUninitialized(TotalBricks);
+	ParallelFor(TotalBricks, [&](int32 BrickIndex)
+	{
+		if(LipschitzBound <= 0.0f)
+		{
+			OutBaked.BrickIndex[BrickIndex] = FVector4f(0.0f, 0.0f, 0.0f, 0.0f);
+			return;
+		}
+		const FIntVector Brick = IndexToBrick(BrickIndex, OutBaked.BrickCount);
+		const float Center = PSFSdf::EvalSDF(Sdf, SamplePosition(OutBaked, Brick, FVector3f(0.5f * BrickVoxels)));
+		const float Bound = FMath::Abs(Center) / LipschitzBound - HalfDiagonal;
+		OutBaked.BrickIndex[BrickIndex] = FVector4f(Bound <= Band ? 0.0f : -1.0f, 0.0f, 0.0f, Center < 0.0f ? -Bound : Bound);
+	});
+
+	TArray<int32> AllocatedBricks;
+	for(int32 BrickIndex = 0; BrickIndex < TotalBricks; ++BrickIndex)
+	{
+		if(OutBaked.BrickIndex[BrickIndex].X >= 0.0f)
+		{
+			AllocatedBricks.Add(BrickIndex);
+		}
+	}
+	OutBaked.NumAllocatedBricks = AllocatedBricks.Num();
+
+	// roughly cubic atlas, volume textures are limited to 2048 texels per side
+	const int32 NumSlots = FMath::Max(AllocatedBricks.Num(), 1);
+	OutBaked.AtlasBricks.X = FMath::CeilToInt(FMath::Pow(float(NumSlots), 1.0f / 3.0f));
+	OutBaked.AtlasBricks.Y = FMath::Min(OutBaked.AtlasBricks.X, FMath::DivideAndRoundUp(NumSlots, OutBaked.AtlasBricks.X));
+	OutBaked.AtlasBricks.Z = FMath::DivideAndRoundUp(NumSlots, OutBaked.AtlasBricks.X * OutBaked.AtlasBricks.Y);
+
+	const FIntVector AtlasSize = OutBaked.GetAtlasSize();
+	if(!FitsTexture(AtlasSize, Settings.MaxTextureSize))
+	{
+		UE_LOG(LogTemp, Error, TEXT("The atlas of the %d stored bricks would be %d x %d x %d texels, more than %d per side. Lower the resolution or the band."),
+			AllocatedBricks.Num(), AtlasSize.X, AtlasSize.Y, AtlasSize.Z, Settings.MaxTextureSize);
+		return false;
+	}
+	OutBaked.Atlas.SetNumZeroed(AtlasSize.X * AtlasSize.Y * AtlasSize.Z);
+
+	ParallelFor(AllocatedBricks.Num(), [&](int32 Slot)
+	{
+		const int32 BrickIndex = AllocatedBricks[Slot];
+		const FIntVector Brick = IndexToBrick(BrickIndex, OutBaked.BrickCount);
+		const FIntVector AtlasOrigin = IndexToBrick(Slot, OutBaked.AtlasBricks) * BrickSamples;
+		OutBaked.BrickIndex[BrickIndex] = FVector4f(float(AtlasOrigin.X), float(AtlasOrigin.Y), float(AtlasOrigin.Z), 0.0f);
+
+		for(int32 Z = 0; Z < BrickSamples; ++Z)
+		{
+			for(int32 Y = 0; Y < BrickSamples; ++Y)
+			{
+				for(int32 X = 0; X < BrickSamples; ++X)
+				{
+					const float Distance = PSFSdf::EvalSDF(Sdf, SamplePosition(OutBaked, Brick, FVector3f(X, Y, Z)));
+					const FIntVector Texel = AtlasOrigin + FIntVector(X, Y, Z);
+					OutBaked.Atlas[Texel.X + AtlasSize.X * (Texel.Y + AtlasSize.Y * Texel.Z)] = FFloat16(Distance);
+				}
+			}
+		}
+	}, EParallelForFlags::Unbalanced);
+
+	OutStats = FPSFSdfBakeStats();
+	OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+	OutStats.SdfEvaluations = (LipschitzBound > 0.0f ? TotalBricks : 0) + int64(AllocatedBricks.Num()) * BrickSamples * BrickSamples * BrickSamples;
+	OutStats.TotalBricks = TotalBricks;
+	OutStats.AllocatedBricks = AllocatedBricks.Num();
+	OutStats.BakedBytes = OutBaked.GetNumBytes();
+
+	const FIntVector Voxels = OutBaked.BrickCount * BrickVoxels + FIntVector(1);
+	OutStats.DenseBytes = int64(Voxels.X) * Voxels.Y * Voxels.Z * sizeof(FFloat16);
+	return true;
+}
+
+float FPSFSdfBaker::Sample(const FPSFBakedSdf &Baked, const FVector3f &P)
+{
+	const float BrickExtent = BrickVoxels * Baked.VoxelSize;
+	const FVector3f BrickCount(Baked.BrickCount);
+	FVector3f Local = (P - Baked.BoundsMin) / BrickExtent;
+
+	const FVector3f Outside = FVector3f::Max(FVector3f::Max(-Local, Local - BrickCount), FVector3f::ZeroVector);
+	const float OutsideDistance = Outside.Size() * BrickExtent;
+	Local = FVector3f::Min(FVector3f::Max(Local, FVector3f::ZeroVector), BrickCount - FVector3f(1e-4f));
+
+	const FIntVector Brick(FMath::FloorToInt(Local.X), FMath::FloorToInt(Local.Y), FMath::FloorToInt(Local.Z));
+	const FVector4f &Entry = Baked.BrickIndex[BrickToIndex(Brick, Baked.BrickCount)];
+
+	float Distance = Entry.W;
+	if(Entry.X >= 0.0f)
+	{
+		// the same texel centers the hardware filter of the atlas interpolates between
+		const FIntVector AtlasSize = Baked.GetAtlasSize();
+		const FVector3f Texel = (Local - FVector3f(Brick.X, Brick.Y, Brick.Z)) * float(BrickVoxels);
+		const FIntVector Base(FMath::Min(FMath::FloorToInt(Texel.X), BrickVoxels - 1), FMath::Min(FMath::FloorToInt(Texel.Y), BrickVoxels - 1), FMath::Min(FMath::FloorToInt(Texel.Z), BrickVoxels - 1));
+		const FVector3f Fraction = Texel - FVector3f(Base.X, Base.Y, Base.Z);
+		const int32 X = int32(Entry.X) + Base.X, Y = int32(Entry.Y) + Base.Y, Z = int32(Entry.Z) + Base.Z;
+
+		const float X00 = FMath::Lerp(LoadAtlas(Baked, AtlasSize, X, Y, Z), LoadAtlas(Baked, AtlasSize, X + 1, Y, Z), Fraction.X);
+		const float X10 = FMath::Lerp(LoadAtlas(Baked, AtlasSize, X, Y + 1, Z), LoadAtlas(Baked, AtlasSize, X + 1, Y + 1, Z), Fraction.X);
+		const float X01 = FMath::Lerp(LoadAtlas(Baked, AtlasSize, X, Y, Z + 1), LoadAtlas(Baked, AtlasSize, X + 1, Y, Z + 1), Fraction.X);
+		const float X11 = FMath::Lerp(LoadAtlas(Baked, AtlasSize, X, Y + 1, Z + 1), LoadAtlas(Baked, AtlasSize, X + 1, Y + 1, Z + 1), Fraction.X);
+		Distance = FMath::Lerp(FMath::Lerp(X00, X10, Fraction.Y), FMath::Lerp(X01, X11, Fraction.Y), Fraction.Z);
+	}
+
+	// outside the bounds both the distance to the box and the distance at the closest point minus the way there are lower bounds
+	return OutsideDistance > 0.0f ? FMath::Max(OutsideDistance, Distance - OutsideDistance) : Distance;
+}
+
+void FPSFSdfBaker::MeasureError(const FPSFSdf &Sdf, const FPSFBakedSdf &Baked, const FPSFSdfBakeSettings &Settings, FPSFSdfBakeStats &InOutStats)
+{
+	FRandomStream Random(0x5df);
+	const FVector3f Extent = FVector3f(Baked.BrickCount * BrickVoxels) * Baked.VoxelSize;
+
+	TArray<FVector3f> Points;
+	Points.SetNumUninitialized(FMath::Max(Settings.ErrorSamples, 1));
+	for(FVector3f &Point : Points)
+	{
+		Point = Baked.BoundsMin + FVector3f(Random.FRand(), Random.FRand(), Random.FRand()) * Extent;
+	}
+
+	TArray<float> Analytic, Sampled;
+	Analytic.SetNumUninitialized(Points.Num());
+	Sampled.SetNumUninitialized(Points.Num());
+
+	double Start = FPlatformTime::Seconds();
+	for(int32 Index = 0; Index < Points.Num(); ++Index)
+	{
+		Analytic[Index] = PSFSdf::EvalSDF(Sdf, Points[Index]);
+	}
+	InOutStats.AnalyticNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / Points.Num();
+
+	Start = FPlatformTime::Seconds();
+	for(int32 Index = 0; Index < Points.Num(); ++Index)
+	{
+		Sampled[Index] = Sample(Baked, Points[Index]);
+	}
+	InOutStats.BakedNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / Points.Num();
+
+	const float Band = Settings.NarrowBandVoxels * Baked.VoxelSize;
+	double SquaredErrorSum = 0.0;
+	InOutStats.BandSamples = 0;
+	InOutStats.MaxError = 0.0f;
+	InOutStats.MaxOvershoot = 0.0f;
+	for(int32 Index = 0; Index < Points.Num(); ++Index)
+	{
+		if(FMath::Abs(Analytic[Index]) <= Band)
+		{
+			const float Error = FMath::Abs(Sampled[Index] - Analytic[Index]);
+			InOutStats.MaxError = FMath::Max(InOutStats.MaxError, Error);
+			SquaredErrorSum += double(Error) * Error;
+			++InOutStats.BandSamples;
+		}
+		else
+		{
+			// a bound has to stay between the surface and the true distance
+			const float Overshoot = Analytic[Index] >= 0.0f ? Sampled[Index] - Analytic[Index] : Analytic[Index] - Sampled[Index];
+			InOutStats.MaxOvershoot = FMath::Max(InOutStats.MaxOvershoot, Overshoot);
+		}
+	}
+	InOutStats.RmsError = InOutStats.BandSamples > 0 ? float(FMath::Sqrt(SquaredErrorSum / InOutStats.BandSamples)) : 0.0f;
+}
+
+void FPSFSdfBaker::LogStats(const FPSFSdfBakeStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("Stored %d of %d bricks in %.2f s, %.2f M evalSDF/s"), Stats.AllocatedBricks, Stats.TotalBricks, Stats.Seconds,
+		Stats.Seconds > 0.0 ? Stats.SdfEvaluations / Stats.Seconds * 1e-6 : 0.0);
+	UE_LOG(LogTemp, Display, TEXT("Brick map: %.2f MB, dense volume: %.2f MB"), Stats.BakedBytes / (1024.0 * 1024.0), Stats.DenseBytes / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Display, TEXT("Error in the narrow band: max %.5f, rms %.5f (%d samples), bound overshoot outside the band: %.5f"),
+		Stats.MaxError, Stats.RmsError, Stats.BandSamples, Stats.MaxOvershoot);
+	UE_LOG(LogTemp, Display, TEXT("CPU cost: %.1f ns analytic, %.1f ns baked per evaluation (%.1fx)"), Stats.AnalyticNsPerEval, Stats.BakedNsPerEval,
+		Stats.BakedNsPerEval > 0.0 ? Stats.AnalyticNsPerEval / Stats.BakedNsPerEval : 0.0);
+}
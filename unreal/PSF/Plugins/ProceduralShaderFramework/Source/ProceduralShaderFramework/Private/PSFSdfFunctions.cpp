@@ -0,0 +1,350 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFSdfFunctions.h"
+#include "PSFNoise.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	float DistanceToBox(const FVector3f &P, const FVector3f &HalfExtent, float Radius)
+	{
+		return Max(Abs(P) - HalfExtent, 0.0f).Size() - Radius;
+	}
+
+	float SmoothUnion(float Distance1, float Distance2, float SmoothFactor)
+	{
+		const float H = FMath::Clamp(0.5f + 0.5f * (Distance2 - Distance1) / SmoothFactor, 0.0f, 1.0f);
+		return FMath::Lerp(Distance2, Distance1, H) - SmoothFactor * H * (1.0f - H);
+	}
+
+	FVector2f DolphinAnimation(float Position, float TimeOffset, double Time)
+	{
+		const float AdjustedTime = static_cast<float>(Time + TimeOffset);
+		const float Angle1 = 0.9f * (0.5f + 0.2f * Position) * FMath::Cos(5.0f * Position - 3.0f * AdjustedTime + 6.2831f / 4.0f);
+		const float Angle2 = 1.0f * FMath::Cos(3.5f * Position - 1.0f * AdjustedTime + 6.2831f / 4.0f);
+		const float Jumping = 0.5f + 0.5f * FMath::Cos(-0.4f + 0.5f * AdjustedTime);
+		const float FinalAngle = FMath::Lerp(Angle1, Angle2, Jumping);
+		const float Thickness = 0.4f * FMath::Cos(4.0f * Position - 1.0f * AdjustedTime) * (1.0f - 0.5f * Jumping);
+		return FVector2f(FinalAngle, Thickness);
+	}
+
+	/** Mirrors dolphinFinFrame */
+	FPSFMatrix3 FinFrame(FVector3f Direction)
+	{
+		Direction = Normalize(Direction);
+		const float K = FMath::Sqrt(1.0f - Direction.Y * Direction.Y);
+		return FPSFMatrix3(
+			FVector3f(Direction.Z / K, -Direction.X * Direction.Y / K, Direction.X),
+			FVector3f(0.0f, K, Direction.Y),
+			FVector3f(-Direction.X / K, -Direction.Y * Direction.Z / K, Direction.Z));
+	}
+
+	FVector2f Rot2(float A, const FVector2f &P)
+	{
+		// mul(rot2(a), p) with rot2(a) = float2x2(c, s, -s, c)
+		const float C = FMath::Cos(A);
+		const float S = FMath::Sin(A);
+		return FVector2f(C * P.X + S * P.Y, -S * P.X + C * P.Y);
+	}
+
+	float SurfFunc(FVector3f P)
+	{
+		const float Layer1Amp = 2.0f;
+		const float Layer2Amp = 1.0f;
+		const float Layer3Amp = 1.0f;
+
+		const float Layer1Freq = 0.2f;
+		const float Layer2Freq = 0.275f;
+		const float Layer3Freq = 0.5f * 3.0f;
+
+		P /= 2.5f;
+		const FVector2f XZ(P.X, P.Z);
+		float Layer1 = PSFNoise::N2D(XZ * Layer1Freq) * Layer1Amp - 0.5f;
+		Layer1 = SmoothStep(0.0f, 1.05f, Layer1);
+		float Layer2 = PSFNoise::N2D(XZ * Layer2Freq) * Layer2Amp;
+		Layer2 = 1.0f - FMath::Abs(Layer2 - 0.5f) * 2.0f;
+		Layer2 = SmoothStep(0.2f, 1.0f, Layer2 * Layer2);
+		const float Layer3 = PSFNoise::N2D(XZ * Layer3Freq) * Layer3Amp;
+		return Layer1 * 0.7f + Layer2 * 0.25f + Layer3 * 0.05f;
+	}
+
+	float Grad(float X, float Offs)
+	{
+		X = FMath::Abs(Frac(X / 6.283f + Offs - 0.25f) - 0.5f) * 2.0f;
+		const float X2 = FMath::Clamp(X * X * (-1.0f + 2.0f * X), 0.0f, 1.0f);
+		X = SmoothStep(0.0f, 1.0f, X);
+		return FMath::Lerp(X, X2, 0.15f);
+	}
+
+	float SandL(const FVector2f &P)
+	{
+		FVector2f Q = Rot2(3.14159f / 18.0f, P);
+		Q.Y += (PSFNoise::GradN2D(Q * 18.0f) - 0.5f) * 0.05f;
+		const float Grad1 = Grad(Q.Y * 80.0f, 0.0f);
+
+		Q = Rot2(-3.14159f / 20.0f, P);
+		Q.Y += (PSFNoise::GradN2D(Q * 12.0f) - 0.5f) * 0.05f;
+		const float Grad2 = Grad(Q.Y * 80.0f, 0.5f);
+
+		Q = Rot2(3.14159f / 4.0f, P);
+		const float A2 = (FMath::Sin(Q.X * 12.0f - FMath::Cos(Q.Y * 12.0f)) + FMath::Sin(Q.Y * 12.0f - FMath::Cos(Q.X * 12.0f))) * 0.25f + 0.5f;
+		const float A1 = 1.0f - A2;
+		return 1.0f - (1.0f - Grad1 * A1) * (1.0f - Grad2 * A2);
+	}
+
+	float Sand(FVector2f P)
+	{
+		P = FVector2f(P.Y - P.X, P.X + P.Y) * 0.7071f / 4.0f;
+		const float C1 = SandL(P);
+		const FVector2f Q = Rot2(3.14159f / 12.0f, P);
+		const float C2 = SandL(Q * 1.25f);
+		return FMath::Lerp(C1, C2, SmoothStep(0.1f, 0.9f, PSFNoise::GradN2D(P * 4.0f)));
+	}
+
+	float BumpSurf3D(const FVector3f &P)
+	{
+		const float N = SurfFunc(P);
+		const float NX = SurfFunc(P + FVector3f(0.001f, 0.0f, 0.0f));
+		const float NZ = SurfFunc(P + FVector3f(0.0f, 0.0f, 0.001f));
+		return Sand(FVector2f(P.X, P.Z) + FVector2f(N - NX, N - NZ) / 0.001f);
+	}
+}
+
+float PSFSdf::SdBox(const FVector3f &P, const FVector3f &B)
+{
+	const FVector3f D = Abs(P) - B;
+	return Max(D, 0.0f).Size() + FMath::Min(MaxComponent(D), 0.0f);
+}
+
+float PSFSdf::SdSphere(const FVector3f &P, float Radius)
+{
+	return P.Size() - Radius;
+}
+
+float PSFSdf::SdRoundBox(const FVector3f &P, const FVector3f &B, float R)
+{
+	const FVector3f Q = Abs(P) - B + FVector3f(R);
+	return Max(Q, 0.0f).Size() + FMath::Min(MaxComponent(Q), 0.0f) - R;
+}
+
+float PSFSdf::SdTorus(const FVector3f &P, const FVector2f &Radius)
+{
+	const FVector2f Q(FVector2f(P.X, P.Y).Size() - Radius.X, P.Z);
+	return Q.Size() - Radius.Y;
+}
+
+float PSFSdf::SdHexPrism(const FVector3f &InP, const FVector2f &Height)
+{
+	const FVector3f K(-0.8660254f, 0.5f, 0.57735f);
+	FVector3f P = Abs(InP);
+	const float Fold = 2.0f * FMath::Min(K.X * P.X + K.Y * P.Y, 0.0f);
+	P.X -= Fold * K.X;
+	P.Y -= Fold * K.Y;
+
+	const FVector2f Edge(FMath::Clamp(P.X, -K.Z * Height.X, K.Z * Height.X), Height.X);
+	const FVector2f D(
+		(FVector2f(P.X, P.Y) - Edge).Size() * FMath::Sign(P.Y - Height.X),
+		P.Z - Height.Y);
+	return FMath::Min(FMath::Max(D.X, D.Y), 0.0f) + Max(D, 0.0f).Size();
+}
+
+float PSFSdf::SdOctahedron(const FVector3f &InP, float S)
+{
+	const FVector3f P = Abs(InP);
+	return (P.X + P.Y + P.Z - S) * 0.57735027f;
+}
+
+float PSFSdf::SdEllipsoid(const FVector3f &P, const FVector3f &R)
+{
+	const float K0 = (P / R).Size();
+	const float K1 = (P / (R * R)).Size();
+	return K0 * (K0 - 1.0f) / K1;
+}
+
+FVector3f PSFSdf::DolphinMovement(float TimeOffset, const FVector3f &BasePosition, float Speed, double Time)
+{
+	if(Speed == 0.0f)
+	{
+		return BasePosition;
+	}
+
+	const float AdjustedTime = static_cast<float>(Time + TimeOffset);
+	const float Jumping = 0.5f + 0.5f * FMath::Cos(-0.4f + 0.5f * AdjustedTime);
+
+	const FVector3f Movement1(0.0f, FMath::Sin(3.0f * AdjustedTime + 6.2831f / 4.0f), 0.0f);
+	const FVector3f Movement2(0.0f, 1.5f + 2.5f * FMath::Cos(1.0f * AdjustedTime), 0.0f);
+	FVector3f FinalMovement = Lerp(Movement1, Movement2, Jumping);
+	FinalMovement.Y *= 0.5f;
+	FinalMovement.X += 0.1f * FMath::Sin(0.1f - 1.0f * AdjustedTime) * (1.0f - Jumping);
+
+	const FVector3f WorldOffset(0.0f, 0.0f, FMod(static_cast<float>(-Speed * Time), 50.0f) - 5.0f);
+
+	return BasePosition + FinalMovement + WorldOffset;
+}
+
+FPSFDolphinSkeleton PSFSdf::ComputeDolphinSkeleton(const FVector3f &Position, float TimeOffset, float Speed, double Time)
+{
+	const int32 NumSegments = FPSFDolphinSkeleton::NumSegments;
+	FPSFDolphinSkeleton Skeleton;
+	Skeleton.Joints[0] = DolphinMovement(TimeOffset, Position, Speed, Time);
+
+	for(int32 Index = 0; Index < NumSegments; ++Index)
+	{
+		const float SegmentPosition = float(Index) / float(NumSegments);
+		const FVector2f SegmentAnimation = Speed == 0.0f ? FVector2f::ZeroVector : DolphinAnimation(SegmentPosition, TimeOffset, Time);
+		const float SegmentLength = Index == 0 ? 0.655f : 0.48f;
+		Skeleton.Joints[Index + 1] = Skeleton.Joints[Index] + SegmentLength * Normalize(FVector3f(FMath::Sin(SegmentAnimation.Y), FMath::Sin(SegmentAnimation.X), FMath::Cos(SegmentAnimation.X)));
+	}
+
+	// specific segment info for fins and tail
+	Skeleton.FlipperFrame = FinFrame(Skeleton.Joints[4] - Skeleton.Joints[3]);
+	Skeleton.FinFrame = FinFrame(Skeleton.Joints[5] - Skeleton.Joints[4]);
+	Skeleton.TailDirection = Normalize(Skeleton.Joints[NumSegments] - Skeleton.Joints[NumSegments - 1]);
+	return Skeleton;
+}
+
+FVector2f PSFSdf::DolphinSkeletonDistance(const FVector3f &P, const FPSFDolphinSkeleton &Skeleton)
+{
+	const int32 NumSegments = FPSFDolphinSkeleton::NumSegments;
+	FVector2f Result(1000.0f, 0.0f);
+	FVector3f ClosestPoint = Skeleton.Joints[0];
+
+	for(int32 Index = 0; Index < NumSegments; ++Index)
+	{
+		const float SegmentPosition = float(Index) / float(NumSegments);
+		const FVector3f &StartPoint = Skeleton.Joints[Index];
+		const FVector3f &EndPoint = Skeleton.Joints[Index + 1];
+
+		const FVector3f StartToPoint = P - StartPoint;
+		const FVector3f StartToEnd = EndPoint - StartPoint;
+		const float Projection = FMath::Clamp((StartToPoint | StartToEnd) / (StartToEnd | StartToEnd), 0.0f, 1.0f);
+		const FVector3f VectorToClosestPoint = StartToPoint - Projection * StartToEnd;
+
+		const float DistanceSquared = VectorToClosestPoint | VectorToClosestPoint;
+		if(DistanceSquared < Result.X)
+		{
+			Result = FVector2f(DistanceSquared, SegmentPosition + Projection / float(NumSegments));
+			ClosestPoint = StartPoint + Projection * (EndPoint - StartPoint);
+		}
+	}
+
+	const float BodyRadius = Result.Y;
+	const float HeightToSpine = P.Y - ClosestPoint.Y;
+	float Radius = 0.05f + BodyRadius * (1.0f - BodyRadius) * (1.0f - BodyRadius) * 2.7f;
+	Radius += 7.0f * FMath::Max(0.0f, BodyRadius - 0.04f) * FMath::Exp(-30.0f * FMath::Max(0.0f, BodyRadius - 0.04f)) * SmoothStep(-0.1f, 0.1f, HeightToSpine);
+	Radius -= 0.03f * SmoothStep(0.0f, 0.1f, FMath::Abs(HeightToSpine)) * (1.0f - SmoothStep(0.0f, 0.1f, BodyRadius));
+	Radius += 0.05f * FMath::Clamp(1.0f - 3.0f * BodyRadius, 0.0f, 1.0f);
+	Radius += 0.035f * (1.0f - SmoothStep(0.0f, 0.025f, FMath::Abs(BodyRadius - 0.1f))) * (1.0f - SmoothStep(0.0f, 0.1f, FMath::Abs(HeightToSpine)));
+	Result.X = 0.75f * (FVector3f::Distance(P, ClosestPoint) - Radius);
+
+	// fin part
+	FVector3f PS = Skeleton.FinFrame.MulRow(P - Skeleton.Joints[4]);
+	PS.Z -= 0.1f;
+
+	float Distance5 = FVector2f(PS.Y, PS.Z).Size() - 0.9f;
+	Distance5 = FMath::Max(Distance5, -((FVector2f(PS.Y, PS.Z) - FVector2f(0.6f, 0.0f)).Size() - 0.35f));
+	Distance5 = FMath::Max(Distance5, DistanceToBox(PS + FVector3f(0.0f, -0.5f, 0.5f), FVector3f(0.0f, 0.5f, 0.5f), 0.02f));
+	Result.X = SmoothUnion(Result.X, Distance5, 0.1f);
+
+	// fin
+	PS = Skeleton.FlipperFrame.MulRow(P - Skeleton.Joints[3]);
+	PS.X = FMath::Abs(PS.X);
+	float L = PS.X;
+	L = FMath::Clamp((L - 0.4f) / 0.5f, 0.0f, 1.0f);
+	L = 4.0f * L * (1.0f - L);
+	L *= 1.0f - FMath::Clamp(5.0f * FMath::Abs(PS.Z + 0.2f), 0.0f, 1.0f);
+	PS += FVector3f(-0.2f, 0.36f, -0.2f);
+	Distance5 = FVector2f(PS.X, PS.Z).Size() - 0.8f;
+	Distance5 = FMath::Max(Distance5, -((FVector2f(PS.X, PS.Z) - FVector2f(0.2f, 0.4f)).Size() - 0.8f));
+	Distance5 = FMath::Max(Distance5, DistanceToBox(PS, FVector3f(1.0f, 0.0f, 1.0f), 0.015f + 0.05f * L));
+	Result.X = SmoothUnion(Result.X, Distance5, 0.12f);
+
+	// tail part
+	const FVector3f &Direction2 = Skeleton.TailDirection;
+	FVector3f PF = P - Skeleton.Joints[NumSegments] - Direction2 * 0.25f;
+	// pf.yz = mul(pf.yz, float2x2(d.z, d.y, -d.y, d.z))
+	const float TailY = PF.Y * Direction2.Z - PF.Z * Direction2.Y;
+	const float TailZ = PF.Y * Direction2.Y + PF.Z * Direction2.Z;
+	PF.Y = TailY;
+	PF.Z = TailZ;
+	float Distance4 = FVector2f(PF.X, PF.Z).Size() - 0.6f;
+	Distance4 = FMath::Max(Distance4, -((FVector2f(PF.X, PF.Z) - FVector2f(0.0f, 0.8f)).Size() - 0.9f));
+	Distance4 = FMath::Max(Distance4, DistanceToBox(PF, FVector3f(1.0f, 0.005f, 1.0f), 0.005f));
+	Result.X = SmoothUnion(Result.X, Distance4, 0.1f);
+
+	return Result;
+}
+
+FVector2f PSFSdf::DolphinDistance(const FVector3f &P, const FVector3f &Position, float TimeOffset, float Speed, double Time)
+{
+	return DolphinSkeletonDistance(P, ComputeDolphinSkeleton(Position, TimeOffset, Speed, Time));
+}
+
+float PSFSdf::MapDesert(const FVector3f &P)
+{
+	return P.Y + (0.5f - SurfFunc(P)) * 2.0f;
+}
+
+FVector3f PSFSdf::DoBumpMap(const FVector3f &P, const FVector3f &Normal, float BumpFactor)
+{
+	const float E = 0.001f;
+	const float Ref = BumpSurf3D(P);
+	FVector3f Gradient = (FVector3f(
+		BumpSurf3D(P - FVector3f(E, 0.0f, 0.0f)),
+		BumpSurf3D(P - FVector3f(0.0f, E, 0.0f)),
+		BumpSurf3D(P - FVector3f(0.0f, 0.0f, E))) - FVector3f(Ref)) / E;
+	Gradient -= Normal * (Normal | Gradient);
+	return Normalize(Normal + Gradient * BumpFactor);
+}
+
+FVector3f PSFSdf::GetDesertColor(const FVector3f &P)
+{
+	const float Ripple = Sand(FVector2f(P.X, P.Z));
+	return Lerp(FVector3f(1.0f, 0.95f, 0.7f), FVector3f(0.9f, 0.6f, 0.4f), Ripple);
+}
+
+float PSFSdf::EvalSDF(const FPSFSdf &Sdf, const FVector3f &P, float Time)
+{
+	const FVector3f ProbePoint = Sdf.Rotation.MulRow(P - Sdf.Position);
+	switch(Sdf.Type)
+	{
+	case EPSFSdfType::Sphere:
+		return SdSphere(ProbePoint, Sdf.Radius);
+	case EPSFSdfType::RoundBox:
+		return SdRoundBox(ProbePoint, Sdf.Size, Sdf.Radius);
+	case EPSFSdfType::Torus:
+		return SdTorus(ProbePoint, FVector2f(Sdf.Size.Y, Sdf.Size.Z));
+	case EPSFSdfType::HexPrism:
+		return SdHexPrism(ProbePoint, FVector2f(Sdf.Radius, Sdf.Radius));
+	case EPSFSdfType::Octahedron:
+		return SdOctahedron(ProbePoint, Sdf.Radius);
+	case EPSFSdfType::Ellipsoid:
+		return SdEllipsoid(ProbePoint, Sdf.Size);
+	case EPSFSdfType::Dolphin:
+		return DolphinDistance(ProbePoint, Sdf.Position, Sdf.TimeOffset, Sdf.Speed, Time).X;
+	case EPSFSdfType::Rock:
+	{
+		const float Base = SdBox(ProbePoint, Sdf.Size);
+		const float Noise = PSFNoise::SNoise(ProbePoint * 5.0f) * 0.1f;
+		return Base - Noise * 0.3f;
+	}
+	case EPSFSdfType::Desert:
+		return MapDesert(P - Sdf.Position);
+	default:
+		return 1e5f;
+	}
+}
+
+FVector3f PSFSdf::GetNormal(const FPSFSdf &Sdf, const FVector3f &P)
+{
+	const float H = 0.0001f;
+	const FVector3f XYY(1, -1, -1), YYX(-1, -1, 1), YXY(-1, 1, -1), XXX(1, 1, 1);
+
+	const float Normal1 = EvalSDF(Sdf, P + XYY * H);
+	const float Normal2 = EvalSDF(Sdf, P + YYX * H);
+	const float Normal3 = EvalSDF(Sdf, P + YXY * H);
+	const float Normal4 = EvalSDF(Sdf, P + XXX * H);
+	return Normalize(XYY * Normal1 + YYX * Normal2 + YXY * Normal3 + XXX * Normal4);
+}
@@ -0,0 +1,948 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFShaderGenerator.h"
+#include "PSFShaderTranslator.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	const EPSFShaderBackend AllBackends[] = {EPSFShaderBackend::Unreal, EPSFShaderBackend::Unity, EPSFShaderBackend::Godot, EPSFShaderBackend::GLSL};
+
+	/** Value of a preprocessor expression, not known if it depends on a macro the includer decides */
+	struct FFoldValue
+	{
+		bool bKnown = false;
+		int64 Value = 0;
+
+		static FFoldValue Make(int64 InValue)
+		{
+			FFoldValue Result;
+			Result.bKnown = true;
+			Result.Value = InValue;
+			return Result;
+		}
+	};
+
+	/** Macros seen so far, shared by all files in include order like the preprocessor does */
+	struct FDefineContext
+	{
+		/** Macros with a known value, as written after the name */
+		TMap<FString, FString> Values;
+
+		/** Macros defined or undefined inside a conditional that is left to the compiler */
+		TSet<FString> Uncertain;
+
+		bool bClosedWorld = false;
+	};
+
+	int32 CountLines(const FString &Text)
+	{
+		int32 Lines = 0;
+		for(const TCHAR Character : Text)
+		{
+			Lines += Character == TEXT('\n') ? 1 : 0;
+		}
+		return Lines;
+	}
+
+	bool IsIdentifierCharacter(TCHAR Character)
+	{
+		return FChar::IsAlnum(Character) || Character == TEXT('_');
+	}
+
+	/** Evaluates the integer expressions of #if: literals, macros, defined, ! && || comparisons and arithmetic */
+	class FConditionEvaluator
+	{
+	public:
+		FConditionEvaluator(const FString &Expression, const FDefineContext &InContext, int32 InDepth = 0)
+			: Context(InContext)
+			, Depth(InDepth)
+		{
+			Tokenize(Expression);
+		}
+
+		FFoldValue Evaluate()
+		{
+			if(bInvalid || Depth > 16)
+			{
+				return FFoldValue();
+			}
+			const FFoldValue Result = ParseOr();
+			return Cursor == Tokens.Num() && !bInvalid ? Result : FFoldValue();
+		}
+
+	private:
+		void Tokenize(const FString &Expression)
+		{
+			int32 Pos = 0;
+			while(Pos < Expression.Len())
+			{
+				const TCHAR Character = Expression[Pos];
+				if(FChar::IsWhitespace(Character))
+				{
+					++Pos;
+					continue;
+				}
+				if(Character == TEXT('/') && Pos + 1 < Expression.Len() && (Expression[Pos + 1] == TEXT('/') || Expression[Pos + 1] == TEXT('*')))
+				{
+					// a trailing comment ends the expression, a block comment inside one is not worth supporting
+					if(Expression[Pos + 1] == TEXT('*'))
+					{
+						bInvalid = true;
+					}
+					break;
+				}
+
+				const int32 Start = Pos;
+				if(IsIdentifierCharacter(Character))
+				{
+					while(Pos < Expression.Len() && (IsIdentifierCharacter(Expression[Pos]) || Expression[Pos] == TEXT('.')))
+					{
+						++Pos;
+					}
+				}
+				else
+				{
+					static const TCHAR *TwoCharacterOperators[] = {TEXT("&&"), TEXT("||"), TEXT("=="), TEXT("!="), TEXT("<="), TEXT(">=")};
+					Pos += 1;
+					for(const TCHAR *Operator : TwoCharacterOperators)
+					{
+						if(Expression.Mid(Start, 2) == Operator)
+						{
+							Pos = Start + 2;
+							break;
+						}
+					}
+				}
+				Tokens.Add(Expression.Mid(Start, Pos - Start));
+			}
+		}
+
+		const FString &Peek() const
+		{
+			static const FString End;
+			return Cursor < Tokens.Num() ? Tokens[Cursor] : End;
+		}
+
+		bool Accept(const TCHAR *Token)
+		{
+			if(Cursor < Tokens.Num() && Tokens[Cursor].Equals(Token, ESearchCase::CaseSensitive))
+			{
+				++Cursor;
+				return true;
+			}
+			return false;
+		}
+
+		FFoldValue ParseOr()
+		{
+			FFoldValue Left = ParseAnd();
+			while(Accept(TEXT("||")))
+			{
+				const FFoldValue Right = ParseAnd();
+				const bool bTrue = (Left.bKnown && Left.Value != 0) || (Right.bKnown && Right.Value != 0);
+				Left = bTrue ? FFoldValue::Make(1) : (Left.bKnown && Right.bKnown ? FFoldValue::Make(0) : FFoldValue());
+			}
+			return Left;
+		}
+
+		FFoldValue ParseAnd()
+		{
+			FFoldValue Left = ParseEquality();
+			while(Accept(TEXT("&&")))
+			{
+				const FFoldValue Right = ParseEquality();
+				const bool bFalse = (Left.bKnown && Left.Value == 0) || (Right.bKnown && Right.Value == 0);
+				Left = bFalse ? FFoldValue::Make(0) : (Left.bKnown && Right.bKnown ? FFoldValue::Make(1) : FFoldValue());
+			}
+			return Left;
+		}
+
+		FFoldValue ParseEquality()
+		{
+			FFoldValue Left = ParseRelational();
+			while(Peek() == TEXT("==") || Peek() == TEXT("!="))
+			{
+				const bool bEqual = Tokens[Cursor++] == TEXT("==");
+				const FFoldValue Right = ParseRelational();
+				Left = Left.bKnown && Right.bKnown ? FFoldValue::Make((Left.Value == Right.Value) == bEqual ? 1 : 0) : FFoldValue();
+			}
+			return Left;
+		}
+
+		FFoldValue ParseRelational()
+		{
+			FFoldValue Left = ParseAdditive();
+			while(Peek() == TEXT("<") || Peek() == TEXT(">") || Peek() == TEXT("<=") || Peek() == TEXT(">="))
+			{
+				const FString Operator = Tokens[Cursor++];
+				const FFoldValue Right = ParseAdditive();
+				if(!Left.bKnown || !Right.bKnown)
+				{
+					Left = FFoldValue();
+					continue;
+				}
+				bool bResult = Left.Value >= Right.Value;
+				if(Operator == TEXT("<"))
+				{
+					bResult = Left.Value < Right.Value;
+				}
+				else if(Operator == TEXT(">"))
+				{
+					bResult = Left.Value > Right.Value;
+				}
+				else if(Operator == TEXT("<="))
+				{
+					bResult = Left.Value <= Right.Value;
+				}
+				Left = FFoldValue::Make(bResult ? 1 : 0);
+			}
+			return Left;
+		}
+
+		FFoldValue ParseAdditive()
+		{
+			FFoldValue Left = ParseMultiplicative();
+			while(Peek() == TEXT("+") || Peek() == TEXT("-"))
+			{
+				const bool bAdd = Tokens[Cursor++] == TEXT("+");
+				const FFoldValue Right = ParseMultiplicative();
+				Left = Left.bKnown && Right.bKnown ? FFoldValue::Make(bAdd ? Left.Value + Right.Value : Left.Value - Right.Value) : FFoldValue();
+			}
+			return Left;
+		}
+
+		FFoldValue ParseMultiplicative()
+		{
+			FFoldValue Left = ParseUnary();
+			while(Peek() == TEXT("*") || Peek() == TEXT("/") || Peek() == TEXT("%"))
+			{
+				const FString Operator = Tokens[Cursor++];
+				const FFoldValue Right = ParseUnary();
+				if(!Left.bKnown || !Right.bKnown || (Operator != TEXT("*") && Right.Value == 0))
+				{
+					Left = FFoldValue();
+					continue;
+				}
+				Left = FFoldValue::Make(Operator == TEXT("*") ? Left.Value * Right.Value : (Operator == TEXT("/") ? Left.Value / Right.Value : Left.Value % Right.Value));
+			}
+			return Left;
+		}
+
+		FFoldValue ParseUnary()
+		{
+			if(Accept(TEXT("!")))
+			{
+				const FFoldValue Operand = ParseUnary();
+				return Operand.bKnown ? FFoldValue::Make(Operand.Value == 0 ? 1 : 0) : Operand;
+			}
+			if(Accept(TEXT("-")))
+			{
+				const FFoldValue Operand = ParseUnary();
+				return Operand.bKnown ? FFoldValue::Make(-Operand.Value) : Operand;
+			}
+			if(Accept(TEXT("+")))
+			{
+				return ParseUnary();
+			}
+			return ParsePrimary();
+		}
+
+		FFoldValue ParsePrimary()
+		{
+			if(Accept(TEXT("(")))
+			{
+				const FFoldValue Inner = ParseOr();
+				if(!Accept(TEXT(")")))
+				{
+					bInvalid = true;
+				}
+				return Inner;
+			}
+			if(Cursor >= Tokens.Num())
+			{
+				bInvalid = true;
+				return FFoldValue();
+			}
+
+			const FString Token = Tokens[Cursor++];
+			if(FChar::IsDigit(Token[0]))
+			{
+				return ParseNumber(Token);
+			}
+			if(!IsIdentifierCharacter(Token[0]))
+			{
+				bInvalid = true;
+				return FFoldValue();
+			}
+
+			if(Token == TEXT("defined"))
+			{
+				const bool bParenthesized = Accept(TEXT("("));
+				if(Cursor >= Tokens.Num())
+				{
+					bInvalid = true;
+					return FFoldValue();
+				}
+				const FString Name = Tokens[Cursor++];
+				if(bParenthesized && !Accept(TEXT(")")))
+				{
+					bInvalid = true;
+				}
+				if(Context.Uncertain.Contains(Name))
+				{
+					return FFoldValue();
+				}
+				if(Context.Values.Contains(Name))
+				{
+					return FFoldValue::Make(1);
+				}
+				return Context.bClosedWorld ? FFoldValue::Make(0) : FFoldValue();
+			}
+
+			if(Context.Uncertain.Contains(Token))
+			{
+				return FFoldValue();
+			}
+			if(const FString *Value = Context.Values.Find(Token))
+			{
+				return Value->IsEmpty() ? FFoldValue() : FConditionEvaluator(*Value, Context, Depth + 1).Evaluate();
+			}
+
+			// the preprocessor reads a name that is not a macro as 0
+			return Context.bClosedWorld ? FFoldValue::Make(0) : FFoldValue();
+		}
+
+		FFoldValue ParseNumber(FString Token)
+		{
+			while(Token.Len() > 1 && (Token.EndsWith(TEXT("u")) || Token.EndsWith(TEXT("l"))))
+			{
+				Token.LeftChopInline(1);
+			}
+
+			// floats are not valid in #if, leave them to the compiler
+			int64 Value = 0;
+			const bool bHex = Token.StartsWith(TEXT("0x"));
+			for(int32 Index = bHex ? 2 : 0; Index < Token.Len(); ++Index)
+			{
+				const TCHAR Character = FChar::ToLower(Token[Index]);
+				int32 Digit = INDEX_NONE;
+				if(FChar::IsDigit(Character))
+				{
+					Digit = Character - TEXT('0');
+				}
+				else if(bHex && Character >= TEXT('a') && Character <= TEXT('f'))
+				{
+					Digit = 10 + Character - TEXT('a');
+				}
+				if(Digit == INDEX_NONE)
+				{
+					return FFoldValue();
+				}
+				Value = Value * (bHex ? 16 : 10) + Digit;
+			}
+			return FFoldValue::Make(Value);
+		}
+
+		const FDefineContext &Context;
+		int32 Depth;
+		TArray<FString> Tokens;
+		int32 Cursor = 0;
+		bool bInvalid = false;
+	};
+
+	/** One #if ... #endif that is open at the current line */
+	struct FConditional
+	{
+		/** Lines of the current branch are written */
+		bool bActive = true;
+
+		/** The compiler decides the branch: the directives stay and macros defined in it are uncertain */
+		bool bKept = false;
+
+		/** A folded branch was taken already, the later #elif / #else are dead */
+		bool bTaken = false;
+
+		/** The include guard of the file, kept but not a decision of the compiler */
+		bool bGuard = false;
+
+		/** The whole conditional is inside a dead branch */
+		bool bDead = false;
+	};
+
+	/** Folds the conditionals of one file, the defines seen are added to Context */
+	FString FoldConditionals(const FString &Text, FDefineContext &Context, int32 &OutFolded, int32 &OutKept)
+	{
+		TArray<FString> Lines;
+		int32 LineStart = 0;
+		while(LineStart < Text.Len())
+		{
+			int32 LineEnd = Text.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromStart, LineStart);
+			LineEnd = LineEnd == INDEX_NONE ? Text.Len() : LineEnd + 1;
+			Lines.Add(Text.Mid(LineStart, LineEnd - LineStart));
+			LineStart = LineEnd;
+		}
+
+		// the include guard stays as it is, the generated library can still be included more than once
+		int32 GuardLine = INDEX_NONE;
+		FString GuardName;
+		for(int32 Index = 0; Index < Lines.Num(); ++Index)
+		{
+			const FString Line = Lines[Index].TrimStartAndEnd();
+			if(Line.IsEmpty() || Line.StartsWith(TEXT("//")))
+			{
+				continue;
+			}
+			if(Line.StartsWith(TEXT("#ifndef")) && Index + 1 < Lines.Num())
+			{
+				GuardName = Line.Mid(7).TrimStartAndEnd();
+				if(Lines[Index + 1].TrimStartAndEnd() == TEXT("#define ") + GuardName)
+				{
+					GuardLine = Index;
+				}
+			}
+			break;
+		}
+
+		FString Out;
+		TArray<FConditional> Stack;
+		const auto IsWriting = [&Stack]()
+		{
+			for(const FConditional &Conditional : Stack)
+			{
+				if(!Conditional.bActive)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+		const auto IsUncertain = [&Stack]()
+		{
+			for(const FConditional &Conditional : Stack)
+			{
+				if(Conditional.bKept && !Conditional.bGuard)
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		for(int32 Index = 0; Index < Lines.Num(); ++Index)
+		{
+			const FString &Line = Lines[Index];
+			FString Directive = Line.TrimStartAndEnd();
+			if(!Directive.StartsWith(TEXT("#")))
+			{
+				if(IsWriting())
+				{
+					Out += Line;
+				}
+				continue;
+			}
+
+			Directive = Directive.Mid(1).TrimStart();
+			int32 KeywordEnd = 0;
+			while(KeywordEnd < Directive.Len() && FChar::IsAlpha(Directive[KeywordEnd]))
+			{
+				++KeywordEnd;
+			}
+			const FString Keyword = Directive.Left(KeywordEnd);
+			const FString Argument = Directive.Mid(KeywordEnd).TrimStartAndEnd();
+
+			if(Keyword == TEXT("if") || Keyword == TEXT("ifdef") || Keyword == TEXT("ifndef"))
+			{
+				FConditional Conditional;
+				if(!IsWriting())
+				{
+					Conditional.bActive = false;
+					Conditional.bDead = true;
+					Stack.Add(Conditional);
+					continue;
+				}
+				if(Index == GuardLine)
+				{
+					Conditional.bKept = true;
+					Conditional.bGuard = true;
+					Stack.Add(Conditional);
+					Out += Line;
+					continue;
+				}
+
+				FString Expression = Argument;
+				if(Keyword != TEXT("if"))
+				{
+					Expression = (Keyword == TEXT("ifndef") ? TEXT("!defined ") : TEXT("defined ")) + Argument;
+				}
+				const FFoldValue Value = FConditionEvaluator(Expression, Context).Evaluate();
+				if(Value.bKnown)
+				{
+					++OutFolded;
+					Conditional.bActive = Value.Value != 0;
+					Conditional.bTaken = Conditional.bActive;
+				}
+				else
+				{
+					++OutKept;
+					Conditional.bKept = true;
+					Out += Line;
+				}
+				Stack.Add(Conditional);
+				continue;
+			}
+
+			if(Keyword == TEXT("elif") || Keyword == TEXT("else") || Keyword == TEXT("endif"))
+			{
+				if(Stack.Num() == 0)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("#%s without #if, kept as it is"), *Keyword);
+					Out += Line;
+					continue;
+				}
+				FConditional &Conditional = Stack.Last();
+				if(Keyword == TEXT("endif"))
+				{
+					if(Conditional.bKept && !Conditional.bDead)
+					{
+						Out += Line;
+					}
+					Stack.Pop();
+					continue;
+				}
+				if(Conditional.bDead)
+				{
+					continue;
+				}
+				if(Conditional.bKept)
+				{
+					Conditional.bActive = true;
+					Out += Line;
+					continue;
+				}
+				if(Conditional.bTaken)
+				{
+					Conditional.bActive = false;
+					continue;
+				}
+				if(Keyword == TEXT("else"))
+				{
+					Conditional.bActive = true;
+					Conditional.bTaken = true;
+					continue;
+				}
+
+				// every branch before was dead, an #elif the compiler has to decide starts the kept part
+				const FFoldValue Value = FConditionEvaluator(Argument, Context).Evaluate();
+				if(Value.bKnown)
+				{
+					Conditional.bActive = Value.Value != 0;
+					Conditional.bTaken = Conditional.bActive;
+				}
+				else
+				{
+					++OutKept;
+					Conditional.bActive = true;
+					Conditional.bKept = true;
+					Out += TEXT("#if ") + Argument + TEXT("\n");
+				}
+				continue;
+			}
+
+			if(!IsWriting())
+			{
+				continue;
+			}
+			Out += Line;
+
+			if(Keyword == TEXT("define") || Keyword == TEXT("undef"))
+			{
+				int32 NameEnd = 0;
+				while(NameEnd < Argument.Len() && IsIdentifierCharacter(Argument[NameEnd]))
+				{
+					++NameEnd;
+				}
+				const FString Name = Argument.Left(NameEnd);
+				const bool bFunctionLike = NameEnd < Argument.Len() && Argument[NameEnd] == TEXT('(');
+				if(Keyword == TEXT("undef"))
+				{
+					Context.Values.Remove(Name);
+				}
+				else
+				{
+					Context.Values.Add(Name, bFunctionLike ? FString() : Argument.Mid(NameEnd).TrimStartAndEnd());
+				}
+
+				if(IsUncertain() || bFunctionLike)
+				{
+					Context.Uncertain.Add(Name);
+				}
+				else
+				{
+					Context.Uncertain.Remove(Name);
+				}
+			}
+		}
+		return Out;
+	}
+
+	/** NAME=VALUE of -Define=, NAME alone is 1 */
+	void ParseDefine(const FString &Define, FString &OutName, FString &OutValue)
+	{
+		OutName = Define;
+		OutValue = TEXT("1");
+		Define.Split(TEXT("="), &OutName, &OutValue);
+		OutName.TrimStartAndEndInline();
+		OutValue.TrimStartAndEndInline();
+	}
+
+	/** Adds a piece of code, directives of consecutive pieces must not end up on one line */
+	void AppendCode(FString &Code, const FString &Piece)
+	{
+		if(!Code.IsEmpty() && !Code.EndsWith(TEXT("\n")) && !Piece.StartsWith(TEXT("\n")))
+		{
+			Code += TEXT("\n");
+		}
+		Code += Piece;
+	}
+}
+
+const TCHAR *FPSFShaderBackendConfig::GetName(EPSFShaderBackend Backend)
+{
+	switch(Backend)
+	{
+	case EPSFShaderBackend::Unity:
+		return TEXT("unity");
+	case EPSFShaderBackend::Godot:
+		return TEXT("godot");
+	case EPSFShaderBackend::GLSL:
+		return TEXT("glsl");
+	default:
+		return TEXT("unreal");
+	}
+}
+
+const TCHAR *FPSFShaderBackendConfig::GetExtension(EPSFShaderBackend Backend)
+{
+	switch(Backend)
+	{
+	case EPSFShaderBackend::Unity:
+		return TEXT("hlsl");
+	case EPSFShaderBackend::Godot:
+		return TEXT("gdshaderinc");
+	case EPSFShaderBackend::GLSL:
+		return TEXT("glsl");
+	default:
+		return TEXT("ush");
+	}
+}
+
+bool FPSFShaderBackendConfig::ParseBackend(const FString &Name, EPSFShaderBackend &OutBackend)
+{
+	for(const EPSFShaderBackend Backend : AllBackends)
+	{
+		if(Name.TrimStartAndEnd() == GetName(Backend))
+		{
+			OutBackend = Backend;
+			return true;
+		}
+	}
+	return false;
+}
+
+FPSFShaderBackendConfig FPSFShaderBackendConfig::Create(EPSFShaderBackend Backend)
+{
+	FPSFShaderBackendConfig Config;
+	Config.Backend = Backend;
+
+	// materials and Custom Function nodes define MAX_SDFS and friends before the include, translated libraries are
+	// the whole program
+	Config.bClosedWorld = Backend == EPSFShaderBackend::Godot || Backend == EPSFShaderBackend::GLSL;
+	return Config;
+}
+
+bool FPSFShaderGeneratorResult::HasProblems(const FPSFShaderBackendConfig &Config) const
+{
+	if(Config.bClosedWorld && ConditionalsKept > 0)
+	{
+		return true;
+	}
+	for(const FPSFFastPathResult &FastPath : FastPaths)
+	{
+		if(FastPath.Status == TEXT("unsupported") || FastPath.Status == TEXT("missing"))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+const TArray<FString> &FPSFShaderGenerator::GetDefaultFastPaths()
+{
+	static const TArray<FString> FastPaths = {
+		TEXT("advanceMarch"),
+		TEXT("evalSceneBVH"),
+		TEXT("evalBakedSDF"),
+		TEXT("dolphinSkeletonDistance"),
+		TEXT("computeWaveBaked"),
+		TEXT("sunriseInScatteringLUT")};
+	return FastPaths;
+}
+
+bool FPSFShaderGenerator::LoadFromDirectory(const FString &ShaderDir, const FString &RootFile)
+{
+	Root = FPaths::GetCleanFilename(RootFile);
+	return Source.LoadFromDirectory(ShaderDir, RootFile);
+}
+
+void FPSFShaderGenerator::Specialize(const FPSFShaderBackendConfig &Config, FPSFShaderGraph &OutGraph, FPSFShaderGeneratorResult &OutResult) const
+{
+	FDefineContext Context;
+	Context.bClosedWorld = Config.bClosedWorld;
+	for(const EPSFShaderBackend Backend : AllBackends)
+	{
+		Context.Values.Add(FString(TEXT("PSF_BACKEND_")) + FString(FPSFShaderBackendConfig::GetName(Backend)).ToUpper(), Backend == Config.Backend ? TEXT("1") : TEXT("0"));
+	}
+	for(const FString &Define : Config.Defines)
+	{
+		FString Name;
+		FString Value;
+		ParseDefine(Define, Name, Value);
+		Context.Values.Add(Name, Value);
+	}
+
+	for(const FString &FileName : Source.GetIncludeOrder(Root))
+	{
+		OutGraph.AddFile(FileName, FoldConditionals(Source.GetFileText(FileName), Context, OutResult.ConditionalsFolded, OutResult.ConditionalsKept));
+	}
+}
+
+FPSFShaderGeneratorResult FPSFShaderGenerator::Generate(const FPSFShaderBackendConfig &Config, const TArray<FString> &EntryPoints, const TArray<FString> &FastPaths) const
+{
+	FPSFShaderGeneratorResult Result;
+	Result.Backend = Config.Backend;
+	const double StartTime = FPlatformTime::Seconds();
+
+	FPSFAmalgamationStats SourceStats;
+	Source.CollectChunks(Root, TArray<FString>(), SourceStats);
+	Result.FunctionsSource = SourceStats.FunctionsTotal;
+	Result.LinesSource = SourceStats.LinesTotal;
+	Result.BytesSource = SourceStats.BytesTotal;
+
+	FPSFShaderGraph Specialized;
+	Specialize(Config, Specialized, Result);
+
+	FPSFAmalgamationStats Stats;
+	const TArray<const FPSFShaderChunk *> Chunks = Specialized.CollectChunks(Root, EntryPoints, Stats);
+
+	// the defines the library was folded with have to hold for the code that uses them as well
+	FString Defines;
+	for(const FString &Define : Config.Defines)
+	{
+		FString Name;
+		FString Value;
+		ParseDefine(Define, Name, Value);
+		Defines += FString::Printf(TEXT("#define %s %s\n"), *Name, *Value);
+	}
+
+	FString Header = FString::Printf(TEXT("// Generated from %s by the PSFGenerateShaders commandlet for %s, do not edit.\n"), *Root, FPSFShaderBackendConfig::GetName(Config.Backend));
+	if(EntryPoints.Num() > 0)
+	{
+		Header += FString::Printf(TEXT("// Entry points: %s\n"), *FString::Join(EntryPoints, TEXT(", ")));
+	}
+
+	TSet<FString> Emitted;
+	TMap<FString, FString> UnsupportedFunctions;
+	FString Body;
+	if(Config.Backend == EPSFShaderBackend::Unreal || Config.Backend == EPSFShaderBackend::Unity)
+	{
+		Body = Defines;
+		if(Config.Backend == EPSFShaderBackend::Unity)
+		{
+			// Common.ush defines it for the Unreal copy
+			Body += TEXT("#ifndef PI\n#define PI 3.14159265358979323846\n#endif\n");
+		}
+		for(const FPSFShaderChunk *Chunk : Chunks)
+		{
+			AppendCode(Body, Chunk->Text);
+			if(Chunk->Type == EPSFShaderChunkType::Function)
+			{
+				Emitted.Add(Chunk->Name);
+			}
+		}
+		Result.FunctionsEmitted = Stats.FunctionsKept;
+	}
+	else
+	{
+		FPSFShaderTranslator Translator(Config.Backend == EPSFShaderBackend::Godot ? EPSFShaderDialect::Godot : EPSFShaderDialect::GLSL);
+
+		// the defines go through the translator like the ones of the library, it needs their values
+		FPSFShaderGraph DefinesGraph;
+		DefinesGraph.AddFile(TEXT("defines"), Defines);
+		FPSFAmalgamationStats DefinesStats;
+		TArray<const FPSFShaderChunk *> AllChunks = DefinesGraph.CollectChunks(TEXT("defines"), TArray<FString>(), DefinesStats);
+		AllChunks.Append(Chunks);
+
+		// Godot: where PSFState has to be declared, in front of the first function that takes it
+		int32 StateOffset = INDEX_NONE;
+		for(const FPSFShaderChunk *Chunk : AllChunks)
+		{
+			FString Code;
+			FString Error;
+			const bool bUsedState = Translator.UsesState();
+			if(Translator.Translate(*Chunk, Code, Error))
+			{
+				if(!bUsedState && Translator.UsesState())
+				{
+					StateOffset = Body.Len();
+				}
+				AppendCode(Body, Code);
+				if(Chunk->Type == EPSFShaderChunkType::Function)
+				{
+					++Result.FunctionsEmitted;
+					Emitted.Add(Chunk->Name);
+				}
+				continue;
+			}
+
+			Result.Unsupported.Add({Chunk->Name, Error});
+			if(Chunk->Type == EPSFShaderChunkType::Function)
+			{
+				UnsupportedFunctions.Add(Chunk->Name, Error);
+			}
+			AppendCode(Body, Chunk->Name.IsEmpty() ? FString::Printf(TEXT("\n// unsupported: %s\n"), *Error) : FString::Printf(TEXT("\n// unsupported %s: %s\n"), *Chunk->Name, *Error));
+		}
+
+		if(StateOffset != INDEX_NONE)
+		{
+			FString WithState = Body.Left(StateOffset);
+			AppendCode(WithState, TEXT("\n\n") + Translator.GetStateDeclaration());
+			AppendCode(WithState, Body.Mid(StateOffset));
+			Body = WithState;
+		}
+
+		Header += Translator.GetPrelude();
+		const FPSFTranslationStats &TranslationStats = Translator.GetStats();
+		Result.IntrinsicsMapped = TranslationStats.IntrinsicsMapped;
+		Result.EmulatedCalls = TranslationStats.EmulatedCalls;
+		Result.Conversions = TranslationStats.Conversions;
+	}
+
+	Result.Code = Header;
+	AppendCode(Result.Code, Body);
+	Result.LinesEmitted = CountLines(Result.Code);
+	Result.BytesEmitted = Result.Code.Len();
+
+	for(const FString &Function : FastPaths)
+	{
+		FPSFFastPathResult FastPath;
+		FastPath.Function = Function;
+		if(Emitted.Contains(Function))
+		{
+			FastPath.Status = TEXT("emitted");
+		}
+		else if(const FString *Reason = UnsupportedFunctions.Find(Function))
+		{
+			FastPath.Status = TEXT("unsupported");
+			FastPath.Reason = *Reason;
+		}
+		else if(!Source.HasFunction(Function))
+		{
+			FastPath.Status = TEXT("missing");
+			FastPath.Reason = TEXT("not a function of the library");
+		}
+		else
+		{
+			FastPath.Status = TEXT("stripped");
+			FastPath.Reason = Specialized.HasFunction(Function) ? TEXT("not reachable from the entry points") : TEXT("inside a folded conditional");
+		}
+		Result.FastPaths.Add(FastPath);
+	}
+
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	return Result;
+}
+
+FString FPSFShaderGenerator::ToJsonString(const TArray<FPSFShaderGeneratorResult> &Results)
+{
+	TArray<TSharedPtr<FJsonValue>> BackendValues;
+	for(const FPSFShaderGeneratorResult &Result : Results)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetStringField(TEXT("backend"), FPSFShaderBackendConfig::GetName(Result.Backend));
+		Object->SetNumberField(TEXT("seconds"), Result.Seconds);
+		Object->SetNumberField(TEXT("functionsSource"), Result.FunctionsSource);
+		Object->SetNumberField(TEXT("functionsEmitted"), Result.FunctionsEmitted);
+		Object->SetNumberField(TEXT("linesSource"), Result.LinesSource);
+		Object->SetNumberField(TEXT("linesEmitted"), Result.LinesEmitted);
+		Object->SetNumberField(TEXT("bytesSource"), Result.BytesSource);
+		Object->SetNumberField(TEXT("bytesEmitted"), Result.BytesEmitted);
+		Object->SetNumberField(TEXT("conditionalsFolded"), Result.ConditionalsFolded);
+		Object->SetNumberField(TEXT("conditionalsKept"), Result.ConditionalsKept);
+		Object->SetNumberField(TEXT("intrinsicsMapped"), Result.IntrinsicsMapped);
+		Object->SetNumberField(TEXT("emulatedCalls"), Result.EmulatedCalls);
+		Object->SetNumberField(TEXT("conversions"), Result.Conversions);
+
+		TArray<TSharedPtr<FJsonValue>> UnsupportedValues;
+		for(const FPSFUnsupportedChunk &Unsupported : Result.Unsupported)
+		{
+			TSharedRef<FJsonObject> UnsupportedObject = MakeShared<FJsonObject>();
+			UnsupportedObject->SetStringField(TEXT("name"), Unsupported.Name);
+			UnsupportedObject->SetStringField(TEXT("reason"), Unsupported.Reason);
+			UnsupportedValues.Add(MakeShared<FJsonValueObject>(UnsupportedObject));
+		}
+		Object->SetArrayField(TEXT("unsupported"), UnsupportedValues);
+
+		TArray<TSharedPtr<FJsonValue>> FastPathValues;
+		for(const FPSFFastPathResult &FastPath : Result.FastPaths)
+		{
+			TSharedRef<FJsonObject> FastPathObject = MakeShared<FJsonObject>();
+			FastPathObject->SetStringField(TEXT("function"), FastPath.Function);
+			FastPathObject->SetStringField(TEXT("status"), FastPath.Status);
+			FastPathObject->SetStringField(TEXT("reason"), FastPath.Reason);
+			FastPathValues.Add(MakeShared<FJsonValueObject>(FastPathObject));
+		}
+		Object->SetArrayField(TEXT("fastPaths"), FastPathValues);
+
+		BackendValues.Add(MakeShared<FJsonValueObject>(Object));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetArrayField(TEXT("backends"), BackendValues);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+void FPSFShaderGenerator::LogResult(const FPSFShaderGeneratorResult &Result)
+{
+	UE_LOG(LogTemp, Display, TEXT("%s: %d of %d functions, %d of %d lines, %d of %d bytes in %.3f s. %d conditionals folded, %d kept."),
+		FPSFShaderBackendConfig::GetName(Result.Backend), Result.FunctionsEmitted, Result.FunctionsSource, Result.LinesEmitted, Result.LinesSource,
+		Result.BytesEmitted, Result.BytesSource, Result.Seconds, Result.ConditionalsFolded, Result.ConditionalsKept);
+	if(Result.Backend == EPSFShaderBackend::Godot || Result.Backend == EPSFShaderBackend::GLSL)
+	{
+		UE_LOG(LogTemp, Display, TEXT("    %d intrinsics native, %d emulated, %d implicit conversions spelled out, %d chunks unsupported."),
+			Result.IntrinsicsMapped, Result.EmulatedCalls, Result.Conversions, Result.Unsupported.Num());
+	}
+	for(const FPSFUnsupportedChunk &Unsupported : Result.Unsupported)
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("    unsupported %s: %s"), *Unsupported.Name, *Unsupported.Reason);
+	}
+	for(const FPSFFastPathResult &FastPath : Result.FastPaths)
+	{
+		if(FastPath.Reason.IsEmpty())
+		{
+			UE_LOG(LogTemp, Display, TEXT("    fast path %s: %s"), *FastPath.Function, *FastPath.Status);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("    fast path %s: %s (%s)"), *FastPath.Function, *FastPath.Status, *FastPath.Reason);
+		}
+	}
+}
@@ -0,0 +1,634 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFShaderGraph.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	bool IsIdentifierStart(TCHAR Character)
+	{
+		return FChar::IsAlpha(Character) || Character == TEXT('_');
+	}
+
+	bool IsIdentifierCharacter(TCHAR Character)
+	{
+		return FChar::IsAlnum(Character) || Character == TEXT('_');
+	}
+
+	/** Index after the comment that starts at Pos, Pos if there is none */
+	int32 SkipComment(const FString &Text, int32 Pos)
+	{
+		if(Text[Pos] != TEXT('/') || Pos + 1 >= Text.Len())
+		{
+			return Pos;
+		}
+		if(Text[Pos + 1] == TEXT('/'))
+		{
+			const int32 LineEnd = Text.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Pos);
+			return LineEnd == INDEX_NONE ? Text.Len() : LineEnd;
+		}
+		if(Text[Pos + 1] == TEXT('*'))
+		{
+			const int32 CommentEnd = Text.Find(TEXT("*/"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Pos + 2);
+			return CommentEnd == INDEX_NONE ? Text.Len() : CommentEnd + 2;
+		}
+		return Pos;
+	}
+
+	/** Index after the comment or string literal that starts at Pos, Pos if there is none */
+	int32 SkipCommentOrString(const FString &Text, int32 Pos)
+	{
+		if(Text[Pos] != TEXT('"'))
+		{
+			return SkipComment(Text, Pos);
+		}
+
+		++Pos;
+		while(Pos < Text.Len() && Text[Pos] != TEXT('"'))
+		{
+			Pos += Text[Pos] == TEXT('\\') ? 2 : 1;
+		}
+		return FMath::Min(Pos + 1, Text.Len());
+	}
+
+	int32 SkipWhitespaceAndComments(const FString &Text, int32 Pos)
+	{
+		while(Pos < Text.Len())
+		{
+			if(FChar::IsWhitespace(Text[Pos]))
+			{
+				++Pos;
+				continue;
+			}
+
+			const int32 Skipped = SkipComment(Text, Pos);
+			if(Skipped == Pos)
+			{
+				break;
+			}
+			Pos = Skipped;
+		}
+		return Pos;
+	}
+
+	/** End of the directive that starts at Pos, lines ending with \ continue it */
+	int32 FindDirectiveEnd(const FString &Text, int32 Pos)
+	{
+		while(true)
+		{
+			const int32 LineEnd = Text.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Pos);
+			if(LineEnd == INDEX_NONE)
+			{
+				return Text.Len();
+			}
+
+			int32 Last = LineEnd - 1;
+			while(Last > Pos && Text[Last] == TEXT('\r'))
+			{
+				--Last;
+			}
+			if(Text[Last] != TEXT('\\'))
+			{
+				return LineEnd;
+			}
+			Pos = LineEnd + 1;
+		}
+	}
+
+	/** Index after the } that closes the { at OpenPos */
+	int32 FindClosingBrace(const FString &Text, int32 OpenPos)
+	{
+		int32 Depth = 0;
+		int32 Pos = OpenPos;
+		while(Pos < Text.Len())
+		{
+			const int32 Skipped = SkipCommentOrString(Text, Pos);
+			if(Skipped != Pos)
+			{
+				Pos = Skipped;
+				continue;
+			}
+
+			if(Text[Pos] == TEXT('{'))
+			{
+				++Depth;
+			}
+			else if(Text[Pos] == TEXT('}') && --Depth == 0)
+			{
+				return Pos + 1;
+			}
+			++Pos;
+		}
+		return Text.Len();
+	}
+
+	/** The identifier that ends right before End, skipping whitespace */
+	FString IdentifierBefore(const FString &Text, int32 End)
+	{
+		while(End > 0 && FChar::IsWhitespace(Text[End - 1]))
+		{
+			--End;
+		}
+		int32 Start = End;
+		while(Start > 0 && IsIdentifierCharacter(Text[Start - 1]))
+		{
+			--Start;
+		}
+		return Text.Mid(Start, End - Start);
+	}
+
+	/**
+	 * "float3 name(float3 p, float r = 1.0)" or with a semantic "float4 name(...) : SV_Target".
+	 * Initializers ("static float a[2] = {...}") and structs are not functions.
+	 */
+	bool IsFunctionSignature(const FString &Prefix, FString &OutName)
+	{
+		const int32 OpenParen = Prefix.Find(TEXT("("), ESearchCase::CaseSensitive);
+		const int32 CloseParen = Prefix.Find(TEXT(")"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+		if(OpenParen == INDEX_NONE || CloseParen < OpenParen || Prefix.Left(OpenParen).Contains(TEXT("="), ESearchCase::CaseSensitive))
+		{
+			return false;
+		}
+
+		const FString AfterParameters = Prefix.Mid(CloseParen + 1).TrimStartAndEnd();
+		if(!AfterParameters.IsEmpty() && AfterParameters[0] != TEXT(':'))
+		{
+			return false;
+		}
+
+		OutName = IdentifierBefore(Prefix, OpenParen);
+		return !OutName.IsEmpty();
+	}
+
+	void CollectIdentifiers(const FString &Text, TSet<FString> &OutIdentifiers)
+	{
+		TCHAR Previous = TEXT(' ');
+		int32 Pos = 0;
+		while(Pos < Text.Len())
+		{
+			const int32 Skipped = SkipCommentOrString(Text, Pos);
+			if(Skipped != Pos)
+			{
+				Pos = Skipped;
+				continue;
+			}
+
+			const TCHAR Character = Text[Pos];
+			if(IsIdentifierStart(Character) || FChar::IsDigit(Character))
+			{
+				const int32 Start = Pos;
+				while(Pos < Text.Len() && IsIdentifierCharacter(Text[Pos]))
+				{
+					++Pos;
+				}
+
+				// numbers like 1e5 and members like s.type are no references
+				if(IsIdentifierStart(Character) && Previous != TEXT('.'))
+				{
+					OutIdentifiers.Add(Text.Mid(Start, Pos - Start));
+				}
+				Previous = TEXT('a');
+				continue;
+			}
+
+			if(!FChar::IsWhitespace(Character))
+			{
+				Previous = Character;
+			}
+			++Pos;
+		}
+	}
+
+	int32 CountLines(const FString &Text)
+	{
+		int32 Lines = 0;
+		for(const TCHAR Character : Text)
+		{
+			Lines += Character == TEXT('\n') ? 1 : 0;
+		}
+		return Lines;
+	}
+}
+
+bool FPSFShaderGraph::LoadFromDirectory(const FString &ShaderDir, const FString &RootFile)
+{
+	Files.Reset();
+	FunctionFiles.Reset();
+
+	const FString RootName = FPaths::GetCleanFilename(RootFile);
+	TArray<FString> Queue = {RootName};
+	while(Queue.Num() > 0)
+	{
+		const FString FileName = Queue.Pop();
+		if(Files.Contains(FileName))
+		{
+			continue;
+		}
+
+		FString Content;
+		if(!FFileHelper::LoadFileToString(Content, *(ShaderDir / FileName)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to read shader: %s"), *(ShaderDir / FileName));
+			if(FileName == RootName)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		AddFile(FileName, Content);
+
+		// engine includes like /Engine/Private/Common.ush are not part of the graph and stay include lines
+		for(const FString &Include : Files[FileName].Includes)
+		{
+			if(!Files.Contains(Include) && FPaths::FileExists(ShaderDir / Include))
+			{
+				Queue.Add(Include);
+			}
+		}
+	}
+	return true;
+}
+
+void FPSFShaderGraph::AddFile(const FString &FileName, const FString &Content)
+{
+	FPSFShaderFile &File = Files.Add(FileName);
+	File.Name = FileName;
+
+	const int32 Length = Content.Len();
+	int32 Pos = 0;
+	while(Pos < Length)
+	{
+		FPSFShaderChunk Chunk;
+		const int32 ChunkStart = Pos;
+		const int32 Start = SkipWhitespaceAndComments(Content, Pos);
+		int32 End = Length;
+
+		if(Start >= Length)
+		{
+			// trailing comments and whitespace
+			Chunk.Type = EPSFShaderChunkType::Declaration;
+		}
+		else if(Content[Start] == TEXT('#'))
+		{
+			Chunk.Type = EPSFShaderChunkType::Preprocessor;
+			End = FindDirectiveEnd(Content, Start);
+
+			const FString Directive = Content.Mid(Start, End - Start);
+			const int32 QuoteStart = Directive.Find(TEXT("\""), ESearchCase::CaseSensitive);
+			const int32 QuoteEnd = Directive.Find(TEXT("\""), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+			if(Directive.StartsWith(TEXT("#include"), ESearchCase::CaseSensitive) && QuoteStart != INDEX_NONE && QuoteEnd > QuoteStart)
+			{
+				Chunk.Name = FPaths::GetCleanFilename(Directive.Mid(QuoteStart + 1, QuoteEnd - QuoteStart - 1));
+				File.Includes.Add(Chunk.Name);
+			}
+		}
+		else
+		{
+			Chunk.Type = EPSFShaderChunkType::Declaration;
+
+			int32 ParenDepth = 0;
+			int32 Scan = Start;
+			while(Scan < Length)
+			{
+				const int32 Skipped = SkipCommentOrString(Content, Scan);
+				if(Skipped != Scan)
+				{
+					Scan = Skipped;
+					continue;
+				}
+
+				const TCHAR Character = Content[Scan];
+				if(Character == TEXT('('))
+				{
+					++ParenDepth;
+				}
+				else if(Character == TEXT(')'))
+				{
+					--ParenDepth;
+				}
+				else if(Character == TEXT(';') && ParenDepth == 0)
+				{
+					End = Scan + 1;
+					break;
+				}
+				else if(Character == TEXT('{') && ParenDepth == 0)
+				{
+					End = FindClosingBrace(Content, Scan);
+
+					FString Name;
+					if(IsFunctionSignature(Content.Mid(Start, Scan - Start), Name))
+					{
+						Chunk.Type = EPSFShaderChunkType::Function;
+						Chunk.Name = Name;
+						break;
+					}
+
+					// struct X { ... }; and cbuffers, the ; belongs to the declaration
+					const int32 Next = SkipWhitespaceAndComments(Content, End);
+					if(Next < Length && Content[Next] == TEXT(';'))
+					{
+						End = Next + 1;
+					}
+					break;
+				}
+				++Scan;
+			}
+		}
+
+		Chunk.Text = Content.Mid(ChunkStart, End - ChunkStart);
+		if(Chunk.Type == EPSFShaderChunkType::Function)
+		{
+			// the body, the signature only names parameter types
+			const int32 BodyStart = Chunk.Text.Find(TEXT("{"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Start - ChunkStart);
+			CollectIdentifiers(Chunk.Text.Mid(BodyStart), Chunk.Identifiers);
+			FunctionFiles.FindOrAdd(Chunk.Name).AddUnique(FileName);
+		}
+		else if(Chunk.Name.IsEmpty())
+		{
+			CollectIdentifiers(Chunk.Text, Chunk.Identifiers);
+		}
+
+		File.Chunks.Add(MoveTemp(Chunk));
+		Pos = End;
+	}
+}
+
+FString FPSFShaderGraph::ResolveInclude(const FString &Target) const
+{
+	return Files.Contains(Target) ? Target : FString();
+}
+
+void FPSFShaderGraph::VisitIncludes(const FString &File, TSet<FString> &Visited, TArray<FString> &OutOrder) const
+{
+	if(Visited.Contains(File))
+	{
+		return;
+	}
+	Visited.Add(File);
+
+	for(const FString &Include : Files[File].Includes)
+	{
+		const FString Resolved = ResolveInclude(Include);
+		if(!Resolved.IsEmpty())
+		{
+			VisitIncludes(Resolved, Visited, OutOrder);
+		}
+	}
+	OutOrder.Add(File);
+}
+
+TArray<FString> FPSFShaderGraph::GetIncludeOrder(const FString &Root) const
+{
+	TArray<FString> Order;
+	TSet<FString> Visited;
+	const FString RootName = ResolveInclude(FPaths::GetCleanFilename(Root));
+	if(!RootName.IsEmpty())
+	{
+		VisitIncludes(RootName, Visited, Order);
+	}
+	return Order;
+}
+
+TArray<FString> FPSFShaderGraph::GetCallees(const FString &Function) const
+{
+	TArray<FString> Callees;
+	const TArray<FString> *DefiningFiles = FunctionFiles.Find(Function);
+	if(!DefiningFiles)
+	{
+		return Callees;
+	}
+
+	for(const FString &FileName : *DefiningFiles)
+	{
+		for(const FPSFShaderChunk &Chunk : Files[FileName].Chunks)
+		{
+			if(Chunk.Type != EPSFShaderChunkType::Function || !Chunk.Name.Equals(Function, ESearchCase::CaseSensitive))
+			{
+				continue;
+			}
+			for(const FString &Identifier : Chunk.Identifiers)
+			{
+				if(Identifier != Function && FunctionFiles.Contains(Identifier))
+				{
+					Callees.AddUnique(Identifier);
+				}
+			}
+		}
+	}
+	return Callees;
+}
+
+bool FPSFShaderGraph::CollectReachable(const FString &Root, const TArray<FString> &EntryPoints, TSet<FString> &OutFunctions, TArray<FString> &OutMissing) const
+{
+	TArray<FString> Queue;
+	for(const FString &EntryPoint : EntryPoints)
+	{
+		if(FunctionFiles.Contains(EntryPoint))
+		{
+			Queue.Add(EntryPoint);
+		}
+		else
+		{
+			OutMissing.Add(EntryPoint);
+		}
+	}
+
+	// functions used by a declaration or a macro can not be followed by name, they are always kept
+	for(const FString &FileName : GetIncludeOrder(Root))
+	{
+		for(const FPSFShaderChunk &Chunk : Files[FileName].Chunks)
+		{
+			if(Chunk.Type == EPSFShaderChunkType::Function)
+			{
+				continue;
+			}
+			for(const FString &Identifier : Chunk.Identifiers)
+			{
+				if(FunctionFiles.Contains(Identifier))
+				{
+					Queue.Add(Identifier);
+				}
+			}
+		}
+	}
+
+	while(Queue.Num() > 0)
+	{
+		const FString Function = Queue.Pop();
+		if(OutFunctions.Contains(Function))
+		{
+			continue;
+		}
+		OutFunctions.Add(Function);
+		Queue.Append(GetCallees(Function));
+	}
+
+	return OutMissing.Num() == 0;
+}
+
+FString FPSFShaderGraph::GetFileText(const FString &FileName) const
+{
+	FString Text;
+	if(const FPSFShaderFile *File = Files.Find(FileName))
+	{
+		for(const FPSFShaderChunk &Chunk : File->Chunks)
+		{
+			Text += Chunk.Text;
+		}
+	}
+	return Text;
+}
+
+TArray<const FPSFShaderChunk *> FPSFShaderGraph::CollectChunks(const FString &Root, const TArray<FString> &EntryPoints, FPSFAmalgamationStats &OutStats) const
+{
+	OutStats = FPSFAmalgamationStats();
+
+	TSet<FString> Reachable;
+	TArray<FString> Missing;
+	if(EntryPoints.Num() > 0 && !CollectReachable(Root, EntryPoints, Reachable, Missing))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unknown entry points: %s"), *FString::Join(Missing, TEXT(", ")));
+	}
+
+	TArray<const FPSFShaderChunk *> Chunks;
+	for(const FString &FileName : GetIncludeOrder(Root))
+	{
+		++OutStats.Files;
+		for(const FPSFShaderChunk &Chunk : Files[FileName].Chunks)
+		{
+			OutStats.BytesTotal += Chunk.Text.Len();
+			OutStats.LinesTotal += CountLines(Chunk.Text);
+
+			// resolved includes are inlined before this file
+			if(Chunk.Type == EPSFShaderChunkType::Preprocessor && !ResolveInclude(Chunk.Name).IsEmpty())
+			{
+				continue;
+			}
+
+			if(Chunk.Type == EPSFShaderChunkType::Function)
+			{
+				++OutStats.FunctionsTotal;
+				if(EntryPoints.Num() > 0 && !Reachable.Contains(Chunk.Name))
+				{
+					continue;
+				}
+				++OutStats.FunctionsKept;
+			}
+
+			Chunks.Add(&Chunk);
+			OutStats.BytesKept += Chunk.Text.Len();
+			OutStats.LinesKept += CountLines(Chunk.Text);
+		}
+	}
+	return Chunks;
+}
+
+FString FPSFShaderGraph::Amalgamate(const FString &Root, const TArray<FString> &EntryPoints, FPSFAmalgamationStats &OutStats) const
+{
+	OutStats = FPSFAmalgamationStats();
+
+	TSet<FString> Reachable;
+	TArray<FString> Missing;
+	if(!CollectReachable(Root, EntryPoints, Reachable, Missing))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unknown entry points: %s"), *FString::Join(Missing, TEXT(", ")));
+	}
+
+	FString Code;
+	Code += FString::Printf(TEXT("// Generated from %s by the PSFAmalgamate commandlet, do not edit.\n"), *FPaths::GetCleanFilename(Root));
+	Code += FString::Printf(TEXT("// Entry points: %s\n"), *FString::Join(EntryPoints, TEXT(", ")));
+	Code += TEXT("// Replaces procedural_shader.ush in a material, the two can not be included together.\n");
+
+	for(const FString &FileName : GetIncludeOrder(Root))
+	{
+		++OutStats.Files;
+		Code += FString::Printf(TEXT("\n// ---- %s ----\n"), *FileName);
+
+		for(const FPSFShaderChunk &Chunk : Files[FileName].Chunks)
+		{
+			OutStats.BytesTotal += Chunk.Text.Len();
+			OutStats.LinesTotal += CountLines(Chunk.Text);
+
+			// resolved includes are inlined before this file
+			if(Chunk.Type == EPSFShaderChunkType::Preprocessor && !ResolveInclude(Chunk.Name).IsEmpty())
+			{
+				continue;
+			}
+
+			if(Chunk.Type == EPSFShaderChunkType::Function)
+			{
+				++OutStats.FunctionsTotal;
+				if(!Reachable.Contains(Chunk.Name))
+				{
+					continue;
+				}
+				++OutStats.FunctionsKept;
+			}
+
+			Code += Chunk.Text;
+			OutStats.BytesKept += Chunk.Text.Len();
+			OutStats.LinesKept += CountLines(Chunk.Text);
+		}
+		Code += TEXT("\n");
+	}
+	return Code;
+}
+
+FString FPSFShaderGraph::ToJsonString() const
+{
+	TSharedRef<FJsonObject> FilesObject = MakeShared<FJsonObject>();
+	for(const TPair<FString, FPSFShaderFile> &File : Files)
+	{
+		TArray<TSharedPtr<FJsonValue>> Includes;
+		for(const FString &Include : File.Value.Includes)
+		{
+			Includes.Add(MakeShared<FJsonValueString>(Include));
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Functions;
+		for(const FPSFShaderChunk &Chunk : File.Value.Chunks)
+		{
+			if(Chunk.Type == EPSFShaderChunkType::Function)
+			{
+				Functions.Add(MakeShared<FJsonValueString>(Chunk.Name));
+			}
+		}
+
+		TSharedRef<FJsonObject> FileObject = MakeShared<FJsonObject>();
+		FileObject->SetArrayField(TEXT("includes"), Includes);
+		FileObject->SetArrayField(TEXT("functions"), Functions);
+		FilesObject->SetObjectField(File.Key, FileObject);
+	}
+
+	TSharedRef<FJsonObject> Calls = MakeShared<FJsonObject>();
+	for(const TPair<FString, TArray<FString>> &Function : FunctionFiles)
+	{
+		TArray<TSharedPtr<FJsonValue>> Callees;
+		for(const FString &Callee : GetCallees(Function.Key))
+		{
+			Callees.Add(MakeShared<FJsonValueString>(Callee));
+		}
+		Calls->SetArrayField(Function.Key, Callees);
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetObjectField(TEXT("files"), FilesObject);
+	Root->SetObjectField(TEXT("calls"), Calls);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(Root, Writer);
+	return JsonString;
+}
+
+void FPSFShaderGraph::LogStats(const FPSFAmalgamationStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("Amalgamated %d files: %d of %d functions, %d of %d lines, %d of %d bytes (%.0f%%)."),
+		Stats.Files, Stats.FunctionsKept, Stats.FunctionsTotal, Stats.LinesKept, Stats.LinesTotal, Stats.BytesKept, Stats.BytesTotal,
+		Stats.BytesTotal > 0 ? 100.0 * Stats.BytesKept / Stats.BytesTotal : 0.0);
+}
@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFShaderPatcher.h"
+#include "PSFShaderSync.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	const TCHAR *MarkerPrefix = TEXT("// PSFCODE");
+	const TCHAR *MarkerStartSuffix = TEXT("START");
+	const TCHAR *MarkerEndSuffix = TEXT("END");
+}
+
+bool FPSFShaderPatcher::Load(const FString &InFilePath)
+{
+	FilePath = InFilePath;
+
+	FString Content;
+	if(!FFileHelper::LoadFileToString(Content, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read file: %s"), *FilePath);
+		bValid = false;
+		return false;
+	}
+	return Parse(Content);
+}
+
+bool FPSFShaderPatcher::Parse(const FString &Content)
+{
+	Original = Content;
+	Regions.Reset();
+	bValid = false;
+
+	const int32 PrefixLength = FCString::Strlen(MarkerPrefix);
+	FRegion *OpenRegion = nullptr;
+
+	int32 Search = 0;
+	while(true)
+	{
+		const int32 Marker = Original.Find(MarkerPrefix, ESearchCase::CaseSensitive, ESearchDir::FromStart, Search);
+		if(Marker == INDEX_NONE)
+		{
+			break;
+		}
+
+		int32 TokenEnd = Marker + PrefixLength;
+		while(TokenEnd < Original.Len() && (FChar::IsAlnum(Original[TokenEnd]) || Original[TokenEnd] == TEXT('_')))
+		{
+			++TokenEnd;
+		}
+		Search = TokenEnd;
+
+		const FString Token = Original.Mid(Marker + PrefixLength, TokenEnd - Marker - PrefixLength);
+		if(Token.EndsWith(MarkerStartSuffix, ESearchCase::CaseSensitive))
+		{
+			const FString Name = Token.LeftChop(FCString::Strlen(MarkerStartSuffix));
+			if(OpenRegion)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: marker %s starts inside of %s."), *FilePath, *Name, *OpenRegion->Name);
+				return false;
+			}
+			if(FindRegion(Name))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: marker %s exists more than once."), *FilePath, *Name);
+				return false;
+			}
+
+			const int32 LineEnd = Original.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromStart, TokenEnd);
+			if(LineEnd == INDEX_NONE)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: marker %s has no end."), *FilePath, *Name);
+				return false;
+			}
+
+			OpenRegion = &Regions.AddDefaulted_GetRef();
+			OpenRegion->Name = Name;
+			OpenRegion->BodyStart = LineEnd + 1;
+		}
+		else if(Token.EndsWith(MarkerEndSuffix, ESearchCase::CaseSensitive))
+		{
+			const FString Name = Token.LeftChop(FCString::Strlen(MarkerEndSuffix));
+			if(!OpenRegion || !OpenRegion->Name.Equals(Name, ESearchCase::CaseSensitive))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: marker %s ends without a start."), *FilePath, *Name);
+				return false;
+			}
+
+			// the region ends where the line of the end marker begins, its indentation is not part of the region
+			const int32 LineStart = Original.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromEnd, Marker) + 1;
+			if(LineStart < OpenRegion->BodyStart)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: marker %s ends on the line it starts."), *FilePath, *Name);
+				return false;
+			}
+
+			OpenRegion->BodyEnd = LineStart;
+			OpenRegion->Body = Original.Mid(OpenRegion->BodyStart, LineStart - OpenRegion->BodyStart);
+			OpenRegion = nullptr;
+		}
+	}
+
+	if(OpenRegion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: marker %s has no end."), *FilePath, *OpenRegion->Name);
+		return false;
+	}
+
+	bValid = true;
+	return true;
+}
+
+bool FPSFShaderPatcher::HasRegion(const FString &Name) const
+{
+	return FindRegion(Name) != nullptr;
+}
+
+FString FPSFShaderPatcher::GetRegion(const FString &Name) const
+{
+	const FRegion *Region = FindRegion(Name);
+	return Region ? Region->Body : FString();
+}
+
+bool FPSFShaderPatcher::SetRegion(const FString &Name, const FString &Body)
+{
+	FRegion *Region = FindRegion(Name);
+	if(!Region)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: could not find the markers of %s."), *FilePath, *Name);
+		bValid = false;
+		return false;
+	}
+
+	Region->Body = Body;
+	return true;
+}
+
+TArray<FString> FPSFShaderPatcher::GetRegionNames() const
+{
+	TArray<FString> Names;
+	for(const FRegion &Region : Regions)
+	{
+		Names.Add(Region.Name);
+	}
+	return Names;
+}
+
+bool FPSFShaderPatcher::IsModified() const
+{
+	for(const FRegion &Region : Regions)
+	{
+		if(!Region.Body.Equals(Original.Mid(Region.BodyStart, Region.BodyEnd - Region.BodyStart), ESearchCase::CaseSensitive))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+FString FPSFShaderPatcher::GetContent() const
+{
+	FString Content;
+	Content.Reserve(Original.Len());
+
+	int32 Copied = 0;
+	for(const FRegion &Region : Regions)
+	{
+		Content += Original.Mid(Copied, Region.BodyStart - Copied);
+		Content += Region.Body;
+		Copied = Region.BodyEnd;
+	}
+	Content += Original.Mid(Copied);
+	return Content;
+}
+
+bool FPSFShaderPatcher::Save(bool &bOutWritten)
+{
+	bOutWritten = false;
+	if(!bValid || FilePath.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s was not patched, an edit failed."), *FilePath);
+		return false;
+	}
+
+	if(!IsModified())
+	{
+		return true;
+	}
+
+	const FString Content = GetContent();
+	if(!SaveStringIfChanged(Content, FilePath, bOutWritten))
+	{
+		return false;
+	}
+
+	// later edits are compared against what is on disk now
+	return Parse(Content);
+}
+
+bool FPSFShaderPatcher::SaveStringIfChanged(const FString &Content, const FString &FilePath, bool &bOutWritten)
+{
+	bOutWritten = false;
+
+	FString Existing;
+	if(FPaths::FileExists(FilePath) && FFileHelper::LoadFileToString(Existing, *FilePath) && Existing.Equals(Content, ESearchCase::CaseSensitive))
+	{
+		return true;
+	}
+
+	const FTCHARToUTF8 Converted(*Content);
+	const TArray<uint8> Bytes(reinterpret_cast<const uint8 *>(Converted.Get()), Converted.Length());
+	if(!FPSFShaderSync::SaveArrayToFileAtomic(Bytes, FilePath))
+	{
+		return false;
+	}
+
+	bOutWritten = true;
+	return true;
+}
+
+FPSFShaderPatcher::FRegion *FPSFShaderPatcher::FindRegion(const FString &Name)
+{
+	return Regions.FindByPredicate([&Name](const FRegion &Region)
+	{
+		return Region.Name.Equals(Name, ESearchCase::CaseSensitive);
+	});
+}
+
+const FPSFShaderPatcher::FRegion *FPSFShaderPatcher::FindRegion(const FString &Name) const
+{
+	return const_cast<FPSFShaderPatcher *>(this)->FindRegion(Name);
+}
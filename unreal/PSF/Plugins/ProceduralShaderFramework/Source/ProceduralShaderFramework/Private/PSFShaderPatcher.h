@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Edits the generated regions of a shader file, the text between a
+ * // PSFCODE<NAME>START line and the line of the matching // PSFCODE<NAME>END.
+ *
+ * The markers are parsed once (case-sensitive, no nesting, no duplicates), all edits are applied in memory and
+ * Save writes the file at most once and only if its content changed, so an edit that reproduces the existing code
+ * does not touch the file and does not trigger a shader recompile. If any edit fails nothing is written.
+ */
+class FPSFShaderPatcher
+{
+public:
+	/** Loads and parses FilePath, false if it can not be read or its markers are malformed */
+	bool Load(const FString &InFilePath);
+
+	/** Parses Content without a file behind it, Save is not available */
+	bool Parse(const FString &Content);
+
+	bool HasRegion(const FString &Name) const;
+
+	/** Text of the region including its trailing line terminator, empty if there is no such region */
+	FString GetRegion(const FString &Name) const;
+
+	/** Replaces the text of a region. The marker pair has to exist, Body should end with a line terminator. */
+	bool SetRegion(const FString &Name, const FString &Body);
+
+	/** Names of the regions in file order */
+	TArray<FString> GetRegionNames() const;
+
+	/** True if an edit changed the text of at least one region */
+	bool IsModified() const;
+
+	/** False after a failed Load/Parse or SetRegion, Save refuses to write in that state */
+	bool IsValid() const
+	{
+		return bValid;
+	}
+
+	FString GetContent() const;
+
+	/**
+	 * Writes the patched content if it differs from the loaded one.
+	 * bOutWritten tells whether the file was touched, the return value whether the patch was applied.
+	 */
+	bool Save(bool &bOutWritten);
+
+	/** Writes Content to FilePath unless the file already has exactly this content */
+	static bool SaveStringIfChanged(const FString &Content, const FString &FilePath, bool &bOutWritten);
+
+private:
+	struct FRegion
+	{
+		FString Name;
+
+		/** Range of the region text in Original, it starts on the line after the start marker */
+		int32 BodyStart = 0;
+		int32 BodyEnd = 0;
+
+		FString Body;
+	};
+
+	FRegion *FindRegion(const FString &Name);
+	const FRegion *FindRegion(const FString &Name) const;
+
+	FString FilePath;
+	FString Original;
+	TArray<FRegion> Regions;
+	bool bValid = false;
+};
@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFShaderSync.h"
+#include "PSFShaderPatcher.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Interfaces/IPluginManager.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	const TCHAR *MarkerPrefix = TEXT("// PSFCODE");
+
+	struct FManifestEntry
+	{
+		/** MD5 of the plugin shader when it was last synced */
+		FString Source;
+
+		/** MD5 of the project copy that was written for it */
+		FString Project;
+	};
+
+	FString HashBytes(const TArray<uint8> &Bytes)
+	{
+		return FMD5::HashBytes(Bytes.GetData(), Bytes.Num());
+	}
+
+	TMap<FString, FManifestEntry> LoadManifest(const FString &ManifestPath, FString &OutJsonString)
+	{
+		TMap<FString, FManifestEntry> Manifest;
+
+		// no manifest yet, every file is compared by content
+		if(!FPaths::FileExists(ManifestPath) || !FFileHelper::LoadFileToString(OutJsonString, *ManifestPath))
+		{
+			return Manifest;
+		}
+
+		TSharedPtr<FJsonObject> Root;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(OutJsonString);
+		const TSharedPtr<FJsonObject> *Files = nullptr;
+		if(!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetObjectField(TEXT("files"), Files))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Shader manifest %s is not valid, comparing all shaders by content."), *ManifestPath);
+			return Manifest;
+		}
+
+		for(const TPair<FString, TSharedPtr<FJsonValue>> &File : (*Files)->Values)
+		{
+			const TSharedPtr<FJsonObject> *FileObject = nullptr;
+			if(File.Value.IsValid() && File.Value->TryGetObject(FileObject))
+			{
+				FManifestEntry &Entry = Manifest.Add(File.Key);
+				(*FileObject)->TryGetStringField(TEXT("source"), Entry.Source);
+				(*FileObject)->TryGetStringField(TEXT("project"), Entry.Project);
+			}
+		}
+		return Manifest;
+	}
+
+	void SaveManifest(const FString &ManifestPath, const TMap<FString, FManifestEntry> &Manifest, const FString &PreviousJsonString)
+	{
+		TSharedRef<FJsonObject> Files = MakeShared<FJsonObject>();
+		for(const TPair<FString, FManifestEntry> &File : Manifest)
+		{
+			TSharedRef<FJsonObject> FileObject = MakeShared<FJsonObject>();
+			FileObject->SetStringField(TEXT("source"), File.Value.Source);
+			FileObject->SetStringField(TEXT("project"), File.Value.Project);
+			Files->SetObjectField(File.Key, FileObject);
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetNumberField(TEXT("version"), 1);
+		Root->SetObjectField(TEXT("files"), Files);
+
+		FString JsonString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+		FJsonSerializer::Serialize(Root, Writer);
+
+		if(!JsonString.Equals(PreviousJsonString, ESearchCase::CaseSensitive) && !FFileHelper::SaveStringToFile(JsonString, *ManifestPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to write shader manifest: %s"), *ManifestPath);
+		}
+	}
+}
+
+FPSFShaderSync::FPSFShaderSync(const FString &InPluginShaderDir, const FString &InProjectShaderDir, const FString &InManifestPath)
+	: PluginShaderDir(InPluginShaderDir)
+	, ProjectShaderDir(InProjectShaderDir)
+	, ManifestPath(InManifestPath)
+{
+}
+
+FPSFShaderSync FPSFShaderSync::CreateForProject()
+{
+	const FString PluginDir = IPluginManager::Get().FindPlugin(TEXT("ProceduralShaderFramework"))->GetBaseDir();
+	return FPSFShaderSync(
+		FPaths::Combine(PluginDir, TEXT("Shaders")),
+		FPaths::ProjectDir() / TEXT("Shaders"),
+		FPaths::ProjectSavedDir() / TEXT("ProceduralShaderFramework") / TEXT("ShaderManifest.json"));
+}
+
+bool FPSFShaderSync::IsMissingFiles() const
+{
+	TArray<FString> ShaderFiles;
+	IFileManager::Get().FindFiles(ShaderFiles, *PluginShaderDir, TEXT("*.ush"));
+
+	for(const FString &FileName : ShaderFiles)
+	{
+		if(!FPaths::FileExists(ProjectShaderDir / FileName))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+FPSFShaderSyncResult FPSFShaderSync::Run() const
+{
+	const double StartTime = FPlatformTime::Seconds();
+	FPSFShaderSyncResult Result;
+
+	IFileManager &FileManager = IFileManager::Get();
+	FileManager.MakeDirectory(*ProjectShaderDir, true);
+
+	FString PreviousManifestJson;
+	const TMap<FString, FManifestEntry> Manifest = LoadManifest(ManifestPath, PreviousManifestJson);
+	TMap<FString, FManifestEntry> NewManifest;
+
+	TArray<FString> ShaderFiles;
+	FileManager.FindFiles(ShaderFiles, *PluginShaderDir, TEXT("*.ush"));
+
+	for(const FString &FileName : ShaderFiles)
+	{
+		const FString SourceFile = FPaths::Combine(PluginShaderDir, FileName);
+		const FString DestFile = FPaths::Combine(ProjectShaderDir, FileName);
+		const FManifestEntry *Entry = Manifest.Find(FileName);
+
+		TArray<uint8> SourceBytes;
+		if(!FFileHelper::LoadFileToArray(SourceBytes, *SourceFile))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Failed to read shader: %s"), *SourceFile);
+			++Result.Failed;
+			continue;
+		}
+		const FString SourceHash = HashBytes(SourceBytes);
+
+		TArray<uint8> DestBytes;
+		const bool bDestExists = FPaths::FileExists(DestFile) && FFileHelper::LoadFileToArray(DestBytes, *DestFile);
+		const FString DestHash = bDestExists ? HashBytes(DestBytes) : FString();
+
+		// the plugin version did not change since the last sync, edits to the project copy since then are
+		// the custom SDF code or the user's and stay
+		if(bDestExists && Entry && Entry->Source == SourceHash)
+		{
+			NewManifest.Add(FileName, *Entry);
+			++Result.UpToDate;
+			Result.BytesSkipped += DestBytes.Num();
+			continue;
+		}
+
+		TArray<uint8> NewBytes = SourceBytes;
+		bool bHasMarkers = false;
+		if(bDestExists)
+		{
+			FString SourceText;
+			FFileHelper::BufferToString(SourceText, SourceBytes.GetData(), SourceBytes.Num());
+			bHasMarkers = SourceText.Contains(MarkerPrefix, ESearchCase::CaseSensitive);
+			if(bHasMarkers)
+			{
+				FString DestText;
+				FFileHelper::BufferToString(DestText, DestBytes.GetData(), DestBytes.Num());
+
+				const FTCHARToUTF8 Merged(*MergeMarkerRegions(SourceText, DestText));
+				NewBytes = TArray<uint8>(reinterpret_cast<const uint8 *>(Merged.Get()), Merged.Length());
+			}
+		}
+		const FString NewHash = HashBytes(NewBytes);
+
+		// first sync with a manifest, or the plugin changed back and forth
+		if(bDestExists && NewHash == DestHash)
+		{
+			NewManifest.Add(FileName, FManifestEntry{SourceHash, DestHash});
+			++Result.UpToDate;
+			Result.BytesSkipped += DestBytes.Num();
+			continue;
+		}
+
+		// both sides changed and there are no markers to merge along, the project copy wins until it is deleted
+		if(bDestExists && Entry && !bHasMarkers && Entry->Project != DestHash)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s was edited in the project and its plugin version changed, keeping the project copy. Delete it to get the plugin version."), *DestFile);
+			NewManifest.Add(FileName, *Entry);
+			++Result.KeptLocalEdits;
+			continue;
+		}
+
+		if(!SaveArrayToFileAtomic(NewBytes, DestFile))
+		{
+			if(Entry)
+			{
+				NewManifest.Add(FileName, *Entry);
+			}
+			++Result.Failed;
+			continue;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Copied %s -> %s"), *SourceFile, *DestFile);
+		NewManifest.Add(FileName, FManifestEntry{SourceHash, NewHash});
+		++Result.Copied;
+		Result.BytesWritten += NewBytes.Num();
+	}
+
+	SaveManifest(ManifestPath, NewManifest, PreviousManifestJson);
+
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	if(Result.UpToDate > 0)
+	{
+		Result.FullCopySeconds = TimeFullCopy(ShaderFiles);
+	}
+	return Result;
+}
+
+double FPSFShaderSync::TimeFullCopy(const TArray<FString> &ShaderFiles) const
+{
+	// the project Shaders/ dir is not touched, that would invalidate what the sync kept
+	IFileManager &FileManager = IFileManager::Get();
+	const FString ScratchDir = FPaths::GetPath(ManifestPath) / TEXT("FullCopy");
+	FileManager.MakeDirectory(*ScratchDir, true);
+
+	const double StartTime = FPlatformTime::Seconds();
+	for(const FString &FileName : ShaderFiles)
+	{
+		FileManager.Copy(*(ScratchDir / FileName), *FPaths::Combine(PluginShaderDir, FileName));
+	}
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	FileManager.DeleteDirectory(*ScratchDir, false, true);
+	return Seconds;
+}
+
+void FPSFShaderSync::LogResult(const FPSFShaderSyncResult &Result)
+{
+	UE_LOG(LogTemp, Log, TEXT("Shader sync took %.1f ms: %d copied (%lld bytes), %d up to date, %d kept with local edits, %d failed."),
+		Result.Seconds * 1000.0, Result.Copied, Result.BytesWritten, Result.UpToDate, Result.KeptLocalEdits, Result.Failed);
+
+	if(Result.UpToDate > 0)
+	{
+		// hashing reads every file, on a fast disk the sync can take longer than the copy it replaces
+		const double SavedMs = (Result.FullCopySeconds - Result.Seconds) * 1000.0;
+		UE_LOG(LogTemp, Log, TEXT("Copying every shader like before took %.1f ms, the sync %s %.1f ms%s."),
+			Result.FullCopySeconds * 1000.0, SavedMs >= 0.0 ? TEXT("saved") : TEXT("took"), FMath::Abs(SavedMs), SavedMs >= 0.0 ? TEXT("") : TEXT(" longer"));
+		UE_LOG(LogTemp, Log, TEXT("Shader sync skipped %d unchanged files (%lld bytes), their timestamps and the shaders compiled from them stay valid."),
+			Result.UpToDate, Result.BytesSkipped);
+	}
+}
+
+FString FPSFShaderSync::MergeMarkerRegions(const FString &Source, const FString &Project)
+{
+	FPSFShaderPatcher SourcePatcher;
+	FPSFShaderPatcher ProjectPatcher;
+	if(!SourcePatcher.Parse(Source) || !ProjectPatcher.Parse(Project))
+	{
+		return Source;
+	}
+
+	for(const FString &Name : SourcePatcher.GetRegionNames())
+	{
+		if(ProjectPatcher.HasRegion(Name))
+		{
+			SourcePatcher.SetRegion(Name, ProjectPatcher.GetRegion(Name));
+		}
+	}
+	return SourcePatcher.GetContent();
+}
+
+bool FPSFShaderSync::SaveArrayToFileAtomic(const TArray<uint8> &Content, const FString &FilePath)
+{
+	const FString TempPath = FilePath + TEXT(".tmp");
+	if(!FFileHelper::SaveArrayToFile(Content, *TempPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write file: %s"), *TempPath);
+		return false;
+	}
+
+	if(!IFileManager::Get().Move(*FilePath, *TempPath, true, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to replace %s with %s"), *FilePath, *TempPath);
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPSFShaderSyncResult
+{
+	int32 Copied = 0;
+	int32 UpToDate = 0;
+
+	/** Files whose project copy had local edits outside of the marker regions and were left alone */
+	int32 KeptLocalEdits = 0;
+	int32 Failed = 0;
+
+	int64 BytesWritten = 0;
+
+	/** Size of the files that were not rewritten and kept their timestamps */
+	int64 BytesSkipped = 0;
+	double Seconds = 0.0;
+
+	/** Time a copy of every plugin shader took, the way the sync worked before the manifest. Only measured if files were skipped. */
+	double FullCopySeconds = 0.0;
+};
+
+/**
+ * Keeps the project Shaders/ dir in sync with the plugin's shaders without touching files that did not change.
+ *
+ * A manifest in Saved/ stores the MD5 of every plugin shader at the time it was synced and of the project copy
+ * that was written. A file is only rewritten when the plugin version changed, the content that was generated
+ * between // PSFCODE<NAME>START and // PSFCODE<NAME>END markers (the custom SDF code in sdf_functions.ush) is
+ * carried over into the new version. Files that only exist in the project (MyCustomSDFs.ush, CompiledScene.ush)
+ * are never touched.
+ */
+class FPSFShaderSync
+{
+public:
+	FPSFShaderSync(const FString &InPluginShaderDir, const FString &InProjectShaderDir, const FString &InManifestPath);
+
+	/** Default plugin -> project dirs, with the manifest in Saved/ProceduralShaderFramework */
+	static FPSFShaderSync CreateForProject();
+
+	/** True if a plugin shader has no project copy yet, materials can not compile until the sync is done */
+	bool IsMissingFiles() const;
+
+	/** Safe to call from any thread, only does file IO */
+	FPSFShaderSyncResult Run() const;
+
+	static void LogResult(const FPSFShaderSyncResult &Result);
+
+	/** Source with the text between every marker pair replaced by the text between the same markers in Project */
+	static FString MergeMarkerRegions(const FString &Source, const FString &Project);
+
+	/** Copies the plugin shaders into a scratch dir next to the manifest and deletes it again, returns the time of the copy */
+	double TimeFullCopy(const TArray<FString> &ShaderFiles) const;
+
+	/** Writes next to FilePath and moves the file over it, so the shader compiler never reads a half written file */
+	static bool SaveArrayToFileAtomic(const TArray<uint8> &Content, const FString &FilePath);
+
+private:
+	FString PluginShaderDir;
+	FString ProjectShaderDir;
+	FString ManifestPath;
+};
@@ -0,0 +1,3152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFShaderTranslator.h"
+#include "PSFShaderGraph.h"
+
+namespace
+{
+	enum class ETokenType : uint8
+	{
+		Identifier,
+		Number,
+		Punctuation,
+		Directive,
+		End
+	};
+
+	struct FToken
+	{
+		ETokenType Type = ETokenType::End;
+		FString Text;
+
+		/** Whitespace and comments in front of the token */
+		FString Leading;
+	};
+
+	/** Operators of more than one character, longest first */
+	const TCHAR *const Punctuators[] = {
+		TEXT("<<="), TEXT(">>="), TEXT("=="), TEXT("!="), TEXT("<="), TEXT(">="), TEXT("&&"), TEXT("||"), TEXT("++"), TEXT("--"), TEXT("+="),
+		TEXT("-="), TEXT("*="), TEXT("/="), TEXT("%="), TEXT("&="), TEXT("|="), TEXT("^="), TEXT("<<"), TEXT(">>"), TEXT("::")};
+
+	/** Keywords and builtins of GLSL that are free identifiers in HLSL */
+	const TCHAR *const GlslReserved[] = {
+		TEXT("attribute"), TEXT("varying"), TEXT("uniform"), TEXT("buffer"), TEXT("shared"), TEXT("coherent"), TEXT("restrict"), TEXT("readonly"),
+		TEXT("writeonly"), TEXT("layout"), TEXT("centroid"), TEXT("flat"), TEXT("smooth"), TEXT("patch"), TEXT("sample"), TEXT("subroutine"),
+		TEXT("invariant"), TEXT("precise"), TEXT("highp"), TEXT("mediump"), TEXT("lowp"), TEXT("precision"), TEXT("input"), TEXT("output"),
+		TEXT("active"), TEXT("filter"), TEXT("common"), TEXT("partition"), TEXT("superp"), TEXT("external"), TEXT("interface"), TEXT("fixed"),
+		TEXT("union"), TEXT("enum"), TEXT("typedef"), TEXT("template"), TEXT("this"), TEXT("goto"), TEXT("sizeof"), TEXT("cast"), TEXT("namespace"),
+		TEXT("using"), TEXT("noinline"), TEXT("public"), TEXT("long"), TEXT("short"), TEXT("double"), TEXT("half"), TEXT("unsigned"),
+		TEXT("hvec2"), TEXT("hvec3"), TEXT("hvec4"), TEXT("dvec2"), TEXT("dvec3"), TEXT("dvec4"), TEXT("fvec2"), TEXT("fvec3"), TEXT("fvec4"),
+		TEXT("vec2"), TEXT("vec3"), TEXT("vec4"), TEXT("ivec2"), TEXT("ivec3"), TEXT("ivec4"), TEXT("uvec2"), TEXT("uvec3"), TEXT("uvec4"),
+		TEXT("bvec2"), TEXT("bvec3"), TEXT("bvec4"), TEXT("mat2"), TEXT("mat3"), TEXT("mat4"), TEXT("mat2x2"), TEXT("mat2x3"), TEXT("mat2x4"),
+		TEXT("mat3x2"), TEXT("mat3x3"), TEXT("mat3x4"), TEXT("mat4x2"), TEXT("mat4x3"), TEXT("mat4x4"), TEXT("sampler2D"), TEXT("sampler3D"),
+		TEXT("samplerCube"), TEXT("texture"), TEXT("textureLod"), TEXT("texelFetch"), TEXT("mix"), TEXT("fract"), TEXT("mod"), TEXT("atan"),
+		TEXT("inversesqrt"), TEXT("dFdx"), TEXT("dFdy"), TEXT("lessThan"), TEXT("greaterThan"), TEXT("lessThanEqual"), TEXT("greaterThanEqual"),
+		TEXT("equal"), TEXT("notEqual"), TEXT("not"), TEXT("matrixCompMult"), TEXT("outerProduct"), TEXT("inverse"), TEXT("main"),
+		TEXT("instance"), TEXT("render_mode"), TEXT("shader_type"), TEXT("group_uniforms"), TEXT("global"), TEXT("hint_range")};
+
+	/** psf_ helpers of the prelude */
+	const TCHAR *const FmodNames[] = {TEXT("psf_fmod"), TEXT("psf_fmod2"), TEXT("psf_fmod3"), TEXT("psf_fmod4")};
+
+	bool IsIdentifierStart(TCHAR Character)
+	{
+		return FChar::IsAlpha(Character) || Character == TEXT('_');
+	}
+
+	bool IsIdentifierCharacter(TCHAR Character)
+	{
+		return FChar::IsAlnum(Character) || Character == TEXT('_');
+	}
+
+	bool IsReservedInGlsl(const FString &Name)
+	{
+		if(Name.StartsWith(TEXT("gl_"), ESearchCase::CaseSensitive) || Name.Contains(TEXT("__"), ESearchCase::CaseSensitive))
+		{
+			return true;
+		}
+		for(const TCHAR *Reserved : GlslReserved)
+		{
+			if(Name.Equals(Reserved, ESearchCase::CaseSensitive))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	FString ToGlslIdentifier(const FString &Name)
+	{
+		return IsReservedInGlsl(Name) ? Name + TEXT("_") : Name;
+	}
+
+	TArray<FToken> Tokenize(const FString &Text)
+	{
+		TArray<FToken> Tokens;
+		const int32 Length = Text.Len();
+		int32 Pos = 0;
+		bool bLineStart = true;
+		while(true)
+		{
+			FToken Token;
+			const int32 TriviaStart = Pos;
+			while(Pos < Length)
+			{
+				const TCHAR Character = Text[Pos];
+				if(Character == TEXT('\n'))
+				{
+					bLineStart = true;
+					++Pos;
+				}
+				else if(FChar::IsWhitespace(Character))
+				{
+					++Pos;
+				}
+				else if(Character == TEXT('/') && Pos + 1 < Length && Text[Pos + 1] == TEXT('/'))
+				{
+					while(Pos < Length && Text[Pos] != TEXT('\n'))
+					{
+						++Pos;
+					}
+				}
+				else if(Character == TEXT('/') && Pos + 1 < Length && Text[Pos + 1] == TEXT('*'))
+				{
+					const int32 CommentEnd = Text.Find(TEXT("*/"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Pos + 2);
+					Pos = CommentEnd == INDEX_NONE ? Length : CommentEnd + 2;
+				}
+				else
+				{
+					break;
+				}
+			}
+			Token.Leading = Text.Mid(TriviaStart, Pos - TriviaStart);
+			if(Pos >= Length)
+			{
+				Tokens.Add(MoveTemp(Token));
+				break;
+			}
+
+			const int32 Start = Pos;
+			const TCHAR Character = Text[Pos];
+			if(Character == TEXT('#') && bLineStart)
+			{
+				// the whole directive, lines ending with \ continue it
+				Token.Type = ETokenType::Directive;
+				while(Pos < Length && Text[Pos] != TEXT('\n'))
+				{
+					Pos += Text[Pos] == TEXT('\\') && Pos + 1 < Length && Text[Pos + 1] == TEXT('\n') ? 2 : 1;
+				}
+				while(Pos > Start && (Text[Pos - 1] == TEXT('\r') || Text[Pos - 1] == TEXT(' ') || Text[Pos - 1] == TEXT('\t')))
+				{
+					--Pos;
+				}
+			}
+			else if(IsIdentifierStart(Character))
+			{
+				Token.Type = ETokenType::Identifier;
+				while(Pos < Length && IsIdentifierCharacter(Text[Pos]))
+				{
+					++Pos;
+				}
+			}
+			else if(FChar::IsDigit(Character) || (Character == TEXT('.') && Pos + 1 < Length && FChar::IsDigit(Text[Pos + 1])))
+			{
+				// 1, 1.5, .5, 1., 1e-3, 0x1F, with suffixes like 1.0f and 2u
+				Token.Type = ETokenType::Number;
+				const bool bHex = Character == TEXT('0') && Pos + 1 < Length && (Text[Pos + 1] == TEXT('x') || Text[Pos + 1] == TEXT('X'));
+				while(Pos < Length && !bHex)
+				{
+					const TCHAR Digit = Text[Pos];
+					if(FChar::IsDigit(Digit) || Digit == TEXT('.'))
+					{
+						++Pos;
+					}
+					else if(Digit == TEXT('e') || Digit == TEXT('E'))
+					{
+						++Pos;
+						if(Pos < Length && (Text[Pos] == TEXT('+') || Text[Pos] == TEXT('-')))
+						{
+							++Pos;
+						}
+					}
+					else
+					{
+						break;
+					}
+				}
+				while(Pos < Length && IsIdentifierCharacter(Text[Pos]))
+				{
+					++Pos;
+				}
+			}
+			else
+			{
+				Token.Type = ETokenType::Punctuation;
+				int32 Matched = 1;
+				for(const TCHAR *Punctuator : Punctuators)
+				{
+					const int32 PunctuatorLength = FCString::Strlen(Punctuator);
+					if(Text.Mid(Pos, PunctuatorLength).Equals(Punctuator, ESearchCase::CaseSensitive))
+					{
+						Matched = PunctuatorLength;
+						break;
+					}
+				}
+				Pos += Matched;
+			}
+			Token.Text = Text.Mid(Start, Pos - Start);
+			bLineStart = false;
+			Tokens.Add(MoveTemp(Token));
+		}
+		return Tokens;
+	}
+
+	bool IsHexLiteral(const FString &Text)
+	{
+		return Text.StartsWith(TEXT("0x")) || Text.StartsWith(TEXT("0X"));
+	}
+
+	bool IsFloatLiteral(const FString &Text)
+	{
+		if(IsHexLiteral(Text))
+		{
+			return false;
+		}
+		for(const TCHAR Character : Text)
+		{
+			if(Character == TEXT('.') || Character == TEXT('e') || Character == TEXT('E') || Character == TEXT('f') || Character == TEXT('F') || Character == TEXT('h') || Character == TEXT('H'))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** 1.0f -> 1.0, .5 -> 0.5, 1. -> 1.0, GLSL only knows the u suffix */
+	FString ToGlslNumber(const FString &Text)
+	{
+		if(IsHexLiteral(Text))
+		{
+			return Text;
+		}
+
+		FString Number = Text;
+		bool bUnsigned = false;
+		while(Number.Len() > 0 && FChar::IsAlpha(Number[Number.Len() - 1]))
+		{
+			bUnsigned |= FChar::ToLower(Number[Number.Len() - 1]) == TEXT('u');
+			Number.LeftChopInline(1);
+		}
+		if(Number.StartsWith(TEXT(".")))
+		{
+			Number = TEXT("0") + Number;
+		}
+		const int32 Dot = Number.Find(TEXT("."), ESearchCase::CaseSensitive);
+		if(Dot != INDEX_NONE && (Dot + 1 == Number.Len() || !FChar::IsDigit(Number[Dot + 1])))
+		{
+			Number = Number.Left(Dot + 1) + TEXT("0") + Number.Mid(Dot + 1);
+		}
+		return bUnsigned ? Number + TEXT("u") : Number;
+	}
+
+	enum class EExprKind : uint8
+	{
+		Literal,
+		Identifier,
+		Unary,
+		Postfix,
+		Binary,
+		Assign,
+		Ternary,
+		Call,
+		Method,
+		Member,
+		Index,
+		Cast,
+		Paren,
+		InitList
+	};
+
+	/** How an expression is printed when copying its tokens is not enough */
+	enum class ERewrite : uint8
+	{
+		None,
+
+		/** saturate(x) -> clamp(x, 0.0, 1.0) */
+		Saturate,
+
+		/** mul(a, b) -> (b * a) */
+		Mul,
+		Mad,
+		Rcp,
+		Log10,
+
+		/** any / all / asfloat of something that already is the result, the argument alone */
+		Unwrap,
+
+		/** (Struct) 0 */
+		ZeroStruct,
+
+		/** (type) x -> type(x) */
+		Cast,
+
+		/** Texture methods */
+		TexelFetch,
+		TextureLod,
+		Texture,
+		TextureGrad,
+
+		/** GetDimensions(w, h) -> (w = textureSize(t, 0).x, h = ...) */
+		Dimensions,
+
+		/** Binary operator as a function: lessThan(a, b), psf_fmod(a, b), matrixCompMult(a, b) */
+		BinaryCall,
+
+		/** x.xxx on a scalar -> vec3(x) */
+		ScalarSwizzle,
+
+		/** Call of a library function with sampler arguments dropped or default arguments appended */
+		Arguments
+	};
+
+	struct FExpr
+	{
+		EExprKind Kind = EExprKind::Literal;
+
+		/** Token range of the expression */
+		int32 First = 0;
+		int32 Last = 0;
+
+		/** Operator, name or member token */
+		int32 Token = INDEX_NONE;
+		TArray<int32> Children;
+
+		FPSFShaderType Type;
+		bool bConstant = false;
+
+		ERewrite Rewrite = ERewrite::None;
+
+		/** Function of a BinaryCall or Arguments rewrite, element type of an initializer list */
+		FString Name;
+
+		/** Array size expression of an initializer list */
+		int32 Size = INDEX_NONE;
+
+		/** Arguments of an Arguments rewrite that are not printed, sampler states */
+		TArray<int32> Dropped;
+		TArray<FString> Extra;
+
+		/** Godot: an Arguments rewrite that passes PSFState in front of the arguments */
+		bool bPassState = false;
+
+		/** Conversion to ConvertTo written around the expression */
+		bool bConvert = false;
+		FPSFShaderType ConvertTo;
+	};
+
+	enum class EIntrinsic : uint8
+	{
+		/** Component-wise on floats */
+		Float,
+
+		/** Component-wise, ints stay ints */
+		Numeric,
+
+		/** dot, length, distance */
+		Reduce,
+		Cross,
+		Determinant,
+		Transpose,
+
+		/** any, all */
+		Test,
+
+		/** isnan, isinf */
+		Classify,
+
+		/** asfloat, asint, countbits ... */
+		Bits,
+		Mul
+	};
+
+	struct FIntrinsic
+	{
+		const TCHAR *Hlsl;
+		const TCHAR *Glsl;
+		EIntrinsic Kind;
+		int32 Arguments;
+
+		/** Bit per argument that GLSL takes as a scalar next to vectors, like the edge of step */
+		uint32 ScalarArguments;
+		ERewrite Rewrite;
+	};
+
+	const FIntrinsic Intrinsics[] = {
+		{TEXT("abs"), TEXT("abs"), EIntrinsic::Numeric, 1, 0, ERewrite::None},
+		{TEXT("sign"), TEXT("sign"), EIntrinsic::Numeric, 1, 0, ERewrite::None},
+		{TEXT("min"), TEXT("min"), EIntrinsic::Numeric, 2, 0b10, ERewrite::None},
+		{TEXT("max"), TEXT("max"), EIntrinsic::Numeric, 2, 0b10, ERewrite::None},
+		{TEXT("clamp"), TEXT("clamp"), EIntrinsic::Numeric, 3, 0b110, ERewrite::None},
+		{TEXT("mad"), TEXT("mad"), EIntrinsic::Numeric, 3, 0, ERewrite::Mad},
+		{TEXT("sin"), TEXT("sin"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("cos"), TEXT("cos"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("tan"), TEXT("tan"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("asin"), TEXT("asin"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("acos"), TEXT("acos"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("atan"), TEXT("atan"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("sinh"), TEXT("sinh"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("cosh"), TEXT("cosh"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("tanh"), TEXT("tanh"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("exp"), TEXT("exp"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("exp2"), TEXT("exp2"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("log"), TEXT("log"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("log2"), TEXT("log2"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("sqrt"), TEXT("sqrt"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("floor"), TEXT("floor"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("ceil"), TEXT("ceil"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("round"), TEXT("round"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("trunc"), TEXT("trunc"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("radians"), TEXT("radians"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("degrees"), TEXT("degrees"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("normalize"), TEXT("normalize"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("fwidth"), TEXT("fwidth"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("rsqrt"), TEXT("inversesqrt"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("frac"), TEXT("fract"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("ddx"), TEXT("dFdx"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("ddy"), TEXT("dFdy"), EIntrinsic::Float, 1, 0, ERewrite::None},
+		{TEXT("atan2"), TEXT("atan"), EIntrinsic::Float, 2, 0, ERewrite::None},
+		{TEXT("pow"), TEXT("pow"), EIntrinsic::Float, 2, 0, ERewrite::None},
+		{TEXT("fmod"), TEXT("psf_fmod"), EIntrinsic::Float, 2, 0, ERewrite::None},
+		{TEXT("lerp"), TEXT("mix"), EIntrinsic::Float, 3, 0b100, ERewrite::None},
+		{TEXT("step"), TEXT("step"), EIntrinsic::Float, 2, 0b01, ERewrite::None},
+		{TEXT("smoothstep"), TEXT("smoothstep"), EIntrinsic::Float, 3, 0b011, ERewrite::None},
+		{TEXT("reflect"), TEXT("reflect"), EIntrinsic::Float, 2, 0, ERewrite::None},
+		{TEXT("refract"), TEXT("refract"), EIntrinsic::Float, 3, 0b100, ERewrite::None},
+		{TEXT("faceforward"), TEXT("faceforward"), EIntrinsic::Float, 3, 0, ERewrite::None},
+		{TEXT("saturate"), TEXT("clamp"), EIntrinsic::Float, 1, 0, ERewrite::Saturate},
+		{TEXT("rcp"), TEXT("rcp"), EIntrinsic::Float, 1, 0, ERewrite::Rcp},
+		{TEXT("log10"), TEXT("log10"), EIntrinsic::Float, 1, 0, ERewrite::Log10},
+		{TEXT("dot"), TEXT("dot"), EIntrinsic::Reduce, 2, 0, ERewrite::None},
+		{TEXT("length"), TEXT("length"), EIntrinsic::Reduce, 1, 0, ERewrite::None},
+		{TEXT("distance"), TEXT("distance"), EIntrinsic::Reduce, 2, 0, ERewrite::None},
+		{TEXT("cross"), TEXT("cross"), EIntrinsic::Cross, 2, 0, ERewrite::None},
+		{TEXT("determinant"), TEXT("determinant"), EIntrinsic::Determinant, 1, 0, ERewrite::None},
+		{TEXT("transpose"), TEXT("transpose"), EIntrinsic::Transpose, 1, 0, ERewrite::None},
+		{TEXT("any"), TEXT("any"), EIntrinsic::Test, 1, 0, ERewrite::None},
+		{TEXT("all"), TEXT("all"), EIntrinsic::Test, 1, 0, ERewrite::None},
+		{TEXT("isnan"), TEXT("isnan"), EIntrinsic::Classify, 1, 0, ERewrite::None},
+		{TEXT("isinf"), TEXT("isinf"), EIntrinsic::Classify, 1, 0, ERewrite::None},
+		{TEXT("asfloat"), TEXT("uintBitsToFloat"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("asint"), TEXT("floatBitsToInt"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("asuint"), TEXT("floatBitsToUint"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("countbits"), TEXT("bitCount"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("firstbithigh"), TEXT("findMSB"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("firstbitlow"), TEXT("findLSB"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("reversebits"), TEXT("bitfieldReverse"), EIntrinsic::Bits, 1, 0, ERewrite::None},
+		{TEXT("mul"), TEXT("mul"), EIntrinsic::Mul, 2, 0, ERewrite::Mul}};
+
+	const FIntrinsic *FindIntrinsic(const FString &Name)
+	{
+		for(const FIntrinsic &Intrinsic : Intrinsics)
+		{
+			if(Name.Equals(Intrinsic.Hlsl, ESearchCase::CaseSensitive))
+			{
+				return &Intrinsic;
+			}
+		}
+		return nullptr;
+	}
+
+	/** Base type of arithmetic on A and B, HLSL promotes int to uint to float */
+	EPSFShaderBaseType CommonBase(const FPSFShaderType &A, const FPSFShaderType &B)
+	{
+		if(A.Base == EPSFShaderBaseType::Float || B.Base == EPSFShaderBaseType::Float)
+		{
+			return EPSFShaderBaseType::Float;
+		}
+		if(A.Base == EPSFShaderBaseType::UInt || B.Base == EPSFShaderBaseType::UInt)
+		{
+			return EPSFShaderBaseType::UInt;
+		}
+		if(A.Base == EPSFShaderBaseType::Bool && B.Base == EPSFShaderBaseType::Bool)
+		{
+			return EPSFShaderBaseType::Bool;
+		}
+		return EPSFShaderBaseType::Int;
+	}
+
+	/** Components of the result of component-wise math, the smallest vector since HLSL truncates the others */
+	int32 CommonSize(const TArray<FPSFShaderType> &Types)
+	{
+		int32 Size = 0;
+		for(const FPSFShaderType &Type : Types)
+		{
+			if(Type.IsVector())
+			{
+				Size = Size == 0 ? Type.Rows : FMath::Min(Size, Type.Rows);
+			}
+		}
+		return FMath::Max(Size, 1);
+	}
+
+	bool IsSwizzle(const FString &Member)
+	{
+		if(Member.Len() < 1 || Member.Len() > 4)
+		{
+			return false;
+		}
+		const FString Sets[] = {TEXT("xyzw"), TEXT("rgba")};
+		for(const FString &Set : Sets)
+		{
+			bool bMatches = true;
+			for(const TCHAR Character : Member)
+			{
+				int32 Index;
+				bMatches &= Set.FindChar(Character, Index);
+			}
+			if(bMatches)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool IsWhitespaceOnly(const FString &Text)
+	{
+		for(const TCHAR Character : Text)
+		{
+			if(!FChar::IsWhitespace(Character))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+FPSFShaderType FPSFShaderType::Make(EPSFShaderBaseType Base, int32 Rows, int32 Columns)
+{
+	FPSFShaderType Type;
+	Type.Base = Base;
+	Type.Rows = Rows;
+	Type.Columns = Columns;
+	return Type;
+}
+
+FPSFShaderType FPSFShaderType::FromHlsl(const FString &Name)
+{
+	struct FNamedType
+	{
+		const TCHAR *Name;
+		EPSFShaderBaseType Base;
+	};
+	const FNamedType Objects[] = {
+		{TEXT("void"), EPSFShaderBaseType::Void},
+		{TEXT("Texture2D"), EPSFShaderBaseType::Texture2D},
+		{TEXT("Texture3D"), EPSFShaderBaseType::Texture3D},
+		{TEXT("TextureCube"), EPSFShaderBaseType::TextureCube},
+		{TEXT("SamplerState"), EPSFShaderBaseType::Sampler},
+		{TEXT("SamplerComparisonState"), EPSFShaderBaseType::Sampler}};
+	for(const FNamedType &Object : Objects)
+	{
+		if(Name.Equals(Object.Name, ESearchCase::CaseSensitive))
+		{
+			return Make(Object.Base);
+		}
+	}
+
+	// the prefix and then nothing, a vector size or RxC
+	const FNamedType Scalars[] = {
+		{TEXT("min16float"), EPSFShaderBaseType::Float},
+		{TEXT("min10float"), EPSFShaderBaseType::Float},
+		{TEXT("min16uint"), EPSFShaderBaseType::UInt},
+		{TEXT("min16int"), EPSFShaderBaseType::Int},
+		{TEXT("float"), EPSFShaderBaseType::Float},
+		{TEXT("half"), EPSFShaderBaseType::Float},
+		{TEXT("double"), EPSFShaderBaseType::Float},
+		{TEXT("uint"), EPSFShaderBaseType::UInt},
+		{TEXT("dword"), EPSFShaderBaseType::UInt},
+		{TEXT("int"), EPSFShaderBaseType::Int},
+		{TEXT("bool"), EPSFShaderBaseType::Bool}};
+	for(const FNamedType &Scalar : Scalars)
+	{
+		if(!Name.StartsWith(Scalar.Name, ESearchCase::CaseSensitive))
+		{
+			continue;
+		}
+
+		const FString Rest = Name.Mid(FCString::Strlen(Scalar.Name));
+		const auto IsDimension = [](TCHAR Character)
+		{
+			return Character >= TEXT('1') && Character <= TEXT('4');
+		};
+		if(Rest.IsEmpty())
+		{
+			return Make(Scalar.Base);
+		}
+		if(Rest.Len() == 1 && IsDimension(Rest[0]))
+		{
+			return Make(Scalar.Base, Rest[0] - TEXT('0'));
+		}
+		if(Rest.Len() == 3 && IsDimension(Rest[0]) && Rest[1] == TEXT('x') && IsDimension(Rest[2]))
+		{
+			return Make(Scalar.Base, Rest[0] - TEXT('0'), Rest[2] - TEXT('0'));
+		}
+		break;
+	}
+	return FPSFShaderType();
+}
+
+FString FPSFShaderType::ToGlsl() const
+{
+	switch(Base)
+	{
+	case EPSFShaderBaseType::Void:
+		return TEXT("void");
+	case EPSFShaderBaseType::Struct:
+		return StructName;
+	case EPSFShaderBaseType::Texture2D:
+		return TEXT("sampler2D");
+	case EPSFShaderBaseType::Texture3D:
+		return TEXT("sampler3D");
+	case EPSFShaderBaseType::TextureCube:
+		return TEXT("samplerCube");
+	case EPSFShaderBaseType::Unknown:
+	case EPSFShaderBaseType::Sampler:
+		return FString();
+	default:
+		break;
+	}
+
+	if(Columns > 0)
+	{
+		return Rows == Columns ? FString::Printf(TEXT("mat%d"), Rows) : FString::Printf(TEXT("mat%dx%d"), Rows, Columns);
+	}
+
+	const TCHAR *Scalar = Base == EPSFShaderBaseType::Bool ? TEXT("bool") : Base == EPSFShaderBaseType::Int ? TEXT("int") : Base == EPSFShaderBaseType::UInt ? TEXT("uint") : TEXT("float");
+	const TCHAR *Vector = Base == EPSFShaderBaseType::Bool ? TEXT("bvec") : Base == EPSFShaderBaseType::Int ? TEXT("ivec") : Base == EPSFShaderBaseType::UInt ? TEXT("uvec") : TEXT("vec");
+	return Rows > 1 ? FString::Printf(TEXT("%s%d"), Vector, Rows) : FString(Scalar);
+}
+
+int32 FPSFShaderTranslator::FFunction::GetRequiredParameters() const
+{
+	int32 Required = 0;
+	for(int32 Index = 0; Index < Parameters.Num(); ++Index)
+	{
+		if(Parameters[Index].Default.IsEmpty())
+		{
+			Required = Index + 1;
+		}
+	}
+	return Required;
+}
+
+/** Parses and types one chunk, then prints it with the rewrites applied */
+class FPSFChunkTranslator
+{
+public:
+	FPSFChunkTranslator(FPSFShaderTranslator &InOwner, const FString &Text, int32 InDepth = 0)
+		: Owner(InOwner)
+		, Tokens(Tokenize(Text))
+		, Depth(InDepth)
+	{
+	}
+
+	bool TranslateFunction(FString &OutCode);
+	bool TranslateDeclaration(FString &OutCode);
+	bool TranslateDirective(FString &OutCode);
+
+	/** The value of an object-like macro as an expression */
+	bool TranslateMacroValue(FString &OutCode, FPSFShaderType &OutType, bool &bOutConstant);
+
+	/** Evaluates the macro value as an integer, for array sizes */
+	bool EvaluateMacroValue(int32 &OutValue);
+
+	FString Error;
+
+private:
+	using FSymbol = FPSFShaderTranslator::FSymbol;
+	using FFunction = FPSFShaderTranslator::FFunction;
+	using FParameter = FPSFShaderTranslator::FParameter;
+	using FStructMember = FPSFShaderTranslator::FStructMember;
+
+	bool Fail(const FString &Message)
+	{
+		if(Error.IsEmpty())
+		{
+			Error = Message;
+		}
+		return false;
+	}
+
+	const FToken &Peek(int32 Offset = 0) const
+	{
+		return Tokens[FMath::Min(Cursor + Offset, Tokens.Num() - 1)];
+	}
+
+	bool IsAt(const TCHAR *Text, int32 Offset = 0) const
+	{
+		const FToken &Token = Peek(Offset);
+		return (Token.Type == ETokenType::Identifier || Token.Type == ETokenType::Punctuation) && Token.Text.Equals(Text, ESearchCase::CaseSensitive);
+	}
+
+	bool Accept(const TCHAR *Text)
+	{
+		if(IsAt(Text))
+		{
+			++Cursor;
+			return true;
+		}
+		return false;
+	}
+
+	bool Expect(const TCHAR *Text)
+	{
+		return Accept(Text) || Fail(FString::Printf(TEXT("expected '%s' before '%s'"), Text, *Peek().Text));
+	}
+
+	/** Type named by the identifier at TokenIndex, Unknown if it is no type */
+	FPSFShaderType TypeAt(int32 TokenIndex) const;
+
+	bool IsTypeAt(int32 TokenIndex) const
+	{
+		return Tokens[TokenIndex].Type == ETokenType::Identifier && TypeAt(TokenIndex).IsKnown();
+	}
+
+	bool IsDeclarationStart() const;
+	const FSymbol *FindSymbol(const FString &Name) const;
+
+	int32 AddExpr(EExprKind Kind, int32 First, int32 Last, int32 Token = INDEX_NONE)
+	{
+		FExpr Expr;
+		Expr.Kind = Kind;
+		Expr.First = First;
+		Expr.Last = Last;
+		Expr.Token = Token;
+		return Exprs.Add(MoveTemp(Expr));
+	}
+
+	void Convert(int32 Index, const FPSFShaderType &Target);
+
+	/** Target with the shape of Index and the base type of Base */
+	void ConvertBase(int32 Index, EPSFShaderBaseType Base);
+
+	int32 ParseExpression(bool bAllowComma = true);
+	int32 ParseAssignment();
+	int32 ParseTernary();
+	int32 ParseBinary(int32 MinPrecedence);
+	int32 ParseUnary();
+	int32 ParsePrimary();
+	int32 ParsePostfix(int32 Index);
+	bool ParseArguments(TArray<int32> &OutArguments);
+
+	int32 MakeBinary(int32 Left, int32 OpToken, int32 Right);
+	bool ResolveCall(int32 Index);
+	bool ResolveFunctionCall(int32 Index, const TArray<FFunction> &Overloads);
+	bool ResolveIntrinsic(int32 Index, const FIntrinsic &Intrinsic);
+	bool ResolveMethod(int32 Index);
+	bool ResolveMember(int32 Index);
+	bool ResolveInitList(int32 Index, const FPSFShaderType &Target, int32 SizeExpr);
+
+	bool EvaluateInteger(int32 Index, int32 &OutValue);
+
+	/** Statement level expression, printed by PrintRange */
+	int32 ParseRoot(const FPSFShaderType *Target = nullptr);
+	bool ParseCondition();
+	bool ParseStatement();
+	bool ParseBlock();
+	bool ParseDeclaration(bool bGlobal);
+
+	/** Godot: adds a mutable global to PSFState and psfState() */
+	bool DeclareStateMember(FSymbol &InOutSymbol, int32 TypeToken, int32 SizeExpr, int32 Init);
+
+	bool ParseArraySize(FPSFShaderType &InOutType, int32 &OutSizeExpr);
+	bool TranslateStruct(FString &OutCode);
+
+	FString ZeroValue(const FPSFShaderType &Type);
+	FString PrintToken(int32 TokenIndex, bool bLeading) const;
+	FString PrintExpr(int32 Index, bool bLeading);
+	FString PrintBody(int32 Index);
+	FString PrintRange(int32 First, int32 Last);
+
+	FPSFShaderTranslator &Owner;
+	TArray<FToken> Tokens;
+	int32 Cursor = 0;
+
+	/** Nesting of macro evaluation */
+	int32 Depth = 0;
+
+	TArray<FExpr> Exprs;
+
+	/** Statement level expressions by their first token */
+	TMap<int32, int32> Roots;
+	TMap<int32, FString> Replacements;
+	TSet<int32> Removed;
+
+	TArray<TPSFIdentifierMap<FSymbol>> Scopes;
+	FPSFShaderType ReturnType;
+
+	/** Godot: the chunk reads or writes PSFState, or calls a function that takes it */
+	bool bUsesState = false;
+
+	/** Godot: the globals the declaration adds to PSFState */
+	TArray<FString> StateNames;
+};
+
+FPSFShaderType FPSFChunkTranslator::TypeAt(int32 TokenIndex) const
+{
+	const FString &Name = Tokens[TokenIndex].Text;
+	FPSFShaderType Type = FPSFShaderType::FromHlsl(Name);
+	if(!Type.IsKnown() && Owner.Structs.Contains(Name))
+	{
+		Type.Base = EPSFShaderBaseType::Struct;
+		Type.StructName = Name;
+	}
+	return Type;
+}
+
+bool FPSFChunkTranslator::IsDeclarationStart() const
+{
+	const TCHAR *const Qualifiers[] = {TEXT("static"), TEXT("const"), TEXT("uniform"), TEXT("extern"), TEXT("precise"), TEXT("groupshared")};
+	for(const TCHAR *Qualifier : Qualifiers)
+	{
+		if(IsAt(Qualifier))
+		{
+			return true;
+		}
+	}
+	return IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)) && Peek(1).Type == ETokenType::Identifier;
+}
+
+const FPSFShaderTranslator::FSymbol *FPSFChunkTranslator::FindSymbol(const FString &Name) const
+{
+	for(int32 Scope = Scopes.Num() - 1; Scope >= 0; --Scope)
+	{
+		if(const FSymbol *Symbol = Scopes[Scope].Find(Name))
+		{
+			return Symbol;
+		}
+	}
+	if(const FSymbol *Symbol = Owner.Globals.Find(Name))
+	{
+		return Symbol;
+	}
+	return Owner.Macros.Find(Name);
+}
+
+void FPSFChunkTranslator::Convert(int32 Index, const FPSFShaderType &Target)
+{
+	FExpr &Expr = Exprs[Index];
+	const FPSFShaderType &From = Expr.Type;
+	if(!Target.IsKnown() || !From.IsKnown() || From == Target)
+	{
+		return;
+	}
+
+	// structs, arrays, textures and matrices are never converted implicitly
+	const bool bFromValue = From.IsScalar() || From.IsVector();
+	const bool bToValue = Target.IsScalar() || Target.IsVector();
+	if(!bFromValue || !bToValue || From.IsMatrix() || Target.IsMatrix())
+	{
+		return;
+	}
+
+	// down into signs and parentheses, so that -1 becomes -1.0 instead of float(-1)
+	const bool bSign = Expr.Kind == EExprKind::Unary && (Tokens[Expr.Token].Text == TEXT("-") || Tokens[Expr.Token].Text == TEXT("+"));
+	if((bSign || Expr.Kind == EExprKind::Paren) && From.Rows == Target.Rows && From.Base != EPSFShaderBaseType::Bool && Target.Base != EPSFShaderBaseType::Bool)
+	{
+		const int32 Child = Expr.Children[0];
+		Expr.Type = Target;
+		Convert(Child, Target);
+		return;
+	}
+	if(Expr.Kind == EExprKind::Ternary)
+	{
+		const int32 A = Expr.Children[1];
+		const int32 B = Expr.Children[2];
+		Expr.Type = Target;
+		Convert(A, Target);
+		Convert(B, Target);
+		return;
+	}
+
+	// int literals are written as float literals
+	if(Expr.Kind == EExprKind::Literal && Target.Base == EPSFShaderBaseType::Float && Target.IsScalar() && From.IsNumeric() && !IsHexLiteral(Tokens[Expr.Token].Text))
+	{
+		FString Number = ToGlslNumber(Tokens[Expr.Token].Text);
+		Number.RemoveFromEnd(TEXT("u"));
+		Replacements.Add(Expr.Token, Number.Contains(TEXT(".")) || Number.Contains(TEXT("e")) ? Number : Number + TEXT(".0"));
+		Expr.Type = Target;
+		return;
+	}
+
+	Expr.bConvert = true;
+	Expr.ConvertTo = Target;
+	++Owner.Stats.Conversions;
+}
+
+void FPSFChunkTranslator::ConvertBase(int32 Index, EPSFShaderBaseType Base)
+{
+	const FPSFShaderType &From = Exprs[Index].Type;
+	if(From.IsScalar() || From.IsVector())
+	{
+		Convert(Index, FPSFShaderType::Make(Base, From.Rows));
+	}
+}
+
+int32 FPSFChunkTranslator::ParseExpression(bool bAllowComma)
+{
+	int32 Left = ParseAssignment();
+	while(Left != INDEX_NONE && bAllowComma && IsAt(TEXT(",")))
+	{
+		const int32 Op = Cursor++;
+		const int32 Right = ParseAssignment();
+		if(Right == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		Left = MakeBinary(Left, Op, Right);
+	}
+	return Left;
+}
+
+int32 FPSFChunkTranslator::ParseAssignment()
+{
+	const int32 Left = ParseTernary();
+	const FToken &Token = Peek();
+	const TCHAR *const Operators[] = {TEXT("="), TEXT("+="), TEXT("-="), TEXT("*="), TEXT("/="), TEXT("%="), TEXT("&="), TEXT("|="), TEXT("^="), TEXT("<<="), TEXT(">>=")};
+	bool bAssignment = false;
+	for(const TCHAR *Operator : Operators)
+	{
+		bAssignment |= Token.Type == ETokenType::Punctuation && Token.Text == Operator;
+	}
+	if(Left == INDEX_NONE || !bAssignment)
+	{
+		return Left;
+	}
+
+	const int32 Op = Cursor++;
+	const int32 Right = ParseAssignment();
+	if(Right == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Index = AddExpr(EExprKind::Assign, Exprs[Left].First, Exprs[Right].Last, Op);
+	Exprs[Index].Children = {Left, Right};
+	const FPSFShaderType LeftType = Exprs[Left].Type;
+	const FPSFShaderType RightType = Exprs[Right].Type;
+	Exprs[Index].Type = LeftType;
+
+	const FString Operator = Tokens[Op].Text;
+	if(Operator == TEXT("%=") && (LeftType.Base == EPSFShaderBaseType::Float || RightType.Base == EPSFShaderBaseType::Float))
+	{
+		Fail(TEXT("%= on floats"));
+		return INDEX_NONE;
+	}
+	if(Operator == TEXT("*=") && LeftType.IsMatrix() && RightType.IsMatrix())
+	{
+		Fail(TEXT("*= of two matrices is component-wise in HLSL"));
+		return INDEX_NONE;
+	}
+
+	if(Operator == TEXT("="))
+	{
+		Convert(Right, LeftType);
+	}
+	else if(Operator.Len() == 2 && LeftType.IsKnown() && (LeftType.IsScalar() || LeftType.IsVector() || LeftType.IsMatrix()))
+	{
+		// v *= s keeps the scalar
+		Convert(Right, RightType.IsScalar() ? FPSFShaderType::Make(LeftType.Base) : LeftType);
+	}
+	return Index;
+}
+
+int32 FPSFChunkTranslator::ParseTernary()
+{
+	const int32 Condition = ParseBinary(1);
+	if(Condition == INDEX_NONE || !IsAt(TEXT("?")))
+	{
+		return Condition;
+	}
+
+	const int32 Op = Cursor++;
+	const int32 A = ParseAssignment();
+	if(A == INDEX_NONE || !Expect(TEXT(":")))
+	{
+		return INDEX_NONE;
+	}
+	const int32 B = ParseAssignment();
+	if(B == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	if(Exprs[Condition].Type.IsVector())
+	{
+		Fail(TEXT("component-wise ?:"));
+		return INDEX_NONE;
+	}
+	Convert(Condition, FPSFShaderType::Make(EPSFShaderBaseType::Bool));
+
+	const int32 Index = AddExpr(EExprKind::Ternary, Exprs[Condition].First, Exprs[B].Last, Op);
+	Exprs[Index].Children = {Condition, A, B};
+
+	const FPSFShaderType TypeA = Exprs[A].Type;
+	const FPSFShaderType TypeB = Exprs[B].Type;
+	FPSFShaderType Type = TypeA.IsKnown() ? TypeA : TypeB;
+	if(TypeA.IsKnown() && TypeB.IsKnown() && (TypeA.IsScalar() || TypeA.IsVector()) && (TypeB.IsScalar() || TypeB.IsVector()))
+	{
+		Type = FPSFShaderType::Make(CommonBase(TypeA, TypeB), CommonSize({TypeA, TypeB}));
+		Convert(A, Type);
+		Convert(B, Type);
+	}
+	Exprs[Index].Type = Type;
+	Exprs[Index].bConstant = Exprs[Condition].bConstant && Exprs[A].bConstant && Exprs[B].bConstant;
+	return Index;
+}
+
+int32 FPSFChunkTranslator::ParseBinary(int32 MinPrecedence)
+{
+	struct FPrecedence
+	{
+		const TCHAR *Operator;
+		int32 Precedence;
+	};
+	const FPrecedence Precedences[] = {
+		{TEXT("||"), 1}, {TEXT("&&"), 2}, {TEXT("|"), 3}, {TEXT("^"), 4}, {TEXT("&"), 5}, {TEXT("=="), 6}, {TEXT("!="), 6}, {TEXT("<"), 7},
+		{TEXT(">"), 7}, {TEXT("<="), 7}, {TEXT(">="), 7}, {TEXT("<<"), 8}, {TEXT(">>"), 8}, {TEXT("+"), 9}, {TEXT("-"), 9}, {TEXT("*"), 10},
+		{TEXT("/"), 10}, {TEXT("%"), 10}};
+
+	int32 Left = ParseUnary();
+	while(Left != INDEX_NONE)
+	{
+		const FToken &Token = Peek();
+		int32 Precedence = 0;
+		for(const FPrecedence &Entry : Precedences)
+		{
+			if(Token.Type == ETokenType::Punctuation && Token.Text == Entry.Operator)
+			{
+				Precedence = Entry.Precedence;
+				break;
+			}
+		}
+		if(Precedence == 0 || Precedence < MinPrecedence)
+		{
+			break;
+		}
+
+		const int32 Op = Cursor++;
+		const int32 Right = ParseBinary(Precedence + 1);
+		if(Right == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		Left = MakeBinary(Left, Op, Right);
+	}
+	return Left;
+}
+
+int32 FPSFChunkTranslator::MakeBinary(int32 Left, int32 OpToken, int32 Right)
+{
+	const int32 Index = AddExpr(EExprKind::Binary, Exprs[Left].First, Exprs[Right].Last, OpToken);
+	Exprs[Index].Children = {Left, Right};
+
+	const FString Op = Tokens[OpToken].Text;
+	const FPSFShaderType L = Exprs[Left].Type;
+	const FPSFShaderType R = Exprs[Right].Type;
+	const FPSFShaderType Bool = FPSFShaderType::Make(EPSFShaderBaseType::Bool);
+	const bool bComparison = Op == TEXT("<") || Op == TEXT(">") || Op == TEXT("<=") || Op == TEXT(">=") || Op == TEXT("==") || Op == TEXT("!=");
+	Exprs[Index].bConstant = Exprs[Left].bConstant && Exprs[Right].bConstant;
+
+	if(Op == TEXT(","))
+	{
+		Exprs[Index].Type = R;
+		return Index;
+	}
+	if(Op == TEXT("&&") || Op == TEXT("||"))
+	{
+		if(L.IsVector() || R.IsVector())
+		{
+			Fail(FString::Printf(TEXT("component-wise %s"), *Op));
+			return INDEX_NONE;
+		}
+		Convert(Left, Bool);
+		Convert(Right, Bool);
+		Exprs[Index].Type = Bool;
+		return Index;
+	}
+	if(Op == TEXT("&") || Op == TEXT("|") || Op == TEXT("^") || Op == TEXT("<<") || Op == TEXT(">>"))
+	{
+		Exprs[Index].Type = L;
+		return Index;
+	}
+	if(!L.IsKnown() || !R.IsKnown())
+	{
+		Exprs[Index].Type = bComparison ? Bool : FPSFShaderType();
+		return Index;
+	}
+
+	if(L.IsMatrix() || R.IsMatrix())
+	{
+		if(bComparison)
+		{
+			Fail(TEXT("matrix comparison"));
+			return INDEX_NONE;
+		}
+		if(L.IsMatrix() && R.IsMatrix())
+		{
+			if(Op == TEXT("*"))
+			{
+				Exprs[Index].Rewrite = ERewrite::BinaryCall;
+				Exprs[Index].Name = TEXT("matrixCompMult");
+				Exprs[Index].bConstant = false;
+			}
+			Exprs[Index].Type = L;
+			return Index;
+		}
+
+		const int32 Scalar = L.IsMatrix() ? Right : Left;
+		if(!Exprs[Scalar].Type.IsScalar())
+		{
+			Fail(FString::Printf(TEXT("%s of a matrix and a vector, use mul"), *Op));
+			return INDEX_NONE;
+		}
+		Convert(Scalar, FPSFShaderType::Make(EPSFShaderBaseType::Float));
+		Exprs[Index].Type = L.IsMatrix() ? L : R;
+		return Index;
+	}
+
+	if(!(L.IsScalar() || L.IsVector()) || !(R.IsScalar() || R.IsVector()))
+	{
+		if(bComparison)
+		{
+			Fail(TEXT("struct comparison"));
+			return INDEX_NONE;
+		}
+		Exprs[Index].Type = L;
+		return Index;
+	}
+
+	const EPSFShaderBaseType Base = CommonBase(L, R);
+	const int32 Size = CommonSize({L, R});
+	const bool bVector = L.IsVector() || R.IsVector();
+	const FPSFShaderType Operand = FPSFShaderType::Make(Base, Size);
+
+	if(bComparison)
+	{
+		if(!bVector)
+		{
+			Convert(Left, Operand);
+			Convert(Right, Operand);
+			Exprs[Index].Type = Bool;
+			return Index;
+		}
+
+		const TCHAR *Function = Op == TEXT("<") ? TEXT("lessThan") : Op == TEXT(">") ? TEXT("greaterThan") : Op == TEXT("<=") ? TEXT("lessThanEqual") : Op == TEXT(">=") ? TEXT("greaterThanEqual") : Op == TEXT("==") ? TEXT("equal") : TEXT("notEqual");
+		Convert(Left, Operand);
+		Convert(Right, Operand);
+		Exprs[Index].Rewrite = ERewrite::BinaryCall;
+		Exprs[Index].Name = Function;
+		Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Bool, Size);
+		++Owner.Stats.IntrinsicsMapped;
+		return Index;
+	}
+
+	// GLSL mixes scalars and vectors, but only of the same base type
+	const EPSFShaderBaseType Arithmetic = Base == EPSFShaderBaseType::Bool ? EPSFShaderBaseType::Int : Base;
+	Convert(Left, L.IsScalar() ? FPSFShaderType::Make(Arithmetic) : FPSFShaderType::Make(Arithmetic, Size));
+	Convert(Right, R.IsScalar() ? FPSFShaderType::Make(Arithmetic) : FPSFShaderType::Make(Arithmetic, Size));
+	Exprs[Index].Type = FPSFShaderType::Make(Arithmetic, Size);
+
+	if(Op == TEXT("%") && Arithmetic == EPSFShaderBaseType::Float)
+	{
+		// the helper takes two values of the same type
+		Convert(Left, Exprs[Index].Type);
+		Convert(Right, Exprs[Index].Type);
+		Exprs[Index].Rewrite = ERewrite::BinaryCall;
+		Exprs[Index].Name = FmodNames[Size - 1];
+		Exprs[Index].bConstant = false;
+		Owner.FmodSizes.Add(Size);
+		++Owner.Stats.EmulatedCalls;
+	}
+	return Index;
+}
+
+int32 FPSFChunkTranslator::ParseUnary()
+{
+	const FToken &Token = Peek();
+	const int32 First = Cursor;
+	if(Token.Type == ETokenType::Punctuation && (Token.Text == TEXT("-") || Token.Text == TEXT("+") || Token.Text == TEXT("!") || Token.Text == TEXT("~") || Token.Text == TEXT("++") || Token.Text == TEXT("--")))
+	{
+		++Cursor;
+		const int32 Operand = ParseUnary();
+		if(Operand == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+
+		const int32 Index = AddExpr(EExprKind::Unary, First, Exprs[Operand].Last, First);
+		Exprs[Index].Children = {Operand};
+		const FString Op = Tokens[First].Text;
+		const FPSFShaderType OperandType = Exprs[Operand].Type;
+		if(Op == TEXT("!"))
+		{
+			if(OperandType.IsVector())
+			{
+				Fail(TEXT("component-wise !"));
+				return INDEX_NONE;
+			}
+			Convert(Operand, FPSFShaderType::Make(EPSFShaderBaseType::Bool));
+			Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Bool);
+		}
+		else
+		{
+			Exprs[Index].Type = OperandType;
+		}
+		Exprs[Index].bConstant = Exprs[Operand].bConstant && Op != TEXT("++") && Op != TEXT("--");
+		return Index;
+	}
+
+	// (type) operand
+	if(IsAt(TEXT("(")) && Peek(1).Type == ETokenType::Identifier && IsTypeAt(FMath::Min(Cursor + 1, Tokens.Num() - 1)) && IsAt(TEXT(")"), 2))
+	{
+		const int32 TypeToken = Cursor + 1;
+		Cursor += 3;
+		const int32 Operand = ParseUnary();
+		if(Operand == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+
+		const int32 Index = AddExpr(EExprKind::Cast, First, Exprs[Operand].Last, TypeToken);
+		Exprs[Index].Children = {Operand};
+		const FPSFShaderType Target = TypeAt(TypeToken);
+		Exprs[Index].Type = Target;
+		Exprs[Index].bConstant = Exprs[Operand].bConstant;
+
+		if(Target.Base == EPSFShaderBaseType::Struct)
+		{
+			const FExpr &Value = Exprs[Operand];
+			if(Value.Kind != EExprKind::Literal || Tokens[Value.Token].Text != TEXT("0"))
+			{
+				Fail(TEXT("casts to a struct other than (Struct) 0"));
+				return INDEX_NONE;
+			}
+			Exprs[Index].Rewrite = ERewrite::ZeroStruct;
+			return Index;
+		}
+		if(!Target.IsScalar() && !Target.IsVector())
+		{
+			Fail(FString::Printf(TEXT("cast to %s"), *Tokens[TypeToken].Text));
+			return INDEX_NONE;
+		}
+		if(Exprs[Operand].Type == Target)
+		{
+			Exprs[Index].Rewrite = ERewrite::Unwrap;
+			return Index;
+		}
+		Exprs[Index].Rewrite = ERewrite::Cast;
+		++Owner.Stats.Conversions;
+		return Index;
+	}
+
+	return ParsePostfix(ParsePrimary());
+}
+
+bool FPSFChunkTranslator::ParseArguments(TArray<int32> &OutArguments)
+{
+	if(Accept(TEXT(")")))
+	{
+		return true;
+	}
+	while(true)
+	{
+		const int32 Argument = ParseAssignment();
+		if(Argument == INDEX_NONE)
+		{
+			return false;
+		}
+		OutArguments.Add(Argument);
+		if(Accept(TEXT(",")))
+		{
+			continue;
+		}
+		return Expect(TEXT(")"));
+	}
+}
+
+int32 FPSFChunkTranslator::ParsePrimary()
+{
+	const FToken &Token = Peek();
+	const int32 First = Cursor;
+
+	if(Token.Type == ETokenType::Number)
+	{
+		++Cursor;
+		const int32 Index = AddExpr(EExprKind::Literal, First, First, First);
+		const FString &Text = Token.Text;
+		const bool bUnsigned = !IsHexLiteral(Text) && (Text.EndsWith(TEXT("u")) || Text.EndsWith(TEXT("U")));
+		Exprs[Index].Type = FPSFShaderType::Make(IsFloatLiteral(Text) ? EPSFShaderBaseType::Float : bUnsigned ? EPSFShaderBaseType::UInt : EPSFShaderBaseType::Int);
+		Exprs[Index].bConstant = true;
+		const FString Number = ToGlslNumber(Text);
+		if(!Number.Equals(Text, ESearchCase::CaseSensitive))
+		{
+			Replacements.Add(First, Number);
+		}
+		return Index;
+	}
+
+	if(Token.Type == ETokenType::Identifier)
+	{
+		++Cursor;
+		if(Token.Text == TEXT("true") || Token.Text == TEXT("false"))
+		{
+			const int32 Index = AddExpr(EExprKind::Literal, First, First, First);
+			Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Bool);
+			Exprs[Index].bConstant = true;
+			return Index;
+		}
+
+		if(Accept(TEXT("(")))
+		{
+			TArray<int32> Arguments;
+			if(!ParseArguments(Arguments))
+			{
+				return INDEX_NONE;
+			}
+			const int32 Index = AddExpr(EExprKind::Call, First, Cursor - 1, First);
+			Exprs[Index].Children = Arguments;
+			return ResolveCall(Index) ? Index : INDEX_NONE;
+		}
+
+		const int32 Index = AddExpr(EExprKind::Identifier, First, First, First);
+		const FString &Name = Tokens[First].Text;
+		const FSymbol *Symbol = FindSymbol(Name);
+		if(!Symbol)
+		{
+			if(Name == TEXT("PI"))
+			{
+				Owner.bUsesPI = true;
+				Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Float);
+				Exprs[Index].bConstant = true;
+				return Index;
+			}
+			Fail(FString::Printf(TEXT("unknown identifier %s"), *Name));
+			return INDEX_NONE;
+		}
+		if(!Symbol->Unsupported.IsEmpty())
+		{
+			Fail(Symbol->Unsupported);
+			return INDEX_NONE;
+		}
+		if(Symbol->bState)
+		{
+			Replacements.Add(First, TEXT("psf.") + Symbol->OutName);
+			bUsesState = true;
+		}
+		else if(!Symbol->OutName.Equals(Name, ESearchCase::CaseSensitive))
+		{
+			Replacements.Add(First, Symbol->OutName);
+		}
+		Exprs[Index].Type = Symbol->Type;
+		Exprs[Index].bConstant = Symbol->bConstant;
+		return Index;
+	}
+
+	if(Accept(TEXT("(")))
+	{
+		const int32 Inner = ParseExpression();
+		if(Inner == INDEX_NONE || !Expect(TEXT(")")))
+		{
+			return INDEX_NONE;
+		}
+		const int32 Index = AddExpr(EExprKind::Paren, First, Cursor - 1);
+		Exprs[Index].Children = {Inner};
+		Exprs[Index].Type = Exprs[Inner].Type;
+		Exprs[Index].bConstant = Exprs[Inner].bConstant;
+		return Index;
+	}
+
+	if(Accept(TEXT("{")))
+	{
+		// typed by the declaration it initializes
+		TArray<int32> Elements;
+		while(!IsAt(TEXT("}")))
+		{
+			const int32 Element = ParseAssignment();
+			if(Element == INDEX_NONE)
+			{
+				return INDEX_NONE;
+			}
+			Elements.Add(Element);
+			if(!Accept(TEXT(",")))
+			{
+				break;
+			}
+		}
+		if(!Expect(TEXT("}")))
+		{
+			return INDEX_NONE;
+		}
+		const int32 Index = AddExpr(EExprKind::InitList, First, Cursor - 1);
+		Exprs[Index].Children = Elements;
+		return Index;
+	}
+
+	Fail(Token.Type == ETokenType::End ? FString(TEXT("unexpected end")) : FString::Printf(TEXT("unexpected '%s'"), *Token.Text));
+	return INDEX_NONE;
+}
+
+int32 FPSFChunkTranslator::ParsePostfix(int32 Index)
+{
+	while(Index != INDEX_NONE)
+	{
+		const int32 First = Exprs[Index].First;
+		if(Accept(TEXT("[")))
+		{
+			const int32 Subscript = ParseExpression();
+			if(Subscript == INDEX_NONE || !Expect(TEXT("]")))
+			{
+				return INDEX_NONE;
+			}
+
+			const FPSFShaderType Object = Exprs[Index].Type;
+			const int32 Element = AddExpr(EExprKind::Index, First, Cursor - 1);
+			Exprs[Element].Children = {Index, Subscript};
+			Exprs[Element].bConstant = Exprs[Index].bConstant && Exprs[Subscript].bConstant;
+			ConvertBase(Subscript, EPSFShaderBaseType::Int);
+
+			FPSFShaderType Type = Object;
+			if(Object.bArray)
+			{
+				Type.bArray = false;
+			}
+			else if(Object.IsMatrix())
+			{
+				// an HLSL row, stored as a GLSL column
+				Type = FPSFShaderType::Make(Object.Base, Object.Columns);
+			}
+			else if(Object.IsVector())
+			{
+				Type = FPSFShaderType::Make(Object.Base);
+			}
+			else if(Object.IsKnown())
+			{
+				Fail(TEXT("index into a scalar"));
+				return INDEX_NONE;
+			}
+			Exprs[Element].Type = Type;
+			Index = Element;
+		}
+		else if(Accept(TEXT(".")))
+		{
+			if(Peek().Type != ETokenType::Identifier)
+			{
+				Fail(TEXT("expected a member name"));
+				return INDEX_NONE;
+			}
+			const int32 NameToken = Cursor++;
+			if(Accept(TEXT("(")))
+			{
+				TArray<int32> Arguments;
+				if(!ParseArguments(Arguments))
+				{
+					return INDEX_NONE;
+				}
+				const int32 Method = AddExpr(EExprKind::Method, First, Cursor - 1, NameToken);
+				Exprs[Method].Children = {Index};
+				Exprs[Method].Children.Append(Arguments);
+				if(!ResolveMethod(Method))
+				{
+					return INDEX_NONE;
+				}
+				Index = Method;
+			}
+			else
+			{
+				const int32 Member = AddExpr(EExprKind::Member, First, NameToken, NameToken);
+				Exprs[Member].Children = {Index};
+				if(!ResolveMember(Member))
+				{
+					return INDEX_NONE;
+				}
+				Index = Member;
+			}
+		}
+		else if(IsAt(TEXT("++")) || IsAt(TEXT("--")))
+		{
+			const int32 Op = Cursor++;
+			const int32 Postfix = AddExpr(EExprKind::Postfix, First, Op, Op);
+			Exprs[Postfix].Children = {Index};
+			Exprs[Postfix].Type = Exprs[Index].Type;
+			Index = Postfix;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return Index;
+}
+
+bool FPSFChunkTranslator::ResolveCall(int32 Index)
+{
+	const FString Name = Tokens[Exprs[Index].Token].Text;
+	const TArray<int32> Arguments = Exprs[Index].Children;
+
+	const FPSFShaderType Constructed = FPSFShaderType::FromHlsl(Name);
+	if(Constructed.IsKnown())
+	{
+		if(!Constructed.IsScalar() && !Constructed.IsVector() && !Constructed.IsMatrix())
+		{
+			return Fail(FString::Printf(TEXT("constructor of %s"), *Name));
+		}
+
+		// constructors convert on their own, only literals are respelled so that float3(0, 1, 0) reads vec3(0.0, 1.0, 0.0)
+		bool bConstant = true;
+		for(const int32 Argument : Arguments)
+		{
+			const FExpr &Value = Exprs[Argument];
+			const bool bLiteral = Value.Kind == EExprKind::Literal || (Value.Kind == EExprKind::Unary && Exprs[Value.Children[0]].Kind == EExprKind::Literal);
+			if(bLiteral)
+			{
+				ConvertBase(Argument, Constructed.Base);
+			}
+			bConstant &= Exprs[Argument].bConstant;
+		}
+		Replacements.Add(Exprs[Index].Token, Constructed.ToGlsl());
+		Exprs[Index].Type = Constructed;
+		Exprs[Index].bConstant = bConstant;
+		return true;
+	}
+
+	if(const TArray<FFunction> *Overloads = Owner.Functions.Find(Name))
+	{
+		return ResolveFunctionCall(Index, *Overloads);
+	}
+	if(const FIntrinsic *Intrinsic = FindIntrinsic(Name))
+	{
+		return ResolveIntrinsic(Index, *Intrinsic);
+	}
+	return Fail(FString::Printf(TEXT("unknown function %s"), *Name));
+}
+
+bool FPSFChunkTranslator::ResolveFunctionCall(int32 Index, const TArray<FFunction> &Overloads)
+{
+	const FString Name = Tokens[Exprs[Index].Token].Text;
+	const TArray<int32> Arguments = Exprs[Index].Children;
+
+	// the same ranking as HLSL in spirit: exact matches first, then conversions, then scalars promoted to vectors
+	const FFunction *Best = nullptr;
+	int32 BestScore = -1;
+	for(const FFunction &Function : Overloads)
+	{
+		if(Arguments.Num() > Function.Parameters.Num() || Arguments.Num() < Function.GetRequiredParameters())
+		{
+			continue;
+		}
+
+		int32 Score = 0;
+		for(int32 Argument = 0; Argument < Arguments.Num() && Score >= 0; ++Argument)
+		{
+			const FPSFShaderType &ArgumentType = Exprs[Arguments[Argument]].Type;
+			const FPSFShaderType &ParameterType = Function.Parameters[Argument].Type;
+			if(!ArgumentType.IsKnown() || ArgumentType == ParameterType)
+			{
+				Score += 4;
+			}
+			else if(ArgumentType.IsNumeric() && ParameterType.IsNumeric() && ArgumentType.Rows == ParameterType.Rows && ArgumentType.Columns == ParameterType.Columns)
+			{
+				Score += 2;
+			}
+			else if(ArgumentType.IsScalar() && ParameterType.IsVector())
+			{
+				Score += 1;
+			}
+			else if(ArgumentType.IsVector() && (ParameterType.IsVector() || ParameterType.IsScalar()) && ArgumentType.Rows > ParameterType.Rows)
+			{
+				Score += 1;
+			}
+			else
+			{
+				Score = -1;
+			}
+		}
+		if(Score > BestScore)
+		{
+			Best = &Function;
+			BestScore = Score;
+		}
+	}
+
+	if(!Best)
+	{
+		return Fail(FString::Printf(TEXT("no overload of %s takes these arguments"), *Name));
+	}
+	if(!Best->Unsupported.IsEmpty())
+	{
+		return Fail(FString::Printf(TEXT("calls %s"), *Name));
+	}
+
+	for(int32 Argument = 0; Argument < Arguments.Num(); ++Argument)
+	{
+		const FParameter &Parameter = Best->Parameters[Argument];
+		if(Parameter.Type.Base == EPSFShaderBaseType::Sampler)
+		{
+			Exprs[Index].Dropped.Add(Arguments[Argument]);
+		}
+		else if(!Parameter.bOut)
+		{
+			Convert(Arguments[Argument], Parameter.Type);
+		}
+	}
+
+	// Godot has no overloads to forward default arguments, they are written at the call
+	if(Owner.Dialect == EPSFShaderDialect::Godot)
+	{
+		for(int32 Parameter = Arguments.Num(); Parameter < Best->Parameters.Num(); ++Parameter)
+		{
+			Exprs[Index].Extra.Add(Best->Parameters[Parameter].Default);
+		}
+	}
+
+	FExpr &Resolved = Exprs[Index];
+	Resolved.Type = Best->ReturnType;
+	Resolved.Name = Best->OutName;
+	Resolved.bPassState = Best->bState;
+	bUsesState |= Best->bState;
+	if(Resolved.Dropped.Num() > 0 || Resolved.Extra.Num() > 0 || Resolved.bPassState)
+	{
+		Resolved.Rewrite = ERewrite::Arguments;
+	}
+	else if(!Best->OutName.Equals(Name, ESearchCase::CaseSensitive))
+	{
+		Replacements.Add(Resolved.Token, Best->OutName);
+	}
+	return true;
+}
+
+bool FPSFChunkTranslator::ResolveIntrinsic(int32 Index, const FIntrinsic &Intrinsic)
+{
+	const FString Name = Tokens[Exprs[Index].Token].Text;
+	const TArray<int32> Arguments = Exprs[Index].Children;
+	if(Arguments.Num() != Intrinsic.Arguments)
+	{
+		return Fail(FString::Printf(TEXT("%s takes %d arguments"), *Name, Intrinsic.Arguments));
+	}
+
+	TArray<FPSFShaderType> Types;
+	bool bKnown = true;
+	bool bConstant = Owner.Dialect == EPSFShaderDialect::GLSL;
+	for(const int32 Argument : Arguments)
+	{
+		Types.Add(Exprs[Argument].Type);
+		bKnown &= Exprs[Argument].Type.IsKnown();
+		bConstant &= Exprs[Argument].bConstant;
+	}
+
+	const FPSFShaderType Float = FPSFShaderType::Make(EPSFShaderBaseType::Float);
+	FPSFShaderType Type;
+	FString GlslName = Intrinsic.Glsl;
+	ERewrite Rewrite = Intrinsic.Rewrite;
+
+	switch(Intrinsic.Kind)
+	{
+	case EIntrinsic::Float:
+	case EIntrinsic::Numeric:
+	{
+		if(!bKnown)
+		{
+			break;
+		}
+		if(Types[0].IsMatrix())
+		{
+			Type = Types[0];
+			break;
+		}
+
+		EPSFShaderBaseType Base = Intrinsic.Kind == EIntrinsic::Float ? EPSFShaderBaseType::Float : Types[0].Base;
+		for(const FPSFShaderType &ArgumentType : Types)
+		{
+			Base = CommonBase(FPSFShaderType::Make(Base), ArgumentType);
+		}
+		Base = Base == EPSFShaderBaseType::Bool ? EPSFShaderBaseType::Int : Base;
+		const int32 Size = CommonSize(Types);
+		for(int32 Argument = 0; Argument < Arguments.Num(); ++Argument)
+		{
+			const bool bScalar = (Intrinsic.ScalarArguments & (1u << Argument)) != 0 && Types[Argument].IsScalar();
+			Convert(Arguments[Argument], FPSFShaderType::Make(Base, bScalar ? 1 : Size));
+		}
+		Type = FPSFShaderType::Make(Base, Size);
+
+		if(Name == TEXT("fmod"))
+		{
+			GlslName = FmodNames[Size - 1];
+			Owner.FmodSizes.Add(Size);
+			++Owner.Stats.EmulatedCalls;
+			bConstant = false;
+		}
+		break;
+	}
+	case EIntrinsic::Reduce:
+	{
+		const int32 Size = CommonSize(Types);
+		for(const int32 Argument : Arguments)
+		{
+			Convert(Argument, FPSFShaderType::Make(EPSFShaderBaseType::Float, Size));
+		}
+		Type = Float;
+		break;
+	}
+	case EIntrinsic::Cross:
+		Convert(Arguments[0], FPSFShaderType::Make(EPSFShaderBaseType::Float, 3));
+		Convert(Arguments[1], FPSFShaderType::Make(EPSFShaderBaseType::Float, 3));
+		Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, 3);
+		break;
+	case EIntrinsic::Determinant:
+		Type = Float;
+		break;
+	case EIntrinsic::Transpose:
+		Type = Types[0].IsMatrix() ? FPSFShaderType::Make(Types[0].Base, Types[0].Columns, Types[0].Rows) : Types[0];
+		break;
+	case EIntrinsic::Test:
+		if(Types[0].IsVector())
+		{
+			Convert(Arguments[0], FPSFShaderType::Make(EPSFShaderBaseType::Bool, Types[0].Rows));
+		}
+		else
+		{
+			Convert(Arguments[0], FPSFShaderType::Make(EPSFShaderBaseType::Bool));
+			Rewrite = ERewrite::Unwrap;
+		}
+		Type = FPSFShaderType::Make(EPSFShaderBaseType::Bool);
+		break;
+	case EIntrinsic::Classify:
+		ConvertBase(Arguments[0], EPSFShaderBaseType::Float);
+		Type = FPSFShaderType::Make(EPSFShaderBaseType::Bool, Types[0].Rows);
+		break;
+	case EIntrinsic::Bits:
+	{
+		const EPSFShaderBaseType From = Types[0].Base;
+		Type = Types[0];
+		if(Name == TEXT("asfloat") || Name == TEXT("asint") || Name == TEXT("asuint"))
+		{
+			const EPSFShaderBaseType To = Name == TEXT("asfloat") ? EPSFShaderBaseType::Float : Name == TEXT("asint") ? EPSFShaderBaseType::Int : EPSFShaderBaseType::UInt;
+			Type.Base = To;
+			if(From == To)
+			{
+				Rewrite = ERewrite::Unwrap;
+			}
+			else if(From == EPSFShaderBaseType::Float)
+			{
+				GlslName = To == EPSFShaderBaseType::Int ? TEXT("floatBitsToInt") : TEXT("floatBitsToUint");
+			}
+			else if(To == EPSFShaderBaseType::Float)
+			{
+				GlslName = From == EPSFShaderBaseType::Int ? TEXT("intBitsToFloat") : TEXT("uintBitsToFloat");
+			}
+			else
+			{
+				// int <-> uint keeps the bits
+				GlslName = Type.ToGlsl();
+			}
+		}
+		else if(Name != TEXT("reversebits"))
+		{
+			Type.Base = EPSFShaderBaseType::Int;
+		}
+		break;
+	}
+	case EIntrinsic::Mul:
+	{
+		// b * a works for every combination since GLSL stores an HLSL row as a column
+		const FPSFShaderType &A = Types[0];
+		const FPSFShaderType &B = Types[1];
+		if(!bKnown)
+		{
+			break;
+		}
+		if(A.IsScalar())
+		{
+			Type = B;
+		}
+		else if(B.IsScalar())
+		{
+			Type = A;
+		}
+		else if(A.IsVector() && B.IsMatrix())
+		{
+			Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, B.Columns);
+		}
+		else if(A.IsMatrix() && B.IsVector())
+		{
+			Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, A.Rows);
+		}
+		else if(A.IsMatrix() && B.IsMatrix())
+		{
+			Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, A.Rows, B.Columns);
+		}
+		else
+		{
+			Type = Float;
+			Rewrite = ERewrite::None;
+			GlslName = TEXT("dot");
+		}
+		break;
+	}
+	}
+
+	FExpr &Expr = Exprs[Index];
+	Expr.Type = Type;
+	Expr.bConstant = bConstant;
+	Expr.Rewrite = Rewrite;
+	if(Rewrite == ERewrite::None && !GlslName.Equals(Name, ESearchCase::CaseSensitive))
+	{
+		Replacements.Add(Expr.Token, GlslName);
+	}
+	if(Rewrite != ERewrite::None || !GlslName.Equals(Name, ESearchCase::CaseSensitive))
+	{
+		Owner.Stats.IntrinsicsMapped += Name == TEXT("fmod") ? 0 : 1;
+	}
+	return true;
+}
+
+bool FPSFChunkTranslator::ResolveMethod(int32 Index)
+{
+	const FString Name = Tokens[Exprs[Index].Token].Text;
+	const TArray<int32> Children = Exprs[Index].Children;
+	const FPSFShaderType Object = Exprs[Children[0]].Type;
+	const int32 Arguments = Children.Num() - 1;
+
+	const int32 Dimensions = Object.Base == EPSFShaderBaseType::Texture2D ? 2 : Object.Base == EPSFShaderBaseType::Texture3D || Object.Base == EPSFShaderBaseType::TextureCube ? 3 : 0;
+	if(Dimensions == 0)
+	{
+		return Fail(FString::Printf(TEXT("method %s"), *Name));
+	}
+
+	const FPSFShaderType Coordinates = FPSFShaderType::Make(EPSFShaderBaseType::Float, Dimensions);
+	const FPSFShaderType Float = FPSFShaderType::Make(EPSFShaderBaseType::Float);
+	ERewrite Rewrite = ERewrite::None;
+	if(Name == TEXT("Load") && Arguments == 1 && Object.Base != EPSFShaderBaseType::TextureCube)
+	{
+		Convert(Children[1], FPSFShaderType::Make(EPSFShaderBaseType::Int, Dimensions + 1));
+		Rewrite = ERewrite::TexelFetch;
+	}
+	else if(Name == TEXT("Sample") && Arguments == 2)
+	{
+		Convert(Children[2], Coordinates);
+		Rewrite = ERewrite::Texture;
+	}
+	else if(Name == TEXT("SampleLevel") && Arguments == 3)
+	{
+		Convert(Children[2], Coordinates);
+		Convert(Children[3], Float);
+		Rewrite = ERewrite::TextureLod;
+	}
+	else if(Name == TEXT("SampleGrad") && Arguments == 4)
+	{
+		Convert(Children[2], Coordinates);
+		Convert(Children[3], Coordinates);
+		Convert(Children[4], Coordinates);
+		Rewrite = ERewrite::TextureGrad;
+	}
+	else if(Name == TEXT("GetDimensions") && Arguments == Dimensions)
+	{
+		Exprs[Index].Rewrite = ERewrite::Dimensions;
+		Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Void);
+		++Owner.Stats.IntrinsicsMapped;
+		return true;
+	}
+	else
+	{
+		return Fail(FString::Printf(TEXT("texture method %s with %d arguments"), *Name, Arguments));
+	}
+
+	Exprs[Index].Rewrite = Rewrite;
+	Exprs[Index].Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, 4);
+	++Owner.Stats.IntrinsicsMapped;
+	return true;
+}
+
+bool FPSFChunkTranslator::ResolveMember(int32 Index)
+{
+	const FString Name = Tokens[Exprs[Index].Token].Text;
+	const int32 ObjectIndex = Exprs[Index].Children[0];
+	const FPSFShaderType Object = Exprs[ObjectIndex].Type;
+	Exprs[Index].bConstant = Exprs[ObjectIndex].bConstant;
+
+	if(Object.Base == EPSFShaderBaseType::Struct && !Object.bArray)
+	{
+		const TArray<FStructMember> *Members = Owner.Structs.Find(Object.StructName);
+		for(const FStructMember &Member : Members ? *Members : TArray<FStructMember>())
+		{
+			if(Member.Name.Equals(Name, ESearchCase::CaseSensitive))
+			{
+				Exprs[Index].Type = Member.Type;
+				const FString OutName = ToGlslIdentifier(Name);
+				if(OutName != Name)
+				{
+					Replacements.Add(Exprs[Index].Token, OutName);
+				}
+				return true;
+			}
+		}
+		return Fail(FString::Printf(TEXT("%s has no member %s"), *Object.StructName, *Name));
+	}
+
+	if(!Object.IsKnown())
+	{
+		return true;
+	}
+	if(Object.IsMatrix() || !(Object.IsScalar() || Object.IsVector()) || !IsSwizzle(Name))
+	{
+		return Fail(FString::Printf(TEXT("member %s"), *Name));
+	}
+
+	Exprs[Index].Type = FPSFShaderType::Make(Object.Base, Name.Len());
+	if(Object.IsScalar())
+	{
+		Exprs[Index].Rewrite = ERewrite::ScalarSwizzle;
+	}
+	return true;
+}
+
+bool FPSFChunkTranslator::ResolveInitList(int32 Index, const FPSFShaderType &Target, int32 SizeExpr)
+{
+	if(!Target.bArray)
+	{
+		return Fail(TEXT("initializer list of a non-array"));
+	}
+
+	FPSFShaderType Element = Target;
+	Element.bArray = false;
+	bool bConstant = true;
+	for(const int32 Child : Exprs[Index].Children)
+	{
+		if(Exprs[Child].Kind == EExprKind::InitList)
+		{
+			return Fail(TEXT("nested initializer lists"));
+		}
+		Convert(Child, Element);
+		bConstant &= Exprs[Child].bConstant;
+	}
+	Exprs[Index].Type = Target;
+	Exprs[Index].Name = Element.ToGlsl();
+	Exprs[Index].Size = SizeExpr;
+	Exprs[Index].bConstant = bConstant;
+	return true;
+}
+
+bool FPSFChunkTranslator::EvaluateInteger(int32 Index, int32 &OutValue)
+{
+	const FExpr &Expr = Exprs[Index];
+	switch(Expr.Kind)
+	{
+	case EExprKind::Literal:
+		if(Expr.Type.Base == EPSFShaderBaseType::Int || Expr.Type.Base == EPSFShaderBaseType::UInt)
+		{
+			OutValue = FCString::Strtoi(*Tokens[Expr.Token].Text, nullptr, 0);
+			return true;
+		}
+		return false;
+	case EExprKind::Identifier:
+	{
+		const FString *Value = Owner.MacroValues.Find(Tokens[Expr.Token].Text);
+		if(!Value || Depth > 8)
+		{
+			return false;
+		}
+		FPSFChunkTranslator Macro(Owner, *Value, Depth + 1);
+		return Macro.EvaluateMacroValue(OutValue);
+	}
+	case EExprKind::Paren:
+		return EvaluateInteger(Expr.Children[0], OutValue);
+	case EExprKind::Unary:
+		if(Tokens[Expr.Token].Text == TEXT("-") && EvaluateInteger(Expr.Children[0], OutValue))
+		{
+			OutValue = -OutValue;
+			return true;
+		}
+		return false;
+	case EExprKind::Binary:
+	{
+		int32 Left = 0;
+		int32 Right = 0;
+		if(!EvaluateInteger(Expr.Children[0], Left) || !EvaluateInteger(Expr.Children[1], Right))
+		{
+			return false;
+		}
+		const FString &Op = Tokens[Expr.Token].Text;
+		if(Op == TEXT("+"))
+		{
+			OutValue = Left + Right;
+		}
+		else if(Op == TEXT("-"))
+		{
+			OutValue = Left - Right;
+		}
+		else if(Op == TEXT("*"))
+		{
+			OutValue = Left * Right;
+		}
+		else if(Op == TEXT("/") && Right != 0)
+		{
+			OutValue = Left / Right;
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool FPSFChunkTranslator::EvaluateMacroValue(int32 &OutValue)
+{
+	const int32 Index = ParseExpression();
+	return Index != INDEX_NONE && Peek().Type == ETokenType::End && EvaluateInteger(Index, OutValue);
+}
+
+int32 FPSFChunkTranslator::ParseRoot(const FPSFShaderType *Target)
+{
+	const int32 Index = ParseExpression();
+	if(Index == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+	if(Exprs[Index].Kind == EExprKind::InitList)
+	{
+		Fail(TEXT("initializer list outside of a declaration"));
+		return INDEX_NONE;
+	}
+	if(Target)
+	{
+		Convert(Index, *Target);
+	}
+	Roots.Add(Exprs[Index].First, Index);
+	return Index;
+}
+
+bool FPSFChunkTranslator::ParseCondition()
+{
+	const FPSFShaderType Bool = FPSFShaderType::Make(EPSFShaderBaseType::Bool);
+	const int32 Index = ParseRoot(&Bool);
+	if(Index != INDEX_NONE && Exprs[Index].Type.IsVector())
+	{
+		return Fail(TEXT("vector condition"));
+	}
+	return Index != INDEX_NONE;
+}
+
+bool FPSFChunkTranslator::ParseBlock()
+{
+	if(!Expect(TEXT("{")))
+	{
+		return false;
+	}
+	Scopes.AddDefaulted();
+	while(!IsAt(TEXT("}")))
+	{
+		if(Peek().Type == ETokenType::End)
+		{
+			return Fail(TEXT("unterminated block"));
+		}
+		if(!ParseStatement())
+		{
+			return false;
+		}
+	}
+	++Cursor;
+	Scopes.Pop();
+	return true;
+}
+
+bool FPSFChunkTranslator::ParseStatement()
+{
+	const FToken &Token = Peek();
+	if(Token.Type == ETokenType::Directive)
+	{
+		// conditionals the specialization left open stay as they are
+		++Cursor;
+		return true;
+	}
+	if(IsAt(TEXT("{")))
+	{
+		return ParseBlock();
+	}
+	if(Accept(TEXT(";")))
+	{
+		return true;
+	}
+	if(IsAt(TEXT("[")))
+	{
+		// [unroll], [loop], [branch], [unroll(4)]: GLSL has no attributes
+		const int32 Start = Cursor;
+		while(!IsAt(TEXT("]")) && Peek().Type != ETokenType::End)
+		{
+			++Cursor;
+		}
+		++Cursor;
+		for(int32 Index = Start; Index < Cursor; ++Index)
+		{
+			Removed.Add(Index);
+		}
+		return ParseStatement();
+	}
+	if(Accept(TEXT("if")))
+	{
+		if(!Expect(TEXT("(")) || !ParseCondition() || !Expect(TEXT(")")) || !ParseStatement())
+		{
+			return false;
+		}
+		return !Accept(TEXT("else")) || ParseStatement();
+	}
+	if(Accept(TEXT("while")))
+	{
+		return Expect(TEXT("(")) && ParseCondition() && Expect(TEXT(")")) && ParseStatement();
+	}
+	if(Accept(TEXT("do")))
+	{
+		return ParseStatement() && Expect(TEXT("while")) && Expect(TEXT("(")) && ParseCondition() && Expect(TEXT(")")) && Expect(TEXT(";"));
+	}
+	if(Accept(TEXT("for")))
+	{
+		if(!Expect(TEXT("(")))
+		{
+			return false;
+		}
+		Scopes.AddDefaulted();
+		if(!IsAt(TEXT(";")))
+		{
+			if(IsDeclarationStart() ? !ParseDeclaration(false) : ParseRoot() == INDEX_NONE)
+			{
+				return false;
+			}
+		}
+		if(!Expect(TEXT(";")) || (!IsAt(TEXT(";")) && !ParseCondition()) || !Expect(TEXT(";")))
+		{
+			return false;
+		}
+		if((!IsAt(TEXT(")")) && ParseRoot() == INDEX_NONE) || !Expect(TEXT(")")) || !ParseStatement())
+		{
+			return false;
+		}
+		Scopes.Pop();
+		return true;
+	}
+	if(Accept(TEXT("switch")))
+	{
+		const FPSFShaderType Int = FPSFShaderType::Make(EPSFShaderBaseType::Int);
+		return Expect(TEXT("(")) && ParseRoot(&Int) != INDEX_NONE && Expect(TEXT(")")) && ParseStatement();
+	}
+	if(Accept(TEXT("case")))
+	{
+		return ParseRoot() != INDEX_NONE && Expect(TEXT(":"));
+	}
+	if(Accept(TEXT("default")))
+	{
+		return Expect(TEXT(":"));
+	}
+	if(Accept(TEXT("break")) || Accept(TEXT("continue")) || Accept(TEXT("discard")))
+	{
+		return Expect(TEXT(";"));
+	}
+	if(Accept(TEXT("return")))
+	{
+		if(Accept(TEXT(";")))
+		{
+			return true;
+		}
+		return ParseRoot(&ReturnType) != INDEX_NONE && Expect(TEXT(";"));
+	}
+	if(IsDeclarationStart())
+	{
+		return ParseDeclaration(false) && Expect(TEXT(";"));
+	}
+	return ParseRoot() != INDEX_NONE && Expect(TEXT(";"));
+}
+
+bool FPSFChunkTranslator::ParseArraySize(FPSFShaderType &InOutType, int32 &OutSizeExpr)
+{
+	OutSizeExpr = INDEX_NONE;
+	while(Accept(TEXT("[")))
+	{
+		if(InOutType.bArray)
+		{
+			return Fail(TEXT("arrays of arrays"));
+		}
+		if(!IsAt(TEXT("]")))
+		{
+			OutSizeExpr = ParseExpression();
+			if(OutSizeExpr == INDEX_NONE)
+			{
+				return false;
+			}
+			ConvertBase(OutSizeExpr, EPSFShaderBaseType::Int);
+			Roots.Add(Exprs[OutSizeExpr].First, OutSizeExpr);
+		}
+		if(!Expect(TEXT("]")))
+		{
+			return false;
+		}
+		InOutType.bArray = true;
+	}
+	return true;
+}
+
+bool FPSFChunkTranslator::ParseDeclaration(bool bGlobal)
+{
+	bool bStatic = false;
+	bool bConst = false;
+	TArray<int32> ConstTokens;
+	while(Peek().Type == ETokenType::Identifier)
+	{
+		if(IsAt(TEXT("static")) || IsAt(TEXT("extern")) || IsAt(TEXT("uniform")) || IsAt(TEXT("precise")) || IsAt(TEXT("groupshared")))
+		{
+			bStatic |= IsAt(TEXT("static"));
+			Removed.Add(Cursor++);
+		}
+		else if(IsAt(TEXT("const")))
+		{
+			bConst = true;
+			ConstTokens.Add(Cursor++);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if(!IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)))
+	{
+		return Fail(FString::Printf(TEXT("expected a type before '%s'"), *Peek().Text));
+	}
+	const int32 TypeToken = Cursor++;
+	const FPSFShaderType Type = TypeAt(TypeToken);
+	if(Type.Base == EPSFShaderBaseType::Void)
+	{
+		return Fail(TEXT("void variable"));
+	}
+	if(!bGlobal && bStatic && !bConst)
+	{
+		return Fail(TEXT("static local variables"));
+	}
+
+	// HLSL globals that are not static are uniforms
+	const bool bUniform = bGlobal && !bStatic && !bConst;
+	const bool bObject = Type.Base >= EPSFShaderBaseType::Texture2D;
+	if(bObject && !bGlobal)
+	{
+		return Fail(TEXT("texture or sampler local"));
+	}
+	Replacements.Add(TypeToken, bUniform || bObject ? TEXT("uniform ") + Type.ToGlsl() : Type.ToGlsl());
+
+	bool bAllConstant = true;
+	do
+	{
+		if(Peek().Type != ETokenType::Identifier)
+		{
+			return Fail(TEXT("expected a variable name"));
+		}
+		const int32 NameToken = Cursor++;
+		const FString &Name = Tokens[NameToken].Text;
+
+		FPSFShaderType VariableType = Type;
+		int32 SizeExpr = INDEX_NONE;
+		if(!ParseArraySize(VariableType, SizeExpr))
+		{
+			return false;
+		}
+
+		// register semantics and packoffset
+		if(IsAt(TEXT(":")))
+		{
+			Removed.Add(Cursor++);
+			while(Peek().Type != ETokenType::End && !IsAt(TEXT("=")) && !IsAt(TEXT(";")) && !IsAt(TEXT(",")))
+			{
+				Removed.Add(Cursor++);
+			}
+		}
+
+		int32 Init = INDEX_NONE;
+		if(Accept(TEXT("=")))
+		{
+			Init = ParseAssignment();
+			if(Init == INDEX_NONE)
+			{
+				return false;
+			}
+			if(Exprs[Init].Kind == EExprKind::InitList)
+			{
+				if(!ResolveInitList(Init, VariableType, SizeExpr))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				Convert(Init, VariableType);
+			}
+			Roots.Add(Exprs[Init].First, Init);
+		}
+		bAllConstant &= Init != INDEX_NONE && Exprs[Init].bConstant;
+		if(bGlobal && Init != INDEX_NONE && !Exprs[Init].bConstant)
+		{
+			return Fail(FString::Printf(TEXT("global %s with a value that is not a constant expression"), *Name));
+		}
+
+		FSymbol Symbol;
+		Symbol.Type = VariableType;
+		Symbol.bConstant = bConst && Init != INDEX_NONE && Exprs[Init].bConstant;
+		Symbol.OutName = ToGlslIdentifier(Name);
+		if(Symbol.OutName != Name)
+		{
+			Replacements.Add(NameToken, Symbol.OutName);
+		}
+		if(bGlobal && Owner.Dialect == EPSFShaderDialect::Godot && !bConst && !bUniform)
+		{
+			if(!DeclareStateMember(Symbol, TypeToken, SizeExpr, Init))
+			{
+				return false;
+			}
+			StateNames.Add(Symbol.OutName);
+		}
+		if(bGlobal)
+		{
+			Owner.Globals.Add(Name, Symbol);
+		}
+		else
+		{
+			Scopes.Last().Add(Name, Symbol);
+		}
+	}
+	while(Accept(TEXT(",")));
+
+	// GLSL const needs a constant expression, HLSL const only means read-only
+	if(bConst && !bAllConstant)
+	{
+		for(const int32 ConstToken : ConstTokens)
+		{
+			Removed.Add(ConstToken);
+		}
+	}
+	return true;
+}
+
+bool FPSFChunkTranslator::DeclareStateMember(FSymbol &InOutSymbol, int32 TypeToken, int32 SizeExpr, int32 Init)
+{
+	// PSFState goes in front of the first function that takes it, a member declared later can only use what is known there
+	if(Owner.bStateUsed)
+	{
+		TArray<int32> Uses = {TypeToken};
+		for(const int32 Index : {SizeExpr, Init})
+		{
+			if(Index == INDEX_NONE)
+			{
+				continue;
+			}
+			for(int32 TokenIndex = Exprs[Index].First; TokenIndex <= Exprs[Index].Last; ++TokenIndex)
+			{
+				Uses.Add(TokenIndex);
+			}
+		}
+		for(const int32 TokenIndex : Uses)
+		{
+			const FString &Text = Tokens[TokenIndex].Text;
+			const bool bDeclared = Owner.Structs.Contains(Text) || Owner.Macros.Contains(Text) || Owner.Globals.Contains(Text);
+			if(Tokens[TokenIndex].Type == ETokenType::Identifier && bDeclared && !Owner.StateKnownNames.Contains(Text))
+			{
+				return Fail(FString::Printf(TEXT("%s of PSFState uses %s, which is declared after the first function that takes PSFState"), *InOutSymbol.OutName, *Text));
+			}
+		}
+	}
+
+	FPSFShaderType Element = InOutSymbol.Type;
+	Element.bArray = false;
+	FString Member = Element.ToGlsl() + TEXT(" ") + InOutSymbol.OutName;
+	FString Start;
+	if(InOutSymbol.Type.bArray)
+	{
+		if(SizeExpr == INDEX_NONE)
+		{
+			return Fail(FString::Printf(TEXT("mutable global array %s without a size"), *InOutSymbol.OutName));
+		}
+		const FString Size = PrintExpr(SizeExpr, false);
+		Member += TEXT("[") + Size + TEXT("]");
+		Start = Init != INDEX_NONE ? FString::Printf(TEXT("psf.%s = %s;"), *InOutSymbol.OutName, *PrintExpr(Init, false))
+			: FString::Printf(TEXT("for(int i = 0; i < %s; i++)\n    {\n        psf.%s[i] = %s;\n    }"), *Size, *InOutSymbol.OutName, *ZeroValue(Element));
+	}
+	else
+	{
+		// HLSL starts a static without a value at zero
+		Start = FString::Printf(TEXT("psf.%s = %s;"), *InOutSymbol.OutName, Init != INDEX_NONE ? *PrintExpr(Init, false) : *ZeroValue(Element));
+	}
+
+	Owner.StateMembers.Add(Member + TEXT(";"));
+	Owner.StateStarts.Add(Start);
+	InOutSymbol.bState = true;
+	return true;
+}
+
+bool FPSFChunkTranslator::TranslateStruct(FString &OutCode)
+{
+	++Cursor;
+	if(Peek().Type != ETokenType::Identifier)
+	{
+		return Fail(TEXT("anonymous struct"));
+	}
+	const FString Name = Peek().Text;
+	++Cursor;
+	if(!Expect(TEXT("{")))
+	{
+		return false;
+	}
+
+	TArray<FStructMember> Members;
+	while(!Accept(TEXT("}")))
+	{
+		if(!IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)))
+		{
+			return Fail(FString::Printf(TEXT("expected a member type before '%s'"), *Peek().Text));
+		}
+		const int32 TypeToken = Cursor++;
+		const FPSFShaderType Type = TypeAt(TypeToken);
+		Replacements.Add(TypeToken, Type.ToGlsl());
+		do
+		{
+			if(Peek().Type != ETokenType::Identifier)
+			{
+				return Fail(TEXT("expected a member name"));
+			}
+			FStructMember Member;
+			Member.Name = Peek().Text;
+			Member.Type = Type;
+			if(ToGlslIdentifier(Member.Name) != Member.Name)
+			{
+				Replacements.Add(Cursor, ToGlslIdentifier(Member.Name));
+			}
+			++Cursor;
+
+			int32 SizeExpr = INDEX_NONE;
+			if(!ParseArraySize(Member.Type, SizeExpr))
+			{
+				return false;
+			}
+			if(Member.Type.bArray && (SizeExpr == INDEX_NONE || !EvaluateInteger(SizeExpr, Member.ArraySize)))
+			{
+				// still declarable, only (Name) 0 needs the size
+				Member.ArraySize = -1;
+			}
+			if(IsAt(TEXT(":")))
+			{
+				Removed.Add(Cursor++);
+				Removed.Add(Cursor++);
+			}
+			Members.Add(Member);
+		}
+		while(Accept(TEXT(",")));
+		if(!Expect(TEXT(";")))
+		{
+			return false;
+		}
+	}
+	if(!Expect(TEXT(";")))
+	{
+		return false;
+	}
+
+	Owner.Structs.Add(Name, Members);
+	OutCode = PrintRange(0, Tokens.Num() - 1);
+	return true;
+}
+
+bool FPSFChunkTranslator::TranslateDeclaration(FString &OutCode)
+{
+	if(Peek().Type == ETokenType::End)
+	{
+		OutCode = Tokens[0].Leading;
+		return true;
+	}
+	if(IsAt(TEXT("struct")))
+	{
+		return TranslateStruct(OutCode);
+	}
+	if(IsAt(TEXT("cbuffer")) || IsAt(TEXT("tbuffer")) || IsAt(TEXT("typedef")))
+	{
+		return Fail(FString::Printf(TEXT("%s"), *Peek().Text));
+	}
+
+	// samplers are part of a GLSL sampler2D
+	if(IsAt(TEXT("SamplerState")) || IsAt(TEXT("SamplerComparisonState")))
+	{
+		++Cursor;
+		while(Peek().Type == ETokenType::Identifier)
+		{
+			FSymbol Symbol;
+			Symbol.Type = FPSFShaderType::Make(EPSFShaderBaseType::Sampler);
+			Symbol.OutName = Peek().Text;
+			Owner.Globals.Add(Peek().Text, Symbol);
+			++Cursor;
+			if(!Accept(TEXT(",")))
+			{
+				break;
+			}
+		}
+		OutCode = Tokens[0].Leading;
+		return Expect(TEXT(";"));
+	}
+
+	if(!ParseDeclaration(true) || !Expect(TEXT(";")))
+	{
+		return false;
+	}
+	if(Peek().Type != ETokenType::End)
+	{
+		return Fail(FString::Printf(TEXT("unexpected '%s' after the declaration"), *Peek().Text));
+	}
+	if(StateNames.Num() > 0)
+	{
+		OutCode = Tokens[0].Leading + FString::Printf(TEXT("// %s: in PSFState"), *FString::Join(StateNames, TEXT(", "))) + Tokens.Last().Leading;
+		return true;
+	}
+	OutCode = PrintRange(0, Tokens.Num() - 1);
+	return true;
+}
+
+bool FPSFChunkTranslator::TranslateMacroValue(FString &OutCode, FPSFShaderType &OutType, bool &bOutConstant)
+{
+	const int32 Index = ParseExpression();
+	if(Index == INDEX_NONE || Peek().Type != ETokenType::End || Exprs[Index].Kind == EExprKind::InitList)
+	{
+		return false;
+	}
+	OutType = Exprs[Index].Type;
+	bOutConstant = Exprs[Index].bConstant;
+	OutCode = PrintExpr(Index, false) + Tokens.Last().Leading;
+	return true;
+}
+
+bool FPSFChunkTranslator::TranslateDirective(FString &OutCode)
+{
+	const FToken &Token = Tokens[0];
+	if(Token.Type != ETokenType::Directive)
+	{
+		return Fail(TEXT("expected a directive"));
+	}
+
+	OutCode = Token.Leading + Token.Text + Tokens.Last().Leading;
+	FString Body = Token.Text.Mid(1).TrimStart();
+	int32 NameEnd = 0;
+	while(NameEnd < Body.Len() && IsIdentifierCharacter(Body[NameEnd]))
+	{
+		++NameEnd;
+	}
+	const FString Directive = Body.Left(NameEnd);
+	const FString Rest = Body.Mid(NameEnd).TrimStart();
+
+	if(Directive == TEXT("include"))
+	{
+		return Fail(FString::Printf(TEXT("include of %s"), *Rest));
+	}
+	if(Directive == TEXT("undef"))
+	{
+		Owner.Macros.Remove(Rest.TrimEnd());
+		Owner.MacroValues.Remove(Rest.TrimEnd());
+		return true;
+	}
+	if(Directive != TEXT("define"))
+	{
+		return true;
+	}
+
+	int32 MacroEnd = 0;
+	while(MacroEnd < Rest.Len() && IsIdentifierCharacter(Rest[MacroEnd]))
+	{
+		++MacroEnd;
+	}
+	const FString Name = Rest.Left(MacroEnd);
+	if(MacroEnd < Rest.Len() && Rest[MacroEnd] == TEXT('('))
+	{
+		return Fail(FString::Printf(TEXT("function-like macro %s"), *Name));
+	}
+
+	const FString Value = Rest.Mid(MacroEnd);
+	FSymbol Symbol;
+	Symbol.OutName = Name;
+	Owner.MacroValues.Add(Name, Value.TrimStartAndEnd());
+
+	// flags like include guards have no value and no type
+	FPSFChunkTranslator ValueTranslator(Owner, Value, Depth + 1);
+	FString Code;
+	if(!IsWhitespaceOnly(Value) && ValueTranslator.TranslateMacroValue(Code, Symbol.Type, Symbol.bConstant))
+	{
+		OutCode = Token.Leading + FString::Printf(TEXT("#define %s %s"), *Name, *Code.TrimStart()) + Tokens.Last().Leading;
+	}
+	if(ValueTranslator.bUsesState)
+	{
+		// the functions that expand it would not know that they take PSFState
+		Symbol.Unsupported = FString::Printf(TEXT("uses %s, a macro over PSFState"), *Name);
+	}
+	Owner.Macros.Add(Name, Symbol);
+	return true;
+}
+
+bool FPSFChunkTranslator::TranslateFunction(FString &OutCode)
+{
+	while(IsAt(TEXT("static")) || IsAt(TEXT("inline")) || IsAt(TEXT("precise")))
+	{
+		Removed.Add(Cursor++);
+	}
+	if(!IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)))
+	{
+		return Fail(FString::Printf(TEXT("expected a return type before '%s'"), *Peek().Text));
+	}
+	const int32 ReturnToken = Cursor++;
+	ReturnType = TypeAt(ReturnToken);
+	Replacements.Add(ReturnToken, ReturnType.ToGlsl());
+
+	if(Peek().Type != ETokenType::Identifier)
+	{
+		return Fail(TEXT("expected a function name"));
+	}
+	const int32 NameToken = Cursor++;
+	const FString Name = Tokens[NameToken].Text;
+	if(!Expect(TEXT("(")))
+	{
+		return false;
+	}
+
+	// parameters, printed from scratch so that samplers and defaults can be dropped
+	struct FParameterText
+	{
+		FString Declaration;
+		FString Name;
+		bool bDropped = false;
+	};
+	FFunction Function;
+	Function.ReturnType = ReturnType;
+	TArray<FParameterText> ParameterTexts;
+	Scopes.AddDefaulted();
+	while(!Accept(TEXT(")")))
+	{
+		FParameter Parameter;
+		FString Qualifier;
+		while(Peek().Type == ETokenType::Identifier && !IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)))
+		{
+			const FString &Text = Peek().Text;
+			if(Text == TEXT("out") || Text == TEXT("inout"))
+			{
+				Parameter.bOut = true;
+				Qualifier = Text + TEXT(" ");
+			}
+			else if(Text == TEXT("in") || Text == TEXT("const") || Text == TEXT("uniform") || Text == TEXT("precise"))
+			{
+			}
+			else
+			{
+				return Fail(FString::Printf(TEXT("parameter qualifier %s"), *Text));
+			}
+			++Cursor;
+		}
+		if(!IsTypeAt(FMath::Min(Cursor, Tokens.Num() - 1)))
+		{
+			return Fail(FString::Printf(TEXT("expected a parameter type before '%s'"), *Peek().Text));
+		}
+		Parameter.Type = TypeAt(Cursor++);
+		if(Peek().Type != ETokenType::Identifier)
+		{
+			return Fail(TEXT("expected a parameter name"));
+		}
+		Parameter.Name = Peek().Text;
+		++Cursor;
+
+		int32 SizeExpr = INDEX_NONE;
+		if(!ParseArraySize(Parameter.Type, SizeExpr))
+		{
+			return false;
+		}
+		if(IsAt(TEXT(":")))
+		{
+			Cursor += 2;
+		}
+		if(Accept(TEXT("=")))
+		{
+			const int32 Default = ParseAssignment();
+			if(Default == INDEX_NONE)
+			{
+				return false;
+			}
+			Convert(Default, Parameter.Type);
+			Parameter.Default = PrintExpr(Default, false);
+		}
+
+		FParameterText Text;
+		Text.Name = ToGlslIdentifier(Parameter.Name);
+		Text.bDropped = Parameter.Type.Base == EPSFShaderBaseType::Sampler;
+		Text.Declaration = Qualifier + Parameter.Type.ToGlsl() + TEXT(" ") + Text.Name;
+		if(Parameter.Type.bArray)
+		{
+			Text.Declaration += TEXT("[") + (SizeExpr != INDEX_NONE ? PrintExpr(SizeExpr, false) : FString()) + TEXT("]");
+		}
+		ParameterTexts.Add(Text);
+
+		FSymbol Symbol;
+		Symbol.Type = Parameter.Type;
+		Symbol.OutName = Text.Name;
+		Scopes.Last().Add(Parameter.Name, Symbol);
+		Function.Parameters.Add(Parameter);
+
+		if(!IsAt(TEXT(")")) && !Expect(TEXT(",")))
+		{
+			return false;
+		}
+	}
+	if(IsAt(TEXT(":")))
+	{
+		Cursor += 2;
+	}
+	if(!IsAt(TEXT("{")))
+	{
+		return Fail(TEXT("function without a body"));
+	}
+
+	// an overload gets its own name in Godot, the first one keeps the HLSL name
+	TArray<FFunction> &Overloads = Owner.Functions.FindOrAdd(Name);
+	int32 OverloadIndex = INDEX_NONE;
+	for(int32 Index = 0; Index < Overloads.Num(); ++Index)
+	{
+		bool bSame = Overloads[Index].Parameters.Num() == Function.Parameters.Num();
+		for(int32 Parameter = 0; bSame && Parameter < Function.Parameters.Num(); ++Parameter)
+		{
+			bSame = Overloads[Index].Parameters[Parameter].Type == Function.Parameters[Parameter].Type;
+		}
+		if(bSame)
+		{
+			OverloadIndex = Index;
+		}
+	}
+	if(OverloadIndex == INDEX_NONE)
+	{
+		Function.OutName = ToGlslIdentifier(Name);
+		if(Owner.Dialect == EPSFShaderDialect::Godot && Overloads.Num() > 0)
+		{
+			for(const FParameter &Parameter : Function.Parameters)
+			{
+				Function.OutName += TEXT("_") + (Parameter.Type.IsKnown() ? Parameter.Type.ToGlsl() : FString(TEXT("s")));
+			}
+		}
+		OverloadIndex = Overloads.Add(Function);
+	}
+	const FString OutName = Overloads[OverloadIndex].OutName;
+	const int32 BodyFirst = Cursor;
+
+	if(!ParseBlock())
+	{
+		Owner.Functions.FindOrAdd(Name)[OverloadIndex].Unsupported = Error;
+		return false;
+	}
+	if(Peek().Type != ETokenType::End)
+	{
+		return Fail(FString::Printf(TEXT("unexpected '%s' after the function"), *Peek().Text));
+	}
+	Owner.Functions.FindOrAdd(Name)[OverloadIndex].Unsupported.Reset();
+
+	TArray<FString> Declarations;
+	if(bUsesState)
+	{
+		for(const FParameter &Parameter : Function.Parameters)
+		{
+			if(Parameter.Name == TEXT("psf"))
+			{
+				return Fail(TEXT("parameter psf, the name of PSFState"));
+			}
+		}
+		Declarations.Add(TEXT("inout PSFState psf"));
+		Owner.Functions.FindOrAdd(Name)[OverloadIndex].bState = true;
+		if(!Owner.bStateUsed)
+		{
+			Owner.bStateUsed = true;
+			for(const auto &Pair : Owner.Structs)
+			{
+				Owner.StateKnownNames.Add(Pair.Key);
+			}
+			for(const auto &Pair : Owner.Macros)
+			{
+				Owner.StateKnownNames.Add(Pair.Key);
+			}
+			for(const auto &Pair : Owner.Globals)
+			{
+				Owner.StateKnownNames.Add(Pair.Key);
+			}
+		}
+	}
+	TArray<FString> Names;
+	for(const FParameterText &Text : ParameterTexts)
+	{
+		if(!Text.bDropped)
+		{
+			Declarations.Add(Text.Declaration);
+		}
+		Names.Add(Text.bDropped ? FString() : Text.Name);
+	}
+
+	FString Code = PrintRange(0, ReturnToken);
+	Code += TEXT(" ") + OutName + TEXT("(") + FString::Join(Declarations, TEXT(", ")) + TEXT(")");
+	Code += PrintRange(BodyFirst, Tokens.Num() - 1);
+
+	// GLSL: default arguments become overloads that forward to the full signature
+	if(Owner.Dialect == EPSFShaderDialect::GLSL)
+	{
+		for(int32 Count = Function.Parameters.Num() - 1; Count >= Function.GetRequiredParameters(); --Count)
+		{
+			TArray<FString> ForwardDeclarations;
+			TArray<FString> Arguments;
+			for(int32 Parameter = 0; Parameter < Function.Parameters.Num(); ++Parameter)
+			{
+				if(ParameterTexts[Parameter].bDropped)
+				{
+					continue;
+				}
+				if(Parameter < Count)
+				{
+					ForwardDeclarations.Add(ParameterTexts[Parameter].Declaration);
+					Arguments.Add(ParameterTexts[Parameter].Name);
+				}
+				else
+				{
+					Arguments.Add(Function.Parameters[Parameter].Default);
+				}
+			}
+			Code += FString::Printf(TEXT("\n\n%s %s(%s)\n{\n    %s%s(%s);\n}"), *ReturnType.ToGlsl(), *OutName, *FString::Join(ForwardDeclarations, TEXT(", ")),
+				ReturnType.Base == EPSFShaderBaseType::Void ? TEXT("") : TEXT("return "), *OutName, *FString::Join(Arguments, TEXT(", ")));
+		}
+	}
+	OutCode = Code;
+	return true;
+}
+
+FString FPSFChunkTranslator::ZeroValue(const FPSFShaderType &Type)
+{
+	if(Type.Base == EPSFShaderBaseType::Struct)
+	{
+		const TArray<FStructMember> *Members = Owner.Structs.Find(Type.StructName);
+		TArray<FString> Values;
+		for(const FStructMember &Member : Members ? *Members : TArray<FStructMember>())
+		{
+			if(!Member.Type.bArray)
+			{
+				Values.Add(ZeroValue(Member.Type));
+				continue;
+			}
+
+			FPSFShaderType Element = Member.Type;
+			Element.bArray = false;
+			TArray<FString> Elements;
+			for(int32 Index = 0; Index < Member.ArraySize; ++Index)
+			{
+				Elements.Add(ZeroValue(Element));
+			}
+			if(Member.ArraySize < 0)
+			{
+				Fail(FString::Printf(TEXT("(%s) 0 with an array member of unknown size"), *Type.StructName));
+			}
+			Values.Add(FString::Printf(TEXT("%s[%d](%s)"), *Element.ToGlsl(), Member.ArraySize, *FString::Join(Elements, TEXT(", "))));
+		}
+		return FString::Printf(TEXT("%s(%s)"), *Type.StructName, *FString::Join(Values, TEXT(", ")));
+	}
+
+	const TCHAR *Scalar = Type.Base == EPSFShaderBaseType::Bool ? TEXT("false") : Type.Base == EPSFShaderBaseType::Float ? TEXT("0.0") : Type.Base == EPSFShaderBaseType::UInt ? TEXT("0u") : TEXT("0");
+	return Type.IsScalar() ? FString(Scalar) : FString::Printf(TEXT("%s(%s)"), *Type.ToGlsl(), Scalar);
+}
+
+FString FPSFChunkTranslator::PrintToken(int32 TokenIndex, bool bLeading) const
+{
+	const FToken &Token = Tokens[TokenIndex];
+	const FString *Replacement = Replacements.Find(TokenIndex);
+	return (bLeading ? Token.Leading : FString()) + (Replacement ? *Replacement : Token.Text);
+}
+
+FString FPSFChunkTranslator::PrintExpr(int32 Index, bool bLeading)
+{
+	FString Body = PrintBody(Index);
+	const FExpr &Expr = Exprs[Index];
+	if(Expr.bConvert)
+	{
+		const FPSFShaderType &From = Expr.Type;
+		const FPSFShaderType &To = Expr.ConvertTo;
+		if(To.Base == EPSFShaderBaseType::Bool && From.Base != EPSFShaderBaseType::Bool)
+		{
+			// HLSL tests against zero
+			Body = To.IsVector() ? FString::Printf(TEXT("notEqual(%s, %s)"), *Body, *ZeroValue(From)) : FString::Printf(TEXT("(%s != %s)"), *Body, *ZeroValue(From));
+		}
+		else if(From.IsVector() && To.Rows < From.Rows)
+		{
+			// truncation, wrapped if the base changes too
+			const bool bAtom = Expr.Kind == EExprKind::Identifier || Expr.Kind == EExprKind::Call || Expr.Kind == EExprKind::Member || Expr.Kind == EExprKind::Index || Expr.Kind == EExprKind::Paren || Expr.Kind == EExprKind::Method;
+			const FString Swizzle = FString(TEXT("xyzw")).Left(To.Rows);
+			Body = (bAtom ? Body : FString::Printf(TEXT("(%s)"), *Body)) + TEXT(".") + Swizzle;
+			if(From.Base != To.Base)
+			{
+				Body = FString::Printf(TEXT("%s(%s)"), *To.ToGlsl(), *Body);
+			}
+		}
+		else
+		{
+			Body = FString::Printf(TEXT("%s(%s)"), *To.ToGlsl(), *Body);
+		}
+	}
+	return bLeading ? Tokens[Expr.First].Leading + Body : Body;
+}
+
+FString FPSFChunkTranslator::PrintBody(int32 Index)
+{
+	const FExpr Expr = Exprs[Index];
+	const auto Child = [this, &Expr](int32 Position)
+	{
+		return PrintExpr(Expr.Children[Position], false);
+	};
+
+	// an argument that becomes the operand of an operator, mul(m, a - b) -> ((a - b) * m)
+	const auto Operand = [this, &Expr, &Child](int32 Position)
+	{
+		const FExpr &Argument = Exprs[Expr.Children[Position]];
+		const bool bAtom = Argument.bConvert || Argument.Kind == EExprKind::Literal || Argument.Kind == EExprKind::Identifier || Argument.Kind == EExprKind::Call
+			|| Argument.Kind == EExprKind::Member || Argument.Kind == EExprKind::Index || Argument.Kind == EExprKind::Paren || Argument.Kind == EExprKind::Method
+			|| Argument.Kind == EExprKind::Unary || Argument.Kind == EExprKind::Postfix;
+		return bAtom ? Child(Position) : FString::Printf(TEXT("(%s)"), *Child(Position));
+	};
+
+	switch(Expr.Rewrite)
+	{
+	case ERewrite::Saturate:
+		return FString::Printf(TEXT("clamp(%s, 0.0, 1.0)"), *Child(0));
+	case ERewrite::Mul:
+		return FString::Printf(TEXT("(%s * %s)"), *Operand(1), *Operand(0));
+	case ERewrite::Mad:
+		return FString::Printf(TEXT("(%s * %s + %s)"), *Operand(0), *Operand(1), *Operand(2));
+	case ERewrite::Rcp:
+		return FString::Printf(TEXT("(1.0 / %s)"), *Operand(0));
+	case ERewrite::Log10:
+		return FString::Printf(TEXT("(log2(%s) * 0.30102999566)"), *Child(0));
+	case ERewrite::Unwrap:
+		return Child(0);
+	case ERewrite::ZeroStruct:
+		return ZeroValue(Expr.Type);
+	case ERewrite::Cast:
+		return FString::Printf(TEXT("%s(%s)"), *Expr.Type.ToGlsl(), *Child(0));
+	case ERewrite::BinaryCall:
+		return FString::Printf(TEXT("%s(%s, %s)"), *Expr.Name, *Child(0), *Child(1));
+	case ERewrite::ScalarSwizzle:
+		return Expr.Type.IsScalar() ? Child(0) : FString::Printf(TEXT("%s(%s)"), *Expr.Type.ToGlsl(), *Child(0));
+	case ERewrite::TexelFetch:
+	{
+		// int3(x, y, mip) -> ivec2(x, y), mip
+		const FExpr &Location = Exprs[Expr.Children[1]];
+		const int32 Dimensions = Exprs[Expr.Children[0]].Type.Base == EPSFShaderBaseType::Texture2D ? 2 : 3;
+		if(Location.Kind == EExprKind::Call && Location.Rewrite == ERewrite::None && Location.Type.IsVector() && !Location.bConvert && Location.Children.Num() == Dimensions + 1)
+		{
+			TArray<FString> Coordinates;
+			for(int32 Position = 0; Position < Dimensions; ++Position)
+			{
+				Coordinates.Add(PrintExpr(Location.Children[Position], false));
+			}
+			return FString::Printf(TEXT("texelFetch(%s, ivec%d(%s), %s)"), *Child(0), Dimensions, *FString::Join(Coordinates, TEXT(", ")), *PrintExpr(Location.Children[Dimensions], false));
+		}
+		const FString Value = Child(1);
+		const TCHAR *Swizzle = Dimensions == 2 ? TEXT("xy") : TEXT("xyz");
+		const TCHAR *Mip = Dimensions == 2 ? TEXT("z") : TEXT("w");
+		return FString::Printf(TEXT("texelFetch(%s, (%s).%s, (%s).%s)"), *Child(0), *Value, Swizzle, *Value, Mip);
+	}
+	case ERewrite::Texture:
+		return FString::Printf(TEXT("texture(%s, %s)"), *Child(0), *Child(2));
+	case ERewrite::TextureLod:
+		return FString::Printf(TEXT("textureLod(%s, %s, %s)"), *Child(0), *Child(2), *Child(3));
+	case ERewrite::TextureGrad:
+		return FString::Printf(TEXT("textureGrad(%s, %s, %s, %s)"), *Child(0), *Child(2), *Child(3), *Child(4));
+	case ERewrite::Dimensions:
+	{
+		TArray<FString> Assignments;
+		for(int32 Position = 1; Position < Expr.Children.Num(); ++Position)
+		{
+			const FPSFShaderType &Type = Exprs[Expr.Children[Position]].Type;
+			const FString Size = FString::Printf(TEXT("textureSize(%s, 0).%c"), *Child(0), TEXT("xyz")[Position - 1]);
+			const bool bInt = Type.Base == EPSFShaderBaseType::Int && Type.IsScalar();
+			Assignments.Add(FString::Printf(TEXT("%s = %s"), *Child(Position), bInt ? *Size : *FString::Printf(TEXT("%s(%s)"), *Type.ToGlsl(), *Size)));
+		}
+		return FString::Printf(TEXT("(%s)"), *FString::Join(Assignments, TEXT(", ")));
+	}
+	case ERewrite::Arguments:
+	{
+		TArray<FString> Arguments;
+		if(Expr.bPassState)
+		{
+			Arguments.Add(TEXT("psf"));
+		}
+		for(const int32 Argument : Expr.Children)
+		{
+			if(!Expr.Dropped.Contains(Argument))
+			{
+				Arguments.Add(PrintExpr(Argument, Arguments.Num() > 0).TrimStart());
+			}
+		}
+		Arguments.Append(Expr.Extra);
+		return FString::Printf(TEXT("%s(%s)"), *Expr.Name, *FString::Join(Arguments, TEXT(", ")));
+	}
+	default:
+		break;
+	}
+
+	if(Expr.Kind == EExprKind::InitList)
+	{
+		// {a, b} -> float[2](a, b)
+		FString Text = FString::Printf(TEXT("%s[%s]("), *Expr.Name, Expr.Size != INDEX_NONE ? *PrintExpr(Expr.Size, false) : TEXT(""));
+		for(int32 Position = 0; Position < Expr.Children.Num(); ++Position)
+		{
+			Text += (Position > 0 ? TEXT(",") : TEXT("")) + PrintExpr(Expr.Children[Position], Position > 0);
+		}
+		return Text + Tokens[Expr.Last].Leading + TEXT(")");
+	}
+
+	// the tokens with the children printed in place
+	TArray<int32> Children = Expr.Children;
+	Children.Sort([this](int32 A, int32 B)
+	{
+		return Exprs[A].First < Exprs[B].First;
+	});
+	FString Text;
+	int32 Next = 0;
+	for(int32 TokenIndex = Expr.First; TokenIndex <= Expr.Last;)
+	{
+		if(Next < Children.Num() && Exprs[Children[Next]].First == TokenIndex)
+		{
+			Text += PrintExpr(Children[Next], TokenIndex != Expr.First);
+			TokenIndex = Exprs[Children[Next]].Last + 1;
+			++Next;
+			continue;
+		}
+		Text += PrintToken(TokenIndex, TokenIndex != Expr.First);
+		++TokenIndex;
+	}
+	return Text;
+}
+
+FString FPSFChunkTranslator::PrintRange(int32 First, int32 Last)
+{
+	FString Text;
+	FString Pending;
+	bool bAfterRemoved = false;
+	for(int32 TokenIndex = First; TokenIndex <= Last;)
+	{
+		const FToken &Token = Tokens[TokenIndex];
+		if(Removed.Contains(TokenIndex))
+		{
+			if(!bAfterRemoved)
+			{
+				Pending = Token.Leading;
+			}
+			else if(!IsWhitespaceOnly(Token.Leading))
+			{
+				Pending += Token.Leading;
+			}
+			bAfterRemoved = true;
+			++TokenIndex;
+			continue;
+		}
+
+		FString Leading = Token.Leading;
+		if(bAfterRemoved)
+		{
+			// keep one of the two line breaks or spaces around what was removed
+			const bool bNewLine = Leading.Contains(TEXT("\n"));
+			Leading = bNewLine && IsWhitespaceOnly(Pending) ? Leading : Pending + (IsWhitespaceOnly(Leading) && !bNewLine ? FString() : Leading);
+			bAfterRemoved = false;
+		}
+
+		if(const int32 *Root = Roots.Find(TokenIndex))
+		{
+			Text += Leading + PrintExpr(*Root, false);
+			TokenIndex = Exprs[*Root].Last + 1;
+			continue;
+		}
+		Text += Leading + PrintToken(TokenIndex, false);
+		++TokenIndex;
+	}
+	return bAfterRemoved ? Text + Pending : Text;
+}
+
+FPSFShaderTranslator::FPSFShaderTranslator(EPSFShaderDialect InDialect)
+	: Dialect(InDialect)
+{
+}
+
+FPSFShaderTranslator::~FPSFShaderTranslator() = default;
+
+bool FPSFShaderTranslator::Translate(const FPSFShaderChunk &Chunk, FString &OutCode, FString &OutError)
+{
+	FPSFChunkTranslator Translator(*this, Chunk.Text);
+	bool bTranslated = false;
+	switch(Chunk.Type)
+	{
+	case EPSFShaderChunkType::Preprocessor:
+		bTranslated = Translator.TranslateDirective(OutCode);
+		break;
+	case EPSFShaderChunkType::Declaration:
+		bTranslated = Translator.TranslateDeclaration(OutCode);
+		break;
+	case EPSFShaderChunkType::Function:
+		bTranslated = Translator.TranslateFunction(OutCode);
+		break;
+	}
+	OutError = bTranslated ? FString() : Translator.Error;
+	return bTranslated;
+}
+
+FString FPSFShaderTranslator::GetStateDeclaration() const
+{
+	if(StateMembers.Num() == 0)
+	{
+		return FString();
+	}
+
+	FString Code = TEXT("// the mutable globals of the library, Godot has none: start with psfState() and pass it to the functions that take it\nstruct PSFState\n{\n");
+	for(const FString &Member : StateMembers)
+	{
+		Code += TEXT("    ") + Member + TEXT("\n");
+	}
+	Code += TEXT("};\n\nPSFState psfState()\n{\n    PSFState psf;\n");
+	for(const FString &Start : StateStarts)
+	{
+		Code += TEXT("    ") + Start + TEXT("\n");
+	}
+	return Code + TEXT("    return psf;\n}");
+}
+
+FString FPSFShaderTranslator::GetPrelude() const
+{
+	FString Prelude;
+	if(bUsesPI && Dialect == EPSFShaderDialect::GLSL)
+	{
+		Prelude += TEXT("#ifndef PI\n#define PI 3.14159265358979\n#endif\n\n");
+	}
+
+	bool bFirst = true;
+	for(int32 Size = 1; Size <= 4; ++Size)
+	{
+		if(!FmodSizes.Contains(Size))
+		{
+			continue;
+		}
+		if(bFirst)
+		{
+			Prelude += TEXT("// fmod of HLSL, the result has the sign of x where mod has the sign of y\n");
+			bFirst = false;
+		}
+		const FString Type = FPSFShaderType::Make(EPSFShaderBaseType::Float, Size).ToGlsl();
+		Prelude += FString::Printf(TEXT("%s %s(%s x, %s y)\n{\n    return x - y * trunc(x / y);\n}\n\n"), *Type, FmodNames[Size - 1], *Type, *Type);
+	}
+	return Prelude;
+}
@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPSFShaderChunk;
+class FPSFChunkTranslator;
+
+/** HLSL identifiers are case-sensitive, FString keys of a TMap are not by default */
+template<typename ValueType>
+struct TPSFCaseSensitiveKeyFuncs : BaseKeyFuncs<TPair<FString, ValueType>, FString, false>
+{
+	static const FString &GetSetKey(const TPair<FString, ValueType> &Element)
+	{
+		return Element.Key;
+	}
+
+	static bool Matches(const FString &A, const FString &B)
+	{
+		return A.Equals(B, ESearchCase::CaseSensitive);
+	}
+
+	static uint32 GetKeyHash(const FString &Key)
+	{
+		return FCrc::StrCrc32(*Key);
+	}
+};
+
+template<typename ValueType>
+using TPSFIdentifierMap = TMap<FString, ValueType, FDefaultSetAllocator, TPSFCaseSensitiveKeyFuncs<ValueType>>;
+
+/** Shading language the translator writes */
+enum class EPSFShaderDialect : uint8
+{
+	/** GLSL ES 3.0, the dialect of the shaders/ library and of Shadertoy */
+	GLSL,
+
+	/** Godot's shading language: GLSL without mutable globals and without overloaded functions, see GetStateDeclaration */
+	Godot
+};
+
+enum class EPSFShaderBaseType : uint8
+{
+	Unknown,
+	Void,
+	Bool,
+	Int,
+	UInt,
+	Float,
+	Struct,
+	Texture2D,
+	Texture3D,
+	TextureCube,
+	Sampler
+};
+
+/** Type of an expression, HLSL shapes: a floatRxC matrix has R rows of C components */
+struct FPSFShaderType
+{
+	EPSFShaderBaseType Base = EPSFShaderBaseType::Unknown;
+
+	/** Components of a vector, rows of a matrix */
+	int32 Rows = 1;
+
+	/** 0 for scalars and vectors */
+	int32 Columns = 0;
+
+	FString StructName;
+	bool bArray = false;
+
+	/** Builtin HLSL type by name (float3, int, float3x3, Texture2D ...), Unknown for anything else */
+	static FPSFShaderType FromHlsl(const FString &Name);
+
+	static FPSFShaderType Make(EPSFShaderBaseType Base, int32 Rows = 1, int32 Columns = 0);
+
+	bool IsKnown() const
+	{
+		return Base != EPSFShaderBaseType::Unknown;
+	}
+
+	bool IsNumeric() const
+	{
+		return !bArray && (Base == EPSFShaderBaseType::Int || Base == EPSFShaderBaseType::UInt || Base == EPSFShaderBaseType::Float);
+	}
+
+	bool IsScalar() const
+	{
+		return (IsNumeric() || (!bArray && Base == EPSFShaderBaseType::Bool)) && Rows == 1 && Columns == 0;
+	}
+
+	bool IsVector() const
+	{
+		return !bArray && Rows > 1 && Columns == 0;
+	}
+
+	bool IsMatrix() const
+	{
+		return !bArray && Columns > 0;
+	}
+
+	bool operator==(const FPSFShaderType &Other) const
+	{
+		return Base == Other.Base && Rows == Other.Rows && Columns == Other.Columns && bArray == Other.bArray && StructName == Other.StructName;
+	}
+
+	bool operator!=(const FPSFShaderType &Other) const
+	{
+		return !(*this == Other);
+	}
+
+	/** GLSL spelling, matrices keep the HLSL dimensions since an HLSL row is stored as a GLSL column */
+	FString ToGlsl() const;
+};
+
+struct FPSFTranslationStats
+{
+	/** HLSL intrinsics written as the native GLSL function or operator */
+	int32 IntrinsicsMapped = 0;
+
+	/** Calls without a native equivalent that go through a psf_ helper, fmod is the only one */
+	int32 EmulatedCalls = 0;
+
+	/** Conversions that HLSL does implicitly and GLSL needs spelled out */
+	int32 Conversions = 0;
+};
+
+/**
+ * Translates the top level chunks of the framework's HLSL to GLSL, one chunk at a time in include order.
+ *
+ * This is not a general HLSL compiler. It parses the subset the library is written in (structs, globals, functions,
+ * statements and expressions) and types every expression, so that what HLSL does implicitly can be written out:
+ * int literals in float math, scalars assigned to vectors, truncation, vector comparisons, default arguments.
+ * Matrices keep their constructor arguments and mul(a, b) becomes b * a, so an HLSL row is a GLSL column and
+ * indexing a matrix returns the same vector in both languages.
+ *
+ * A chunk that uses something the dialect has no equivalent for fails with a reason, and so does every later chunk
+ * that references it.
+ *
+ * Godot has no mutable globals. They become the members of a struct PSFState, and a function that reads or writes one,
+ * or calls a function that does, takes it as its first parameter "inout PSFState psf".
+ */
+class FPSFShaderTranslator
+{
+public:
+	explicit FPSFShaderTranslator(EPSFShaderDialect InDialect);
+	~FPSFShaderTranslator();
+
+	/** Declares and translates a chunk, false with the reason in OutError if it can not be expressed in the dialect */
+	bool Translate(const FPSFShaderChunk &Chunk, FString &OutCode, FString &OutError);
+
+	/** Helper functions and constants used by the chunks translated so far, goes in front of them */
+	FString GetPrelude() const;
+
+	/** Whether a translated function takes PSFState, the first one that does needs GetStateDeclaration in front of it */
+	bool UsesState() const
+	{
+		return bStateUsed;
+	}
+
+	/** PSFState and psfState(), which returns it with the start values the globals have in HLSL */
+	FString GetStateDeclaration() const;
+
+	const FPSFTranslationStats &GetStats() const
+	{
+		return Stats;
+	}
+
+private:
+	friend class FPSFChunkTranslator;
+
+	struct FSymbol
+	{
+		FPSFShaderType Type;
+		bool bConstant = false;
+
+		/** Name in the output, differs from the HLSL name for GLSL keywords */
+		FString OutName;
+
+		/** Why the symbol can not be used in this dialect, empty if it can */
+		FString Unsupported;
+
+		/** A mutable global that is a member of PSFState */
+		bool bState = false;
+	};
+
+	struct FStructMember
+	{
+		FString Name;
+		FPSFShaderType Type;
+
+		/** Element count of an array member */
+		int32 ArraySize = 0;
+	};
+
+	struct FParameter
+	{
+		FString Name;
+		FPSFShaderType Type;
+		bool bOut = false;
+
+		/** Translated default value, empty if the parameter has none */
+		FString Default;
+	};
+
+	struct FFunction
+	{
+		FString OutName;
+		FPSFShaderType ReturnType;
+		TArray<FParameter> Parameters;
+		FString Unsupported;
+
+		/** Takes PSFState in front of its parameters */
+		bool bState = false;
+
+		int32 GetRequiredParameters() const;
+	};
+
+	EPSFShaderDialect Dialect;
+
+	TPSFIdentifierMap<FSymbol> Globals;
+	TPSFIdentifierMap<FSymbol> Macros;
+
+	/** Macro values as written, for array sizes */
+	TPSFIdentifierMap<FString> MacroValues;
+
+	TPSFIdentifierMap<TArray<FStructMember>> Structs;
+
+	/** Overloads in declaration order */
+	TPSFIdentifierMap<TArray<FFunction>> Functions;
+
+	/** Members of PSFState and the statements of psfState() that set them */
+	TArray<FString> StateMembers;
+	TArray<FString> StateStarts;
+
+	/** Structs, macros and globals declared before the first function that takes PSFState, a later member can not use others */
+	TSet<FString> StateKnownNames;
+	bool bStateUsed = false;
+
+	/** Vector sizes psf_fmod is used with, 1 for scalars */
+	TSet<int32> FmodSizes;
+	bool bUsesPI = false;
+
+	FPSFTranslationStats Stats;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTimelineComponent.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+UPSFTimelineComponent::UPSFTimelineComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	bTickInEditor = true;
+}
+
+void UPSFTimelineComponent::BindMaterial(UMaterialInstanceDynamic *Material)
+{
+	if(Material)
+	{
+		BoundMaterials.AddUnique(Material);
+	}
+}
+
+void UPSFTimelineComponent::ApplyTracks(float Time)
+{
+	UWorld *World = GetWorld();
+	UMaterialParameterCollectionInstance *Collection = World && ParameterCollection ? World->GetParameterCollectionInstance(ParameterCollection) : nullptr;
+
+	for(const FPSFTimelineTrack &Track : Tracks)
+	{
+		if(Track.Parameter.IsNone())
+		{
+			continue;
+		}
+
+		const FVector4f Value = Track.Evaluate(Time);
+		const FLinearColor Color(Value.X, Value.Y, Value.Z, 1.0f);
+		const FName AngleParameter = Track.Type == EPSFTimelineTrackType::Orbit ? FName(*(Track.Parameter.ToString() + TEXT("Angle"))) : NAME_None;
+
+		// the collection ignores (and logs) parameters it does not have, an instance only sets the ones its material uses
+		if(Collection)
+		{
+			if(Track.bScalar)
+			{
+				Collection->SetScalarParameterValue(Track.Parameter, Value.X);
+			}
+			else
+			{
+				Collection->SetVectorParameterValue(Track.Parameter, Color);
+			}
+			if(!AngleParameter.IsNone())
+			{
+				Collection->SetScalarParameterValue(AngleParameter, Value.W);
+			}
+		}
+		for(UMaterialInstanceDynamic *Material : BoundMaterials)
+		{
+			if(!Material)
+			{
+				continue;
+			}
+			if(Track.bScalar)
+			{
+				Material->SetScalarParameterValue(Track.Parameter, Value.X);
+			}
+			else
+			{
+				Material->SetVectorParameterValue(Track.Parameter, Color);
+			}
+			if(!AngleParameter.IsNone())
+			{
+				Material->SetScalarParameterValue(AngleParameter, Value.W);
+			}
+		}
+	}
+}
+
+void UPSFTimelineComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// the time of the Time material expression, so that tracks and per pixel tweens stay in sync
+	const UWorld *World = GetWorld();
+	ApplyTracks(World ? World->GetTimeSeconds() : 0.0f);
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// The track evaluation needs no engine objects, it is apart from the component so that it builds without them
+
+#include "PSFTimelineComponent.h"
+#include "PSFAnimation.h"
+#include "PSFTween.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	/** Tweens between the keys around Time, holds the first and last key outside of them */
+	FVector3f EvaluateKeys(const TArray<FPSFTweenKey> &Keys, bool bLoop, float Time)
+	{
+		if(Keys.Num() == 0)
+		{
+			return FVector3f::ZeroVector;
+		}
+
+		const float FirstTime = Keys[0].Time;
+		const float Length = Keys.Last().Time - FirstTime;
+		if(bLoop && Length > 0.0f && Time > FirstTime)
+		{
+			Time = FirstTime + FMod(Time - FirstTime, Length);
+		}
+
+		if(Time <= FirstTime || Keys.Num() == 1)
+		{
+			return FVector3f(Keys[0].Value);
+		}
+
+		for(int32 Index = 0; Index + 1 < Keys.Num(); ++Index)
+		{
+			const FPSFTweenKey &Key = Keys[Index];
+			const FPSFTweenKey &Next = Keys[Index + 1];
+			if(Time < Next.Time)
+			{
+				const float Progress = Next.Time > Key.Time ? (Time - Key.Time) / (Next.Time - Key.Time) : 1.0f;
+				return Lerp(FVector3f(Key.Value), FVector3f(Next.Value), PSFTween::ApplyTweenFunction(Progress, Key.TweenType));
+			}
+		}
+		return FVector3f(Keys.Last().Value);
+	}
+}
+
+FVector4f FPSFTimelineTrack::Evaluate(float Time) const
+{
+	switch(Type)
+	{
+	case EPSFTimelineTrackType::Tween:
+		return FVector4f(PSFTween::Tween3D(FVector3f(Start), FVector3f(End), Duration, TweenType, StartTime, bPingPong, Time), 0.0f);
+	case EPSFTimelineTrackType::Keyframes:
+		return FVector4f(EvaluateKeys(Keys, bLoop, Time), 0.0f);
+	case EPSFTimelineTrackType::Orbit:
+	{
+		float Angle = 0.0f;
+		const FVector3f Position = PSFAnimation::OrbitObjectAroundPoint(FVector3f(Start), FVector3f(Center), FVector3f(Axis), Radius, Speed, AngleOffset, Time, Angle);
+		return FVector4f(Position, Angle);
+	}
+	case EPSFTimelineTrackType::Shake:
+		return FVector4f(PSFAnimation::ShakeObject(FVector3f(Start), Intensity, Speed, Time), 0.0f);
+	case EPSFTimelineTrackType::CycleColor:
+		return FVector4f(PSFAnimation::CycleColor(FVector3f(Start), Speed, Time), 0.0f);
+	default:
+		return FVector4f(FVector3f(Start), 0.0f);
+	}
+}
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTween.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	float BounceEaseOut(float P)
+	{
+		if(P < 4.0f / 11.0f)
+		{
+			return (121.0f * P * P) / 16.0f;
+		}
+		if(P < 8.0f / 11.0f)
+		{
+			return (363.0f / 40.0f * P * P) - (99.0f / 10.0f * P) + 17.0f / 5.0f;
+		}
+		if(P < 9.0f / 10.0f)
+		{
+			return (4356.0f / 361.0f * P * P) - (35442.0f / 1805.0f * P) + 16061.0f / 1805.0f;
+		}
+		return (54.0f / 5.0f * P * P) - (513.0f / 25.0f * P) + 268.0f / 25.0f;
+	}
+
+	float BounceEaseIn(float P)
+	{
+		return 1.0f - BounceEaseOut(1.0f - P);
+	}
+
+	float BounceEaseInOut(float P)
+	{
+		return P < 0.5f ? 0.5f * BounceEaseIn(P * 2.0f) : 0.5f * BounceEaseOut(P * 2.0f - 1.0f) + 0.5f;
+	}
+}
+
+float PSFTween::ApplyTweenFunction(float T, int32 TweenType)
+{
+	switch(TweenType)
+	{
+	case 0:
+		return T;
+	case 1:
+		return T * T;
+	case 2:
+		return -(T * (T - 2.0f));
+	case 3:
+		return T < 0.5f ? 2.0f * T * T : (-2.0f * T * T) + (4.0f * T) - 1.0f;
+	case 4:
+		return T * T * T;
+	case 5:
+	{
+		const float F = T - 1.0f;
+		return F * F * F + 1.0f;
+	}
+	case 6:
+	{
+		if(T < 0.5f)
+		{
+			return 4.0f * T * T * T;
+		}
+		const float F = 2.0f * T - 2.0f;
+		return 0.5f * F * F * F + 1.0f;
+	}
+	case 7:
+		return T * T * T * T;
+	case 8:
+	{
+		const float F = T - 1.0f;
+		return 1.0f - F * F * F * (1.0f - T);
+	}
+	case 9:
+	{
+		if(T < 0.5f)
+		{
+			return 8.0f * T * T * T * T;
+		}
+		const float F = T - 1.0f;
+		return -8.0f * F * F * F * F + 1.0f;
+	}
+	case 10:
+		return T * T * T * T * T;
+	case 11:
+	{
+		const float F = T - 1.0f;
+		return F * F * F * F * F + 1.0f;
+	}
+	case 12:
+	{
+		if(T < 0.5f)
+		{
+			return 16.0f * T * T * T * T * T;
+		}
+		const float F = 2.0f * T - 2.0f;
+		return 0.5f * F * F * F * F * F + 1.0f;
+	}
+	case 13:
+		return FMath::Sin((T - 1.0f) * (Pi * 0.5f)) + 1.0f;
+	case 14:
+		return FMath::Sin(T * (Pi * 0.5f));
+	case 15:
+		return 0.5f * (1.0f - FMath::Cos(T * Pi));
+	case 16:
+		return 1.0f - FMath::Sqrt(1.0f - T * T);
+	case 17:
+		return FMath::Sqrt((2.0f - T) * T);
+	case 18:
+	{
+		if(T < 0.5f)
+		{
+			return 0.5f * (1.0f - FMath::Sqrt(1.0f - 4.0f * T * T));
+		}
+		return 0.5f * (FMath::Sqrt(-((2.0f * T - 3.0f) * (2.0f * T - 1.0f))) + 1.0f);
+	}
+	case 19:
+		return T == 0.0f ? 0.0f : FMath::Pow(2.0f, 10.0f * (T - 1.0f));
+	case 20:
+		return T == 1.0f ? 1.0f : 1.0f - FMath::Pow(2.0f, -10.0f * T);
+	case 21:
+	{
+		if(T == 0.0f || T == 1.0f)
+		{
+			return T;
+		}
+		if(T < 0.5f)
+		{
+			return 0.5f * FMath::Pow(2.0f, 20.0f * T - 10.0f);
+		}
+		return -0.5f * FMath::Pow(2.0f, -20.0f * T + 10.0f) + 1.0f;
+	}
+	case 22:
+		return FMath::Sin(13.0f * Pi * 0.5f * T) * FMath::Pow(2.0f, 10.0f * (T - 1.0f));
+	case 23:
+		return FMath::Sin(-13.0f * Pi * 0.5f * (T + 1.0f)) * FMath::Pow(2.0f, -10.0f * T) + 1.0f;
+	case 24:
+	{
+		if(T < 0.5f)
+		{
+			return 0.5f * FMath::Sin(13.0f * Pi * (2.0f * T) * 0.5f) * FMath::Pow(2.0f, 10.0f * (2.0f * T - 1.0f));
+		}
+		return 0.5f * (FMath::Sin(-13.0f * Pi * 0.5f * ((2.0f * T - 1.0f) + 1.0f)) * FMath::Pow(2.0f, -10.0f * (2.0f * T - 1.0f)) + 2.0f);
+	}
+	case 25:
+		return T * T * T - T * FMath::Sin(T * Pi);
+	case 26:
+	{
+		const float F = 1.0f - T;
+		return 1.0f - (F * F * F - F * FMath::Sin(F * Pi));
+	}
+	case 27:
+	{
+		if(T < 0.5f)
+		{
+			const float F = 2.0f * T;
+			return 0.5f * (F * F * F - F * FMath::Sin(F * Pi));
+		}
+		const float F = 1.0f - (2.0f * T - 1.0f);
+		return 0.5f * (1.0f - (F * F * F - F * FMath::Sin(F * Pi))) + 0.5f;
+	}
+	case 28:
+		return BounceEaseIn(T);
+	case 29:
+		return BounceEaseOut(T);
+	case 30:
+		return BounceEaseInOut(T);
+	default:
+		return T;
+	}
+}
+
+float PSFTween::GetTweenProgress(float StartTime, float Duration, bool bPingPong, float Time)
+{
+	const float T = (Time - StartTime) / Duration;
+	if(T < 0.0f)
+	{
+		return 0.0f;
+	}
+
+	if(bPingPong)
+	{
+		const float CycleTime = FMod(T, 2.0f);
+		return CycleTime < 1.0f ? CycleTime : 2.0f - CycleTime;
+	}
+	return Frac(T);
+}
+
+float PSFTween::Tween1D(float Start, float End, float Duration, int32 TweenType, float StartTime, bool bPingPong, float Time)
+{
+	const float T = GetTweenProgress(StartTime, Duration, bPingPong, Time);
+	return FMath::Lerp(Start, End, ApplyTweenFunction(T, TweenType));
+}
+
+FVector3f PSFTween::Tween3D(const FVector3f &Start, const FVector3f &End, float Duration, int32 TweenType, float StartTime, bool bPingPong, float Time)
+{
+	const float T = GetTweenProgress(StartTime, Duration, bPingPong, Time);
+	return Lerp(Start, End, ApplyTweenFunction(T, TweenType));
+}
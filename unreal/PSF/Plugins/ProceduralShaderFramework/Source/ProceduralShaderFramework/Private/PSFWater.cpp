@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFWater.h"
+#include "PSFShaderMath.h"
+
+using namespace PSFShaderMath;
+
+float PSFWater::HashNoise(const FVector3f &InP)
+{
+	const FVector3f Magic(7.0f, 157.0f, 113.0f);
+	const FVector3f F = Floor(InP);
+	FVector3f P = InP - F;
+
+	const float Base = F | Magic;
+	const float H0[4] = {Base, Magic.Y + Base, Magic.Z + Base, Magic.Y + Magic.Z + Base};
+
+	// p *= p * (3 - 2p)
+	P = P * P * (FVector3f(3.0f) - P * 2.0f);
+
+	float H[4];
+	for(int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		H[Corner] = FMath::Lerp(Frac(FMath::Sin(H0[Corner]) * 43785.5f), Frac(FMath::Sin(H0[Corner] + Magic.X) * 43785.5f), P.X);
+	}
+
+	// h.xy = lerp(h.xz, h.yw, p.y)
+	const float X = FMath::Lerp(H[0], H[1], P.Y);
+	const float Y = FMath::Lerp(H[2], H[3], P.Y);
+	return FMath::Lerp(X, Y, P.Z);
+}
+
+void PSFWater::ComputeWaveOctaves(const FVector3f &Position, float Time, float OutOctaves[NumWaveOctaves])
+{
+	FVector3f Warped = Position - FVector3f(0.0f, 0.0f, FMod(Time, 62.83f) * 3.0f);
+
+	const float Direction = FMath::Sin(Time * 0.15f);
+	const float Angle = 0.001f * Direction;
+	const float C = FMath::Cos(Angle);
+	const float S = FMath::Sin(Angle);
+
+	float Amplitude = 3.0f;
+	for(int32 Iteration = 0; Iteration < NumWaveOctaves; ++Iteration)
+	{
+		Amplitude *= 0.51f;
+		OutOctaves[Iteration] = FMath::Abs(FMath::Sin(HashNoise(Warped * 0.15f) - 0.5f) * 3.14f) * Amplitude;
+
+		// mul(warped.xy, float2x2(c, s, -s, c))
+		Warped = FVector3f(Warped.X * C - Warped.Y * S, Warped.X * S + Warped.Y * C, Warped.Z);
+		Warped *= 1.75f;
+	}
+}
+
+float PSFWater::ComputeWave(const FVector3f &Position, float Time)
+{
+	float Octaves[NumWaveOctaves];
+	ComputeWaveOctaves(Position, Time, Octaves);
+
+	float Accum = 0.0f;
+	for(const float Octave : Octaves)
+	{
+		Accum += Octave;
+	}
+
+	float Height = Position.Y + Accum;
+	Height *= 0.5f;
+	Height += 0.3f * FMath::Sin(Time + Position.X * 0.3f);
+	return Height;
+}
+
+FVector4f PSFWater::TraceWater(const FVector3f &RayOrigin, const FVector3f &RayDirection, float Time, float StoppingCriterium, const FPSFMarchState &Start, int32 &OutSteps)
+{
+	FPSFMarchState March = Start;
+	FVector3f HitPosition = FVector3f::ZeroVector;
+	float T = March.T;
+	OutSteps = 0;
+	for(int32 Step = 0; Step < 100; ++Step)
+	{
+		++OutSteps;
+		const FVector3f P = RayOrigin + RayDirection * March.T;
+		const float D = ComputeWave(P, Time);
+		T = March.T;
+		if(!March.Advance(D))
+		{
+			continue;
+		}
+		if(D < 0.0001f)
+		{
+			HitPosition = P;
+			break;
+		}
+		T = March.T;
+		if(T > StoppingCriterium)
+		{
+			break;
+		}
+	}
+	return FVector4f(HitPosition, T);
+}
@@ -0,0 +1,301 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFWaveBaker.h"
+#include "PSFWater.h"
+#include "PSFShaderMath.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include <atomic>
+
+using namespace PSFShaderMath;
+
+namespace
+{
+	/** Step of sampleHeightField, the surface is bracketed with it and then refined by bisection */
+	const float SurfaceSearchStep = 0.05f;
+	const int32 MaxSurfaceSearchSteps = 100;
+	const int32 SurfaceBisections = 8;
+
+	/** Samples the band means are estimated from before the crossfade */
+	const int32 MeanSamples = 4096;
+
+	struct FWaveBands
+	{
+		float Coarse = 0.0f;
+		float Fine = 0.0f;
+	};
+
+	float SumOctaves(const float Octaves[PSFWater::NumWaveOctaves], int32 First, int32 Last)
+	{
+		float Sum = 0.0f;
+		for(int32 Octave = First; Octave < Last; ++Octave)
+		{
+			Sum += Octaves[Octave];
+		}
+		return Sum;
+	}
+
+	/**
+	 * Octaves at time 0 on the surface at (X, Z), where y + waveStrength crosses zero. The crossing is bracketed with
+	 * the step of sampleHeightField starting at InOutGuess (0 searches downwards from the top like sampleHeightField),
+	 * neighbouring texels pass the height of the previous one.
+	 */
+	FWaveBands EvaluateOnSurface(float X, float Z, int32 CoarseOctaves, float &InOutGuess, int64 &InOutEvaluations)
+	{
+		float Octaves[PSFWater::NumWaveOctaves];
+		auto SurfaceDistance = [&](float Y)
+		{
+			++InOutEvaluations;
+			PSFWater::ComputeWaveOctaves(FVector3f(X, Y, Z), 0.0f, Octaves);
+			return Y + SumOctaves(Octaves, 0, PSFWater::NumWaveOctaves);
+		};
+
+		// above the surface the distance is positive
+		const float Direction = SurfaceDistance(InOutGuess) < 0.0f ? 1.0f : -1.0f;
+		float Upper = InOutGuess;
+		float Lower = InOutGuess;
+		for(int32 Step = 0; Step < MaxSurfaceSearchSteps; ++Step)
+		{
+			const float Next = (Direction > 0.0f ? Upper : Lower) + Direction * SurfaceSearchStep;
+			const bool bAbove = SurfaceDistance(Next) >= 0.0f;
+			if(Direction > 0.0f)
+			{
+				Lower = Upper;
+				Upper = Next;
+			}
+			else
+			{
+				Upper = Lower;
+				Lower = Next;
+			}
+			if(bAbove == (Direction > 0.0f))
+			{
+				break;
+			}
+		}
+
+		for(int32 Bisection = 0; Bisection < SurfaceBisections; ++Bisection)
+		{
+			const float Middle = 0.5f * (Upper + Lower);
+			(SurfaceDistance(Middle) < 0.0f ? Lower : Upper) = Middle;
+		}
+
+		InOutGuess = 0.5f * (Upper + Lower);
+		SurfaceDistance(InOutGuess);
+		return {SumOctaves(Octaves, 0, CoarseOctaves), SumOctaves(Octaves, CoarseOctaves, PSFWater::NumWaveOctaves)};
+	}
+
+	int32 Wrap(int32 Index, int32 Size)
+	{
+		return ((Index % Size) + Size) % Size;
+	}
+
+	/** Bilinear with wrapping, texel centers at (i + 0.5) * TileSize / Resolution like the GPU sampler */
+	template<typename TexelType, typename ReadType>
+	FVector4f SampleWrapped(const TArray<TexelType> &Texels, int32 Resolution, float TileSize, float X, float Z, ReadType Read)
+	{
+		const float U = X / TileSize * Resolution - 0.5f;
+		const float V = Z / TileSize * Resolution - 0.5f;
+		const int32 U0 = FMath::FloorToInt(U);
+		const int32 V0 = FMath::FloorToInt(V);
+		const float FractionU = U - U0;
+		const float FractionV = V - V0;
+
+		auto Load = [&](int32 Column, int32 Row)
+		{
+			return Read(Texels, Wrap(Row, Resolution) * Resolution + Wrap(Column, Resolution));
+		};
+		const FVector4f Top = Load(U0, V0) * (1.0f - FractionU) + Load(U0 + 1, V0) * FractionU;
+		const FVector4f Bottom = Load(U0, V0 + 1) * (1.0f - FractionU) + Load(U0 + 1, V0 + 1) * FractionU;
+		return Top * (1.0f - FractionV) + Bottom * FractionV;
+	}
+}
+
+FVector4f FPSFBakedWaves::Sample(float X, float Z) const
+{
+	return SampleWrapped(Texels, Resolution, TileSize, X, Z, [](const TArray<FFloat16> &Data, int32 Texel)
+	{
+		return FVector4f(Data[4 * Texel].GetFloat(), Data[4 * Texel + 1].GetFloat(), Data[4 * Texel + 2].GetFloat(), Data[4 * Texel + 3].GetFloat());
+	});
+}
+
+bool FPSFWaveBaker::Bake(const FPSFWaveBakeSettings &Settings, FPSFBakedWaves &OutBaked, FPSFWaveBakeStats &OutStats)
+{
+	if(Settings.Resolution < 2 || Settings.TileSize <= 0.0f || Settings.CoarseOctaves < 0 || Settings.CoarseOctaves > PSFWater::NumWaveOctaves)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Invalid wave bake settings: resolution %d, tile size %f, coarse octaves %d."), Settings.Resolution, Settings.TileSize, Settings.CoarseOctaves);
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 Resolution = Settings.Resolution;
+	const float TileSize = Settings.TileSize;
+	std::atomic<int64> TotalEvaluations(0);
+
+	// the crossfade keeps the variance around the mean, which has to be known first
+	FWaveBands Mean;
+	{
+		FRandomStream Random(0x3a7e);
+		int64 Evaluations = 0;
+		for(int32 Sample = 0; Sample < MeanSamples; ++Sample)
+		{
+			float Guess = 0.0f;
+			const FWaveBands Bands = EvaluateOnSurface((Random.FRand() * 2.0f - 1.0f) * TileSize, (Random.FRand() * 2.0f - 1.0f) * TileSize, Settings.CoarseOctaves, Guess, Evaluations);
+			Mean.Coarse += Bands.Coarse / MeanSamples;
+			Mean.Fine += Bands.Fine / MeanSamples;
+		}
+		TotalEvaluations += Evaluations;
+	}
+
+	// every texel blends the unbounded field at its position and one tile to the left / below, with weights that
+	// make the left edge of the tile continue its right edge
+	TArray<FVector4f> Bands;
+	Bands.SetNumZeroed(Resolution * Resolution);
+	ParallelFor(Resolution, [&](int32 Row)
+	{
+		int64 Evaluations = 0;
+		float Guesses[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		const float V = (Row + 0.5f) / Resolution;
+		for(int32 Column = 0; Column < Resolution; ++Column)
+		{
+			const float U = (Column + 0.5f) / Resolution;
+			const float X = U * TileSize;
+			const float Z = V * TileSize;
+
+			const float Weights[4] = {(1.0f - U) * (1.0f - V), U * (1.0f - V), (1.0f - U) * V, U * V};
+			const FWaveBands Samples[4] = {
+				EvaluateOnSurface(X, Z, Settings.CoarseOctaves, Guesses[0], Evaluations),
+				EvaluateOnSurface(X - TileSize, Z, Settings.CoarseOctaves, Guesses[1], Evaluations),
+				EvaluateOnSurface(X, Z - TileSize, Settings.CoarseOctaves, Guesses[2], Evaluations),
+				EvaluateOnSurface(X - TileSize, Z - TileSize, Settings.CoarseOctaves, Guesses[3], Evaluations)
+			};
+
+			float Coarse = 0.0f;
+			float Fine = 0.0f;
+			for(int32 Corner = 0; Corner < 4; ++Corner)
+			{
+				Coarse += Weights[Corner] * (Samples[Corner].Coarse - Mean.Coarse);
+				Fine += Weights[Corner] * (Samples[Corner].Fine - Mean.Fine);
+			}
+
+			// a plain lerp of two independent fields halves the variance in the middle of the tile
+			const float Normalization = 1.0f / FMath::Sqrt((FMath::Square(1.0f - U) + FMath::Square(U)) * (FMath::Square(1.0f - V) + FMath::Square(V)));
+			Bands[Row * Resolution + Column] = FVector4f(Mean.Coarse + Coarse * Normalization, Mean.Fine + Fine * Normalization, 0.0f, 0.0f);
+		}
+		TotalEvaluations += Evaluations;
+	}, EParallelForFlags::Unbalanced);
+
+	// differences for getNormal(p, 1), taken on the tiled field so that they wrap as well
+	const float TexelSize = TileSize / Resolution;
+	TArray<FFloat16> Texels;
+	Texels.SetNumUninitialized(4 * Resolution * Resolution);
+	ParallelFor(Resolution, [&](int32 Row)
+	{
+		for(int32 Column = 0; Column < Resolution; ++Column)
+		{
+			const float X = (Column + 0.5f) * TexelSize;
+			const float Z = (Row + 0.5f) * TexelSize;
+			auto Strength = [&](float SampleX, float SampleZ)
+			{
+				const FVector4f Field = SampleWrapped(Bands, Resolution, TileSize, SampleX, SampleZ, [](const TArray<FVector4f> &Data, int32 Texel) { return Data[Texel]; });
+				return Field.X + Field.Y;
+			};
+
+			const int32 Texel = Row * Resolution + Column;
+			Texels[4 * Texel] = FFloat16(Bands[Texel].X);
+			Texels[4 * Texel + 1] = FFloat16(Bands[Texel].Y);
+			Texels[4 * Texel + 2] = FFloat16(Strength(X + 1.0f, Z) - Strength(X - 1.0f, Z));
+			Texels[4 * Texel + 3] = FFloat16(Strength(X, Z + 1.0f) - Strength(X, Z - 1.0f));
+		}
+	});
+
+	OutBaked.Resolution = Resolution;
+	OutBaked.TileSize = TileSize;
+	OutBaked.CoarseOctaves = Settings.CoarseOctaves;
+	OutBaked.Texels = MoveTemp(Texels);
+
+	OutStats = FPSFWaveBakeStats();
+	OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+	OutStats.WaveEvaluations = TotalEvaluations;
+	OutStats.Bytes = int64(OutBaked.Texels.Num()) * sizeof(FFloat16);
+	return true;
+}
+
+float FPSFWaveBaker::ComputeWave(const FPSFBakedWaves &Baked, const FVector3f &Position, float Time, float Distance, float FadeStart, float FadeEnd)
+{
+	const FVector4f Field = Baked.Sample(Position.X, Position.Z - FMod(Time, 62.83f) * 3.0f);
+	const float Accum = Field.X + Field.Y * (1.0f - SmoothStep(FadeStart, FadeEnd, Distance));
+
+	float Height = Position.Y + Accum;
+	Height *= 0.5f;
+	Height += 0.3f * FMath::Sin(Time + Position.X * 0.3f);
+	return Height;
+}
+
+void FPSFWaveBaker::MeasureStatistics(const FPSFBakedWaves &Baked, const FPSFWaveBakeSettings &Settings, FPSFWaveBakeStats &InOutStats)
+{
+	FRandomStream Random(0x7e1d);
+	const int32 NumSamples = FMath::Max(Settings.StatisticsSamples, 2);
+
+	// waveStrength on the surface, the baked field is sampled several tiles away to include the repetition
+	double AnalyticSum = 0.0, AnalyticSquares = 0.0, BakedSum = 0.0, BakedSquares = 0.0;
+	int64 Evaluations = 0;
+	for(int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		const float X = (Random.FRand() * 8.0f - 4.0f) * Baked.TileSize;
+		const float Z = (Random.FRand() * 8.0f - 4.0f) * Baked.TileSize;
+		float Guess = 0.0f;
+		const FWaveBands Bands = EvaluateOnSurface(X, Z, Baked.CoarseOctaves, Guess, Evaluations);
+		const float Analytic = Bands.Coarse + Bands.Fine;
+		const FVector4f Field = Baked.Sample(X, Z);
+		const float BakedStrength = Field.X + Field.Y;
+
+		AnalyticSum += Analytic;
+		AnalyticSquares += double(Analytic) * Analytic;
+		BakedSum += BakedStrength;
+		BakedSquares += double(BakedStrength) * BakedStrength;
+	}
+	InOutStats.AnalyticMean = float(AnalyticSum / NumSamples);
+	InOutStats.AnalyticStdDev = float(FMath::Sqrt(FMath::Max(AnalyticSquares / NumSamples - FMath::Square(AnalyticSum / NumSamples), 0.0)));
+	InOutStats.BakedMean = float(BakedSum / NumSamples);
+	InOutStats.BakedStdDev = float(FMath::Sqrt(FMath::Max(BakedSquares / NumSamples - FMath::Square(BakedSum / NumSamples), 0.0)));
+
+	TArray<FVector4f> Points;
+	Points.SetNumUninitialized(NumSamples);
+	for(FVector4f &Point : Points)
+	{
+		Point = FVector4f((Random.FRand() * 2.0f - 1.0f) * 100.0f, -3.0f * Random.FRand(), (Random.FRand() * 2.0f - 1.0f) * 100.0f, Random.FRand() * 62.83f);
+	}
+
+	float Sink = 0.0f;
+	double Start = FPlatformTime::Seconds();
+	for(const FVector4f &Point : Points)
+	{
+		Sink += PSFWater::ComputeWave(FVector3f(Point.X, Point.Y, Point.Z), Point.W);
+	}
+	InOutStats.AnalyticNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / NumSamples;
+
+	Start = FPlatformTime::Seconds();
+	for(const FVector4f &Point : Points)
+	{
+		Sink += ComputeWave(Baked, FVector3f(Point.X, Point.Y, Point.Z), Point.W, 0.0f, 0.0f, 1.0f);
+	}
+	InOutStats.BakedNsPerEval = (FPlatformTime::Seconds() - Start) * 1e9 / NumSamples;
+
+	// keeps both loops from being optimized away
+	if(Sink == 1234.5f)
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("%f"), Sink);
+	}
+}
+
+void FPSFWaveBaker::LogStats(const FPSFWaveBakeStats &Stats)
+{
+	UE_LOG(LogTemp, Display, TEXT("Baked the waves in %.2f s, %.2f M octave loops/s, %.2f MB"), Stats.Seconds,
+		Stats.Seconds > 0.0 ? Stats.WaveEvaluations / Stats.Seconds * 1e-6 : 0.0, Stats.Bytes / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Display, TEXT("waveStrength on the surface: analytic mean %.3f stddev %.3f, baked mean %.3f stddev %.3f"),
+		Stats.AnalyticMean, Stats.AnalyticStdDev, Stats.BakedMean, Stats.BakedStdDev);
+	UE_LOG(LogTemp, Display, TEXT("CPU cost of computeWave: %.1f ns analytic, %.1f ns baked (%.1fx)"), Stats.AnalyticNsPerEval, Stats.BakedNsPerEval,
+		Stats.BakedNsPerEval > 0.0 ? Stats.AnalyticNsPerEval / Stats.BakedNsPerEval : 0.0);
+}
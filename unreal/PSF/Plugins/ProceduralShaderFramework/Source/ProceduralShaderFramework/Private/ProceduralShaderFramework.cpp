@@ -3,6 +3,20 @@
 #include "ProceduralShaderFramework.h"
 #include "CustomSDFWindowPluginStyle.h"
 #include "CustomSDFWindowPluginCommands.h"
+#include "PSFScene.h"
+#include "PSFSceneCompiler.h"
+#include "PSFCpuRaymarcher.h"
+#include "PSFMarchProfile.h"
+#include "SPSFMarchStatsWidget.h"
+#include "PSFShaderSync.h"
+#include "PSFShaderPatcher.h"
+#include "PSFCustomSDFRegistry.h"
+#include "PSFCustomSDFGenerator.h"
+#include "MaterialEditingLibrary.h"
+#include "Misc/Crc.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "Framework/Notifications/NotificationManager.h"
 #include "ShaderCompiler.h"
 #include "ShaderCore.h"
 #include "ShaderCompilerCore.h"
@@ -49,8 +63,38 @@ void FProceduralShaderFrameworkModule::StartupModule()
 
 
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-	CopyShaderFilesToProject();
 	ShaderDir = FPaths::Combine(FPaths::ProjectDir(), TEXT("Shaders"));
+	IFileManager::Get().MakeDirectory(*ShaderDir, true);
+
+	const FPSFShaderSync ShaderSync = FPSFShaderSync::CreateForProject();
+	if(ShaderSync.IsMissingFiles())
+	{
+		// first start, the materials can not compile without the shaders
+		FPSFShaderSync::LogResult(ShaderSync.Run());
+	}
+	else
+	{
+		// only changed plugin shaders get rewritten, hashing does not need to hold up the editor
+		ShaderSyncTask = Async(EAsyncExecution::ThreadPool, [this, ShaderSync] ()
+		{
+			// a Generate click during the sync would otherwise patch sdf_functions.ush while it is being replaced
+			FPSFShaderSyncResult Result;
+			{
+				FScopeLock Lock(&ShaderFileLock);
+				Result = ShaderSync.Run();
+			}
+			FPSFShaderSync::LogResult(Result);
+			if(Result.Copied > 0)
+			{
+				AsyncTask(ENamedThreads::GameThread, [] ()
+				{
+					// shaders that were read before the sync finished are cached with their old content
+					FlushShaderFileCache();
+					UE_LOG(LogTemp, Log, TEXT("Plugin shaders were updated, use RecompileShaders Changed to apply them to already compiled materials."));
+				});
+			}
+		});
+	}
 	if(!AllShaderSourceDirectoryMappings().Contains(TEXT("/ProceduralShaderFramework"))) {
 		AddShaderSourceDirectoryMapping(TEXT("/ProceduralShaderFramework"), ShaderDir);
 	}
@@ -64,6 +108,22 @@ void FProceduralShaderFrameworkModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	++LatestGeneration;
+	if(GenerateDebounceHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(GenerateDebounceHandle);
+		GenerateDebounceHandle.Reset();
+	}
+	// superseded generations still run until their next check and use this module
+	for(TFuture<void> &Task : GenerateTasks)
+	{
+		Task.Wait();
+	}
+	GenerateTasks.Reset();
+	if(ShaderSyncTask.IsValid())
+	{
+		ShaderSyncTask.Wait();
+	}
 	UE_LOG(LogTemp, Warning, TEXT("ProceduralShaderFramework: ShutdownModule called."));
 }
 
@@ -109,6 +169,16 @@ TSharedRef<class SDockTab> FProceduralShaderFrameworkModule::OnSpawnPluginTab(co
 		[
 			SNew(SVerticalBox)
 
+				// Name of the custom SDF, an existing name is updated
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(10, 10, 10, 0)
+				[
+					SAssignNew(CustomSDFNameTextBox, SEditableTextBox)
+						.Text(FText::FromString(FPSFCustomSDFRegistry::LegacyName))
+						.HintText(FText::FromString("Name of the custom SDF, generates sd<Name>, add<Name> and Add<Name>"))
+				]
+
 				// Large Text Input Box
 				+ SVerticalBox::Slot()
 				.Padding(10)
@@ -131,298 +201,285 @@ TSharedRef<class SDockTab> FProceduralShaderFrameworkModule::OnSpawnPluginTab(co
 					SNew(SButton)
 						.Text(FText::FromString("Generate"))
 						.OnClicked_Lambda([this] () -> FReply {
-							WriteShaderFunctionToFile();
-							GenerateMaterialFunction();
+							RequestGenerate();
 							return FReply::Handled();
 						})
 				]
+
+			// Scene compiler
+			+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(10)
+				[
+					SNew(SHorizontalBox)
+						+ SHorizontalBox::Slot()
+						.FillWidth(1.0f)
+						.Padding(0, 0, 10, 0)
+						[
+							SAssignNew(ScenePathTextBox, SEditableTextBox)
+								.HintText(FText::FromString("Scene json to compile into CompiledScene.ush"))
+						]
+						+ SHorizontalBox::Slot()
+						.AutoWidth()
+						[
+							SNew(SButton)
+								.Text(FText::FromString("Compile Scene"))
+								.OnClicked_Lambda([this] () -> FReply {
+									CompileSceneToShader();
+									return FReply::Handled();
+								})
+						]
+						+ SHorizontalBox::Slot()
+						.AutoWidth()
+						.Padding(10, 0, 0, 0)
+						[
+							SNew(SButton)
+								.Text(FText::FromString("Profile Scene"))
+								.OnClicked_Lambda([this] () -> FReply {
+									ProfileScene();
+									return FReply::Handled();
+								})
+						]
+				]
+
+			// March counters of the last profiled scene
+			+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(10, 0, 10, 10)
+				[
+					SAssignNew(MarchStatsWidget, SPSFMarchStatsWidget)
+				]
 		];
 	
 }
 
-void FProceduralShaderFrameworkModule::WriteShaderFunctionToFile()
+void FProceduralShaderFrameworkModule::RequestGenerate()
 {
-	// Write SDF Function to MyCustomSDF.ush
-
-	if(!MultiLineTextBox.IsValid())
+	if(!MultiLineTextBox.IsValid() || !CustomSDFNameTextBox.IsValid())
 	{
 		UE_LOG(LogTemp, Error, TEXT("MultiLineTextBox is not valid."));
 		return;
 	}
 
-	// Get user-entered text
-	FString UserCode = MultiLineTextBox->GetText().ToString();
-
-	// Wrap with a function header
-	FString WrappedCode;
-	WrappedCode += TEXT("#ifndef PROCEDURAL_SHADER_FRAMEWORK_CUSTOM_SDFs_H\n");
-	WrappedCode += TEXT("#define PROCEDURAL_SHADER_FRAMEWORK_CUSTOM_SDFs_H\n");
-
-	WrappedCode += TEXT("float sdMyCustomSDF(float3 probePoint, float time)\n");
-	WrappedCode += TEXT("{\n");
-	WrappedCode += UserCode.Replace(TEXT("\n"), TEXT("\n    ")); // indent nicely
-	WrappedCode += TEXT("\n}\n");
-	WrappedCode += TEXT("#endif\n");
-
-
-	// Define output file path (change as needed)
-	FString FilePath = ShaderDir / TEXT("/MyCustomSDFs.ush");
-
-	// Ensure directory exists
-	FString Directory = FPaths::GetPath(FilePath);
-	IFileManager::Get().MakeDirectory(*Directory, true);
-
-	// Write to file
-	if(FFileHelper::SaveStringToFile(WrappedCode, *FilePath))
-	{
-		UE_LOG(LogTemp, Log, TEXT("Shader code written to: %s"), *FilePath);
-	}
-	else
+	const FString Name = CustomSDFNameTextBox->GetText().ToString().TrimStartAndEnd();
+	const FString NameError = FPSFCustomSDFRegistry::ValidateName(Name);
+	if(!NameError.IsEmpty())
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to write shader code to: %s"), *FilePath);
+		SetGenerateProgress(FString::Printf(TEXT("Custom SDF: %s"), *NameError), SNotificationItem::CS_Fail);
+		return;
 	}
 
-	// include customSDF.ush
-	ReplaceBetweenMarkers("// PSFCODEINCLUDECUSTOMSDFSTART", "// PSFCODEINCLUDECUSTOMSDFEND", "#include \"MyCustomSDFs.ush\"\n");
-
+	// the code is taken now, a later click supersedes this generation
+	const FString UserCode = MultiLineTextBox->GetText().ToString();
+	const uint32 Generation = ++LatestGeneration;
 
-	// Modify evalScene
-	ReplaceBetweenMarkers("// PSFCODEEVALCUSTOMSDFSTART", "// PSFCODEEVALCUSTOMSDFEND",	"else if (s.type == 99)\n"
-																					"{\n"
-																						"float dist = sdMyCustomSDF(probePoint, time);\n"
-																						"return dist;\n"
-																					"}\n");
+	if(GenerateDebounceHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(GenerateDebounceHandle);
+	}
+	GenerateDebounceHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, Generation, Name, UserCode] (float) -> bool {
+		GenerateDebounceHandle.Reset();
+		StartGenerate(Generation, Name, UserCode);
+		return false;
+	}), GenerateDebounceSeconds);
 
+	SetGenerateProgress(TEXT("Custom SDF: waiting for further changes..."), SNotificationItem::CS_Pending);
+}
 
-	// Add void addCustomSDF(inout int index, MaterialParams material){} function to sdf_functions.ush
-	ReplaceBetweenMarkers("// PSFCODEADDCUSTOMSDFSTART", "// PSFCODEADDCUSTOMSDFEND",	"void addCustomSDF(inout int index, MaterialParams material)\n"
-																					"{\n"
-																						"SDF newSDF;\n"
+void FProceduralShaderFrameworkModule::StartGenerate(uint32 Generation, const FString &Name, const FString &UserCode)
+{
+	SetGenerateProgress(TEXT("Custom SDF: writing shader code..."), SNotificationItem::CS_Pending);
 
-																						"newSDF.type = 99;\n"
-																						"newSDF.material = material;\n"
-																						"newSDF.rotation = computeRotationMatrix(normalize(float3(0.0, 1.0, 0.0)), 0 * PI / 180);\n"
+	GenerateTasks.RemoveAll([] (const TFuture<void> &Task)
+	{
+		return Task.IsReady();
+	});
 
-																						"addSDF(index, newSDF);\n"
+	// file IO on a worker, only the asset work below needs the game thread
+	GenerateTasks.Add(Async(EAsyncExecution::ThreadPool, [this, Generation, Name, UserCode] ()
+	{
+		FPSFCustomSDF Sdf;
+		bool bWritten = false;
+		bool bChanged = false;
+		{
+			// an older generation or the startup sync that is still writing finishes first, they are never interleaved
+			FScopeLock Lock(&ShaderFileLock);
+			if(Generation != LatestGeneration)
+			{
+				return;
+			}
+			bWritten = WriteShaderFunctionToFile(Name, UserCode, Sdf, bChanged);
+			if(bChanged)
+			{
+				// a later generation may find the files already written and must still recompile
+				bShaderFilesDirty = true;
+			}
+		}
 
-																					"}\n");
+		AsyncTask(ENamedThreads::GameThread, [this, Generation, Sdf, bWritten] ()
+		{
+			if(Generation != LatestGeneration)
+			{
+				return;
+			}
 
+			if(!bWritten)
+			{
+				SetGenerateProgress(TEXT("Custom SDF: failed to write the shader code, see the output log."), SNotificationItem::CS_Fail);
+				return;
+			}
 
+			SetGenerateProgress(FString::Printf(TEXT("Custom SDF: updating material function of %s (type %d)..."), *Sdf.Name, Sdf.TypeId), SNotificationItem::CS_Pending);
+
+			// next tick, so the progress is painted before the asset work blocks the game thread
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, Generation, Sdf] (float) -> bool {
+				if(Generation != LatestGeneration)
+				{
+					return false;
+				}
+
+				// also true if a superseded generation wrote the files and never got here
+				const bool bShaderChanged = bShaderFilesDirty;
+
+				// the shader file cache still holds the old includes
+				if(bShaderChanged)
+				{
+					FlushShaderFileCache();
+				}
+				bool bModified = false;
+				if(!FPSFCustomSDFGenerator::UpdateMaterialFunction(Sdf, bShaderChanged, FPSFCustomSDFGenerator::DefaultPackagePath, bModified))
+				{
+					SetGenerateProgress(FString::Printf(TEXT("Custom SDF: failed to update the material function of %s, see the output log."), *Sdf.Name), SNotificationItem::CS_Fail);
+					return false;
+				}
+
+				if(bShaderChanged)
+				{
+					bShaderFilesDirty = false;
+				}
+				SetGenerateProgress(FString::Printf(TEXT("Custom SDF: %s generated."), *Sdf.Name), SNotificationItem::CS_Success);
+				return false;
+			}));
+		});
+	}));
 }
 
-void FProceduralShaderFrameworkModule::ReplaceBetweenMarkers(const FString &StartMarker, const FString &EndMarker, const FString &Replacement) {
-	FString FileContent;
-	FString FilePath = ShaderDir / TEXT("/sdf_functions.ush");
-
-	// Load file content
-	if(!FFileHelper::LoadFileToString(FileContent, *FilePath))
+void FProceduralShaderFrameworkModule::SetGenerateProgress(const FString &Text, SNotificationItem::ECompletionState State)
+{
+	TSharedPtr<SNotificationItem> Notification = GenerateNotification.Pin();
+	if(!Notification.IsValid())
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to read file: %s"), *FilePath);
+		FNotificationInfo Info(FText::FromString(Text));
+		Info.bFireAndForget = false;
+		Info.ExpireDuration = 3.0f;
+		Notification = FSlateNotificationManager::Get().AddNotification(Info);
+		GenerateNotification = Notification;
+		if(!Notification.IsValid())
+		{
+			return;
+		}
 	}
 
-	// Find marker positions
-	int32 StartIndex = FileContent.Find(StartMarker, ESearchCase::IgnoreCase, ESearchDir::FromStart);
-	int32 EndIndex = FileContent.Find(EndMarker, ESearchCase::IgnoreCase, ESearchDir::FromStart);
-
-	if(StartIndex == INDEX_NONE || EndIndex == INDEX_NONE || EndIndex <= StartIndex)
+	Notification->SetText(FText::FromString(Text));
+	Notification->SetCompletionState(State);
+	if(State != SNotificationItem::CS_Pending)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Could not find valid marker range in file."));
+		Notification->ExpireAndFadeout();
+		GenerateNotification.Reset();
 	}
+}
 
-	// Find the line ends after each marker
-	int32 StartLineEnd = FileContent.Find(LINE_TERMINATOR, ESearchCase::IgnoreCase, ESearchDir::FromStart, StartIndex);
-	int32 EndLineStart = EndIndex;
+bool FProceduralShaderFrameworkModule::WriteShaderFunctionToFile(const FString &Name, const FString &UserCode, FPSFCustomSDF &OutSdf, bool &bOutChanged)
+{
+	// Register the SDF and write all custom SDFs to MyCustomSDFs.ush
 
-	// Extract parts
-	FString Before = FileContent.Left(StartLineEnd + FCString::Strlen(LINE_TERMINATOR));
-	FString After = FileContent.Mid(EndLineStart);
+	bOutChanged = false;
 
-	FString NewContent = Before + Replacement + LINE_TERMINATOR + After;
+	FPSFCustomSDFRegistry Registry;
+	const FString RegistryPath = ShaderDir / FPSFCustomSDFRegistry::FileName;
+	if(!Registry.LoadFromJsonFile(RegistryPath))
+	{
+		return false;
+	}
 
-	// Write back to file
-	if(!FFileHelper::SaveStringToFile(NewContent, *FilePath))
+	OutSdf = Registry.AddOrUpdate(Name, UserCode);
+	if(!Registry.SaveToJsonFile(RegistryPath))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to write file: %s"), *FilePath);
+		return false;
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("Successfully updated file between markers."));
+	return FPSFCustomSDFGenerator::WriteShaderFiles(ShaderDir, Registry, bOutChanged);
 }
 
-
-void FProceduralShaderFrameworkModule::GenerateMaterialFunction()
+void FProceduralShaderFrameworkModule::CompileSceneToShader()
 {
-	FString AssetName = TEXT("AddCustomSDF");
-	FString PackagePath = TEXT("/Game/SDF");
-	FAssetToolsModule &AssetToolsModule = FAssetToolsModule::GetModule();
+	// Write the straight-line version of a static scene to CompiledScene.ush
 
-
-	// Try to load existing asset
-	UPackage *ExistingPackage = FindPackage(nullptr, *(PackagePath / AssetName));
-	if(ExistingPackage)
+	if(!ScenePathTextBox.IsValid())
 	{
-		UObject *ExistingAsset = StaticFindObject(nullptr, ExistingPackage, *AssetName);
-		if(ExistingAsset)
-		{
-			// Mark for delete
-			TArray<UObject *> AssetsToDelete = {ExistingAsset};
-			ObjectTools::DeleteObjectsUnchecked(AssetsToDelete);
-			UE_LOG(LogTemp, Warning, TEXT("Existing asset '%s' was deleted."), *(PackagePath / AssetName));
-		}
+		UE_LOG(LogTemp, Error, TEXT("ScenePathTextBox is not valid."));
+		return;
 	}
 
-
-
-	
-
-	// Create the asset
-	UMaterialFunctionFactoryNew *Factory = NewObject<UMaterialFunctionFactoryNew>();
-
-
-	UObject* CreatedAsset = AssetToolsModule.Get().CreateAsset(
-		AssetName, PackagePath, UMaterialFunction::StaticClass(), Factory);
-
-
-	UMaterialFunction *MaterialFunction = Cast<UMaterialFunction>(CreatedAsset);
-
-	if(!MaterialFunction)
+	const FString ScenePath = ScenePathTextBox->GetText().ToString().TrimStartAndEnd().TrimQuotes();
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to create Material Function."));
 		return;
 	}
 
-	// Mark as transactional so we can undo/redo
-	MaterialFunction->SetFlags(RF_Transactional);
-
-	// Create nodes
-	UMaterialExpressionFunctionInput *IndexInputNode = NewObject<UMaterialExpressionFunctionInput>(MaterialFunction, UMaterialExpressionFunctionInput::StaticClass(), NAME_None, RF_Transactional);
-	UMaterialExpressionFunctionInput *MaterialInputNode = NewObject<UMaterialExpressionFunctionInput>(MaterialFunction, UMaterialExpressionFunctionInput::StaticClass(), NAME_None, RF_Transactional);
-
-
-	UMaterialExpressionCustom *CustomNode = NewObject<UMaterialExpressionCustom>(MaterialFunction, UMaterialExpressionCustom::StaticClass(), NAME_None, RF_Transactional);
-	UMaterialExpressionFunctionOutput *OutputNode = NewObject<UMaterialExpressionFunctionOutput>(MaterialFunction, UMaterialExpressionFunctionOutput::StaticClass(), NAME_None, RF_Transactional);
-
-	UMaterialExpressionBreakMaterialAttributes *BreakMaterialNode = NewObject<UMaterialExpressionBreakMaterialAttributes>(MaterialFunction, UMaterialExpressionBreakMaterialAttributes::StaticClass(), NAME_None, RF_Transactional);
-
-	// Configure Inputs
-	IndexInputNode->InputName = TEXT("index");
-	IndexInputNode->InputType = FunctionInput_Scalar;
-	IndexInputNode->MaterialExpressionEditorX = -400;
-	IndexInputNode->MaterialExpressionEditorY = 0;
-
-	MaterialInputNode->InputName = TEXT("material");
-	MaterialInputNode->InputType = FunctionInput_MaterialAttributes;
-	MaterialInputNode->MaterialExpressionEditorX = -400;
-	MaterialInputNode->MaterialExpressionEditorY = -200;
-
-
-	FCustomInput baseColor, specularColor, specularStrength, shininess, roughness, metallic, rimPower, fakeSpecularColor, fakeSpecularPower, ior, refractionStrength, refractionTint;
-	baseColor.InputName = TEXT("baseColor");
-	specularColor.InputName = TEXT("specularColor");
-	specularStrength.InputName = TEXT("specularStrength");
-	shininess.InputName = TEXT("shininess");
-	roughness.InputName = TEXT("roughness");
-	metallic.InputName = TEXT("metallic");
-	rimPower.InputName = TEXT("rimPower");
-	fakeSpecularColor.InputName = TEXT("fakeSpecularColor");
-	fakeSpecularPower.InputName = TEXT("fakeSpecularPower");
-	ior.InputName = TEXT("ior");
-	refractionStrength.InputName = TEXT("refractionStrength");
-	refractionTint.InputName = TEXT("refractionTint");
-
-	CustomNode->Inputs.Add(baseColor);
-	CustomNode->Inputs.Add(specularColor);
-	CustomNode->Inputs.Add(specularStrength);
-	CustomNode->Inputs.Add(shininess);
-	CustomNode->Inputs.Add(roughness);
-	CustomNode->Inputs.Add(metallic);
-	CustomNode->Inputs.Add(rimPower);
-	CustomNode->Inputs.Add(fakeSpecularColor);
-	CustomNode->Inputs.Add(fakeSpecularPower);
-	CustomNode->Inputs.Add(ior);
-	CustomNode->Inputs.Add(refractionStrength);
-	CustomNode->Inputs.Add(refractionTint);
-
-	// Configure Custom node
-	CustomNode->Code = TEXT("float index = Index;\n"
-		"MaterialParams mat;\n"
-		"mat.baseColor = baseColor;\n"
-		"mat.specularColor = specularColor;\n"
-		"mat.specularStrength = specularStrength;\n"
-		"mat.shininess = shininess;\n"
-		"mat.roughness = roughness;\n"
-		"mat.metallic = metallic;\n"
-		"mat.rimPower = rimPower;\n"
-		"mat.fakeSpecularColor = fakeSpecularColor;\n"
-		"mat.fakeSpecularPower = fakeSpecularPower;\n"
-		"mat.ior = ior;\n"
-		"mat.refractionStrength = refractionStrength;\n"
-		"mat.refractionTint = refractionTint;\n"
-		"addCustomSDF(index, mat);\n"
-		"return index;\n");  // your custom HLSL code
-	CustomNode->OutputType = CMOT_Float1;
-
-	CustomNode->IncludeFilePaths.Add("/ProceduralShaderFramework/procedural_shader.ush");
-	CustomNode->IncludeFilePaths.Add("/ProceduralShaderFramework/MyCustomSDFs.ush");
-	CustomNode->ShowCode = true;
-	CustomNode->Inputs[0].InputName = "Index";
-
-	CustomNode->MaterialExpressionEditorX = 400;
-	CustomNode->MaterialExpressionEditorY = 0;
-
-	// Connect input to custom input
-	CustomNode->Inputs[0].Input.Connect(0, IndexInputNode); // index
-
-	CustomNode->Inputs[1].Input.Connect(0, BreakMaterialNode); // basecolor -> basecolor
-	CustomNode->Inputs[6].Input.Connect(1, BreakMaterialNode); // metallic -> metallic
-	CustomNode->Inputs[3].Input.Connect(2, BreakMaterialNode); // Specular -> specularStrength
-	CustomNode->Inputs[5].Input.Connect(3, BreakMaterialNode); // Roughness -> roughness
-	CustomNode->Inputs[9].Input.Connect(4, BreakMaterialNode); // Anisotropy -> fakeSpecularPower
-	CustomNode->Inputs[2].Input.Connect(5, BreakMaterialNode); // EmissiveColor -> SpecularColor
-	CustomNode->Inputs[4].Input.Connect(6, BreakMaterialNode); // Opacity -> shininess
-	CustomNode->Inputs[7].Input.Connect(7, BreakMaterialNode); // OpacityMask -> rimPower
-	CustomNode->Inputs[8].Input.Connect(8, BreakMaterialNode); // Normal -> fakeSpecularColor
-	CustomNode->Inputs[12].Input.Connect(9, BreakMaterialNode); // Tangent -> refractionTint
-	CustomNode->Inputs[11].Input.Connect(13, BreakMaterialNode); // ClearCoatRoughness -> refractionStrength
-	CustomNode->Inputs[10].Input.Connect(14, BreakMaterialNode); // AmbientOcclusion -> ior
-
-
-	// Configure breakMaterialNode
-	BreakMaterialNode->MaterialAttributes.Connect(0, MaterialInputNode);
-	BreakMaterialNode->MaterialExpressionEditorX = 0;
-	BreakMaterialNode->MaterialExpressionEditorY = 0;
+	FPSFCustomSDFRegistry Registry;
+	if(!Registry.LoadFromJsonFile(ShaderDir / FPSFCustomSDFRegistry::FileName))
+	{
+		return;
+	}
 
+	FPSFSceneCompilerStats Stats;
+	FString Code;
+	if(!FPSFSceneCompiler::Compile(Scene, Registry.GetEntries(), FPaths::GetCleanFilename(ScenePath), Code, Stats))
+	{
+		return;
+	}
 
-	
+	const FString FilePath = ShaderDir / FPSFSceneCompiler::OutputFileName;
+	if(!FFileHelper::SaveStringToFile(Code, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write compiled scene to: %s"), *FilePath);
+		return;
+	}
 
-	// Configure Output
-	OutputNode->OutputName = TEXT("nextIndex");
-	OutputNode->MaterialExpressionEditorX = 800;
-	OutputNode->MaterialExpressionEditorY = 0;
-	OutputNode->A.Connect(0, CustomNode);
+	UE_LOG(LogTemp, Log, TEXT("Compiled scene written to: %s"), *FilePath);
+	FPSFSceneCompiler::LogStats(Stats);
+}
 
-	TArray<FFunctionExpressionInput> Inputs;
-	TArray<FFunctionExpressionOutput> Outputs;
-	MaterialFunction->GetInputsAndOutputs(Inputs, Outputs);
+void FProceduralShaderFrameworkModule::ProfileScene()
+{
+	// Count the march cost of a scene with the CPU raymarcher, the same counters PSF_DEBUG_COUNTERS shows on the GPU
 
+	if(!ScenePathTextBox.IsValid() || !MarchStatsWidget.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("ScenePathTextBox is not valid."));
+		return;
+	}
 
-	FMaterialExpressionCollection Collection;
-	Collection.Expressions = {
-		IndexInputNode,
-		CustomNode,
-		OutputNode,
-		MaterialInputNode,
-		BreakMaterialNode
-	};
+	const FString ScenePath = ScenePathTextBox->GetText().ToString().TrimStartAndEnd().TrimQuotes();
+	FPSFScene Scene;
+	if(!Scene.LoadFromJsonFile(ScenePath))
+	{
+		return;
+	}
 
-	MaterialFunction->AssignExpressionCollection(Collection);
-	
-	// Compile and save
-	MaterialFunction->PostEditChange();
-	MaterialFunction->MarkPackageDirty();
-	MaterialFunction->UpdateFromFunctionResource();
-	UE_LOG(LogTemp, Log, TEXT("Material Function created and configured successfully."));
+	FPSFRenderSettings Settings;
+	Settings.Width = ProfileResolution;
+	Settings.Height = ProfileResolution;
 
+	TArray<FLinearColor> Pixels;
+	FPSFRenderStats Stats;
+	FPSFMarchProfile Profile;
+	FPSFCpuRaymarcher::Render(Scene, Settings, Pixels, Stats, nullptr, &Profile);
 
+	Profile.LogSummary(Scene);
+	MarchStatsWidget->SetProfile(Scene, Profile);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPSFMarchStatsWidget.h"
+#include "PSFMarchProfile.h"
+#include "PSFScene.h"
+#include "SlateOptMacros.h"
+#include "Styling/AppStyle.h"
+#include "Widgets/SLeafWidget.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Layout/SScrollBox.h"
+#include "Widgets/Text/STextBlock.h"
+
+/** Bar chart of the pixels per bucket of one counter */
+class SPSFHistogram : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPSFHistogram)
+	{}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments &InArgs)
+	{
+	}
+
+	void SetBuckets(TArray<int32> InBuckets)
+	{
+		Buckets = MoveTemp(InBuckets);
+		MaxCount = 1;
+		for(const int32 Count : Buckets)
+		{
+			MaxCount = FMath::Max(MaxCount, Count);
+		}
+		Invalidate(EInvalidateWidgetReason::Paint);
+	}
+
+	virtual FVector2D ComputeDesiredSize(float) const override
+	{
+		return FVector2D(320.0f, 80.0f);
+	}
+
+	virtual int32 OnPaint(const FPaintArgs &Args, const FGeometry &AllottedGeometry, const FSlateRect &MyCullingRect, FSlateWindowElementList &OutDrawElements,
+		int32 LayerId, const FWidgetStyle &InWidgetStyle, bool bParentEnabled) const override
+	{
+		const FSlateBrush *Brush = FAppStyle::GetBrush("WhiteBrush");
+		const FVector2f Size = AllottedGeometry.GetLocalSize();
+		FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), Brush, ESlateDrawEffect::None, FLinearColor(0.02f, 0.02f, 0.02f));
+		if(Buckets.Num() == 0)
+		{
+			return LayerId;
+		}
+
+		// bars share the width, the bucket with the most pixels is full height
+		const float BarWidth = Size.X / Buckets.Num();
+		for(int32 Index = 0; Index < Buckets.Num(); ++Index)
+		{
+			const float Height = Size.Y * Buckets[Index] / MaxCount;
+			if(Height <= 0.0f)
+			{
+				continue;
+			}
+			FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 1,
+				AllottedGeometry.ToPaintGeometry(FVector2f(FMath::Max(BarWidth - 1.0f, 1.0f), Height), FSlateLayoutTransform(FVector2f(Index * BarWidth, Size.Y - Height))),
+				Brush, ESlateDrawEffect::None, FLinearColor(0.9f, 0.5f, 0.1f));
+		}
+		return LayerId + 1;
+	}
+
+private:
+	TArray<int32> Buckets;
+	int32 MaxCount = 1;
+};
+
+namespace
+{
+	const int32 HistogramBuckets = 50;
+
+	/** One line of the SDF table, every cell has the same width so the columns line up */
+	TSharedRef<SWidget> MakeSdfRow(const TArray<FString> &Cells, const FSlateColor &Color)
+	{
+		TSharedRef<SHorizontalBox> Row = SNew(SHorizontalBox);
+		for(const FString &Cell : Cells)
+		{
+			Row->AddSlot()
+				.AutoWidth()
+				[
+					SNew(SBox)
+						.WidthOverride(90.0f)
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString(Cell))
+								.ColorAndOpacity(Color)
+						]
+				];
+		}
+		return Row;
+	}
+}
+
+BEGIN_SLATE_FUNCTION_BUILD_OPTIMIZATION
+void SPSFMarchStatsWidget::Construct(const FArguments &InArgs)
+{
+	ChildSlot
+	[
+		SNew(SVerticalBox)
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(0, 0, 0, 5)
+			[
+				SAssignNew(TotalsText, STextBlock)
+					.Text(FText::FromString("Profile a scene to see its march counters"))
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(STextBlock)
+					.Text(FText::FromString("Steps per pixel"))
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(0, 2, 0, 5)
+			[
+				SAssignNew(StepHistogram, SPSFHistogram)
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(STextBlock)
+					.Text(FText::FromString("SDF evaluations per pixel"))
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(0, 2, 0, 5)
+			[
+				SAssignNew(EvaluationHistogram, SPSFHistogram)
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				MakeSdfRow({TEXT("SDF"), TEXT("Type"), TEXT("Evaluations"), TEXT("ns/eval"), TEXT("Est. ms"), TEXT("Costliest")}, FSlateColor::UseSubduedForeground())
+			]
+			+ SVerticalBox::Slot()
+			.MaxHeight(200.0f)
+			[
+				SNew(SScrollBox)
+					+ SScrollBox::Slot()
+					[
+						SAssignNew(SdfRows, SVerticalBox)
+					]
+			]
+	];
+}
+END_SLATE_FUNCTION_BUILD_OPTIMIZATION
+
+void SPSFMarchStatsWidget::SetProfile(const FPSFScene &Scene, const FPSFMarchProfile &Profile)
+{
+	const double Rays = FMath::Max(Profile.Pixels.Num(), 1);
+	const int32 Costliest = Profile.GetCostliestSdf();
+	TotalsText->SetText(FText::FromString(FString::Printf(
+		TEXT("%dx%d: %.2f steps, %.1f SDF evaluations, %.1f dolphin evaluations per pixel\n%.1f%% hit, %.1f%% escaped, %.2f%% ran out of steps\nMost expensive SDF: %s"),
+		Profile.Width, Profile.Height, Profile.GetTotalSteps() / Rays, Profile.GetTotalEvaluations() / Rays, Profile.GetTotalDolphinEvaluations() / Rays,
+		Profile.CountExits(EPSFMarchExit::Hit) * 100.0 / Rays, Profile.CountExits(EPSFMarchExit::Escaped) * 100.0 / Rays, Profile.CountExits(EPSFMarchExit::StepCap) * 100.0 / Rays,
+		Costliest != INDEX_NONE ? *FString::Printf(TEXT("%d (%s)"), Costliest, PSFScene::SdfTypeToString(Scene.SDFs[Costliest].Type)) : TEXT("none"))));
+
+	StepHistogram->SetBuckets(Profile.GetHistogram(EPSFDebugView::Steps, HistogramBuckets, 100));
+	EvaluationHistogram->SetBuckets(Profile.GetHistogram(EPSFDebugView::Evaluations, HistogramBuckets, FMath::Max(1, Profile.GetMaxValue(EPSFDebugView::Evaluations))));
+
+	SdfRows->ClearChildren();
+	for(int32 SdfIndex = 0; SdfIndex < Profile.Sdfs.Num(); ++SdfIndex)
+	{
+		const FPSFSdfCost &Cost = Profile.Sdfs[SdfIndex];
+		const TArray<FString> Cells = {
+			FString::FromInt(SdfIndex),
+			Scene.SDFs.IsValidIndex(SdfIndex) ? PSFScene::SdfTypeToString(Scene.SDFs[SdfIndex].Type) : TEXT(""),
+			FString::Printf(TEXT("%lld"), Cost.Evaluations),
+			FString::Printf(TEXT("%.1f"), Cost.NanosecondsPerEvaluation),
+			FString::Printf(TEXT("%.3f"), Cost.GetEstimatedSeconds() * 1000.0),
+			FString::Printf(TEXT("%.1f%%"), Cost.CostliestPixels * 100.0 / Rays)
+		};
+		SdfRows->AddSlot()
+			.AutoHeight()
+			[
+				MakeSdfRow(Cells, SdfIndex == Costliest ? FSlateColor(FLinearColor(1.0f, 0.4f, 0.1f)) : FSlateColor::UseForeground())
+			];
+	}
+}
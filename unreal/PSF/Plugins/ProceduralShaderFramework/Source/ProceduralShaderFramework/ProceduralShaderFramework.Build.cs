@@ -53,7 +53,9 @@ public class ProceduralShaderFramework : ModuleRules
 				"Renderer",
 				"MaterialEditor",
                 "ToolMenus",
-                "EditorScriptingUtilities"
+                "EditorScriptingUtilities",
+                "Json",
+                "ImageCore"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * CPU ports of animation_functions.ush, used by UPSFTimelineComponent to evaluate them once per frame.
+ */
+namespace PSFAnimation
+{
+	/** Mirrors orbitObjectAroundPoint, OutAngle is in degrees like the shader output */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f OrbitObjectAroundPoint(const FVector3f &SeedPosition, const FVector3f &Center, const FVector3f &Axis, float Radius, float Speed,
+		float AngleOffset, float Time, float &OutAngle);
+
+	/** Mirrors shakeObject */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ShakeObject(const FVector3f &SeedPosition, float Intensity, float Speed, float Time);
+
+	/** Mirrors cycleColor */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f CycleColor(const FVector3f &SeedColor, float Speed, float Time);
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFLighting.h"
+
+struct FPSFAtmosphereLUTSettings
+{
+	/** Texels of the optical depth table over the view zenith and the altitude */
+	int32 DepthViewSize = 128;
+	int32 DepthAltitudeSize = 32;
+
+	/** Texels of the in-scattering table over the view / sun angle, the view zenith and the sun zenith */
+	int32 AngleSize = 32;
+	int32 ViewSize = 64;
+	int32 SunSize = 32;
+
+	/** Altitude slices of the in-scattering table, spread evenly between 0 and MaxAltitude */
+	int32 AltitudeSlices = 4;
+
+	/** Highest point above the ground the tables cover, lookups above it are clamped */
+	float MaxAltitude = 1000.0f;
+
+	/** Random view rays the tables are compared against applySunriseLighting at */
+	int32 ErrorSamples = 20000;
+};
+
+/**
+ * The sunrise atmosphere of addSunriseLight as two lookup tables, the layout applySunriseLightingLUT in
+ * lighting_functions.ush reads.
+ *
+ * The atmosphere is a sphere, so a view ray that leaves it only depends on the altitude, the zenith angles of the
+ * view and the sun and the angle between both. Depth (RGBA32F, DepthViewSize x DepthAltitudeSize) stores the
+ * Rayleigh and Mie optical depth of the view ray in xy. Scatter (RGBA32F, 2 * AngleSize x ViewSize x
+ * SunSize * AltitudeSlices) stores the Rayleigh in-scattering in the first AngleSize columns and the Mie
+ * in-scattering in the others, times the scattering coefficients and for a sun intensity of 1. Every altitude slice
+ * is a block of SunSize depth slices. The phase functions are applied at lookup time so the sun glow stays sharp.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFAtmosphereLUT
+{
+	FPSFAtmosphereLUTSettings Settings;
+
+	/** Planet the tables were baked for, lookups with another one are wrong */
+	FPSFSunriseLight Light;
+
+	TArray<FVector4f> Depth;
+	TArray<FVector4f> Scatter;
+
+	FIntVector GetScatterSize() const
+	{
+		return FIntVector(2 * Settings.AngleSize, Settings.ViewSize, Settings.SunSize * Settings.AltitudeSlices);
+	}
+
+	/** The sunriseLUT argument of applySunriseLightingLUT: max altitude and altitude slices */
+	FVector4f GetShaderParameters() const
+	{
+		return FVector4f(Settings.MaxAltitude, float(Settings.AltitudeSlices), 0.0f, 0.0f);
+	}
+
+	int64 GetNumBytes() const
+	{
+		return int64(Depth.Num() + Scatter.Num()) * sizeof(FVector4f);
+	}
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFAtmosphereLUTStats
+{
+	double Seconds = 0.0;
+
+	/** applySunriseLighting view integrals of the bake */
+	int64 Integrals = 0;
+
+	int64 Bytes = 0;
+
+	/** Error of the sky color against applySunriseLighting, absolute and relative to the brightest sample */
+	float MaxError = 0.0f;
+	float RmsError = 0.0f;
+	float MaxValue = 0.0f;
+
+	/** CPU cost of one sky color */
+	double AnalyticNsPerEval = 0.0;
+	double LUTNsPerEval = 0.0;
+};
+
+/**
+ * Precomputes the optical depth and in-scattering of applySunriseLighting, which integrates 16 view steps with
+ * 4 sun steps each per pixel. applySunriseLightingLUT gets away with six texture fetches and addSunriseLightLUT,
+ * which lights a black background, with four. Texels are baked in parallel.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFAtmosphereLUTBaker
+{
+public:
+	/** Bakes the tables for the earth and atmosphere of Light, its sun direction is ignored */
+	static bool Bake(const FPSFAtmosphereLUTSettings &Settings, const FPSFSunriseLight &Light, FPSFAtmosphereLUT &OutLUT, FPSFAtmosphereLUTStats &OutStats);
+
+	/** Mirrors sunriseInScatteringLUT, applySunriseLightingLUT for a black Lo without the optical depth fetch */
+	static FVector3f InScattering(const FPSFAtmosphereLUT &LUT, const FVector3f &Position, const FVector3f &Direction, const FPSFSunriseLight &Light);
+
+	/** Mirrors applySunriseLightingLUT, Light must share the planet of the bake */
+	static FVector3f ApplySunriseLighting(const FPSFAtmosphereLUT &LUT, const FVector3f &Position, const FVector3f &Direction, const FVector3f &Lo, const FPSFSunriseLight &Light);
+
+	/** Fills the error and cost part of Stats by comparing LUT to applySunriseLighting for random rays and suns */
+	static void MeasureError(const FPSFAtmosphereLUT &LUT, FPSFAtmosphereLUTStats &InOutStats);
+
+	static void LogStats(const FPSFAtmosphereLUTStats &Stats);
+};
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+class UTexture2D;
+
+namespace PSFSdfBounds
+{
+	/** Extent used for primitives without finite bounds (desert, custom SDFs), they are never culled */
+	constexpr float Unbounded = 1e30f;
+
+	/**
+	 * Conservative world space bounds of a primitive at the given time, the surface never leaves the box.
+	 * Returns false for primitives that cannot be bounded, OutBounds is then set to +-Unbounded.
+	 */
+	PROCEDURALSHADERFRAMEWORK_API bool ComputeBounds(const FPSFSdf &Sdf, float Time, FBox3f &OutBounds);
+
+	/**
+	 * Largest change of evalSDF per unit of distance, 0 if there is none to rely on. |evalSDF| divided by it is a lower bound
+	 * of the distance to the surface, the mesh extractor and the baker skip the space that is farther from it.
+	 */
+	PROCEDURALSHADERFRAMEWORK_API float GetLipschitzBound(const FPSFSdf &Sdf);
+
+	/** Distance from P to the box, 0 inside */
+	FORCEINLINE float DistanceToBox(const FBox3f &Box, const FVector3f &P)
+	{
+		const FVector3f Outside = FVector3f::Max(FVector3f::Max(Box.Min - P, P - Box.Max), FVector3f::ZeroVector);
+		return Outside.Size();
+	}
+}
+
+struct FPSFBvhNode
+{
+	FBox3f Bounds;
+
+	/** Leaves: offset into the primitive index list. Inner nodes: index of the right child, the left child directly follows its parent. */
+	int32 RightChildOrFirstPrimitive = 0;
+
+	/** Number of primitives, 0 for inner nodes */
+	int32 PrimitiveCount = 0;
+};
+
+/**
+ * Bounding volume hierarchy over the primitives of a scene, rebuilt every frame from the conservative bounds.
+ * Used to answer "closest primitive to p" queries during sphere tracing while skipping every primitive
+ * whose bounds are farther away than the best distance found so far.
+ *
+ * Skipping is always safe because the true distance to a skipped surface is at least the distance to its box.
+ * Octahedron, ellipsoid and dolphin return a lower bound instead of the exact distance, near their silhouettes
+ * the culled march can therefore take a larger (still safe) step than the brute force loop and end on a different pixel.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFBvh
+{
+public:
+	static constexpr int32 MaxLeafSize = 2;
+
+	/** Traversal stack size, median splits keep the depth at log2 of the primitive count */
+	static constexpr int32 MaxTraversalDepth = 64;
+
+	/** PSF_BVH_STACK_SIZE in sdf_functions.ush, deeper trees make evalSceneBVH fall back to testing every primitive */
+	static constexpr int32 ShaderStackSize = 32;
+
+	void Build(const FPSFScene &Scene, float Time);
+
+	/**
+	 * Minimum over all primitives of evalSDF, OutIndex is the primitive that produced it.
+	 * InOutPerSdfEvaluations (one counter per primitive) counts which primitives were evaluated, for FPSFMarchProfile.
+	 */
+	float EvalScene(const FPSFScene &Scene, const FVector3f &P, float Time, int32 &OutIndex, int64 &InOutSdfEvaluations, int64 *InOutPerSdfEvaluations = nullptr) const;
+
+	/**
+	 * Packs the hierarchy into float4 texels for raymarchAllBVH in sdf_functions.ush:
+	 * texel 0 holds the node count, node i occupies texels 1 + 2i (min, right child / first primitive)
+	 * and 2 + 2i (max, primitive count), followed by the primitive indices, four per texel.
+	 */
+	void Pack(TArray<FVector4f> &OutTexels) const;
+
+	/**
+	 * Uploads the packed hierarchy into a 1-texel high RGBA32F texture that is passed to raymarchAllBVH as bvhNodes.
+	 * The texture is (re)created when it is missing or too small, otherwise only the used texels are updated.
+	 */
+	UTexture2D *UpdateTexture(UTexture2D *Texture) const;
+
+	bool IsEmpty() const
+	{
+		return Nodes.Num() == 0;
+	}
+
+	const TArray<FPSFBvhNode> &GetNodes() const
+	{
+		return Nodes;
+	}
+
+	const TArray<int32> &GetPrimitiveIndices() const
+	{
+		return PrimitiveIndices;
+	}
+
+	/** Number of inner nodes on the longest path from the root to a leaf */
+	int32 GetDepth() const
+	{
+		return Depth;
+	}
+
+private:
+	int32 BuildRecursive(int32 First, int32 Count, int32 NodeDepth);
+
+	TArray<FPSFBvhNode> Nodes;
+	TArray<int32> PrimitiveIndices;
+
+	TArray<FBox3f> PrimitiveBounds;
+	TArray<FVector3f> PrimitiveCentroids;
+
+	int32 Depth = 0;
+};
@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+class FPSFBvh;
+class FPSFLightGrid;
+struct FPSFMarchCounters;
+struct FPSFMarchProfile;
+
+/** The march strategies of PSF_MARCH_MODE */
+enum class EPSFMarchMode : uint8
+{
+	/** Sphere tracing, PSF_MARCH_PLAIN */
+	Plain,
+
+	/** Over-relaxed sphere tracing that falls back to plain steps after the first overshoot, PSF_MARCH_RELAXED */
+	Relaxed
+};
+
+/** Mirrors MarchState, beginMarch and advanceMarch of sdf_functions.ush */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMarchState
+{
+	float T = 0.0f;
+	float Omega = 1.0f;
+	float PreviousRadius = 0.0f;
+	float StepLength = 0.0f;
+
+	FPSFMarchState() = default;
+
+	FPSFMarchState(float StartT, EPSFMarchMode MarchMode, float Relaxation)
+		: T(StartT)
+		, Omega(MarchMode == EPSFMarchMode::Relaxed ? Relaxation : 1.0f)
+	{
+	}
+
+	/** Steps by the distance at T, returns false if the step before overshot and D must not be tested for a hit */
+	FORCEINLINE bool Advance(float D)
+	{
+		const float Radius = FMath::Abs(D);
+		const bool bOvershot = Omega > 1.0f && (D < 0.0f || Radius + PreviousRadius < StepLength);
+		if(bOvershot)
+		{
+			StepLength -= Omega * StepLength;
+			Omega = 1.0f;
+		}
+		else
+		{
+			StepLength = D * Omega;
+		}
+		PreviousRadius = Radius;
+		T += StepLength;
+		return !bOvershot;
+	}
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFRenderSettings
+{
+	int32 Width = 512;
+	int32 Height = 512;
+
+	/** Tiles are the unit of work handed to the task graph */
+	int32 TileSize = 16;
+
+	float Time = 0.0f;
+
+	/** March 2x2 pixel quads as one 4-wide SIMD packet instead of one ray at a time */
+	bool bUsePackets = true;
+
+	/**
+	 * Build a BVH over the primitive bounds once per frame and only evaluate primitives whose bounds are closer than the current best distance.
+	 * Scenes with only a few primitives are always marched with the flat loop.
+	 */
+	bool bUseBvh = true;
+
+	EPSFMarchMode MarchMode = EPSFMarchMode::Plain;
+
+	/** Step scale of EPSFMarchMode::Relaxed, PSF_MARCH_RELAXATION */
+	float Relaxation = 1.2f;
+
+	/**
+	 * Pixels per side of a texel of the cone prepass, 0 disables it. The prepass marches one cone per texel
+	 * (coneMarchPrepass) and every ray starts at the smallest t of the 2x2 texels around it (loadConeStart).
+	 */
+	int32 ConePrepassTexel = 0;
+
+	/**
+	 * Bin the scene's point lights into screen tiles of LightTileSize pixels (FPSFLightGrid) and shade every pixel with the
+	 * lights of its tile. Without it every pixel loops over all point lights. Scenes without point lights ignore both.
+	 */
+	bool bUseLightGrid = true;
+	int32 LightTileSize = 16;
+
+	/** Frame counter of temporal reprojection, picks the pixels that march from the eye (the frame of reprojectStart) */
+	int32 Frame = 0;
+
+	/** PSF_TEMPORAL_BACKOFF, PSF_TEMPORAL_TOLERANCE and PSF_TEMPORAL_REFRESH */
+	float TemporalBackoff = 0.05f;
+	float TemporalTolerance = 0.05f;
+	int32 TemporalRefresh = 16;
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFRenderStats
+{
+	int64 Rays = 0;
+	int64 MarchSteps = 0;
+	int64 SdfEvaluations = 0;
+	double Seconds = 0.0;
+
+	/** Cones and their steps of the prepass, SdfEvaluations and Seconds include it */
+	int64 PrepassCones = 0;
+	int64 PrepassSteps = 0;
+
+	/** Point lights looped over by the shaded pixels, and the time to bin them (included in Seconds) */
+	int64 LightEvaluations = 0;
+	double LightBinningSeconds = 0.0;
+
+	/** Rays that started at a reprojected t of the temporal history, the validation step is counted in MarchSteps */
+	int64 TemporalStarts = 0;
+
+	/** March steps per pixel including the prepass, the number to compare the strategies by */
+	double StepsPerPixel() const
+	{
+		return Rays > 0 ? double(MarchSteps + PrepassSteps) / Rays : 0.0;
+	}
+
+	double LightsPerPixel() const
+	{
+		return Rays > 0 ? double(LightEvaluations) / Rays : 0.0;
+	}
+
+	double RaysPerSecond() const
+	{
+		return Seconds > 0.0 ? Rays / Seconds : 0.0;
+	}
+
+	double SdfEvaluationsPerSecond() const
+	{
+		return Seconds > 0.0 ? SdfEvaluations / Seconds : 0.0;
+	}
+};
+
+/**
+ * Hit distances of the last frame for temporal reprojection, what the history target of the scene component holds.
+ * Depth is row-major Width * Height and -1 where the ray hit nothing (temporalDepth).
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFTemporalHistory
+{
+	FVector3f Eye = FVector3f::ZeroVector;
+	FPSFMatrix3 CameraMatrix;
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<float> Depth;
+
+	bool IsValid() const
+	{
+		return Width > 0 && Height > 0 && Depth.Num() == Width * Height;
+	}
+};
+
+/** Result of marching a single ray, mirrors the outputs of raymarchAll */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFRayHit
+{
+	FVector4f HitPosition = FVector4f(0, 0, 0, 0);
+	int32 HitIndex = INDEX_NONE;
+	int32 Steps = 0;
+};
+
+/**
+ * Headless reference implementation of raymarchAll + the lighting functions.
+ * The image is split into tiles that are distributed over the task graph's worker threads,
+ * inside a tile rays are marched in 4-wide packets using the engine's vector intrinsics (SSE/NEON).
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFCpuRaymarcher
+{
+public:
+	/**
+	 * Renders the lit scene into OutPixels (row-major, Width * Height).
+	 * With a History the rays start at the reprojection of its hit distances (raymarchAllTemporal), a valid cone prepass
+	 * start that lies further wins. The history is replaced with the hit distances of this frame either way.
+	 * With a profile every ray takes the scalar path and its counters are written to OutProfile, the timing does not include
+	 * the cost measurement that follows the frame.
+	 */
+	static void Render(const FPSFScene &Scene, const FPSFRenderSettings &Settings, TArray<FLinearColor> &OutPixels, FPSFRenderStats &OutStats,
+		FPSFTemporalHistory *History = nullptr, FPSFMarchProfile *OutProfile = nullptr);
+
+	/**
+	 * Mirrors the march loop of raymarchAllFrom for a single ray, Start holds the start t and the march strategy.
+	 * With a BVH built for the same scene and time the per-step minimum is found through FPSFBvh::EvalScene.
+	 * OutCounters receives the counters of PSF_DEBUG_COUNTERS, InOutPerSdfEvaluations (one per SDF) counts the evaluations of
+	 * every SDF and is needed for the dolphin evaluations.
+	 */
+	static FPSFRayHit Raymarch(const FPSFScene &Scene, const FVector3f &RayDirection, float Time, int64 &InOutSdfEvaluations, const FPSFBvh *Bvh = nullptr,
+		const FPSFMarchState &Start = FPSFMarchState(), FPSFMarchCounters *OutCounters = nullptr, int64 *InOutPerSdfEvaluations = nullptr);
+
+	/** Mirrors coneMarchScene, the t every ray inside the cone of ConeRadius around RayDirection can start at */
+	static float ConeMarch(const FPSFScene &Scene, const FVector3f &RayDirection, float ConeRadius, float Time, int64 &InOutSdfEvaluations, int32 &OutSteps,
+		const FPSFBvh *Bvh = nullptr);
+
+	/** Mirrors computeUV + the ray direction setup of raymarchAll for the default camera */
+	static FVector2f PixelToUV(int32 X, int32 Y, int32 Width, int32 Height);
+	static FVector3f ComputeRayDirection(const FPSFMatrix3 &CameraMatrix, const FVector2f &UV);
+
+	/** Inverse of PixelToUV, the 0..1 viewport position with y pointing down that the light grid is indexed with */
+	static FVector2f UVToScreenUV(const FVector2f &UV);
+
+	/** Mirrors projectToScreen, false if P is behind the camera at Eye or off screen */
+	static bool ProjectToScreen(const FVector3f &P, const FVector3f &Eye, const FPSFMatrix3 &CameraMatrix, FVector2f &OutScreenUV);
+
+	/** Mirrors temporalDepth */
+	static float TemporalDepth(const FVector4f &HitPosition, float StoppingCriterium);
+
+	/**
+	 * Mirrors reprojectStart for the ray from RayOrigin through ScreenUV, with the frame and the constants of Settings.
+	 * 0 on a disocclusion, the caller still has to check the start against the scene of this frame.
+	 */
+	static float ReprojectStart(const FPSFTemporalHistory &History, const FVector3f &RayOrigin, const FVector3f &RayDirection, const FVector2f &ScreenUV,
+		const FPSFRenderSettings &Settings);
+
+	/**
+	 * Mirrors limitTemporalStart: TStart, or where the ray first enters the bounds at Time of a swimming dolphin or a
+	 * custom SDF if that is earlier. The bounds are the boxes of PSFSdfBounds, 0 for unbounded ones.
+	 */
+	static float LimitTemporalStart(const FPSFScene &Scene, const FVector3f &RayOrigin, const FVector3f &RayDirection, float Time, float TStart);
+
+	/**
+	 * Shades a hit the way raymarchAll finishes a hit (normal, material, desert bump) followed by the scene's lighting.
+	 * With a light grid the lighting models that have a tiled variant shade with the point lights of the pixel's tile.
+	 */
+	static FLinearColor ShadeHit(const FPSFScene &Scene, const FPSFRayHit &Hit, const FVector3f &RayDirection, const FVector2f &UV, float Time,
+		const FPSFLightGrid *LightGrid = nullptr);
+};
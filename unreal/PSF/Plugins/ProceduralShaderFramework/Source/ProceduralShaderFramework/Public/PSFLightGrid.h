@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+class UTexture2D;
+
+/** Range of the light index list that belongs to one screen tile */
+struct FPSFLightTile
+{
+	int32 FirstIndex = 0;
+	int32 LightCount = 0;
+};
+
+/**
+ * Screen space light culling for the tiled lighting functions of lighting_functions.ush.
+ *
+ * The view is split into square tiles of TileSize pixels. Every point light whose sphere of influence touches the
+ * frustum of a tile is appended to the tile's index list, so a pixel only loops over the lights that can reach it.
+ * A light contributes exactly 0 beyond its radius (pointLightAttenuation), the culled result therefore matches
+ * shading with every light.
+ *
+ * A light is tested against the column and the row strip of the frustum separately and binned into every tile of the
+ * rectangle that both tests leave, which is conservative for lights close to the corners of a tile. Tiles have no
+ * depth range, a light in front of a distant wall lands in every tile it covers on screen.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFLightGrid
+{
+public:
+	/** Texels per row of the texture, PSF_LIGHT_GRID_WIDTH in lighting_functions.ush */
+	static constexpr int32 TextureWidth = 1024;
+
+	/** Bins the lights for a Width x Height view of the camera at RayOrigin, CameraMatrix as computed by FPSFScene::ComputeCameraMatrix */
+	void Build(const TArray<FPSFPointLight> &InLights, const FVector3f &RayOrigin, const FPSFMatrix3 &CameraMatrix, int32 Width, int32 Height, int32 TileSize);
+
+	/** A single tile that lists every light, the unculled reference the binned grid is measured against */
+	void BuildUnculled(const TArray<FPSFPointLight> &InLights);
+
+	/** Lights of the tile that contains ScreenUV (0..1, y pointing down like the pixel rows) */
+	TConstArrayView<int32> GetTileLights(const FVector2f &ScreenUV) const;
+
+	/**
+	 * Packs the grid into float4 texels for the *Tiled lighting functions, texel i is at (i % TextureWidth, i / TextureWidth):
+	 * texel 0 holds (tilesX, tilesY, light count, 0) and texel 1 the tiles per unit of screen UV, light i occupies
+	 * texels 2 + 2i (position, radius) and 3 + 2i (color * intensity), followed by the tiles as (first index, count),
+	 * two per texel, and the light indices, four per texel. The last row is padded with zeros.
+	 */
+	void Pack(TArray<FVector4f> &OutTexels) const;
+
+	/**
+	 * Uploads the packed grid into an RGBA32F texture that is passed to the tiled lighting functions as lightGrid.
+	 * The texture is (re)created when it is missing or has too few rows, otherwise only the used rows are updated.
+	 */
+	UTexture2D *UpdateTexture(UTexture2D *Texture) const;
+
+	int32 GetTilesX() const
+	{
+		return TilesX;
+	}
+
+	int32 GetTilesY() const
+	{
+		return TilesY;
+	}
+
+	const TArray<FPSFPointLight> &GetLights() const
+	{
+		return Lights;
+	}
+
+	const TArray<FPSFLightTile> &GetTiles() const
+	{
+		return Tiles;
+	}
+
+	const TArray<int32> &GetLightIndices() const
+	{
+		return LightIndices;
+	}
+
+	/** Lights that are in at least one tile */
+	int32 GetVisibleLights() const
+	{
+		return VisibleLights;
+	}
+
+	int32 GetMaxLightsPerTile() const;
+
+	double GetAverageLightsPerTile() const
+	{
+		return Tiles.Num() > 0 ? double(LightIndices.Num()) / Tiles.Num() : 0.0;
+	}
+
+private:
+	TArray<FPSFPointLight> Lights;
+	TArray<FPSFLightTile> Tiles;
+	TArray<int32> LightIndices;
+
+	int32 TilesX = 0;
+	int32 TilesY = 0;
+
+	/** Tiles per unit of screen UV, Width / TileSize and Height / TileSize */
+	FVector2f TilesPerUV = FVector2f::ZeroVector;
+
+	int32 VisibleLights = 0;
+};
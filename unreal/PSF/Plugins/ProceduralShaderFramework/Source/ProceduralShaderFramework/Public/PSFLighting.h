@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+/** Mirrors the static globals of global_variables.ush that the lighting functions read */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFShaderGlobals
+{
+	FVector3f RayOrigin = FVector3f(0.0f, 0.0f, 7.0f);
+	float RaymarchStoppingCriterium = 100.0f;
+};
+
+/** Mirrors the SunriseLight struct of lighting_functions.ush */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFSunriseLight
+{
+	FVector3f SunDir;
+	FVector3f EarthCenter;
+	float EarthRadius;
+	float AtmosphereRadius;
+	float SunIntensity;
+
+	/** The sun setup of addSunriseLight */
+	static FPSFSunriseLight Make(float Time);
+};
+
+/**
+ * CPU ports of the lighting functions in lighting_functions.ush.
+ * HitPosition.w carries the raymarch distance exactly like the shader's hitPosition.
+ */
+namespace PSFLighting
+{
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyPhongLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyLambertLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyBlinnPhongLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyFakeSpecular(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f LambertDiffuse(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyToonLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	/** Cook-Torrance term of applyPBRLighting for a white light in direction L, shared with the tiled variant */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f CookTorranceLighting(const FVector3f &N, const FVector3f &V, const FVector3f &L, const FPSFMaterialParams &Material);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyPBRLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyRimLighting(const FPSFShaderGlobals &Globals, const FVector3f &RimColor, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplySoftSSLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyFresnelLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyUVGradientLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const FVector2f &UV);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyUVAnisotropicLighting(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &LightPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const FVector2f &UV);
+
+	PROCEDURALSHADERFRAMEWORK_API FVector2f DensitiesRM(const FVector3f &Position, const FPSFSunriseLight &Light);
+	PROCEDURALSHADERFRAMEWORK_API float Escape(const FVector3f &Position, const FVector3f &Direction, float AtmosphereRadius, const FVector3f &EarthCenter);
+	PROCEDURALSHADERFRAMEWORK_API FVector2f ScatterDepthInt(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, float Steps, const FPSFSunriseLight &Light);
+
+	/** The view ray integral of applySunriseLighting: optical depth along the view and the Rayleigh / Mie in-scattering before the phase functions */
+	PROCEDURALSHADERFRAMEWORK_API void SunriseInScattering(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, const FPSFSunriseLight &Light, FVector2f &OutDepthRM, FVector3f &OutRayleigh, FVector3f &OutMie);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplySunriseLighting(const FVector3f &Position, FVector3f Direction, float AtmosphericDistance, const FVector3f &Lo, const FPSFSunriseLight &Light);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f AddSunriseLight(const FPSFShaderGlobals &Globals, float Time, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, const FVector3f &RayDirection);
+
+	/** Mirrors pointLightAttenuation, 0 from Radius on */
+	PROCEDURALSHADERFRAMEWORK_API float PointLightAttenuation(float Distance, float Radius);
+
+	/** Ports of the *Tiled functions, LightIndices are the lights of the pixel's tile (FPSFLightGrid::GetTileLights) */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyPhongLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyLambertLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FVector3f &Normal, const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyBlinnPhongLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f ApplyPBRLightingTiled(const FPSFShaderGlobals &Globals, const FVector4f &HitPosition, const FPSFMaterialParams &Material, const FVector3f &Normal, const TArray<FPSFPointLight> &Lights, TConstArrayView<int32> LightIndices);
+
+	/** Shades with the scene's point lights through the tiled port of its lighting model, false for the models without one */
+	PROCEDURALSHADERFRAMEWORK_API bool ShadeTiled(const FPSFScene &Scene, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, TConstArrayView<int32> LightIndices, FVector3f &OutColor);
+
+	/** Dispatches to the port selected by the scene's lighting model */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f Shade(const FPSFScene &Scene, float Time, const FVector4f &HitPosition, const FVector3f &Normal, const FPSFMaterialParams &Material, const FVector3f &RayDirection, const FVector2f &UV);
+}
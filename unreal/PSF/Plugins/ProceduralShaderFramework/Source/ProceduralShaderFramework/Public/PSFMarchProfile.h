@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+/** How a march ended, PSF_EXIT_* */
+enum class EPSFMarchExit : uint8
+{
+	Hit,
+
+	/** Passed the scene's RaymarchStoppingCriterium */
+	Escaped,
+
+	/** Ran out of iterations */
+	StepCap
+};
+
+/** The views of marchDebugColor, PSF_DEBUG_VIEW_* */
+enum class EPSFDebugView : uint8
+{
+	Steps,
+	Evaluations,
+	Dolphins,
+	Exit,
+	CostliestSdf
+};
+
+/** Counters of one pixel, mirror marchDebugCounters and marchCostliestSdf of PSF_DEBUG_COUNTERS */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMarchCounters
+{
+	int32 Steps = 0;
+	int32 SdfEvaluations = 0;
+	int32 DolphinEvaluations = 0;
+	EPSFMarchExit Exit = EPSFMarchExit::StepCap;
+
+	/** The SDF that was the nearest one for the longest run of consecutive steps */
+	int32 CostliestSdf = INDEX_NONE;
+};
+
+/** What one SDF of the scene cost a frame */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFSdfCost
+{
+	int64 Evaluations = 0;
+
+	/** Pixels whose CostliestSdf it is */
+	int64 CostliestPixels = 0;
+
+	/** Measured by MeasureEvaluationCost, an SDF type costs the same at every step */
+	double NanosecondsPerEvaluation = 0.0;
+
+	double GetEstimatedSeconds() const
+	{
+		return Evaluations * NanosecondsPerEvaluation * 1e-9;
+	}
+};
+
+/**
+ * Per pixel march counters of a frame of the CPU raymarcher and their totals per SDF, what PSF_DEBUG_COUNTERS shows on
+ * the GPU. The evaluation counts are the CPU's, which tests every primitive per step where evalScene skips the ones whose
+ * bounding sphere is farther away than the best distance, the steps and exits match.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMarchProfile
+{
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** Row-major Width * Height */
+	TArray<FPSFMarchCounters> Pixels;
+
+	/** One per SDF of the scene */
+	TArray<FPSFSdfCost> Sdfs;
+
+	/** Times evaluations of every SDF around its position and fills NanosecondsPerEvaluation */
+	void MeasureEvaluationCost(const FPSFScene &Scene, float Time);
+
+	int64 CountExits(EPSFMarchExit Exit) const;
+	int64 GetTotalSteps() const;
+	int64 GetTotalEvaluations() const;
+	int64 GetTotalDolphinEvaluations() const;
+
+	/** Largest counter of a Steps, Evaluations or Dolphins view */
+	int32 GetMaxValue(EPSFDebugView View) const;
+
+	/** Pixels per bucket of a Steps, Evaluations or Dolphins view, bucket i holds the values in [i, i + 1) * MaxValue / NumBuckets */
+	TArray<int32> GetHistogram(EPSFDebugView View, int32 NumBuckets, int32 MaxValue) const;
+
+	/** The SDF with the largest estimated evaluation time, INDEX_NONE without SDFs */
+	int32 GetCostliestSdf() const;
+
+	/** Mirrors marchDebugColor */
+	FLinearColor GetDebugColor(int32 PixelIndex, EPSFDebugView View, float MaxEvaluations) const;
+
+	/** Totals, the per SDF costs and the step histogram, SDF types are taken from Scene */
+	FString ToJsonString(const FPSFScene &Scene) const;
+
+	void LogSummary(const FPSFScene &Scene) const;
+
+	static const TCHAR *GetViewName(EPSFDebugView View);
+};
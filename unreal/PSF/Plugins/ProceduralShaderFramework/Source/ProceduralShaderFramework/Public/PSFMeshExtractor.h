@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+struct FPSFMeshExtractSettings
+{
+	/** Cells along the longest side of the bounds at LOD 0, every further LOD halves it */
+	int32 Resolution = 128;
+
+	int32 NumLods = 3;
+
+	/** Cells along each side of a chunk, only the samples of the chunks in flight are held in memory */
+	int32 ChunkCells = 32;
+
+	/** Space around the primitive bounds, in cells, so that the surface is never cut off by the bounds */
+	float PaddingCells = 2.0f;
+
+	/** Moves every vertex onto the surface along the gradient of its cell, otherwise it stays at the mean of the edge crossings */
+	bool bProjectVertices = true;
+};
+
+/** Indexed triangle list of one LOD in the space of the scene, counter-clockwise seen from outside */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFExtractedMesh
+{
+	TArray<FVector3f> Positions;
+	TArray<FVector3f> Normals;
+	TArray<uint32> Indices;
+
+	float CellSize = 0.0f;
+
+	int32 GetNumTriangles() const
+	{
+		return Indices.Num() / 3;
+	}
+
+	int64 GetNumBytes() const
+	{
+		return int64(Positions.Num() + Normals.Num()) * sizeof(FVector3f) + int64(Indices.Num()) * sizeof(uint32);
+	}
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMeshExtractStats
+{
+	double Seconds = 0.0;
+
+	/** evalSDF calls of the extraction, chunk classification, corner samples and vertex placement */
+	int64 SdfEvaluations = 0;
+
+	int32 TotalChunks = 0;
+	int32 SurfaceChunks = 0;
+
+	int32 Vertices = 0;
+	int32 Triangles = 0;
+
+	/** Largest amount of memory the extraction held at once, sample buffers and meshes, and a dense grid of float samples for comparison */
+	int64 PeakBytes = 0;
+	int64 DenseBytes = 0;
+
+	/** Largest |evalSDF| at a vertex */
+	float MaxVertexError = 0.0f;
+
+	double GetTrianglesPerSecond() const
+	{
+		return Seconds > 0.0 ? Triangles / Seconds : 0.0;
+	}
+};
+
+/**
+ * Extracts indexed meshes of static primitives for rasterization at distance and for collision, instead of marching
+ * them per pixel. Surface nets, the simplest dual contouring: one vertex per cell the surface passes through, one quad
+ * per edge it crosses. The bounds are cut into chunks that are sampled and meshed in parallel, chunks are merged in
+ * order as soon as they are done, so the output does not depend on the thread count and the full grid never exists.
+ * Every SDF is meshed on its own, overlapping SDFs give intersecting meshes and not the mesh of their union.
+ * Dolphins move and custom SDFs only exist as HLSL, neither can be extracted.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFMeshExtractor
+{
+public:
+	static bool CanExtract(const FPSFSdf &Sdf);
+
+	/** Extracts Sdf inside Bounds with Resolution cells along the longest side, an invalid box uses the bounds of the primitive */
+	static bool Extract(const FPSFSdf &Sdf, const FBox3f &Bounds, int32 Resolution, const FPSFMeshExtractSettings &Settings, FPSFExtractedMesh &OutMesh, FPSFMeshExtractStats &OutStats);
+
+	/** Settings.NumLods extractions of the same bounds, LOD n at Settings.Resolution >> n */
+	static bool ExtractLods(const FPSFSdf &Sdf, const FBox3f &Bounds, const FPSFMeshExtractSettings &Settings, TArray<FPSFExtractedMesh> &OutLods, TArray<FPSFMeshExtractStats> &OutStats);
+
+	static void LogStats(int32 Lod, const FPSFMeshExtractStats &Stats);
+};
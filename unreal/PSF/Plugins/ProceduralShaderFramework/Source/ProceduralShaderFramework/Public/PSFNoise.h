@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * How the noise batches evaluate the sin of frac(sin(x) * 43758) and similar hashes. The factor turns the last bits of
+ * sin into the hash value, so two sin implementations give other values for many cells. The GPU has its own sin and
+ * agrees with neither, only the kind of noise is the same.
+ */
+enum class EPSFSinHash : uint8
+{
+	/** FMath::Sin lane by lane, the batches equal the scalar ports */
+	Exact,
+
+	/** VectorSin, several times faster for hashNoise and gradN2D, other values than the scalar ports in a share of the cells */
+	Fast
+};
+
+/**
+ * CPU ports of the noise functions in noise_functions.ush.
+ * The ports follow the HLSL line by line so that CPU renders and bakes match the GPU.
+ */
+namespace PSFNoise
+{
+	/** Simplex noise, mirrors snoise */
+	PROCEDURALSHADERFRAMEWORK_API float SNoise(const FVector3f &V);
+
+	/** Value noise from hash44, mirrors n31 */
+	PROCEDURALSHADERFRAMEWORK_API float N31(const FVector3f &P);
+
+	/** Mirrors fbm_n31 */
+	PROCEDURALSHADERFRAMEWORK_API float FbmN31(const FVector3f &P, int32 Octaves);
+
+	/** Mirrors hash11, used by shakeObject */
+	PROCEDURALSHADERFRAMEWORK_API float Hash11(float X);
+
+	/** Mirrors hash22, used by gradN2D */
+	PROCEDURALSHADERFRAMEWORK_API FVector2f Hash22(const FVector2f &P);
+
+	/** Value noise used for the desert, mirrors n2D */
+	PROCEDURALSHADERFRAMEWORK_API float N2D(const FVector2f &P);
+
+	/** Gradient noise used for the desert sand, mirrors gradN2D */
+	PROCEDURALSHADERFRAMEWORK_API float GradN2D(const FVector2f &P);
+
+	/** Mirrors hash44, the hash behind n31 */
+	PROCEDURALSHADERFRAMEWORK_API FVector4f Hash44(const FVector4f &P);
+
+	/**
+	 * Batch versions for baking and other CPU work on many points: OutValues[i] is the function of Points[i], evaluated
+	 * four points at a time with VectorRegister4Float (SSE on x64, NEON on ARM). Any count works, the arrays must have the
+	 * same length. HashNoiseBatch mirrors hashNoise of water_functions.ush, PSFWater::HashNoise is its scalar port.
+	 *
+	 * The batches repeat the float operations of the scalar ports in the same order and differ from them by at most
+	 * BatchTolerance, normally not at all. Against the GPU they are as close as the scalar ports: snoise, n31, fbm_n31
+	 * and hash44 by float rounding, the sin hashes of n2D, gradN2D and hashNoise not beyond the kind of noise, see
+	 * EPSFSinHash.
+	 */
+	constexpr float BatchTolerance = 1e-5f;
+
+	PROCEDURALSHADERFRAMEWORK_API void SNoiseBatch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues);
+	PROCEDURALSHADERFRAMEWORK_API void N31Batch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues);
+	PROCEDURALSHADERFRAMEWORK_API void FbmN31Batch(TConstArrayView<FVector3f> Points, int32 Octaves, TArrayView<float> OutValues);
+	PROCEDURALSHADERFRAMEWORK_API void Hash44Batch(TConstArrayView<FVector4f> Points, TArrayView<FVector4f> OutValues);
+	PROCEDURALSHADERFRAMEWORK_API void N2DBatch(TConstArrayView<FVector2f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash = EPSFSinHash::Exact);
+	PROCEDURALSHADERFRAMEWORK_API void GradN2DBatch(TConstArrayView<FVector2f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash = EPSFSinHash::Exact);
+	PROCEDURALSHADERFRAMEWORK_API void HashNoiseBatch(TConstArrayView<FVector3f> Points, TArrayView<float> OutValues, EPSFSinHash SinHash = EPSFSinHash::Exact);
+}
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * CPU-side mirror of the scene that the shaders build per pixel through addSphere, addTorus, ...
+ * The type ids match the `s.type == N` branches of evalSDF in sdf_functions.ush.
+ */
+enum class EPSFSdfType : int32
+{
+	Sphere = 0,
+	RoundBox = 1,
+	Torus = 2,
+	HexPrism = 3,
+	Octahedron = 4,
+	Ellipsoid = 5,
+	Dolphin = 6,
+	Rock = 7,
+	Desert = 8,
+	Custom = 99
+};
+
+/** Row-major 3x3 matrix with the same layout as the HLSL float3x3 built by computeRotationMatrix */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMatrix3
+{
+	FVector3f Rows[3];
+
+	FPSFMatrix3()
+	{
+		Rows[0] = FVector3f(1, 0, 0);
+		Rows[1] = FVector3f(0, 1, 0);
+		Rows[2] = FVector3f(0, 0, 1);
+	}
+
+	FPSFMatrix3(const FVector3f &Row0, const FVector3f &Row1, const FVector3f &Row2)
+	{
+		Rows[0] = Row0;
+		Rows[1] = Row1;
+		Rows[2] = Row2;
+	}
+
+	/** HLSL mul(v, M): v is treated as a row vector */
+	FORCEINLINE FVector3f MulRow(const FVector3f &V) const
+	{
+		return Rows[0] * V.X + Rows[1] * V.Y + Rows[2] * V.Z;
+	}
+
+	/** HLSL mul(M, v): v is treated as a column vector */
+	FORCEINLINE FVector3f MulColumn(const FVector3f &V) const
+	{
+		return FVector3f(Rows[0] | V, Rows[1] | V, Rows[2] | V);
+	}
+
+	/** Mirrors computeRotationMatrix in helper_functions.ush, angle in radians */
+	static FPSFMatrix3 FromAxisAngle(const FVector3f &Axis, float Angle);
+};
+
+/** Mirrors MaterialParams in material_functions.ush */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFMaterialParams
+{
+	FVector3f BaseColor = FVector3f(1.0f, 1.0f, 1.0f);
+	FVector3f SpecularColor = FVector3f(1.0f, 1.0f, 1.0f);
+	float SpecularStrength = 1.0f;
+	float Shininess = 32.0f;
+
+	float Roughness = 0.5f;
+	float Metallic = 0.0f;
+	float RimPower = 2.0f;
+	float FakeSpecularPower = 32.0f;
+	FVector3f FakeSpecularColor = FVector3f(1.0f, 1.0f, 1.0f);
+
+	float Ior = 1.45f;
+	float RefractionStrength = 0.0f;
+	FVector3f RefractionTint = FVector3f(1.0f, 1.0f, 1.0f);
+
+	bool operator==(const FPSFMaterialParams &Other) const
+	{
+		return BaseColor == Other.BaseColor && SpecularColor == Other.SpecularColor && SpecularStrength == Other.SpecularStrength
+			&& Shininess == Other.Shininess && Roughness == Other.Roughness && Metallic == Other.Metallic && RimPower == Other.RimPower
+			&& FakeSpecularPower == Other.FakeSpecularPower && FakeSpecularColor == Other.FakeSpecularColor && Ior == Other.Ior
+			&& RefractionStrength == Other.RefractionStrength && RefractionTint == Other.RefractionTint;
+	}
+};
+
+/** Mirrors the SDF struct (plus the Dolphin side table) in sdf_functions.ush */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFSdf
+{
+	EPSFSdfType Type = EPSFSdfType::Sphere;
+	FVector3f Position = FVector3f::ZeroVector;
+	FVector3f Size = FVector3f::ZeroVector;
+	float Radius = 0.0f;
+	FPSFMatrix3 Rotation;
+	FPSFMaterialParams Material;
+
+	// only used by dolphins
+	float TimeOffset = 0.0f;
+	float Speed = 0.0f;
+
+	// only used by custom SDFs, the name in CustomSDFs.json, empty for the single CustomSDF of type 99
+	FString CustomName;
+};
+
+enum class EPSFLightingModel : int32
+{
+	None,
+	Phong,
+	Lambert,
+	BlinnPhong,
+	FakeSpecular,
+	LambertDiffuse,
+	Toon,
+	PBR,
+	Rim,
+	SoftSS,
+	Fresnel,
+	UVGradient,
+	UVAnisotropic,
+	Sunrise
+};
+
+/** A point light of the tiled lighting functions, its contribution fades to exactly 0 at Radius */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFPointLight
+{
+	FVector3f Position = FVector3f::ZeroVector;
+	FVector3f Color = FVector3f(1.0f, 1.0f, 1.0f);
+	float Intensity = 1.0f;
+	float Radius = 5.0f;
+};
+
+/**
+ * A scene as it would be assembled by a material graph: the list of SDFs, the camera and a single light.
+ * Point lights are shaded by the tiled variants of the Phong, Lambert, Blinn-Phong and PBR models, see FPSFLightGrid.
+ * Scenes are described as json so that they can be rendered headless and compared to engine captures.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFScene
+{
+	TArray<FPSFSdf> SDFs;
+
+	FVector3f RayOrigin = FVector3f(0.0f, 0.0f, 7.0f);
+	FVector3f LookAt = FVector3f::ZeroVector;
+	float RaymarchStoppingCriterium = 100.0f;
+
+	EPSFLightingModel LightingModel = EPSFLightingModel::Phong;
+	FVector3f LightPosition = FVector3f(0.0f, 4.0f, 7.0f);
+	FVector3f RimColor = FVector3f(1.0f, 1.0f, 1.0f);
+	TArray<FPSFPointLight> PointLights;
+
+	/** Mirrors computeCameraMatrix(LookAt, RayOrigin, identity) */
+	FPSFMatrix3 ComputeCameraMatrix() const;
+
+	bool LoadFromJsonFile(const FString &FilePath);
+	bool LoadFromJsonString(const FString &JsonString);
+	FString SaveToJsonString() const;
+};
+
+namespace PSFScene
+{
+	PROCEDURALSHADERFRAMEWORK_API const TCHAR *SdfTypeToString(EPSFSdfType Type);
+	PROCEDURALSHADERFRAMEWORK_API bool SdfTypeFromString(const FString &Name, EPSFSdfType &OutType);
+
+	PROCEDURALSHADERFRAMEWORK_API const TCHAR *LightingModelToString(EPSFLightingModel Model);
+	PROCEDURALSHADERFRAMEWORK_API bool LightingModelFromString(const FString &Name, EPSFLightingModel &OutModel);
+}
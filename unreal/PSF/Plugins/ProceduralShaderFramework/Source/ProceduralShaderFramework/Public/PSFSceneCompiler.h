@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+struct FPSFCustomSDF;
+
+/**
+ * Static per-step cost of the work that compilation removes, in ALU operations as counted from the HLSL.
+ * The primitive math itself (sdSphere, sdTorus, ...) is identical in both paths and not included.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFSceneCompilerStats
+{
+	int32 NumSDFs = 0;
+
+	/** `s.type == N` compares evalSDF runs before reaching the branch of each SDF */
+	int32 GenericDispatchComparesPerStep = 0;
+
+	/** mul(p - s.position, s.rotation) for every SDF */
+	int32 GenericTransformOpsPerStep = 0;
+
+	/** Transforms left after dropping identity rotations, rotations of spheres and zero translations */
+	int32 CompiledTransformOpsPerStep = 0;
+
+	/** computeRotationMatrix + normalize(axis) of every add* call, paid once per pixel */
+	int32 GenericSetupOpsPerPixel = 0;
+
+	int32 FoldedRotations = 0;
+	int32 FoldedTranslations = 0;
+
+	int32 GenericOpsPerStep() const
+	{
+		return GenericDispatchComparesPerStep + GenericTransformOpsPerStep;
+	}
+};
+
+/**
+ * Compiles a static scene into straight-line HLSL: one function per SDF with position, rotation and
+ * sizes folded in as literals, an unrolled evalCompiledScene without type dispatch and a
+ * raymarchCompiledScene that is a drop-in replacement for the add* calls + raymarchAll.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFSceneCompiler
+{
+public:
+	static const TCHAR *OutputFileName;
+
+	/**
+	 * SourceName is only written into the header comment of the generated file. Custom SDFs call the sd<Name> of their entry
+	 * in CustomSDFs, false if one is not registered.
+	 */
+	static bool Compile(const FPSFScene &Scene, const TArray<FPSFCustomSDF> &CustomSDFs, const FString &SourceName, FString &OutCode, FPSFSceneCompilerStats &OutStats);
+
+	static void LogStats(const FPSFSceneCompilerStats &Stats);
+};
@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PSFScene.h"
+#include "PSFScenePacker.h"
+#include "PSFSceneComponent.generated.h"
+
+class UTexture2D;
+class UTextureRenderTarget2D;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+/**
+ * Holds the SDFs of a scene on the CPU and keeps a texture with the packed scene up to date, so that materials
+ * call loadSceneTexture once instead of building the scene with add* calls in every pixel.
+ *
+ * Edits only mark the scene dirty. The scene is packed at most once per frame in TickComponent and only the
+ * texels that changed are uploaded. Swimming dolphins repack their skeletons every frame, so the shader does not
+ * animate them per pixel. Bound materials get the texture as SceneTextureParameter.
+ *
+ * With a ConePrepassMaterial the component also draws the cone prepass (coneMarchPrepass) into a low resolution
+ * target every tick, bound materials get it as ConeStartParameter for loadConeStart.
+ *
+ * Point lights of the scene are binned into screen tiles for the scene's camera whenever the scene changes (FPSFLightGrid),
+ * bound materials get the grid as LightGridParameter for the *Tiled lighting functions. Scenes without lights get an empty grid.
+ *
+ * With a TemporalDepthMaterial the component draws the hit distances of raymarchAllTemporal into one of two targets every
+ * tick, the other holds the distances of the tick before and is passed back as the history. Bound materials get the new
+ * distances as TemporalDepthParameter for loadTemporalStart.
+ */
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class PROCEDURALSHADERFRAMEWORK_API UPSFSceneComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPSFSceneComponent();
+
+	/** Texture parameter of the bound materials that is passed to loadSceneTexture */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	FName SceneTextureParameter = TEXT("PSFScene");
+
+	/** MAX_SDFS of the bound materials, larger scenes are not uploaded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF", meta = (ClampMin = "1"))
+	int32 MaxSdfs = 20;
+
+	/** MAX_MATERIALS of the bound materials, scenes with more distinct materials are not uploaded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF", meta = (ClampMin = "1"))
+	int32 MaxMaterials = 20;
+
+	/** MAX_DOLPHINS of the bound materials, only as many dolphins get a skeleton computed on the CPU */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF", meta = (ClampMin = "0"))
+	int32 MaxDolphins = 4;
+
+	/** Scene json in the format of the PSFRender commandlet, loaded on BeginPlay */
+	UPROPERTY(EditAnywhere, Category = "PSF", meta = (FilePathFilter = "json"))
+	FFilePath SceneFile;
+
+	/** Material that outputs coneMarchPrepass, it gets the scene texture like a bound material. None disables the prepass */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Cone Prepass")
+	TObjectPtr<UMaterialInterface> ConePrepassMaterial;
+
+	/** Size of the prepass target, a texel per 8x8 pixels of the view is a good start */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Cone Prepass")
+	FIntPoint ConePrepassResolution = FIntPoint(240, 135);
+
+	/** Texture parameter of the bound materials that is passed to loadConeStart */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Cone Prepass")
+	FName ConeStartParameter = TEXT("PSFConeStart");
+
+	/** Vector parameter of the prepass material that is passed to coneMarchPrepass as tileUVSize */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Cone Prepass")
+	FName ConeTileUVSizeParameter = TEXT("PSFConeTileUVSize");
+
+	/** Texture parameter of the bound materials that is passed to the *Tiled lighting functions as lightGrid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Point Lights")
+	FName LightGridParameter = TEXT("PSFLightGrid");
+
+	/** Size of the view the lights are binned for, the tiles of the shader are the same fraction of any other size */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Point Lights")
+	FIntPoint LightGridResolution = FIntPoint(1920, 1080);
+
+	/** Pixels per side of a tile at LightGridResolution */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Point Lights")
+	int32 LightTileSize = 16;
+
+	/**
+	 * Material that outputs temporalDepth of raymarchAllTemporal (or traceWaterTemporal), it gets the scene texture like
+	 * a bound material and the history parameters below. None disables temporal reprojection
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	TObjectPtr<UMaterialInterface> TemporalDepthMaterial;
+
+	/** Size of both depth targets, the history is dropped when it changes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FIntPoint TemporalResolution = FIntPoint(1920, 1080);
+
+	/** Texture parameter of the depth material that is passed to raymarchAllTemporal as history */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FName TemporalHistoryParameter = TEXT("PSFTemporalHistory");
+
+	/** Vector parameter of the depth material with the historyEye, the camera position of the last tick */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FName HistoryEyeParameter = TEXT("PSFHistoryEye");
+
+	/** Prefix of the vector parameters <Prefix>0, 1 and 2 of the depth material with the rows of historyCamera */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FName HistoryCameraParameter = TEXT("PSFHistoryCamera");
+
+	/** Scalar parameter of the depth material that is passed as frame, counts the ticks since the history was dropped */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FName TemporalFrameParameter = TEXT("PSFTemporalFrame");
+
+	/** Texture parameter of the bound materials that is passed to loadTemporalStart */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Temporal")
+	FName TemporalDepthParameter = TEXT("PSFTemporalDepth");
+
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	void BindMaterial(UMaterialInstanceDynamic *Material);
+
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	bool LoadSceneFromJsonFile(const FString &FilePath);
+
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	UTexture2D *GetSceneTexture() const
+	{
+		return SceneTexture;
+	}
+
+	/** Texels uploaded by the last tick, 0 if nothing changed */
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	int32 GetLastUploadedTexels() const
+	{
+		return LastUploadedTexels;
+	}
+
+	int32 AddSdf(const FPSFSdf &Sdf);
+	void SetSdf(int32 Index, const FPSFSdf &Sdf);
+	void RemoveSdf(int32 Index);
+	void SetScene(const FPSFScene &InScene);
+	void SetPointLights(const TArray<FPSFPointLight> &PointLights);
+
+	const FPSFScene &GetScene() const
+	{
+		return Scene;
+	}
+
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	void UploadDirtyRanges();
+	void DrawConePrepass();
+	void UpdateLightGrid();
+	void DrawTemporalDepth();
+
+	FPSFScene Scene;
+	FPSFScenePacker Packer;
+	bool bSceneDirty = true;
+
+	/** The last packed scene exceeded MaxSdfs or MaxMaterials, the one before it stays bound until the next edit */
+	bool bSceneRejected = false;
+	int32 LastUploadedTexels = 0;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> SceneTexture;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> LightGridTexture;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMaterialInstanceDynamic>> BoundMaterials;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTextureRenderTarget2D> ConeStartTarget;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMaterialInstanceDynamic> ConePrepassInstance;
+
+	/** Written and read in turns, TemporalDepthTargets[CurrentTemporalTarget] holds the distances of the last tick */
+	UPROPERTY(Transient)
+	TObjectPtr<UTextureRenderTarget2D> TemporalDepthTargets[2];
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMaterialInstanceDynamic> TemporalDepthInstance;
+
+	int32 CurrentTemporalTarget = 0;
+	int32 TemporalFrame = 0;
+
+	/** Camera of the last depth pass */
+	FVector3f HistoryEye = FVector3f::ZeroVector;
+	FPSFMatrix3 HistoryCamera;
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+struct FPSFDolphinSkeleton;
+
+/** Texels [First, First + Count) of the packed scene */
+struct FPSFTexelRange
+{
+	int32 First = 0;
+	int32 Count = 0;
+};
+
+/** What the shaders can hold, MAX_SDFS, MAX_MATERIALS and MAX_DOLPHINS of global_variables.ush */
+struct FPSFShaderLimits
+{
+	int32 MaxSdfs = 20;
+	int32 MaxMaterials = 20;
+	int32 MaxDolphins = 4;
+};
+
+/**
+ * Packs a scene into float4 texels for loadSceneTexture in sdf_functions.ush and remembers what it packed last,
+ * so that only the texels that changed have to be uploaded. Does not touch the GPU, UPSFSceneComponent owns the texture.
+ *
+ * Texel 0 holds (SDF count, material count, first material texel, SDF capacity). SDF i occupies TexelsPerSdf texels
+ * from 1 + i * TexelsPerSdf: (type, material index, animated), (position, radius), (size, 0), the rotation as quaternion
+ * and the bounding sphere, the same values addSDF writes into sdfRecords, sdfAnimated, sdfPositions, sdfSizes,
+ * sdfRotations and sdfBounds. An SDF is animated if it changed since the last pack or changes with the time in the shader.
+ * Dolphins keep their skeleton slot in size.z, the skeletons at the packed time follow after the SDF capacity,
+ * TexelsPerDolphin texels each. The deduplicated materials follow after the dolphin capacity, TexelsPerMaterial texels each.
+ *
+ * Scenes with more SDFs or distinct materials than the shader limits are rejected, the shader would drop the SDFs past
+ * MAX_SDFS and shade the ones past MAX_MATERIALS with its overflow material. Only the first MAX_DOLPHINS dolphins get a
+ * skeleton, the others keep slot -1 and the shader evaluates them with dolphinDistance at every step.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFScenePacker
+{
+public:
+	static constexpr int32 TexelsPerSdf = 5;
+	static constexpr int32 TexelsPerMaterial = 5;
+	static constexpr int32 TexelsPerDolphin = 19;
+
+	/** Smallest SDF and material capacity, both grow in powers of two */
+	static constexpr int32 MinCapacity = 16;
+
+	/** Dirty texels at most this far apart are uploaded as one range */
+	static constexpr int32 MergeGap = 4;
+
+	/**
+	 * Packs SDFs with the dolphin skeletons at Time, OutRanges are the ranges that differ from the previous call.
+	 * The first call and every capacity change return the whole buffer as one range. False if the scene exceeds the
+	 * shader limits, the texels of the previous call are kept then.
+	 */
+	bool Pack(const TArray<FPSFSdf> &SDFs, TArray<FPSFTexelRange> &OutRanges, double Time = 0.0);
+
+	void SetShaderLimits(const FPSFShaderLimits &Limits)
+	{
+		ShaderLimits = Limits;
+	}
+
+	/** The next Pack returns the whole buffer, after the texture was recreated */
+	void Reset()
+	{
+		Texels.Reset();
+	}
+
+	const TArray<FVector4f> &GetTexels() const
+	{
+		return Texels;
+	}
+
+	int32 GetNumMaterials() const
+	{
+		return NumMaterials;
+	}
+
+	int32 GetNumDolphins() const
+	{
+		return NumDolphins;
+	}
+
+	/** The last pack flagged SDFs because they changed, the next pack clears the flag of the ones that stopped */
+	bool HasMovedSdfs() const
+	{
+		return bHasMovedSdfs;
+	}
+
+	static void PackSdf(const FPSFSdf &Sdf, int32 MaterialIndex, int32 DolphinSlot, FVector4f *OutTexels);
+	static void PackDolphinSkeleton(const FPSFDolphinSkeleton &Skeleton, FVector4f *OutTexels);
+	static void PackMaterial(const FPSFMaterialParams &Material, FVector4f *OutTexels);
+
+	/** Mirrors quaternionFromRotation, rotating by the result equals Rotation.MulRow */
+	static FVector4f QuaternionFromRotation(const FPSFMatrix3 &Rotation);
+
+	/** Conservative world space (center, radius), time independent like computeSDFBounds */
+	static FVector4f ComputeBoundingSphere(const FPSFSdf &Sdf);
+
+private:
+	TArray<FVector4f> Texels;
+	FPSFShaderLimits ShaderLimits;
+	int32 SdfCapacity = 0;
+	int32 MaterialCapacity = 0;
+	int32 DolphinCapacity = 0;
+	int32 NumMaterials = 0;
+	int32 NumDolphins = 0;
+	bool bHasMovedSdfs = false;
+};
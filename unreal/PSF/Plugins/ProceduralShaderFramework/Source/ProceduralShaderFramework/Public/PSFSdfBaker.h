@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+struct FPSFSdfBakeSettings
+{
+	/** Voxels along the longest side of the baked bounds */
+	int32 Resolution = 128;
+
+	/** Bricks closer to the surface than this many voxels store distances, all others only a distance bound */
+	float NarrowBandVoxels = 4.0f;
+
+	/** Space around the primitive bounds, in voxels, so that the band is never cut off by the bounds */
+	float PaddingVoxels = 2.0f;
+
+	/** Random points the baked distance is compared against evalSDF at */
+	int32 ErrorSamples = 200000;
+
+	/** Largest side of the brick index and of the atlas, volume textures are limited to 2048 texels per side */
+	int32 MaxTextureSize = 2048;
+};
+
+/**
+ * Sparse brick map of a static SDF in world space, the layout evalBakedSDF in sdf_functions.ush reads.
+ *
+ * The bounds are split into bricks of BrickSamples^3 distance samples. Neighbouring bricks share their border
+ * samples, so trilinear filtering inside a brick never reads another brick. Only bricks within the narrow band are
+ * stored in the atlas, every brick has a texel in the brick index: xyz is the texel of the brick in the atlas
+ * (x < 0 for bricks that are not stored), w is a signed lower bound of the distance for the ones that are not.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFBakedSdf
+{
+	FVector3f BoundsMin = FVector3f::ZeroVector;
+	float VoxelSize = 0.0f;
+
+	FIntVector BrickCount = FIntVector::ZeroValue;
+	TArray<FVector4f> BrickIndex;
+
+	/** Size of the atlas in bricks */
+	FIntVector AtlasBricks = FIntVector::ZeroValue;
+	TArray<FFloat16> Atlas;
+
+	int32 NumAllocatedBricks = 0;
+
+	FIntVector GetAtlasSize() const;
+
+	/** The bakeOrigin argument of evalBakedSDF: bounds min and voxel size */
+	FVector4f GetBakeOrigin() const
+	{
+		return FVector4f(BoundsMin, VoxelSize);
+	}
+
+	int64 GetNumBytes() const
+	{
+		return int64(BrickIndex.Num()) * sizeof(FVector4f) + int64(Atlas.Num()) * sizeof(FFloat16);
+	}
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFSdfBakeStats
+{
+	double Seconds = 0.0;
+
+	/** evalSDF calls of the bake, classification and brick samples */
+	int64 SdfEvaluations = 0;
+
+	int32 TotalBricks = 0;
+	int32 AllocatedBricks = 0;
+
+	/** Size of the brick map and of a dense volume with one half float per voxel at the same resolution */
+	int64 BakedBytes = 0;
+	int64 DenseBytes = 0;
+
+	/** Error against evalSDF at random points inside the narrow band */
+	int32 BandSamples = 0;
+	float MaxError = 0.0f;
+	float RmsError = 0.0f;
+
+	/** Largest amount the baked distance exceeds evalSDF outside the band, where it is only a bound */
+	float MaxOvershoot = 0.0f;
+
+	/** CPU cost of one evaluation at the error sample points */
+	double AnalyticNsPerEval = 0.0;
+	double BakedNsPerEval = 0.0;
+};
+
+/**
+ * Bakes static primitives (rock, desert, anything evalSDF can evaluate on the CPU) into sparse brick maps, so a
+ * material samples a texture instead of running the noise of the primitive on every step. Bricks are sampled in
+ * parallel. Dolphins move and custom SDFs only exist as HLSL, neither can be baked.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFSdfBaker
+{
+public:
+	/** Distance samples per brick side, 7 voxels plus the border shared with the next brick */
+	static constexpr int32 BrickSamples = 8;
+
+	static bool CanBake(const FPSFSdf &Sdf);
+
+	/**
+	 * Bakes Sdf inside Bounds, an invalid box uses the bounds of the primitive. False for unbounded primitives without bounds
+	 * and when the brick index or the atlas would exceed Settings.MaxTextureSize on a side.
+	 */
+	static bool Bake(const FPSFSdf &Sdf, const FBox3f &Bounds, const FPSFSdfBakeSettings &Settings, FPSFBakedSdf &OutBaked, FPSFSdfBakeStats &OutStats);
+
+	/** Mirrors evalBakedSDF, including the half float storage of the atlas */
+	static float Sample(const FPSFBakedSdf &Baked, const FVector3f &P);
+
+	/** Fills the error and cost part of Stats by comparing Baked to evalSDF at random points inside its bounds */
+	static void MeasureError(const FPSFSdf &Sdf, const FPSFBakedSdf &Baked, const FPSFSdfBakeSettings &Settings, FPSFSdfBakeStats &InOutStats);
+
+	static void LogStats(const FPSFSdfBakeStats &Stats);
+};
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFScene.h"
+
+/** Mirrors DolphinSkeleton of helper_functions.ush, the time dependent part of dolphinDistance */
+struct FPSFDolphinSkeleton
+{
+	static constexpr int32 NumSegments = 11;
+
+	/** Start point of every segment and end point of the last one */
+	FVector3f Joints[NumSegments + 1];
+
+	/** Frames of segment 4 (dorsal fin) and segment 3 (flippers) */
+	FPSFMatrix3 FinFrame;
+	FPSFMatrix3 FlipperFrame;
+
+	/** Normalized direction of the last segment */
+	FVector3f TailDirection = FVector3f::ZeroVector;
+};
+
+/**
+ * CPU ports of the SDF primitives in helper_functions.ush and of evalSDF / get_normal in sdf_functions.ush.
+ */
+namespace PSFSdf
+{
+	PROCEDURALSHADERFRAMEWORK_API float SdBox(const FVector3f &P, const FVector3f &B);
+	PROCEDURALSHADERFRAMEWORK_API float SdSphere(const FVector3f &P, float Radius);
+	PROCEDURALSHADERFRAMEWORK_API float SdRoundBox(const FVector3f &P, const FVector3f &B, float R);
+	PROCEDURALSHADERFRAMEWORK_API float SdTorus(const FVector3f &P, const FVector2f &Radius);
+	PROCEDURALSHADERFRAMEWORK_API float SdHexPrism(const FVector3f &P, const FVector2f &Height);
+	PROCEDURALSHADERFRAMEWORK_API float SdOctahedron(const FVector3f &P, float S);
+	PROCEDURALSHADERFRAMEWORK_API float SdEllipsoid(const FVector3f &P, const FVector3f &R);
+
+	PROCEDURALSHADERFRAMEWORK_API FVector3f DolphinMovement(float TimeOffset, const FVector3f &BasePosition, float Speed, double Time);
+	PROCEDURALSHADERFRAMEWORK_API FPSFDolphinSkeleton ComputeDolphinSkeleton(const FVector3f &Position, float TimeOffset, float Speed, double Time);
+	PROCEDURALSHADERFRAMEWORK_API FVector2f DolphinSkeletonDistance(const FVector3f &P, const FPSFDolphinSkeleton &Skeleton);
+	PROCEDURALSHADERFRAMEWORK_API FVector2f DolphinDistance(const FVector3f &P, const FVector3f &Position, float TimeOffset, float Speed, double Time);
+
+	PROCEDURALSHADERFRAMEWORK_API float MapDesert(const FVector3f &P);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f DoBumpMap(const FVector3f &P, const FVector3f &Normal, float BumpFactor);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f GetDesertColor(const FVector3f &P);
+
+	/** Mirrors evalSDF. Custom SDFs only exist as HLSL and evaluate to the same 1e5 miss value as an unknown type. */
+	PROCEDURALSHADERFRAMEWORK_API float EvalSDF(const FPSFSdf &Sdf, const FVector3f &P, float Time = 0.0f);
+
+	/** Mirrors get_normal, including its use of evalSDF's default time of 0 */
+	PROCEDURALSHADERFRAMEWORK_API FVector3f GetNormal(const FPSFSdf &Sdf, const FVector3f &P);
+}
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFShaderGraph.h"
+
+enum class EPSFShaderBackend : uint8
+{
+	/** .ush for Custom nodes, HLSL as written */
+	Unreal,
+
+	/** .hlsl for Custom Function nodes and includes, HLSL with the constants the engine does not define */
+	Unity,
+
+	/** .gdshaderinc, translated to Godot's shading language */
+	Godot,
+
+	/** .glsl in the dialect of the shaders/ library */
+	GLSL
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFShaderBackendConfig
+{
+	EPSFShaderBackend Backend = EPSFShaderBackend::Unreal;
+
+	/** Extra defines as NAME=VALUE (or NAME for 1), known before the first line of the library */
+	TArray<FString> Defines;
+
+	/**
+	 * The output is the whole program: a macro the library does not define is undefined, so every conditional folds.
+	 * Without it only the conditionals over known defines fold and the rest stays for the includer to decide.
+	 */
+	bool bClosedWorld = false;
+
+	/** Lower case name as used in -Backends= and the report */
+	static const TCHAR *GetName(EPSFShaderBackend Backend);
+
+	/** File extension of the generated library, without the dot */
+	static const TCHAR *GetExtension(EPSFShaderBackend Backend);
+
+	static bool ParseBackend(const FString &Name, EPSFShaderBackend &OutBackend);
+
+	static FPSFShaderBackendConfig Create(EPSFShaderBackend Backend);
+};
+
+/** A function that has to reach the output of every backend, e.g. the baked or relaxed variant of a hot path */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFFastPathResult
+{
+	FString Function;
+
+	/** emitted, stripped (not reachable from the entry points), unsupported (by the backend) or missing (not in the library) */
+	FString Status;
+
+	FString Reason;
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFUnsupportedChunk
+{
+	FString Name;
+	FString Reason;
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFShaderGeneratorResult
+{
+	EPSFShaderBackend Backend = EPSFShaderBackend::Unreal;
+	FString Code;
+	double Seconds = 0.0;
+
+	/** The library as written against the generated one */
+	int32 FunctionsSource = 0;
+	int32 FunctionsEmitted = 0;
+	int32 LinesSource = 0;
+	int32 LinesEmitted = 0;
+	int32 BytesSource = 0;
+	int32 BytesEmitted = 0;
+
+	/** #if / #ifdef / #ifndef blocks decided during generation and left to the shader compiler */
+	int32 ConditionalsFolded = 0;
+	int32 ConditionalsKept = 0;
+
+	/** Translated backends only, see FPSFShaderTranslator */
+	int32 IntrinsicsMapped = 0;
+	int32 EmulatedCalls = 0;
+	int32 Conversions = 0;
+
+	TArray<FPSFUnsupportedChunk> Unsupported;
+	TArray<FPSFFastPathResult> FastPaths;
+
+	/** A fast path that is reachable but not emitted, or a conditional left in a closed world */
+	bool HasProblems(const FPSFShaderBackendConfig &Config) const;
+};
+
+/**
+ * Generates the shader library of every engine from the Unreal .ush files, so that a change to the library only has
+ * to be made once.
+ *
+ * Every backend gets its own specialized copy: the conditionals over its defines are folded (PSF_BACKEND_<NAME> is 1
+ * for the backend and 0 for the others), functions that are not reachable from the entry points are removed and the
+ * GLSL dialects call the native intrinsics. The Godot backend is checked in as godot/addons/includes/generated, the
+ * hand-maintained trees under unity/ and shaders/ are not touched.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFShaderGenerator
+{
+public:
+	/** Functions that the default report checks, one per optimized path of the library */
+	static const TArray<FString> &GetDefaultFastPaths();
+
+	/** Parses RootFile and everything it includes from ShaderDir */
+	bool LoadFromDirectory(const FString &ShaderDir, const FString &RootFile);
+
+	/** Without entry points every function is kept */
+	FPSFShaderGeneratorResult Generate(const FPSFShaderBackendConfig &Config, const TArray<FString> &EntryPoints, const TArray<FString> &FastPaths) const;
+
+	static FString ToJsonString(const TArray<FPSFShaderGeneratorResult> &Results);
+
+	static void LogResult(const FPSFShaderGeneratorResult &Result);
+
+private:
+	/** Folds the conditionals of every file in include order and parses the result into OutGraph */
+	void Specialize(const FPSFShaderBackendConfig &Config, FPSFShaderGraph &OutGraph, FPSFShaderGeneratorResult &OutResult) const;
+
+	FPSFShaderGraph Source;
+	FString Root;
+};
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EPSFShaderChunkType : uint8
+{
+	/** A directive, for #include the include target is the chunk name */
+	Preprocessor,
+
+	/** Everything that ends with ; at the top level or is a struct / cbuffer, always kept */
+	Declaration,
+
+	/** A function definition, only kept if it is reachable from an entry point */
+	Function
+};
+
+/** A top level piece of a shader file, including the comments and whitespace in front of it */
+struct FPSFShaderChunk
+{
+	EPSFShaderChunkType Type = EPSFShaderChunkType::Declaration;
+	FString Text;
+	FString Name;
+
+	/** Identifiers outside of comments and strings, members after a . are skipped */
+	TSet<FString> Identifiers;
+};
+
+struct FPSFShaderFile
+{
+	FString Name;
+	TArray<FPSFShaderChunk> Chunks;
+
+	/** Clean file names of the #include targets, in include order */
+	TArray<FString> Includes;
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFAmalgamationStats
+{
+	int32 Files = 0;
+	int32 FunctionsTotal = 0;
+	int32 FunctionsKept = 0;
+	int32 BytesTotal = 0;
+	int32 BytesKept = 0;
+	int32 LinesTotal = 0;
+	int32 LinesKept = 0;
+};
+
+/**
+ * Include graph and function call graph of the framework's .ush files.
+ *
+ * The parser only understands the top level of a file: directives, declarations, structs and function
+ * definitions. Calls are found by name, so overloads are kept or dropped together and a function that is
+ * referenced from a declaration or a macro is always kept.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFShaderGraph
+{
+public:
+	/** Parses RootFile and everything it includes from ShaderDir */
+	bool LoadFromDirectory(const FString &ShaderDir, const FString &RootFile);
+
+	/** Parses a file without touching the disk, includes are resolved against the files added so far and later */
+	void AddFile(const FString &FileName, const FString &Content);
+
+	/** Files reachable from Root, every file after the files it includes */
+	TArray<FString> GetIncludeOrder(const FString &Root) const;
+
+	/** Functions called by Function, by name */
+	TArray<FString> GetCallees(const FString &Function) const;
+
+	bool HasFunction(const FString &Function) const
+	{
+		return FunctionFiles.Contains(Function);
+	}
+
+	/** Content of a parsed file, empty if it is not part of the graph */
+	FString GetFileText(const FString &FileName) const;
+
+	/** Functions needed by EntryPoints, false if an entry point does not exist */
+	bool CollectReachable(const FString &Root, const TArray<FString> &EntryPoints, TSet<FString> &OutFunctions, TArray<FString> &OutMissing) const;
+
+	/**
+	 * Root and its includes as a single header with the include lines resolved and every function that is not
+	 * reachable from EntryPoints removed. The include guards of the files stay, so it replaces procedural_shader.ush
+	 * in a material but can not be mixed with it.
+	 */
+	FString Amalgamate(const FString &Root, const TArray<FString> &EntryPoints, FPSFAmalgamationStats &OutStats) const;
+
+	/**
+	 * The chunks that Amalgamate writes, in include order and without the resolved include lines. Without entry points
+	 * every function is kept.
+	 */
+	TArray<const FPSFShaderChunk *> CollectChunks(const FString &Root, const TArray<FString> &EntryPoints, FPSFAmalgamationStats &OutStats) const;
+
+	/** Include and call graph as json, for inspection and tooling */
+	FString ToJsonString() const;
+
+	static void LogStats(const FPSFAmalgamationStats &Stats);
+
+private:
+	void VisitIncludes(const FString &File, TSet<FString> &Visited, TArray<FString> &OutOrder) const;
+	FString ResolveInclude(const FString &Target) const;
+
+	TMap<FString, FPSFShaderFile> Files;
+
+	/** Files that define a function, more than one entry for overloads across files */
+	TMap<FString, TArray<FString>> FunctionFiles;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * HLSL intrinsics with HLSL semantics on UE vector types.
+ * Used by the CPU ports of the shader library so that they read like the .ush code they mirror.
+ */
+namespace PSFShaderMath
+{
+	FORCEINLINE float Frac(float X)
+	{
+		return X - FMath::FloorToFloat(X);
+	}
+
+	/** HLSL fmod: the result has the sign of X */
+	FORCEINLINE float FMod(float X, float Y)
+	{
+		return FMath::Fmod(X, Y);
+	}
+
+	FORCEINLINE float Saturate(float X)
+	{
+		return FMath::Clamp(X, 0.0f, 1.0f);
+	}
+
+	FORCEINLINE float SmoothStep(float Edge0, float Edge1, float X)
+	{
+		const float T = Saturate((X - Edge0) / (Edge1 - Edge0));
+		return T * T * (3.0f - 2.0f * T);
+	}
+
+	FORCEINLINE FVector3f Floor(const FVector3f &V)
+	{
+		return FVector3f(FMath::FloorToFloat(V.X), FMath::FloorToFloat(V.Y), FMath::FloorToFloat(V.Z));
+	}
+
+	FORCEINLINE FVector3f Frac(const FVector3f &V)
+	{
+		return FVector3f(Frac(V.X), Frac(V.Y), Frac(V.Z));
+	}
+
+	FORCEINLINE FVector3f Abs(const FVector3f &V)
+	{
+		return FVector3f(FMath::Abs(V.X), FMath::Abs(V.Y), FMath::Abs(V.Z));
+	}
+
+	FORCEINLINE FVector3f Max(const FVector3f &V, float S)
+	{
+		return FVector3f(FMath::Max(V.X, S), FMath::Max(V.Y, S), FMath::Max(V.Z, S));
+	}
+
+	FORCEINLINE FVector2f Max(const FVector2f &V, float S)
+	{
+		return FVector2f(FMath::Max(V.X, S), FMath::Max(V.Y, S));
+	}
+
+	FORCEINLINE float MaxComponent(const FVector3f &V)
+	{
+		return FMath::Max(V.X, FMath::Max(V.Y, V.Z));
+	}
+
+	FORCEINLINE FVector3f Lerp(const FVector3f &A, const FVector3f &B, float T)
+	{
+		return A + (B - A) * T;
+	}
+
+	FORCEINLINE FVector3f Pow(const FVector3f &V, float E)
+	{
+		return FVector3f(FMath::Pow(V.X, E), FMath::Pow(V.Y, E), FMath::Pow(V.Z, E));
+	}
+
+	FORCEINLINE FVector3f Exp(const FVector3f &V)
+	{
+		return FVector3f(FMath::Exp(V.X), FMath::Exp(V.Y), FMath::Exp(V.Z));
+	}
+
+	/** HLSL normalize, without UE's safe-normal fallback so that NaNs propagate like on the GPU */
+	FORCEINLINE FVector3f Normalize(const FVector3f &V)
+	{
+		return V * FMath::InvSqrt(V | V);
+	}
+
+	FORCEINLINE FVector3f Reflect(const FVector3f &I, const FVector3f &N)
+	{
+		return I - N * (2.0f * (N | I));
+	}
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PSFTimelineComponent.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialParameterCollection;
+
+/** The shader function a track replaces */
+UENUM(BlueprintType)
+enum class EPSFTimelineTrackType : uint8
+{
+	/** tween1D / tween3D from Start to End */
+	Tween,
+
+	/** Tweens from key to key, the tween type of a key eases the segment that starts at it */
+	Keyframes,
+
+	/** orbitObjectAroundPoint of Start, the angle in degrees is written to <Parameter>Angle */
+	Orbit,
+
+	/** shakeObject around Start */
+	Shake,
+
+	/** cycleColor of the color Start */
+	CycleColor
+};
+
+USTRUCT(BlueprintType)
+struct FPSFTweenKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	float Time = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	FVector Value = FVector::ZeroVector;
+
+	/** TWEEN_* type of tween_functions.ush */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF", meta = (ClampMin = "0", ClampMax = "30"))
+	int32 TweenType = 0;
+};
+
+/** One animated material parameter, the arguments are the ones of the shader function of Type */
+USTRUCT(BlueprintType)
+struct PROCEDURALSHADERFRAMEWORK_API FPSFTimelineTrack
+{
+	GENERATED_BODY()
+
+	/** Scalar or vector parameter of the collection and the bound materials */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	FName Parameter;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	EPSFTimelineTrackType Type = EPSFTimelineTrackType::Tween;
+
+	/** Writes X as a scalar parameter instead of a vector */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	bool bScalar = false;
+
+	/** Start of a tween, the seed position of an orbit or shake and the seed color of a color cycle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	FVector Start = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Tween")
+	FVector End = FVector::OneVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Tween")
+	float Duration = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Tween", meta = (ClampMin = "0", ClampMax = "30"))
+	int32 TweenType = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Tween")
+	float StartTime = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Tween")
+	bool bPingPong = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Keyframes")
+	TArray<FPSFTweenKey> Keys;
+
+	/** Start over after the last key instead of holding it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Keyframes")
+	bool bLoop = true;
+
+	/** Speed of orbits, shakes and color cycles */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	float Speed = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	FVector Center = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	FVector Axis = FVector(0.0, 1.0, 0.0);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	float Radius = 1.0f;
+
+	/** Orbit start angle in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	float AngleOffset = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF|Animation")
+	float Intensity = 0.1f;
+
+	/** Value at Time as the shader function computes it, W holds the orbit angle */
+	FVector4f Evaluate(float Time) const;
+};
+
+/**
+ * Evaluates tweens and animations once per frame on the CPU and writes the results into material parameters, so that
+ * materials read a uniform instead of running tween3D, orbitObjectAroundPoint etc. in every pixel.
+ *
+ * Time is the world time, the same as the Time node of the materials. Values go into ParameterCollection (the
+ * parameters have to exist in it) and into every bound material instance.
+ *
+ * The module is an Editor module, so the component works in the editor and PIE but is not part of packaged games.
+ */
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class PROCEDURALSHADERFRAMEWORK_API UPSFTimelineComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPSFTimelineComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	TArray<FPSFTimelineTrack> Tracks;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PSF")
+	TObjectPtr<UMaterialParameterCollection> ParameterCollection;
+
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	void BindMaterial(UMaterialInstanceDynamic *Material);
+
+	/** Evaluates every track at Time and writes the values, TickComponent calls it with the world time */
+	UFUNCTION(BlueprintCallable, Category = "PSF")
+	void ApplyTracks(float Time);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMaterialInstanceDynamic>> BoundMaterials;
+};
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * CPU ports of tween_functions.ush. The tween types are the TWEEN_* defines of the shader.
+ */
+namespace PSFTween
+{
+	/** TWEEN_BOUNCE_INOUT, the last tween type */
+	constexpr int32 MaxTweenType = 30;
+
+	/** Mirrors applyTweenFunction, unknown types are linear */
+	PROCEDURALSHADERFRAMEWORK_API float ApplyTweenFunction(float T, int32 TweenType);
+
+	/** Mirrors getTweenProgress */
+	PROCEDURALSHADERFRAMEWORK_API float GetTweenProgress(float StartTime, float Duration, bool bPingPong, float Time);
+
+	/** Mirror tween1D and tween3D */
+	PROCEDURALSHADERFRAMEWORK_API float Tween1D(float Start, float End, float Duration, int32 TweenType, float StartTime, bool bPingPong, float Time);
+	PROCEDURALSHADERFRAMEWORK_API FVector3f Tween3D(const FVector3f &Start, const FVector3f &End, float Duration, int32 TweenType, float StartTime, bool bPingPong, float Time);
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PSFCpuRaymarcher.h"
+
+/**
+ * CPU ports of the wave functions in water_functions.ush.
+ */
+namespace PSFWater
+{
+	constexpr int32 NumWaveOctaves = 7;
+
+	/** Mirrors hashNoise */
+	PROCEDURALSHADERFRAMEWORK_API float HashNoise(const FVector3f &P);
+
+	/** The terms of the octave loop of computeWave, their sum is waveStrength */
+	PROCEDURALSHADERFRAMEWORK_API void ComputeWaveOctaves(const FVector3f &Position, float Time, float OutOctaves[NumWaveOctaves]);
+
+	/** Mirrors computeWave without the waveStrength side output */
+	PROCEDURALSHADERFRAMEWORK_API float ComputeWave(const FVector3f &Position, float Time);
+
+	/** Mirrors traceWater, Start holds the march strategy. Returns the hit position and t, OutSteps the march steps */
+	PROCEDURALSHADERFRAMEWORK_API FVector4f TraceWater(const FVector3f &RayOrigin, const FVector3f &RayDirection, float Time, float StoppingCriterium, const FPSFMarchState &Start,
+		int32 &OutSteps);
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPSFWaveBakeSettings
+{
+	/** Texels per side of the tile */
+	int32 Resolution = 1024;
+
+	/** World size of the tile, the field repeats after it in x and z */
+	float TileSize = 64.0f;
+
+	/** computeWave octaves stored in the red channel, the remaining ones go into green and fade out with distance */
+	int32 CoarseOctaves = 3;
+
+	/** Random positions the statistics of the baked field are compared at */
+	int32 StatisticsSamples = 100000;
+};
+
+/**
+ * Tileable RGBA16F field of the computeWave octaves, the layout computeWaveBaked in water_functions.ush reads:
+ * r = coarse octaves, g = fine octaves, ba = the differences of both over +-1 in x and z that getNormal(p, 1) needs.
+ *
+ * computeWave only depends on time through a scroll in z (and a rotation of at most 0.001 radians that the bake
+ * leaves out), so one tile covers the whole period. The octaves are evaluated on the wave surface of every texel.
+ */
+struct PROCEDURALSHADERFRAMEWORK_API FPSFBakedWaves
+{
+	int32 Resolution = 0;
+	float TileSize = 0.0f;
+	int32 CoarseOctaves = 0;
+	TArray<FFloat16> Texels;
+
+	/** Bilinear and wrapping like the sampler of the texture */
+	FVector4f Sample(float X, float Z) const;
+};
+
+struct PROCEDURALSHADERFRAMEWORK_API FPSFWaveBakeStats
+{
+	double Seconds = 0.0;
+
+	/** computeWave octave loops of the bake, including the search for the surface */
+	int64 WaveEvaluations = 0;
+
+	int64 Bytes = 0;
+
+	/** Mean and standard deviation of waveStrength, the crossfade that makes the tile repeat must not flatten the waves */
+	float AnalyticMean = 0.0f;
+	float AnalyticStdDev = 0.0f;
+	float BakedMean = 0.0f;
+	float BakedStdDev = 0.0f;
+
+	/** CPU cost of one computeWave */
+	double AnalyticNsPerEval = 0.0;
+	double BakedNsPerEval = 0.0;
+};
+
+/**
+ * Bakes the water waves into a tileable texture so that traceWater, getNormal and adaptableWaterNormal sample
+ * it instead of running the 7 octave hashNoise loop on every call. Rows are baked in parallel.
+ */
+class PROCEDURALSHADERFRAMEWORK_API FPSFWaveBaker
+{
+public:
+	static bool Bake(const FPSFWaveBakeSettings &Settings, FPSFBakedWaves &OutBaked, FPSFWaveBakeStats &OutStats);
+
+	/** Mirrors computeWaveBaked, the fine octaves fade out between FadeStart and FadeEnd */
+	static float ComputeWave(const FPSFBakedWaves &Baked, const FVector3f &Position, float Time, float Distance, float FadeStart, float FadeEnd);
+
+	/** Fills the statistics and cost part of Stats */
+	static void MeasureStatistics(const FPSFBakedWaves &Baked, const FPSFWaveBakeSettings &Settings, FPSFWaveBakeStats &InOutStats);
+
+	static void LogStats(const FPSFWaveBakeStats &Stats);
+};
@@ -6,8 +6,13 @@
 #include "Misc/Paths.h"
 #include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
-#include "Interfaces/IPluginManager.h"
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+#include "HAL/CriticalSection.h"
+#include "Widgets/Notifications/SNotificationList.h"
 #include "Widgets/Input/SMultiLineEditableTextBox.h"
+#include "Widgets/Input/SEditableTextBox.h"
+#include <atomic>
 
 
 class FToolBarBuilder;
@@ -25,48 +30,49 @@ private:
     /** This function will be bound to Command (by default it will bring up plugin window) */
     void PluginButtonClicked();
     TSharedPtr<SMultiLineEditableTextBox> MultiLineTextBox;
+    TSharedPtr<SEditableTextBox> CustomSDFNameTextBox;
+    TSharedPtr<SEditableTextBox> ScenePathTextBox;
+    TSharedPtr<class SPSFMarchStatsWidget> MarchStatsWidget;
     FString ShaderDir;
-private:
 
-    void RegisterMenus();
+    /** Shader sync that runs off the startup path, waited for on shutdown */
+    TFuture<void> ShaderSyncTask;
 
-    TSharedRef<class SDockTab> OnSpawnPluginTab(const class FSpawnTabArgs &SpawnTabArgs);
+    /** Held by everything that writes the project Shaders/ dir, the startup sync and the custom SDF generation */
+    FCriticalSection ShaderFileLock;
 
-private:
-    TSharedPtr<class FUICommandList> PluginCommands;
-
-    void WriteShaderFunctionToFile();
-    void GenerateMaterialFunction();
-    void ReplaceBetweenMarkers(const FString &StartMarker, const FString &EndMarker, const FString &Replacement);
+    /** Custom SDF generation: a click bumps the generation, stages of older generations stop at their next check */
+    static constexpr float GenerateDebounceSeconds = 0.4f;
+    std::atomic<uint32> LatestGeneration {0};
+    FTSTicker::FDelegateHandle GenerateDebounceHandle;
 
-};
+    /** Every generation worker that may still run, they all hold this and are waited for on shutdown. Game thread only. */
+    TArray<TFuture<void>> GenerateTasks;
 
+    /** Set when a worker rewrote shader files, cleared once a material function was updated with a recompile */
+    std::atomic<bool> bShaderFilesDirty {false};
+    TWeakPtr<SNotificationItem> GenerateNotification;
+private:
 
-void CopyShaderFilesToProject()
-{
-    FString PluginShaderDir = FPaths::Combine(IPluginManager::Get().FindPlugin(TEXT("ProceduralShaderFramework"))->GetBaseDir(), TEXT("Shaders"));
-    FString ProjectShaderDir = FPaths::ProjectDir() / TEXT("Shaders");
+    void RegisterMenus();
 
-    UE_LOG(LogTemp, Log, TEXT("COPY SHADERS CALLED"));
+    TSharedRef<class SDockTab> OnSpawnPluginTab(const class FSpawnTabArgs &SpawnTabArgs);
 
-    IFileManager &FileManager = IFileManager::Get();
+private:
+    TSharedPtr<class FUICommandList> PluginCommands;
 
-    // Ensure project shader dir exists
-    FileManager.MakeDirectory(*ProjectShaderDir, true);
+    /** Restarts the debounce timer, the generation starts once the button was not pressed for GenerateDebounceSeconds */
+    void RequestGenerate();
+    void StartGenerate(uint32 Generation, const FString &Name, const FString &UserCode);
+    void SetGenerateProgress(const FString &Text, SNotificationItem::ECompletionState State);
 
-    // List .ush files in plugin shader folder
-    TArray<FString> ShaderFiles;
-    FileManager.FindFiles(ShaderFiles, *PluginShaderDir, TEXT("*.ush"));
+    /** Runs on a worker thread, registers the SDF and bOutChanged tells whether a shader file was rewritten */
+    bool WriteShaderFunctionToFile(const FString &Name, const FString &UserCode, struct FPSFCustomSDF &OutSdf, bool &bOutChanged);
+    void CompileSceneToShader();
 
-    for(const FString &FileName : ShaderFiles)
-    {
-        FString SourceFile = FPaths::Combine(PluginShaderDir, FileName);
-        FString DestFile = FPaths::Combine(ProjectShaderDir, FileName);
+    /** Renders the scene of ScenePathTextBox at ProfileResolution on the CPU and shows its march counters */
+    static constexpr int32 ProfileResolution = 256;
+    void ProfileScene();
 
+};
 
-        // Overwrite if different or not exists
-        
-        UE_LOG(LogTemp, Log, TEXT("Copying %s -> %s"), *SourceFile, *DestFile);
-        FileManager.Copy(*DestFile, *SourceFile);
-    }
-}
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+
+struct FPSFScene;
+struct FPSFMarchProfile;
+class STextBlock;
+class SVerticalBox;
+
+/**
+ * Stats panel of the march counters of one CPU frame: totals and exits, histograms of steps and SDF evaluations per pixel
+ * and what every SDF of the scene cost, with the most expensive one highlighted.
+ */
+class PROCEDURALSHADERFRAMEWORK_API SPSFMarchStatsWidget : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPSFMarchStatsWidget)
+	{}
+	SLATE_END_ARGS()
+
+	/** Constructs this widget with InArgs */
+	void Construct(const FArguments &InArgs);
+
+	/** Replaces the shown stats with those of a profile rendered from Scene */
+	void SetProfile(const FPSFScene &Scene, const FPSFMarchProfile &Profile);
+
+private:
+	TSharedPtr<STextBlock> TotalsText;
+	TSharedPtr<class SPSFHistogram> StepHistogram;
+	TSharedPtr<class SPSFHistogram> EvaluationHistogram;
+	TSharedPtr<SVerticalBox> SdfRows;
+};
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFBvh.h"
+#include "PSFSdfFunctions.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	/** Rotation about y, FPSFMatrix3::FromAxisAngle lives with the json code the tests do not build */
+	FPSFMatrix3 RotationY(float Angle)
+	{
+		const float C = FMath::Cos(Angle);
+		const float S = FMath::Sin(Angle);
+		return FPSFMatrix3(FVector3f(C, 0.0f, S), FVector3f(0.0f, 1.0f, 0.0f), FVector3f(-S, 0.0f, C));
+	}
+
+	/**
+	 * Random primitives whose evalSDF is the exact distance, the BVH then culls without changing the minimum.
+	 * The desert has no bounds and is never culled.
+	 */
+	FPSFScene MakeRandomScene(int32 Count)
+	{
+		const EPSFSdfType Types[] = {EPSFSdfType::Sphere, EPSFSdfType::RoundBox, EPSFSdfType::Torus, EPSFSdfType::HexPrism};
+
+		FRandomStream Random(7);
+		FPSFScene Scene;
+		for(int32 Index = 0; Index < Count; ++Index)
+		{
+			FPSFSdf &Sdf = Scene.SDFs.AddDefaulted_GetRef();
+			Sdf.Type = Types[Index % UE_ARRAY_COUNT(Types)];
+			Sdf.Position = FVector3f(Random.FRand(), Random.FRand(), Random.FRand()) * 20.0f - 10.0f;
+			Sdf.Size = FVector3f(0.3f + Random.FRand(), 0.3f + Random.FRand(), 0.1f + 0.3f * Random.FRand());
+			Sdf.Radius = 0.1f + 0.6f * Random.FRand();
+			Sdf.Rotation = RotationY(Random.FRand() * UE_TWO_PI);
+		}
+
+		FPSFSdf &Desert = Scene.SDFs.AddDefaulted_GetRef();
+		Desert.Type = EPSFSdfType::Desert;
+		Desert.Position = FVector3f(0.0f, -12.0f, 0.0f);
+		return Scene;
+	}
+}
+
+PSF_TEST(BvhEvalSceneMatchesEveryPrimitive)
+{
+	const FPSFScene Scene = MakeRandomScene(40);
+	FPSFBvh Bvh;
+	Bvh.Build(Scene, 0.0f);
+	PSF_REQUIRE(!Bvh.IsEmpty());
+
+	FRandomStream Random(11);
+	int64 Evaluations = 0;
+	const int32 Points = 2000;
+	for(int32 Point = 0; Point < Points; ++Point)
+	{
+		const FVector3f P = FVector3f(Random.FRand(), Random.FRand(), Random.FRand()) * 28.0f - 14.0f;
+
+		float Expected = 1e5f;
+		int32 ExpectedIndex = INDEX_NONE;
+		for(int32 Index = 0; Index < Scene.SDFs.Num(); ++Index)
+		{
+			const float D = PSFSdf::EvalSDF(Scene.SDFs[Index], P, 0.0f);
+			if(D < Expected)
+			{
+				Expected = D;
+				ExpectedIndex = Index;
+			}
+		}
+
+		int32 Index = INDEX_NONE;
+		const float D = Bvh.EvalScene(Scene, P, 0.0f, Index, Evaluations);
+		PSF_EXPECT_EQ(D, Expected);
+		PSF_EXPECT_EQ(Index, ExpectedIndex);
+	}
+
+	// the culling has to skip primitives to be worth it
+	PSF_EXPECT(Evaluations < int64(Points) * Scene.SDFs.Num() / 2);
+}
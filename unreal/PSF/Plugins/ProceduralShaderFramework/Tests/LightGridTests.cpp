@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFLightGrid.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	/** FPSFScene::ComputeCameraMatrix, which lives with the json code the tests do not build */
+	FPSFMatrix3 LookAtMatrix(const FVector3f &Eye, const FVector3f &Target)
+	{
+		const FVector3f Forward = (Target - Eye).GetSafeNormal();
+		const FVector3f Right = (Forward ^ FVector3f(0, 1, 0)).GetSafeNormal();
+		const FVector3f Up = Right ^ Forward;
+		return FPSFMatrix3(Right, Up, -Forward);
+	}
+
+	/** Whether the ray from Origin along Direction passes within the radius of the light, only in front of the origin */
+	bool RayReachesLight(const FVector3f &Origin, const FVector3f &Direction, const FPSFPointLight &Light)
+	{
+		const FVector3f Offset = Light.Position - Origin;
+		const float T = FMath::Max(Offset | Direction, 0.0f);
+		return FVector3f::DistSquared(Origin + Direction * T, Light.Position) <= Light.Radius * Light.Radius;
+	}
+}
+
+PSF_TEST(LightGridTilesHoldEveryLightTheirPixelsReach)
+{
+	FRandomStream Random(3);
+	TArray<FPSFPointLight> Lights;
+	for(int32 Index = 0; Index < 300; ++Index)
+	{
+		FPSFPointLight &Light = Lights.AddDefaulted_GetRef();
+		Light.Position = FVector3f(Random.FRand(), Random.FRand(), Random.FRand()) * 30.0f - 15.0f;
+		Light.Radius = 0.2f + 2.0f * Random.FRand();
+	}
+
+	const FVector3f Eye(0.0f, 2.0f, 9.0f);
+	const FPSFMatrix3 CameraMatrix = LookAtMatrix(Eye, FVector3f::ZeroVector);
+	const int32 Width = 96, Height = 72, TileSize = 16;
+	FPSFLightGrid Grid;
+	Grid.Build(Lights, Eye, CameraMatrix, Width, Height, TileSize);
+	PSF_REQUIRE(Grid.GetTilesX() == 6 && Grid.GetTilesY() == 5);
+
+	// every pixel scans every light, the lights its ray passes have to be in its tile
+	int32 Missing = 0, Reached = 0, Listed = 0;
+	for(int32 Y = 0; Y < Height; ++Y)
+	{
+		for(int32 X = 0; X < Width; ++X)
+		{
+			// computeUV and the ray of the pixel, mul(float3(uv, -1), cameraMatrix)
+			const FVector2f ScreenUV((X + 0.5f) / Width, (Y + 0.5f) / Height);
+			const FVector2f UV(ScreenUV.X * 2.0f - 1.0f, 1.0f - ScreenUV.Y * 2.0f);
+			const FVector3f Direction = CameraMatrix.MulRow(FVector3f(UV.X, UV.Y, -1.0f)).GetSafeNormal();
+
+			const TConstArrayView<int32> TileLights = Grid.GetTileLights(ScreenUV);
+			Listed += TileLights.Num();
+			for(int32 LightIndex = 0; LightIndex < Lights.Num(); ++LightIndex)
+			{
+				if(!RayReachesLight(Eye, Direction, Lights[LightIndex]))
+				{
+					continue;
+				}
+				++Reached;
+				bool bListed = false;
+				for(const int32 TileLight : TileLights)
+				{
+					bListed |= TileLight == LightIndex;
+				}
+				Missing += bListed ? 0 : 1;
+			}
+		}
+	}
+	PSF_EXPECT(Reached > 0);
+	PSF_EXPECT_EQ(Missing, 0);
+
+	// and the tiles have to cull most of them
+	PSF_EXPECT(Listed < Width * Height * Lights.Num() / 4);
+	PSF_EXPECT(Grid.GetVisibleLights() < Lights.Num());
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFMeshExtractor.h"
+
+namespace
+{
+	FPSFMeshExtractSettings MakeSettings(int32 ChunkCells)
+	{
+		FPSFMeshExtractSettings Settings;
+		Settings.ChunkCells = ChunkCells;
+		Settings.bProjectVertices = false;
+		return Settings;
+	}
+
+	/** Triangles of Sdf in small chunks, which may be skipped, and in a single chunk that holds the surface */
+	void ExtractChunkedAndWhole(const FPSFSdf &Sdf, const FBox3f &Bounds, FPSFMeshExtractStats &OutChunked, FPSFMeshExtractStats &OutWhole)
+	{
+		FPSFExtractedMesh Chunked, Whole;
+		PSF_REQUIRE(FPSFMeshExtractor::Extract(Sdf, Bounds, 40, MakeSettings(4), Chunked, OutChunked));
+		PSF_REQUIRE(FPSFMeshExtractor::Extract(Sdf, Bounds, 40, MakeSettings(1024), Whole, OutWhole));
+		PSF_REQUIRE(OutWhole.TotalChunks == 1);
+		PSF_EXPECT(OutWhole.Triangles > 0);
+	}
+}
+
+PSF_TEST(ExtractorSkipsChunksFarFromExactSdfs)
+{
+	FPSFSdf Sphere;
+	Sphere.Type = EPSFSdfType::Sphere;
+	Sphere.Radius = 1.0f;
+
+	FPSFMeshExtractStats Chunked, Whole;
+	ExtractChunkedAndWhole(Sphere, FBox3f(FVector3f(-4.0f), FVector3f(4.0f)), Chunked, Whole);
+	PSF_EXPECT(Chunked.SurfaceChunks < Chunked.TotalChunks);
+	PSF_EXPECT_EQ(Chunked.Triangles, Whole.Triangles);
+}
+
+PSF_TEST(ExtractorKeepsTheSurfaceOfSteepSdfs)
+{
+	FPSFSdf Rock;
+	Rock.Type = EPSFSdfType::Rock;
+	Rock.Size = FVector3f(1.0f, 0.6f, 0.8f);
+
+	FPSFSdf Ellipsoid;
+	Ellipsoid.Type = EPSFSdfType::Ellipsoid;
+	Ellipsoid.Size = FVector3f(2.0f, 0.2f, 0.5f);
+
+	FPSFSdf Desert;
+	Desert.Type = EPSFSdfType::Desert;
+
+	// evalSDF of these changes faster than the distance, a chunk they cross can be farther from them than its size
+	const FBox3f Boxes[] = {FBox3f(FVector3f(-1.5f), FVector3f(1.5f)), FBox3f(FVector3f(-2.5f), FVector3f(2.5f)), FBox3f(FVector3f(-6.0f, -3.0f, -6.0f), FVector3f(6.0f, 3.0f, 6.0f))};
+	const FPSFSdf Sdfs[] = {Rock, Ellipsoid, Desert};
+	for(int32 Index = 0; Index < 3; ++Index)
+	{
+		FPSFMeshExtractStats Chunked, Whole;
+		ExtractChunkedAndWhole(Sdfs[Index], Boxes[Index], Chunked, Whole);
+		PSF_EXPECT_EQ(Chunked.Triangles, Whole.Triangles);
+		PSF_EXPECT_EQ(Chunked.Vertices, Whole.Vertices);
+	}
+}
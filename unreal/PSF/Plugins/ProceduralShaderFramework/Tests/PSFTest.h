@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <functional>
+
+/**
+ * Minimal test registry for the out-of-engine tests, see Makefile.
+ * PSF_TEST defines a test function, PSF_EXPECT* record a failure and keep going, PSF_REQUIRE stops the test.
+ */
+struct FPSFTestCase
+{
+	const char *Name;
+	std::function<void()> Body;
+};
+
+TArray<FPSFTestCase> &GetPSFTests();
+void PSFTestFail(const char *File, int32 Line, const FString &Message);
+
+/** Directory of the test sources, samples and golden files are read relative to it */
+FString GetPSFTestDir();
+
+/** Directory for files written by the tests, created empty for every run */
+FString GetPSFTestOutputDir();
+
+struct FPSFTestRegistrar
+{
+	FPSFTestRegistrar(const char *Name, std::function<void()> Body)
+	{
+		GetPSFTests().Add({Name, MoveTemp(Body)});
+	}
+};
+
+struct FPSFTestRequireFailed
+{
+};
+
+#define PSF_TEST(Name) \
+	static void PSFTest_##Name(); \
+	static FPSFTestRegistrar PSFTestRegistrar_##Name(#Name, &PSFTest_##Name); \
+	static void PSFTest_##Name()
+
+#define PSF_EXPECT(Condition) \
+	do { if(!(Condition)) { PSFTestFail(__FILE__, __LINE__, TEXT(#Condition)); } } while(0)
+
+#define PSF_REQUIRE(Condition) \
+	do { if(!(Condition)) { PSFTestFail(__FILE__, __LINE__, TEXT(#Condition)); throw FPSFTestRequireFailed(); } } while(0)
+
+#define PSF_EXPECT_EQ(Actual, Expected) \
+	do { if(!((Actual) == (Expected))) { PSFTestFail(__FILE__, __LINE__, FString(TEXT(#Actual " == " #Expected))); } } while(0)
+
+#define PSF_EXPECT_NEAR(Actual, Expected, Tolerance) \
+	do { const double PSFActual = (Actual), PSFExpected = (Expected); if(!(std::fabs(PSFActual - PSFExpected) <= (Tolerance))) { PSFTestFail(__FILE__, __LINE__, FString::Printf(TEXT("%s is %g, expected %g"), TEXT(#Actual), PSFActual, PSFExpected)); } } while(0)
+
+/** Compares two texts and reports the first line that differs */
+#define PSF_EXPECT_TEXT(Actual, Expected) PSFExpectText(__FILE__, __LINE__, Actual, Expected)
+void PSFExpectText(const char *File, int32 Line, const FString &Actual, const FString &Expected);
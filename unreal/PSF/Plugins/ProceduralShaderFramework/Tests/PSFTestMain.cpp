@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include <filesystem>
+
+bool GPSFShimVerboseLog = false;
+
+namespace
+{
+	int32 GFailures = 0;
+	const char *GCurrentTest = "";
+	FString GTestDir;
+}
+
+TArray<FPSFTestCase> &GetPSFTests()
+{
+	static TArray<FPSFTestCase> Tests;
+	return Tests;
+}
+
+void PSFTestFail(const char *File, int32 Line, const FString &Message)
+{
+	++GFailures;
+	std::fprintf(stderr, "%s:%d: %s: %s\n", File, Line, GCurrentTest, FTCHARToUTF8(*Message).Get());
+}
+
+void PSFExpectText(const char *File, int32 Line, const FString &Actual, const FString &Expected)
+{
+	if(Actual.Equals(Expected, ESearchCase::CaseSensitive))
+	{
+		return;
+	}
+
+	TArray<FString> ActualLines;
+	TArray<FString> ExpectedLines;
+	Actual.ParseIntoArray(ActualLines, TEXT("\n"), false);
+	Expected.ParseIntoArray(ExpectedLines, TEXT("\n"), false);
+	int32 LineIndex = 0;
+	while(LineIndex < ActualLines.Num() && LineIndex < ExpectedLines.Num() && ActualLines[LineIndex].Equals(ExpectedLines[LineIndex], ESearchCase::CaseSensitive))
+	{
+		++LineIndex;
+	}
+	PSFTestFail(File, Line, FString::Printf(TEXT("texts differ at line %d\n  actual:   %s\n  expected: %s"), LineIndex + 1,
+		ActualLines.IsValidIndex(LineIndex) ? *ActualLines[LineIndex] : TEXT("<end>"), ExpectedLines.IsValidIndex(LineIndex) ? *ExpectedLines[LineIndex] : TEXT("<end>")));
+}
+
+FString GetPSFTestDir()
+{
+	return GTestDir;
+}
+
+FString GetPSFTestOutputDir()
+{
+	return GTestDir / TEXT("Build/Output");
+}
+
+int main(int ArgCount, char **Args)
+{
+	// PSFTests [-v] [test name filter]
+	const char *Filter = nullptr;
+	for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+	{
+		if(std::strcmp(Args[ArgIndex], "-v") == 0)
+		{
+			GPSFShimVerboseLog = true;
+		}
+		else
+		{
+			Filter = Args[ArgIndex];
+		}
+	}
+
+	GTestDir = PSFShimUTF8ToString(reinterpret_cast<const uint8 *>(PSF_TEST_DIR), (int32)std::strlen(PSF_TEST_DIR));
+	const std::filesystem::path OutputDir(FTCHARToUTF8(*GetPSFTestOutputDir()).Get());
+	std::filesystem::remove_all(OutputDir);
+	std::filesystem::create_directories(OutputDir);
+
+	int32 Run = 0;
+	int32 Failed = 0;
+	for(const FPSFTestCase &Test : GetPSFTests())
+	{
+		if(Filter && !std::strstr(Test.Name, Filter))
+		{
+			continue;
+		}
+
+		GCurrentTest = Test.Name;
+		const int32 FailuresBefore = GFailures;
+		try
+		{
+			Test.Body();
+		}
+		catch(const FPSFTestRequireFailed &)
+		{
+		}
+		++Run;
+		if(GFailures != FailuresBefore)
+		{
+			++Failed;
+			std::fprintf(stderr, "FAILED %s\n", Test.Name);
+		}
+	}
+
+	std::printf("%d tests, %d failed\n", Run, Failed);
+	return Failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+// Generated from Expressions.ush by the PSFGenerateShaders commandlet for glsl, do not edit.
+// fmod of HLSL, the result has the sign of x where mod has the sign of y
+float psf_fmod(float x, float y)
+{
+    return x - y * trunc(x / y);
+}
+
+// Implicit conversions, intrinsics without a GLSL name and matrix order
+
+#define STEPS 4
+
+uniform sampler2D noiseTexture;
+
+
+struct Ray
+{
+    vec3 origin;
+    vec3 direction;
+};
+
+// HLSL converts the int literals, truncates the float4 and compares component-wise
+vec3 shade(vec3 normal, vec4 color, float roughness)
+{
+    vec3 base = color.xyz;
+    float ndl = clamp(dot(normal, vec3(0.0, 1.0, 0.0)), 0.0, 1.0);
+    vec3 tint = mix(base, vec3(1), roughness * 0.5);
+    if (any(greaterThan(base, vec3(0.5))))
+    {
+        tint *= 2.0;
+    }
+    return tint * ndl + fract(roughness) * (1.0 / (roughness + 1.0));
+}
+
+// mul(m, v) is v * m in GLSL, the rows of an HLSL matrix are the columns of the GLSL one
+vec3 rotate(mat3 rotation, vec3 p)
+{
+    return ((p - vec3(1.0, 0.0, 0.0)) * rotation);
+}
+
+float wrap(float x)
+{
+    return psf_fmod(x, 2.0) + (log2(x) * 0.30102999566) + atan(x, 1.0);
+}
+
+float fbm(vec2 uv, int octaves)
+{
+    float sum = 0.0;
+    float amplitude = 0.5;
+    for (int i = 0; i < octaves; i++)
+    {
+        sum += amplitude * textureLod(noiseTexture, uv, 0.0).r;
+        uv *= 2.0;
+        amplitude *= 0.5;
+    }
+    return sum;
+}
+
+float fbm(vec2 uv)
+{
+    return fbm(uv, STEPS);
+}
+
+// an overload, Godot has none and renames it
+float fbm(vec3 p)
+{
+    return fbm(p.xz) + fbm(p.xy, 2);
+}
+
+Ray makeRay(vec3 origin, vec3 target)
+{
+    Ray ray = Ray(vec3(0.0), vec3(0.0));
+    ray.origin = origin;
+    ray.direction = normalize(target - origin);
+    return ray;
+}
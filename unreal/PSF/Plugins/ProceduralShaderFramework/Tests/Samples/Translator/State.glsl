@@ -0,0 +1,67 @@
+// Generated from State.ush by the PSFGenerateShaders commandlet for glsl, do not edit.
+// Mutable globals, Godot keeps them in PSFState
+
+#define MAX_ITEMS 8
+
+struct Item
+{
+    vec3 position;
+    float radius;
+};
+
+const float EPSILON = 0.001;
+
+uniform float time;
+
+Item items[MAX_ITEMS];
+int itemCount = 0;
+vec3 eye = vec3(0.0, 0.0, 7.0);
+int steps;
+
+// only uses its parameters, stays as it is
+float sphere(vec3 p, float radius)
+{
+    return length(p) - radius;
+}
+
+void addItem(vec3 position, float radius)
+{
+    items[itemCount].position = position;
+    items[itemCount].radius = radius;
+    itemCount++;
+}
+
+float scene(vec3 p)
+{
+    float d = 1e10;
+    for (int i = 0; i < itemCount; i++)
+    {
+        d = min(d, sphere(p - items[i].position, items[i].radius));
+    }
+    return d;
+}
+
+// uses the state only through scene
+float march(vec3 direction)
+{
+    float t = 0.0;
+    steps = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        float d = scene(eye + direction * t);
+        steps++;
+        if (d < EPSILON * t)
+        {
+            return t;
+        }
+        t += d;
+    }
+    return -1.0;
+}
+
+float render(vec2 uv)
+{
+    addItem(vec3(sin(time), 0.0, 0.0), 1.0);
+    addItem(vec3(0.0, 1.0, 0.0), 0.5);
+    return march(normalize(vec3(uv, -1.0)));
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFSceneCompiler.h"
+#include "PSFCustomSDFRegistry.h"
+
+namespace
+{
+	FPSFCustomSDF MakeCustomSDF(const FString &Name, int32 TypeId)
+	{
+		FPSFCustomSDF CustomSDF;
+		CustomSDF.Name = Name;
+		CustomSDF.TypeId = TypeId;
+		CustomSDF.Code = TEXT("return length(probePoint) - 1.0;");
+		return CustomSDF;
+	}
+}
+
+// PSFCustomSDFRegistry.cpp needs the JSON reader, the compiler only uses the names of the registry
+const TCHAR *FPSFCustomSDFRegistry::LegacyName = TEXT("CustomSDF");
+const TCHAR *FPSFCustomSDFRegistry::FileName = TEXT("CustomSDFs.json");
+
+PSF_TEST(CompilerCallsTheRegisteredCustomSDF)
+{
+	FPSFSdf Blob;
+	Blob.Type = EPSFSdfType::Custom;
+	Blob.CustomName = TEXT("Blob");
+
+	FPSFSdf Legacy;
+	Legacy.Type = EPSFSdfType::Custom;
+
+	FPSFScene Scene;
+	Scene.SDFs = {Blob, Legacy};
+	const TArray<FPSFCustomSDF> CustomSDFs = {MakeCustomSDF(TEXT("CustomSDF"), 99), MakeCustomSDF(TEXT("Blob"), 100)};
+
+	FString Code;
+	FPSFSceneCompilerStats Stats;
+	PSF_REQUIRE(FPSFSceneCompiler::Compile(Scene, CustomSDFs, TEXT("Test.json"), Code, Stats));
+	PSF_EXPECT(Code.Contains(TEXT("#include \"MyCustomSDFs.ush\"")));
+	PSF_EXPECT(Code.Contains(TEXT("float evalCompiledSDF0(float3 p, float time)\n{\n    float3 probePoint = p;\n    return sdBlob(probePoint, time);\n}")));
+	PSF_EXPECT(Code.Contains(TEXT("float evalCompiledSDF1(float3 p, float time)\n{\n    float3 probePoint = p;\n    return sdCustomSDF(probePoint, time);\n}")));
+
+	// MyCustomSDFs.ush has no function for a name that is not registered
+	Scene.SDFs[0].CustomName = TEXT("Missing");
+	PSF_EXPECT(!FPSFSceneCompiler::Compile(Scene, CustomSDFs, TEXT("Test.json"), Code, Stats));
+	PSF_EXPECT(!FPSFSceneCompiler::Compile(Scene, {}, TEXT("Test.json"), Code, Stats));
+}
@@ -0,0 +1,371 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFScenePacker.h"
+#include "PSFSdfFunctions.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	/** Integer value of #define Name in a plugin shader, defines that name another define are followed */
+	int32 ReadShaderDefine(const TCHAR *File, const FString &Name)
+	{
+		FString Content;
+		PSF_REQUIRE(FFileHelper::LoadFileToString(Content, *(GetPSFTestDir() / TEXT("../Shaders") / File)));
+
+		const FString Directive = TEXT("#define ") + Name + TEXT(" ");
+		const int32 Start = Content.Find(Directive, ESearchCase::CaseSensitive);
+		PSF_REQUIRE(Start != INDEX_NONE);
+		FString Value;
+		Content.Mid(Start + Directive.Len()).Split(TEXT("\n"), &Value, nullptr, ESearchCase::CaseSensitive);
+		Value.TrimStartAndEndInline();
+		return Value.IsNumeric() ? FCString::Atoi(*Value) : ReadShaderDefine(File, Value);
+	}
+
+	/** The arrays loadSceneTexture in sdf_functions.ush fills */
+	struct FLoadedScene
+	{
+		int32 Count = 0;
+		TArray<FIntPoint> Records;
+		TArray<FVector4f> Positions;
+		TArray<FVector4f> Sizes;
+		TArray<FVector4f> Rotations;
+		TArray<FVector4f> Bounds;
+		TArray<float> Animated;
+		TArray<FVector4f> MaterialTexels;
+		TArray<TArray<FVector4f>> Skeletons;
+	};
+
+	/** loadSceneTexture statement by statement, on the texels of the packer instead of sceneData.Load */
+	FLoadedScene LoadSceneTexels(const TArray<FVector4f> &Texels, int32 MaxSdfs, int32 MaxMaterials, int32 MaxDolphins)
+	{
+		const int32 TexelsPerSdf = ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_SDF"));
+		const int32 TexelsPerMaterial = ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_MATERIAL"));
+		const int32 TexelsPerDolphin = ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_DOLPHIN"));
+		const int32 MaterialOverflow = MaxMaterials;
+
+		FLoadedScene Scene;
+		const FVector4f Header = Texels[0];
+		Scene.Count = FMath::Min(int32(Header.X), MaxSdfs);
+		const int32 MaterialCount = FMath::Min(int32(Header.Y), MaxMaterials);
+		const int32 MaterialOffset = int32(Header.Z);
+		Scene.Skeletons.SetNum(MaxDolphins);
+
+		for(int32 Index = 0; Index < Scene.Count; ++Index)
+		{
+			const int32 Texel = 1 + Index * TexelsPerSdf;
+			const FVector4f Record = Texels[Texel];
+			const int32 MaterialIndex = int32(Record.Y);
+			Scene.Records.Add(FIntPoint(int32(Record.X), MaterialIndex >= 0 && MaterialIndex < MaterialCount ? MaterialIndex : MaterialOverflow));
+			Scene.Positions.Add(Texels[Texel + 1]);
+			Scene.Sizes.Add(Texels[Texel + 2]);
+			Scene.Rotations.Add(Texels[Texel + 3]);
+			Scene.Bounds.Add(Texels[Texel + 4]);
+			Scene.Animated.Add(Record.Z);
+
+			if(Scene.Records.Last().X == int32(EPSFSdfType::Dolphin))
+			{
+				const int32 Slot = int32(Scene.Sizes.Last().Z);
+				if(Slot < 0 || Slot >= MaxDolphins)
+				{
+					continue;
+				}
+				const int32 SkeletonTexel = 1 + int32(Header.W) * TexelsPerSdf + Slot * TexelsPerDolphin;
+				for(int32 Offset = 0; Offset < TexelsPerDolphin; ++Offset)
+				{
+					Scene.Skeletons[Slot].Add(Texels[SkeletonTexel + Offset]);
+				}
+			}
+		}
+		for(int32 Material = 0; Material < MaterialCount; ++Material)
+		{
+			for(int32 Offset = 0; Offset < TexelsPerMaterial; ++Offset)
+			{
+				Scene.MaterialTexels.Add(Texels[MaterialOffset + Material * TexelsPerMaterial + Offset]);
+			}
+		}
+		return Scene;
+	}
+
+	/** rotateByQuaternion of sdf_functions.ush */
+	FVector3f RotateByQuaternion(const FVector4f &Q, const FVector3f &V)
+	{
+		const FVector3f Axis(Q.X, Q.Y, Q.Z);
+		const FVector3f T = (Axis ^ V) * 2.0f;
+		return V + T * Q.W + (Axis ^ T);
+	}
+
+	/** MaterialParams the way loadSceneTexture assembles it from its five texels */
+	FPSFMaterialParams UnpackMaterial(const TArray<FVector4f> &MaterialTexels, int32 Material)
+	{
+		const FVector4f *T = &MaterialTexels[Material * FPSFScenePacker::TexelsPerMaterial];
+		FPSFMaterialParams Params;
+		Params.BaseColor = FVector3f(T[0].X, T[0].Y, T[0].Z);
+		Params.SpecularStrength = T[0].W;
+		Params.SpecularColor = FVector3f(T[1].X, T[1].Y, T[1].Z);
+		Params.Shininess = T[1].W;
+		Params.FakeSpecularColor = FVector3f(T[2].X, T[2].Y, T[2].Z);
+		Params.Roughness = T[2].W;
+		Params.RefractionTint = FVector3f(T[3].X, T[3].Y, T[3].Z);
+		Params.Metallic = T[3].W;
+		Params.RimPower = T[4].X;
+		Params.FakeSpecularPower = T[4].Y;
+		Params.Ior = T[4].Z;
+		Params.RefractionStrength = T[4].W;
+		return Params;
+	}
+
+	FVector3f XYZ(const FVector4f &V)
+	{
+		return FVector3f(V.X, V.Y, V.Z);
+	}
+
+	FPSFMaterialParams MakeMaterial(const FVector3f &BaseColor)
+	{
+		FPSFMaterialParams Material;
+		Material.BaseColor = BaseColor;
+		Material.Shininess = 12.0f;
+		Material.Ior = 1.33f;
+		Material.RefractionTint = FVector3f(0.2f, 0.4f, 0.6f);
+		return Material;
+	}
+
+	FPSFSdf MakeSdf(EPSFSdfType Type, const FVector3f &Position, const FPSFMaterialParams &Material)
+	{
+		FPSFSdf Sdf;
+		Sdf.Type = Type;
+		Sdf.Position = Position;
+		Sdf.Size = FVector3f(0.5f, 0.75f, 1.0f);
+		Sdf.Radius = 0.8f;
+		Sdf.Material = Material;
+		return Sdf;
+	}
+
+	/** A sphere, a rotated round box with the sphere's material, a resting and a swimming dolphin and a torus */
+	TArray<FPSFSdf> MakeScene()
+	{
+		const FPSFMaterialParams Red = MakeMaterial(FVector3f(1.0f, 0.0f, 0.0f));
+		const FPSFMaterialParams Blue = MakeMaterial(FVector3f(0.0f, 0.0f, 1.0f));
+
+		TArray<FPSFSdf> SDFs;
+		SDFs.Add(MakeSdf(EPSFSdfType::Sphere, FVector3f(1.0f, 2.0f, 3.0f), Red));
+
+		FPSFSdf Box = MakeSdf(EPSFSdfType::RoundBox, FVector3f(-2.0f, 0.0f, 1.0f), Red);
+		const float C = FMath::Cos(0.6f), S = FMath::Sin(0.6f);
+		Box.Rotation = FPSFMatrix3(FVector3f(C, 0.0f, -S), FVector3f(0.0f, 1.0f, 0.0f), FVector3f(S, 0.0f, C));
+		SDFs.Add(Box);
+
+		FPSFSdf Resting = MakeSdf(EPSFSdfType::Dolphin, FVector3f(0.0f, -1.0f, 0.0f), Blue);
+		Resting.TimeOffset = 0.25f;
+		SDFs.Add(Resting);
+
+		FPSFSdf Swimming = MakeSdf(EPSFSdfType::Dolphin, FVector3f(3.0f, -1.0f, 2.0f), Blue);
+		Swimming.TimeOffset = 1.5f;
+		Swimming.Speed = 2.0f;
+		SDFs.Add(Swimming);
+
+		SDFs.Add(MakeSdf(EPSFSdfType::Torus, FVector3f(0.0f, 4.0f, 0.0f), MakeMaterial(FVector3f(0.0f, 1.0f, 0.0f))));
+		return SDFs;
+	}
+
+	bool CoversTexel(const TArray<FPSFTexelRange> &Ranges, int32 Texel)
+	{
+		return Ranges.ContainsByPredicate([Texel](const FPSFTexelRange &Range) { return Texel >= Range.First && Texel < Range.First + Range.Count; });
+	}
+}
+
+PSF_TEST(PackerLayoutMatchesTheShaderDefines)
+{
+	PSF_EXPECT_EQ(FPSFScenePacker::TexelsPerSdf, ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_SDF")));
+	PSF_EXPECT_EQ(FPSFScenePacker::TexelsPerMaterial, ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_MATERIAL")));
+	PSF_EXPECT_EQ(FPSFScenePacker::TexelsPerDolphin, ReadShaderDefine(TEXT("sdf_functions.ush"), TEXT("PSF_TEXELS_PER_DOLPHIN")));
+	PSF_EXPECT_EQ(FPSFDolphinSkeleton::NumSegments, ReadShaderDefine(TEXT("helper_functions.ush"), TEXT("PSF_DOLPHIN_SEGMENTS")));
+
+	// joints, two frames and the tail direction
+	PSF_EXPECT_EQ(FPSFScenePacker::TexelsPerDolphin, FPSFDolphinSkeleton::NumSegments + 1 + 3 + 3 + 1);
+
+	const FPSFShaderLimits Limits;
+	PSF_EXPECT_EQ(Limits.MaxSdfs, ReadShaderDefine(TEXT("global_variables.ush"), TEXT("MAX_SDFS")));
+	PSF_EXPECT_EQ(Limits.MaxMaterials, ReadShaderDefine(TEXT("global_variables.ush"), TEXT("MAX_MATERIALS")));
+	PSF_EXPECT_EQ(Limits.MaxDolphins, ReadShaderDefine(TEXT("global_variables.ush"), TEXT("MAX_DOLPHINS")));
+}
+
+PSF_TEST(PackerRoundTripsThroughLoadSceneTexture)
+{
+	const TArray<FPSFSdf> SDFs = MakeScene();
+	const double Time = 1.75;
+
+	FPSFScenePacker Packer;
+	TArray<FPSFTexelRange> Ranges;
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, Time));
+	PSF_EXPECT_EQ(Packer.GetNumMaterials(), 3);
+	PSF_EXPECT(LoadSceneTexels(Packer.GetTexels(), 20, 20, 4).Animated == TArray<float>({1.0f, 1.0f, 1.0f, 1.0f, 1.0f}));
+
+	// the second pack of the same scene only leaves the swimming dolphin animated
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, Time));
+	const int32 MaxDolphins = ReadShaderDefine(TEXT("global_variables.ush"), TEXT("MAX_DOLPHINS"));
+	const FLoadedScene Loaded = LoadSceneTexels(Packer.GetTexels(), 20, 20, MaxDolphins);
+	PSF_REQUIRE(Loaded.Count == SDFs.Num());
+
+	int32 DolphinSlot = 0;
+	for(int32 Index = 0; Index < SDFs.Num(); ++Index)
+	{
+		const FPSFSdf &Sdf = SDFs[Index];
+		PSF_EXPECT_EQ(Loaded.Records[Index].X, int32(Sdf.Type));
+		PSF_EXPECT(UnpackMaterial(Loaded.MaterialTexels, Loaded.Records[Index].Y) == Sdf.Material);
+		PSF_EXPECT(XYZ(Loaded.Positions[Index]) == Sdf.Position);
+		PSF_EXPECT_EQ(Loaded.Positions[Index].W, Sdf.Radius);
+		PSF_EXPECT(Loaded.Bounds[Index] == FPSFScenePacker::ComputeBoundingSphere(Sdf));
+
+		// rotateByQuaternion(q, v) replaces mul(v, rotation)
+		for(const FVector3f &V : {FVector3f(1.0f, 0.0f, 0.0f), FVector3f(0.0f, 1.0f, 0.0f), FVector3f(0.3f, -0.5f, 2.0f)})
+		{
+			PSF_EXPECT(RotateByQuaternion(Loaded.Rotations[Index], V).Equals(Sdf.Rotation.MulRow(V), 1e-5f));
+		}
+
+		PSF_EXPECT((Loaded.Animated[Index] != 0.0f) == (Sdf.Type == EPSFSdfType::Dolphin && Sdf.Speed != 0.0f));
+		if(Sdf.Type != EPSFSdfType::Dolphin)
+		{
+			PSF_EXPECT(XYZ(Loaded.Sizes[Index]) == Sdf.Size);
+			continue;
+		}
+
+		// (timeOffset, speed, skeleton slot) like addDolphin, and the skeleton of the packed time in that slot
+		PSF_EXPECT(XYZ(Loaded.Sizes[Index]) == FVector3f(Sdf.TimeOffset, Sdf.Speed, float(DolphinSlot)));
+		const FPSFDolphinSkeleton Expected = PSFSdf::ComputeDolphinSkeleton(Sdf.Position, Sdf.TimeOffset, Sdf.Speed, Time);
+		const TArray<FVector4f> &Skeleton = Loaded.Skeletons[DolphinSlot];
+		PSF_REQUIRE(Skeleton.Num() == FPSFScenePacker::TexelsPerDolphin);
+		for(int32 Joint = 0; Joint <= FPSFDolphinSkeleton::NumSegments; ++Joint)
+		{
+			PSF_EXPECT(XYZ(Skeleton[Joint]) == Expected.Joints[Joint]);
+		}
+		const int32 Frames = FPSFDolphinSkeleton::NumSegments + 1;
+		for(int32 Row = 0; Row < 3; ++Row)
+		{
+			PSF_EXPECT(XYZ(Skeleton[Frames + Row]) == Expected.FinFrame.Rows[Row]);
+			PSF_EXPECT(XYZ(Skeleton[Frames + 3 + Row]) == Expected.FlipperFrame.Rows[Row]);
+		}
+		PSF_EXPECT(XYZ(Skeleton[Frames + 6]) == Expected.TailDirection);
+		++DolphinSlot;
+	}
+}
+
+PSF_TEST(PackerUploadsOnlyChangedTexels)
+{
+	TArray<FPSFSdf> SDFs = MakeScene();
+	FPSFScenePacker Packer;
+	TArray<FPSFTexelRange> Ranges;
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 1.0));
+	PSF_REQUIRE(Ranges.Num() == 1);
+	PSF_EXPECT_EQ(Ranges[0].First, 0);
+	PSF_EXPECT_EQ(Ranges[0].Count, Packer.GetTexels().Num());
+
+	// every SDF of the first pack is new for the temporal march, the next pack clears the flags of the static ones
+	PSF_EXPECT(Packer.HasMovedSdfs());
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 1.0));
+	PSF_EXPECT(!Packer.HasMovedSdfs());
+
+	// the swimming dolphin moves with the time, the resting one does not
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 2.0));
+	const int32 DolphinOffset = 1 + FPSFScenePacker::MinCapacity * FPSFScenePacker::TexelsPerSdf;
+	PSF_EXPECT(Ranges.Num() > 0);
+	for(const FPSFTexelRange &Range : Ranges)
+	{
+		PSF_EXPECT(Range.First >= DolphinOffset + FPSFScenePacker::TexelsPerDolphin);
+		PSF_EXPECT(Range.First + Range.Count <= DolphinOffset + 2 * FPSFScenePacker::TexelsPerDolphin);
+	}
+
+	// nothing changed once the stopped dolphin lost its flag
+	SDFs[3].Speed = 0.0f;
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 2.0));
+	PSF_EXPECT(Packer.HasMovedSdfs());
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_EXPECT_EQ(Ranges.Num(), 0);
+
+	// one moved SDF uploads its flag, its position and its bounds, and the flag again when it stops
+	const int32 MovedTexel = 1 + 4 * FPSFScenePacker::TexelsPerSdf;
+	SDFs[4].Position.X += 1.0f;
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_REQUIRE(Ranges.Num() == 1);
+	PSF_EXPECT(CoversTexel(Ranges, MovedTexel + 1));
+	PSF_EXPECT(CoversTexel(Ranges, MovedTexel + 4));
+	PSF_EXPECT(!CoversTexel(Ranges, 0));
+	PSF_EXPECT_EQ(Packer.GetTexels()[MovedTexel].Z, 1.0f);
+	PSF_EXPECT_EQ(Packer.GetTexels()[1].Z, 0.0f);
+
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_REQUIRE(Ranges.Num() == 1);
+	PSF_EXPECT_EQ(Ranges[0].First, MovedTexel);
+	PSF_EXPECT_EQ(Ranges[0].Count, 1);
+	PSF_EXPECT_EQ(Packer.GetTexels()[MovedTexel].Z, 0.0f);
+
+	// a new capacity moves the dolphins and materials, everything is uploaded
+	while(SDFs.Num() <= FPSFScenePacker::MinCapacity)
+	{
+		SDFs.Add(SDFs[0]);
+	}
+	Packer.SetShaderLimits({32, 20});
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_REQUIRE(Ranges.Num() == 1);
+	PSF_EXPECT_EQ(Ranges[0].Count, Packer.GetTexels().Num());
+}
+
+PSF_TEST(PackerRejectsScenesOverTheShaderLimits)
+{
+	const FPSFShaderLimits Limits;
+	TArray<FPSFSdf> SDFs = MakeScene();
+	FPSFScenePacker Packer;
+	TArray<FPSFTexelRange> Ranges;
+
+	// equal materials share an entry, so MAX_SDFS copies of one SDF still fit
+	TArray<FPSFSdf> Full;
+	for(int32 Index = 0; Index < Limits.MaxSdfs; ++Index)
+	{
+		Full.Add(SDFs[0]);
+	}
+	PSF_EXPECT(Packer.Pack(Full, Ranges));
+	PSF_EXPECT_EQ(Packer.GetNumMaterials(), 1);
+
+	// one SDF more than the shader holds is rejected and keeps the texels of the last scene that fit
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges));
+	const TArray<FVector4f> Accepted = Packer.GetTexels();
+	Full.Add(SDFs[0]);
+	PSF_EXPECT(!Packer.Pack(Full, Ranges));
+	PSF_EXPECT_EQ(Ranges.Num(), 0);
+	PSF_EXPECT(Packer.GetTexels() == Accepted);
+
+	// more distinct materials than MAX_MATERIALS
+	Packer.SetShaderLimits({Limits.MaxSdfs, 2});
+	PSF_EXPECT(!Packer.Pack(SDFs, Ranges));
+	PSF_EXPECT(Packer.GetTexels() == Accepted);
+
+	// the limits of materials with other defines
+	Packer.SetShaderLimits({Limits.MaxSdfs + 1, 3});
+	PSF_EXPECT(Packer.Pack(Full, Ranges));
+	PSF_EXPECT(Packer.Pack(SDFs, Ranges));
+}
+
+PSF_TEST(PackerGivesSkeletonsOnlyToTheShaderSlots)
+{
+	const TArray<FPSFSdf> SDFs = MakeScene();
+	const int32 Resting = 2, Swimming = 3;
+	PSF_REQUIRE(SDFs[Resting].Type == EPSFSdfType::Dolphin && SDFs[Swimming].Type == EPSFSdfType::Dolphin);
+
+	FPSFScenePacker Packer;
+	Packer.SetShaderLimits({20, 20, 1});
+	TArray<FPSFTexelRange> Ranges;
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 1.0));
+	PSF_EXPECT_EQ(Packer.GetNumDolphins(), 2);
+
+	// the dolphin past MAX_DOLPHINS keeps slot -1, loadSceneTexture leaves it to dolphinDistance
+	const FLoadedScene Loaded = LoadSceneTexels(Packer.GetTexels(), 20, 20, 1);
+	PSF_EXPECT_EQ(Loaded.Sizes[Resting].Z, 0.0f);
+	PSF_EXPECT_EQ(Loaded.Sizes[Swimming].Z, -1.0f);
+	PSF_EXPECT_EQ(Loaded.Skeletons[0].Num(), FPSFScenePacker::TexelsPerDolphin);
+
+	// the dolphin without a slot does not make the next frame dirty, the resting one never does
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 2.0));
+	PSF_REQUIRE(Packer.Pack(SDFs, Ranges, 3.0));
+	PSF_EXPECT_EQ(Ranges.Num(), 0);
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFSdfBaker.h"
+#include "PSFSdfFunctions.h"
+
+namespace
+{
+	FPSFSdf MakeSphere()
+	{
+		FPSFSdf Sdf;
+		Sdf.Type = EPSFSdfType::Sphere;
+		Sdf.Position = FVector3f(1.0f, 2.0f, 3.0f);
+		Sdf.Radius = 1.5f;
+		return Sdf;
+	}
+
+	FPSFSdfBakeSettings MakeSettings(int32 Resolution)
+	{
+		FPSFSdfBakeSettings Settings;
+		Settings.Resolution = Resolution;
+		Settings.ErrorSamples = 2000;
+		return Settings;
+	}
+
+	struct FCrossingCheck
+	{
+		int32 Crossings = 0;
+
+		/** Crossings in bricks that are not stored */
+		int32 LostCrossings = 0;
+
+		/** Largest amount the bound of a brick that is not stored exceeds the distance to the closest crossing */
+		float MaxOvershoot = 0.0f;
+	};
+
+	/** Sign changes of evalSDF along lines in x through the baked bounds, which the bake may neither drop nor step over */
+	FCrossingCheck CheckCrossings(const FPSFSdf &Sdf, const FPSFBakedSdf &Baked)
+	{
+		constexpr int32 BrickVoxels = FPSFSdfBaker::BrickSamples - 1;
+		constexpr int32 LinesPerSide = 24;
+		const float BrickExtent = BrickVoxels * Baked.VoxelSize;
+		const FVector3f Extent = FVector3f(Baked.BrickCount) * BrickExtent;
+		const float Step = 0.5f * Baked.VoxelSize;
+		const int32 Steps = FMath::FloorToInt(Extent.X / Step);
+
+		auto IsStored = [&](const FVector3f &P)
+		{
+			const FVector3f Local = (P - Baked.BoundsMin) / BrickExtent;
+			const FIntVector Brick(FMath::FloorToInt(Local.X), FMath::FloorToInt(Local.Y), FMath::FloorToInt(Local.Z));
+			return Baked.BrickIndex[Brick.X + Baked.BrickCount.X * (Brick.Y + Baked.BrickCount.Y * Brick.Z)].X >= 0.0f;
+		};
+
+		FCrossingCheck Check;
+		TArray<FVector3f> Points;
+		TArray<float> Crossings;
+		for(int32 Line = 0; Line < LinesPerSide * LinesPerSide; ++Line)
+		{
+			// off the sample grid of the bake
+			const float Y = Baked.BoundsMin.Y + ((Line % LinesPerSide) + 0.37f) / LinesPerSide * Extent.Y;
+			const float Z = Baked.BoundsMin.Z + ((Line / LinesPerSide) + 0.61f) / LinesPerSide * Extent.Z;
+
+			Points.Reset();
+			Crossings.Reset();
+			float Previous = 0.0f;
+			for(int32 Index = 0; Index < Steps; ++Index)
+			{
+				const FVector3f P(Baked.BoundsMin.X + (Index + 0.5f) * Step, Y, Z);
+				const float Distance = PSFSdf::EvalSDF(Sdf, P);
+				if(Index > 0 && (Distance < 0.0f) != (Previous < 0.0f))
+				{
+					const FVector3f Crossing = P - FVector3f(0.5f * Step, 0.0f, 0.0f);
+					++Check.Crossings;
+					Check.LostCrossings += IsStored(Crossing) ? 0 : 1;
+					Crossings.Add(Crossing.X);
+				}
+				Points.Add(P);
+				Previous = Distance;
+			}
+
+			for(const FVector3f &P : Points)
+			{
+				if(Crossings.Num() > 0 && !IsStored(P))
+				{
+					float ToCrossing = MAX_flt;
+					for(const float Crossing : Crossings)
+					{
+						ToCrossing = FMath::Min(ToCrossing, FMath::Abs(P.X - Crossing) + 0.5f * Step);
+					}
+					Check.MaxOvershoot = FMath::Max(Check.MaxOvershoot, FMath::Abs(FPSFSdfBaker::Sample(Baked, P)) - ToCrossing);
+				}
+			}
+		}
+		return Check;
+	}
+}
+
+// PSFScene.cpp needs the JSON module, the baker only names the type in its errors
+const TCHAR *PSFScene::SdfTypeToString(EPSFSdfType Type)
+{
+	return TEXT("Test");
+}
+
+PSF_TEST(BakerKeepsTheAtlasWithinTheTextureLimit)
+{
+	const FPSFSdf Sphere = MakeSphere();
+	FPSFSdfBakeSettings Settings = MakeSettings(48);
+
+	FPSFBakedSdf Baked;
+	FPSFSdfBakeStats Stats;
+	PSF_REQUIRE(FPSFSdfBaker::Bake(Sphere, FBox3f(), Settings, Baked, Stats));
+	const FIntVector AtlasSize = Baked.GetAtlasSize();
+	PSF_EXPECT(AtlasSize.X <= Settings.MaxTextureSize && AtlasSize.Y <= Settings.MaxTextureSize && AtlasSize.Z <= Settings.MaxTextureSize);
+	PSF_EXPECT(Baked.NumAllocatedBricks > 0);
+
+	// the baked distance is usable before any limit is involved
+	FPSFSdfBaker::MeasureError(Sphere, Baked, Settings, Stats);
+	PSF_EXPECT(Stats.BandSamples > 0);
+	PSF_EXPECT(Stats.MaxError < Baked.VoxelSize);
+
+	// the same bake into a smaller atlas than its bricks need fails instead of writing past the texture
+	Settings.MaxTextureSize = AtlasSize.GetMax() - 1;
+	PSF_EXPECT(Baked.BrickCount.GetMax() <= Settings.MaxTextureSize);
+	PSF_EXPECT(!FPSFSdfBaker::Bake(Sphere, FBox3f(), Settings, Baked, Stats));
+}
+
+PSF_TEST(BakerRejectsBrickIndicesOverTheTextureLimit)
+{
+	FPSFSdfBakeSettings Settings = MakeSettings(48);
+	Settings.MaxTextureSize = 4;
+
+	FPSFBakedSdf Baked;
+	FPSFSdfBakeStats Stats;
+	PSF_EXPECT(!FPSFSdfBaker::Bake(MakeSphere(), FBox3f(), Settings, Baked, Stats));
+}
+
+PSF_TEST(BakerKeepsTheSurfaceOfSteepSdfs)
+{
+	FPSFSdf Rock;
+	Rock.Type = EPSFSdfType::Rock;
+	Rock.Size = FVector3f(1.0f, 0.6f, 0.8f);
+
+	FPSFSdf Desert;
+	Desert.Type = EPSFSdfType::Desert;
+
+	// evalSDF of both changes faster than the distance, a brick whose center evaluates beyond its half diagonal can still hold surface
+	const FPSFSdf Sdfs[] = {Rock, Desert};
+	const FBox3f Bounds[] = {FBox3f(), FBox3f(FVector3f(-20.0f, -4.0f, -20.0f), FVector3f(20.0f, 4.0f, 20.0f))};
+	for(int32 Index = 0; Index < 2; ++Index)
+	{
+		FPSFBakedSdf Baked;
+		FPSFSdfBakeStats Stats;
+		PSF_REQUIRE(FPSFSdfBaker::Bake(Sdfs[Index], Bounds[Index], MakeSettings(320), Baked, Stats));
+
+		const FCrossingCheck Check = CheckCrossings(Sdfs[Index], Baked);
+		PSF_EXPECT(Check.Crossings > 0);
+		PSF_EXPECT_EQ(Check.LostCrossings, 0);
+		PSF_EXPECT(Check.MaxOvershoot <= 1e-3f);
+	}
+}
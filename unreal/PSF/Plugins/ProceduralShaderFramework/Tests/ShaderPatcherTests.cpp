@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFShaderPatcher.h"
+#include "PSFShaderSync.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	int32 GAtomicWrites = 0;
+
+	FString LoadSample(const TCHAR *Name)
+	{
+		FString Content;
+		PSF_REQUIRE(FFileHelper::LoadFileToString(Content, *(GetPSFTestDir() / TEXT("Samples/Patcher") / Name)));
+		return Content;
+	}
+
+	/** Copy of a sample in the output dir that the test may modify */
+	FString CopySample(const TCHAR *Name, const FString &Content)
+	{
+		const FString Path = GetPSFTestOutputDir() / Name;
+		PSF_REQUIRE(FFileHelper::SaveStringToFile(Content, *Path));
+		return Path;
+	}
+
+	FString ToCRLF(const FString &Content)
+	{
+		return Content.Replace(TEXT("\n"), TEXT("\r\n"), ESearchCase::CaseSensitive);
+	}
+}
+
+// the engine version moves a temporary file over the target, here it only has to write and count
+bool FPSFShaderSync::SaveArrayToFileAtomic(const TArray<uint8> &Content, const FString &FilePath)
+{
+	++GAtomicWrites;
+	return FFileHelper::SaveArrayToFile(Content, *FilePath);
+}
+
+PSF_TEST(PatcherParsesRegionsInFileOrder)
+{
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Parse(LoadSample(TEXT("Regions.ush"))));
+
+	const TArray<FString> Names = Patcher.GetRegionNames();
+	PSF_REQUIRE(Names.Num() == 3);
+	PSF_EXPECT(Names[0].Equals(TEXT("INCLUDECUSTOMSDF")));
+	PSF_EXPECT(Names[1].Equals(TEXT("EVALCUSTOMSDF")));
+	PSF_EXPECT(Names[2].Equals(TEXT("EMPTY")));
+
+	// the region starts on the line after the start marker and ends before the indentation of the end marker
+	PSF_EXPECT_TEXT(Patcher.GetRegion(TEXT("INCLUDECUSTOMSDF")), TEXT("#include \"MyCustomSDFs.ush\"\n"));
+	PSF_EXPECT_TEXT(Patcher.GetRegion(TEXT("EVALCUSTOMSDF")), TEXT("    else if (sdfType[index] == 100)\n    {\n        return sdMyCustomSDF(p, time);\n    }\n"));
+	PSF_EXPECT(Patcher.HasRegion(TEXT("EMPTY")));
+	PSF_EXPECT(Patcher.GetRegion(TEXT("EMPTY")).IsEmpty());
+
+	// marker names are case-sensitive
+	PSF_EXPECT(!Patcher.HasRegion(TEXT("includecustomsdf")));
+}
+
+PSF_TEST(PatcherRoundTripsUnchangedContent)
+{
+	const FString Content = LoadSample(TEXT("Regions.ush"));
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Parse(Content));
+	PSF_EXPECT(!Patcher.IsModified());
+	PSF_EXPECT_TEXT(Patcher.GetContent(), Content);
+}
+
+PSF_TEST(PatcherRoundTripsPluginShader)
+{
+	const FString Path = GetPSFTestDir() / TEXT("../Shaders/sdf_functions.ush");
+	FString Content;
+	PSF_REQUIRE(FFileHelper::LoadFileToString(Content, *Path));
+
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Load(Path));
+	PSF_EXPECT(Patcher.HasRegion(TEXT("INCLUDECUSTOMSDF")));
+	PSF_EXPECT(Patcher.HasRegion(TEXT("ADDCUSTOMSDF")));
+	PSF_EXPECT(Patcher.HasRegion(TEXT("EVALCUSTOMSDF")));
+	PSF_EXPECT_TEXT(Patcher.GetContent(), Content);
+}
+
+PSF_TEST(PatcherReplacesOnlyTheRegion)
+{
+	const FString Content = LoadSample(TEXT("Regions.ush"));
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Parse(Content));
+
+	const FString Body = TEXT("#include \"MyCustomSDFs.ush\"\n#include \"CompiledScene.ush\"\n");
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("INCLUDECUSTOMSDF"), Body));
+	PSF_EXPECT(Patcher.IsModified());
+	PSF_EXPECT_TEXT(Patcher.GetContent(), Content.Replace(TEXT("#include \"MyCustomSDFs.ush\"\n"), *Body, ESearchCase::CaseSensitive));
+
+	// a reparse of the result finds the new body and leaves the other regions alone
+	FPSFShaderPatcher Reparsed;
+	PSF_REQUIRE(Reparsed.Parse(Patcher.GetContent()));
+	PSF_EXPECT_TEXT(Reparsed.GetRegion(TEXT("INCLUDECUSTOMSDF")), Body);
+	PSF_EXPECT_TEXT(Reparsed.GetRegion(TEXT("EVALCUSTOMSDF")), Patcher.GetRegion(TEXT("EVALCUSTOMSDF")));
+}
+
+PSF_TEST(PatcherSavesOnceAndOnlyWhenChanged)
+{
+	const FString Content = LoadSample(TEXT("Regions.ush"));
+	const FString Path = CopySample(TEXT("SaveOnce.ush"), Content);
+
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Load(Path));
+
+	// the same code again is not a change
+	const int32 WritesBefore = GAtomicWrites;
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("EVALCUSTOMSDF"), Patcher.GetRegion(TEXT("EVALCUSTOMSDF"))));
+	PSF_EXPECT(!Patcher.IsModified());
+	bool bWritten = true;
+	PSF_EXPECT(Patcher.Save(bWritten));
+	PSF_EXPECT(!bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore);
+
+	// two edits, one write
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("INCLUDECUSTOMSDF"), TEXT("#include \"A.ush\"\n")));
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("EMPTY"), TEXT("float e;\n")));
+	PSF_EXPECT(Patcher.Save(bWritten));
+	PSF_EXPECT(bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore + 1);
+
+	FString Saved;
+	PSF_REQUIRE(FFileHelper::LoadFileToString(Saved, *Path));
+	PSF_EXPECT_TEXT(Saved, Patcher.GetContent());
+
+	// after the save the patcher compares against the new file, saving again writes nothing
+	PSF_EXPECT(!Patcher.IsModified());
+	PSF_EXPECT(Patcher.Save(bWritten));
+	PSF_EXPECT(!bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore + 1);
+}
+
+PSF_TEST(SaveStringIfChangedSkipsIdenticalFiles)
+{
+	const FString Content = LoadSample(TEXT("Regions.ush"));
+	const FString Path = CopySample(TEXT("Identical.ush"), Content);
+
+	const int32 WritesBefore = GAtomicWrites;
+	bool bWritten = true;
+	PSF_EXPECT(FPSFShaderPatcher::SaveStringIfChanged(Content, Path, bWritten));
+	PSF_EXPECT(!bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore);
+
+	PSF_EXPECT(FPSFShaderPatcher::SaveStringIfChanged(Content + TEXT("\n"), Path, bWritten));
+	PSF_EXPECT(bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore + 1);
+}
+
+PSF_TEST(PatcherRejectsNestedMarkers)
+{
+	FPSFShaderPatcher Patcher;
+	PSF_EXPECT(!Patcher.Parse(LoadSample(TEXT("Nested.ush"))));
+	PSF_EXPECT(!Patcher.IsValid());
+}
+
+PSF_TEST(PatcherRejectsDuplicateMarkers)
+{
+	FPSFShaderPatcher Patcher;
+	PSF_EXPECT(!Patcher.Parse(LoadSample(TEXT("Duplicate.ush"))));
+	PSF_EXPECT(!Patcher.IsValid());
+}
+
+PSF_TEST(PatcherRejectsUnterminatedMarkers)
+{
+	FPSFShaderPatcher Patcher;
+	PSF_EXPECT(!Patcher.Parse(LoadSample(TEXT("Unterminated.ush"))));
+	PSF_EXPECT(!Patcher.IsValid());
+
+	// a start marker on the last line has no body at all
+	PSF_EXPECT(!Patcher.Parse(TEXT("float x;\n// PSFCODEADDCUSTOMSDFSTART")));
+
+	// an end marker on the line of its start marker
+	PSF_EXPECT(!Patcher.Parse(TEXT("// PSFCODEASTART // PSFCODEAEND\n")));
+}
+
+PSF_TEST(PatcherRejectsMismatchedEndMarkers)
+{
+	FPSFShaderPatcher Patcher;
+	PSF_EXPECT(!Patcher.Parse(LoadSample(TEXT("Mismatched.ush"))));
+	PSF_EXPECT(!Patcher.Parse(TEXT("// PSFCODEAEND\n")));
+}
+
+PSF_TEST(PatcherDoesNotWriteAfterAFailedEdit)
+{
+	const FString Content = LoadSample(TEXT("Regions.ush"));
+	const FString Path = CopySample(TEXT("FailedEdit.ush"), Content);
+
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Load(Path));
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("INCLUDECUSTOMSDF"), TEXT("#include \"A.ush\"\n")));
+	PSF_EXPECT(!Patcher.SetRegion(TEXT("MISSING"), TEXT("float x;\n")));
+	PSF_EXPECT(!Patcher.IsValid());
+
+	const int32 WritesBefore = GAtomicWrites;
+	bool bWritten = true;
+	PSF_EXPECT(!Patcher.Save(bWritten));
+	PSF_EXPECT(!bWritten);
+	PSF_EXPECT_EQ(GAtomicWrites, WritesBefore);
+
+	FString OnDisk;
+	PSF_REQUIRE(FFileHelper::LoadFileToString(OnDisk, *Path));
+	PSF_EXPECT_TEXT(OnDisk, Content);
+}
+
+PSF_TEST(PatcherKeepsCRLFLineEndings)
+{
+	const FString Content = ToCRLF(LoadSample(TEXT("Regions.ush")));
+	FPSFShaderPatcher Patcher;
+	PSF_REQUIRE(Patcher.Parse(Content));
+	PSF_EXPECT_EQ(Patcher.GetRegionNames().Num(), 3);
+
+	// the \r of the start marker line is not part of the region, the one of its last line is
+	PSF_EXPECT_TEXT(Patcher.GetRegion(TEXT("INCLUDECUSTOMSDF")), TEXT("#include \"MyCustomSDFs.ush\"\r\n"));
+	PSF_EXPECT(Patcher.GetRegion(TEXT("EMPTY")).IsEmpty());
+	PSF_EXPECT_TEXT(Patcher.GetContent(), Content);
+
+	const FString Body = TEXT("#include \"A.ush\"\r\n#include \"B.ush\"\r\n");
+	PSF_REQUIRE(Patcher.SetRegion(TEXT("INCLUDECUSTOMSDF"), Body));
+	const FString Patched = Patcher.GetContent();
+	PSF_EXPECT(!Patched.Replace(TEXT("\r\n"), TEXT(""), ESearchCase::CaseSensitive).Contains(TEXT("\r")));
+	PSF_EXPECT(!Patched.Replace(TEXT("\r\n"), TEXT(""), ESearchCase::CaseSensitive).Contains(TEXT("\n")));
+
+	FPSFShaderPatcher Reparsed;
+	PSF_REQUIRE(Reparsed.Parse(Patched));
+	PSF_EXPECT_TEXT(Reparsed.GetRegion(TEXT("INCLUDECUSTOMSDF")), Body);
+	PSF_EXPECT_TEXT(Reparsed.GetRegion(TEXT("EVALCUSTOMSDF")), Patcher.GetRegion(TEXT("EVALCUSTOMSDF")));
+}
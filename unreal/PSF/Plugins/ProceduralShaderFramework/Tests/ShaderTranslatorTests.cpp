@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFShaderGenerator.h"
+#include "PSFShaderGraph.h"
+#include "PSFShaderTranslator.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	/** Every chunk of Source translated in file order, a chunk that fails is a test failure */
+	FString Translate(EPSFShaderDialect Dialect, const FString &Source)
+	{
+		FPSFShaderGraph Graph;
+		Graph.AddFile(TEXT("Test.ush"), Source);
+		FPSFAmalgamationStats Stats;
+
+		FPSFShaderTranslator Translator(Dialect);
+		FString Code;
+		for(const FPSFShaderChunk *Chunk : Graph.CollectChunks(TEXT("Test.ush"), {}, Stats))
+		{
+			FString ChunkCode, Error;
+			if(!Translator.Translate(*Chunk, ChunkCode, Error))
+			{
+				PSFTestFail(__FILE__, __LINE__, FString::Printf(TEXT("%s: %s"), *Chunk->Name, *Error));
+			}
+			Code += ChunkCode;
+		}
+		return Code;
+	}
+
+	/** Samples/Translator/<Name>.ush generated for Backend against the golden file next to it */
+	void ExpectGolden(const FString &Name, EPSFShaderBackend Backend)
+	{
+		const FString SampleDir = GetPSFTestDir() / TEXT("Samples/Translator");
+		FPSFShaderGenerator Generator;
+		PSF_REQUIRE(Generator.LoadFromDirectory(SampleDir, Name + TEXT(".ush")));
+		const FPSFShaderGeneratorResult Result = Generator.Generate(FPSFShaderBackendConfig::Create(Backend), {}, {});
+		PSF_EXPECT_EQ(Result.Unsupported.Num(), 0);
+
+		// the output lands in Build/Output as well, to diff it against the golden file after a change
+		const FString FileName = Name + TEXT(".") + FPSFShaderBackendConfig::GetExtension(Backend);
+		PSF_REQUIRE(FFileHelper::SaveStringToFile(Result.Code, *(GetPSFTestOutputDir() / FileName)));
+		FString Golden;
+		PSF_REQUIRE(FFileHelper::LoadFileToString(Golden, *(SampleDir / FileName)));
+		PSF_EXPECT_TEXT(Result.Code, Golden);
+	}
+}
+
+PSF_TEST(TranslatorParenthesizesRewrittenOperands)
+{
+	const FString Code = Translate(EPSFShaderDialect::GLSL, TEXT(
+		"float3 Rewrites(float3x3 m, float3 a, float3 b, float c)\n"
+		"{\n"
+		"    float3 x = mul(m, a - b);\n"
+		"    float3 y = mad(a + b, b - a, a * c);\n"
+		"    float z = rcp(c + 1.0);\n"
+		"    float w = rcp(-c) * rcp(c);\n"
+		"    return mul(mul(m, m), x) + y + z + w;\n"
+		"}\n"));
+	// mul swaps its operands and GLSL * binds tighter than - and +, compound operands need their own parentheses
+	PSF_EXPECT(Code.Contains(TEXT("vec3 x = ((a - b) * m);")));
+	PSF_EXPECT(Code.Contains(TEXT("vec3 y = ((a + b) * (b - a) + (a * c));")));
+	PSF_EXPECT(Code.Contains(TEXT("float z = (1.0 / (c + 1.0));")));
+	PSF_EXPECT(Code.Contains(TEXT("float w = (1.0 / -c) * (1.0 / c);")));
+	PSF_EXPECT(Code.Contains(TEXT("return (x * (m * m)) + y + z + w;")));
+}
+
+PSF_TEST(TranslatorMatchesGoldenExpressions)
+{
+	ExpectGolden(TEXT("Expressions"), EPSFShaderBackend::GLSL);
+	ExpectGolden(TEXT("Expressions"), EPSFShaderBackend::Godot);
+}
+
+PSF_TEST(TranslatorPassesGodotTheStateOfMutableGlobals)
+{
+	ExpectGolden(TEXT("State"), EPSFShaderBackend::GLSL);
+	ExpectGolden(TEXT("State"), EPSFShaderBackend::Godot);
+}
+
+PSF_TEST(GeneratorEmitsTheFastPathsOfEveryBackend)
+{
+	FPSFShaderGenerator Generator;
+	PSF_REQUIRE(Generator.LoadFromDirectory(GetPSFTestDir() / TEXT("../Shaders"), TEXT("procedural_shader.ush")));
+	for(const EPSFShaderBackend Backend : {EPSFShaderBackend::Unreal, EPSFShaderBackend::Unity, EPSFShaderBackend::Godot, EPSFShaderBackend::GLSL})
+	{
+		// what -Check of PSFGenerateShaders fails on
+		const FPSFShaderBackendConfig Config = FPSFShaderBackendConfig::Create(Backend);
+		const FPSFShaderGeneratorResult Result = Generator.Generate(Config, {}, FPSFShaderGenerator::GetDefaultFastPaths());
+		PSF_EXPECT(!Result.HasProblems(Config));
+		PSF_EXPECT_EQ(Result.Unsupported.Num(), 0);
+		for(const FPSFFastPathResult &FastPath : Result.FastPaths)
+		{
+			PSF_EXPECT(FastPath.Status == TEXT("emitted"));
+		}
+	}
+}
+
+PSF_TEST(GeneratorMatchesTheGodotLibraryOfTheGodotProject)
+{
+	// godot/addons/includes/generated is written by -run=PSFGenerateShaders -Backends=godot, a change of the .ush files regenerates it
+	const FString LibraryPath = GetPSFTestDir() / TEXT("../../../../../godot/addons/includes/generated/procedural_shader.gdshaderinc");
+	FPSFShaderGenerator Generator;
+	PSF_REQUIRE(Generator.LoadFromDirectory(GetPSFTestDir() / TEXT("../Shaders"), TEXT("procedural_shader.ush")));
+	const FPSFShaderGeneratorResult Result = Generator.Generate(FPSFShaderBackendConfig::Create(EPSFShaderBackend::Godot), {}, FPSFShaderGenerator::GetDefaultFastPaths());
+	PSF_REQUIRE(FFileHelper::SaveStringToFile(Result.Code, *(GetPSFTestOutputDir() / TEXT("procedural_shader.gdshaderinc"))));
+	FString Library;
+	PSF_REQUIRE(FFileHelper::LoadFileToString(Library, *LibraryPath));
+	PSF_EXPECT_TEXT(Result.Code, Library);
+}
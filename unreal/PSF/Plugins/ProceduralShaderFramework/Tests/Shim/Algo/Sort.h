@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Algo
+{
+	template<typename RangeType, typename PredicateType>
+	void Sort(RangeType &&Range, PredicateType Predicate)
+	{
+		std::sort(Range.begin(), Range.end(), Predicate);
+	}
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EParallelForFlags
+{
+	None = 0,
+	Unbalanced = 1
+};
+
+// runs the body in order on the calling thread, the tested code must not depend on the order anyway
+template<typename FunctionType>
+void ParallelFor(int32 Num, FunctionType Body, EParallelForFlags Flags = EParallelForFlags::None)
+{
+	for(int32 Index = 0; Index < Num; ++Index)
+	{
+		Body(Index);
+	}
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Only the declarations the component headers need, the tests evaluate their structs and never create a component
+
+template<typename ObjectType>
+using TObjectPtr = ObjectType *;
+
+enum ELevelTick
+{
+	LEVELTICK_TimeOnly,
+	LEVELTICK_ViewportsOnly,
+	LEVELTICK_All,
+	LEVELTICK_PauseTick,
+};
+
+struct FActorComponentTickFunction
+{
+};
+
+class UActorComponent
+{
+public:
+	virtual ~UActorComponent() = default;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) {}
+};
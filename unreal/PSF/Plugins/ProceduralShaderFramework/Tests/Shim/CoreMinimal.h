@@ -0,0 +1,801 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Stand-ins for the parts of Core the engine independent plugin code uses, so that it builds and runs with a plain
+// compiler. Only what the tested sources need is here, with the semantics of the engine types.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef wchar_t TCHAR;
+typedef char ANSICHAR;
+typedef char UTF8CHAR;
+
+#define TEXT(x) L##x
+#define FORCEINLINE inline
+#define PROCEDURALSHADERFRAMEWORK_API
+#define INDEX_NONE (-1)
+#define MAX_int32 (0x7fffffff)
+#define MAX_flt (3.402823466e+38F)
+#define UE_ARRAY_COUNT(Array) (sizeof(Array) / sizeof((Array)[0]))
+
+#define check(Condition) do { if(!(Condition)) { std::fprintf(stderr, "check failed: %s (%s:%d)\n", #Condition, __FILE__, __LINE__); std::abort(); } } while(0)
+#define checkf(Condition, ...) check(Condition)
+#define ensure(Condition) (Condition)
+
+// reflection markup is for the header tool, the tested structs are plain C++ without it
+#define UENUM(...)
+#define USTRUCT(...)
+#define UCLASS(...)
+#define UPROPERTY(...)
+#define UFUNCTION(...)
+#define GENERATED_BODY()
+
+// logs go to stderr only with PSF_TESTS_VERBOSE, tests provoke errors on purpose
+#define UE_LOG(Category, Verbosity, Format, ...) PSFShimLog(TEXT(#Verbosity), Format, ##__VA_ARGS__)
+
+template<typename T>
+typename std::remove_reference<T>::type &&MoveTemp(T &&Value)
+{
+	return std::move(Value);
+}
+
+template<typename T>
+void Swap(T &A, T &B)
+{
+	std::swap(A, B);
+}
+
+namespace ESearchCase
+{
+	enum Type
+	{
+		CaseSensitive,
+		IgnoreCase,
+	};
+}
+
+namespace ESearchDir
+{
+	enum Type
+	{
+		FromStart,
+		FromEnd,
+	};
+}
+
+struct FChar
+{
+	static bool IsAlpha(TCHAR C) { return std::iswalpha(C) != 0; }
+	static bool IsDigit(TCHAR C) { return C >= TEXT('0') && C <= TEXT('9'); }
+	static bool IsAlnum(TCHAR C) { return std::iswalnum(C) != 0; }
+	static bool IsWhitespace(TCHAR C) { return C == TEXT(' ') || C == TEXT('\t') || C == TEXT('\r') || C == TEXT('\n') || C == TEXT('\f') || C == TEXT('\v'); }
+	static bool IsLinebreak(TCHAR C) { return C == TEXT('\r') || C == TEXT('\n'); }
+	static TCHAR ToLower(TCHAR C) { return (TCHAR)std::towlower(C); }
+	static TCHAR ToUpper(TCHAR C) { return (TCHAR)std::towupper(C); }
+};
+
+struct FMemory
+{
+	static void *Memcpy(void *Dest, const void *Src, size_t Count) { return std::memcpy(Dest, Src, Count); }
+	static int32 Memcmp(const void *A, const void *B, size_t Count) { return std::memcmp(A, B, Count); }
+	static void Memzero(void *Dest, size_t Count) { std::memset(Dest, 0, Count); }
+};
+
+struct FCString
+{
+	static int32 Strlen(const TCHAR *String) { return (int32)std::wcslen(String); }
+	static int32 Strcmp(const TCHAR *A, const TCHAR *B) { return std::wcscmp(A, B); }
+	static int32 Atoi(const TCHAR *String) { return (int32)std::wcstol(String, nullptr, 10); }
+	static int32 Strtoi(const TCHAR *String, TCHAR **End, int32 Base) { return (int32)std::wcstol(String, End, Base); }
+	static float Atof(const TCHAR *String) { return std::wcstof(String, nullptr); }
+	static double Atod(const TCHAR *String) { return std::wcstod(String, nullptr); }
+};
+
+/** Element of a TArray<bool>, std::vector<bool> packs bits and can not hand out references to its elements */
+struct FShimBool
+{
+	bool Value;
+
+	FShimBool(bool InValue = false) : Value(InValue) {}
+	bool operator==(const FShimBool &Other) const { return Value == Other.Value; }
+};
+
+template<typename T>
+class TArray
+{
+	using ElementType = std::conditional_t<std::is_same_v<T, bool>, FShimBool, T>;
+
+public:
+	TArray() = default;
+	TArray(std::initializer_list<T> List) : Data(List.begin(), List.end()) {}
+	TArray(const T *Pointer, int32 Count) : Data(Pointer, Pointer + Count) {}
+
+	int32 Num() const { return (int32)Data.size(); }
+	bool IsEmpty() const { return Data.empty(); }
+	bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Num(); }
+
+	T &operator[](int32 Index) { check(IsValidIndex(Index)); return GetData()[Index]; }
+	const T &operator[](int32 Index) const { check(IsValidIndex(Index)); return GetData()[Index]; }
+	T &Last(int32 IndexFromEnd = 0) { return GetData()[Data.size() - 1 - IndexFromEnd]; }
+	const T &Last(int32 IndexFromEnd = 0) const { return GetData()[Data.size() - 1 - IndexFromEnd]; }
+	T *GetData() { return reinterpret_cast<T *>(Data.data()); }
+	const T *GetData() const { return reinterpret_cast<const T *>(Data.data()); }
+
+	int32 Add(const T &Item) { Data.push_back(Item); return Num() - 1; }
+	int32 Add(T &&Item) { Data.push_back(std::move(Item)); return Num() - 1; }
+	template<typename... ArgTypes>
+	int32 Emplace(ArgTypes &&... Args) { Data.emplace_back(std::forward<ArgTypes>(Args)...); return Num() - 1; }
+	int32 AddUnique(const T &Item) { const int32 Index = Find(Item); return Index != INDEX_NONE ? Index : Add(Item); }
+	int32 AddDefaulted(int32 Count = 1) { const int32 First = Num(); Data.resize(Data.size() + Count); return First; }
+	T &AddDefaulted_GetRef() { Data.emplace_back(); return Last(); }
+	int32 AddZeroed(int32 Count = 1) { const int32 First = Num(); Data.resize(Data.size() + Count, ElementType()); return First; }
+	int32 AddUninitialized(int32 Count = 1) { return AddDefaulted(Count); }
+	void Append(const TArray &Other) { Data.insert(Data.end(), Other.Data.begin(), Other.Data.end()); }
+	void Append(std::initializer_list<T> List) { Data.insert(Data.end(), List.begin(), List.end()); }
+	void Append(const T *Pointer, int32 Count) { Data.insert(Data.end(), Pointer, Pointer + Count); }
+	void Insert(const T &Item, int32 Index) { Data.insert(Data.begin() + Index, Item); }
+
+	void RemoveAt(int32 Index, int32 Count = 1) { Data.erase(Data.begin() + Index, Data.begin() + Index + Count); }
+	int32 Remove(const T &Item) { const size_t Before = Data.size(); Data.erase(std::remove(Data.begin(), Data.end(), Item), Data.end()); return int32(Before - Data.size()); }
+	template<typename PredicateType>
+	int32 RemoveAll(PredicateType Predicate) { const size_t Before = Data.size(); Data.erase(std::remove_if(Data.begin(), Data.end(), Predicate), Data.end()); return int32(Before - Data.size()); }
+	T Pop() { T Item = MoveTemp(Last()); Data.pop_back(); return Item; }
+	void Reset(int32 NewSize = 0) { Data.clear(); Data.reserve(NewSize); }
+	void Empty(int32 Slack = 0) { Data.clear(); Data.shrink_to_fit(); Data.reserve(Slack); }
+	void Reserve(int32 Count) { Data.reserve(Count); }
+	void SetNum(int32 Count) { Data.resize(Count); }
+	void SetNumZeroed(int32 Count) { Data.assign(Count, ElementType()); }
+	void SetNumUninitialized(int32 Count) { Data.resize(Count); }
+	void Init(const T &Value, int32 Count) { Data.assign(Count, Value); }
+
+	int32 Find(const T &Item) const { for(int32 Index = 0; Index < Num(); ++Index) { if((*this)[Index] == Item) { return Index; } } return INDEX_NONE; }
+	bool Contains(const T &Item) const { return Find(Item) != INDEX_NONE; }
+	template<typename KeyType>
+	int32 IndexOfByKey(const KeyType &Key) const { for(int32 Index = 0; Index < Num(); ++Index) { if((*this)[Index] == Key) { return Index; } } return INDEX_NONE; }
+	template<typename PredicateType>
+	int32 IndexOfByPredicate(PredicateType Predicate) const { for(int32 Index = 0; Index < Num(); ++Index) { if(Predicate((*this)[Index])) { return Index; } } return INDEX_NONE; }
+	template<typename PredicateType>
+	T *FindByPredicate(PredicateType Predicate) { for(T &Item : *this) { if(Predicate(Item)) { return &Item; } } return nullptr; }
+	template<typename PredicateType>
+	const T *FindByPredicate(PredicateType Predicate) const { for(const T &Item : *this) { if(Predicate(Item)) { return &Item; } } return nullptr; }
+	template<typename PredicateType>
+	bool ContainsByPredicate(PredicateType Predicate) const { return FindByPredicate(Predicate) != nullptr; }
+	template<typename PredicateType>
+	TArray FilterByPredicate(PredicateType Predicate) const { TArray Result; for(const T &Item : *this) { if(Predicate(Item)) { Result.Add(Item); } } return Result; }
+
+	void Sort() { std::sort(begin(), end()); }
+	template<typename PredicateType>
+	void Sort(PredicateType Predicate) { std::sort(begin(), end(), Predicate); }
+	template<typename PredicateType>
+	void StableSort(PredicateType Predicate) { std::stable_sort(begin(), end(), Predicate); }
+
+	bool operator==(const TArray &Other) const { return Data == Other.Data; }
+	bool operator!=(const TArray &Other) const { return Data != Other.Data; }
+
+	T *begin() { return GetData(); }
+	T *end() { return GetData() + Num(); }
+	const T *begin() const { return GetData(); }
+	const T *end() const { return GetData() + Num(); }
+
+private:
+	std::vector<ElementType> Data;
+};
+
+
+template<typename T>
+class TArrayView
+{
+public:
+	TArrayView() = default;
+	TArrayView(T *InData, int32 InNum) : Data(InData), Count(InNum) {}
+	template<typename ArrayType>
+	TArrayView(ArrayType &Array) : Data(Array.GetData()), Count(Array.Num()) {}
+
+	int32 Num() const { return Count; }
+	T *GetData() const { return Data; }
+	T &operator[](int32 Index) const { check(Index >= 0 && Index < Count); return Data[Index]; }
+	T *begin() const { return Data; }
+	T *end() const { return Data + Count; }
+
+private:
+	T *Data = nullptr;
+	int32 Count = 0;
+};
+
+template<typename T>
+using TConstArrayView = TArrayView<const T>;
+
+class FString
+{
+public:
+	FString() = default;
+	FString(const TCHAR *String) : Data(String ? String : TEXT("")) {}
+	explicit FString(const std::wstring &String) : Data(String) {}
+	FString(int32 Count, const TCHAR *String) : Data(String, Count) {}
+
+	const TCHAR *operator*() const { return Data.c_str(); }
+	TCHAR &operator[](int32 Index) { return Data[Index]; }
+	const TCHAR &operator[](int32 Index) const { return Data[Index]; }
+	int32 Len() const { return (int32)Data.size(); }
+	bool IsEmpty() const { return Data.empty(); }
+	void Reserve(int32 Count) { Data.reserve(Count); }
+	void Empty() { Data.clear(); }
+	void Reset() { Data.clear(); }
+	const std::wstring &GetStdString() const { return Data; }
+	const TCHAR *begin() const { return Data.data(); }
+	const TCHAR *end() const { return Data.data() + Data.size(); }
+
+	FString &operator+=(const FString &Other) { Data += Other.Data; return *this; }
+	FString &operator+=(const TCHAR *Other) { Data += Other; return *this; }
+	FString &operator+=(TCHAR Char) { Data += Char; return *this; }
+	FString &AppendChar(TCHAR Char) { Data += Char; return *this; }
+	FString &AppendChars(const TCHAR *String, int32 Count) { Data.append(String, Count); return *this; }
+	FString &Append(const FString &Other) { Data += Other.Data; return *this; }
+	FString &Append(const TCHAR *String, int32 Count) { Data.append(String, Count); return *this; }
+	friend FString operator+(const FString &A, const FString &B) { return FString(A.Data + B.Data); }
+	friend FString operator+(const FString &A, const TCHAR *B) { return FString(A.Data + B); }
+	friend FString operator+(const TCHAR *A, const FString &B) { return FString(A + B.Data); }
+	friend FString operator/(const FString &A, const FString &B) { return A.IsEmpty() ? B : (A.EndsWith(TEXT("/")) ? A + B : A + TEXT("/") + B); }
+	friend FString operator/(const FString &A, const TCHAR *B) { return A / FString(B); }
+
+	bool operator==(const FString &Other) const { return Equals(Other, ESearchCase::IgnoreCase); }
+	bool operator!=(const FString &Other) const { return !(*this == Other); }
+	bool operator==(const TCHAR *Other) const { return *this == FString(Other); }
+	bool operator!=(const TCHAR *Other) const { return !(*this == Other); }
+	bool operator<(const FString &Other) const { return Compare(Other, ESearchCase::IgnoreCase) < 0; }
+
+	bool Equals(const FString &Other, ESearchCase::Type SearchCase = ESearchCase::CaseSensitive) const { return Compare(Other, SearchCase) == 0; }
+	int32 Compare(const FString &Other, ESearchCase::Type SearchCase = ESearchCase::CaseSensitive) const
+	{
+		if(SearchCase == ESearchCase::CaseSensitive)
+		{
+			return Data.compare(Other.Data);
+		}
+		return Lower().compare(Other.Lower());
+	}
+
+	int32 Find(const TCHAR *SubString, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase, ESearchDir::Type SearchDir = ESearchDir::FromStart, int32 StartPosition = INDEX_NONE) const
+	{
+		const std::wstring Haystack = SearchCase == ESearchCase::CaseSensitive ? Data : Lower();
+		const std::wstring Needle = SearchCase == ESearchCase::CaseSensitive ? std::wstring(SubString) : FString(SubString).Lower();
+		size_t Result;
+		if(SearchDir == ESearchDir::FromStart)
+		{
+			Result = Haystack.find(Needle, StartPosition == INDEX_NONE ? 0 : (size_t)std::max(StartPosition, 0));
+		}
+		else
+		{
+			// like the engine, a match has to start before StartPosition
+			if(StartPosition == 0)
+			{
+				return INDEX_NONE;
+			}
+			Result = StartPosition == INDEX_NONE ? Haystack.rfind(Needle) : Haystack.rfind(Needle, StartPosition - 1);
+		}
+		return Result == std::wstring::npos ? INDEX_NONE : (int32)Result;
+	}
+	int32 Find(const FString &SubString, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase, ESearchDir::Type SearchDir = ESearchDir::FromStart, int32 StartPosition = INDEX_NONE) const
+	{
+		return Find(*SubString, SearchCase, SearchDir, StartPosition);
+	}
+	bool FindChar(TCHAR Char, int32 &OutIndex) const { const size_t Index = Data.find(Char); OutIndex = Index == std::wstring::npos ? INDEX_NONE : (int32)Index; return OutIndex != INDEX_NONE; }
+	bool FindLastChar(TCHAR Char, int32 &OutIndex) const { const size_t Index = Data.rfind(Char); OutIndex = Index == std::wstring::npos ? INDEX_NONE : (int32)Index; return OutIndex != INDEX_NONE; }
+	bool Contains(const TCHAR *SubString, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { return Find(SubString, SearchCase) != INDEX_NONE; }
+	bool Contains(const FString &SubString, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { return Find(*SubString, SearchCase) != INDEX_NONE; }
+
+	bool StartsWith(const TCHAR *Prefix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { const FString P(Prefix); return Len() >= P.Len() && Left(P.Len()).Equals(P, SearchCase); }
+	bool StartsWith(const FString &Prefix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { return StartsWith(*Prefix, SearchCase); }
+	bool EndsWith(const TCHAR *Suffix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { const FString S(Suffix); return Len() >= S.Len() && Right(S.Len()).Equals(S, SearchCase); }
+	bool EndsWith(const FString &Suffix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const { return EndsWith(*Suffix, SearchCase); }
+
+	FString Mid(int32 Start, int32 Count = 0x7fffffff) const
+	{
+		Start = std::clamp(Start, 0, Len());
+		Count = std::clamp(Count, 0, Len() - Start);
+		return FString(Data.substr(Start, Count));
+	}
+	FString Left(int32 Count) const { return Mid(0, Count); }
+	FString Right(int32 Count) const { Count = std::clamp(Count, 0, Len()); return Mid(Len() - Count); }
+	FString LeftChop(int32 Count) const { return Left(Len() - Count); }
+	FString RightChop(int32 Count) const { return Mid(Count); }
+	void LeftChopInline(int32 Count) { *this = LeftChop(Count); }
+	void RightChopInline(int32 Count) { *this = RightChop(Count); }
+
+	bool RemoveFromStart(const FString &Prefix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) { if(Prefix.IsEmpty() || !StartsWith(Prefix, SearchCase)) { return false; } RightChopInline(Prefix.Len()); return true; }
+	bool RemoveFromEnd(const FString &Suffix, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) { if(Suffix.IsEmpty() || !EndsWith(Suffix, SearchCase)) { return false; } LeftChopInline(Suffix.Len()); return true; }
+
+	FString TrimStart() const { int32 Start = 0; while(Start < Len() && FChar::IsWhitespace(Data[Start])) { ++Start; } return Mid(Start); }
+	FString TrimEnd() const { int32 End = Len(); while(End > 0 && FChar::IsWhitespace(Data[End - 1])) { --End; } return Left(End); }
+	FString TrimStartAndEnd() const { return TrimStart().TrimEnd(); }
+	void TrimStartInline() { *this = TrimStart(); }
+	void TrimEndInline() { *this = TrimEnd(); }
+	void TrimStartAndEndInline() { *this = TrimStartAndEnd(); }
+	FString TrimQuotes() const { return Len() >= 2 && Data.front() == TEXT('"') && Data.back() == TEXT('"') ? Mid(1, Len() - 2) : *this; }
+
+	FString ToLower() const { return FString(Lower()); }
+	FString ToUpper() const { std::wstring Result = Data; for(TCHAR &C : Result) { C = FChar::ToUpper(C); } return FString(Result); }
+
+	FString Replace(const TCHAR *From, const TCHAR *To, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase) const
+	{
+		FString Result = *this;
+		Result.ReplaceInline(From, To, SearchCase);
+		return Result;
+	}
+	int32 ReplaceInline(const TCHAR *From, const TCHAR *To, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase)
+	{
+		const int32 FromLength = FCString::Strlen(From);
+		if(FromLength == 0)
+		{
+			return 0;
+		}
+		std::wstring Result;
+		int32 Count = 0;
+		int32 Copied = 0;
+		for(int32 Match = Find(From, SearchCase, ESearchDir::FromStart, 0); Match != INDEX_NONE; Match = Find(From, SearchCase, ESearchDir::FromStart, Match + FromLength))
+		{
+			Result.append(Data, Copied, Match - Copied);
+			Result += To;
+			Copied = Match + FromLength;
+			++Count;
+		}
+		Result.append(Data, Copied, std::wstring::npos);
+		Data = Result;
+		return Count;
+	}
+
+	bool Split(const FString &Separator, FString *OutLeft, FString *OutRight, ESearchCase::Type SearchCase = ESearchCase::IgnoreCase, ESearchDir::Type SearchDir = ESearchDir::FromStart) const
+	{
+		const int32 Index = Find(*Separator, SearchCase, SearchDir);
+		if(Index == INDEX_NONE)
+		{
+			return false;
+		}
+		if(OutLeft)
+		{
+			*OutLeft = Left(Index);
+		}
+		if(OutRight)
+		{
+			*OutRight = Mid(Index + Separator.Len());
+		}
+		return true;
+	}
+
+	int32 ParseIntoArray(TArray<FString> &OutArray, const TCHAR *Delimiter, bool bCullEmpty = true) const
+	{
+		OutArray.Reset();
+		const int32 DelimiterLength = FCString::Strlen(Delimiter);
+		int32 Start = 0;
+		while(Start <= Len())
+		{
+			int32 End = Find(Delimiter, ESearchCase::CaseSensitive, ESearchDir::FromStart, Start);
+			if(End == INDEX_NONE)
+			{
+				End = Len();
+			}
+			if(!bCullEmpty || End > Start)
+			{
+				OutArray.Add(Mid(Start, End - Start));
+			}
+			Start = End + DelimiterLength;
+		}
+		return OutArray.Num();
+	}
+	int32 ParseIntoArrayLines(TArray<FString> &OutArray, bool bCullEmpty = true) const
+	{
+		OutArray.Reset();
+		int32 Start = 0;
+		for(int32 Index = 0; Index <= Len(); ++Index)
+		{
+			if(Index == Len() || Data[Index] == TEXT('\n') || Data[Index] == TEXT('\r'))
+			{
+				if(!bCullEmpty || Index > Start)
+				{
+					OutArray.Add(Mid(Start, Index - Start));
+				}
+				if(Index < Len() && Data[Index] == TEXT('\r') && Index + 1 < Len() && Data[Index + 1] == TEXT('\n'))
+				{
+					++Index;
+				}
+				Start = Index + 1;
+			}
+		}
+		return OutArray.Num();
+	}
+
+	bool IsNumeric() const
+	{
+		if(Data.empty())
+		{
+			return false;
+		}
+		wchar_t *End = nullptr;
+		std::wcstod(Data.c_str(), &End);
+		return End && *End == 0;
+	}
+
+	static FString Chr(TCHAR Char) { return FString(std::wstring(1, Char)); }
+	static FString ChrN(int32 Count, TCHAR Char) { return FString(std::wstring(std::max(Count, 0), Char)); }
+	static FString FromInt(int32 Value) { return FString(std::to_wstring(Value)); }
+	static FString SanitizeFloat(double Value, int32 MinFractionalDigits = 1)
+	{
+		wchar_t Buffer[64];
+		std::swprintf(Buffer, 64, L"%.9g", Value);
+		FString Result(Buffer);
+		if(MinFractionalDigits > 0 && !Result.Contains(TEXT(".")) && !Result.Contains(TEXT("e")) && !Result.Contains(TEXT("n")))
+		{
+			Result += TEXT(".0");
+		}
+		return Result;
+	}
+	static FString Join(const TArray<FString> &Items, const TCHAR *Separator)
+	{
+		FString Result;
+		for(int32 Index = 0; Index < Items.Num(); ++Index)
+		{
+			if(Index > 0)
+			{
+				Result += Separator;
+			}
+			Result += Items[Index];
+		}
+		return Result;
+	}
+
+	// %s takes a TCHAR string like in the engine, it is mapped to the wide string conversion of swprintf
+	template<typename... ArgTypes>
+	static FString Printf(const TCHAR *Format, ArgTypes... Args)
+	{
+		std::wstring WideFormat(Format);
+		for(size_t Position = 0; (Position = WideFormat.find(L"%", Position)) != std::wstring::npos; )
+		{
+			size_t Conversion = Position + 1;
+			while(Conversion < WideFormat.size() && std::wcschr(L"-+ #0123456789.*hlLzjt", WideFormat[Conversion]))
+			{
+				++Conversion;
+			}
+			if(Conversion < WideFormat.size() && WideFormat[Conversion] == L's')
+			{
+				WideFormat.insert(Conversion, L"l");
+				++Conversion;
+			}
+			Position = Conversion + 1;
+		}
+		std::vector<wchar_t> Buffer(256);
+		for(;;)
+		{
+			const int Written = std::swprintf(Buffer.data(), Buffer.size(), WideFormat.c_str(), Args...);
+			if(Written >= 0 && size_t(Written) < Buffer.size())
+			{
+				return FString(Buffer.data());
+			}
+			Buffer.resize(Buffer.size() * 4);
+		}
+	}
+
+private:
+	std::wstring Lower() const { std::wstring Result = Data; for(TCHAR &C : Result) { C = FChar::ToLower(C); } return Result; }
+
+	std::wstring Data;
+};
+
+inline uint32 GetTypeHash(const FString &String)
+{
+	return (uint32)std::hash<std::wstring>()(String.ToLower().GetStdString());
+}
+
+inline uint32 GetTypeHash(int32 Value)
+{
+	return (uint32)Value;
+}
+
+inline uint32 GetTypeHash(uint32 Value)
+{
+	return Value;
+}
+
+inline uint32 GetTypeHash(int64 Value)
+{
+	return uint32(Value) ^ uint32(uint64(Value) >> 32);
+}
+
+template<typename KeyType, typename ValueType>
+struct TPair
+{
+	KeyType Key;
+	ValueType Value;
+};
+
+struct FDefaultSetAllocator
+{
+};
+
+struct FCrc
+{
+	static uint32 StrCrc32(const TCHAR *String) { return uint32(std::hash<std::wstring>()(String)); }
+};
+
+template<typename ElementType, typename InKeyType, bool bInAllowDuplicateKeys = false>
+struct BaseKeyFuncs
+{
+	using KeyType = InKeyType;
+};
+
+template<typename ElementType>
+struct DefaultKeyFuncs : BaseKeyFuncs<ElementType, ElementType>
+{
+	static const ElementType &GetSetKey(const ElementType &Element) { return Element; }
+	static bool Matches(const ElementType &A, const ElementType &B) { return A == B; }
+	static uint32 GetKeyHash(const ElementType &Key) { return GetTypeHash(Key); }
+};
+
+template<typename KeyType, typename ValueType>
+struct TDefaultMapHashableKeyFuncs : BaseKeyFuncs<TPair<KeyType, ValueType>, KeyType>
+{
+	static const KeyType &GetSetKey(const TPair<KeyType, ValueType> &Element) { return Element.Key; }
+	static bool Matches(const KeyType &A, const KeyType &B) { return A == B; }
+	static uint32 GetKeyHash(const KeyType &Key) { return GetTypeHash(Key); }
+};
+
+/**
+ * Hash set over the key functions of the engine, FString keys ignore case unless the key functions say otherwise.
+ * Elements are iterated in the order they were added, like an engine set that nothing was removed from.
+ */
+template<typename ElementType, typename KeyFuncs = DefaultKeyFuncs<ElementType>, typename Allocator = FDefaultSetAllocator>
+class TSet
+{
+public:
+	using KeyType = typename KeyFuncs::KeyType;
+
+	TSet() = default;
+	TSet(std::initializer_list<ElementType> List) { for(const ElementType &Element : List) { Add(Element); } }
+
+	int32 Num() const { return Elements.Num(); }
+	bool IsEmpty() const { return Elements.IsEmpty(); }
+
+	ElementType &Add(const ElementType &Element)
+	{
+		if(ElementType *Existing = Find(KeyFuncs::GetSetKey(Element)))
+		{
+			*Existing = Element;
+			return *Existing;
+		}
+		Buckets[KeyFuncs::GetKeyHash(KeyFuncs::GetSetKey(Element))].push_back(Elements.Num());
+		return Elements[Elements.Add(Element)];
+	}
+	void Append(const TArray<ElementType> &Other) { for(const ElementType &Element : Other) { Add(Element); } }
+	void Append(const TSet &Other) { for(const ElementType &Element : Other) { Add(Element); } }
+
+	ElementType *Find(const KeyType &Key)
+	{
+		const auto Bucket = Buckets.find(KeyFuncs::GetKeyHash(Key));
+		if(Bucket != Buckets.end())
+		{
+			for(const int32 Index : Bucket->second)
+			{
+				if(KeyFuncs::Matches(KeyFuncs::GetSetKey(Elements[Index]), Key))
+				{
+					return &Elements[Index];
+				}
+			}
+		}
+		return nullptr;
+	}
+	const ElementType *Find(const KeyType &Key) const { return const_cast<TSet *>(this)->Find(Key); }
+	bool Contains(const KeyType &Key) const { return Find(Key) != nullptr; }
+
+	int32 Remove(const KeyType &Key)
+	{
+		const ElementType *Existing = Find(Key);
+		if(!Existing)
+		{
+			return 0;
+		}
+		Elements.RemoveAt(int32(Existing - Elements.GetData()));
+		Rehash();
+		return 1;
+	}
+	void Empty() { Elements.Empty(); Buckets.clear(); }
+	void Reset() { Empty(); }
+
+	TArray<ElementType> Array() const { return Elements; }
+
+	ElementType *begin() { return Elements.begin(); }
+	ElementType *end() { return Elements.end(); }
+	const ElementType *begin() const { return Elements.begin(); }
+	const ElementType *end() const { return Elements.end(); }
+
+private:
+	void Rehash()
+	{
+		Buckets.clear();
+		for(int32 Index = 0; Index < Elements.Num(); ++Index)
+		{
+			Buckets[KeyFuncs::GetKeyHash(KeyFuncs::GetSetKey(Elements[Index]))].push_back(Index);
+		}
+	}
+
+	TArray<ElementType> Elements;
+	std::unordered_map<uint32, std::vector<int32>> Buckets;
+};
+
+template<typename KeyType, typename ValueType, typename Allocator = FDefaultSetAllocator, typename KeyFuncs = TDefaultMapHashableKeyFuncs<KeyType, ValueType>>
+class TMap
+{
+public:
+	using ElementType = TPair<KeyType, ValueType>;
+
+	int32 Num() const { return Pairs.Num(); }
+	bool IsEmpty() const { return Pairs.IsEmpty(); }
+
+	ValueType &Add(const KeyType &Key, const ValueType &Value) { return Pairs.Add(ElementType{Key, Value}).Value; }
+	ValueType &Add(const KeyType &Key) { return Add(Key, ValueType()); }
+	ValueType &FindOrAdd(const KeyType &Key) { ValueType *Existing = Find(Key); return Existing ? *Existing : Add(Key); }
+
+	ValueType *Find(const KeyType &Key) { ElementType *Pair = Pairs.Find(Key); return Pair ? &Pair->Value : nullptr; }
+	const ValueType *Find(const KeyType &Key) const { const ElementType *Pair = Pairs.Find(Key); return Pair ? &Pair->Value : nullptr; }
+	ValueType FindRef(const KeyType &Key) const { const ValueType *Value = Find(Key); return Value ? *Value : ValueType(); }
+	ValueType &FindChecked(const KeyType &Key) { ValueType *Value = Find(Key); check(Value); return *Value; }
+	const ValueType &FindChecked(const KeyType &Key) const { const ValueType *Value = Find(Key); check(Value); return *Value; }
+	bool Contains(const KeyType &Key) const { return Pairs.Contains(Key); }
+	ValueType &operator[](const KeyType &Key) { return FindChecked(Key); }
+	const ValueType &operator[](const KeyType &Key) const { return FindChecked(Key); }
+
+	int32 Remove(const KeyType &Key) { return Pairs.Remove(Key); }
+	void Empty() { Pairs.Empty(); }
+	void Reset() { Pairs.Reset(); }
+
+	int32 GetKeys(TArray<KeyType> &OutKeys) const { OutKeys.Reset(); for(const ElementType &Pair : Pairs) { OutKeys.Add(Pair.Key); } return OutKeys.Num(); }
+	void GenerateKeyArray(TArray<KeyType> &OutKeys) const { GetKeys(OutKeys); }
+	void GenerateValueArray(TArray<ValueType> &OutValues) const { OutValues.Reset(); for(const ElementType &Pair : Pairs) { OutValues.Add(Pair.Value); } }
+
+	ElementType *begin() { return Pairs.begin(); }
+	ElementType *end() { return Pairs.end(); }
+	const ElementType *begin() const { return Pairs.begin(); }
+	const ElementType *end() const { return Pairs.end(); }
+
+private:
+	struct FPairKeyFuncs : BaseKeyFuncs<ElementType, KeyType>
+	{
+		static const KeyType &GetSetKey(const ElementType &Element) { return Element.Key; }
+		static bool Matches(const KeyType &A, const KeyType &B) { return KeyFuncs::Matches(A, B); }
+		static uint32 GetKeyHash(const KeyType &Key) { return KeyFuncs::GetKeyHash(Key); }
+	};
+
+	TSet<ElementType, FPairKeyFuncs> Pairs;
+};
+
+/** Names compared by their text, without the engine's name table */
+class FName
+{
+public:
+	FName() = default;
+	FName(const TCHAR *Name) : Text(Name) {}
+	bool IsNone() const { return Text.IsEmpty(); }
+	FString ToString() const { return Text; }
+	bool operator==(const FName &Other) const { return Text == Other.Text; }
+
+private:
+	FString Text;
+};
+
+#define NAME_None FName()
+
+// shared pointers without the engine's thread safety modes, a TSharedRef is never null by convention only
+template<typename ObjectType>
+using TSharedPtr = std::shared_ptr<ObjectType>;
+
+template<typename ObjectType>
+using TSharedRef = std::shared_ptr<ObjectType>;
+
+template<typename ObjectType, typename... ArgTypes>
+TSharedRef<ObjectType> MakeShared(ArgTypes &&... Args)
+{
+	return std::make_shared<ObjectType>(std::forward<ArgTypes>(Args)...);
+}
+
+/** UTF-8 bytes of a TCHAR string */
+class FTCHARToUTF8
+{
+public:
+	explicit FTCHARToUTF8(const TCHAR *String)
+	{
+		for(; *String; ++String)
+		{
+			const uint32 C = (uint32)*String;
+			if(C < 0x80)
+			{
+				Bytes += char(C);
+			}
+			else if(C < 0x800)
+			{
+				Bytes += char(0xC0 | (C >> 6));
+				Bytes += char(0x80 | (C & 0x3F));
+			}
+			else if(C < 0x10000)
+			{
+				Bytes += char(0xE0 | (C >> 12));
+				Bytes += char(0x80 | ((C >> 6) & 0x3F));
+				Bytes += char(0x80 | (C & 0x3F));
+			}
+			else
+			{
+				Bytes += char(0xF0 | (C >> 18));
+				Bytes += char(0x80 | ((C >> 12) & 0x3F));
+				Bytes += char(0x80 | ((C >> 6) & 0x3F));
+				Bytes += char(0x80 | (C & 0x3F));
+			}
+		}
+	}
+
+	const ANSICHAR *Get() const { return Bytes.c_str(); }
+	int32 Length() const { return (int32)Bytes.size(); }
+
+private:
+	std::string Bytes;
+};
+
+/** TCHAR string of UTF-8 bytes */
+inline FString PSFShimUTF8ToString(const uint8 *Bytes, int32 Count)
+{
+	std::wstring Result;
+	for(int32 Index = 0; Index < Count; )
+	{
+		const uint8 Lead = Bytes[Index];
+		const int32 Length = Lead < 0x80 ? 1 : (Lead >> 5) == 0x6 ? 2 : (Lead >> 4) == 0xE ? 3 : 4;
+		uint32 C = Length == 1 ? Lead : Length == 2 ? (Lead & 0x1F) : Length == 3 ? (Lead & 0x0F) : (Lead & 0x07);
+		for(int32 Continuation = 1; Continuation < Length && Index + Continuation < Count; ++Continuation)
+		{
+			C = (C << 6) | (Bytes[Index + Continuation] & 0x3F);
+		}
+		Result += (wchar_t)C;
+		Index += Length;
+	}
+	return FString(Result);
+}
+
+class FCriticalSection
+{
+public:
+	void Lock() { Mutex.lock(); }
+	void Unlock() { Mutex.unlock(); }
+
+private:
+	std::mutex Mutex;
+};
+
+extern bool GPSFShimVerboseLog;
+
+template<typename... ArgTypes>
+void PSFShimLog(const TCHAR *Verbosity, const TCHAR *Format, ArgTypes... Args)
+{
+	if(GPSFShimVerboseLog)
+	{
+		std::fwprintf(stderr, L"%ls: %ls\n", Verbosity, *FString::Printf(Format, Args...));
+	}
+}
+
+#include "PSFShimMath.h"
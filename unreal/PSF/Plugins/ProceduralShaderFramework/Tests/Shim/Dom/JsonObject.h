@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+class FJsonValue
+{
+public:
+	virtual ~FJsonValue() = default;
+
+	/** The value as JSON text, used by FJsonSerializer */
+	virtual FString ToJson() const = 0;
+};
+
+class FJsonValueString : public FJsonValue
+{
+public:
+	explicit FJsonValueString(const FString &InValue) : Value(InValue) {}
+
+	virtual FString ToJson() const override
+	{
+		FString Result = TEXT("\"");
+		for(const TCHAR Character : Value)
+		{
+			if(Character == TEXT('"') || Character == TEXT('\\'))
+			{
+				Result += TEXT('\\');
+				Result += Character;
+			}
+			else if(Character == TEXT('\n'))
+			{
+				Result += TEXT("\\n");
+			}
+			else if(Character == TEXT('\t'))
+			{
+				Result += TEXT("\\t");
+			}
+			else if(Character < 0x20)
+			{
+				Result += FString::Printf(TEXT("\\u%04x"), int32(Character));
+			}
+			else
+			{
+				Result += Character;
+			}
+		}
+		return Result + TEXT("\"");
+	}
+
+private:
+	FString Value;
+};
+
+class FJsonValueNumber : public FJsonValue
+{
+public:
+	explicit FJsonValueNumber(double InValue) : Value(InValue) {}
+
+	virtual FString ToJson() const override
+	{
+		return FString::Printf(TEXT("%.17g"), Value);
+	}
+
+private:
+	double Value;
+};
+
+class FJsonValueBoolean : public FJsonValue
+{
+public:
+	explicit FJsonValueBoolean(bool bInValue) : bValue(bInValue) {}
+
+	virtual FString ToJson() const override
+	{
+		return bValue ? TEXT("true") : TEXT("false");
+	}
+
+private:
+	bool bValue;
+};
+
+class FJsonValueArray : public FJsonValue
+{
+public:
+	explicit FJsonValueArray(const TArray<TSharedPtr<FJsonValue>> &InValues) : Values(InValues) {}
+
+	virtual FString ToJson() const override
+	{
+		FString Result = TEXT("[");
+		for(int32 Index = 0; Index < Values.Num(); ++Index)
+		{
+			Result += (Index > 0 ? TEXT(",") : TEXT("")) + Values[Index]->ToJson();
+		}
+		return Result + TEXT("]");
+	}
+
+private:
+	TArray<TSharedPtr<FJsonValue>> Values;
+};
+
+class FJsonValueObject : public FJsonValue
+{
+public:
+	explicit FJsonValueObject(const TSharedPtr<FJsonObject> &InObject) : Object(InObject) {}
+
+	virtual FString ToJson() const override;
+
+private:
+	TSharedPtr<FJsonObject> Object;
+};
+
+/** Fields in the order they were first set, the engine writes them in the same order */
+class FJsonObject
+{
+public:
+	void SetField(const FString &Name, const TSharedPtr<FJsonValue> &Value) { Values.Add(Name, Value); }
+	void SetStringField(const FString &Name, const FString &Value) { SetField(Name, MakeShared<FJsonValueString>(Value)); }
+	void SetNumberField(const FString &Name, double Value) { SetField(Name, MakeShared<FJsonValueNumber>(Value)); }
+	void SetBoolField(const FString &Name, bool bValue) { SetField(Name, MakeShared<FJsonValueBoolean>(bValue)); }
+	void SetArrayField(const FString &Name, const TArray<TSharedPtr<FJsonValue>> &Array) { SetField(Name, MakeShared<FJsonValueArray>(Array)); }
+	void SetObjectField(const FString &Name, const TSharedPtr<FJsonObject> &Object) { SetField(Name, MakeShared<FJsonValueObject>(Object)); }
+
+	FString ToJson() const
+	{
+		FString Result = TEXT("{");
+		bool bFirst = true;
+		for(const TPair<FString, TSharedPtr<FJsonValue>> &Pair : Values)
+		{
+			Result += (bFirst ? TEXT("") : TEXT(",")) + FJsonValueString(Pair.Key).ToJson() + TEXT(":") + Pair.Value->ToJson();
+			bFirst = false;
+		}
+		return Result + TEXT("}");
+	}
+
+	TMap<FString, TSharedPtr<FJsonValue>> Values;
+};
+
+inline FString FJsonValueObject::ToJson() const
+{
+	return Object->ToJson();
+}
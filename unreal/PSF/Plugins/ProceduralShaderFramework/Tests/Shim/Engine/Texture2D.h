@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <functional>
+
+// Only enough of the texture API for the packing code to build, the tests compare the texels and never upload them
+
+enum EPixelFormat
+{
+	PF_A32B32G32R32F,
+	PF_FloatRGBA,
+};
+
+enum TextureFilter
+{
+	TF_Nearest,
+	TF_Bilinear,
+};
+
+enum TextureCompressionSettings
+{
+	TC_Default,
+	TC_HDR,
+};
+
+struct FUpdateTextureRegion2D
+{
+	uint32 DestX = 0, DestY = 0;
+	int32 SrcX = 0, SrcY = 0;
+	uint32 Width = 0, Height = 0;
+
+	FUpdateTextureRegion2D() = default;
+	FUpdateTextureRegion2D(uint32 InDestX, uint32 InDestY, int32 InSrcX, int32 InSrcY, uint32 InWidth, uint32 InHeight)
+		: DestX(InDestX), DestY(InDestY), SrcX(InSrcX), SrcY(InSrcY), Width(InWidth), Height(InHeight)
+	{
+	}
+};
+
+class UTexture2D
+{
+public:
+	TextureFilter Filter = TF_Bilinear;
+	bool SRGB = true;
+	TextureCompressionSettings CompressionSettings = TC_Default;
+	bool NeverStream = false;
+
+	static UTexture2D *CreateTransient(int32 InSizeX, int32 InSizeY, EPixelFormat)
+	{
+		UTexture2D *Texture = new UTexture2D();
+		Texture->SizeX = InSizeX;
+		Texture->SizeY = InSizeY;
+		return Texture;
+	}
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	void UpdateResource() {}
+
+	/** Calls DataCleanupFunc right away, there is no render thread */
+	void UpdateTextureRegions(int32, uint32, const FUpdateTextureRegion2D *Regions, uint32, uint32, uint8 *SrcData,
+		std::function<void(uint8 *, const FUpdateTextureRegion2D *)> DataCleanupFunc)
+	{
+		DataCleanupFunc(SrcData, Regions);
+	}
+
+private:
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+};
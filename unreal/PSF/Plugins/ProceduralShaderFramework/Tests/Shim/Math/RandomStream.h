@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <random>
+
+// deterministic like the engine stream, not the same sequence
+struct FRandomStream
+{
+	explicit FRandomStream(int32 Seed) : Engine(uint32(Seed)) {}
+
+	float FRand() { return std::uniform_real_distribution<float>(0.0f, 1.0f)(Engine); }
+
+private:
+	std::mt19937 Engine;
+};
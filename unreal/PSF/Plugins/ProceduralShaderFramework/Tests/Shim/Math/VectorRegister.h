@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <smmintrin.h>
+
+// The SSE versions of the VectorRegister functions the plugin uses. VectorSin goes through std::sin lane by lane, the
+// engine uses a polynomial with a slightly different error.
+
+typedef __m128 VectorRegister4Float;
+
+FORCEINLINE VectorRegister4Float VectorZeroFloat() { return _mm_setzero_ps(); }
+FORCEINLINE VectorRegister4Float VectorOneFloat() { return _mm_set1_ps(1.0f); }
+FORCEINLINE VectorRegister4Float VectorSetFloat1(float Value) { return _mm_set1_ps(Value); }
+FORCEINLINE VectorRegister4Float MakeVectorRegisterFloat(float X, float Y, float Z, float W) { return _mm_setr_ps(X, Y, Z, W); }
+FORCEINLINE VectorRegister4Float VectorLoadAligned(const float *Pointer) { return _mm_load_ps(Pointer); }
+FORCEINLINE VectorRegister4Float VectorLoad(const float *Pointer) { return _mm_loadu_ps(Pointer); }
+FORCEINLINE void VectorStoreAligned(const VectorRegister4Float &Vector, float *Pointer) { _mm_store_ps(Pointer, Vector); }
+FORCEINLINE void VectorStore(const VectorRegister4Float &Vector, float *Pointer) { _mm_storeu_ps(Pointer, Vector); }
+
+FORCEINLINE VectorRegister4Float VectorAdd(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_add_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorSubtract(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_sub_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorMultiply(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_mul_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorMultiplyAdd(const VectorRegister4Float &A, const VectorRegister4Float &B, const VectorRegister4Float &C) { return _mm_add_ps(_mm_mul_ps(A, B), C); }
+FORCEINLINE VectorRegister4Float VectorDivide(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_div_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorNegate(const VectorRegister4Float &A) { return _mm_sub_ps(_mm_setzero_ps(), A); }
+FORCEINLINE VectorRegister4Float VectorAbs(const VectorRegister4Float &A) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), A); }
+FORCEINLINE VectorRegister4Float VectorMax(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_max_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorMin(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_min_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorSqrt(const VectorRegister4Float &A) { return _mm_sqrt_ps(A); }
+FORCEINLINE VectorRegister4Float VectorFloor(const VectorRegister4Float &A) { return _mm_floor_ps(A); }
+FORCEINLINE VectorRegister4Float VectorTruncate(const VectorRegister4Float &A) { return _mm_round_ps(A, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+FORCEINLINE VectorRegister4Float VectorCompareLT(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_cmplt_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorCompareLE(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_cmple_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorCompareGT(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_cmpgt_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorCompareGE(const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_cmpge_ps(A, B); }
+FORCEINLINE VectorRegister4Float VectorSelect(const VectorRegister4Float &Mask, const VectorRegister4Float &A, const VectorRegister4Float &B) { return _mm_blendv_ps(B, A, Mask); }
+FORCEINLINE int32 VectorMaskBits(const VectorRegister4Float &A) { return _mm_movemask_ps(A); }
+
+FORCEINLINE VectorRegister4Float VectorSin(const VectorRegister4Float &A)
+{
+	alignas(16) float Lanes[4];
+	_mm_store_ps(Lanes, A);
+	for(float &Lane : Lanes)
+	{
+		Lane = std::sin(Lane);
+	}
+	return _mm_load_ps(Lanes);
+}
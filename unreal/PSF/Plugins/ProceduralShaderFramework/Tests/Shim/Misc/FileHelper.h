@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <fstream>
+#include <iterator>
+
+struct FFileHelper
+{
+	static bool LoadFileToArray(TArray<uint8> &Result, const TCHAR *Filename)
+	{
+		std::ifstream File(FTCHARToUTF8(Filename).Get(), std::ios::binary);
+		if(!File)
+		{
+			return false;
+		}
+		const std::string Bytes((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+		Result = TArray<uint8>(reinterpret_cast<const uint8 *>(Bytes.data()), (int32)Bytes.size());
+		return true;
+	}
+
+	/** UTF-8 files, with or without BOM */
+	static bool LoadFileToString(FString &Result, const TCHAR *Filename)
+	{
+		TArray<uint8> Bytes;
+		if(!LoadFileToArray(Bytes, Filename))
+		{
+			return false;
+		}
+		const int32 Skip = Bytes.Num() >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF ? 3 : 0;
+		Result = PSFShimUTF8ToString(Bytes.GetData() + Skip, Bytes.Num() - Skip);
+		return true;
+	}
+
+	static bool SaveArrayToFile(const TArray<uint8> &Array, const TCHAR *Filename)
+	{
+		std::ofstream File(FTCHARToUTF8(Filename).Get(), std::ios::binary | std::ios::trunc);
+		File.write(reinterpret_cast<const char *>(Array.GetData()), Array.Num());
+		return bool(File);
+	}
+
+	/** Always written as UTF-8 without BOM */
+	static bool SaveStringToFile(const FString &String, const TCHAR *Filename)
+	{
+		const FTCHARToUTF8 Converted(*String);
+		return SaveArrayToFile(TArray<uint8>(reinterpret_cast<const uint8 *>(Converted.Get()), Converted.Length()), Filename);
+	}
+};
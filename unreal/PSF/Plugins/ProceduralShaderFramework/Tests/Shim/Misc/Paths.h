@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <fstream>
+
+struct FPaths
+{
+	static bool FileExists(const FString &Filename)
+	{
+		return bool(std::ifstream(FTCHARToUTF8(*Filename).Get()));
+	}
+
+	static FString GetCleanFilename(const FString &Path)
+	{
+		int32 Slash = INDEX_NONE;
+		Path.Replace(TEXT("\\"), TEXT("/")).FindLastChar(TEXT('/'), Slash);
+		return Path.Mid(Slash + 1);
+	}
+
+	static FString GetBaseFilename(const FString &Path)
+	{
+		const FString Clean = GetCleanFilename(Path);
+		int32 Dot = INDEX_NONE;
+		return Clean.FindLastChar(TEXT('.'), Dot) ? Clean.Left(Dot) : Clean;
+	}
+
+	static FString GetPath(const FString &Path)
+	{
+		int32 Slash = INDEX_NONE;
+		return Path.Replace(TEXT("\\"), TEXT("/")).FindLastChar(TEXT('/'), Slash) ? Path.Left(Slash) : FString();
+	}
+
+	template<typename... PathTypes>
+	static FString Combine(const FString &First, const PathTypes &... Rest)
+	{
+		FString Result = First;
+		((Result = Result / FString(Rest)), ...);
+		return Result;
+	}
+};
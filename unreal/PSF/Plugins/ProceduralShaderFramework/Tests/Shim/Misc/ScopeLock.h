@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FScopeLock
+{
+public:
+	explicit FScopeLock(FCriticalSection *InSection) : Section(InSection) { Section->Lock(); }
+	~FScopeLock() { Section->Unlock(); }
+
+	FScopeLock(const FScopeLock &) = delete;
+	FScopeLock &operator=(const FScopeLock &) = delete;
+
+private:
+	FCriticalSection *Section;
+};
@@ -0,0 +1,329 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Math types of Core used by the tested sources, included by CoreMinimal.h
+
+#define UE_PI (3.1415926535897932f)
+#define UE_TWO_PI (6.28318530717958647692f)
+#define UE_SQRT_3 (1.7320508075688772935274463415059f)
+#ifndef PI
+#define PI UE_PI
+#endif
+
+struct FMath
+{
+	template<typename T> static T Max(T A, T B) { return A > B ? A : B; }
+	template<typename T> static T Min(T A, T B) { return A < B ? A : B; }
+	template<typename T> static T Clamp(T X, T Low, T High) { return X < Low ? Low : (X > High ? High : X); }
+	template<typename T> static T Abs(T X) { return X < 0 ? -X : X; }
+	template<typename T> static T Square(T X) { return X * X; }
+	template<typename T, typename U> static T Lerp(const T &A, const T &B, const U &Alpha) { return A + (B - A) * Alpha; }
+	template<typename T> static T Sign(T X) { return X > 0 ? T(1) : (X < 0 ? T(-1) : T(0)); }
+
+	static float Sqrt(float X) { return std::sqrt(X); }
+	static double Sqrt(double X) { return std::sqrt(X); }
+	static float InvSqrt(float X) { return 1.0f / std::sqrt(X); }
+	static float Sin(float X) { return std::sin(X); }
+	static float Cos(float X) { return std::cos(X); }
+	static float Pow(float A, float B) { return std::pow(A, B); }
+	static float Exp(float X) { return std::exp(X); }
+	static float Loge(float X) { return std::log(X); }
+	static float Log2(float X) { return std::log2(X); }
+	static float Fmod(float A, float B) { return std::fmod(A, B); }
+	static float Frac(float X) { return X - std::floor(X); }
+	static float Atan2(float Y, float X) { return std::atan2(Y, X); }
+	static float Acos(float X) { return std::acos(X); }
+	static float DegreesToRadians(float Degrees) { return Degrees * (UE_PI / 180.0f); }
+	static float FloorToFloat(float X) { return std::floor(X); }
+	static int32 FloorToInt(float X) { return (int32)std::floor(X); }
+	static int32 CeilToInt(float X) { return (int32)std::ceil(X); }
+	static int32 RoundToInt(float X) { return (int32)std::floor(X + 0.5f); }
+	static bool IsNearlyEqual(float A, float B, float Tolerance = 1e-8f) { return std::fabs(A - B) <= Tolerance; }
+	static int32 DivideAndRoundUp(int32 Dividend, int32 Divisor) { return (Dividend + Divisor - 1) / Divisor; }
+	static uint32 RoundUpToPowerOfTwo(uint32 Value) { uint32 Result = 1; while(Result < Value) { Result <<= 1; } return Result; }
+	static uint32 CeilLogTwo(uint32 Value) { uint32 Result = 0; while((1u << Result) < Value) { ++Result; } return Result; }
+};
+
+enum EForceInit
+{
+	ForceInit,
+	ForceInitToZero,
+};
+
+struct FIntVector
+{
+	int32 X = 0, Y = 0, Z = 0;
+
+	FIntVector() = default;
+	explicit FIntVector(int32 Value) : X(Value), Y(Value), Z(Value) {}
+	FIntVector(int32 InX, int32 InY, int32 InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	int32 &operator[](int32 Index) { return (&X)[Index]; }
+	int32 operator[](int32 Index) const { return (&X)[Index]; }
+	FIntVector operator+(const FIntVector &Other) const { return FIntVector(X + Other.X, Y + Other.Y, Z + Other.Z); }
+	FIntVector operator-(const FIntVector &Other) const { return FIntVector(X - Other.X, Y - Other.Y, Z - Other.Z); }
+	FIntVector operator*(int32 Scale) const { return FIntVector(X * Scale, Y * Scale, Z * Scale); }
+	int32 GetMax() const { return std::max(X, std::max(Y, Z)); }
+	bool operator==(const FIntVector &Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+
+	static const FIntVector ZeroValue;
+};
+inline const FIntVector FIntVector::ZeroValue(0, 0, 0);
+
+struct FIntPoint
+{
+	int32 X = 0, Y = 0;
+
+	FIntPoint() = default;
+	FIntPoint(int32 InX, int32 InY) : X(InX), Y(InY) {}
+	bool operator==(const FIntPoint &Other) const { return X == Other.X && Y == Other.Y; }
+};
+
+struct FVector2f
+{
+	float X = 0.0f, Y = 0.0f;
+
+	FVector2f() = default;
+	explicit FVector2f(float Value) : X(Value), Y(Value) {}
+	FVector2f(float InX, float InY) : X(InX), Y(InY) {}
+
+	FVector2f operator+(const FVector2f &Other) const { return FVector2f(X + Other.X, Y + Other.Y); }
+	FVector2f operator-(const FVector2f &Other) const { return FVector2f(X - Other.X, Y - Other.Y); }
+	FVector2f operator*(const FVector2f &Other) const { return FVector2f(X * Other.X, Y * Other.Y); }
+	FVector2f operator*(float Scale) const { return FVector2f(X * Scale, Y * Scale); }
+	FVector2f operator/(float Scale) const { return FVector2f(X / Scale, Y / Scale); }
+	FVector2f operator-() const { return FVector2f(-X, -Y); }
+	float operator|(const FVector2f &Other) const { return X * Other.X + Y * Other.Y; }
+	bool operator==(const FVector2f &Other) const { return X == Other.X && Y == Other.Y; }
+	float Size() const { return std::sqrt(X * X + Y * Y); }
+
+	static const FVector2f ZeroVector;
+};
+inline const FVector2f FVector2f::ZeroVector(0.0f, 0.0f);
+
+/** Double precision vector, only a value type here, the tested code converts it to FVector3f */
+struct FVector
+{
+	double X = 0.0, Y = 0.0, Z = 0.0;
+
+	FVector() = default;
+	FVector(double InX, double InY, double InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	static const FVector ZeroVector;
+	static const FVector OneVector;
+};
+inline const FVector FVector::ZeroVector(0.0, 0.0, 0.0);
+inline const FVector FVector::OneVector(1.0, 1.0, 1.0);
+
+struct FVector3f
+{
+	float X = 0.0f, Y = 0.0f, Z = 0.0f;
+
+	FVector3f() = default;
+	explicit FVector3f(EForceInit) {}
+	explicit FVector3f(float Value) : X(Value), Y(Value), Z(Value) {}
+	explicit FVector3f(const FIntVector &Vector) : X(float(Vector.X)), Y(float(Vector.Y)), Z(float(Vector.Z)) {}
+	explicit FVector3f(const FVector &Vector) : X(float(Vector.X)), Y(float(Vector.Y)), Z(float(Vector.Z)) {}
+	FVector3f(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	float &operator[](int32 Index) { return (&X)[Index]; }
+	float operator[](int32 Index) const { return (&X)[Index]; }
+	FVector3f operator+(const FVector3f &Other) const { return FVector3f(X + Other.X, Y + Other.Y, Z + Other.Z); }
+	FVector3f operator-(const FVector3f &Other) const { return FVector3f(X - Other.X, Y - Other.Y, Z - Other.Z); }
+	FVector3f operator*(const FVector3f &Other) const { return FVector3f(X * Other.X, Y * Other.Y, Z * Other.Z); }
+	FVector3f operator/(const FVector3f &Other) const { return FVector3f(X / Other.X, Y / Other.Y, Z / Other.Z); }
+	FVector3f operator+(float Bias) const { return FVector3f(X + Bias, Y + Bias, Z + Bias); }
+	FVector3f operator-(float Bias) const { return FVector3f(X - Bias, Y - Bias, Z - Bias); }
+	FVector3f operator*(float Scale) const { return FVector3f(X * Scale, Y * Scale, Z * Scale); }
+	FVector3f operator/(float Scale) const { return FVector3f(X / Scale, Y / Scale, Z / Scale); }
+	FVector3f operator-() const { return FVector3f(-X, -Y, -Z); }
+	FVector3f &operator+=(const FVector3f &Other) { X += Other.X; Y += Other.Y; Z += Other.Z; return *this; }
+	FVector3f &operator-=(const FVector3f &Other) { X -= Other.X; Y -= Other.Y; Z -= Other.Z; return *this; }
+	FVector3f &operator*=(const FVector3f &Other) { X *= Other.X; Y *= Other.Y; Z *= Other.Z; return *this; }
+	FVector3f &operator*=(float Scale) { X *= Scale; Y *= Scale; Z *= Scale; return *this; }
+	FVector3f &operator/=(float Scale) { X /= Scale; Y /= Scale; Z /= Scale; return *this; }
+	bool operator==(const FVector3f &Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+	bool operator!=(const FVector3f &Other) const { return !(*this == Other); }
+
+	/** Dot and cross product */
+	float operator|(const FVector3f &Other) const { return X * Other.X + Y * Other.Y + Z * Other.Z; }
+	FVector3f operator^(const FVector3f &Other) const { return FVector3f(Y * Other.Z - Z * Other.Y, Z * Other.X - X * Other.Z, X * Other.Y - Y * Other.X); }
+
+	float Size() const { return std::sqrt(SizeSquared()); }
+	float SizeSquared() const { return X * X + Y * Y + Z * Z; }
+	float GetMax() const { return std::max(X, std::max(Y, Z)); }
+	float GetMin() const { return std::min(X, std::min(Y, Z)); }
+	float GetAbsMax() const { return GetAbs().GetMax(); }
+	FVector3f GetAbs() const { return FVector3f(std::fabs(X), std::fabs(Y), std::fabs(Z)); }
+	FVector3f GetSafeNormal() const { const float Length = Size(); return Length > 1e-8f ? *this / Length : FVector3f(); }
+	bool Normalize() { const float Length = Size(); if(Length <= 1e-8f) { return false; } *this /= Length; return true; }
+	bool Equals(const FVector3f &Other, float Tolerance = 1e-4f) const { return std::fabs(X - Other.X) <= Tolerance && std::fabs(Y - Other.Y) <= Tolerance && std::fabs(Z - Other.Z) <= Tolerance; }
+	bool IsNearlyZero(float Tolerance = 1e-4f) const { return GetAbsMax() <= Tolerance; }
+
+	static float Distance(const FVector3f &A, const FVector3f &B) { return (A - B).Size(); }
+	static float DistSquared(const FVector3f &A, const FVector3f &B) { return (A - B).SizeSquared(); }
+	static float DotProduct(const FVector3f &A, const FVector3f &B) { return A | B; }
+	static FVector3f CrossProduct(const FVector3f &A, const FVector3f &B) { return A ^ B; }
+	static FVector3f Max(const FVector3f &A, const FVector3f &B) { return FVector3f(std::max(A.X, B.X), std::max(A.Y, B.Y), std::max(A.Z, B.Z)); }
+	static FVector3f Min(const FVector3f &A, const FVector3f &B) { return FVector3f(std::min(A.X, B.X), std::min(A.Y, B.Y), std::min(A.Z, B.Z)); }
+
+	static const FVector3f ZeroVector;
+	static const FVector3f OneVector;
+	static const FVector3f UpVector;
+};
+inline const FVector3f FVector3f::ZeroVector(0.0f, 0.0f, 0.0f);
+inline const FVector3f FVector3f::OneVector(1.0f, 1.0f, 1.0f);
+inline const FVector3f FVector3f::UpVector(0.0f, 0.0f, 1.0f);
+inline FVector3f operator*(float Scale, const FVector3f &Vector) { return Vector * Scale; }
+
+struct FVector4f
+{
+	float X = 0.0f, Y = 0.0f, Z = 0.0f, W = 0.0f;
+
+	FVector4f() = default;
+	FVector4f(float InX, float InY, float InZ, float InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+	FVector4f(const FVector3f &Vector, float InW) : X(Vector.X), Y(Vector.Y), Z(Vector.Z), W(InW) {}
+
+	float &operator[](int32 Index) { return (&X)[Index]; }
+	float operator[](int32 Index) const { return (&X)[Index]; }
+	FVector4f operator+(const FVector4f &Other) const { return FVector4f(X + Other.X, Y + Other.Y, Z + Other.Z, W + Other.W); }
+	FVector4f operator-(const FVector4f &Other) const { return FVector4f(X - Other.X, Y - Other.Y, Z - Other.Z, W - Other.W); }
+	FVector4f operator*(float Scale) const { return FVector4f(X * Scale, Y * Scale, Z * Scale, W * Scale); }
+	FVector4f operator/(float Scale) const { return FVector4f(X / Scale, Y / Scale, Z / Scale, W / Scale); }
+	FVector4f &operator+=(const FVector4f &Other) { X += Other.X; Y += Other.Y; Z += Other.Z; W += Other.W; return *this; }
+	float operator|(const FVector4f &Other) const { return X * Other.X + Y * Other.Y + Z * Other.Z + W * Other.W; }
+	bool operator==(const FVector4f &Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z && W == Other.W; }
+	bool operator!=(const FVector4f &Other) const { return !(*this == Other); }
+};
+
+struct FColor
+{
+	uint8 B = 0, G = 0, R = 0, A = 0;
+
+	FColor() = default;
+	FColor(uint8 InR, uint8 InG, uint8 InB, uint8 InA = 255) : B(InB), G(InG), R(InR), A(InA) {}
+};
+
+struct FLinearColor
+{
+	float R = 0.0f, G = 0.0f, B = 0.0f, A = 0.0f;
+
+	FLinearColor() = default;
+	FLinearColor(float InR, float InG, float InB, float InA = 1.0f) : R(InR), G(InG), B(InB), A(InA) {}
+	explicit FLinearColor(const FVector3f &Vector) : R(Vector.X), G(Vector.Y), B(Vector.Z), A(1.0f) {}
+
+	FColor ToFColor(bool /*bSRGB*/) const
+	{
+		auto Quantize = [](float Value) { return uint8(std::lround(std::clamp(Value, 0.0f, 1.0f) * 255.0f)); };
+		return FColor(Quantize(R), Quantize(G), Quantize(B), Quantize(A));
+	}
+
+	static const FLinearColor Black;
+	static const FLinearColor White;
+};
+inline const FLinearColor FLinearColor::Black(0.0f, 0.0f, 0.0f, 1.0f);
+inline const FLinearColor FLinearColor::White(1.0f, 1.0f, 1.0f, 1.0f);
+
+struct FBox3f
+{
+	FVector3f Min;
+	FVector3f Max;
+	bool IsValid = false;
+
+	FBox3f() = default;
+	explicit FBox3f(EForceInit) {}
+	FBox3f(const FVector3f &InMin, const FVector3f &InMax) : Min(InMin), Max(InMax), IsValid(true) {}
+
+	FBox3f &operator+=(const FVector3f &Point)
+	{
+		if(IsValid)
+		{
+			Min = FVector3f::Min(Min, Point);
+			Max = FVector3f::Max(Max, Point);
+		}
+		else
+		{
+			Min = Max = Point;
+			IsValid = true;
+		}
+		return *this;
+	}
+
+	FBox3f &operator+=(const FBox3f &Other)
+	{
+		if(IsValid && Other.IsValid)
+		{
+			Min = FVector3f::Min(Min, Other.Min);
+			Max = FVector3f::Max(Max, Other.Max);
+		}
+		else if(Other.IsValid)
+		{
+			*this = Other;
+		}
+		return *this;
+	}
+
+	FVector3f GetCenter() const { return (Min + Max) * 0.5f; }
+	FVector3f GetExtent() const { return (Max - Min) * 0.5f; }
+	FVector3f GetSize() const { return Max - Min; }
+	FBox3f ExpandBy(float W) const { return FBox3f(Min - FVector3f(W), Max + FVector3f(W)); }
+	bool IsInside(const FVector3f &Point) const { return Point.X > Min.X && Point.X < Max.X && Point.Y > Min.Y && Point.Y < Max.Y && Point.Z > Min.Z && Point.Z < Max.Z; }
+	bool Intersect(const FBox3f &Other) const { return !(Min.X > Other.Max.X || Other.Min.X > Max.X || Min.Y > Other.Max.Y || Other.Min.Y > Max.Y || Min.Z > Other.Max.Z || Other.Min.Z > Max.Z); }
+};
+
+/** Half precision float, stored as a float rounded through the half format */
+struct FFloat16
+{
+	uint16 Encoded = 0;
+
+	FFloat16() = default;
+	FFloat16(float Value) { Set(Value); }
+
+	void Set(float Value)
+	{
+		uint32 Bits;
+		std::memcpy(&Bits, &Value, 4);
+		const uint32 Sign = (Bits >> 16) & 0x8000;
+		int32 Exponent = int32((Bits >> 23) & 0xFF) - 127 + 15;
+		uint32 Mantissa = Bits & 0x7FFFFF;
+		if(Exponent <= 0)
+		{
+			Encoded = uint16(Sign);
+		}
+		else if(Exponent >= 31)
+		{
+			Encoded = uint16(Sign | 0x7C00);
+		}
+		else
+		{
+			// round to nearest
+			Mantissa += 0x1000;
+			if(Mantissa & 0x800000)
+			{
+				Mantissa = 0;
+				++Exponent;
+			}
+			Encoded = Exponent >= 31 ? uint16(Sign | 0x7C00) : uint16(Sign | (Exponent << 10) | (Mantissa >> 13));
+		}
+	}
+
+	float GetFloat() const
+	{
+		const uint32 Sign = uint32(Encoded & 0x8000) << 16;
+		const uint32 Exponent = (Encoded >> 10) & 0x1F;
+		const uint32 Mantissa = Encoded & 0x3FF;
+		uint32 Bits = Sign;
+		if(Exponent == 31)
+		{
+			Bits |= 0x7F800000 | (Mantissa << 13);
+		}
+		else if(Exponent != 0)
+		{
+			Bits |= ((Exponent - 15 + 127) << 23) | (Mantissa << 13);
+		}
+		float Value;
+		std::memcpy(&Value, &Bits, 4);
+		return Value;
+	}
+};
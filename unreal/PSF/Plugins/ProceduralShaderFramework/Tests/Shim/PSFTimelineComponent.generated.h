@@ -0,0 +1,5 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Stands in for the header tool output, the shim's reflection macros expand to nothing
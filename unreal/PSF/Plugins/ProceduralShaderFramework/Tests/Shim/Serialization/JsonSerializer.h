@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+
+class FJsonSerializer
+{
+public:
+	template<typename CharType>
+	static bool Serialize(const TSharedRef<FJsonObject> &Object, const TSharedRef<TJsonWriter<CharType>> &Writer)
+	{
+		Writer->Write(Object->ToJson());
+		return true;
+	}
+};
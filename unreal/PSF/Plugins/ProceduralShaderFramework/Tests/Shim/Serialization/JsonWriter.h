@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Writes condensed JSON into a string, the engine's default policy pretty prints */
+template<typename CharType = TCHAR>
+class TJsonWriter
+{
+public:
+	explicit TJsonWriter(FString *InOutput) : Output(InOutput) {}
+
+	void Write(const FString &Json) { *Output += Json; }
+
+private:
+	FString *Output;
+};
+
+template<typename CharType = TCHAR>
+class TJsonWriterFactory
+{
+public:
+	static TSharedRef<TJsonWriter<CharType>> Create(FString *Output)
+	{
+		return MakeShared<TJsonWriter<CharType>>(Output);
+	}
+};
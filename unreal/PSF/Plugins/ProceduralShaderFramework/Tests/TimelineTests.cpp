@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PSFTest.h"
+#include "PSFTimelineComponent.h"
+
+namespace
+{
+	/** Keyframe track on X, the keys are (time, value) pairs with linear tweens */
+	FPSFTimelineTrack MakeKeyTrack(std::initializer_list<std::pair<float, float>> Keys, bool bLoop)
+	{
+		FPSFTimelineTrack Track;
+		Track.Type = EPSFTimelineTrackType::Keyframes;
+		Track.bLoop = bLoop;
+		for(const std::pair<float, float> &Key : Keys)
+		{
+			FPSFTweenKey &Added = Track.Keys.AddDefaulted_GetRef();
+			Added.Time = Key.first;
+			Added.Value = FVector(Key.second, 0.0, 0.0);
+		}
+		return Track;
+	}
+}
+
+PSF_TEST(TimelineKeysLoopAfterTheLastKey)
+{
+	const FPSFTimelineTrack Looping = MakeKeyTrack({{1.0f, 0.0f}, {3.0f, 10.0f}}, true);
+	PSF_EXPECT_NEAR(Looping.Evaluate(2.0f).X, 5.0f, 1e-4);
+	PSF_EXPECT_NEAR(Looping.Evaluate(4.0f).X, 5.0f, 1e-4);
+	PSF_EXPECT_NEAR(Looping.Evaluate(6.5f).X, 7.5f, 1e-4);
+
+	// without bLoop the last key is held
+	const FPSFTimelineTrack Holding = MakeKeyTrack({{1.0f, 0.0f}, {3.0f, 10.0f}}, false);
+	PSF_EXPECT_NEAR(Holding.Evaluate(4.0f).X, 10.0f, 1e-4);
+	PSF_EXPECT_NEAR(Holding.Evaluate(100.0f).X, 10.0f, 1e-4);
+}
+
+PSF_TEST(TimelineKeysHoldTheFirstKeyBeforeIt)
+{
+	for(const bool bLoop : {true, false})
+	{
+		const FPSFTimelineTrack Track = MakeKeyTrack({{1.0f, 4.0f}, {3.0f, 10.0f}}, bLoop);
+		PSF_EXPECT_NEAR(Track.Evaluate(0.0f).X, 4.0f, 1e-4);
+		PSF_EXPECT_NEAR(Track.Evaluate(-5.0f).X, 4.0f, 1e-4);
+		PSF_EXPECT_NEAR(Track.Evaluate(1.0f).X, 4.0f, 1e-4);
+	}
+}
+
+PSF_TEST(TimelineKeysJumpOverAZeroLengthSegment)
+{
+	// two keys at 2 make a step from 10 to 20
+	const FPSFTimelineTrack Track = MakeKeyTrack({{1.0f, 0.0f}, {2.0f, 10.0f}, {2.0f, 20.0f}, {3.0f, 30.0f}}, false);
+	PSF_EXPECT_NEAR(Track.Evaluate(1.5f).X, 5.0f, 1e-4);
+	PSF_EXPECT_NEAR(Track.Evaluate(1.999f).X, 9.99f, 1e-3);
+	PSF_EXPECT_NEAR(Track.Evaluate(2.0f).X, 20.0f, 1e-4);
+	PSF_EXPECT_NEAR(Track.Evaluate(2.5f).X, 25.0f, 1e-4);
+
+	// every key at the same time: no division by the zero length, nothing to loop
+	const FPSFTimelineTrack Instant = MakeKeyTrack({{2.0f, 7.0f}, {2.0f, 9.0f}}, true);
+	PSF_EXPECT_NEAR(Instant.Evaluate(1.0f).X, 7.0f, 1e-4);
+	PSF_EXPECT_NEAR(Instant.Evaluate(5.0f).X, 9.0f, 1e-4);
+}